@@ -31,6 +31,15 @@ namespace fs = ghc::filesystem;
 void* find_plugin_library(const std::string& name) {
     // Just using a goto for this would probably be cleaner, but yeah...
     const auto impl = [&name]() -> void* {
+        // When a host loads hundreds of chainloaded plugins, then another
+        // chainloader will almost always have already loaded the library. In
+        // that case the dynamic linker can hand us that same library based on
+        // its soname, and we can skip the entire search below.
+        if (void* handle =
+                dlopen(name.c_str(), RTLD_LAZY | RTLD_LOCAL | RTLD_NOLOAD)) {
+            return handle;
+        }
+
         // If `name` exists right next to the Wine plugin host binary, then
         // we'll try loading that. Otherwise we'll fall back to regular
         // `dlopen()` for distro packaged versions of yabridge
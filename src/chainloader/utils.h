@@ -25,7 +25,9 @@
  * `dlclose()`'d when it's no longer needed. This search works in the following
  * order:
  *
- * - First we'll try to locate `yabridge-host.exe` using the same method used by
+ * - If another chainloader in this process has already loaded the library,
+ *   then we'll reuse that without searching for it again.
+ * - Then we'll try to locate `yabridge-host.exe` using the same method used by
  *   the yabridge plugin bridges themselves. We'll search in `$PATH`, followed
  *   by `${XDG_DATA_HOME:-$HOME/.local/share}/yabridge`. If that file exists and
  *   the target plugin library exists right next to it, then we'll use that.
@@ -0,0 +1,244 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "audio-kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+namespace {
+
+/**
+ * Whether the CPU supports AVX2. This is checked once when the library gets
+ * loaded, so the kernels below only need a single well predicted branch.
+ */
+const bool has_avx2 = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}();
+
+__attribute__((target("avx2"))) void accumulate_avx2(const float* src,
+                                                     float* dst,
+                                                     size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        const __m256 a = _mm256_add_ps(_mm256_loadu_ps(dst + i),
+                                       _mm256_loadu_ps(src + i));
+        const __m256 b = _mm256_add_ps(_mm256_loadu_ps(dst + i + 8),
+                                       _mm256_loadu_ps(src + i + 8));
+        _mm256_storeu_ps(dst + i, a);
+        _mm256_storeu_ps(dst + i + 8, b);
+    }
+    for (; i < samples; i++) {
+        dst[i] += src[i];
+    }
+}
+
+__attribute__((target("avx2"))) void accumulate_avx2(const double* src,
+                                                     double* dst,
+                                                     size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m256d a = _mm256_add_pd(_mm256_loadu_pd(dst + i),
+                                        _mm256_loadu_pd(src + i));
+        const __m256d b = _mm256_add_pd(_mm256_loadu_pd(dst + i + 4),
+                                        _mm256_loadu_pd(src + i + 4));
+        _mm256_storeu_pd(dst + i, a);
+        _mm256_storeu_pd(dst + i + 4, b);
+    }
+    for (; i < samples; i++) {
+        dst[i] += src[i];
+    }
+}
+
+void accumulate_sse2(const float* src, float* dst, size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        _mm_storeu_ps(dst + i,
+                      _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+    }
+    for (; i < samples; i++) {
+        dst[i] += src[i];
+    }
+}
+
+void accumulate_sse2(const double* src, double* dst, size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 2 <= samples; i += 2) {
+        _mm_storeu_pd(dst + i,
+                      _mm_add_pd(_mm_loadu_pd(dst + i), _mm_loadu_pd(src + i)));
+    }
+    for (; i < samples; i++) {
+        dst[i] += src[i];
+    }
+}
+
+__attribute__((target("avx2"))) void convert_avx2(const float* src,
+                                                  double* dst,
+                                                  size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m256 values = _mm256_loadu_ps(src + i);
+        _mm256_storeu_pd(dst + i,
+                         _mm256_cvtps_pd(_mm256_castps256_ps128(values)));
+        _mm256_storeu_pd(dst + i + 4,
+                         _mm256_cvtps_pd(_mm256_extractf128_ps(values, 1)));
+    }
+    for (; i < samples; i++) {
+        dst[i] = src[i];
+    }
+}
+
+__attribute__((target("avx2"))) void convert_avx2(const double* src,
+                                                  float* dst,
+                                                  size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m128 low = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i));
+        const __m128 high = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4));
+        _mm256_storeu_ps(dst + i,
+                         _mm256_insertf128_ps(_mm256_castps128_ps256(low),
+                                              high, 1));
+    }
+    for (; i < samples; i++) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+void convert_sse2(const float* src, double* dst, size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 values = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(values));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(values, values)));
+    }
+    for (; i < samples; i++) {
+        dst[i] = src[i];
+    }
+}
+
+void convert_sse2(const double* src, float* dst, size_t samples) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        const __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(low, high));
+    }
+    for (; i < samples; i++) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+/**
+ * The number of samples checked at a time in the silence detection functions
+ * before checking whether we can bail early.
+ */
+constexpr size_t silence_block_size = 64;
+
+template <typename T, typename U>
+bool is_silent_impl(const T* src, size_t samples) noexcept {
+    static_assert(sizeof(T) == sizeof(U));
+
+    // Comparing the bit patterns with the sign bit masked out lets the
+    // compiler vectorize these loops, and it also treats `-0.0` as silence
+    constexpr U magnitude_mask = ~(static_cast<U>(1) << (sizeof(U) * 8 - 1));
+
+    size_t i = 0;
+    while (i < samples) {
+        const size_t block_end = std::min(i + silence_block_size, samples);
+
+        U bits = 0;
+        for (; i < block_end; i++) {
+            U sample;
+            std::memcpy(&sample, &src[i], sizeof(U));
+            bits |= sample & magnitude_mask;
+        }
+
+        if (bits != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace
+
+namespace audio_kernels {
+
+// NOTE: glibc already selects an AVX2 or ERMS `memcpy()` implementation at
+//       runtime, and a hand written copy loop would not beat that. These
+//       overloads exist so all audio transfers go through this one library.
+void copy(const float* src, float* dst, size_t samples) noexcept {
+    std::memcpy(dst, src, samples * sizeof(float));
+}
+
+void copy(const double* src, double* dst, size_t samples) noexcept {
+    std::memcpy(dst, src, samples * sizeof(double));
+}
+
+void convert(const float* src, double* dst, size_t samples) noexcept {
+    if (has_avx2) {
+        convert_avx2(src, dst, samples);
+    } else {
+        convert_sse2(src, dst, samples);
+    }
+}
+
+void convert(const double* src, float* dst, size_t samples) noexcept {
+    if (has_avx2) {
+        convert_avx2(src, dst, samples);
+    } else {
+        convert_sse2(src, dst, samples);
+    }
+}
+
+void accumulate(const float* src, float* dst, size_t samples) noexcept {
+    if (has_avx2) {
+        accumulate_avx2(src, dst, samples);
+    } else {
+        accumulate_sse2(src, dst, samples);
+    }
+}
+
+void accumulate(const double* src, double* dst, size_t samples) noexcept {
+    if (has_avx2) {
+        accumulate_avx2(src, dst, samples);
+    } else {
+        accumulate_sse2(src, dst, samples);
+    }
+}
+
+void clear(float* dst, size_t samples) noexcept {
+    std::memset(dst, 0, samples * sizeof(float));
+}
+
+void clear(double* dst, size_t samples) noexcept {
+    std::memset(dst, 0, samples * sizeof(double));
+}
+
+bool is_silent(const float* src, size_t samples) noexcept {
+    return is_silent_impl<float, uint32_t>(src, samples);
+}
+
+bool is_silent(const double* src, size_t samples) noexcept {
+    return is_silent_impl<double, uint64_t>(src, samples);
+}
+
+}  // namespace audio_kernels
@@ -0,0 +1,71 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Small vectorized kernels for moving audio between the host's buffers and our
+ * shared memory audio buffers. With large channel counts at double precision
+ * these copies are a measurable part of yabridge's overhead. The AVX2 versions
+ * of these kernels are selected at runtime if the CPU supports them, and SSE2
+ * is used otherwise. SSE2 is always available since we compile with `-msse2`
+ * for our flush-to-zero intrinsic.
+ *
+ * None of these functions require the buffers to be aligned, and the source
+ * and destination buffers should not overlap.
+ *
+ * @see AudioShmBuffer
+ */
+namespace audio_kernels {
+
+/**
+ * Copy `samples` samples from `src` to `dst`.
+ */
+void copy(const float* src, float* dst, size_t samples) noexcept;
+void copy(const double* src, double* dst, size_t samples) noexcept;
+
+/**
+ * Copy `samples` samples from `src` to `dst` while converting them to the
+ * other precision. This is used when a VST3 plugin only supports the precision
+ * the host is not using.
+ */
+void convert(const float* src, double* dst, size_t samples) noexcept;
+void convert(const double* src, float* dst, size_t samples) noexcept;
+
+/**
+ * Add `samples` samples from `src` to the existing values in `dst`. This is
+ * used for the accumulating VST2 `process()` function.
+ */
+void accumulate(const float* src, float* dst, size_t samples) noexcept;
+void accumulate(const double* src, double* dst, size_t samples) noexcept;
+
+/**
+ * Fill `samples` samples in `dst` with zeroes.
+ */
+void clear(float* dst, size_t samples) noexcept;
+void clear(double* dst, size_t samples) noexcept;
+
+/**
+ * Check whether all `samples` samples in `src` are zero. Negative zeroes are
+ * also considered to be silent. This stops at the first non-silent block of
+ * samples, so checking a buffer with audio in it is usually very cheap.
+ */
+bool is_silent(const float* src, size_t samples) noexcept;
+bool is_silent(const double* src, size_t samples) noexcept;
+
+}  // namespace audio_kernels
@@ -16,15 +16,66 @@
 
 #include "audio-shm.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 
+#include <immintrin.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #include "logging/common.h"
+#include "probes.h"
 
 using namespace std::literals::string_literals;
 
+namespace {
+
+/**
+ * Mappings at least this large will be backed by transparent huge pages when
+ * `AudioShmBuffer::Config::pinned` is set. Below this size a huge page would
+ * mostly be wasted memory.
+ */
+constexpr size_t huge_page_threshold = 2 << 20;
+
+/**
+ * A thin wrapper around the futex system call, since glibc doesn't provide
+ * one. The counters live in a shared memory object, so we cannot use
+ * `FUTEX_PRIVATE_FLAG` here.
+ */
+long futex(std::atomic_uint32_t* word,
+           int operation,
+           uint32_t value,
+           const timespec* timeout) noexcept {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), operation,
+                   value, timeout, nullptr, 0);
+}
+
+/**
+ * Add `duration` to a cumulative statistic and update its maximum. These are
+ * only written to from a single thread, so we can avoid the read-modify-write
+ * instructions.
+ */
+void add_duration(std::atomic_uint64_t& total,
+                  std::atomic_uint64_t& max,
+                  std::chrono::nanoseconds duration) noexcept {
+    const uint64_t nanoseconds = static_cast<uint64_t>(duration.count());
+    total.store(total.load(std::memory_order_relaxed) + nanoseconds,
+                std::memory_order_relaxed);
+    if (nanoseconds > max.load(std::memory_order_relaxed)) {
+        max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace
+
 AudioShmBuffer::AudioShmBuffer(const Config& config)
     : config_(config),
       shm_fd_(shm_open(config.name.c_str(), O_RDWR | O_CREAT, 0600)) {
+    config_.capacity = std::max(config_.size, config_.capacity);
+
     if (shm_fd_ == -1) {
         throw std::system_error(
             std::error_code(errno, std::system_category()),
@@ -32,6 +83,25 @@ AudioShmBuffer::AudioShmBuffer(const Config& config)
     }
 
     setup_mapping();
+
+    // The Wine plugin host creates the shared memory object, so a freshly
+    // zeroed header means that we're the first ones to map it. The native
+    // plugin should always see a header with the same layout.
+    if (header()->version == 0) {
+        header()->version = control_header_version;
+    } else if (header()->version != control_header_version) {
+        throw std::runtime_error(
+            "Shared memory object " + config_.name +
+            " uses control header version " +
+            std::to_string(header()->version) + ", expected version " +
+            std::to_string(control_header_version));
+    }
+
+#ifdef __WINE__
+    header()->memory.host_pid = static_cast<uint32_t>(getpid());
+#else
+    header()->memory.native_pid = static_cast<uint32_t>(getpid());
+#endif
 }
 
 AudioShmBuffer::~AudioShmBuffer() noexcept {
@@ -39,7 +109,7 @@ AudioShmBuffer::~AudioShmBuffer() noexcept {
     // removed, so we'll do it on both sides to reduce the chance that we leak
     // shared memory
     if (!is_moved_) {
-        munmap(shm_bytes_, config_.size);
+        munmap(shm_bytes_, shm_size_);
         close(shm_fd_);
         shm_unlink(config_.name.c_str());
     }
@@ -49,7 +119,9 @@ AudioShmBuffer::AudioShmBuffer(AudioShmBuffer&& o) noexcept
     : config_(std::move(o.config_)),
       shm_fd_(std::move(o.shm_fd_)),
       shm_bytes_(std::move(o.shm_bytes_)),
-      shm_size_(std::move(o.shm_size_)) {
+      shm_size_(std::move(o.shm_size_)),
+      generation_(o.generation_),
+      memory_released_(o.memory_released_) {
     o.is_moved_ = true;
 }
 
@@ -58,6 +130,8 @@ AudioShmBuffer& AudioShmBuffer::operator=(AudioShmBuffer&& o) noexcept {
     shm_fd_ = std::move(o.shm_fd_);
     shm_bytes_ = std::move(o.shm_bytes_);
     shm_size_ = std::move(o.shm_size_);
+    generation_ = o.generation_;
+    memory_released_ = o.memory_released_;
     o.is_moved_ = true;
 
     return *this;
@@ -70,52 +144,342 @@ void AudioShmBuffer::resize(const Config& new_config) {
                                     new_config.name + "\"");
     }
 
+    // The buffers only ever grow. If the new layout still fits in the memory
+    // we've already mapped, then we can skip remapping the buffer entirely,
+    // even if the capacity requested for the new size including its headroom
+    // would be larger. This matters for hosts that frequently change the block
+    // size, like when bouncing a project offline. Only when the new size
+    // doesn't fit do we grow to the requested capacity. With
+    // `Config::reclaimable` we'll shrink the buffer again when less than half
+    // of it is needed. The native plugin receives the capacity computed on the
+    // Wine side, so both sides always make the same decision here.
+    const uint32_t old_capacity = config_.capacity;
+    const uint32_t old_metadata_capacity = config_.metadata_capacity;
     config_ = new_config;
-    setup_mapping();
+    const uint32_t requested_capacity =
+        std::max(config_.size, config_.capacity);
+    if (config_.size > old_capacity ||
+        (config_.reclaimable && requested_capacity <= old_capacity / 2)) {
+        config_.capacity = requested_capacity;
+    } else {
+        config_.capacity = old_capacity;
+    }
+    const bool remap = config_.capacity != old_capacity ||
+                       config_.metadata_capacity != old_metadata_capacity;
+    if (remap) {
+        setup_mapping();
+    }
+    YABRIDGE_PROBE(audio_shm_resize, config_.capacity, remap ? 1 : 0);
+
+    generation_++;
+}
+
+void AudioShmBuffer::release_memory() noexcept {
+    // Only whole pages can be released, so the page containing the end of the
+    // metadata regions is kept
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t audio_offset =
+        static_cast<size_t>(audio_bytes() - shm_bytes_);
+    const size_t release_offset =
+        ((audio_offset + page_size - 1) / page_size) * page_size;
+    if (memory_released_ || release_offset >= shm_size_) {
+        return;
+    }
+
+    // Locked pages can't be released. `MADV_REMOVE` punches a hole in the
+    // shared memory object itself, so this also frees the pages mapped by the
+    // native plugin.
+    uint8_t* release_start = shm_bytes_ + release_offset;
+    const size_t release_size = shm_size_ - release_offset;
+    munlock(release_start, release_size);
+    if (madvise(release_start, release_size, MADV_REMOVE) != 0) {
+        mlock(release_start, release_size);
+        return;
+    }
+
+    memory_released_ = true;
+}
+
+void AudioShmBuffer::restore_memory() noexcept {
+    if (!memory_released_) {
+        return;
+    }
+
+    // This mirrors the `MAP_LOCKED` flag the mapping was created with
+    if (config_.pinned) {
+        pin_mapping();
+    } else {
+        mlock(shm_bytes_, shm_size_);
+    }
+
+    memory_released_ = false;
+}
+
+void AudioShmBuffer::bind_to_numa_node(int node) noexcept {
+    constexpr size_t max_nodes = 1024;
+    if (node < 0 || static_cast<size_t>(node) >= max_nodes) {
+        return;
+    }
+
+    numa_node_ = node;
+
+#ifdef SYS_mbind
+    constexpr size_t bits_per_word = sizeof(unsigned long) * 8;
+    std::array<unsigned long, max_nodes / bits_per_word> node_mask{};
+    node_mask[node / bits_per_word] = 1UL << (node % bits_per_word);
+
+    // Both sides map these pages, so moving them requires `MPOL_MF_MOVE_ALL`
+    // and thus `CAP_SYS_NICE`. Otherwise only new pages will end up on the
+    // node. `MPOL_PREFERRED` still allows allocating elsewhere when the node
+    // is out of memory. The kernel ignores the last bit of the mask, hence the
+    // `+ 1`.
+    const auto bind = [&](unsigned int flags) {
+        return syscall(SYS_mbind, shm_bytes_, shm_size_, MPOL_PREFERRED,
+                       node_mask.data(), max_nodes + 1, flags) == 0;
+    };
+    if (!bind(MPOL_MF_MOVE_ALL)) {
+        bind(MPOL_MF_MOVE);
+    }
+#endif
+}
+
+void AudioShmBuffer::notify_response() noexcept {
+    header()->response_sequence.fetch_add(1, std::memory_order_release);
+    futex(&header()->response_sequence, FUTEX_WAKE, 1, nullptr);
+}
+
+void AudioShmBuffer::record_plugin_time(
+    std::chrono::nanoseconds duration,
+    std::chrono::nanoseconds callbacks_duration) noexcept {
+    ProcessingStats& stats = header()->stats;
+    add_duration(stats.plugin_ns, stats.max_plugin_ns, duration);
+    if (callbacks_duration.count() > 0) {
+        stats.callbacks_ns.store(
+            stats.callbacks_ns.load(std::memory_order_relaxed) +
+                static_cast<uint64_t>(callbacks_duration.count()),
+            std::memory_order_relaxed);
+    }
+}
+
+void AudioShmBuffer::record_total_time(
+    std::chrono::nanoseconds duration) noexcept {
+    ProcessingStats& stats = header()->stats;
+    add_duration(stats.total_ns, stats.max_total_ns, duration);
+    stats.num_blocks.store(
+        stats.num_blocks.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+}
+
+void AudioShmBuffer::record_block_timings(
+    std::chrono::steady_clock::time_point received,
+    std::chrono::steady_clock::time_point plugin_start,
+    std::chrono::steady_clock::time_point plugin_end,
+    std::chrono::nanoseconds callbacks,
+    bool realtime) noexcept {
+    const auto to_ns = [](std::chrono::steady_clock::time_point time) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                time.time_since_epoch())
+                .count());
+    };
+
+    // These are published to the native plugin by the release store in
+    // `notify_response()`, or by the socket write when signalling is disabled
+    BlockTimings& timings = header()->last_block;
+    timings.received_ns.store(to_ns(received), std::memory_order_relaxed);
+    timings.plugin_start_ns.store(to_ns(plugin_start),
+                                  std::memory_order_relaxed);
+    timings.plugin_end_ns.store(to_ns(plugin_end), std::memory_order_relaxed);
+    timings.callbacks_ns.store(static_cast<uint64_t>(callbacks.count()),
+                               std::memory_order_relaxed);
+    timings.realtime.store(realtime, std::memory_order_relaxed);
+}
+
+std::optional<AudioShmBuffer::ProcessingStatsSnapshot>
+AudioShmBuffer::read_processing_stats(const std::string& name) noexcept {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        return std::nullopt;
+    }
+
+    void* mapping =
+        mmap(nullptr, sizeof(ControlHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return std::nullopt;
+    }
+
+    std::optional<ProcessingStatsSnapshot> snapshot;
+    const ControlHeader* header = static_cast<const ControlHeader*>(mapping);
+    if (header->version == control_header_version) {
+        snapshot = ProcessingStatsSnapshot{
+            .num_blocks =
+                header->stats.num_blocks.load(std::memory_order_relaxed),
+            .total_ns = header->stats.total_ns.load(std::memory_order_relaxed),
+            .plugin_ns =
+                header->stats.plugin_ns.load(std::memory_order_relaxed),
+            .callbacks_ns =
+                header->stats.callbacks_ns.load(std::memory_order_relaxed)};
+    }
+
+    munmap(mapping, sizeof(ControlHeader));
+
+    return snapshot;
+}
+
+bool AudioShmBuffer::wait_for_response(
+    uint32_t last_sequence,
+    std::chrono::milliseconds timeout) noexcept {
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec timeout_spec{
+        .tv_sec = static_cast<time_t>(seconds.count()),
+        .tv_nsec = static_cast<long>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout -
+                                                                 seconds)
+                .count())};
+
+    // `FUTEX_WAIT` returns immediately if the counter has already been
+    // incremented by the time we get here, and it can also wake up spuriously,
+    // so we'll just check the counter again after every wakeup. The timeout is
+    // relative to the start of every wait, but that's fine since it's only used
+    // to periodically check whether the other side is still alive.
+    while (header()->response_sequence.load(std::memory_order_acquire) ==
+           last_sequence) {
+        if (futex(&header()->response_sequence, FUTEX_WAIT, last_sequence,
+                  &timeout_spec) == -1 &&
+            errno == ETIMEDOUT) {
+            return header()->response_sequence.load(
+                       std::memory_order_acquire) != last_sequence;
+        }
+    }
+
+    return true;
+}
+
+bool AudioShmBuffer::spin_for_response(
+    uint32_t last_sequence,
+    std::chrono::microseconds budget) const noexcept {
+    // Reading the clock is much more expensive than reading the counter, so
+    // we'll only check the deadline every so often
+    constexpr int polls_per_clock_check = 64;
+
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    while (true) {
+        for (int i = 0; i < polls_per_clock_check; i++) {
+            if (header()->response_sequence.load(std::memory_order_acquire) !=
+                last_sequence) {
+                return true;
+            }
+
+            _mm_pause();
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return header()->response_sequence.load(
+                       std::memory_order_acquire) != last_sequence;
+        }
+    }
 }
 
 void AudioShmBuffer::setup_mapping() {
-    // Apparently you get a `Resource temporarily unavailable` when calling
-    // `ftruncate()` with a size of 0 on shared memory
-    if (config_.size > 0) {
-        // I don't think this can fail
-        assert(ftruncate(shm_fd_, config_.size) == 0);
-
-        // But this can, if the user does not have permissions to use (enough)
-        // locked emmory, we'll try it without locking memory and show a big
-        // obnoxious warning and try again without locking the memory.
-        uint8_t* old_shm_bytes = shm_bytes_;
-        shm_bytes_ = static_cast<uint8_t*>(
-            old_shm_bytes
-                ? mremap(old_shm_bytes, shm_size_, config_.size, MREMAP_MAYMOVE)
-                : mmap(nullptr, config_.size, PROT_READ | PROT_WRITE,
-                       MAP_SHARED | MAP_LOCKED, shm_fd_, 0));
+    // The control header is always stored at the start of the shared memory
+    // object followed by the metadata regions, so the mapping will never be
+    // empty. Apparently you get a
+    // `Resource temporarily unavailable` when calling `ftruncate()` with a size
+    // of 0 on shared memory.
+    const size_t mapping_size =
+        sizeof(ControlHeader) +
+        (2 * static_cast<size_t>(config_.metadata_capacity)) +
+        config_.capacity;
+
+    // I don't think this can fail
+    assert(ftruncate(shm_fd_, mapping_size) == 0);
+
+    // But this can, if the user does not have permissions to use (enough)
+    // locked emmory, we'll try it without locking memory and show a big
+    // obnoxious warning and try again without locking the memory.
+    uint8_t* old_shm_bytes = shm_bytes_;
+    shm_bytes_ = static_cast<uint8_t*>(
+        old_shm_bytes
+            ? mremap(old_shm_bytes, shm_size_, mapping_size, MREMAP_MAYMOVE)
+            : mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_LOCKED, shm_fd_, 0));
+    if (shm_bytes_ == MAP_FAILED) {
+        Logger logger = Logger::create_exception_logger();
+
+        logger.log("");
+        logger.log("ERROR: Could not map shared memory. This means that");
+        logger.log("       your user's memory locking limit has been");
+        logger.log("       reached. Check your distro's documentation or");
+        logger.log("       wiki for instructions on how to set up");
+        logger.log("       realtime privileges and memlock limits.");
+        logger.log("");
+
+        // Growing into a size that we cannot lock sounds like a super rare
+        // edge case, but let's handle it anyways
+        if (old_shm_bytes) {
+            assert(munmap(old_shm_bytes, shm_size_) == 0);
+        }
+        shm_bytes_ = static_cast<uint8_t*>(mmap(nullptr, mapping_size,
+                                                PROT_READ | PROT_WRITE,
+                                                MAP_SHARED, shm_fd_, 0));
         if (shm_bytes_ == MAP_FAILED) {
-            Logger logger = Logger::create_exception_logger();
-
-            logger.log("");
-            logger.log("ERROR: Could not map shared memory. This means that");
-            logger.log("       your user's memory locking limit has been");
-            logger.log("       reached. Check your distro's documentation or");
-            logger.log("       wiki for instructions on how to set up");
-            logger.log("       realtime privileges and memlock limits.");
-            logger.log("");
-
-            // Growing into a size that we cannot lock sounds like a super rare
-            // edge case, but let's handle it anyways
-            if (old_shm_bytes) {
-                assert(munmap(old_shm_bytes, shm_size_) == 0);
-            }
-            shm_bytes_ = static_cast<uint8_t*>(mmap(nullptr, config_.size,
-                                                    PROT_READ | PROT_WRITE,
-                                                    MAP_SHARED, shm_fd_, 0));
-            if (shm_bytes_ == MAP_FAILED) {
-                throw std::system_error(
-                    std::error_code(errno, std::system_category()),
-                    "Could not map shared memory");
-            }
+            throw std::system_error(
+                std::error_code(errno, std::system_category()),
+                "Could not map shared memory");
+        }
+    }
+
+    shm_size_ = mapping_size;
+
+    if (numa_node_) {
+        bind_to_numa_node(*numa_node_);
+    }
+    if (config_.pinned) {
+        pin_mapping();
+    }
+}
+
+void AudioShmBuffer::pin_mapping() noexcept {
+    // We can't use `MAP_HUGETLB` here since that only works for anonymous
+    // mappings and files on a hugetlbfs mount, while these objects live on
+    // `/dev/shm`. What we can do is ask for transparent huge pages, which will
+    // be used as long as `/sys/kernel/mm/transparent_hugepage/shmem_enabled`
+    // is not set to `never`. This has to happen before prefaulting.
+    if (shm_size_ >= huge_page_threshold) {
+        madvise(shm_bytes_, shm_size_, MADV_HUGEPAGE);
+    }
+
+    // Touching every page now means that the audio thread won't have to take
+    // a page fault the first time it writes to a channel after a resize. We
+    // can't write zeroes here since the other side may already have written
+    // to the mapping, so when `MADV_POPULATE_WRITE` isn't available we'll just
+    // write back whatever is already there.
+    bool prefaulted = false;
+#ifdef MADV_POPULATE_WRITE
+    prefaulted = madvise(shm_bytes_, shm_size_, MADV_POPULATE_WRITE) == 0;
+#endif
+    if (!prefaulted) {
+        const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (size_t offset = 0; offset < shm_size_; offset += page_size) {
+            volatile uint8_t* byte = shm_bytes_ + offset;
+            *byte = *byte;
         }
     }
 
-    shm_size_ = config_.size;
+    // The initial mapping is already created with `MAP_LOCKED`, but that flag
+    // is dropped when we had to fall back to an unlocked mapping and it's
+    // best effort anyways
+    if (mlock(shm_bytes_, shm_size_) != 0) {
+        Logger logger = Logger::create_exception_logger();
+
+        logger.log("");
+        logger.log("WARNING: Could not lock the shared audio buffers for");
+        logger.log("         '" + config_.name + "' into memory even though");
+        logger.log("         'pin_audio_buffers' is enabled. Check the");
+        logger.log("         memlock limit in yabridge's initialization");
+        logger.log("         message.");
+        logger.log("");
+    }
 }
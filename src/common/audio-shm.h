@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -44,6 +47,11 @@
  * for audio processing. The configuration (e.g. name, and dimensions) for this
  * shared memory object are then sent back to the plugin so the plugin can map
  * the same shared memory region.
+ *
+ * The start of the shared memory object contains a small control header with
+ * sequence counters that can be used together with futexes to signal the other
+ * side without having to go through a socket. See `Config::signalling` for more
+ * information.
  */
 class AudioShmBuffer {
    public:
@@ -74,11 +82,26 @@ class AudioShmBuffer {
          */
         uint32_t size;
 
+        /**
+         * The size **in bytes** of the audio area that's actually allocated.
+         * This is at least `size`, and it may be larger to leave room for
+         * future block size or channel layout changes. When `resize()` is
+         * called with a configuration that fits within the current capacity,
+         * the buffer is updated in place without remapping it. The capacity
+         * never shrinks. This is computed by `AudioShmBuffer` on the Wine
+         * side, and the native plugin should receive the Wine side's
+         * `config_` so both sides agree on the final size.
+         *
+         * @see Configuration::audio_buffer_headroom
+         */
+        uint32_t capacity = 0;
+
         /**
          * Offsets **in samples** within the shared memory object for an input
          * audio channel, indexed by `[bus][channel]`. For VST2 plugins the bus
          * will always be 0. This can be used later to retrieve a pointer to the
-         * audio channel.
+         * audio channel. Every channel should start at a multiple of
+         * `channel_alignment` bytes, see `aligned_channel_samples()`.
          */
         std::vector<std::vector<uint32_t>> input_offsets;
         /**
@@ -89,19 +112,279 @@ class AudioShmBuffer {
          */
         std::vector<std::vector<uint32_t>> output_offsets;
 
+        /**
+         * If this is set, then the Wine plugin host will signal that it has
+         * finished processing audio by incrementing the response sequence
+         * counter in the control header and waking up the native plugin using a
+         * futex instead of by sending an acknowledgement over the socket. This
+         * saves a socket round trip for every processed audio block. This is
+         * set based on the `futex_signalling` option in `yabridge.toml`.
+         */
+        bool signalling = false;
+
+        /**
+         * The size **in bytes** of both the request and the response metadata
+         * regions stored between the control header and the audio buffers.
+         * These are used to pass the per-block processing metadata (transport
+         * information, parameter changes, events, and so on) without having to
+         * write them to a socket. This should be a multiple of 64 so the audio
+         * buffers stay aligned. If this is zero, then all metadata will be sent
+         * over the socket.
+         *
+         * @see MetadataRegion
+         */
+        uint32_t metadata_capacity = 0;
+
+        /**
+         * If this is set, then both sides will prefault and explicitly lock
+         * the entire mapping into memory after every (re)mapping, and larger
+         * mappings will be backed by transparent huge pages when the kernel
+         * allows it. This moves page faults that would otherwise happen on
+         * the audio thread the first time a channel gets touched after a
+         * resize to the set up phase. This is set based on the
+         * `pin_audio_buffers` option in `yabridge.toml`.
+         */
+        bool pinned = false;
+
+        /**
+         * Normally the buffers never shrink. If this is set, then `resize()`
+         * will release the memory again when the new layout needs less than
+         * half of the current capacity, for instance after switching from a
+         * large offline rendering block size back to a small realtime block
+         * size. This is set based on the `audio_buffer_reclaim` option in
+         * `yabridge.toml`.
+         */
+        bool reclaimable = false;
+
         template <typename S>
         void serialize(S& s) {
             s.text1b(name, 1024);
             s.value4b(size);
+            s.value4b(capacity);
             s.container(input_offsets, 8192, [](S& s, auto& offsets) {
                 s.container4b(offsets, 8192);
             });
             s.container(output_offsets, 8192, [](S& s, auto& offsets) {
                 s.container4b(offsets, 8192);
             });
+            s.value1b(signalling);
+            s.value4b(metadata_capacity);
+            s.value1b(pinned);
+            s.value1b(reclaimable);
         }
     };
 
+    /**
+     * The two metadata regions stored in the shared memory object. The request
+     * region is written to by the native plugin before it asks the Wine plugin
+     * host to process audio, and the response region is written to by the Wine
+     * plugin host before it signals that it has finished processing.
+     *
+     * @see write_shm_object
+     * @see read_shm_object
+     */
+    enum class MetadataRegion : uint32_t { request = 0, response = 1 };
+
+    /**
+     * The version of the control header's layout described below. This should
+     * be incremented whenever the layout changes.
+     */
+    static constexpr uint32_t control_header_version = 4;
+
+    /**
+     * Audio processing statistics for a single plugin instance, stored in the
+     * control header so they can be read by both sides and by
+     * `yabridgectl stats` while the plugin is processing audio. All durations
+     * are cumulative and in nanoseconds. The time spent in yabridge itself is
+     * the difference between `total_ns` and `plugin_ns`. Every field is only
+     * ever written to by a single thread, so they don't need to be updated
+     * atomically as a whole.
+     *
+     * NOTE: `yabridgectl` reads these fields at fixed offsets, so it needs to
+     *       be updated whenever this layout changes.
+     */
+    struct alignas(64) ProcessingStats {
+        /**
+         * The number of processed blocks. Written by the native plugin.
+         */
+        std::atomic_uint64_t num_blocks;
+        /**
+         * The time between the host calling the plugin's processing function
+         * and yabridge returning from it, including the time spent waiting on
+         * the Wine plugin host. Written by the native plugin.
+         */
+        std::atomic_uint64_t total_ns;
+        /**
+         * The longest single block in `total_ns`. Written by the native plugin.
+         */
+        std::atomic_uint64_t max_total_ns;
+        /**
+         * The time spent inside of the Windows plugin's processing function.
+         * Written by the Wine plugin host.
+         */
+        std::atomic_uint64_t plugin_ns;
+        /**
+         * The longest single block in `plugin_ns`. Written by the Wine plugin
+         * host.
+         */
+        std::atomic_uint64_t max_plugin_ns;
+        /**
+         * The part of `plugin_ns` the plugin spent waiting on host callbacks
+         * it made from the audio thread. Written by the Wine plugin host. This
+         * used to be padding, so older readers simply ignore it.
+         */
+        std::atomic_uint64_t callbacks_ns;
+    };
+
+    static_assert(std::atomic_uint64_t::is_always_lock_free);
+
+    /**
+     * Which processes are using this buffer, so `yabridgectl stats --memory`
+     * can attribute the Wine plugin host's memory usage to individual plugin
+     * instances. Both sides write their own process ID when they map the
+     * buffer.
+     *
+     * NOTE: Just like `ProcessingStats`, `yabridgectl` reads these fields at
+     *       fixed offsets.
+     */
+    struct MemoryStats {
+        /**
+         * The Wine plugin host's process ID.
+         */
+        uint32_t host_pid;
+        /**
+         * The process ID of the host the native plugin has been loaded into.
+         */
+        uint32_t native_pid;
+    };
+
+    /**
+     * When the last block of audio was handled on the Wine side and whether the
+     * Wine plugin host's audio thread was running with realtime scheduling at
+     * the time. This is written by the Wine plugin host before it signals that
+     * the block has been processed. The native plugin uses it to break down
+     * blocks that took too long with the `audio_deadline_warning` option. The
+     * timestamps are `std::chrono::steady_clock` times in nanoseconds, which
+     * uses `CLOCK_MONOTONIC` in both processes.
+     */
+    struct BlockTimings {
+        /**
+         * When the Wine plugin host's audio thread started handling the
+         * request.
+         */
+        std::atomic_uint64_t received_ns;
+        /**
+         * When the Windows plugin's processing function was called.
+         */
+        std::atomic_uint64_t plugin_start_ns;
+        /**
+         * When the Windows plugin's processing function returned.
+         */
+        std::atomic_uint64_t plugin_end_ns;
+        /**
+         * How long the plugin spent waiting on host callbacks made from the
+         * audio thread while processing, included in the plugin's processing
+         * time above.
+         */
+        std::atomic_uint64_t callbacks_ns;
+        /**
+         * Whether the audio thread uses a realtime scheduling policy.
+         */
+        std::atomic_uint32_t realtime;
+    };
+
+    /**
+     * The control header at the start of the shared memory object. This is
+     * followed by the request and response metadata regions, and then the audio
+     * buffers described by `Config::input_offsets` and `Config::output_offsets`
+     * start. The counters are used as futex words, so they need to be plain
+     * 32-bit integers that are shared between both processes. Only fixed width
+     * types are used here since the 32-bit bitbridge has to agree on this
+     * layout.
+     */
+    struct alignas(64) ControlHeader {
+        /**
+         * Set to `control_header_version` by whichever side creates the shared
+         * memory object first.
+         */
+        uint32_t version;
+
+        /**
+         * Incremented by the Wine plugin host after it has finished processing
+         * a block of audio when `Config::signalling` is enabled.
+         */
+        std::atomic_uint32_t response_sequence;
+
+        /**
+         * The number of bytes currently stored in each metadata region, indexed
+         * by `MetadataRegion`.
+         */
+        uint32_t metadata_size[2];
+
+        /**
+         * @see ProcessingStats
+         */
+        ProcessingStats stats;
+
+        /**
+         * @see MemoryStats
+         */
+        MemoryStats memory;
+
+        /**
+         * @see BlockTimings
+         */
+        BlockTimings last_block;
+    };
+
+    static_assert(std::atomic_uint32_t::is_always_lock_free);
+
+    /**
+     * The alignment **in bytes** of every audio channel in the shared memory
+     * object. Aligning channels to cache lines lets the plugin use aligned
+     * SIMD loads and stores, and it guarantees that two channels never share a
+     * cache line.
+     */
+    static constexpr size_t channel_alignment = 64;
+
+    /**
+     * The padding **in bytes** inserted between the input and the output
+     * channels. The native plugin writes to the inputs while the Wine plugin
+     * host writes to the outputs, and modern CPUs prefetch cache lines in
+     * adjacent pairs. Keeping two cache lines between the regions prevents
+     * false sharing between the two processes when the host and Wine audio
+     * threads run on different cores.
+     */
+    static constexpr size_t region_padding = 2 * channel_alignment;
+
+    /**
+     * The number of samples a single audio channel takes up in the shared
+     * memory object, rounded up so that the next channel again starts at a
+     * multiple of `channel_alignment`. The channel offsets in `Config` should
+     * be advanced by this amount.
+     *
+     * @param samples_per_block The maximum number of samples per channel.
+     * @param sample_size The size of a single sample in bytes, so either
+     *   `sizeof(float)` or `sizeof(double)`.
+     */
+    static constexpr uint32_t aligned_channel_samples(
+        uint32_t samples_per_block,
+        size_t sample_size) noexcept {
+        const size_t samples_per_line = channel_alignment / sample_size;
+        return static_cast<uint32_t>(
+            ((samples_per_block + samples_per_line - 1) / samples_per_line) *
+            samples_per_line);
+    }
+
+    /**
+     * The padding from `region_padding` in samples, for advancing the channel
+     * offsets after the last input channel.
+     */
+    static constexpr uint32_t region_padding_samples(
+        size_t sample_size) noexcept {
+        return static_cast<uint32_t>(region_padding / sample_size);
+    }
+
     /**
      * Connect to or create the shared memory object and map it to this
      * process's memory. The configuration is created on the Wine side using the
@@ -109,6 +392,8 @@ class AudioShmBuffer {
      *
      * @throw std::system_error If the shared memory object could not be
      *   created or mapped.
+     * @throw std::runtime_error If the shared memory object was created with an
+     *   incompatible control header layout.
      */
     AudioShmBuffer(const Config& config);
 
@@ -127,7 +412,10 @@ class AudioShmBuffer {
 
     /**
      * Adapt to a new buffer size or channel layout. The name of the buffer
-     * needs to remain the same.
+     * needs to remain the same. If the new layout fits within the buffer's
+     * current capacity, then only the offsets are updated and the mapping is
+     * left untouched. Otherwise the shared memory object is grown and
+     * remapped.
      *
      * @throw `std::invalid_argument` If the config is for a buffer with a
      *   different name.
@@ -135,6 +423,171 @@ class AudioShmBuffer {
      */
     void resize(const Config& new_config);
 
+    /**
+     * Give the memory backing the audio channels back to the kernel, while
+     * keeping the shared memory object and both sides' mappings intact. The
+     * control header and the metadata regions are left alone. The memory will
+     * be faulted back in as zeroes once either side touches it again. Called
+     * on the Wine plugin host side for the `audio_buffer_idle_release_s`
+     * option.
+     *
+     * @see restore_memory
+     */
+    void release_memory() noexcept;
+
+    /**
+     * Lock the memory released with `release_memory()` again, and prefault it
+     * if `Config::pinned` is set. Does nothing if the memory has not been
+     * released.
+     */
+    void restore_memory() noexcept;
+
+    /**
+     * Bind the memory backing these buffers to a NUMA node for the
+     * `audio_thread_follow_host_numa_node` option. Pages that already exist
+     * are moved to that node when the kernel allows it, and pages faulted in
+     * later, for instance after a resize or after `release_memory()`, are
+     * allocated there. The binding is reapplied whenever the buffers get
+     * resized. This is best effort, so failures are ignored.
+     */
+    void bind_to_numa_node(int node) noexcept;
+
+    /**
+     * Whether the response to a process request should be signalled through
+     * the futex in the control header instead of through the socket.
+     *
+     * @see Config::signalling
+     */
+    inline bool signalling_enabled() const noexcept {
+        return config_.signalling;
+    }
+
+    /**
+     * Get the current value of the response sequence counter. This should be
+     * read before sending a process request so it can later be passed to
+     * `wait_for_response()`.
+     */
+    inline uint32_t response_sequence() const noexcept {
+        return header()->response_sequence.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Increment the response sequence counter and wake up the thread waiting
+     * on it in `wait_for_response()`. Called on the Wine plugin host side after
+     * the plugin has written its outputs to this buffer.
+     */
+    void notify_response() noexcept;
+
+    /**
+     * Wait until the response sequence counter no longer equals
+     * `last_sequence`, or until the timeout has been reached. This allows the
+     * caller to periodically check whether the Wine plugin host is still
+     * running.
+     *
+     * @param last_sequence The value returned by `response_sequence()` before
+     *   the request was sent.
+     * @param timeout The maximum amount of time to wait for.
+     *
+     * @return Whether the counter has changed. If this returns false, the
+     *   timeout has been reached.
+     */
+    bool wait_for_response(uint32_t last_sequence,
+                           std::chrono::milliseconds timeout) noexcept;
+
+    /**
+     * Busy-wait until the response sequence counter no longer equals
+     * `last_sequence`, for at most `budget`. This can be used before calling
+     * `wait_for_response()` to avoid the latency of being woken up by the
+     * scheduler when the response is expected to arrive very soon.
+     *
+     * @param last_sequence The value returned by `response_sequence()` before
+     *   the request was sent.
+     * @param budget The maximum amount of time to spin for.
+     *
+     * @return Whether the counter has changed while we were spinning.
+     *
+     * @see Configuration::audio_wait_spin_us
+     */
+    bool spin_for_response(uint32_t last_sequence,
+                           std::chrono::microseconds budget) const noexcept;
+
+    /**
+     * Add the time the Windows plugin spent processing a single block to the
+     * statistics in the control header. Called on the Wine plugin host side.
+     *
+     * @param duration The time spent in the plugin's processing function.
+     * @param callbacks_duration The part of `duration` spent waiting on host
+     *   callbacks.
+     *
+     * @see ProcessingStats
+     */
+    void record_plugin_time(
+        std::chrono::nanoseconds duration,
+        std::chrono::nanoseconds callbacks_duration) noexcept;
+
+    /**
+     * Add the time a single bridged processing call took to the statistics in
+     * the control header, and increment the block count. Called on the native
+     * plugin side.
+     *
+     * @see ProcessingStats
+     */
+    void record_total_time(std::chrono::nanoseconds duration) noexcept;
+
+    /**
+     * Store the timings for the block that was just processed. Called on the
+     * Wine plugin host side before notifying the native plugin.
+     *
+     * @see BlockTimings
+     */
+    void record_block_timings(
+        std::chrono::steady_clock::time_point received,
+        std::chrono::steady_clock::time_point plugin_start,
+        std::chrono::steady_clock::time_point plugin_end,
+        std::chrono::nanoseconds callbacks,
+        bool realtime) noexcept;
+
+    /**
+     * The timings for the last processed block. Only meaningful on the native
+     * plugin side after the Wine plugin host has finished processing.
+     */
+    inline const BlockTimings& last_block_timings() const noexcept {
+        return header()->last_block;
+    }
+
+    /**
+     * The capacity of each of the two metadata regions, in bytes.
+     */
+    inline size_t metadata_capacity() const noexcept {
+        return config_.metadata_capacity;
+    }
+
+    /**
+     * Get a pointer to the start of one of the metadata regions. These
+     * addresses might change after a call to `resize()`.
+     */
+    inline uint8_t* metadata_ptr(MetadataRegion region) noexcept {
+        return shm_bytes_ + sizeof(ControlHeader) +
+               (static_cast<size_t>(region) * config_.metadata_capacity);
+    }
+
+    inline const uint8_t* metadata_ptr(MetadataRegion region) const noexcept {
+        return shm_bytes_ + sizeof(ControlHeader) +
+               (static_cast<size_t>(region) * config_.metadata_capacity);
+    }
+
+    /**
+     * The number of bytes last written to a metadata region.
+     */
+    inline uint32_t metadata_size(MetadataRegion region) const noexcept {
+        return header()->metadata_size[static_cast<size_t>(region)];
+    }
+
+    inline void set_metadata_size(MetadataRegion region,
+                                  uint32_t size) noexcept {
+        header()->metadata_size[static_cast<size_t>(region)] = size;
+    }
+
     inline size_t num_input_channels(const uint32_t bus) const {
         return config_.input_offsets[bus].size();
     }
@@ -151,7 +604,7 @@ class AudioShmBuffer {
     template <typename T>
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     T* input_channel_ptr(const uint32_t bus, const uint32_t channel) noexcept {
-        return reinterpret_cast<T*>(shm_bytes_) +
+        return reinterpret_cast<T*>(audio_bytes()) +
                config_.input_offsets[bus][channel];
     }
 
@@ -159,7 +612,7 @@ class AudioShmBuffer {
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     const T* input_channel_ptr(const uint32_t bus,
                                const uint32_t channel) const noexcept {
-        return reinterpret_cast<const T*>(shm_bytes_) +
+        return reinterpret_cast<const T*>(audio_bytes()) +
                config_.input_offsets[bus][channel];
     }
 
@@ -171,7 +624,7 @@ class AudioShmBuffer {
     template <typename T>
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     T* output_channel_ptr(const uint32_t bus, const uint32_t channel) noexcept {
-        return reinterpret_cast<T*>(shm_bytes_) +
+        return reinterpret_cast<T*>(audio_bytes()) +
                config_.output_offsets[bus][channel];
     }
 
@@ -179,13 +632,67 @@ class AudioShmBuffer {
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     const T* output_channel_ptr(const uint32_t bus,
                                 const uint32_t channel) const noexcept {
-        return reinterpret_cast<const T*>(shm_bytes_) +
+        return reinterpret_cast<const T*>(audio_bytes()) +
                config_.output_offsets[bus][channel];
     }
 
+    /**
+     * A counter that gets incremented every time this buffer is resized. This
+     * can be used to invalidate information cached about the contents of the
+     * audio channels, since those may have moved or been cleared after a
+     * resize. This is local to this process.
+     */
+    inline uint32_t generation() const noexcept { return generation_; }
+
+    /**
+     * The size of the allocated audio area in bytes. This is at least as
+     * large as the current configuration's size.
+     *
+     * @see Config::capacity
+     */
+    inline uint32_t capacity() const noexcept { return config_.capacity; }
+
+    /**
+     * A copy of the counters from `ProcessingStats`.
+     */
+    struct ProcessingStatsSnapshot {
+        uint64_t num_blocks;
+        uint64_t total_ns;
+        uint64_t plugin_ns;
+        uint64_t callbacks_ns;
+    };
+
+    /**
+     * Read the processing statistics from the control header of the shared
+     * memory object called `name`, by only mapping that header. This is used
+     * for the group host's metrics endpoint, which runs on another thread than
+     * the one that may be resizing or destroying the buffer.
+     *
+     * @return The statistics, or a nullopt if the object doesn't exist
+     *   (anymore) or if it uses a different control header layout.
+     */
+    static std::optional<ProcessingStatsSnapshot> read_processing_stats(
+        const std::string& name) noexcept;
+
     Config config_;
 
    private:
+    inline ControlHeader* header() noexcept {
+        return reinterpret_cast<ControlHeader*>(shm_bytes_);
+    }
+    inline const ControlHeader* header() const noexcept {
+        return reinterpret_cast<const ControlHeader*>(shm_bytes_);
+    }
+
+    inline uint8_t* audio_bytes() noexcept {
+        return shm_bytes_ + sizeof(ControlHeader) +
+               (2 * static_cast<size_t>(config_.metadata_capacity));
+    }
+    inline const uint8_t* audio_bytes() const noexcept {
+        return shm_bytes_ + sizeof(ControlHeader) +
+               (2 * static_cast<size_t>(config_.metadata_capacity));
+    }
+
     /**
      * Resize the shared memory object, and set up the memory mapping.
      *
@@ -193,6 +700,13 @@ class AudioShmBuffer {
      */
     void setup_mapping();
 
+    /**
+     * Prefault and lock the entire mapping, and ask the kernel to back it with
+     * huge pages if it's large enough. Called from `setup_mapping()` when
+     * `Config::pinned` is set. Failures are logged, but they're not fatal.
+     */
+    void pin_mapping() noexcept;
+
     /**
      * The file descriptor for our shared memory object.
      */
@@ -202,9 +716,25 @@ class AudioShmBuffer {
      */
     uint8_t* shm_bytes_ = nullptr;
     /**
-     * The size of the mapped shared memory area, used for remapping.
+     * The size of the mapped shared memory area, used for remapping. This
+     * includes the control header.
      */
     size_t shm_size_ = 0;
 
+    /**
+     * @see generation
+     */
+    uint32_t generation_ = 0;
+
+    /**
+     * @see release_memory
+     */
+    bool memory_released_ = false;
+
+    /**
+     * @see bind_to_numa_node
+     */
+    std::optional<int> numa_node_;
+
     bool is_moved_ = false;
 };
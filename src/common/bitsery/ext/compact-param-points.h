@@ -0,0 +1,128 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include <bitsery/ext/compact_value.h>
+#include <bitsery/traits/core/traits.h>
+
+namespace bitsery {
+namespace ext {
+
+/**
+ * A compact encoding for the `(sample_offset, value)` points stored in a VST3
+ * parameter value queue. Automation heavy projects send a lot of these every
+ * processing cycle, and serializing them verbatim costs twelve bytes per
+ * point. Instead, every point here starts with a variable length header
+ * containing the difference between its sample offset and the previous
+ * point's sample offset (which will almost always fit in one or two bytes),
+ * and a flag indicating that the point has the exact same value as the
+ * previous point. In that case the value is omitted. The points themselves are
+ * never dropped or altered, since that would change how the plugin
+ * interpolates between them.
+ *
+ * This works with any vector-like container of `std::pair<int32, double>`s.
+ */
+class CompactParamPoints {
+   public:
+    /**
+     * @param max_size The maximum number of points we'll accept while
+     *   deserializing.
+     */
+    explicit CompactParamPoints(size_t max_size) : max_size_(max_size) {}
+
+    template <typename Ser, typename T, typename Fnc>
+    void serialize(Ser& ser, const T& points, Fnc&&) const {
+        uint32_t size = static_cast<uint32_t>(points.size());
+        ser.ext4b(size, CompactValue{});
+
+        int32_t previous_offset = 0;
+        uint64_t previous_value_bits = 0;
+        bool first = true;
+        for (const auto& [offset, value] : points) {
+            const uint64_t value_bits = std::bit_cast<uint64_t>(value);
+            const bool same_value = !first && value_bits == previous_value_bits;
+
+            // The offset difference is zigzag encoded so that the occasional
+            // out of order point still results in a small number
+            const int64_t offset_delta =
+                static_cast<int64_t>(offset) - previous_offset;
+            const uint64_t zigzag_delta =
+                (static_cast<uint64_t>(offset_delta) << 1) ^
+                static_cast<uint64_t>(offset_delta >> 63);
+            uint64_t header = (zigzag_delta << 1) | (same_value ? 1 : 0);
+            ser.ext8b(header, CompactValue{});
+            if (!same_value) {
+                ser.value8b(value);
+            }
+
+            previous_offset = offset;
+            previous_value_bits = value_bits;
+            first = false;
+        }
+    }
+
+    template <typename Des, typename T, typename Fnc>
+    void deserialize(Des& des, T& points, Fnc&&) const {
+        uint32_t size = 0;
+        des.ext4b(size, CompactValue{});
+        if (size > max_size_) {
+            des.adapter().error(ReaderError::InvalidData);
+            return;
+        }
+
+        points.resize(size);
+        int32_t previous_offset = 0;
+        double previous_value = 0.0;
+        for (auto& [offset, value] : points) {
+            uint64_t header = 0;
+            des.ext8b(header, CompactValue{});
+
+            const uint64_t zigzag_delta = header >> 1;
+            const int64_t offset_delta =
+                static_cast<int64_t>(zigzag_delta >> 1) ^
+                -static_cast<int64_t>(zigzag_delta & 1);
+            offset = static_cast<int32_t>(previous_offset + offset_delta);
+            if (header & 1) {
+                value = previous_value;
+            } else {
+                des.value8b(value);
+            }
+
+            previous_offset = offset;
+            previous_value = value;
+        }
+    }
+
+   private:
+    size_t max_size_;
+};
+
+}  // namespace ext
+
+namespace traits {
+template <typename T>
+struct ExtensionTraits<ext::CompactParamPoints, T> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+}  // namespace traits
+}  // namespace bitsery
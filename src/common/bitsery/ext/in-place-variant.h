@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <array>
+#include <utility>
+
 #include <bitsery/ext/std_variant.h>
 
 namespace bitsery {
@@ -29,6 +32,14 @@ namespace ext {
  * single and double precision audio, but as it turns out bitsery's
  * `std::variant` extension would always reinitialize those objects, undoing our
  * efforts to prevent allocations.
+ *
+ * The VST3 request variants contain well over a hundred types, so instead of
+ * bitsery's approach of comparing the deserialized index against every
+ * alternative in turn, we'll jump straight to the alternative's
+ * deserialization function through a table indexed by the variant index. New
+ * alternatives are also constructed directly inside of the variant instead of
+ * first being deserialized into a temporary and then being moved into another
+ * temporary variant.
  */
 template <typename... Overloads>
 class InPlaceVariant : public StdVariant<Overloads...> {
@@ -40,29 +51,42 @@ class InPlaceVariant : public StdVariant<Overloads...> {
             des.adapter(), index, sizeof...(Ts),
             std::integral_constant<bool, Des::TConfig::CheckDataErrors>{});
 
-        // Most of this is copied directly from the original implementation.
-        // We just added the check here to reuse the existing object if
-        // possible.
-        this->execIndex(index, obj, [this, &des](auto& data, auto index) {
-            constexpr size_t Index = decltype(index)::value;
-            using TElem =
-                typename std::variant_alternative<Index,
-                                                  std::variant<Ts...>>::type;
-            // Reinitializing nontrivial types may be expensive especially when
-            // they reference heap data, so if `data` is already holding the
-            // requested variant then we'll deserialize into the existing object
-            if constexpr (!std::is_trivial_v<TElem>) {
-                if (auto item = std::get_if<TElem>(&data)) {
-                    this->serializeType(des, *item);
-                    return;
-                }
+        using Deserializer =
+            void (*)(const InPlaceVariant&, Des&, std::variant<Ts...>&);
+        constexpr auto deserializers =
+            []<size_t... Indices>(std::index_sequence<Indices...>) {
+                return std::array<Deserializer, sizeof...(Ts)>{
+                    &deserialize_alternative<Indices, Des, Ts...>...};
+            }(std::index_sequence_for<Ts...>{});
+
+        // Like in bitsery's implementation, invalid indices are ignored when
+        // data error checking is disabled
+        if (index < sizeof...(Ts)) {
+            deserializers[index](*this, des, obj);
+        }
+    }
+
+   private:
+    template <size_t Index, typename Des, typename... Ts>
+    static void deserialize_alternative(const InPlaceVariant& self,
+                                        Des& des,
+                                        std::variant<Ts...>& obj) {
+        using TElem =
+            typename std::variant_alternative<Index, std::variant<Ts...>>::type;
+
+        // Reinitializing nontrivial types may be expensive especially when
+        // they reference heap data, so if `obj` is already holding the
+        // requested variant then we'll deserialize into the existing object
+        if constexpr (!std::is_trivial_v<TElem>) {
+            if (obj.index() == Index) {
+                self.serializeType(des, std::get<Index>(obj));
+                return;
             }
+        }
 
-            TElem item = ::bitsery::Access::create<TElem>();
-            this->serializeType(des, item);
-            data = std::variant<Ts...>(std::in_place_index_t<Index>{},
-                                       std::move(item));
-        });
+        TElem& item =
+            obj.template emplace<Index>(::bitsery::Access::create<TElem>());
+        self.serializeType(des, item);
     }
 };
 
@@ -0,0 +1,569 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <bitsery/traits/core/traits.h>
+
+namespace bitsery {
+namespace ext {
+
+/**
+ * A temporary POSIX shared memory object used to pass a large blob to the
+ * other side. The object is created with a unique name by one side, that name
+ * is sent to the other side, and the other side then opens the object and
+ * immediately unlinks it. A name can thus only be received once. After that
+ * both sides can keep using their file descriptors until they are closed.
+ *
+ * If an object was created but its name was never sent to the other side, then
+ * it will be unlinked again when this object gets destroyed.
+ */
+class SharedMemoryFile {
+   public:
+    /**
+     * Create a new, empty shared memory object with a unique name.
+     *
+     * @return The new object, or a nullopt if it could not be created.
+     */
+    static std::optional<SharedMemoryFile> create() noexcept {
+        // Process IDs are unique among all yabridge processes, and the counter
+        // makes the name unique within a process
+        static std::atomic_size_t next_blob_id = 0;
+        std::string name = "/yabridge-blob-" + std::to_string(getpid()) + "-" +
+                           std::to_string(next_blob_id++);
+
+        const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd == -1) {
+            return std::nullopt;
+        }
+
+        return SharedMemoryFile(fd, std::move(name));
+    }
+
+    /**
+     * Open a shared memory object created by the other side using `create()`,
+     * and unlink its name.
+     *
+     * @return The opened object, or a nullopt if it could not be opened.
+     */
+    static std::optional<SharedMemoryFile> open(
+        const std::string& name) noexcept {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd == -1) {
+            return std::nullopt;
+        }
+
+        // We're the only ones who will ever open this object, so the data
+        // stays available until both sides have closed their file descriptors
+        shm_unlink(name.c_str());
+
+        return SharedMemoryFile(fd, "");
+    }
+
+    SharedMemoryFile(const SharedMemoryFile&) = delete;
+    SharedMemoryFile& operator=(const SharedMemoryFile&) = delete;
+
+    SharedMemoryFile(SharedMemoryFile&& o) noexcept
+        : fd_(o.fd_), name_(std::move(o.name_)) {
+        o.fd_ = -1;
+        o.name_.clear();
+    }
+    SharedMemoryFile& operator=(SharedMemoryFile&& o) noexcept {
+        if (this != &o) {
+            reset();
+
+            fd_ = o.fd_;
+            name_ = std::move(o.name_);
+            o.fd_ = -1;
+            o.name_.clear();
+        }
+
+        return *this;
+    }
+
+    ~SharedMemoryFile() noexcept { reset(); }
+
+    /**
+     * Hand out this object's name so it can be sent to the other side. The
+     * other side will unlink the object when it opens it, so this returns an
+     * empty string if the name has already been handed out or if this object
+     * was opened using `open()`.
+     */
+    std::string take_name() const noexcept {
+        std::string name;
+        name.swap(name_);
+
+        return name;
+    }
+
+    /**
+     * Read `size` bytes starting at `offset` into `data`.
+     *
+     * @return Whether all bytes could be read.
+     */
+    bool read(uint64_t offset, void* data, size_t size) const noexcept {
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+
+        size_t bytes_read = 0;
+        while (bytes_read < size) {
+            const ssize_t result =
+                pread(fd_, bytes + bytes_read, size - bytes_read,
+                      static_cast<off_t>(offset + bytes_read));
+            if (result <= 0) {
+                return false;
+            }
+
+            bytes_read += static_cast<size_t>(result);
+        }
+
+        return true;
+    }
+
+    /**
+     * Write `size` bytes from `data` starting at `offset`, growing the object
+     * if needed.
+     *
+     * @return Whether all bytes could be written.
+     */
+    bool write(uint64_t offset, const void* data, size_t size) noexcept {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+        size_t bytes_written = 0;
+        while (bytes_written < size) {
+            const ssize_t result =
+                pwrite(fd_, bytes + bytes_written, size - bytes_written,
+                       static_cast<off_t>(offset + bytes_written));
+            if (result <= 0) {
+                return false;
+            }
+
+            bytes_written += static_cast<size_t>(result);
+        }
+
+        return true;
+    }
+
+    /**
+     * Grow or shrink the object.
+     *
+     * @return Whether the object could be resized.
+     */
+    bool truncate(uint64_t size) noexcept {
+        return ftruncate(fd_, static_cast<off_t>(size)) == 0;
+    }
+
+   private:
+    SharedMemoryFile(int fd, std::string name) noexcept
+        : fd_(fd), name_(std::move(name)) {}
+
+    void reset() noexcept {
+        if (fd_ != -1) {
+            close(fd_);
+            fd_ = -1;
+        }
+        if (!name_.empty()) {
+            shm_unlink(name_.c_str());
+            name_.clear();
+        }
+    }
+
+    int fd_ = -1;
+    /**
+     * The object's name, as long as it still has to be sent to the other side.
+     * `take_name()` is called during serialization, which is why this is
+     * mutable.
+     */
+    mutable std::string name_;
+};
+
+/**
+ * A byte buffer that's stored in a regular `std::vector<uint8_t>` while it's
+ * small, and that moves to a `SharedMemoryFile` once it grows past
+ * `SharedMemoryBlob::shared_memory_threshold`. When serialized using the
+ * `SharedMemoryBlob` extension, a buffer stored in shared memory is not copied
+ * at all. Only the shared memory object's name is sent, and the other side will
+ * then read from and write to that same object.
+ *
+ * This is used for `YaBStream`, so large VST3 plugin states can be copied from
+ * and to the host's stream in small windows instead of always having to keep
+ * several full copies of the state in memory.
+ */
+class SharedMemoryBuffer {
+   public:
+    SharedMemoryBuffer() noexcept = default;
+
+    /**
+     * Copies get their own shared memory object so they can be modified
+     * independently. If that object cannot be created, then the copy will store
+     * its data in a vector instead.
+     */
+    SharedMemoryBuffer(const SharedMemoryBuffer& o);
+    SharedMemoryBuffer& operator=(const SharedMemoryBuffer& o);
+
+    SharedMemoryBuffer(SharedMemoryBuffer&&) noexcept = default;
+    SharedMemoryBuffer& operator=(SharedMemoryBuffer&&) noexcept = default;
+
+    size_t size() const noexcept {
+        return file_ ? file_size_ : buffer_.size();
+    }
+
+    /**
+     * Copy `size` bytes starting at `offset` to `data`. The caller should make
+     * sure this range lies within the buffer.
+     *
+     * @return Whether the data could be read.
+     */
+    bool read(uint64_t offset, void* data, size_t size) const noexcept {
+        if (file_) {
+            return file_->read(offset, data, size);
+        } else {
+            std::copy_n(buffer_.data() + offset, size,
+                        static_cast<uint8_t*>(data));
+            return true;
+        }
+    }
+
+    /**
+     * Copy `size` bytes from `data` to the buffer, starting at `offset`,
+     * growing the buffer if needed.
+     *
+     * @return Whether the data could be written.
+     */
+    bool write(uint64_t offset, const void* data, size_t size);
+
+    /**
+     * Grow or shrink the buffer. New bytes will be zero-initialized.
+     *
+     * @return Whether the buffer could be resized.
+     */
+    bool resize(size_t size);
+
+    // These are accessed by the `SharedMemoryBlob` extension
+    std::vector<uint8_t> buffer_;
+    std::optional<SharedMemoryFile> file_;
+    size_t file_size_ = 0;
+
+   private:
+    /**
+     * Move the contents of `buffer_` to a new shared memory object if the
+     * buffer needs to grow past `SharedMemoryBlob::shared_memory_threshold`.
+     * If the object cannot be created, we'll keep using the vector.
+     */
+    void maybe_move_to_shared_memory(size_t new_size);
+};
+
+/**
+ * Copy the first `size` bytes from one shared memory object to another.
+ *
+ * @return Whether all bytes could be copied.
+ */
+inline bool copy_shared_memory_file(const SharedMemoryFile& from,
+                                    SharedMemoryFile& to,
+                                    uint64_t size);
+
+/**
+ * Serialize large binary blobs like preset chunks through a temporary shared
+ * memory object instead of copying them into the serialized message. Sending
+ * hundreds of megabytes of data over a socket means copying that data into the
+ * serialization buffer, into and out of the socket's kernel buffers in small
+ * pieces, and then out of the deserialization buffer again. With this
+ * extension the serializing side writes the blob to a new shared memory object
+ * and only sends that object's name. The deserializing side then reads the blob
+ * back and unlinks the object. This also lifts the size limit for these blobs.
+ *
+ * Small blobs are still serialized inline, since creating and mapping a shared
+ * memory object is more expensive than sending a few kilobytes over a socket.
+ *
+ * This works with both `std::vector<uint8_t>` and `SharedMemoryBuffer`. In the
+ * latter case the data stays in the shared memory object on both sides instead
+ * of being copied into a vector.
+ *
+ * NOTE: If a message using this extension gets serialized but never received
+ *       (because the other side crashed), then the shared memory object will
+ *       be left behind in `/dev/shm`.
+ */
+class SharedMemoryBlob {
+   public:
+    /**
+     * Blobs larger than this will be sent through shared memory.
+     */
+    static constexpr size_t shared_memory_threshold = 1 << 20;
+
+    /**
+     * The maximum size of a blob sent through shared memory. VST2 and VST3 use
+     * 32-bit integers for their chunk sizes, so this is plenty.
+     */
+    static constexpr uint64_t max_shared_memory_size = 1ull << 31;
+
+    /**
+     * @param max_inline_size The maximum size of a blob that was serialized
+     *   inline. This is used for the inline container's bounds check, and for
+     *   the fallback if we can't create a shared memory object.
+     */
+    explicit SharedMemoryBlob(size_t max_inline_size)
+        : max_inline_size_(max_inline_size) {}
+
+    template <typename Ser, typename Fnc>
+    void serialize(Ser& ser, const std::vector<uint8_t>& blob, Fnc&&) const {
+        std::string name;
+        if (blob.size() > shared_memory_threshold &&
+            blob.size() <= max_shared_memory_size) {
+            if (auto file = SharedMemoryFile::create();
+                file && file->write(0, blob.data(), blob.size())) {
+                name = file->take_name();
+            }
+        }
+
+        serialize_header(ser, name, blob.size());
+        if (name.empty()) {
+            ser.container1b(blob, max_inline_size_);
+        }
+    }
+
+    template <typename Ser, typename Fnc>
+    void serialize(Ser& ser, const SharedMemoryBuffer& blob, Fnc&&) const {
+        if (!blob.file_) {
+            serialize(ser, blob.buffer_, [](Ser&, const uint8_t&) {});
+            return;
+        }
+
+        // If we've received this buffer from the other side then its name has
+        // already been unlinked, so we'll need to copy it to a new object
+        std::string name = blob.file_->take_name();
+        if (name.empty()) {
+            if (auto file = SharedMemoryFile::create();
+                file &&
+                copy_shared_memory_file(*blob.file_, *file, blob.file_size_)) {
+                name = file->take_name();
+            }
+        }
+
+        // We can't send the data inline if it doesn't fit, so the other side
+        // will end up with an empty buffer
+        serialize_header(ser, name, name.empty() ? 0 : blob.file_size_);
+        if (name.empty()) {
+            ser.container1b(std::vector<uint8_t>{}, max_inline_size_);
+        }
+    }
+
+    template <typename Des, typename Fnc>
+    void deserialize(Des& des, std::vector<uint8_t>& blob, Fnc&&) const {
+        std::string name;
+        uint64_t size = 0;
+        if (!deserialize_header(des, name, size)) {
+            des.container1b(blob, max_inline_size_);
+            return;
+        }
+
+        const std::optional<SharedMemoryFile> file =
+            SharedMemoryFile::open(name);
+        if (!file || size > max_shared_memory_size) {
+            blob.clear();
+            des.adapter().error(ReaderError::InvalidData);
+            return;
+        }
+
+        blob.resize(size);
+        if (!file->read(0, blob.data(), size)) {
+            blob.clear();
+            des.adapter().error(ReaderError::InvalidData);
+        }
+    }
+
+    template <typename Des, typename Fnc>
+    void deserialize(Des& des, SharedMemoryBuffer& blob, Fnc&&) const {
+        std::string name;
+        uint64_t size = 0;
+        if (!deserialize_header(des, name, size)) {
+            blob.file_.reset();
+            blob.file_size_ = 0;
+            des.container1b(blob.buffer_, max_inline_size_);
+            return;
+        }
+
+        blob.buffer_.clear();
+        blob.file_ = SharedMemoryFile::open(name);
+        blob.file_size_ = size;
+        if (!blob.file_ || size > max_shared_memory_size) {
+            blob.file_.reset();
+            blob.file_size_ = 0;
+            des.adapter().error(ReaderError::InvalidData);
+        }
+    }
+
+   private:
+    /**
+     * Write whether the blob is stored in shared memory, and if it is, the
+     * shared memory object's name and the blob's size. `name` should be empty
+     * if the blob is sent inline.
+     */
+    template <typename Ser>
+    static void serialize_header(Ser& ser,
+                                 const std::string& name,
+                                 uint64_t size) {
+        bool in_shared_memory = !name.empty();
+        ser.value1b(in_shared_memory);
+        if (in_shared_memory) {
+            ser.text1b(name, 255);
+            ser.value8b(size);
+        }
+    }
+
+    /**
+     * The counterpart to `serialize_header()`.
+     *
+     * @return Whether the blob is stored in shared memory. If this returns
+     *   false, then the blob is stored inline.
+     */
+    template <typename Des>
+    static bool deserialize_header(Des& des, std::string& name, uint64_t& size) {
+        bool in_shared_memory = false;
+        des.value1b(in_shared_memory);
+        if (in_shared_memory) {
+            des.text1b(name, 255);
+            des.value8b(size);
+        }
+
+        return in_shared_memory;
+    }
+
+    size_t max_inline_size_;
+
+};
+
+inline bool copy_shared_memory_file(const SharedMemoryFile& from,
+                                    SharedMemoryFile& to,
+                                    uint64_t size) {
+    std::vector<uint8_t> window(
+        std::min<uint64_t>(size, SharedMemoryBlob::shared_memory_threshold));
+    for (uint64_t offset = 0; offset < size; offset += window.size()) {
+        const size_t window_size =
+            std::min<uint64_t>(window.size(), size - offset);
+        if (!from.read(offset, window.data(), window_size) ||
+            !to.write(offset, window.data(), window_size)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline SharedMemoryBuffer::SharedMemoryBuffer(const SharedMemoryBuffer& o)
+    : buffer_(o.buffer_) {
+    if (o.file_) {
+        if (auto file = SharedMemoryFile::create();
+            file && copy_shared_memory_file(*o.file_, *file, o.file_size_)) {
+            file_ = std::move(file);
+            file_size_ = o.file_size_;
+        } else {
+            buffer_.resize(o.file_size_);
+            o.file_->read(0, buffer_.data(), o.file_size_);
+        }
+    }
+}
+
+inline SharedMemoryBuffer& SharedMemoryBuffer::operator=(
+    const SharedMemoryBuffer& o) {
+    if (this != &o) {
+        *this = SharedMemoryBuffer(o);
+    }
+
+    return *this;
+}
+
+inline bool SharedMemoryBuffer::write(uint64_t offset,
+                                      const void* data,
+                                      size_t size) {
+    maybe_move_to_shared_memory(offset + size);
+    if (file_) {
+        if (!file_->write(offset, data, size)) {
+            return false;
+        }
+
+        file_size_ = std::max<size_t>(file_size_, offset + size);
+    } else {
+        if (offset + size > buffer_.size()) {
+            buffer_.resize(offset + size);
+        }
+
+        std::copy_n(static_cast<const uint8_t*>(data), size,
+                    buffer_.data() + offset);
+    }
+
+    return true;
+}
+
+inline bool SharedMemoryBuffer::resize(size_t size) {
+    maybe_move_to_shared_memory(size);
+    if (file_) {
+        if (!file_->truncate(size)) {
+            return false;
+        }
+
+        file_size_ = size;
+    } else {
+        buffer_.resize(size);
+    }
+
+    return true;
+}
+
+inline void SharedMemoryBuffer::maybe_move_to_shared_memory(size_t new_size) {
+    if (file_ || new_size <= SharedMemoryBlob::shared_memory_threshold) {
+        return;
+    }
+
+    if (auto file = SharedMemoryFile::create();
+        file && file->write(0, buffer_.data(), buffer_.size())) {
+        file_ = std::move(file);
+        file_size_ = buffer_.size();
+
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+    }
+}
+
+}  // namespace ext
+
+namespace traits {
+template <>
+struct ExtensionTraits<ext::SharedMemoryBlob, std::vector<uint8_t>> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+
+template <>
+struct ExtensionTraits<ext::SharedMemoryBlob, ext::SharedMemoryBuffer> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+}  // namespace traits
+}  // namespace bitsery
@@ -0,0 +1,91 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <bitsery/ext/compact_value.h>
+#include <bitsery/traits/core/traits.h>
+
+namespace bitsery {
+namespace ext {
+
+/**
+ * Serialize a contiguous container of trivially copyable objects as a single
+ * block of bytes, instead of serializing every field of every element
+ * separately. This is only safe because both sides of the connection are
+ * always running on the same machine and are built from the same source, so
+ * the objects' layouts will match exactly.
+ *
+ * This works with any vector-like container that has `size()`, `resize()` and
+ * `data()` member functions.
+ */
+class TrivialContainer {
+   public:
+    /**
+     * @param max_size The maximum number of elements we'll accept while
+     *   deserializing.
+     */
+    explicit TrivialContainer(size_t max_size) : max_size_(max_size) {}
+
+    template <typename Ser, typename T, typename Fnc>
+    void serialize(Ser& ser, const T& container, Fnc&&) const {
+        using value_type = typename T::value_type;
+        static_assert(std::is_trivially_copyable_v<value_type>);
+
+        uint32_t size = static_cast<uint32_t>(container.size());
+        ser.ext4b(size, CompactValue{});
+        ser.adapter().template writeBuffer<1>(
+            reinterpret_cast<const uint8_t*>(container.data()),
+            size * sizeof(value_type));
+    }
+
+    template <typename Des, typename T, typename Fnc>
+    void deserialize(Des& des, T& container, Fnc&&) const {
+        using value_type = typename T::value_type;
+        static_assert(std::is_trivially_copyable_v<value_type>);
+
+        uint32_t size = 0;
+        des.ext4b(size, CompactValue{});
+        if (size > max_size_) {
+            des.adapter().error(ReaderError::InvalidData);
+            return;
+        }
+
+        container.resize(size);
+        des.adapter().template readBuffer<1>(
+            reinterpret_cast<uint8_t*>(container.data()),
+            size * sizeof(value_type));
+    }
+
+   private:
+    size_t max_size_;
+};
+
+}  // namespace ext
+
+namespace traits {
+template <typename T>
+struct ExtensionTraits<ext::TrivialContainer, T> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+}  // namespace traits
+}  // namespace bitsery
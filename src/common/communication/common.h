@@ -16,8 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <variant>
+
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <bitsery/adapter/buffer.h>
 #include <bitsery/bitsery.h>
@@ -33,9 +40,14 @@
 #include <asio/write.hpp>
 #include <ghc/filesystem.hpp>
 
+#include "../audio-shm.h"
 #include "../bitsery/traits/small-vector.h"
 #include "../logging/common.h"
+#include "../logging/histograms.h"
+#include "../logging/trace.h"
+#include "../probes.h"
 #include "../utils.h"
+#include "io-uring.h"
 
 // Our input and output adapters for binary serialization always expect the data
 // to be encoded in little endian format. This should not make any difference
@@ -79,6 +91,90 @@ using SerializationBuffer = llvm::SmallVector<uint8_t, N>;
  */
 using SerializationBufferBase = llvm::SmallVectorImpl<uint8_t>;
 
+/**
+ * A reused `SerializationBuffer<N>` that adapts its capacity to the messages
+ * it's used for. This is meant to be stored in a `thread_local` variable.
+ *
+ * The buffer keeps a high-water mark of the message sizes it has been used
+ * for, which decays a little with every message. After a one-off large
+ * transfer like loading a preset, the buffer gets reallocated at the size of
+ * the messages that follow so the memory doesn't stay pinned for the lifetime
+ * of the thread. Buffers are never shrunk below `min_shrink_capacity` and only
+ * when they're several times larger than the high-water mark, so the
+ * steady-state messages sent during audio processing don't cause
+ * reallocations. New buffers start out with the capacity learned by the other
+ * buffers used for the same messages.
+ *
+ * @tparam N The buffer's inline capacity.
+ */
+template <size_t N>
+class AdaptiveSerializationBuffer {
+   public:
+    /**
+     * @param learned_capacity The capacity learned by the other buffers used
+     *   for the same messages. This should be a static variable at the call
+     *   site, so each message type gets its own statistics.
+     */
+    explicit AdaptiveSerializationBuffer(
+        std::atomic_size_t& learned_capacity) noexcept
+        : learned_capacity_(learned_capacity),
+          high_water_mark_(learned_capacity.load(std::memory_order_relaxed)) {
+        buffer_.reserve(high_water_mark_);
+    }
+
+    /**
+     * Get the buffer for the next message. The last message read into or
+     * written from the buffer is accounted for here, and the buffer gets
+     * reallocated when it has grown far beyond what was needed recently.
+     */
+    SerializationBufferBase& get() {
+        high_water_mark_ =
+            std::max(buffer_.size(),
+                     high_water_mark_ - (high_water_mark_ >> decay_shift));
+
+        // This is only a hint for new threads, so we'll avoid writing to the
+        // shared value unless we have learned something new
+        const size_t learned_capacity =
+            std::min(high_water_mark_, min_shrink_capacity);
+        if (learned_capacity >
+            learned_capacity_.load(std::memory_order_relaxed)) {
+            learned_capacity_.store(learned_capacity,
+                                    std::memory_order_relaxed);
+        }
+
+        if (buffer_.capacity() > std::max(N, min_shrink_capacity) &&
+            buffer_.capacity() > high_water_mark_ * shrink_factor) {
+            // NOTE: There's no `.shrink_to_fit()` implementation here, so
+            //       we'll reinitialize the vector since we don't need the old
+            //       data
+            buffer_ = SerializationBuffer<N>{};
+            buffer_.reserve(high_water_mark_);
+        }
+
+        return buffer_;
+    }
+
+   private:
+    /**
+     * The high-water mark loses 1/16th of its value for every message.
+     */
+    static constexpr unsigned int decay_shift = 4;
+    /**
+     * How many times larger than the high-water mark the buffer has to be
+     * before it gets reallocated.
+     */
+    static constexpr size_t shrink_factor = 4;
+    /**
+     * Buffers smaller than this are never reallocated to a smaller size. This
+     * is also the maximum capacity new buffers start out with.
+     */
+    static constexpr size_t min_shrink_capacity = 1 << 16;
+
+    SerializationBuffer<N> buffer_;
+    std::atomic_size_t& learned_capacity_;
+    size_t high_water_mark_;
+};
+
 namespace asio {
 
 // These are copied verbatim `asio::buffer(std::vector<PodType, Allocator>&,
@@ -115,9 +211,142 @@ inline ASIO_MUTABLE_BUFFER buffer(llvm::SmallVectorImpl<PodType>& data,
 
 }  // namespace asio
 
+/**
+ * The traffic counters the messages written and read on this thread should be
+ * counted in, if any. `write_object()` and `read_object()` only see sockets,
+ * so the socket handlers set this using a `SocketTrafficScope` while they send
+ * or receive a message on one of their sockets.
+ */
+inline thread_local SocketTrafficCounters* current_socket_traffic = nullptr;
+
+/**
+ * Count all messages written and read on this thread in `counters` during this
+ * object's lifetime. These scopes can be nested, for instance when a host
+ * callback is made while handling a request, in which case the previous
+ * counters are restored afterwards.
+ */
+class SocketTrafficScope {
+   public:
+    explicit SocketTrafficScope(SocketTrafficCounters& counters) noexcept
+        : previous_(current_socket_traffic) {
+        current_socket_traffic = &counters;
+    }
+
+    ~SocketTrafficScope() noexcept { current_socket_traffic = previous_; }
+
+    SocketTrafficScope(const SocketTrafficScope&) = delete;
+    SocketTrafficScope& operator=(const SocketTrafficScope&) = delete;
+
+   private:
+    SocketTrafficCounters* previous_;
+};
+
+/**
+ * Whether a socket endpoint lives in Linux' abstract socket namespace instead
+ * of on the filesystem. These endpoints' paths start with a null byte.
+ *
+ * @see Sockets::endpoint
+ */
+inline bool is_abstract_endpoint(
+    const asio::local::stream_protocol::endpoint& endpoint) {
+    const std::string path = endpoint.path();
+    return !path.empty() && path[0] == '\0';
+}
+
+/**
+ * The path of a socket endpoint, without the leading null byte used for
+ * abstract socket endpoints.
+ */
+inline ghc::filesystem::path endpoint_file_path(
+    const asio::local::stream_protocol::endpoint& endpoint) {
+    const std::string path = endpoint.path();
+    return is_abstract_endpoint(endpoint) ? path.substr(1) : path;
+}
+
+/**
+ * Whether the process on the other end of a connected socket runs as the same
+ * user as this process. Unlike socket files in the user's private runtime
+ * directory, abstract socket endpoints don't have any permissions, so any
+ * process in the same network namespace can connect to them. Every connection
+ * accepted on an abstract endpoint thus needs to pass this check.
+ */
+inline bool is_same_user_peer(asio::local::stream_protocol::socket& socket) {
+    ucred credentials{};
+    socklen_t credentials_size = sizeof(credentials);
+
+    return getsockopt(socket.native_handle(), SOL_SOCKET, SO_PEERCRED,
+                      &credentials, &credentials_size) == 0 &&
+           credentials.uid == getuid();
+}
+
+/**
+ * Synchronously accept a connection on `acceptor` into `socket`. For abstract
+ * endpoints, connections from processes belonging to other users are closed
+ * again and we'll keep waiting for the next connection.
+ *
+ * @see is_same_user_peer
+ */
+inline void accept_from_same_user(
+    asio::local::stream_protocol::acceptor& acceptor,
+    asio::local::stream_protocol::socket& socket,
+    const asio::local::stream_protocol::endpoint& endpoint) {
+    acceptor.accept(socket);
+    while (is_abstract_endpoint(endpoint) && !is_same_user_peer(socket)) {
+        socket.close();
+        acceptor.accept(socket);
+    }
+}
+
+/**
+ * Get the traffic counters for a socket endpoint. The channel's name is the
+ * endpoint's file name without the extension, and without the instance ID
+ * suffix used for the VST3 audio processor sockets. That way all
+ * `host_vst_audio_processor_<n>` sockets share a single channel.
+ */
+inline SocketTraffic& socket_traffic_for_endpoint(
+    const asio::local::stream_protocol::endpoint& endpoint) {
+    std::string channel = endpoint_file_path(endpoint).stem().string();
+    if (const size_t separator = channel.find_last_not_of("0123456789");
+        separator != std::string::npos && separator + 1 < channel.size() &&
+        channel[separator] == '_') {
+        channel.resize(separator);
+    }
+
+    return LatencyHistograms::get().socket_traffic(channel);
+}
+
+/**
+ * The part of `write_object()` that writes an already serialized object to the
+ * socket. Also used in `write_and_read_object()`.
+ */
+template <typename Socket>
+inline void write_serialized_object(Socket& socket,
+                                    const SerializationBufferBase& buffer,
+                                    size_t size) {
+    // Tell the other side how large the object is so it can prepare a buffer
+    // large enough before sending the data
+    // NOTE: We're writing these sizes as a 64 bit integers, **not** as pointer
+    //       sized integers. This is to provide compatibility with the 32-bit
+    //       bit bridge. This won't make any function difference aside from the
+    //       32-bit host application having to convert between 64 and 32 bit
+    //       integers.
+    // Asio will write both buffers using a single `sendmsg()` call
+    const uint64_t message_length = size;
+    YABRIDGE_PROBE(message_write, message_length);
+    if (current_socket_traffic) {
+        current_socket_traffic->record_sent(sizeof(message_length) + size);
+    }
+    const std::array<asio::const_buffer, 2> buffers{
+        asio::buffer(&message_length, sizeof(message_length)),
+        asio::buffer(buffer.data(), size)};
+    [[maybe_unused]] const size_t bytes_written = asio::write(socket, buffers);
+    assert(bytes_written == sizeof(message_length) + size);
+}
+
 /**
  * Serialize an object using bitsery and write it to a socket. This will write
- * both the size of the serialized object and the object itself over the socket.
+ * both the size of the serialized object and the object itself over the socket
+ * using a single scatter/gather write.
  *
  * @param socket The Asio socket to write to.
  * @param object The object to write to the stream.
@@ -138,17 +367,7 @@ inline void write_object(Socket& socket,
         bitsery::quickSerialization<OutputAdapter<SerializationBufferBase>>(
             buffer, object);
 
-    // Tell the other side how large the object is so it can prepare a buffer
-    // large enough before sending the data
-    // NOTE: We're writing these sizes as a 64 bit integers, **not** as pointer
-    //       sized integers. This is to provide compatibility with the 32-bit
-    //       bit bridge. This won't make any function difference aside from the
-    //       32-bit host application having to convert between 64 and 32 bit
-    //       integers.
-    asio::write(socket, asio::buffer(std::array<uint64_t, 1>{size}));
-    const size_t bytes_written =
-        asio::write(socket, asio::buffer(buffer, size));
-    assert(bytes_written == size);
+    write_serialized_object(socket, buffer, size);
 }
 
 /**
@@ -162,6 +381,57 @@ inline void write_object(Socket& socket, const T& object) {
     write_object(socket, object, buffer);
 }
 
+/**
+ * The part of `read_object()` that reads the rest of a message after the size
+ * prefix and the first part of the message have been read into `buffer`, and
+ * then deserializes the message. Also used in `write_and_read_object()`.
+ *
+ * @param message_length The message's size, as read from the size prefix.
+ * @param payload_bytes_read How many bytes of the message have already been
+ *   read into `buffer`.
+ */
+template <typename T, typename Socket>
+inline T& finish_read_object(Socket& socket,
+                             T& object,
+                             SerializationBufferBase& buffer,
+                             uint64_t message_length,
+                             size_t payload_bytes_read) {
+    const size_t size = message_length;
+    if (payload_bytes_read > size) [[unlikely]] {
+        throw std::runtime_error("Read past the end of a message in call: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    // Make sure the buffer is large enough. This keeps the part of the message
+    // we've already read.
+    buffer.resize_for_overwrite(size);
+
+    // `asio::read/write` will handle all the packet splitting and
+    // merging for us, since local domain sockets have packet limits somewhere
+    // in the hundreds of kilobytes
+    if (payload_bytes_read < size) {
+        asio::read(socket,
+                   asio::buffer(buffer.data() + payload_bytes_read,
+                                size - payload_bytes_read),
+                   asio::transfer_exactly(size - payload_bytes_read));
+    }
+
+    YABRIDGE_PROBE(message_read, message_length);
+    if (current_socket_traffic) {
+        current_socket_traffic->record_received(sizeof(message_length) + size);
+    }
+    auto [_, success] =
+        bitsery::quickDeserialization<InputAdapter<SerializationBufferBase>>(
+            {buffer.begin(), size}, object);
+
+    if (!success) [[unlikely]] {
+        throw std::runtime_error("Deserialization failure in call: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    return object;
+}
+
 /**
  * Deserialize an object by reading it from a socket. This should be used
  * together with `write_object`. This will block until the object is available.
@@ -185,29 +455,23 @@ inline T& read_object(Socket& socket,
                       T& object,
                       SerializationBufferBase& buffer) {
     // See the note above on the use of `uint64_t` instead of `size_t`
-    std::array<uint64_t, 1> message_length;
-    asio::read(socket, asio::buffer(message_length),
-               asio::transfer_exactly(sizeof(message_length)));
-
-    // Make sure the buffer is large enough
-    const size_t size = message_length[0];
-    buffer.resize(size);
-
-    // `asio::read/write` will handle all the packet splitting and
-    // merging for us, since local domain sockets have packet limits somewhere
-    // in the hundreds of kilobytes
-    asio::read(socket, asio::buffer(buffer), asio::transfer_exactly(size));
-
-    auto [_, success] =
-        bitsery::quickDeserialization<InputAdapter<SerializationBufferBase>>(
-            {buffer.begin(), size}, object);
-
-    if (!success) [[unlikely]] {
-        throw std::runtime_error("Deserialization failure in call: " +
-                                 std::string(__PRETTY_FUNCTION__));
-    }
-
-    return object;
+    uint64_t message_length = 0;
+
+    // Most messages are small, so we'll speculatively read both the size
+    // prefix and as much of the message as fits in the buffer's current
+    // capacity using a single `recvmsg()` call. This relies on there never
+    // being more than one unread message on a socket at a time, which is the
+    // case because every message is followed by a response or an
+    // acknowledgement before the next message gets sent over the same socket.
+    buffer.resize_for_overwrite(buffer.capacity());
+    const std::array<asio::mutable_buffer, 2> buffers{
+        asio::buffer(&message_length, sizeof(message_length)),
+        asio::buffer(buffer.data(), buffer.size())};
+    const size_t bytes_read = asio::read(
+        socket, buffers, asio::transfer_at_least(sizeof(message_length)));
+
+    return finish_read_object(socket, object, buffer, message_length,
+                              bytes_read - sizeof(message_length));
 }
 
 /**
@@ -251,6 +515,144 @@ inline T read_object(Socket& socket) {
     return object;
 }
 
+/**
+ * Send a request using `write_object()` and then read the response into
+ * `response_object` using `read_object()`. When yabridge is built with the
+ * `io-uring` option and io_uring is available, small requests will be sent and
+ * the response will start being received with a single system call. See
+ * `io_uring_send_receive()` for more information.
+ *
+ * @param socket The Asio socket to send the request over.
+ * @param object The request to send.
+ * @param response_object The object to deserialize the response into.
+ * @param buffer The buffer to use for both serializing the request and
+ *   receiving the response.
+ *
+ * @return The deserialized response.
+ *
+ * @throw std::runtime_error If the conversion to an object was not successful.
+ * @throw std::system_error If the socket is closed or gets closed
+ *   while sending or receiving.
+ *
+ * @relates write_object
+ * @relates read_object
+ */
+template <typename T, typename TResponse, typename Socket>
+inline TResponse& write_and_read_object(Socket& socket,
+                                        const T& object,
+                                        TResponse& response_object,
+                                        SerializationBufferBase& buffer) {
+#ifdef WITH_IO_URING
+    const size_t size =
+        bitsery::quickSerialization<OutputAdapter<SerializationBufferBase>>(
+            buffer, object);
+
+    if (size <= max_io_uring_request_size) {
+        // The response is received into the same buffer the request is sent
+        // from. This is safe because the receive only starts after the send
+        // has completed.
+        uint64_t message_length = size;
+        uint64_t response_length = 0;
+        buffer.resize_for_overwrite(std::max(buffer.capacity(), size));
+        const std::array<iovec, 2> send_buffers{
+            iovec{.iov_base = &message_length,
+                  .iov_len = sizeof(message_length)},
+            iovec{.iov_base = buffer.data(), .iov_len = size}};
+        const std::array<iovec, 2> receive_buffers{
+            iovec{.iov_base = &response_length,
+                  .iov_len = sizeof(response_length)},
+            iovec{.iov_base = buffer.data(), .iov_len = buffer.size()}};
+
+        if (const std::optional<size_t> bytes_read = io_uring_send_receive(
+                socket.native_handle(), send_buffers, receive_buffers,
+                sizeof(response_length))) {
+            if (current_socket_traffic) {
+                current_socket_traffic->record_sent(sizeof(message_length) +
+                                                    size);
+            }
+
+            return finish_read_object(socket, response_object, buffer,
+                                      response_length,
+                                      *bytes_read - sizeof(response_length));
+        }
+    }
+
+    // The request has already been serialized, and serializing some objects
+    // has side effects, so we must not call `write_object()` here
+    write_serialized_object(socket, buffer, size);
+#else
+    write_object(socket, object, buffer);
+#endif
+
+    return read_object<TResponse>(socket, response_object, buffer);
+}
+
+/**
+ * Serialize an object using bitsery and write it to one of the metadata regions
+ * of an `AudioShmBuffer`. This is used during audio processing to pass the
+ * per-block metadata to the other side without having to write it to a socket.
+ * The other side should be notified through the usual socket message or futex
+ * after this function returns.
+ *
+ * @param shm The shared memory object to write to.
+ * @param region The metadata region to write the serialized object to.
+ * @param object The object to serialize.
+ *
+ * @return Whether the serialized object fit in the metadata region. If this
+ *   returns false, then the object should be sent over the socket instead.
+ *
+ * @relates read_shm_object
+ */
+template <typename T>
+inline bool write_shm_object(AudioShmBuffer& shm,
+                             AudioShmBuffer::MetadataRegion region,
+                             const T& object) {
+    // This buffer will grow to the largest object we've serialized on this
+    // thread, so we won't be allocating during audio processing
+    thread_local SerializationBuffer<256> buffer{};
+
+    const size_t size =
+        bitsery::quickSerialization<OutputAdapter<SerializationBufferBase>>(
+            buffer, object);
+    if (size > shm.metadata_capacity()) {
+        return false;
+    }
+
+    std::copy_n(buffer.begin(), size, shm.metadata_ptr(region));
+    shm.set_metadata_size(region, static_cast<uint32_t>(size));
+
+    return true;
+}
+
+/**
+ * Deserialize an object that was written to one of the metadata regions of an
+ * `AudioShmBuffer` using `write_shm_object()`. This deserializes directly from
+ * the shared memory.
+ *
+ * @param shm The shared memory object to read from.
+ * @param region The metadata region to read the serialized object from.
+ * @param object The object to deserialize into.
+ *
+ * @throw std::runtime_error If the conversion to an object was not successful.
+ *
+ * @relates write_shm_object
+ */
+template <typename T>
+inline T& read_shm_object(const AudioShmBuffer& shm,
+                          AudioShmBuffer::MetadataRegion region,
+                          T& object) {
+    auto [_, success] =
+        bitsery::quickDeserialization<InputAdapter<SerializationBufferBase>>(
+            {shm.metadata_ptr(region), shm.metadata_size(region)}, object);
+
+    if (!success) [[unlikely]] {
+        throw std::runtime_error("Deserialization failure in call: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    return object;
+}
+
 /**
  * Generate a unique base directory that can be used as a prefix for all Unix
  * domain socket endpoints used in `Vst2PluginBridge`/`Vst2Bridge`. This will
@@ -269,6 +671,16 @@ ghc::filesystem::path generate_endpoint_base(const std::string& plugin_name);
  * Wine host. Every plugin will get its own directory (the socket endpoint base
  * directory), and all socket endpoints are created within this directory. This
  * is usually `/run/user/<uid>/yabridge-<plugin_name>-<random_id>/`.
+ *
+ * When yabridge spawns the Wine plugin host itself, the sockets are bound in
+ * Linux' abstract socket namespace instead, using the same paths as their
+ * names. Those sockets don't need to be created on or removed from the
+ * filesystem, and they can't be left behind when a process crashes. They also
+ * don't have any permissions, so the socket handlers reject connections from
+ * other users using `is_same_user_peer()`. The base directory still gets
+ * created so running plugins can be found by `yabridgectl top`. Group hosts
+ * may serve plugins from other sandboxes with their own network namespaces, so
+ * those keep using the filesystem.
  */
 class Sockets {
    public:
@@ -278,11 +690,16 @@ class Sockets {
      *
      * @param endpoint_base_dir The base directory that will be used for the
      *   Unix domain sockets.
+     * @param abstract_namespace Whether to bind the sockets in the abstract
+     *   socket namespace. This should only be enabled for individually hosted
+     *   plugins, and both sides need to use the same value.
      *
      * @see Sockets::connect
      */
-    Sockets(const ghc::filesystem::path& endpoint_base_dir)
-        : base_dir_(endpoint_base_dir) {}
+    Sockets(const ghc::filesystem::path& endpoint_base_dir,
+            bool abstract_namespace)
+        : base_dir_(endpoint_base_dir),
+          abstract_namespace_(abstract_namespace) {}
 
     /**
      * Shuts down and closes all sockets and then cleans up the directory
@@ -346,6 +763,25 @@ class Sockets {
      * below are files within this directory.
      */
     const ghc::filesystem::path base_dir_;
+
+   protected:
+    /**
+     * Get the endpoint for the socket called `name` in `base_dir_`, either on
+     * the filesystem or in the abstract socket namespace depending on
+     * `abstract_namespace_`.
+     */
+    asio::local::stream_protocol::endpoint endpoint(
+        const std::string& name) const {
+        const std::string path = (base_dir_ / name).string();
+        if (abstract_namespace_) {
+            return asio::local::stream_protocol::endpoint('\0' + path);
+        } else {
+            return asio::local::stream_protocol::endpoint(path);
+        }
+    }
+
+   private:
+    const bool abstract_namespace_;
 };
 
 /**
@@ -368,10 +804,12 @@ class SocketHandler {
     SocketHandler(asio::io_context& io_context,
                   asio::local::stream_protocol::endpoint endpoint,
                   bool listen)
-        : endpoint_(endpoint), socket_(io_context) {
+        : endpoint_(endpoint),
+          socket_(io_context),
+          traffic_(socket_traffic_for_endpoint(endpoint)) {
         if (listen) {
             ghc::filesystem::create_directories(
-                ghc::filesystem::path(endpoint.path()).parent_path());
+                endpoint_file_path(endpoint).parent_path());
             acceptor_.emplace(io_context, endpoint);
         }
     }
@@ -383,7 +821,16 @@ class SocketHandler {
      */
     void connect() {
         if (acceptor_) {
-            acceptor_->accept(socket_);
+            accept_from_same_user(*acceptor_, socket_, endpoint_);
+
+            // There will only ever be a single connection to this socket, so
+            // there's no need to keep listening. With many plugin instances
+            // these idle listening sockets would otherwise add up to hundreds
+            // of file descriptors and socket files.
+            acceptor_.reset();
+            if (!is_abstract_endpoint(endpoint_)) {
+                ghc::filesystem::remove(endpoint_.path());
+            }
         } else {
             socket_.connect(endpoint_);
         }
@@ -401,6 +848,25 @@ class SocketHandler {
         socket_.close();
     }
 
+    /**
+     * Block until there's data to read from the socket, or until the socket
+     * gets closed. Unlike the other functions this does not throw, so it can be
+     * used to check whether the other side is still there before reading from
+     * the socket in a `ScopedRealtimeSection`.
+     *
+     * @return Whether there's data to read. This is false when the socket has
+     *   been closed.
+     */
+    bool wait_for_data() noexcept {
+        std::error_code err;
+        socket_.wait(asio::local::stream_protocol::socket::wait_read, err);
+        if (err) {
+            return false;
+        }
+
+        return socket_.available(err) > 0 && !err;
+    }
+
     /**
      * Serialize an object and send it over the socket.
      *
@@ -422,6 +888,7 @@ class SocketHandler {
      */
     template <typename T>
     inline void send(const T& object, SerializationBufferBase& buffer) {
+        const SocketTrafficScope traffic_scope(traffic_.primary);
         write_object(socket_, object, buffer);
     }
 
@@ -432,6 +899,7 @@ class SocketHandler {
      */
     template <typename T>
     inline void send(const T& object) {
+        const SocketTrafficScope traffic_scope(traffic_.primary);
         write_object(socket_, object);
     }
 
@@ -466,6 +934,7 @@ class SocketHandler {
      */
     template <typename T>
     inline T& receive_single(T& object, SerializationBufferBase& buffer) {
+        const SocketTrafficScope traffic_scope(traffic_.primary);
         return read_object<T>(socket_, object, buffer);
     }
 
@@ -477,6 +946,7 @@ class SocketHandler {
      */
     template <typename T>
     inline T receive_single() {
+        const SocketTrafficScope traffic_scope(traffic_.primary);
         return read_object<T>(socket_);
     }
 
@@ -521,11 +991,61 @@ class SocketHandler {
 
     /**
      * Will be used in `connect()` on the listening side to establish the
-     * connection.
+     * connection. This is reset after the connection has been accepted.
      */
     std::optional<asio::local::stream_protocol::acceptor> acceptor_;
+
+    /**
+     * The traffic counters for this socket's channel.
+     */
+    SocketTraffic& traffic_;
+};
+
+/**
+ * Thread implementations that provide a `Thread::Pool` thread pool type. When
+ * available, `AdHocSocketHandler` will run the handlers for secondary
+ * connections on that pool instead of spawning a new thread for every
+ * connection. This is the case for `Win32Thread`.
+ */
+template <typename Thread>
+concept HasThreadPool = requires(typename Thread::Pool& pool) {
+    pool.submit([]() {});
+};
+
+/**
+ * `Thread::Pool` if `Thread` has a thread pool, or an empty placeholder type
+ * otherwise.
+ */
+template <typename Thread>
+struct ThreadPoolType {
+    using type = std::monostate;
+};
+
+template <HasThreadPool Thread>
+struct ThreadPoolType<Thread> {
+    using type = typename Thread::Pool;
 };
 
+/**
+ * Process-wide counts of the secondary socket connections used by all
+ * `AdHocSocketHandler`s, shown on the group host's metrics endpoint. When these
+ * keep growing, a host or a plugin is making a lot of concurrent calls.
+ */
+struct SecondarySocketCounters {
+    /**
+     * The number of secondary connections this process has opened to send
+     * requests, not counting reused idle connections.
+     */
+    std::atomic_uint64_t opened;
+    /**
+     * The number of secondary connections this process is currently handling
+     * requests on.
+     */
+    std::atomic_uint64_t handling;
+};
+
+inline SecondarySocketCounters secondary_socket_counters{};
+
 /**
  * There are situations where we can not know in advance how many sockets we
  * need. The main example of this are VST2 `dispatcher()` and `audioMaster()`
@@ -545,12 +1065,26 @@ class SocketHandler {
  *   socket instead. On the listening side the new connection will be accepted,
  *   and a newly spawned thread will handle incoming connection just like it
  *   would for the primary socket.
+ * - Since some hosts and plugins will do this many times per second, the
+ *   sending side keeps up to `max_idle_secondary_sockets` of these additional
+ *   connections open after they've been used so they can be reused for later
+ *   requests. The thread handling such a connection on the listening side will
+ *   keep handling requests until the connection gets closed. Connections that
+ *   don't fit in the pool are closed again after a single request, so their
+ *   threads exit just like before.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
  *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class AdHocSocketHandler {
+   public:
+    /**
+     * The maximum number of idle secondary socket connections we'll keep
+     * around on the sending side.
+     */
+    static constexpr size_t max_idle_secondary_sockets = 8;
+
    protected:
     /**
      * Sets up a single primary socket. The sockets won't be active until
@@ -569,14 +1103,44 @@ class AdHocSocketHandler {
     AdHocSocketHandler(asio::io_context& io_context,
                        asio::local::stream_protocol::endpoint endpoint,
                        bool listen)
-        : io_context_(io_context), endpoint_(endpoint), socket_(io_context) {
+        : io_context_(io_context),
+          endpoint_(endpoint),
+          socket_(io_context),
+          traffic_(socket_traffic_for_endpoint(endpoint)),
+          trace_flow_base_(
+              (std::hash<std::string>{}(endpoint.path()) & 0xffffffff) << 32) {
         if (listen) {
             ghc::filesystem::create_directories(
-                ghc::filesystem::path(endpoint.path()).parent_path());
+                endpoint_file_path(endpoint).parent_path());
             acceptor_.emplace(io_context, endpoint);
         }
     }
 
+    /**
+     * Whether `socket` is this handler's primary socket, as opposed to a
+     * secondary socket passed to the callbacks in `send()` and
+     * `receive_multi()`.
+     */
+    bool is_primary_socket(
+        const asio::local::stream_protocol::socket& socket) const noexcept {
+        return &socket == &socket_;
+    }
+
+    /**
+     * Get the flow ID for traces for the next request sent or received over
+     * the primary socket. Both sides count the requests on the primary socket
+     * in the same order, so the n-th request sent from one side gets the same
+     * ID as the n-th request received on the other side without us having to
+     * send these IDs over the socket. Requests sent over secondary sockets
+     * don't get a flow ID, since those connections are pooled independently
+     * on both sides. This should only be called for the primary socket.
+     *
+     * @see Tracer
+     */
+    uint64_t next_trace_flow_id() noexcept {
+        return trace_flow_base_ | trace_flow_sequence_.fetch_add(1);
+    }
+
    public:
     /**
      * Depending on the value of the `listen` argument passed to the
@@ -585,14 +1149,16 @@ class AdHocSocketHandler {
      */
     void connect() {
         if (acceptor_) {
-            acceptor_->accept(socket_);
+            accept_from_same_user(*acceptor_, socket_, endpoint_);
 
             // As mentioned in `acceptor's` docstring, this acceptor will be
             // recreated in `receive_multi()` on another context, and
             // potentially on the other side of the connection in the case
             // where we're handling `vst_host_callback_` VST2 events
             acceptor_.reset();
-            ghc::filesystem::remove(endpoint_.path());
+            if (!is_abstract_endpoint(endpoint_)) {
+                ghc::filesystem::remove(endpoint_.path());
+            }
         } else {
             socket_.connect(endpoint_);
         }
@@ -609,6 +1175,17 @@ class AdHocSocketHandler {
                          err);
         socket_.close();
 
+        // This also makes the other side's threads for these connections exit
+        {
+            std::lock_guard lock(idle_secondary_sockets_mutex_);
+            for (auto& secondary_socket : idle_secondary_sockets_) {
+                secondary_socket.shutdown(
+                    asio::local::stream_protocol::socket::shutdown_both, err);
+                secondary_socket.close(err);
+            }
+            idle_secondary_sockets_.clear();
+        }
+
         while (currently_listening_) {
             // If another thread is currently calling `receive_multi()`, we'll
             // spinlock until that function has exited. We would otherwise get a
@@ -624,8 +1201,8 @@ class AdHocSocketHandler {
      * for details on the parameters and return value of this function.
      *
      * As described above, if this function is currently being called from
-     * another thread, then this will create a new socket connection and send
-     * the event there instead.
+     * another thread, then this will send the event over an idle secondary
+     * socket connection instead, or over a new connection if there are none.
      *
      * @param callback A function that will be called with a reference to a
      *   socket. This is either the primary `socket`, or a new ad hock socket if
@@ -641,12 +1218,10 @@ class AdHocSocketHandler {
         constexpr bool returns_void = std::is_void_v<
             std::invoke_result_t<F, asio::local::stream_protocol::socket&>>;
 
-        // XXX: Maybe at some point we should benchmark how often this
-        //      ad hoc socket spawning mechanism gets used. If some hosts
-        //      for instance consistently and repeatedly trigger this then
-        //      we might be able to do some optimizations there.
         std::unique_lock lock(write_mutex_, std::try_to_lock);
         if (lock.owns_lock()) {
+            const SocketTrafficScope traffic_scope(traffic_.primary);
+
             // This was used to always block when sending the first message,
             // because the other side may not be listening for additional
             // connections yet
@@ -661,11 +1236,28 @@ class AdHocSocketHandler {
             }
         } else {
             try {
-                asio::local::stream_protocol::socket secondary_socket(
-                    io_context_);
-                secondary_socket.connect(endpoint_);
+                std::optional<asio::local::stream_protocol::socket>
+                    secondary_socket = take_idle_secondary_socket();
+                if (!secondary_socket) {
+                    secondary_socket.emplace(io_context_);
+                    secondary_socket->connect(endpoint_);
+                    secondary_socket_counters.opened.fetch_add(
+                        1, std::memory_order_relaxed);
+                    YABRIDGE_PROBE(secondary_socket_opened);
+                }
+
+                // The socket only goes back into the pool if the request
+                // succeeded, so we never reuse a connection in a weird state
+                const SocketTrafficScope traffic_scope(traffic_.secondary);
+                if constexpr (returns_void) {
+                    callback(*secondary_socket);
+                    return_idle_secondary_socket(std::move(*secondary_socket));
+                } else {
+                    auto result = callback(*secondary_socket);
+                    return_idle_secondary_socket(std::move(*secondary_socket));
 
-                return callback(secondary_socket);
+                    return result;
+                }
             } catch (const std::system_error&) {
                 // So, what do we do when noone is listening on the endpoint
                 // yet? This can happen with plugin groups when the Wine
@@ -681,6 +1273,7 @@ class AdHocSocketHandler {
                 // sockets, and we should thus just exit.
                 if (!sent_first_event_) {
                     std::lock_guard lock(write_mutex_);
+                    const SocketTrafficScope traffic_scope(traffic_.primary);
 
                     if constexpr (returns_void) {
                         callback(socket_);
@@ -739,42 +1332,131 @@ class AdHocSocketHandler {
         acceptor_.emplace(secondary_context, endpoint_);
 
         // This works the exact same was as `active_plugins` and
-        // `next_plugin_id` in `GroupBridge`
-        std::unordered_map<size_t, Thread> active_secondary_requests{};
+        // `next_plugin_id` in `GroupBridge`. The sending side may keep these
+        // connections open to reuse them for later requests, so every thread
+        // keeps handling requests until its connection gets closed. The sockets
+        // are stored alongside the threads so we can shut them down when the
+        // primary socket closes. Elements in an `std::unordered_map` have
+        // stable addresses, so the threads can safely refer to them. If
+        // `Thread` has a thread pool, then the requests will be handled on that
+        // pool and `thread` stays empty. In that case an idle connection does
+        // not hold on to a worker. Instead we wait for the connection to become
+        // readable on `secondary_context`, handle a single request on the pool,
+        // and then go back to waiting. The pool is declared after the
+        // connections so its workers are joined before the sockets are
+        // destroyed.
+        struct SecondaryConnection {
+            std::optional<asio::local::stream_protocol::socket> socket;
+            Thread thread;
+        };
+
+        std::unordered_map<size_t, SecondaryConnection>
+            active_secondary_requests{};
         std::atomic_size_t next_request_id{};
         std::mutex active_secondary_requests_mutex{};
+
+        // Only used with a thread pool. This waits on `secondary_context` until
+        // the other side sends a request over `socket`, handles that single
+        // request on the pool, and then calls itself again to wait for the next
+        // request. Connections are removed again once they get closed.
+        std::function<void(asio::local::stream_protocol::socket&, size_t)>
+            wait_for_pooled_request;
+        std::optional<typename ThreadPoolType<Thread>::type>
+            secondary_requests_pool{};
+        if constexpr (HasThreadPool<Thread>) {
+            secondary_requests_pool.emplace();
+            wait_for_pooled_request =
+                [&](asio::local::stream_protocol::socket& socket,
+                    size_t request_id) {
+                    const auto close_connection = [&, request_id]() {
+                        asio::post(secondary_context, [&, request_id]() {
+                            std::lock_guard lock(
+                                active_secondary_requests_mutex);
+                            active_secondary_requests.erase(request_id);
+                        });
+                    };
+
+                    socket.async_wait(
+                        asio::local::stream_protocol::socket::wait_read,
+                        [&, &socket = socket, close_connection,
+                         request_id](const std::error_code& error) {
+                            if (error) {
+                                close_connection();
+                                return;
+                            }
+
+                            secondary_requests_pool->submit(
+                                [&, &socket = socket, close_connection,
+                                 request_id]() {
+                                    if (!handle_pooled_request(
+                                            socket, secondary_callback)) {
+                                        close_connection();
+                                        return;
+                                    }
+
+                                    asio::post(secondary_context,
+                                               [&, &socket = socket,
+                                                request_id]() {
+                                                   wait_for_pooled_request(
+                                                       socket, request_id);
+                                               });
+                                });
+                        });
+                };
+        }
         accept_requests(
             *acceptor_, logger,
             [&](asio::local::stream_protocol::socket secondary_socket) {
                 const size_t request_id = next_request_id.fetch_add(1);
 
-                // We have to make sure to keep moving these sockets into the
-                // threads that will handle them
                 std::lock_guard lock(active_secondary_requests_mutex);
-                active_secondary_requests[request_id] = Thread(
-                    [&, request_id](
-                        asio::local::stream_protocol::socket secondary_socket) {
-                        secondary_callback(secondary_socket);
-
-                        // When we have processed this request, we'll join the
-                        // thread again with the thread that's handling
-                        // `secondary_context`
-                        asio::post(secondary_context, [&, request_id]() {
-                            std::lock_guard lock(
-                                active_secondary_requests_mutex);
+                SecondaryConnection& connection =
+                    active_secondary_requests[request_id];
+                connection.socket.emplace(std::move(secondary_socket));
 
-                            // The join is implicit because we're using
-                            // `std::jthread`/`Win32Thread`
-                            active_secondary_requests.erase(request_id);
-                        });
-                    },
-                    std::move(secondary_socket));
+                if constexpr (HasThreadPool<Thread>) {
+                    wait_for_pooled_request(*connection.socket, request_id);
+                    return;
+                }
+
+                auto handle_connection = [&, &connection = connection,
+                                          request_id]() {
+                    secondary_socket_counters.handling.fetch_add(
+                        1, std::memory_order_relaxed);
+                    const SocketTrafficScope traffic_scope(traffic_.secondary);
+                    while (true) {
+                        try {
+                            secondary_callback(*connection.socket);
+                        } catch (const std::system_error&) {
+                            // This happens when the other side closes the
+                            // connection, or when we shut it down below
+                            break;
+                        }
+                    }
+                    secondary_socket_counters.handling.fetch_sub(
+                        1, std::memory_order_relaxed);
+
+                    // When the connection has been closed, we'll join the
+                    // thread again with the thread that's handling
+                    // `secondary_context`
+                    asio::post(secondary_context, [&, request_id]() {
+                        std::lock_guard lock(active_secondary_requests_mutex);
+
+                        // The join is implicit because we're using
+                        // `std::jthread`/`Win32Thread`
+                        active_secondary_requests.erase(request_id);
+                    });
+                };
+
+                connection.thread = Thread(std::move(handle_connection));
             });
 
         Thread secondary_requests_handler([&]() {
             pthread_setname_np(pthread_self(), "adhoc-acceptor");
 
-            // Any secondary threads should not be realtime
+            // Any secondary threads should not be realtime. Thread pools copy
+            // the scheduling priority from the thread submitting the task, so
+            // this also applies to those.
             set_realtime_priority(false);
 
             secondary_context.run();
@@ -782,6 +1464,7 @@ class AdHocSocketHandler {
 
         // Now we'll handle reads on the primary socket in a loop until the
         // socket shuts down
+        const SocketTrafficScope traffic_scope(traffic_.primary);
         while (true) {
             try {
                 primary_callback(socket_);
@@ -794,10 +1477,17 @@ class AdHocSocketHandler {
 
         // After the primary socket gets terminated (during shutdown) we'll make
         // sure all outstanding jobs have been processed and then drop all work
-        // from the IO context
+        // from the IO context. Idle secondary connections would otherwise keep
+        // their threads alive, so those get shut down as well. Those threads
+        // are joined when `active_secondary_requests` goes out of scope.
         std::lock_guard lock(active_secondary_requests_mutex);
         secondary_context.stop();
         acceptor_.reset();
+        for (auto& [request_id, connection] : active_secondary_requests) {
+            std::error_code err;
+            connection.socket->shutdown(
+                asio::local::stream_protocol::socket::shutdown_both, err);
+        }
 
         currently_listening_ = false;
     }
@@ -815,6 +1505,64 @@ class AdHocSocketHandler {
     }
 
    private:
+    /**
+     * Handle a single request on a secondary connection when those connections
+     * are handled on a thread pool. See `receive_multi()`.
+     *
+     * @return Whether the connection is still open. If this returns false, then
+     *   the other side has closed the connection or it got shut down at the
+     *   end of `receive_multi()`.
+     */
+    template <typename F>
+    bool handle_pooled_request(asio::local::stream_protocol::socket& socket,
+                               F& secondary_callback) {
+        secondary_socket_counters.handling.fetch_add(1,
+                                                     std::memory_order_relaxed);
+        bool still_open = true;
+        {
+            const SocketTrafficScope traffic_scope(traffic_.secondary);
+            try {
+                secondary_callback(socket);
+            } catch (const std::system_error&) {
+                still_open = false;
+            }
+        }
+        secondary_socket_counters.handling.fetch_sub(1,
+                                                     std::memory_order_relaxed);
+
+        return still_open;
+    }
+
+    /**
+     * Take a previously used secondary socket connection from the pool, if
+     * there are any.
+     */
+    std::optional<asio::local::stream_protocol::socket>
+    take_idle_secondary_socket() {
+        std::lock_guard lock(idle_secondary_sockets_mutex_);
+        if (idle_secondary_sockets_.empty()) {
+            return std::nullopt;
+        }
+
+        std::optional<asio::local::stream_protocol::socket> secondary_socket(
+            std::move(idle_secondary_sockets_.back()));
+        idle_secondary_sockets_.pop_back();
+
+        return secondary_socket;
+    }
+
+    /**
+     * Put a secondary socket connection back into the pool after it has been
+     * used, or close it if the pool is already full.
+     */
+    void return_idle_secondary_socket(
+        asio::local::stream_protocol::socket secondary_socket) {
+        std::lock_guard lock(idle_secondary_sockets_mutex_);
+        if (idle_secondary_sockets_.size() < max_idle_secondary_sockets) {
+            idle_secondary_sockets_.push_back(std::move(secondary_socket));
+        }
+    }
+
     /**
      * Used in `receive_multi()` to asynchronously listen for secondary socket
      * connections. After `callback()` returns this function will continue to be
@@ -847,7 +1595,18 @@ class AdHocSocketHandler {
                     return;
                 }
 
-                callback(std::move(secondary_socket));
+                // Abstract endpoints can be connected to by anyone, so
+                // connections from other users are dropped right away
+                if (is_abstract_endpoint(endpoint_) &&
+                    !is_same_user_peer(secondary_socket)) {
+                    if (logger) {
+                        logger->get().log(
+                            "Rejected a connection from another user on '" +
+                            endpoint_file_path(endpoint_).string() + "'");
+                    }
+                } else {
+                    callback(std::move(secondary_socket));
+                }
 
                 accept_requests(acceptor, logger, callback);
             });
@@ -863,6 +1622,12 @@ class AdHocSocketHandler {
     asio::local::stream_protocol::endpoint endpoint_;
     asio::local::stream_protocol::socket socket_;
 
+    /**
+     * The traffic counters for this socket's channel, split between the
+     * primary socket and secondary connections.
+     */
+    SocketTraffic& traffic_;
+
     /**
      * This acceptor will be used once synchronously on the listening side
      * during `Sockets::connect()`. When `AdHocSocketHandler::receive_multi()`
@@ -891,6 +1656,15 @@ class AdHocSocketHandler {
      */
     std::mutex write_mutex_;
 
+    /**
+     * Secondary socket connections that have been used before and that are
+     * kept open so they can be reused by `send()`.
+     *
+     * @see max_idle_secondary_sockets
+     */
+    std::vector<asio::local::stream_protocol::socket> idle_secondary_sockets_;
+    std::mutex idle_secondary_sockets_mutex_;
+
     /**
      * Indicates whether or not the remove has processed an event we sent from
      * this side. When a Windows VST2 plugin performs a host callback in its
@@ -899,4 +1673,12 @@ class AdHocSocketHandler {
      * this fallback behaviour should only happen during initialization.
      */
     std::atomic_bool sent_first_event_ = false;
+
+    /**
+     * The upper 32 bits of the flow IDs returned by `next_trace_flow_id()`,
+     * based on the endpoint's path so that they're unique per socket but the
+     * same on both sides.
+     */
+    const uint64_t trace_flow_base_;
+    std::atomic_uint32_t trace_flow_sequence_ = 0;
 };
@@ -0,0 +1,234 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifdef WITH_IO_URING
+
+#include "io-uring.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+#include <liburing.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+namespace {
+
+/**
+ * Used as the `user_data` for the two submission queue entries, so we can tell
+ * their completions apart.
+ */
+constexpr uint64_t send_user_data = 0;
+constexpr uint64_t receive_user_data = 1;
+
+/**
+ * A thread local io_uring instance. We only ever have a single send and receive
+ * in flight, so the ring can be tiny.
+ */
+class ThreadRing {
+   public:
+    ThreadRing() noexcept {
+        const int policy = sched_getscheduler(0);
+        if (policy == SCHED_FIFO || policy == SCHED_RR) {
+            return;
+        }
+
+        available_ = io_uring_queue_init(4, &ring_, 0) == 0;
+    }
+
+    ~ThreadRing() noexcept {
+        if (available_) {
+            io_uring_queue_exit(&ring_);
+        }
+    }
+
+    ThreadRing(const ThreadRing&) = delete;
+    ThreadRing& operator=(const ThreadRing&) = delete;
+
+    /**
+     * The ring, or a null pointer if io_uring is not available on this thread.
+     */
+    io_uring* get() noexcept { return available_ ? &ring_ : nullptr; }
+
+    /**
+     * Stop using io_uring on this thread. Used when submitting fails in a way
+     * we can't recover from.
+     */
+    void disable() noexcept {
+        if (available_) {
+            io_uring_queue_exit(&ring_);
+            available_ = false;
+        }
+    }
+
+   private:
+    io_uring ring_{};
+    bool available_ = false;
+};
+
+/**
+ * Drop the first `num_bytes` bytes from a list of buffers.
+ */
+void consume(std::vector<iovec>& buffers, size_t num_bytes) noexcept {
+    auto it = buffers.begin();
+    while (it != buffers.end() && num_bytes >= it->iov_len) {
+        num_bytes -= it->iov_len;
+        it++;
+    }
+
+    buffers.erase(buffers.begin(), it);
+    if (!buffers.empty()) {
+        buffers.front().iov_base =
+            static_cast<uint8_t*>(buffers.front().iov_base) + num_bytes;
+        buffers.front().iov_len -= num_bytes;
+    }
+}
+
+/**
+ * Wait until the socket becomes readable or writable. The socket may be in
+ * non-blocking mode since Asio sets that on its sockets when they are used
+ * for asynchronous operations.
+ */
+void wait_for(int fd, short events) {
+    pollfd poll_fd{.fd = fd, .events = events, .revents = 0};
+    while (poll(&poll_fd, 1, -1) == -1) {
+        if (errno != EINTR) {
+            throw std::system_error(errno, std::system_category());
+        }
+    }
+}
+
+/**
+ * Receive into `buffers` using regular blocking `recvmsg()` calls until at
+ * least `min_receive` bytes have been received.
+ */
+size_t receive_at_least(int fd,
+                        std::vector<iovec> buffers,
+                        size_t min_receive) {
+    size_t bytes_received = 0;
+    while (bytes_received < min_receive) {
+        msghdr message{};
+        message.msg_iov = buffers.data();
+        message.msg_iovlen = buffers.size();
+
+        const ssize_t result = recvmsg(fd, &message, 0);
+        if (result == 0) {
+            throw std::system_error(
+                std::make_error_code(std::errc::connection_reset));
+        } else if (result == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait_for(fd, POLLIN);
+            } else if (errno != EINTR) {
+                throw std::system_error(errno, std::system_category());
+            }
+
+            continue;
+        }
+
+        bytes_received += static_cast<size_t>(result);
+        consume(buffers, static_cast<size_t>(result));
+    }
+
+    return bytes_received;
+}
+
+}  // namespace
+
+std::optional<size_t> io_uring_send_receive(int fd,
+                                            std::span<const iovec> send,
+                                            std::span<const iovec> receive,
+                                            size_t min_receive) {
+    thread_local ThreadRing thread_ring;
+    io_uring* ring = thread_ring.get();
+    if (!ring) {
+        return std::nullopt;
+    }
+
+    // The kernel reads these structs when the entries are submitted, so they
+    // only need to live until the end of this function
+    msghdr send_message{};
+    send_message.msg_iov = const_cast<iovec*>(send.data());
+    send_message.msg_iovlen = send.size();
+    msghdr receive_message{};
+    receive_message.msg_iov = const_cast<iovec*>(receive.data());
+    receive_message.msg_iovlen = receive.size();
+
+    // `MSG_WAITALL` makes the kernel fail the send (and thus cancel the linked
+    // receive) instead of completing it with a short write
+    io_uring_sqe* send_sqe = io_uring_get_sqe(ring);
+    io_uring_prep_sendmsg(send_sqe, fd, &send_message,
+                          MSG_NOSIGNAL | MSG_WAITALL);
+    io_uring_sqe_set_data64(send_sqe, send_user_data);
+    send_sqe->flags |= IOSQE_IO_LINK;
+
+    io_uring_sqe* receive_sqe = io_uring_get_sqe(ring);
+    io_uring_prep_recvmsg(receive_sqe, fd, &receive_message, 0);
+    io_uring_sqe_set_data64(receive_sqe, receive_user_data);
+
+    if (io_uring_submit(ring) != 2) {
+        // This should never happen, but if it does then the queue may still
+        // contain our entries so we can't reuse this ring
+        thread_ring.disable();
+        return std::nullopt;
+    }
+
+    std::array<int, 2> results{};
+    for (int i = 0; i < 2; i++) {
+        io_uring_cqe* cqe = nullptr;
+        int error = 0;
+        while ((error = io_uring_wait_cqe(ring, &cqe)) == -EINTR) {
+        }
+        if (error < 0) {
+            thread_ring.disable();
+            throw std::system_error(-error, std::system_category());
+        }
+
+        results[io_uring_cqe_get_data64(cqe) == receive_user_data] = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+    }
+
+    const auto [send_result, receive_result] = results;
+    if (send_result < 0) {
+        throw std::system_error(-send_result, std::system_category());
+    }
+
+    size_t bytes_received = 0;
+    if (receive_result == 0) {
+        throw std::system_error(
+            std::make_error_code(std::errc::connection_reset));
+    } else if (receive_result > 0) {
+        bytes_received = static_cast<size_t>(receive_result);
+    } else if (receive_result != -EAGAIN && receive_result != -EINTR) {
+        throw std::system_error(-receive_result, std::system_category());
+    }
+
+    // If the response arrived in multiple parts, then we'll receive the rest
+    // of the required bytes the old fashioned way
+    if (bytes_received < min_receive) {
+        std::vector<iovec> remaining_buffers(receive.begin(), receive.end());
+        consume(remaining_buffers, bytes_received);
+        bytes_received += receive_at_least(fd, std::move(remaining_buffers),
+                                           min_receive - bytes_received);
+    }
+
+    return bytes_received;
+}
+
+#endif
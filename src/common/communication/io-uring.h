@@ -0,0 +1,71 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#ifdef WITH_IO_URING
+
+#include <cstddef>
+#include <optional>
+#include <span>
+
+#include <sys/uio.h>
+
+/**
+ * The largest request we'll send through `io_uring_send_receive()`. Larger
+ * requests are sent using regular blocking writes. Keeping requests well below
+ * the socket's send buffer size means the kernel will never have to split them
+ * up, which we rely on to chain the receive to the send. These requests are
+ * also not the ones where saving a system call makes any difference.
+ */
+constexpr size_t max_io_uring_request_size = 32 << 10;
+
+/**
+ * Send a request over a socket and start receiving the response using a single
+ * `io_uring_enter()` system call instead of separate `sendmsg()` and
+ * `recvmsg()` calls. The receive is linked to the send, so it only starts once
+ * the entire request has been sent. This saves a system call and a context
+ * switch for every one of the many small back to back requests made when a
+ * host scans a plugin's parameters or restores a project.
+ *
+ * Every thread gets its own ring the first time it calls this function. This
+ * falls back to returning a nullopt without doing anything if the kernel
+ * doesn't support io_uring (or if it's been disabled through
+ * `kernel.io_uring_disabled`), or if the calling thread is a realtime thread.
+ * We don't want to lazily set up rings from the audio thread.
+ *
+ * @param fd The socket's file descriptor.
+ * @param send The buffers to send. This should not be larger than
+ *   `max_io_uring_request_size`. These buffers are not modified, but they may
+ *   be reused as part of `receive`.
+ * @param receive The buffers to receive the response into. They may overlap
+ *   with `send`.
+ * @param min_receive The minimum number of bytes to receive. If the response
+ *   comes in in multiple parts, then we'll keep receiving until at least this
+ *   many bytes have been received.
+ *
+ * @return The number of bytes received, or a nullopt if io_uring cannot be used
+ *   on this thread. Nothing will have been sent in that case.
+ *
+ * @throw std::system_error If the socket was closed, or if sending or receiving
+ *   failed.
+ */
+std::optional<size_t> io_uring_send_receive(int fd,
+                                            std::span<const iovec> send,
+                                            std::span<const iovec> receive,
+                                            size_t min_receive);
+
+#endif
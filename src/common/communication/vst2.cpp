@@ -74,6 +74,8 @@ Vst2EventResult DefaultDataConverter::send_event(
     asio::local::stream_protocol::socket& socket,
     const Vst2Event& event,
     SerializationBufferBase& buffer) const {
-    write_object(socket, event, buffer);
-    return read_object<Vst2EventResult>(socket, buffer);
+    Vst2EventResult response;
+    write_and_read_object(socket, event, response, buffer);
+
+    return response;
 }
@@ -167,8 +167,9 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
      * @relates passthrough_event
      */
     template <std::derived_from<DefaultDataConverter> Converter>
-    intptr_t send_event(Converter& data_converter,
-                        std::optional<std::pair<Vst2Logger&, bool>> logging,
+    intptr_t send_event(
+        Converter& data_converter,
+        [[maybe_unused]] std::optional<std::pair<Vst2Logger&, bool>> logging,
                         int opcode,
                         int index,
                         intptr_t value,
@@ -184,10 +185,12 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
         const std::optional<Vst2Event::Payload> value_payload =
             data_converter.read_value(opcode, value);
 
-        if (logging) {
-            auto [logger, is_dispatch] = *logging;
-            logger.log_event(is_dispatch, opcode, index, value, payload, option,
-                             value_payload);
+        if constexpr (event_logging_enabled) {
+            if (logging) {
+                auto [logger, is_dispatch] = *logging;
+                logger.log_event(is_dispatch, opcode, index, value, payload,
+                                 option, value_payload);
+            }
         }
 
         const Vst2Event event{.opcode = opcode,
@@ -207,15 +210,27 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
         // calling thread (i.e. mutual recursion).
         const Vst2EventResult response =
             this->send([&](asio::local::stream_protocol::socket& socket) {
+                const bool is_primary = this->is_primary_socket(socket);
+                // The native side sends `dispatch()` calls and the Wine side
+                // sends `audioMaster()` callbacks
+                const TraceScope trace_scope(
+                    "Vst2Event", "request",
+                    is_primary ? this->next_trace_flow_id() : 0,
+                    is_primary ? TraceFlow::start : TraceFlow::none, opcode);
+                const LatencyScope latency_scope(
+                    vst2_event_histogram(opcode, false));
+
                 return data_converter.send_event(socket, event,
                                                  serialization_buffer());
             });
 
-        if (logging) {
-            auto [logger, is_dispatch] = *logging;
-            logger.log_event_response(is_dispatch, opcode,
-                                      response.return_value, response.payload,
-                                      response.value_payload);
+        if constexpr (event_logging_enabled) {
+            if (logging) {
+                auto [logger, is_dispatch] = *logging;
+                logger.log_event_response(
+                    is_dispatch, opcode, response.return_value,
+                    response.payload, response.value_payload);
+            }
         }
 
         data_converter.write_data(opcode, data, response);
@@ -254,20 +269,47 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
                 bool on_main_thread) {
                 SerializationBufferBase& buffer = serialization_buffer();
 
-                auto event = read_object<Vst2Event>(socket, buffer);
-                if (logging) {
-                    auto [logger, is_dispatch] = *logging;
-                    logger.log_event(is_dispatch, event.opcode, event.index,
-                                     event.value, event.payload, event.option,
-                                     event.value_payload);
+                // See `AdHocSocketHandler::next_trace_flow_id()`. The primary
+                // socket is the one handled on the main thread.
+                const uint64_t trace_flow_id =
+                    on_main_thread ? this->next_trace_flow_id() : 0;
+
+                // Like the serialization buffer, we'll reuse the event object
+                // for every event received on this thread. Because of
+                // `bitsery::ext::InPlaceVariant` this means that receiving the
+                // same type of event twice in a row can reuse the payload's
+                // strings and vectors instead of allocating new ones. See
+                // `reset_event()` for when this object gets cleared.
+                thread_local Vst2Event persistent_event{};
+                reset_event(persistent_event);
+
+                Vst2Event& event =
+                    read_object<Vst2Event>(socket, persistent_event, buffer);
+                if constexpr (event_logging_enabled) {
+                    if (logging) {
+                        auto [logger, is_dispatch] = *logging;
+                        logger.log_event(is_dispatch, event.opcode,
+                                         event.index, event.value,
+                                         event.payload, event.option,
+                                         event.value_payload);
+                    }
                 }
 
+                const TraceScope trace_scope(
+                    "Vst2Event", "handle", trace_flow_id,
+                    on_main_thread ? TraceFlow::end : TraceFlow::none,
+                    event.opcode);
+                const LatencyScope latency_scope(
+                    vst2_event_histogram(event.opcode, true));
+
                 Vst2EventResult response = callback(event, on_main_thread);
-                if (logging) {
-                    auto [logger, is_dispatch] = *logging;
-                    logger.log_event_response(
-                        is_dispatch, event.opcode, response.return_value,
-                        response.payload, response.value_payload);
+                if constexpr (event_logging_enabled) {
+                    if (logging) {
+                        auto [logger, is_dispatch] = *logging;
+                        logger.log_event_response(
+                            is_dispatch, event.opcode, response.return_value,
+                            response.payload, response.value_payload);
+                    }
                 }
 
                 write_object(socket, response, buffer);
@@ -298,22 +340,26 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
         // capacity for a large-ish number of events so we don't have to
         // allocate under normal circumstances.
         constexpr size_t initial_events_size = sizeof(DynamicVstEvents);
-        thread_local SerializationBuffer<initial_events_size> buffer{};
+        static std::atomic_size_t learned_capacity = 0;
+        thread_local AdaptiveSerializationBuffer<initial_events_size> buffer(
+            learned_capacity);
 
         // This buffer is already pretty large, but it can still grow immensely
-        // when sending and receiving preset data. In such cases we do want to
-        // reallocate the buffer on the next event to free up memory again. This
+        // when sending and receiving preset data. The buffer will be
+        // reallocated once the events that follow are much smaller again. This
         // won't happen during audio processing.
-        if (buffer.size() > initial_events_size * 2) {
-            // NOTE: There's no `.shrink_to_fit()` implementation here, so we'll
-            //       just YOLO it and reinitialize the vector since we don't
-            //       need the old data
-            buffer = SerializationBuffer<initial_events_size>{};
-            // buffer.resize(initial_events_size);
-            // buffer.shrink_to_fit();
-        }
+        return buffer.get();
+    }
 
-        return buffer;
+    /**
+     * The `Vst2Event` counterpart to `serialization_buffer()`. Events
+     * containing preset chunks can be huge, so we won't keep those around
+     * any longer than needed.
+     */
+    static void reset_event(Vst2Event& event) {
+        if (std::holds_alternative<ChunkData>(event.payload)) {
+            event.payload = nullptr;
+        }
     }
 };
 
@@ -343,29 +389,31 @@ class Vst2Sockets final : public Sockets {
      * @param listen If `true`, start listening on the sockets. Incoming
      *   connections will be accepted when `connect()` gets called. This should
      *   be set to `true` on the plugin side, and `false` on the Wine host side.
+     * @param abstract_namespace Whether to use abstract socket endpoints. See
+     *   `Sockets` for more information.
      *
      * @see Vst2Sockets::connect
      */
     Vst2Sockets(asio::io_context& io_context,
                 const ghc::filesystem::path& endpoint_base_dir,
-                bool listen)
-        : Sockets(endpoint_base_dir),
+                bool listen,
+                bool abstract_namespace)
+        : Sockets(endpoint_base_dir, abstract_namespace),
           host_vst_dispatch_(io_context,
-                             (base_dir_ / "host_vst_dispatch.sock").string(),
+                             endpoint("host_vst_dispatch.sock"),
                              listen),
           vst_host_callback_(io_context,
-                             (base_dir_ / "vst_host_callback.sock").string(),
+                             endpoint("vst_host_callback.sock"),
                              listen),
-          host_vst_parameters_(
-              io_context,
-              (base_dir_ / "host_vst_parameters.sock").string(),
-              listen),
+          host_vst_parameters_(io_context,
+                               endpoint("host_vst_parameters.sock"),
+                               listen),
           host_vst_process_replacing_(
               io_context,
-              (base_dir_ / "host_vst_process_replacing.sock").string(),
+              endpoint("host_vst_process_replacing.sock"),
               listen),
           host_vst_control_(io_context,
-                            (base_dir_ / "host_vst_control.sock").string(),
+                            endpoint("host_vst_control.sock"),
                             listen) {}
 
     ~Vst2Sockets() noexcept override { close(); }
@@ -482,6 +530,10 @@ Vst2EventResult passthrough_event(AEffect* plugin,
             // updates to the native plugin from the Wine plugin host
             return nullptr;
         },
+        [](const AEffectDelta&) -> void* {
+            // The same as the above, but only for the fields that changed
+            return nullptr;
+        },
         [](DynamicVstEvents& events) -> void* { return &events.as_c_events(); },
         [](DynamicSpeakerArrangement& speaker_arrangement) -> void* {
             return &speaker_arrangement.as_c_speaker_arrangement();
@@ -507,7 +559,16 @@ Vst2EventResult passthrough_event(AEffect* plugin,
         [](VstPatchChunkInfo& info) -> void* { return &info; },
         [&](const WantsVstRect&) -> void* { return string_buffer.data(); },
         [](const WantsVstTimeInfo&) -> void* { return nullptr; },
-        [&](const WantsString&) -> void* { return string_buffer.data(); }};
+        [&](const WantsString&) -> void* { return string_buffer.data(); },
+        [](const WantsParameterDescriptions&) -> void* {
+            // This is handled separately in `Vst2Bridge::run()` and never
+            // reaches the plugin
+            return nullptr;
+        },
+        [](const WantsProgramNames&) -> void* {
+            // Same as the above
+            return nullptr;
+        }};
 
     // Almost all events pass data through the `data` argument. There are two
     // events, `effSetSpeakerArrangement()` and `effGetSpeakerArrangement()`
@@ -536,6 +597,11 @@ Vst2EventResult passthrough_event(AEffect* plugin,
 
             return nullptr;
         },
+        [&](const AEffectDelta& delta) -> Vst2EventResult::Payload {
+            delta.apply(*plugin);
+
+            return nullptr;
+        },
         [](const DynamicSpeakerArrangement& speaker_arrangement)
             -> Vst2EventResult::Payload { return speaker_arrangement; },
         [&](const WantsAEffectUpdate&) -> Vst2EventResult::Payload {
@@ -16,13 +16,29 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <variant>
 
 #include "../logging/vst3.h"
 #include "../serialization/vst3.h"
 #include "common.h"
 
+/**
+ * Requests whose response the caller does not need to wait for, because the
+ * response is only ever a status code that the caller can't meaningfully act
+ * on. These can be sent using `Vst3MessageHandler::send_message_async()`. A
+ * request opts into this by defining `static constexpr bool fire_and_forget =
+ * true`.
+ */
+template <typename T>
+concept FireAndForget = requires {
+    requires T::fire_and_forget;
+};
+
 /**
  * An instance of `AdHocSocketHandler` that encapsulates the simple
  * communication model we use for sending requests and receiving responses. A
@@ -62,6 +78,18 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
                        bool listen)
         : AdHocSocketHandler<Thread>(io_context, endpoint, listen) {}
 
+    /**
+     * Stop the thread used for `send_message_async()`, if it was started.
+     * Requests that are still queued at this point are dropped.
+     */
+    ~Vst3MessageHandler() noexcept {
+        {
+            std::lock_guard lock(async_queue_mutex_);
+            async_stopping_ = true;
+        }
+        async_queue_cv_.notify_all();
+    }
+
     /**
      * Serialize and send an event over a socket and return the appropriate
      * response.
@@ -109,6 +137,37 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
         return response_object;
     }
 
+    /**
+     * Queue a request to be sent from a background thread and return
+     * immediately, without waiting for the response. Requests sent this way are
+     * sent in the order they were queued in, but they may be sent after
+     * requests sent later through the regular `send_message()`. The response
+     * is logged and then discarded. The background thread gets started the
+     * first time this function is called.
+     *
+     * @param object The request object to send. This will be copied into the
+     *   queue.
+     * @param logging See `send_message()`.
+     *
+     * @see FireAndForget
+     */
+    template <FireAndForget T>
+    void send_message_async(
+        const T& object,
+        std::optional<std::pair<Vst3Logger&, bool>> logging) {
+        {
+            std::lock_guard lock(async_queue_mutex_);
+            async_queue_.push_back(
+                [this, object, logging]() { send_message(object, logging); });
+
+            if (!async_sender_started_) {
+                async_sender_ = Thread([this]() { run_async_sender(); });
+                async_sender_started_ = true;
+            }
+        }
+        async_queue_cv_.notify_one();
+    }
+
     /**
      * `Vst3MessageHandler::send_message()`, but deserializing the response into
      * an existing object.
@@ -121,31 +180,50 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
     typename T::Response& receive_into(
         const T& object,
         typename T::Response& response_object,
-        std::optional<std::pair<Vst3Logger&, bool>> logging,
+        [[maybe_unused]] std::optional<std::pair<Vst3Logger&, bool>> logging,
         SerializationBufferBase& buffer) {
         using TResponse = typename T::Response;
 
         // Since a lot of messages just return a `tresult`, we can't filter out
         // responses based on the response message type. Instead, we'll just
         // only print the responses when the request was not filtered out.
-        bool should_log_response = false;
-        if (logging) {
-            auto [logger, is_host_vst] = *logging;
-            should_log_response = logger.log_request(is_host_vst, object);
+        [[maybe_unused]] bool should_log_response = false;
+        if constexpr (event_logging_enabled) {
+            if (logging) {
+                auto [logger, is_host_vst] = *logging;
+                should_log_response = logger.log_request(is_host_vst, object);
+            }
         }
 
         // A socket only handles a single request at a time as to prevent
         // messages from arriving out of order. `AdHocSocketHandler::send()`
         // will either use a long-living primary socket, or if that's currently
         // in use it will spawn a new socket for us.
+        // NOTE: The audio processor sockets are used from the audio thread, so
+        //       we don't want to lazily set up io_uring rings there
         this->send([&](asio::local::stream_protocol::socket& socket) {
-            write_object(socket, Request(object), buffer);
-            read_object<TResponse>(socket, response_object, buffer);
+            const bool is_primary = this->is_primary_socket(socket);
+            const TraceScope trace_scope(
+                trace_name<T>(), "request",
+                is_primary ? this->next_trace_flow_id() : 0,
+                is_primary ? TraceFlow::start : TraceFlow::none);
+            const LatencyScope latency_scope(
+                vst3_request_histogram<T, false>());
+
+            if constexpr (std::is_same_v<Request, AudioProcessorRequest>) {
+                write_object(socket, Request(object), buffer);
+                read_object<TResponse>(socket, response_object, buffer);
+            } else {
+                write_and_read_object(socket, Request(object), response_object,
+                                      buffer);
+            }
         });
 
-        if (should_log_response) {
-            auto [logger, is_host_vst] = *logging;
-            logger.log_response(!is_host_vst, response_object);
+        if constexpr (event_logging_enabled) {
+            if (should_log_response) {
+                auto [logger, is_host_vst] = *logging;
+                logger.log_response(!is_host_vst, response_object);
+            }
         }
 
         return response_object;
@@ -205,7 +283,8 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
         // we receive works in the same way regardless of which socket we're
         // using
         const auto process_message =
-            [&](asio::local::stream_protocol::socket& socket) {
+            [&](asio::local::stream_protocol::socket& socket,
+                bool is_primary) {
                 // The persistent buffer is only used when the
                 // `persistent_buffers` template value is enabled, but we'll
                 // always use the thread local persistent object. Because of
@@ -217,58 +296,139 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
                 // every time, but on the audio processor side we store the
                 // actual variant within an object and we then use some hackery
                 // to always keep the large process data object in memory.
-                thread_local SerializationBuffer<256> persistent_buffer{};
+                static std::atomic_size_t learned_capacity = 0;
+                thread_local AdaptiveSerializationBuffer<256> persistent_buffer(
+                    learned_capacity);
                 thread_local Request persistent_object;
+                SerializationBufferBase& buffer = persistent_buffer.get();
 
                 auto& request =
                     persistent_buffers
                         ? read_object<Request>(socket, persistent_object,
-                                               persistent_buffer)
+                                               buffer)
                         : read_object<Request>(socket, persistent_object);
 
+                // The flow ID has to be taken for every request on the primary
+                // socket to stay in sync with the other side, see
+                // `AdHocSocketHandler::next_trace_flow_id()`
+                const uint64_t trace_flow_id =
+                    is_primary ? this->next_trace_flow_id() : 0;
+
                 // See the comment in `receive_into()` for more information
-                bool should_log_response = false;
-                if (logging) {
-                    should_log_response = std::visit(
-                        [&](const auto& object) {
-                            auto [logger, is_host_vst] = *logging;
-                            return logger.log_request(is_host_vst, object);
-                        },
-                        // In the case of `AudioProcessorRequest`, we need to
-                        // actually fetch the variant field since our object
-                        // also contains a persistent object to store process
-                        // data into so we can prevent allocations during audio
-                        // processing
-                        get_request_variant(request));
+                [[maybe_unused]] bool should_log_response = false;
+                if constexpr (event_logging_enabled) {
+                    if (logging) {
+                        should_log_response = std::visit(
+                            [&](const auto& object) {
+                                auto [logger, is_host_vst] = *logging;
+                                return logger.log_request(is_host_vst, object);
+                            },
+                            // In the case of `AudioProcessorRequest`, we need
+                            // to actually fetch the variant field since our
+                            // object also contains a persistent object to
+                            // store process data into so we can prevent
+                            // allocations during audio processing
+                            get_request_variant(request));
+                    }
                 }
 
                 // We do the visiting here using a templated lambda. This way we
                 // always know for sure that the function returns the correct
-                // type, and we can scrap a lot of boilerplate elsewhere.
+                // type, and we can scrap a lot of boilerplate elsewhere. The
+                // callback gets a reference to the thread local object we
+                // deserialized into so we don't make a deep copy of every
+                // request, and so the strings and vectors in that object can be
+                // reused the next time the same type of request comes in.
                 std::visit(
-                    [&]<typename T>(T object) {
+                    [&]<typename T>(T& object) {
+                        const TraceScope trace_scope(
+                            trace_name<T>(), "handle", trace_flow_id,
+                            is_primary ? TraceFlow::end : TraceFlow::none);
+                        const LatencyScope latency_scope(
+                            vst3_request_histogram<T, true>());
+
                         typename T::Response response = callback(object);
 
-                        if (should_log_response) {
-                            auto [logger, is_host_vst] = *logging;
-                            logger.log_response(!is_host_vst, response);
+                        if constexpr (event_logging_enabled) {
+                            if (should_log_response) {
+                                auto [logger, is_host_vst] = *logging;
+                                logger.log_response(!is_host_vst, response);
+                            }
                         }
 
                         if constexpr (persistent_buffers) {
-                            write_object(socket, response, persistent_buffer);
+                            write_object(socket, response, buffer);
                         } else {
                             write_object(socket, response);
                         }
                     },
                     // See above
                     get_request_variant(request));
+
+                // Requests on the regular sockets may contain entire preset
+                // states, and the thread local object would otherwise keep
+                // the largest of those around until the next request of a
+                // different type comes in
+                if constexpr (!persistent_buffers) {
+                    persistent_object = Request{};
+                }
             };
 
         this->receive_multi(
             logging ? std::optional(std::ref(logging->first.logger_))
                     : std::nullopt,
-            process_message);
+            [&](asio::local::stream_protocol::socket& socket) {
+                process_message(socket, true);
+            },
+            [&](asio::local::stream_protocol::socket& socket) {
+                process_message(socket, false);
+            });
+    }
+
+   private:
+    /**
+     * Send the requests queued by `send_message_async()` until this object gets
+     * destroyed or until the socket gets closed.
+     */
+    void run_async_sender() {
+        std::unique_lock lock(async_queue_mutex_);
+        while (true) {
+            async_queue_cv_.wait(
+                lock, [&]() { return async_stopping_ || !async_queue_.empty(); });
+            if (async_stopping_) {
+                break;
+            }
+
+            std::function<void()> send_request =
+                std::move(async_queue_.front());
+            async_queue_.pop_front();
+
+            lock.unlock();
+            try {
+                send_request();
+            } catch (const std::system_error&) {
+                // The socket has been closed, so we're shutting down
+                return;
+            }
+            lock.lock();
+        }
     }
+
+    /**
+     * Requests queued by `send_message_async()`, erased into functions that
+     * send them and discard the responses.
+     */
+    std::deque<std::function<void()>> async_queue_;
+    std::mutex async_queue_mutex_;
+    std::condition_variable async_queue_cv_;
+    bool async_stopping_ = false;
+    bool async_sender_started_ = false;
+
+    /**
+     * The thread that sends the requests in `async_queue_`. This is declared
+     * last so it gets joined before the queue is destroyed.
+     */
+    Thread async_sender_;
 };
 
 /**
@@ -307,18 +467,21 @@ class Vst3Sockets final : public Sockets {
      * @param listen If `true`, start listening on the sockets. Incoming
      *   connections will be accepted when `connect()` gets called. This should
      *   be set to `true` on the plugin side, and `false` on the Wine host side.
+     * @param abstract_namespace Whether to use abstract socket endpoints. See
+     *   `Sockets` for more information.
      *
      * @see Vst3Sockets::connect
      */
     Vst3Sockets(asio::io_context& io_context,
                 const ghc::filesystem::path& endpoint_base_dir,
-                bool listen)
-        : Sockets(endpoint_base_dir),
+                bool listen,
+                bool abstract_namespace)
+        : Sockets(endpoint_base_dir, abstract_namespace),
           host_vst_control_(io_context,
-                            (base_dir_ / "host_vst_control.sock").string(),
+                            endpoint("host_vst_control.sock"),
                             listen),
           vst_host_callback_(io_context,
-                             (base_dir_ / "vst_host_callback.sock").string(),
+                             endpoint("vst_host_callback.sock"),
                              listen),
           io_context_(io_context) {}
 
@@ -354,14 +517,23 @@ class Vst3Sockets final : public Sockets {
         std::lock_guard lock(audio_processor_sockets_mutex_);
         audio_processor_sockets_.try_emplace(
             instance_id, io_context_,
-            (base_dir_ / ("host_vst_audio_processor_" +
-                          std::to_string(instance_id) + ".sock"))
-                .string(),
+            endpoint("host_vst_audio_processor_" +
+                     std::to_string(instance_id) + ".sock"),
             false);
 
         audio_processor_sockets_.at(instance_id).connect();
     }
 
+    /**
+     * Whether a dedicated `IAudioProcessor` and `IConnect` socket has been set
+     * up for a plugin object instance. Used with the `vst3_lazy_audio_threads`
+     * option, where these sockets are only created on first use.
+     */
+    bool has_audio_processor(size_t instance_id) {
+        std::lock_guard lock(audio_processor_sockets_mutex_);
+        return audio_processor_sockets_.contains(instance_id);
+    }
+
     /**
      * Create and listen on a dedicated `IAudioProcessor` and `IConnect`
      * handling socket for a plugin object instance. The calling thread will
@@ -388,9 +560,8 @@ class Vst3Sockets final : public Sockets {
             std::lock_guard lock(audio_processor_sockets_mutex_);
             audio_processor_sockets_.try_emplace(
                 instance_id, io_context_,
-                (base_dir_ / ("host_vst_audio_processor_" +
-                              std::to_string(instance_id) + ".sock"))
-                    .string(),
+                endpoint("host_vst_audio_processor_" +
+                         std::to_string(instance_id) + ".sock"),
                 true);
         }
 
@@ -506,11 +677,13 @@ class Vst3Sockets final : public Sockets {
         typename T::Response& response_object,
         size_t instance_id,
         std::optional<std::pair<Vst3Logger&, bool>> logging) {
-        thread_local SerializationBuffer<256> audio_processor_buffer{};
+        static std::atomic_size_t learned_capacity = 0;
+        thread_local AdaptiveSerializationBuffer<256> audio_processor_buffer(
+            learned_capacity);
 
         return audio_processor_sockets_.at(instance_id)
             .receive_into(object, response_object, logging,
-                          audio_processor_buffer);
+                          audio_processor_buffer.get());
     }
 
     asio::io_context& io_context_;
@@ -21,18 +21,52 @@
 #define TOML_WINDOWS_COMPAT 0
 
 #include <fnmatch.h>
+#include <sched.h>
 #include <toml++/toml.h>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "utils.h"
 
 namespace fs = ghc::filesystem;
 
-Configuration::Configuration() noexcept {}
+/**
+ * The sections from a `yabridge.toml` file, sorted by their position in the
+ * file.
+ */
+using SortedTables = std::vector<std::tuple<toml::key, toml::table>>;
+
+/**
+ * Parse a `yabridge.toml` file and sort its sections by their location in the
+ * file. When a lot of plugins share the same configuration file, we'd otherwise
+ * have to parse that file again for every single plugin instance, so the
+ * results are cached for the lifetime of the process. Cached files are
+ * invalidated when their modification time changes.
+ *
+ * @throw toml::parsing_error If the file cannot be parsed. Files that fail to
+ *   parse will not be cached.
+ */
+std::shared_ptr<const SortedTables> parse_config_file(
+    const fs::path& config_path) {
+    static std::mutex parsed_files_mutex;
+    static std::map<fs::path,
+                    std::pair<fs::file_time_type,
+                              std::shared_ptr<const SortedTables>>>
+        parsed_files;
+
+    std::error_code err;
+    const fs::file_time_type last_write_time =
+        fs::last_write_time(config_path, err);
+    if (!err) {
+        std::lock_guard lock(parsed_files_mutex);
+        if (auto it = parsed_files.find(config_path);
+            it != parsed_files.end() && it->second.first == last_write_time) {
+            return it->second.second;
+        }
+    }
 
-Configuration::Configuration(const fs::path& config_path,
-                             const fs::path& yabridge_path)
-    : Configuration() {
     // Will throw a `toml::parsing_error` if the file cannot be parsed. Better
     // to throw here rather than failing silently since syntax errors would
     // otherwise be impossible to spot. We'll also have to sort all tables by
@@ -44,13 +78,13 @@ Configuration::Configuration(const fs::path& config_path,
     // sorted lexicographically. For our uses we want sections from the start of
     // the file to have precedence over later sections, so we need to sort the
     // tables by source location first.
-    std::vector<std::tuple<toml::key, toml::table>> sorted_tables{};
+    auto sorted_tables = std::make_shared<SortedTables>();
     for (auto [pattern, node] : table) {
         if (const toml::table* config = node.as_table()) {
-            sorted_tables.push_back(std::make_tuple(pattern, *config));
+            sorted_tables->push_back(std::make_tuple(pattern, *config));
         }
     }
-    std::sort(sorted_tables.begin(), sorted_tables.end(),
+    std::sort(sorted_tables->begin(), sorted_tables->end(),
               [](const auto& a, const auto& b) {
                   const auto& [a_pattern, a_table] = a;
                   const auto& [b_pattern, b_table] = b;
@@ -59,23 +93,84 @@ Configuration::Configuration(const fs::path& config_path,
                          b_pattern.source().begin.line;
               });
 
-    // This is the path of the current .so file relative to this `yabridge.toml`
-    // file
-    const fs::path relative_path =
-        yabridge_path.lexically_relative(config_path.parent_path());
-    for (const auto& [pattern, table] : sorted_tables) {
-        // First try to match the glob pattern, allow matching an entire
-        // directory for ease of use. If none of the patterns in the file match
-        // the plugin path then everything will be left at the defaults.
+    if (!err) {
+        std::lock_guard lock(parsed_files_mutex);
+        parsed_files[config_path] = std::pair(last_write_time, sorted_tables);
+    }
+
+    return sorted_tables;
+}
+
+Configuration::Configuration() noexcept {}
+
+Configuration::Configuration(const fs::path& config_path,
+                             const fs::path& yabridge_path)
+    // This is the path of the current .so file relative to this
+    // `yabridge.toml` file. We'll try to match the glob patterns against this,
+    // and we'll allow matching an entire directory for ease of use. If none of
+    // the patterns in the file match the plugin path then everything will be
+    // left at the defaults.
+    : Configuration(config_path,
+                    [relative_path = yabridge_path.lexically_relative(
+                         config_path.parent_path())](
+                        const std::string& pattern) {
+                        return fnmatch(pattern.c_str(), relative_path.c_str(),
+                                       FNM_PATHNAME | FNM_LEADING_DIR) == 0;
+                    }) {}
+
+Configuration Configuration::reload() const {
+    if (!matched_file || !matched_pattern) {
+        return Configuration();
+    }
+
+    return Configuration(*matched_file,
+                         [&](const std::string& pattern) {
+                             return pattern == *matched_pattern;
+                         });
+}
+
+Configuration::Configuration(
+    const fs::path& config_path,
+    const std::function<bool(const std::string& pattern)>& matches)
+    : Configuration() {
+    // Will throw a `toml::parsing_error` if the file cannot be parsed
+    const std::shared_ptr<const SortedTables> sorted_tables =
+        parse_config_file(config_path);
+
+    for (const auto& [pattern, table] : *sorted_tables) {
         const std::string key(pattern.str());
-        if (fnmatch(key.c_str(), relative_path.c_str(),
-                    FNM_PATHNAME | FNM_LEADING_DIR) != 0) {
+        if (!matches(key)) {
             continue;
         }
 
         matched_file = config_path;
         matched_pattern = pattern;
 
+        // Profiles are applied first so the other options in this section can
+        // override the options set by the profile
+        if (const toml::node* profile_node = table.get("profile")) {
+            const std::optional<std::string> profile_name =
+                profile_node->value<std::string>();
+            if (profile_name == "low-latency") {
+                audio_wait_spin_us = 50;
+                futex_signalling = true;
+                vst3_edit_coalescing_ms = 10;
+            } else if (profile_name == "mixing") {
+                event_loop_idle_backoff = true;
+                vst2_pipelined_processing = true;
+            } else if (profile_name == "render") {
+                offline_render_non_realtime = true;
+                vst3_fast_offline_processing = true;
+            }
+
+            if (profile_name == "low-latency" || profile_name == "mixing" ||
+                profile_name == "render") {
+                profile = *profile_name;
+            } else {
+                invalid_options.emplace_back("profile");
+            }
+        }
+
         // If the table is missing some fields then they will simply be left at
         // their defaults. At this point I'd really wish C++ could do pattern
         // matching.
@@ -86,6 +181,125 @@ Configuration::Configuration(const fs::path& config_path,
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "group_parallel_loading") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    group_parallel_loading = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "group_module_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    group_module_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_buffer_headroom") {
+                std::optional<double> headroom;
+                if (const auto parsed_value = value.as_floating_point()) {
+                    headroom = parsed_value->get();
+                } else if (const auto parsed_value = value.as_integer()) {
+                    headroom = static_cast<double>(parsed_value->get());
+                }
+
+                // Values below 1 would not make any sense here
+                if (headroom && *headroom >= 1.0) {
+                    audio_buffer_headroom = static_cast<float>(*headroom);
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_buffer_idle_release_s") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 0) {
+                    if (parsed_value->get() > 0) {
+                        audio_buffer_idle_release_s =
+                            static_cast<uint32_t>(parsed_value->get());
+                    }
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_buffer_reclaim") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    audio_buffer_reclaim = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_deadline_warning") {
+                std::optional<double> fraction;
+                if (const auto parsed_value = value.as_floating_point()) {
+                    fraction = parsed_value->get();
+                } else if (const auto parsed_value = value.as_integer()) {
+                    fraction = static_cast<double>(parsed_value->get());
+                }
+
+                if (fraction && *fraction > 0.0) {
+                    audio_deadline_warning = static_cast<float>(*fraction);
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_thread_cpus") {
+                // This can be either a single core or an array of cores
+                std::vector<int> cpus;
+                bool valid = true;
+                const auto parse_cpu = [&](const toml::node& node) {
+                    const auto parsed_value = node.as_integer();
+                    if (parsed_value && parsed_value->get() >= 0 &&
+                        parsed_value->get() < CPU_SETSIZE) {
+                        cpus.push_back(static_cast<int>(parsed_value->get()));
+                    } else {
+                        valid = false;
+                    }
+                };
+                if (const auto parsed_value = value.as_array()) {
+                    for (const auto& element : *parsed_value) {
+                        parse_cpu(element);
+                    }
+                } else {
+                    parse_cpu(value);
+                }
+
+                if (valid && !cpus.empty()) {
+                    audio_thread_cpus = std::move(cpus);
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_thread_follow_host_cpu") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    audio_thread_follow_host_cpu = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_thread_follow_host_numa_node") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    audio_thread_follow_host_numa_node = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_thread_host_mapping") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    audio_thread_host_mapping = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_thread_sched_deadline") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    audio_thread_sched_deadline = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_wait_spin_us") {
+                // Spinning for longer than a millisecond would just waste CPU
+                // time, since the scheduler's wakeup latency is much lower than
+                // that
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 0 &&
+                    parsed_value->get() <= 1000) {
+                    if (parsed_value->get() > 0) {
+                        audio_wait_spin_us =
+                            static_cast<uint32_t>(parsed_value->get());
+                    }
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else if (key == "disable_pipes") {
                 // This option can be either enabled or disable with a boolean,
                 // or it can be set to an absolute path
@@ -113,12 +327,32 @@ Configuration::Configuration(const fs::path& config_path,
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "editor_obscured_frame_rate") {
+                if (const auto parsed_value = value.as_floating_point()) {
+                    editor_obscured_frame_rate = parsed_value->get();
+                } else if (const auto parsed_value = value.as_integer()) {
+                    editor_obscured_frame_rate = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "editor_precreate_window") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    editor_precreate_window = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else if (key == "editor_xembed") {
                 if (const auto parsed_value = value.as_boolean()) {
                     editor_xembed = parsed_value->get();
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "event_loop_idle_backoff") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    event_loop_idle_backoff = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else if (key == "frame_rate") {
                 if (const auto parsed_value = value.as_floating_point()) {
                     frame_rate = parsed_value->get();
@@ -130,24 +364,246 @@ Configuration::Configuration(const fs::path& config_path,
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "futex_signalling") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    futex_signalling = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "host_pool_size") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 1 &&
+                    parsed_value->get() <= 16) {
+                    host_pool_size = static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else if (key == "hide_daw") {
                 if (const auto parsed_value = value.as_boolean()) {
                     hide_daw = parsed_value->get();
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "memory_huge_pages") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    memory_huge_pages = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "memory_merging") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    memory_merging = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "offline_render_non_realtime") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    offline_render_non_realtime = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "parameter_metadata_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    parameter_metadata_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "pin_audio_buffers") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    pin_audio_buffers = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "profile") {
+                // This has already been handled above
+            } else if (key == "speaker_arrangement_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    speaker_arrangement_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_async_automation") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_async_automation = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_batch_midi_events") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_batch_midi_events = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_chunk_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_chunk_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_coalesce_io_changed") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_coalesce_io_changed = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_detect_silence") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_detect_silence = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_midi_output_queue_size") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 1 &&
+                    parsed_value->get() <= 4096) {
+                    vst2_midi_output_queue_size =
+                        static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_parameter_cache_ms") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 1 &&
+                    parsed_value->get() <= 60000) {
+                    vst2_parameter_cache_ms =
+                        static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_parameter_info_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_parameter_info_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_pipelined_processing") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_pipelined_processing = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_program_name_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_program_name_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst2_scan_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_scan_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_async_callbacks") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_async_callbacks = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_automation_thinning") {
+                std::optional<double> tolerance;
+                if (const auto parsed_value = value.as_floating_point()) {
+                    tolerance = parsed_value->get();
+                }
+
+                if (tolerance && *tolerance > 0.0 && *tolerance < 1.0) {
+                    vst3_automation_thinning = static_cast<float>(*tolerance);
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_control_off_gui_thread") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_control_off_gui_thread = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_edit_coalescing_ms") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 1 &&
+                    parsed_value->get() <= 1000) {
+                    vst3_edit_coalescing_ms =
+                        static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_fast_offline_processing") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_fast_offline_processing = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_get_state_off_gui_thread") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_get_state_off_gui_thread = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_lazy_audio_threads") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_lazy_audio_threads = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else if (key == "vst3_no_scaling") {
                 if (const auto parsed_value = value.as_boolean()) {
                     vst3_no_scaling = parsed_value->get();
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "vst3_parameter_finder_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_parameter_finder_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_parameter_value_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_parameter_value_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else if (key == "vst3_prefer_32bit") {
                 if (const auto parsed_value = value.as_boolean()) {
                     vst3_prefer_32bit = parsed_value->get();
                 } else {
                     invalid_options.emplace_back(key);
                 }
+            } else if (key == "vst3_prefetch_instance_info") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_prefetch_instance_info = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_restart_coalescing_ms") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 1 &&
+                    parsed_value->get() <= 1000) {
+                    vst3_restart_coalescing_ms =
+                        static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_shared_bus_cache") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_shared_bus_cache = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "vst3_skip_silent_inputs") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_skip_silent_inputs = parsed_value->get();
+                } else {
+                    invalid_options.emplace_back(key);
+                }
+            } else if (key == "wineserver_persistence") {
+                const auto parsed_value = value.as_integer();
+                if (parsed_value && parsed_value->get() >= 1 &&
+                    parsed_value->get() <= 86400) {
+                    wineserver_persistence =
+                        static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.emplace_back(key);
+                }
             } else {
                 unknown_options.emplace_back(key);
             }
@@ -162,3 +618,18 @@ std::chrono::steady_clock::duration Configuration::event_loop_interval()
     return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
         std::chrono::milliseconds(1000) / frame_rate.value_or(60.0));
 }
+
+std::optional<std::chrono::steady_clock::duration>
+Configuration::obscured_editor_idle_interval() const noexcept {
+    if (!editor_obscured_frame_rate) {
+        return std::nullopt;
+    }
+
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::milliseconds(1000) / *editor_obscured_frame_rate);
+}
+
+bool Configuration::follows_host_audio_thread_cpu() const noexcept {
+    return audio_thread_follow_host_cpu && !audio_thread_host_mapping &&
+           !audio_wait_spin_us;
+}
@@ -17,7 +17,10 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <optional>
+#include <string>
+#include <vector>
 
 #include <ghc/filesystem.hpp>
 
@@ -71,6 +74,19 @@ class Configuration {
     Configuration(const ghc::filesystem::path& config_path,
                   const ghc::filesystem::path& yabridge_path);
 
+    /**
+     * Parse `matched_file` again and return the settings from the section with
+     * `matched_pattern` as its key. This is used to pick up changes made to the
+     * configuration file while the plugin is running. The default settings are
+     * returned if this configuration was not loaded from a file, or if the
+     * section no longer exists.
+     *
+     * @throw toml::parsing_error If the file could not be parsed.
+     */
+    Configuration reload() const;
+
+    bool operator==(const Configuration&) const = default;
+
     /**
      * The name of the plugin group that should be used for the plugin this
      * configuration object was created for. If not set, then the plugin should
@@ -78,6 +94,158 @@ class Configuration {
      */
     std::optional<std::string> group;
 
+    /**
+     * When hosting the plugin in a plugin group, load its library on a
+     * separate thread before handing it over to the group host's main thread.
+     * This way loading a project with many plugins in the same group does not
+     * have to wait for every `LoadLibrary()` call, including the dependency
+     * resolution that goes with it, to finish one after the other. The actual
+     * plugin initialization still happens on the main thread one plugin at a
+     * time.
+     *
+     * @see HostRequest::preload_library_path
+     */
+    bool group_parallel_loading = false;
+
+    /**
+     * When hosting the plugin in a plugin group, keep its library loaded for
+     * `module_unload_grace_period` after the plugin exits. New instances of the
+     * same plugin loaded during that time will reuse the already loaded
+     * library, and for VST3 plugins also the already initialized module and
+     * plugin factory.
+     *
+     * @see HostBridge::retain_module
+     */
+    bool group_module_cache = false;
+
+    /**
+     * How much larger than strictly necessary the shared memory audio buffers
+     * should be allocated when they need to grow. With a value of 2, the
+     * buffers will be allocated with twice the required size. As long as later
+     * block size or channel layout changes still fit in the allocated memory,
+     * the buffers can be updated in place without having to remap them. The
+     * buffers never shrink unless `audio_buffer_reclaim` is enabled. If not
+     * set, no additional memory is reserved.
+     *
+     * @see AudioShmBuffer::Config::capacity
+     */
+    std::optional<float> audio_buffer_headroom;
+
+    /**
+     * Give the memory backing a plugin instance's shared audio buffers back to
+     * the kernel after it has not processed any audio for this many seconds
+     * while its editor is closed. Hosts like REAPER stop processing silent
+     * tracks, so in large templates most instances would otherwise keep their
+     * buffers locked in memory for nothing. The memory is restored by the next
+     * processing call.
+     *
+     * @see IdleBufferRelease
+     */
+    std::optional<uint32_t> audio_buffer_idle_release_s;
+
+    /**
+     * Shrink the shared memory audio buffers again when the plugin gets
+     * reconfigured to a layout that needs less than half of the memory that's
+     * currently allocated, instead of keeping the largest buffers ever
+     * allocated around for the rest of the plugin's lifetime.
+     *
+     * @see AudioShmBuffer::Config::reclaimable
+     */
+    bool audio_buffer_reclaim = false;
+
+    /**
+     * Log a breakdown of where the time went for every bridged audio
+     * processing call that took longer than this fraction of the block's
+     * duration, based on the sample rate and the number of samples in the
+     * block. The breakdown shows the time spent sending the request, waking up
+     * the Wine plugin host, processing in the plugin, waiting on host
+     * callbacks during processing, and copying the outputs back, along with
+     * whether both audio threads were using realtime scheduling. These
+     * messages are rate limited to one per second.
+     *
+     * @see ProcessDeadlineMonitor
+     */
+    std::optional<float> audio_deadline_warning;
+
+    /**
+     * The CPU cores the Wine plugin host's audio threads should be restricted
+     * to. This is useful on systems where some cores have been isolated for
+     * realtime audio, since otherwise the audio threads may end up sharing a
+     * core with the GUI and X11 threads. An empty list leaves the affinity
+     * untouched.
+     *
+     * @see set_audio_thread_affinity
+     */
+    std::vector<int> audio_thread_cpus;
+
+    /**
+     * Pin the Wine plugin host's audio thread to the CPU core the host's audio
+     * thread is running on. Like the realtime scheduling priority, this is
+     * synchronized whenever the host's audio thread changes cores. Since the host's audio thread is
+     * blocked while the plugin processes audio, this keeps the data involved
+     * in the processing cycle in the same core's caches. If
+     * `audio_thread_cpus` is also set, then only cores from that list will be
+     * followed. This has no effect when `audio_wait_spin_us` is set, since the
+     * host's audio thread would then be competing for that same core.
+     *
+     * @see follows_host_audio_thread_cpu
+     */
+    bool audio_thread_follow_host_cpu = false;
+
+    /**
+     * Keep the Wine plugin host's audio thread and the shared memory audio
+     * buffers on the NUMA node the host's audio thread is running on. The
+     * buffers' memory is bound to that node through `mbind()`, and unless the
+     * thread is already pinned to a single core by
+     * `audio_thread_follow_host_cpu` or `audio_thread_host_mapping` the audio
+     * thread is restricted to that node's cores. Like the realtime priority,
+     * this is synchronized whenever the host's audio thread moves to another
+     * node. This avoids cross-node memory traffic on multi-socket systems.
+     *
+     * @see AudioShmBuffer::bind_to_numa_node
+     */
+    bool audio_thread_follow_host_numa_node = false;
+
+    /**
+     * Give every one of the host's audio threads a CPU core of its own, and
+     * pin the Wine plugin host's audio threads to the core belonging to the
+     * host thread that's processing them. This is shared between all plugins
+     * in a plugin group, so all instances processed by the same host thread
+     * share a core and the number of cores in use mirrors the host's audio
+     * thread count. Cores are taken from `audio_thread_cpus` if that is set.
+     * This takes precedence over `audio_thread_follow_host_cpu`.
+     *
+     * @see HostAudioThreadMap
+     */
+    bool audio_thread_host_mapping = false;
+
+    /**
+     * Use `SCHED_DEADLINE` instead of `SCHED_FIFO` for the Wine plugin host's
+     * audio threads. The period and deadline are set to the duration of a
+     * single block based on the block size and sample rate passed to the
+     * plugin, and the runtime budget to half of that. This lets the kernel
+     * perform admission control for the audio threads. When the kernel refuses
+     * this, for instance because the user lacks the privileges for it or
+     * because `audio_thread_cpus` has restricted the threads' affinity, the
+     * threads stay on `SCHED_FIFO`.
+     *
+     * @see set_deadline_scheduling
+     */
+    bool audio_thread_sched_deadline = false;
+
+    /**
+     * The number of microseconds the native plugin's audio thread should
+     * busy-wait for the Wine plugin host to finish processing a block of audio
+     * before it goes to sleep on the futex. With small buffer sizes the time it
+     * takes for the scheduler to wake up the audio thread again can be a large
+     * part of the total round trip, so spinning for a short while can avoid
+     * this. This only has an effect when `futex_signalling` is also enabled,
+     * since it polls the response counter in the shared memory object.
+     *
+     * @see AudioShmBuffer::spin_for_response
+     */
+    std::optional<uint32_t> audio_wait_spin_us;
+
     /**
      * If enabled, we'll redirect the plugin's STDOUT and STDERR streams to this
      * file instead of using pipes to intersperse it with yabridge's other
@@ -112,6 +280,26 @@ class Configuration {
      */
     bool editor_force_dnd = false;
 
+    /**
+     * The refresh rate to use for a plugin's editor while the editor's window
+     * is fully obscured by other windows or when it has been unmapped. When
+     * this is not set, the editor keeps running at `frame_rate`.
+     *
+     * @relates obscured_editor_idle_interval
+     */
+    std::optional<float> editor_obscured_frame_rate;
+
+    /**
+     * Create a hidden Wine window for the plugin's editor as soon as the
+     * plugin gets loaded, and create a new one again after the editor gets
+     * closed. Opening the editor then doesn't have to wait for Wine to create
+     * the window. This is opt-in since it means that plugins whose editors
+     * never get opened will still open an X11 connection and a window.
+     *
+     * @see Editor::precreate_window
+     */
+    bool editor_precreate_window = false;
+
     /**
      * Use XEmbed instead of yabridge's normal editor embedding method. Wine's
      * XEmbed support is not very polished yet and tends to lead to rendering
@@ -120,6 +308,18 @@ class Configuration {
      */
     bool editor_xembed = false;
 
+    /**
+     * Let the Wine plugin host's event loop gradually slow down while no plugin
+     * editors are open and no Win32 messages are coming in, down to
+     * `max_idle_event_loop_interval`. The loop returns to `frame_rate` as soon
+     * as an editor gets opened or when there are messages to handle. In a
+     * plugin group this is only done when every plugin in the group has
+     * enabled this option.
+     *
+     * @see MainContext::async_handle_events
+     */
+    bool event_loop_idle_backoff = false;
+
     /**
      * The number of times per second we'll handle the event loop. In most
      * plugins this also controls the plugin editor GUI's refresh rate.
@@ -132,6 +332,113 @@ class Configuration {
      */
     std::optional<float> frame_rate;
 
+    /**
+     * Signal the end of audio processing through a futex stored in the shared
+     * audio buffers instead of by sending an acknowledgement over a socket.
+     * This saves a socket round trip every processing cycle, which adds up
+     * with small buffer sizes and many plugin instances.
+     *
+     * @see AudioShmBuffer::Config::signalling
+     */
+    bool futex_signalling = false;
+
+    /**
+     * Keep this many idle Wine host processes running per Wine prefix and
+     * architecture for individually hosted plugins. A new plugin instance will
+     * take one of those already initialized processes instead of having to
+     * wait for Wine to start up, and another process will then be launched in
+     * the background to take its place. Idle processes shut down on their own
+     * after `host_pool_idle_timeout`. Has no effect for plugin groups.
+     *
+     * @see PooledHost
+     */
+    std::optional<uint32_t> host_pool_size;
+
+    /**
+     * Back the Wine plugin host's large anonymous memory regions with
+     * transparent huge pages when possible. This can reduce TLB misses for
+     * plugins that work with large amounts of sample data, at the cost of
+     * using more memory. These huge pages can't be merged by
+     * `memory_merging`.
+     *
+     * @see advise_anonymous_memory
+     */
+    bool memory_huge_pages = false;
+
+    /**
+     * Let the kernel deduplicate identical pages in the Wine plugin host's
+     * large anonymous memory regions through kernel same-page merging (KSM).
+     * This is useful when multiple plugin groups load the same sample library,
+     * since they'd otherwise each keep their own copy of the decoded sample
+     * data in memory. KSM needs to be enabled in
+     * `/sys/kernel/mm/ksm/run` for this to have any effect.
+     *
+     * @see advise_anonymous_memory
+     */
+    bool memory_merging = false;
+
+    /**
+     * Switch the Wine plugin host's audio thread for an instance to the normal
+     * `SCHED_OTHER` scheduling policy while the host renders that instance
+     * offline, and go back to realtime scheduling once the host switches back
+     * to realtime processing. This way a bounce or background export
+     * doesn't compete with live playback, including with other plugins in
+     * the same plugin group.
+     *
+     * @see AudioThreadScheduling::set_offline
+     */
+    bool offline_render_non_realtime = false;
+
+    /**
+     * Store the plugin's parameter metadata on disk after the host first
+     * enumerates it, and use that to answer the host's parameter queries for
+     * later instances of the same plugin. For VST3 plugins this covers
+     * `IEditController::getParameterInfo()`, and for VST2 plugins this covers
+     * the parameter names and labels cached by the `vst2_parameter_info_cache`
+     * option, which is required for this to have any effect there.
+     *
+     * @see ParameterMetadataCache
+     */
+    bool parameter_metadata_cache = false;
+
+    /**
+     * Prefault and lock the shared memory audio buffers into memory on both
+     * sides after they have been set up or resized, and back large buffers by
+     * transparent huge pages when possible. This avoids page faults on the
+     * audio thread at the cost of a slightly slower `effMainsChanged()` or
+     * `IAudioProcessor::setActive()`.
+     *
+     * @see AudioShmBuffer::Config::pinned
+     */
+    bool pin_audio_buffers = false;
+
+    /**
+     * A named set of performance options to enable at once. Options set
+     * explicitly in the same section take precedence over the ones set by the
+     * profile. The supported profiles are:
+     *
+     * - `low-latency`: `futex_signalling`, `audio_wait_spin_us = 50`, and
+     *   `vst3_edit_coalescing_ms = 10`. CPU affinity is not part of this
+     *   profile since following the host's audio thread has no effect while
+     *   spinning.
+     * - `mixing`: `vst2_pipelined_processing` and `event_loop_idle_backoff`.
+     * - `render`: `offline_render_non_realtime` and
+     *   `vst3_fast_offline_processing`.
+     */
+    std::optional<std::string> profile;
+
+    /**
+     * Remember the speaker arrangements a plugin has rejected through
+     * `effSetSpeakerArrangement()` or `IAudioProcessor::setBusArrangements()`
+     * for all instances of that plugin, and the arrangements an instance has
+     * last accepted. Hosts that try many layouts while activating a plugin
+     * then get repeated attempts answered without a round trip to the Wine
+     * plugin host. For VST2 plugins this also caches the result of
+     * `effGetSpeakerArrangement()` until the plugin accepts a new arrangement
+     * or calls `audioMasterIOChanged()`.
+     */
+    bool speaker_arrangement_cache = false;
+
     /**
      * When this option is enabled, we'll report some random other string
      * instead of the actual name of the host when the plugin queries it. This
@@ -141,6 +448,206 @@ class Configuration {
      */
     bool hide_daw = false;
 
+    /**
+     * Queue the `audioMasterAutomate()`, `audioMasterBeginEdit()`, and
+     * `audioMasterEndEdit()` callbacks a VST2 plugin makes from the Wine plugin
+     * host's audio thread instead of sending them to the host right away. The
+     * queued callbacks are sent back together with the processed audio, and
+     * the native plugin then makes these callbacks from the host's audio
+     * thread. This prevents the Wine audio thread from having to wait for a
+     * round trip to the host for every automation change during audio
+     * processing.
+     *
+     * @see Vst2ProcessResponse
+     */
+    bool vst2_async_automation = false;
+
+    /**
+     * Hold on to the MIDI events the host passes to a VST2 plugin through
+     * `effProcessEvents()` on the native side, and send them to the Wine plugin
+     * host together with the next processing request. This saves a socket
+     * round trip every processing cycle for instruments that receive MIDI.
+     * Pending events are sent through `effProcessEvents()` as usual before any
+     * other dispatcher call that has to go to the Wine plugin host, so the
+     * order of events is preserved, and large batches or batches containing
+     * SysEx data are never held back.
+     *
+     * @see Vst2BatchedProcessRequest
+     */
+    bool vst2_batch_midi_events = false;
+
+    /**
+     * Keep the last chunk returned by `effGetChunk()` on the native plugin side
+     * for VST2 plugins, and let the Wine plugin host only send the chunk data
+     * back when it differs from that cached chunk. Hosts that take periodic
+     * snapshots of every plugin's state would otherwise transfer the full
+     * chunk every time, even if nothing has changed.
+     *
+     * @see WantsChunkBuffer::cached_hash
+     */
+    bool vst2_chunk_cache = false;
+
+    /**
+     * Check whether a VST2 plugin's input channels only contain silence before
+     * copying them to the shared memory audio buffers. VST2 has no equivalent
+     * of VST3's silence flags, so this detection takes their place. Silent
+     * channels are cleared once and then skipped until they contain audio
+     * again. This relies on the plugin not writing to its input buffers, which
+     * is why this is opt-in.
+     */
+    bool vst2_detect_silence = false;
+
+    /**
+     * Coalesce `audioMasterIOChanged()` calls made by VST2 plugins. Instead of
+     * passing every call through to the host immediately, the Wine plugin host
+     * will send a single call to the host on the next main loop tick. Some
+     * plugins call this every time a parameter changes their latency, and the
+     * host would recalculate its latency compensation for every call. The
+     * plugin always gets a return value of 1.
+     */
+    bool vst2_coalesce_io_changed = false;
+
+    /**
+     * The number of batches of MIDI events a VST2 plugin can send to the host
+     * during a single processing cycle. Plugins almost always send at most one
+     * batch per cycle, but plugins with multiple internal processing stages may
+     * send more. Events that don't fit are dropped and counted. If not set,
+     * this defaults to 8.
+     */
+    std::optional<uint32_t> vst2_midi_output_queue_size;
+
+    /**
+     * Answer `getParameter()` calls for VST2 plugins from a cache on the native
+     * plugin side. Values reported by the plugin through `audioMasterAutomate()`
+     * update the cache directly, while `setParameter()` calls and program or
+     * chunk changes invalidate it. Cached values older than this many
+     * milliseconds are fetched from the plugin again, since plugins are not
+     * required to report every parameter change made from their own editor.
+     */
+    std::optional<uint32_t> vst2_parameter_cache_ms;
+
+    /**
+     * Fetch the names, labels, and display strings for a whole range of VST2
+     * parameters at once when the host asks for one of them, and keep the
+     * names and labels around on the native plugin side. Display strings from
+     * such a batch are only used once and only for a short while, since they
+     * change with the parameter's value. Program and chunk changes,
+     * `audioMasterUpdateDisplay()`, and `audioMasterIOChanged()` drop the
+     * cached names and labels.
+     */
+    bool vst2_parameter_info_cache = false;
+
+    /**
+     * Fetch the names of all of a VST2 plugin's programs at once the first
+     * time the host asks for one of them, and answer `effGetProgramName()` and
+     * `effGetProgramNameIndexed()` from that list on the native plugin side.
+     * Preset browsers otherwise need a round trip for every program.
+     * `effGetProgramName()` is only answered from the cache after the host has
+     * selected a program with `effSetProgram()`. Chunk loads,
+     * `audioMasterUpdateDisplay()`, and `audioMasterIOChanged()` drop the
+     * cached names.
+     */
+    bool vst2_program_name_cache = false;
+
+    /**
+     * Let VST2 plugins process audio in parallel with the host by adding one
+     * block of latency. `processReplacing()` will return the output from the
+     * previous processing cycle immediately after handing the current block
+     * to the Wine plugin host, instead of waiting for it to finish processing.
+     * The added latency is reported through `AEffect::initialDelay`. This
+     * disables the `yabridgeVendorSpecificAudioBuffers` extension, since the
+     * host would otherwise read output buffers the plugin is still writing to.
+     */
+    bool vst2_pipelined_processing = false;
+
+    /**
+     * Store a snapshot of the VST2 plugin's `AEffect` struct together with the
+     * results of `effGetEffectName()`, `effGetVendorString()`, and the other
+     * opcodes memoized by `Vst2PluginBridge::dispatch_result_cache_` on disk
+     * when the plugin gets closed. Later instances of the same plugin library
+     * are then created from that snapshot without starting Wine, and the Wine
+     * plugin host only gets started once the host does something that can't
+     * be answered from the snapshot. This makes plugin scans that only read
+     * the plugin's metadata practically free.
+     *
+     * @see ParameterMetadataCache
+     */
+    bool vst2_scan_cache = false;
+
+    /**
+     * Send VST3 callbacks that only return a status code, like
+     * `IComponentHandler::restartComponent()` and
+     * `IComponentHandler2::setDirty()`, to the host from a background thread
+     * without waiting for the host to handle them. The plugin then immediately
+     * gets `kResultOk`. This frees up the plugin's GUI thread sooner, but the
+     * host may now handle these callbacks after later synchronous callbacks.
+     */
+    bool vst3_async_callbacks = false;
+
+    /**
+     * Drop automation points from the parameter change queues the host passes
+     * to VST3 plugins that lie within this distance of the line between the
+     * surrounding points. Some hosts send a point for every few samples, and
+     * the cost of sending those to the Wine plugin host grows with every
+     * point. The first and last points of every queue are always kept. This is
+     * in terms of normalized parameter values.
+     */
+    std::optional<float> vst3_automation_thinning;
+
+    /**
+     * Handle VST3 control requests that are normally run on the GUI thread for
+     * compatibility reasons, but that don't need the Win32 message loop
+     * themselves, directly on the control socket's thread instead. This lets
+     * `getState()`, `setState()`, connection point messages, and channel
+     * context information skip the queue behind the plugin's editor. Some
+     * plugins, like the VST3 version of Algonaut Atlas, Melodyne, and
+     * FabFilter's plugins, misbehave when these are not run on the GUI thread.
+     *
+     * @see gui_thread_agnostic_request
+     */
+    bool vst3_control_off_gui_thread = false;
+
+    /**
+     * Coalesce `IComponentHandler::performEdit()` calls made by VST3 plugins
+     * during this many milliseconds before sending them to the host in a single
+     * batch. Only the last value for each parameter gets sent, and the plugin
+     * no longer has to wait for the host to handle each edit. Pending edits are
+     * always sent before `beginEdit()`, `endEdit()`, and
+     * `restartComponent()` so their order is preserved.
+     */
+    std::optional<uint32_t> vst3_edit_coalescing_ms;
+
+    /**
+     * Call `IAudioProcessor::process()` directly from the audio thread when the
+     * host renders offline. By default yabridge runs offline processing on the
+     * Wine plugin host's main thread because IK Multimedia's T-RackS 5 hangs
+     * otherwise, but that adds a trip through the main event loop to every
+     * block during a bounce. Plugins that don't have this problem can opt out
+     * of that workaround with this option.
+     */
+    bool vst3_fast_offline_processing = false;
+
+    /**
+     * Only call `getState()` for VST3 plugins directly on the control socket's
+     * thread instead of on the GUI thread. This is a narrower version of
+     * `vst3_control_off_gui_thread` for plugins that can safely save their
+     * state from any thread but that need `setState()` to be called from the
+     * GUI thread. Hosts often save every plugin's state while autosaving, and
+     * large states would otherwise block the event loop for every plugin in
+     * the same plugin group.
+     */
+    bool vst3_get_state_off_gui_thread = false;
+
+    /**
+     * Don't spawn the dedicated `IAudioProcessor`/`IComponent` thread and
+     * socket for a VST3 plugin instance until the host makes its first call to
+     * one of those interfaces. Hosts often create plugin instances only to
+     * query their classes or to load and save their state, and in large
+     * projects every one of those instances would otherwise keep a realtime
+     * Wine thread around.
+     */
+    bool vst3_lazy_audio_threads = false;
+
     /**
      * Disable `IPlugViewContentScaleSupport::setContentScaleFactor()`. Wine
      * does not properly implement fractional DPI scaling, so without this
@@ -152,6 +659,26 @@ class Configuration {
      */
     bool vst3_no_scaling = false;
 
+    /**
+     * Snap the coordinates passed to `IParameterFinder::findParameter()` to a
+     * coarse grid, and answer repeated queries for the same grid cell from a
+     * short-lived cache. Some hosts call this function on every mouse move
+     * over the editor, and every call would otherwise be a round trip to the
+     * Wine plugin host's GUI thread.
+     */
+    bool vst3_parameter_finder_cache = false;
+
+    /**
+     * Keep a mirror of a VST3 plugin's normalized parameter values on the
+     * native plugin side, and answer `IEditController::getParamNormalized()`
+     * from that mirror. The mirror is populated in a single request, kept up
+     * to date through `IComponentHandler::performEdit()` callbacks, and
+     * refetched after the plugin's state changes or after the plugin calls
+     * `IComponentHandler::restartComponent()`. This is opt-in because plugins
+     * are not strictly required to report every parameter change.
+     */
+    bool vst3_parameter_value_cache = false;
+
     /**
      * If a merged bundle contains both the 64-bit and the 32-bit versions of a
      * Windows VST3 plugin (in the `x86_64-win` and the `x86-win` directories),
@@ -161,6 +688,61 @@ class Configuration {
      */
     bool vst3_prefer_32bit = false;
 
+    /**
+     * Have the Wine plugin host query a VST3 plugin object's bus counts, bus
+     * information, parameter information, and process context requirements
+     * right after `IPluginBase::initialize()`, and send those back as part of
+     * the response. Hosts ask for all of this right after initializing a
+     * plugin, and with this enabled those questions can be answered from the
+     * native plugin's caches instead of requiring a round trip each.
+     */
+    bool vst3_prefetch_instance_info = false;
+
+    /**
+     * Collect the `IComponentHandler::restartComponent()` calls a VST3 plugin
+     * makes during this many milliseconds and send them to the host as a
+     * single call with all of their flags combined. Some plugins announce a
+     * latency or parameter value change many times in a row while loading a
+     * preset, and the host will query the plugin's bus, latency, and
+     * parameter information again after every call. The plugin immediately
+     * gets `kResultOk`.
+     */
+    std::optional<uint32_t> vst3_restart_coalescing_ms;
+
+    /**
+     * Share the bus counts, bus information, speaker arrangements, and latency
+     * and tail lengths reported by a VST3 plugin between all instances of the
+     * same plugin class. When the host creates dozens of instances of the same
+     * plugin, only the first instance will have to ask the Wine plugin host for
+     * this information. Instances with different bus arrangements don't share
+     * their information, and everything gets dropped as soon as any instance
+     * announces a latency or IO change through
+     * `IComponentHandler::restartComponent()`. This is opt-in because the
+     * latency of some plugins depends on their state.
+     */
+    bool vst3_shared_bus_cache = false;
+
+    /**
+     * Don't copy VST3 input channels the host marked as silent through
+     * `AudioBusBuffers::silenceFlags` to the shared memory audio buffers.
+     * Those channels are cleared once and then skipped until they contain
+     * audio again. Like `vst2_detect_silence` this relies on the plugin not
+     * writing to its input buffers, which VST3 plugins processing in place may
+     * still do, so this is opt-in.
+     */
+    bool vst3_skip_silent_inputs = false;
+
+    /**
+     * Start a persistent wineserver for the plugin's Wine prefix before
+     * launching the Wine plugin host, which keeps running for this many seconds
+     * after the last Wine process in the prefix has exited. Otherwise the
+     * wineserver shuts down almost immediately, and the next plugin that gets
+     * loaded in that prefix will have to wait for Wine to start it again.
+     *
+     * @see PluginInfo::start_persistent_wineserver
+     */
+    std::optional<uint32_t> wineserver_persistence;
+
     /**
      * The path to the configuration file that was parsed.
      */
@@ -190,21 +772,100 @@ class Configuration {
      */
     std::chrono::steady_clock::duration event_loop_interval() const noexcept;
 
+    /**
+     * The delay between an editor's X11 event handling and `effEditIdle` calls
+     * while the editor is obscured. This is based on
+     * `editor_obscured_frame_rate`, and it will be a nullopt if that option has
+     * not been set.
+     */
+    std::optional<std::chrono::steady_clock::duration>
+    obscured_editor_idle_interval() const noexcept;
+
+    /**
+     * Whether the native plugin should send the CPU core the host's audio
+     * thread is running on to the Wine plugin host, based on
+     * `audio_thread_follow_host_cpu`, `audio_thread_host_mapping`, and
+     * `audio_wait_spin_us`.
+     */
+    bool follows_host_audio_thread_cpu() const noexcept;
+
     template <typename S>
     void serialize(S& s) {
         s.ext(group, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.text1b(v, 4096); });
+        s.value1b(group_parallel_loading);
+        s.value1b(group_module_cache);
 
+        s.ext(audio_buffer_headroom, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.ext(audio_buffer_idle_release_s, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(audio_buffer_reclaim);
+        s.ext(audio_deadline_warning, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.container4b(audio_thread_cpus, 1024);
+        s.value1b(audio_thread_follow_host_cpu);
+        s.value1b(audio_thread_follow_host_numa_node);
+        s.value1b(audio_thread_host_mapping);
+        s.value1b(audio_thread_sched_deadline);
+        s.ext(audio_wait_spin_us, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
         s.ext(disable_pipes, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.ext(v, bitsery::ext::GhcPath{}); });
         s.value1b(editor_coordinate_hack);
         s.value1b(editor_force_dnd);
+        s.ext(editor_obscured_frame_rate, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(editor_precreate_window);
         s.value1b(editor_xembed);
+        s.value1b(event_loop_idle_backoff);
         s.ext(frame_rate, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(futex_signalling);
+        s.ext(host_pool_size, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
         s.value1b(hide_daw);
+        s.value1b(memory_huge_pages);
+        s.value1b(memory_merging);
+        s.value1b(offline_render_non_realtime);
+        s.value1b(parameter_metadata_cache);
+        s.value1b(pin_audio_buffers);
+        s.ext(profile, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.text1b(v, 4096); });
+        s.value1b(speaker_arrangement_cache);
+        s.value1b(vst2_async_automation);
+        s.value1b(vst2_batch_midi_events);
+        s.value1b(vst2_chunk_cache);
+        s.value1b(vst2_detect_silence);
+        s.value1b(vst2_coalesce_io_changed);
+        s.ext(vst2_midi_output_queue_size, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.ext(vst2_parameter_cache_ms, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(vst2_parameter_info_cache);
+        s.value1b(vst2_pipelined_processing);
+        s.value1b(vst2_program_name_cache);
+        s.value1b(vst2_scan_cache);
+        s.value1b(vst3_async_callbacks);
+        s.ext(vst3_automation_thinning, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(vst3_control_off_gui_thread);
+        s.ext(vst3_edit_coalescing_ms, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(vst3_fast_offline_processing);
+        s.value1b(vst3_get_state_off_gui_thread);
+        s.value1b(vst3_lazy_audio_threads);
         s.value1b(vst3_no_scaling);
+        s.value1b(vst3_parameter_finder_cache);
+        s.value1b(vst3_parameter_value_cache);
         s.value1b(vst3_prefer_32bit);
+        s.value1b(vst3_prefetch_instance_info);
+        s.ext(vst3_restart_coalescing_ms, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(vst3_shared_bus_cache);
+        s.value1b(vst3_skip_silent_inputs);
+        s.ext(wineserver_persistence, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
 
         s.ext(matched_file, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.ext(v, bitsery::ext::GhcPath{}); });
@@ -216,4 +877,16 @@ class Configuration {
         s.container(unknown_options, 1024,
                     [](S& s, auto& v) { s.text1b(v, 4096); });
     }
+
+   private:
+    /**
+     * Load the settings from the first section in the configuration file for
+     * which `matches` returns true when called with the section's key. This
+     * implements both the public constructor and `reload()`.
+     *
+     * @throw toml::parsing_error If the file could not be parsed.
+     */
+    Configuration(
+        const ghc::filesystem::path& config_path,
+        const std::function<bool(const std::string& pattern)>& matches);
 };
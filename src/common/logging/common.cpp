@@ -16,12 +16,24 @@
 
 #include "common.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdio>
 #include <ctime>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
 
+#ifndef WITHOUT_ASIO
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#endif  // WITHOUT_ASIO
+
 /**
  * The environment variable indicating whether to log to a file. Will log to
  * STDERR if not specified.
@@ -41,6 +53,281 @@ constexpr char logging_verbosity_environment_variable[] =
  */
 constexpr char editor_tracing_flag[] = "+editor";
 
+/**
+ * Write the current local time as `HH:MM:SS.uuuuuu ` to `buffer`, and return
+ * the number of characters written.
+ */
+size_t format_timestamp(std::array<char, 32>& buffer) noexcept;
+
+#ifndef WITHOUT_ASIO
+/**
+ * The number of log messages every thread can have queued up before new
+ * messages get dropped.
+ */
+constexpr size_t log_ring_capacity = 128;
+
+/**
+ * The maximum length of a single queued log message, including the trailing
+ * newline. Longer messages get truncated.
+ */
+constexpr size_t log_record_size = 2048;
+
+/**
+ * How often the writer thread writes queued log messages to their streams.
+ */
+constexpr std::chrono::milliseconds log_writer_interval(10);
+
+namespace {
+
+/**
+ * A single formatted log message waiting to be written to `stream`.
+ */
+struct LogRecord {
+    std::shared_ptr<std::ostream> stream;
+    size_t length;
+    std::array<char, log_record_size> text;
+};
+
+/**
+ * A single producer single consumer ring buffer of log messages. Every thread
+ * that logs at the `most_events` and `all_events` verbosity levels gets one of
+ * these, and the `LogWriter` is the only consumer. Pushing a message never
+ * blocks, so the audio threads can log their processing calls without having
+ * to wait for a slow pipe or file.
+ */
+struct LogRing {
+    /**
+     * Copy the message to the ring. This is only called from the thread that
+     * owns this ring.
+     *
+     * @return False if the ring was full and the message was not copied.
+     */
+    bool try_push(const std::shared_ptr<std::ostream>& stream,
+                  const std::string& message) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= log_ring_capacity) {
+            return false;
+        }
+
+        LogRecord& record = records_[head % log_ring_capacity];
+        record.stream = stream;
+        record.length = std::min(message.size(), log_record_size);
+        std::memcpy(record.text.data(), message.data(), record.length);
+        if (record.length < message.size()) {
+            record.text[log_record_size - 1] = '\n';
+        }
+
+        head_.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Count a message that didn't fit in the ring. A warning is written the
+     * next time the ring gets drained.
+     */
+    void drop() noexcept { dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * Write all messages in the ring to their streams. The streams are not
+     * flushed here, but every stream that has been written to is added to
+     * `written_streams`. This is only called while holding
+     * `LogWriter::rings_mutex_`.
+     *
+     * @return Whether the ring was empty.
+     */
+    bool drain(std::vector<std::shared_ptr<std::ostream>>& written_streams) {
+        const size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        const bool was_empty = tail == head;
+        for (; tail != head; tail++) {
+            LogRecord& record = records_[tail % log_ring_capacity];
+            record.stream->write(record.text.data(),
+                                 static_cast<std::streamsize>(record.length));
+            // There's almost always only a single stream
+            if (std::find(written_streams.begin(), written_streams.end(),
+                          record.stream) == written_streams.end()) {
+                written_streams.push_back(std::move(record.stream));
+            }
+            record.stream.reset();
+
+            tail_.store(tail + 1, std::memory_order_release);
+        }
+
+        if (const size_t dropped =
+                dropped_.exchange(0, std::memory_order_relaxed);
+            dropped > 0) {
+            std::cerr << "WARNING: Dropped " << dropped
+                      << " log messages because they were logged faster than "
+                         "they could be written"
+                      << std::endl;
+        }
+
+        return was_empty;
+    }
+
+   private:
+    std::array<LogRecord, log_ring_capacity> records_;
+    std::atomic_size_t head_ = 0;
+    std::atomic_size_t tail_ = 0;
+    std::atomic_size_t dropped_ = 0;
+};
+
+/**
+ * Set once the `LogWriter` has been created, so `Logger::flush()` doesn't have
+ * to create it.
+ */
+std::atomic_bool log_writer_created = false;
+
+/**
+ * Owns the per-thread `LogRing`s and the low priority thread that writes
+ * their messages. This is used at the `most_events` and `all_events` verbosity
+ * levels, since those can log thousands of messages in a short burst, and the
+ * audio threads log every processing call at the `all_events` level. The
+ * messages from all rings are written in a single batch, after which every
+ * stream is flushed once.
+ *
+ * This uses a regular pthread on the Wine side as well, since the writer
+ * thread never calls any Win32 functions.
+ */
+class LogWriter {
+   public:
+    LogWriter()
+        : writer_thread_([this](std::stop_token stop_token) {
+              // This thread may have been spawned from an audio thread, but
+              // writing log messages should never compete with audio
+              // processing
+              set_realtime_priority(false);
+              pthread_setname_np(pthread_self(), "log-writer");
+
+              while (!stop_token.stop_requested()) {
+                  std::this_thread::sleep_for(log_writer_interval);
+                  drain_all();
+              }
+
+              drain_all();
+          }) {}
+
+    static LogWriter& get() {
+        static LogWriter instance;
+        log_writer_created.store(true, std::memory_order_release);
+
+        return instance;
+    }
+
+    /**
+     * Queue a message for the writer thread. If the calling thread's ring is
+     * full, then `may_block` decides whether the message gets dropped, or
+     * whether the calling thread writes out all queued messages itself first.
+     * The audio threads should never block, but the burst of messages logged
+     * during a plugin scan at the `most_events` level should not get lost.
+     */
+    void push(const std::shared_ptr<std::ostream>& stream,
+              const std::string& message,
+              bool may_block) {
+        LogRing& ring = thread_ring();
+        if (ring.try_push(stream, message)) [[likely]] {
+            return;
+        }
+
+        if (may_block) {
+            drain_all();
+            if (ring.try_push(stream, message)) {
+                return;
+            }
+        }
+
+        ring.drop();
+    }
+
+    /**
+     * Get the calling thread's ring, creating and registering it the first
+     * time a thread logs something.
+     */
+    LogRing& thread_ring() {
+        thread_local std::shared_ptr<LogRing> ring = nullptr;
+        if (!ring) [[unlikely]] {
+            ring = std::make_shared<LogRing>();
+
+            std::lock_guard lock(rings_mutex_);
+            rings_.push_back(ring);
+        }
+
+        return *ring;
+    }
+
+    /**
+     * Write and flush all queued messages. This can be called from any thread,
+     * since the rings are only ever drained while holding `rings_mutex_`.
+     */
+    void drain_all() {
+        std::lock_guard lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end();) {
+            // Rings for threads that have exited can be removed once they have
+            // been emptied
+            if ((*it)->drain(written_streams_) && it->use_count() == 1) {
+                it = rings_.erase(it);
+            } else {
+                it++;
+            }
+        }
+
+        for (const auto& stream : written_streams_) {
+            stream->flush();
+        }
+        written_streams_.clear();
+    }
+
+   private:
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::mutex rings_mutex_;
+
+    /**
+     * The streams written to during `drain_all()`, so every stream only needs
+     * to be flushed once per batch. Reused to avoid reallocations.
+     */
+    std::vector<std::shared_ptr<std::ostream>> written_streams_;
+
+    std::jthread writer_thread_;
+};
+
+}  // namespace
+#endif  // WITHOUT_ASIO
+
+LogStream& LogStream::operator<<(double value) {
+    // This is the same as the default `std::ostream` formatting for floating
+    // point numbers
+    std::array<char, 32> formatted;
+    const int length =
+        std::snprintf(formatted.data(), formatted.size(), "%g", value);
+    if (length > 0) {
+        buffer_.append(formatted.data(),
+                       std::min(static_cast<size_t>(length),
+                                formatted.size() - 1));
+    }
+
+    return *this;
+}
+
+LogStream& LogStream::operator<<(const void* pointer) {
+    if (!pointer) {
+        // Also matches `std::ostream`, which doesn't print `0x0`
+        buffer_.push_back('0');
+        return *this;
+    }
+
+    std::array<char, 24> formatted;
+    const int length =
+        std::snprintf(formatted.data(), formatted.size(), "%p", pointer);
+    if (length > 0) {
+        buffer_.append(formatted.data(),
+                       std::min(static_cast<size_t>(length),
+                                formatted.size() - 1));
+    }
+
+    return *this;
+}
+
 Logger::Logger(std::shared_ptr<std::ostream> stream,
                Verbosity verbosity_level,
                bool editor_tracing,
@@ -120,28 +407,86 @@ Logger Logger::create_exception_logger() {
 }
 
 void Logger::log(const std::string& message) {
-    std::ostringstream formatted_message;
+    std::array<char, 32> timestamp{};
+    const size_t timestamp_length =
+        prefix_timestamp_ ? format_timestamp(timestamp) : 0;
+
+    // The linefeed is part of the same string to prevent two messages from
+    // being put on the same row
+    std::string formatted_message;
+    formatted_message.reserve(timestamp_length + prefix_.size() +
+                              message.size() + 1);
+    formatted_message.append(timestamp.data(), timestamp_length);
+    formatted_message.append(prefix_);
+    formatted_message.append(message);
+    formatted_message.push_back('\n');
+
+#ifndef WITHOUT_ASIO
+    // At these verbosity levels we can log thousands of messages in a short
+    // amount of time, and at the `all_events` level the audio threads log
+    // every processing call so we can't let them wait for the write to finish
+    if (verbosity_ >= Verbosity::most_events) {
+        LogWriter::get().push(stream_, formatted_message,
+                              verbosity_ < Verbosity::all_events);
+        return;
+    }
+#endif  // WITHOUT_ASIO
+
+    *stream_ << formatted_message << std::flush;
+}
 
-    if (prefix_timestamp_) {
-        const auto current_time = std::chrono::system_clock::now();
+void Logger::flush() {
+#ifndef WITHOUT_ASIO
+    if (log_writer_created.load(std::memory_order_acquire)) {
+        LogWriter::get().drain_all();
+    }
+#endif  // WITHOUT_ASIO
+}
+
+size_t format_timestamp(std::array<char, 32>& buffer) noexcept {
+    // Converting the time to local time for every message is relatively
+    // expensive, and `localtime_r()` takes a global lock. Instead we'll do
+    // that once, and then use the monotonic clock for the rest. This does mean
+    // that the timestamps won't follow daylight saving time changes and system
+    // clock adjustments made while the plugin is running.
+    struct ClockBase {
+        std::chrono::steady_clock::time_point steady;
+        std::chrono::microseconds since_midnight;
+    };
+    static const ClockBase base = []() {
+        const auto steady_now = std::chrono::steady_clock::now();
+        const auto system_now = std::chrono::system_clock::now();
         const time_t timestamp =
-            std::chrono::system_clock::to_time_t(current_time);
+            std::chrono::system_clock::to_time_t(system_now);
 
-        // How did C++ manage to get time formatting libraries without a way to
-        // actually get a timestamp in a threadsafe way? `localtime_r` in C++ is
-        // not portable but luckily we only have to support GCC anyway.
+        // `localtime_r` in C++ is not portable but luckily we only have to
+        // support GCC anyway
         std::tm tm;
         localtime_r(&timestamp, &tm);
 
-        formatted_message << std::put_time(&tm, "%T") << " ";
-    }
+        return ClockBase{
+            .steady = steady_now,
+            .since_midnight =
+                std::chrono::hours(tm.tm_hour) +
+                std::chrono::minutes(tm.tm_min) +
+                std::chrono::seconds(tm.tm_sec) +
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    system_now - std::chrono::system_clock::from_time_t(
+                                     timestamp))};
+    }();
 
-    formatted_message << prefix_;
-    formatted_message << message;
-    // Flushing a stringstream doesn't do anything, but we need to put a
-    // linefeed in this string stream rather writing it sprightly to the output
-    // stream to prevent two messages from being put on the same row
-    formatted_message << std::endl;
+    const uint64_t us = static_cast<uint64_t>(
+        (base.since_midnight +
+         std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - base.steady))
+            .count());
+    const int length = std::snprintf(
+        buffer.data(), buffer.size(), "%02u:%02u:%02u.%06u ",
+        static_cast<unsigned int>((us / 3'600'000'000) % 24),
+        static_cast<unsigned int>((us / 60'000'000) % 60),
+        static_cast<unsigned int>((us / 1'000'000) % 60),
+        static_cast<unsigned int>(us % 1'000'000));
 
-    *stream_ << formatted_message.str() << std::flush;
+    return length > 0 ? std::min(static_cast<size_t>(length), buffer.size() - 1)
+                      : 0;
 }
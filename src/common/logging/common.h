@@ -16,9 +16,16 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <charconv>
+#include <concepts>
 #include <memory>
 #include <optional>
 #include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 // The chainloader needs to be able to use the logger without pulling in a bunch
 // of Boost things
@@ -33,6 +40,85 @@
 
 #include "../utils.h"
 
+/**
+ * Whether the request and response logging for the `most_events` and
+ * `all_events` verbosity levels has been compiled in. Builds configured with
+ * `-Devent-logging=false` define `WITHOUT_EVENT_LOGGING`, and the logging in
+ * the message handlers and in `Logger::log_trace()` is then removed at compile
+ * time using `if constexpr`. That way the audio processing loop does not
+ * contain any logging related branches at all.
+ */
+#ifdef WITHOUT_EVENT_LOGGING
+constexpr bool event_logging_enabled = false;
+#else
+constexpr bool event_logging_enabled = true;
+#endif
+
+/**
+ * A cheap replacement for `std::ostringstream` for building log messages.
+ * Constructing a string stream copies the global locale and every `<<`
+ * operation goes through the locale's facets, which makes formatting a single
+ * message surprisingly expensive. This appends directly to a string instead,
+ * formatting numbers with `std::to_chars()`. The output matches what a string
+ * stream with the default flags would produce, except for 8-bit integers which
+ * are printed as numbers instead of as characters.
+ *
+ * The string's capacity is kept when calling `clear()`, so a `thread_local`
+ * instance can be used to build every message on a thread without allocating.
+ */
+class LogStream {
+   public:
+    LogStream& operator<<(std::string_view text) {
+        buffer_.append(text);
+        return *this;
+    }
+    LogStream& operator<<(const char* text) {
+        buffer_.append(text);
+        return *this;
+    }
+    LogStream& operator<<(char c) {
+        buffer_.push_back(c);
+        return *this;
+    }
+    LogStream& operator<<(bool value) {
+        buffer_.push_back(value ? '1' : '0');
+        return *this;
+    }
+    template <std::integral T>
+    LogStream& operator<<(T value) {
+        std::array<char, 24> formatted;
+        const auto [end, _] = std::to_chars(
+            formatted.data(), formatted.data() + formatted.size(), value);
+        buffer_.append(formatted.data(), end);
+        return *this;
+    }
+    template <typename T>
+        requires std::is_enum_v<T>
+    LogStream& operator<<(T value) {
+        return *this << +static_cast<std::underlying_type_t<T>>(value);
+    }
+    LogStream& operator<<(double value);
+    LogStream& operator<<(const void* pointer);
+    template <size_t N>
+    LogStream& operator<<(const std::bitset<N>& bits) {
+        buffer_.append(bits.to_string());
+        return *this;
+    }
+
+    /**
+     * The message built so far.
+     */
+    inline const std::string& str() const noexcept { return buffer_; }
+
+    /**
+     * Start a new message, keeping the allocated capacity.
+     */
+    inline void clear() noexcept { buffer_.clear(); }
+
+   private:
+    std::string buffer_;
+};
+
 /**
  * Super basic logging facility meant for debugging malfunctioning VST
  * plugins. This is also used to redirect the output of the Wine process
@@ -44,6 +130,16 @@
  *   multiple threads at the same time doesn't seem to produce corrupted text if
  *   you're writing an entire string at once even though the messages may be
  *   slightly out of order.
+ *
+ * @note At the `most_events` and `all_events` verbosity levels messages are not
+ *   written directly. Every thread instead copies its formatted messages into
+ *   its own lock-free ring buffer. A low priority thread then writes those
+ *   buffers to the log in batches every few milliseconds. Without this, the
+ *   logging itself would cause xruns, and bursts of messages during plugin
+ *   scans would slow down the host. Messages from different threads may be
+ *   interleaved differently as a result, but every message still carries its
+ *   own timestamp with microsecond precision. Use `Logger::flush()` to write
+ *   everything that's still queued before terminating the process.
  */
 class Logger {
    public:
@@ -142,6 +238,14 @@ class Logger {
      */
     void log(const std::string& message);
 
+    /**
+     * Write all messages that are still queued up for the background writer
+     * thread. This happens automatically at exit, but this should be called
+     * before terminating the process in other ways. Does nothing if
+     * nothing has been queued.
+     */
+    static void flush();
+
 #ifndef WITHOUT_ASIO
     /**
      * Write output from an async pipe to the log on a line by line basis.
@@ -182,9 +286,11 @@ class Logger {
      * @param message A lambda producing a string that should be written.
      */
     template <invocable_returning<std::string> F>
-    void log_trace(F&& fn) {
-        if (verbosity_ >= Verbosity::all_events) [[unlikely]] {
-            log(fn());
+    void log_trace([[maybe_unused]] F&& fn) {
+        if constexpr (event_logging_enabled) {
+            if (verbosity_ >= Verbosity::all_events) [[unlikely]] {
+                log(fn());
+            }
         }
     }
 
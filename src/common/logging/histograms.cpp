@@ -0,0 +1,336 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "histograms.h"
+
+#include <bit>
+#include <condition_variable>
+#include <cstdlib>
+#include <sstream>
+
+#include "../utils.h"
+#include "common.h"
+
+/**
+ * The environment variable containing the interval in seconds at which the
+ * latency histograms are written to the log. Nothing gets written when this is
+ * not set.
+ */
+constexpr char latency_interval_environment_variable[] =
+    "YABRIDGE_LATENCY_INTERVAL";
+
+/**
+ * VST2 opcodes for both `dispatcher()` and `audioMaster()` stay well below
+ * this. Anything at or above this value gets recorded in the last histogram.
+ */
+constexpr size_t num_vst2_opcode_histograms = 128;
+
+using OpcodeHistograms =
+    std::array<LatencyHistogram, num_vst2_opcode_histograms>;
+
+/**
+ * Register one histogram per VST2 opcode, labelled `<label><opcode><suffix>`.
+ * Always returns true so this can be used to initialize a static.
+ */
+bool register_opcode_histograms(const OpcodeHistograms& histograms,
+                                const char* label,
+                                const char* suffix);
+
+/**
+ * The index in an `OpcodeHistograms` array for `opcode`.
+ */
+size_t opcode_histogram_index(int opcode) noexcept;
+
+/**
+ * The index of the bucket `us` microseconds falls in.
+ */
+size_t bucket_index(uint64_t us) noexcept;
+
+/**
+ * The upper bound of the bucket at `index` in microseconds. Used to report
+ * percentiles.
+ */
+uint64_t bucket_upper_bound(size_t index) noexcept;
+
+/**
+ * The logger the summaries are written to.
+ */
+Logger create_latency_logger();
+
+void LatencyHistogram::record(
+    std::chrono::steady_clock::duration duration) noexcept {
+    const uint64_t us = static_cast<uint64_t>(std::max<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count(),
+        0));
+
+    buckets_[std::min(bucket_index(us), num_buckets - 1)].fetch_add(
+        1, std::memory_order_relaxed);
+
+    uint64_t current_max = max_us_.load(std::memory_order_relaxed);
+    while (us > current_max &&
+           !max_us_.compare_exchange_weak(current_max, us,
+                                          std::memory_order_relaxed)) {
+    }
+}
+
+std::optional<LatencyHistogram::Summary> LatencyHistogram::summarize()
+    const noexcept {
+    // The buckets may still be written to while we're reading them, but being
+    // off by a couple of requests doesn't matter here
+    std::array<uint64_t, num_buckets> counts{};
+    uint64_t total = 0;
+    for (size_t i = 0; i < num_buckets; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    if (total == 0) {
+        return std::nullopt;
+    }
+
+    const auto percentile = [&](double fraction) -> uint64_t {
+        const uint64_t target = std::max<uint64_t>(
+            static_cast<uint64_t>(static_cast<double>(total) * fraction), 1);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < num_buckets; i++) {
+            seen += counts[i];
+            if (seen >= target) {
+                return bucket_upper_bound(i);
+            }
+        }
+
+        return bucket_upper_bound(num_buckets - 1);
+    };
+
+    const uint64_t max_us = max_us_.load(std::memory_order_relaxed);
+
+    return Summary{.count = total,
+                   .p50_us = std::min(percentile(0.5), max_us),
+                   .p99_us = std::min(percentile(0.99), max_us),
+                   .p999_us = std::min(percentile(0.999), max_us),
+                   .max_us = max_us};
+}
+
+LatencyHistograms& LatencyHistograms::get() {
+    static LatencyHistograms instance;
+    return instance;
+}
+
+LatencyHistograms::LatencyHistograms() {
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* interval_env = getenv(latency_interval_environment_variable);
+    if (!interval_env || interval_env[0] == '\0') {
+        return;
+    }
+
+    const double interval_seconds = std::strtod(interval_env, nullptr);
+    if (!(interval_seconds > 0.0)) {
+        return;
+    }
+
+    const auto interval =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(interval_seconds));
+
+    // NOTE: Besides being useful, logging this here makes sure that the
+    //       asynchronous log writer used at the `all_events` verbosity level
+    //       gets created before this object, so it's still alive for the final
+    //       dump in our destructor
+    create_latency_logger().log("Writing request latency histograms every " +
+                                std::string(interval_env) + " seconds");
+
+    dump_thread_ = std::jthread([this, interval](std::stop_token stop_token) {
+        // Like the logging thread, this may get spawned from an audio thread
+        set_realtime_priority(false);
+        pthread_setname_np(pthread_self(), "latency-dump");
+
+        std::mutex sleep_mutex;
+        std::condition_variable_any sleep_cv;
+        std::unique_lock sleep_lock(sleep_mutex);
+        while (!sleep_cv.wait_for(sleep_lock, stop_token, interval,
+                                  []() { return false; })) {
+            if (stop_token.stop_requested()) {
+                break;
+            }
+
+            dump();
+        }
+    });
+}
+
+LatencyHistograms::~LatencyHistograms() noexcept {
+    if (dump_thread_.joinable()) {
+        dump_thread_.request_stop();
+        dump_thread_.join();
+
+        try {
+            dump();
+        } catch (...) {
+            // Nothing we can do about this during shutdown
+        }
+    }
+}
+
+void LatencyHistograms::add(std::string label,
+                            const LatencyHistogram& histogram) {
+    std::lock_guard lock(histograms_mutex_);
+    histograms_.emplace_back(std::move(label), &histogram);
+}
+
+SocketTraffic& LatencyHistograms::socket_traffic(const std::string& channel) {
+    std::lock_guard lock(socket_traffic_mutex_);
+    for (auto& [name, traffic] : socket_traffic_) {
+        if (name == channel) {
+            return *traffic;
+        }
+    }
+
+    return *socket_traffic_
+                .emplace_back(channel, std::make_unique<SocketTraffic>())
+                .second;
+}
+
+void LatencyHistograms::dump() {
+    Logger logger = create_latency_logger();
+
+    for_each_summary([&](const std::string& label,
+                         const LatencyHistogram::Summary& summary) {
+        std::ostringstream message;
+        message << label << ": n = " << summary.count
+                << ", p50 = " << summary.p50_us
+                << " us, p99 = " << summary.p99_us
+                << " us, p99.9 = " << summary.p999_us
+                << " us, max = " << summary.max_us << " us";
+
+        logger.log(message.str());
+    });
+
+    for_each_socket_traffic([&](const std::string& channel,
+                                const SocketTraffic& traffic) {
+        const auto format_counters = [](std::ostringstream& message,
+                                        const SocketTrafficCounters& counters) {
+            message << counters.messages_sent.load(std::memory_order_relaxed)
+                    << " sent ("
+                    << counters.bytes_sent.load(std::memory_order_relaxed)
+                    << " bytes), "
+                    << counters.messages_received.load(
+                           std::memory_order_relaxed)
+                    << " received ("
+                    << counters.bytes_received.load(std::memory_order_relaxed)
+                    << " bytes)";
+        };
+
+        std::ostringstream message;
+        message << "socket " << channel << ": primary ";
+        format_counters(message, traffic.primary);
+        message << ", secondary ";
+        format_counters(message, traffic.secondary);
+
+        logger.log(message.str());
+    });
+}
+
+LatencyHistogram& vst2_event_histogram(int opcode, bool handling) {
+    // The labels are from this process' point of view. The native plugin
+    // sends `dispatcher()` calls and handles `audioMaster()` callbacks, and the
+    // Wine plugin host does the opposite.
+#ifdef __WINE__
+    constexpr char sent_label[] = "audioMaster() opcode ";
+    constexpr char handled_label[] = "dispatcher() opcode ";
+#else
+    constexpr char sent_label[] = "dispatcher() opcode ";
+    constexpr char handled_label[] = "audioMaster() opcode ";
+#endif
+
+    static OpcodeHistograms sent_histograms;
+    static OpcodeHistograms handled_histograms;
+    static const bool registered =
+        register_opcode_histograms(sent_histograms, sent_label,
+                                   " (round trip)") &&
+        register_opcode_histograms(handled_histograms, handled_label,
+                                   " (handling)");
+    (void)registered;
+
+    const size_t index = opcode_histogram_index(opcode);
+
+    return handling ? handled_histograms[index] : sent_histograms[index];
+}
+
+LatencyHistogram& vst2_process_callback_histogram(int opcode) {
+    static OpcodeHistograms histograms;
+    static const bool registered = register_opcode_histograms(
+        histograms, "audioMaster() opcode ", " (during processing)");
+    (void)registered;
+
+    return histograms[opcode_histogram_index(opcode)];
+}
+
+bool register_opcode_histograms(const OpcodeHistograms& histograms,
+                                const char* label,
+                                const char* suffix) {
+    LatencyHistograms& registry = LatencyHistograms::get();
+    for (size_t i = 0; i < histograms.size(); i++) {
+        registry.add(label +
+                         (i == histograms.size() - 1 ? ">= " + std::to_string(i)
+                                                     : std::to_string(i)) +
+                         suffix,
+                     histograms[i]);
+    }
+
+    return true;
+}
+
+size_t opcode_histogram_index(int opcode) noexcept {
+    return std::min(static_cast<size_t>(std::max(opcode, 0)),
+                    num_vst2_opcode_histograms - 1);
+}
+
+size_t bucket_index(uint64_t us) noexcept {
+    if (us == 0) {
+        return 0;
+    }
+
+    // Two buckets per power of two, split on the bit below the most
+    // significant bit
+    const size_t log2 = static_cast<size_t>(std::bit_width(us)) - 1;
+    const size_t half = log2 == 0 ? 0 : (us >> (log2 - 1)) & 1;
+
+    return 1 + (log2 * 2) + half;
+}
+
+uint64_t bucket_upper_bound(size_t index) noexcept {
+    if (index == 0) {
+        return 0;
+    }
+
+    const size_t log2 = (index - 1) / 2;
+    const size_t half = (index - 1) % 2;
+    if (log2 == 0) {
+        return 1;
+    }
+
+    return (1ull << log2) + ((half + 1) << (log2 - 1)) - 1;
+}
+
+Logger create_latency_logger() {
+#ifdef __WINE__
+    return Logger::create_wine_stderr();
+#else
+    return Logger::create_from_environment("[latency] ");
+#endif
+}
@@ -0,0 +1,272 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+/**
+ * A lock-free latency histogram with logarithmic buckets. Every power of two
+ * microseconds is split into two buckets, so the reported percentiles are
+ * accurate to within 50%. That's plenty for finding requests that take
+ * milliseconds instead of microseconds. Recording a value is a single relaxed
+ * atomic increment, so these histograms are always enabled.
+ */
+class LatencyHistogram {
+   public:
+    /**
+     * A summary of the recorded values. The percentiles are the upper bounds
+     * of the buckets they fall in.
+     */
+    struct Summary {
+        uint64_t count;
+        uint64_t p50_us;
+        uint64_t p99_us;
+        uint64_t p999_us;
+        uint64_t max_us;
+    };
+
+    /**
+     * Record a single request's latency. This is safe to call from any thread,
+     * including audio threads.
+     */
+    void record(std::chrono::steady_clock::duration duration) noexcept;
+
+    /**
+     * Summarize the values recorded so far, or return a nullopt if nothing has
+     * been recorded yet.
+     */
+    std::optional<Summary> summarize() const noexcept;
+
+   private:
+    /**
+     * One bucket for values under a microsecond, and then two buckets for
+     * every power of two up to 2^32 microseconds.
+     */
+    static constexpr size_t num_buckets = 1 + (2 * 32);
+
+    std::array<std::atomic_uint64_t, num_buckets> buckets_{};
+    std::atomic_uint64_t max_us_ = 0;
+};
+
+/**
+ * The number of messages and bytes sent and received over one kind of socket
+ * connection. The byte counts include the size prefix. Like the histograms,
+ * recording something is a couple of relaxed atomic increments.
+ */
+struct SocketTrafficCounters {
+    inline void record_sent(uint64_t bytes) noexcept {
+        messages_sent.fetch_add(1, std::memory_order_relaxed);
+        bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    inline void record_received(uint64_t bytes) noexcept {
+        messages_received.fetch_add(1, std::memory_order_relaxed);
+        bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    std::atomic_uint64_t messages_sent = 0;
+    std::atomic_uint64_t bytes_sent = 0;
+    std::atomic_uint64_t messages_received = 0;
+    std::atomic_uint64_t bytes_received = 0;
+};
+
+/**
+ * The traffic over all sockets for a single channel, like `host_vst_dispatch`
+ * or `host_vst_process_replacing`, in this process. This is split between the
+ * long living primary sockets and the secondary connections
+ * `AdHocSocketHandler` falls back to when the primary socket is in use. Every
+ * channel gets its own cache line since the audio threads of different plugin
+ * instances update these at the same time.
+ */
+struct alignas(64) SocketTraffic {
+    SocketTrafficCounters primary;
+    SocketTrafficCounters secondary;
+};
+
+/**
+ * Keeps track of all latency histograms in this process, as well as the
+ * socket traffic counters for every channel. When the
+ * `YABRIDGE_LATENCY_INTERVAL` environment variable is set to a number of
+ * seconds, the summaries of all histograms and the traffic counters are
+ * written to the log at that interval and once more when this process or the
+ * plugin library exits.
+ */
+class LatencyHistograms {
+   public:
+    static LatencyHistograms& get();
+
+    LatencyHistograms(const LatencyHistograms&) = delete;
+    LatencyHistograms& operator=(const LatencyHistograms&) = delete;
+
+    ~LatencyHistograms() noexcept;
+
+    /**
+     * Add a histogram to the summaries. The histogram has to outlive this
+     * object, so this should only be used for static histograms.
+     */
+    void add(std::string label, const LatencyHistogram& histogram);
+
+    /**
+     * Call `fn(label, summary)` for every histogram that has recorded
+     * something. This is also used for the group host's metrics endpoint.
+     */
+    template <std::invocable<const std::string&,
+                             const LatencyHistogram::Summary&> F>
+    void for_each_summary(F&& fn) {
+        std::lock_guard lock(histograms_mutex_);
+        for (const auto& [label, histogram] : histograms_) {
+            if (const auto summary = histogram->summarize()) {
+                fn(label, *summary);
+            }
+        }
+    }
+
+    /**
+     * Get the traffic counters for the socket channel with the specified name,
+     * creating them if they don't exist yet. The returned reference stays
+     * valid for the rest of the process' lifetime. Socket handlers look these
+     * up once when they're created.
+     */
+    SocketTraffic& socket_traffic(const std::string& channel);
+
+    /**
+     * Call `fn(channel, traffic)` for every socket channel that has been
+     * created in this process. This is also used for the group host's metrics
+     * endpoint.
+     */
+    template <std::invocable<const std::string&, const SocketTraffic&> F>
+    void for_each_socket_traffic(F&& fn) {
+        std::lock_guard lock(socket_traffic_mutex_);
+        for (const auto& [channel, traffic] : socket_traffic_) {
+            fn(channel, *traffic);
+        }
+    }
+
+   private:
+    LatencyHistograms();
+
+    /**
+     * Write the summaries of all histograms that recorded something to the
+     * log.
+     */
+    void dump();
+
+    std::vector<std::pair<std::string, const LatencyHistogram*>> histograms_;
+    std::mutex histograms_mutex_;
+
+    /**
+     * There are only a handful of channels, so this doesn't need to be a map.
+     * The traffic counters are heap allocated so their addresses are stable.
+     */
+    std::vector<std::pair<std::string, std::unique_ptr<SocketTraffic>>>
+        socket_traffic_;
+    std::mutex socket_traffic_mutex_;
+
+    /**
+     * Periodically calls `dump()`. Only started when
+     * `YABRIDGE_LATENCY_INTERVAL` is set.
+     */
+    std::jthread dump_thread_;
+};
+
+/**
+ * Measures the time between construction and destruction, and records it in a
+ * histogram.
+ */
+class LatencyScope {
+   public:
+    explicit LatencyScope(LatencyHistogram& histogram) noexcept
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~LatencyScope() noexcept {
+        histogram_.record(std::chrono::steady_clock::now() - start_);
+    }
+
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+
+   private:
+    LatencyHistogram& histogram_;
+    const std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * The histogram for the round trip times of requests of type `T` sent from this
+ * process, or for the time spent handling them in this process when
+ * `handling` is true. A process never both sends and handles the same VST3
+ * request type, so the request type alone identifies the direction.
+ */
+template <typename T, bool handling>
+LatencyHistogram& vst3_request_histogram() {
+    static LatencyHistogram histogram;
+    static const bool registered = [&]() {
+        LatencyHistograms::get().add(
+            std::string(trace_name<T>()) +
+                (handling ? " (handling)" : " (round trip)"),
+            histogram);
+        return true;
+    }();
+    (void)registered;
+
+    return histogram;
+}
+
+/**
+ * The histogram for VST2 events with the specified opcode sent from this
+ * process, or handled in this process when `handling` is true. Opcodes outside
+ * of the range of regular VST2 opcodes share a single histogram.
+ */
+LatencyHistogram& vst2_event_histogram(int opcode, bool handling);
+
+/**
+ * The histogram for host callbacks of type `T` the plugin made while
+ * processing audio. These are also included in the `(round trip)` histograms,
+ * but this separates the callbacks that the plugin's processing time is
+ * blocked on. Only used by the Wine plugin host.
+ *
+ * @see ProcessCallbackTimer::Callback
+ */
+template <typename T>
+LatencyHistogram& vst3_process_callback_histogram() {
+    static LatencyHistogram histogram;
+    static const bool registered = [&]() {
+        LatencyHistograms::get().add(
+            std::string(trace_name<T>()) + " (during processing)", histogram);
+        return true;
+    }();
+    (void)registered;
+
+    return histogram;
+}
+
+/**
+ * The VST2 equivalent of `vst3_process_callback_histogram()` for
+ * `audioMaster()` callbacks with the specified opcode.
+ */
+LatencyHistogram& vst2_process_callback_histogram(int opcode);
@@ -0,0 +1,198 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * The environment variable containing the path to append trace events to.
+ * Tracing is disabled when this is not set.
+ */
+constexpr char trace_file_environment_variable[] = "YABRIDGE_TRACE_FILE";
+
+/**
+ * The maximum length of a single trace event. Our events are much shorter than
+ * this, so this only matters for very long request type names, which get
+ * truncated.
+ */
+constexpr size_t max_trace_event_size = 1024;
+
+/**
+ * The name shown for this process in the trace viewer.
+ */
+#ifdef __WINE__
+constexpr char trace_process_name[] = "yabridge Wine plugin host";
+#else
+constexpr char trace_process_name[] = "yabridge native plugin";
+#endif
+
+/**
+ * The time in microseconds since the steady clock's epoch. This is
+ * `CLOCK_MONOTONIC` in both processes, so the timestamps from the native plugin
+ * and the Wine plugin host line up.
+ */
+double to_trace_timestamp(std::chrono::steady_clock::time_point time) noexcept;
+
+Tracer& Tracer::get() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer() {
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* trace_file = getenv(trace_file_environment_variable);
+    if (!trace_file || trace_file[0] == '\0') {
+        return;
+    }
+
+    fd_ = open(trace_file, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        return;
+    }
+
+    pid_ = getpid();
+
+    // Only the first process writing to the file adds the opening bracket
+    struct stat file_info {};
+    if (fstat(fd_, &file_info) == 0 && file_info.st_size == 0) {
+        write_event("[\n", 2);
+    }
+
+    char event[max_trace_event_size];
+    const int length = snprintf(
+        event, sizeof(event),
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"name\":\"%s (%d)\"}},\n",
+        pid_, pid_, trace_process_name, pid_);
+    if (length > 0) {
+        write_event(event, std::min(static_cast<size_t>(length),
+                                    sizeof(event) - 1));
+    }
+}
+
+Tracer::~Tracer() noexcept {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+void Tracer::write_slice(const char* name,
+                         const char* category,
+                         std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end,
+                         int opcode,
+                         uint64_t flow_id,
+                         TraceFlow flow) noexcept {
+    if (!enabled()) {
+        return;
+    }
+
+    const int tid = static_cast<int>(syscall(SYS_gettid));
+    const double start_us = to_trace_timestamp(start);
+    const double duration_us = std::chrono::duration<double, std::micro>(
+                                   end - start)
+                                   .count();
+
+    // The flow event and the slice are written together so they can't end up
+    // in different places in the file when both processes write at once
+    char event[max_trace_event_size];
+    int length = 0;
+    if (flow != TraceFlow::none) {
+        // The start of a flow binds to the slice enclosing it on the sending
+        // thread, and the end of the flow binds to the slice it's in on the
+        // handling thread
+        length = snprintf(
+            event, sizeof(event),
+            "{\"name\":\"request\",\"cat\":\"flow\",\"ph\":\"%s\","
+            "\"id\":\"0x%llx\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d%s},\n",
+            flow == TraceFlow::start ? "s" : "f",
+            static_cast<unsigned long long>(flow_id), start_us, pid_, tid,
+            flow == TraceFlow::end ? ",\"bp\":\"e\"" : "");
+        if (length < 0) {
+            return;
+        }
+    }
+
+    const size_t offset =
+        std::min(static_cast<size_t>(length), sizeof(event) - 1);
+    int slice_length;
+    if (opcode >= 0) {
+        slice_length = snprintf(
+            event + offset, sizeof(event) - offset,
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+            "\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"opcode\":%d}},\n",
+            name, category, start_us, duration_us, pid_, tid, opcode);
+    } else {
+        slice_length =
+            snprintf(event + offset, sizeof(event) - offset,
+                     "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                     "\"dur\":%.3f,\"pid\":%d,\"tid\":%d},\n",
+                     name, category, start_us, duration_us, pid_, tid);
+    }
+    if (slice_length < 0) {
+        return;
+    }
+
+    // Truncated events would make the file unreadable, so we'll just drop
+    // those
+    const size_t total_length = offset + static_cast<size_t>(slice_length);
+    if (total_length < sizeof(event)) {
+        write_event(event, total_length);
+    }
+}
+
+void Tracer::write_event(const char* event, size_t length) noexcept {
+    // With `O_APPEND` every write ends up in one piece at the end of the file,
+    // even when the other process is writing at the same time
+    [[maybe_unused]] const ssize_t result = write(fd_, event, length);
+}
+
+TraceScope::TraceScope(const char* name,
+                       const char* category,
+                       uint64_t flow_id,
+                       TraceFlow flow,
+                       int opcode) noexcept
+    : enabled_(Tracer::get().enabled()),
+      name_(name),
+      category_(category),
+      flow_id_(flow_id),
+      flow_(flow),
+      opcode_(opcode) {
+    if (enabled_) [[unlikely]] {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+TraceScope::~TraceScope() noexcept {
+    if (enabled_) [[unlikely]] {
+        Tracer::get().write_slice(name_, category_, start_,
+                                  std::chrono::steady_clock::now(), opcode_,
+                                  flow_id_, flow_);
+    }
+}
+
+double to_trace_timestamp(std::chrono::steady_clock::time_point time) noexcept {
+    return std::chrono::duration<double, std::micro>(time.time_since_epoch())
+        .count();
+}
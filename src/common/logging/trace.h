@@ -0,0 +1,173 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+#include <cxxabi.h>
+
+/**
+ * How a traced request is connected to the request on the other side of the
+ * socket. Chrome's trace viewer and Perfetto draw an arrow from the slice that
+ * started a flow to the slice that ends it.
+ */
+enum class TraceFlow {
+    /**
+     * This slice is not connected to anything.
+     */
+    none,
+    /**
+     * This slice sent a request, and the flow ends at the slice handling that
+     * request in the other process.
+     */
+    start,
+    /**
+     * This slice handled a request sent from the other process.
+     */
+    end,
+};
+
+/**
+ * Writes Chrome trace events describing the bridge's activity to the file
+ * specified in the `YABRIDGE_TRACE_FILE` environment variable. Both the native
+ * plugin and the Wine plugin host append to the same file, and requests are
+ * connected to the slice that handled them on the other side using flow
+ * events. The resulting file can be opened in `chrome://tracing` or in
+ * Perfetto. There's no closing bracket since multiple processes write to the
+ * file, but both viewers accept that.
+ *
+ * Every event is written to the file with a single `write()`, and nothing gets
+ * allocated while writing events. This does add a system call to every traced
+ * request, but without tracing enabled the overhead is a single branch.
+ */
+class Tracer {
+   public:
+    /**
+     * Get the tracer for this process. The trace file is opened the first time
+     * this is called.
+     */
+    static Tracer& get();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    ~Tracer() noexcept;
+
+    /**
+     * Whether `YABRIDGE_TRACE_FILE` was set and the file could be opened.
+     */
+    inline bool enabled() const noexcept { return fd_ != -1; }
+
+    /**
+     * Write a complete slice for the calling thread, optionally along with a
+     * flow event connecting it to a slice in the other process.
+     *
+     * @param name The name of the slice, usually the request's type name.
+     * @param category The category of the slice, shown in the trace viewer.
+     * @param start The time the slice started.
+     * @param end The time the slice ended.
+     * @param opcode A VST2 opcode to add as an argument, if this is not
+     *   negative.
+     * @param flow_id The flow ID shared by both sides of the request. Ignored
+     *   when `flow` is `TraceFlow::none`.
+     * @param flow How this slice connects to the other process.
+     */
+    void write_slice(const char* name,
+                     const char* category,
+                     std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point end,
+                     int opcode,
+                     uint64_t flow_id,
+                     TraceFlow flow) noexcept;
+
+   private:
+    Tracer();
+
+    /**
+     * Write a single event to the trace file. `length` should not include the
+     * null terminator.
+     */
+    void write_event(const char* event, size_t length) noexcept;
+
+    /**
+     * The trace file's file descriptor, or -1 if tracing is disabled.
+     */
+    int fd_ = -1;
+
+    /**
+     * This process's ID, written to every event.
+     */
+    int pid_ = 0;
+};
+
+/**
+ * A RAII helper that writes a slice to the trace file covering this object's
+ * lifetime, if tracing is enabled.
+ */
+class TraceScope {
+   public:
+    /**
+     * @param name The name of the slice. This pointer should outlive the
+     *   scope, since the slice is only written at the end.
+     * @param category The slice's category. The same applies here.
+     * @param flow_id See `Tracer::write_slice()`.
+     * @param flow See `Tracer::write_slice()`.
+     * @param opcode See `Tracer::write_slice()`.
+     */
+    TraceScope(const char* name,
+               const char* category,
+               uint64_t flow_id = 0,
+               TraceFlow flow = TraceFlow::none,
+               int opcode = -1) noexcept;
+
+    ~TraceScope() noexcept;
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+   private:
+    const bool enabled_;
+    const char* name_;
+    const char* category_;
+    const uint64_t flow_id_;
+    const TraceFlow flow_;
+    const int opcode_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Get a readable name for `T` to use in traces. The name is demangled once per
+ * type, so this doesn't allocate after the first call for a type.
+ */
+template <typename T>
+const char* trace_name() {
+    static const std::string name = []() {
+        int status = 0;
+        const std::unique_ptr<char, decltype(&free)> demangled(
+            abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status),
+            free);
+
+        return status == 0 && demangled ? std::string(demangled.get())
+                                         : std::string(typeid(T).name());
+    }();
+
+    return name.c_str();
+}
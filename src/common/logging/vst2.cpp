@@ -341,10 +341,13 @@ void Vst2Logger::log_get_parameter(int index) {
     }
 }
 
-void Vst2Logger::log_get_parameter_response(float value) {
+void Vst2Logger::log_get_parameter_response(float value, bool from_cache) {
     if (logger_.verbosity_ >= Logger::Verbosity::most_events) [[unlikely]] {
         std::ostringstream message;
         message << "   getParameter() :: " << value;
+        if (from_cache) {
+            message << " (from cache)";
+        }
 
         log(message.str());
     }
@@ -427,6 +430,7 @@ void Vst2Logger::log_event(
                     message << "<window " << window_id << ">";
                 },
                 [&](const AEffect&) { message << "nullptr"; },
+                [&](const AEffectDelta&) { message << "nullptr"; },
                 [&](const DynamicVstEvents& events) {
                     message << "<" << events.events_.size() << " midi_events";
                     if (!events.sysex_data_.empty()) {
@@ -456,7 +460,13 @@ void Vst2Logger::log_event(
                 },
                 [&](const WantsVstRect&) { message << "VstRect**"; },
                 [&](const WantsVstTimeInfo&) { message << "nullptr"; },
-                [&](const WantsString&) { message << "<writable_string>"; }},
+                [&](const WantsString&) { message << "<writable_string>"; },
+                [&](const WantsParameterDescriptions&) {
+                    message << "<parameter_descriptions>";
+                },
+                [&](const WantsProgramNames&) {
+                    message << "<program_names>";
+                }},
             payload);
 
         message << ")";
@@ -531,6 +541,17 @@ void Vst2Logger::log_event_response(
                     message << ", <parameter_properties for '" << props.label
                             << "'>";
                 },
+                [&](const Vst2ParameterDescriptions& descriptions) {
+                    message << ", <" << descriptions.descriptions.size()
+                            << " parameter_descriptions>";
+                },
+                [&](const Vst2ProgramNames& program_names) {
+                    message << ", <" << program_names.names.size()
+                            << " program_names>";
+                },
+                [&](const UnchangedChunkData&) {
+                    message << ", <unchanged chunk>";
+                },
                 [&](const VstRect& rect) {
                     message << ", {l: " << rect.left << ", t: " << rect.top
                             << ", r: " << rect.right << ", b: " << rect.bottom
@@ -27,7 +27,7 @@
  * everywhere.
  */
 std::string format_bstream(const YaBStream& stream) {
-    std::ostringstream formatted;
+    LogStream formatted;
     formatted << "<IBStream* ";
     if (stream.supports_stream_attributes_ && stream.attributes_) {
         formatted << "with meta data [";
@@ -58,7 +58,7 @@ void Vst3Logger::log_query_interface(
     tresult result,
     const std::optional<Steinberg::FUID>& uid) {
     if (logger_.verbosity_ >= Logger::Verbosity::all_events) [[unlikely]] {
-        std::ostringstream message;
+        LogStream message;
         std::string uid_string = uid ? format_uid(*uid) : "<unknown_pointer>";
 
         if (result == Steinberg::kResultOk) {
@@ -118,6 +118,14 @@ bool Vst3Logger::log_request(bool is_host_vst,
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const Vst3PluginProxy::StartAudioProcessor& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id << ": <start audio processor thread>";
+    });
+}
+
 bool Vst3Logger::log_request(bool is_host_vst,
                              const Vst3PluginProxy::SetState& request) {
     return log_request_base(is_host_vst, [&](auto& message) {
@@ -251,6 +259,15 @@ bool Vst3Logger::log_request(
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaEditController::GetAllParameterInfos& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id
+                << ": IEditController::getParameterInfo() for all parameters";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaEditController::GetParamStringByValue& request) {
@@ -286,6 +303,15 @@ bool Vst3Logger::log_request(
     });
 }
 
+bool Vst3Logger::log_request(bool is_host_vst,
+                             const YaComponentHandler::PerformEdits& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.owner_instance_id
+                << ": IComponentHandler::performEdit() for "
+                << request.edits.size() << " coalesced parameter edits";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaEditController::PlainParamToNormalized& request) {
@@ -307,6 +333,15 @@ bool Vst3Logger::log_request(
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaEditController::GetAllParamNormalized& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id
+                << ": IEditController::getParamNormalized() for all parameters";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaEditController::SetParamNormalized& request) {
@@ -424,13 +459,24 @@ bool Vst3Logger::log_request(
     const YaKeyswitchController::GetKeyswitchInfo& request) {
     return log_request_base(is_host_vst, [&](auto& message) {
         message << request.instance_id
-                << ": IKeyswitchController::getKeyswitchCount(busIndex = "
+                << ": IKeyswitchController::getKeyswitchInfo(busIndex = "
                 << request.bus_index << ", channel = " << request.channel
                 << ", keySwitchIndex = " << request.key_switch_index
                 << ", &info)";
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaKeyswitchController::GetAllKeyswitchInfos& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id
+                << ": IKeyswitchController::getKeyswitchInfo(busIndex = "
+                << request.bus_index << ", channel = " << request.channel
+                << ") for all keyswitches";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaMidiLearn::OnLiveMIDIControllerInput& request) {
@@ -454,6 +500,16 @@ bool Vst3Logger::log_request(
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaMidiMapping::GetAllMidiControllerAssignments& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id
+                << ": IMidiMapping::getMidiControllerAssignment(busIndex = "
+                << request.bus_index << ") for all channels and controllers";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaNoteExpressionController::GetNoteExpressionCount& request) {
@@ -478,6 +534,18 @@ bool Vst3Logger::log_request(
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaNoteExpressionController::GetAllNoteExpressionInfos& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message
+            << request.instance_id
+            << ": INoteExpressionController::getNoteExpressionInfo(busIndex = "
+            << request.bus_index << ", channel = " << request.channel
+            << ") for all note expressions";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaNoteExpressionController::GetNoteExpressionStringByValue& request) {
@@ -832,6 +900,16 @@ bool Vst3Logger::log_request(bool is_host_vst,
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaUnitInfo::GetAllUnitsAndProgramLists& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id
+                << ": IUnitInfo::getUnitInfo() and "
+                   "IUnitInfo::getProgramName() for all units and programs";
+    });
+}
+
 bool Vst3Logger::log_request(bool is_host_vst,
                              const YaUnitInfo::HasProgramPitchNames& request) {
     return log_request_base(is_host_vst, [&](auto& message) {
@@ -1009,7 +1087,7 @@ bool Vst3Logger::log_request(
             //       supports (based on the audio buffers we set up during
             //       `IAudioProcessor::setActive()`). Some hosts may send more
             //       buffers, but we don't reflect that in the output right now.
-            std::ostringstream num_input_channels;
+            LogStream num_input_channels;
             num_input_channels << "[";
             for (bool is_first = true;
                  const auto& buffers : request.data.inputs_) {
@@ -1026,7 +1104,7 @@ bool Vst3Logger::log_request(
             }
             num_input_channels << "]";
 
-            std::ostringstream num_output_channels;
+            LogStream num_output_channels;
             num_output_channels << "[";
             for (bool is_first = true;
                  const auto& buffers : request.data.outputs_) {
@@ -1067,8 +1145,9 @@ bool Vst3Logger::log_request(
                     << (request.data.output_events_ ? "<IEventList*>"
                                                     : "<nullptr>")
                     << ", process_context = "
-                    << (request.data.process_context_ ? "<ProcessContext*>"
-                                                      : "<nullptr>")
+                    << (request.data.has_process_context()
+                            ? "<ProcessContext*>"
+                            : "<nullptr>")
                     << ", process_mode = " << request.data.process_mode_
                     << ", symbolic_sample_size = "
                     << request.data.symbolic_sample_size_ << ">)";
@@ -1273,13 +1352,19 @@ bool Vst3Logger::log_request(
 }
 
 bool Vst3Logger::log_request(bool is_host_vst,
-                             const YaContextMenu::AddItem& request) {
+                             const YaContextMenu::AddItems& request) {
     return log_request_base(is_host_vst, [&](auto& message) {
         message << request.owner_instance_id << ": <IContextMenu* #"
-                << request.context_menu_id
-                << ">::addItem(item = <IContextMenuItem #" << request.item.tag
-                << " for \"" << VST3::StringConvert::convert(request.item.name)
-                << "\">, target)";
+                << request.context_menu_id << ">::addItem() for "
+                << request.items.size() << " items";
+        if (logger_.verbosity_ >= Logger::Verbosity::all_events) {
+            for (const auto& [item, item_id, has_target] : request.items) {
+                message << "\n  item = <IContextMenuItem #" << item.tag
+                        << " for \"" << VST3::StringConvert::convert(item.name)
+                        << "\">, target = "
+                        << (has_target ? "<IContextMenuTarget*>" : "nullptr");
+            }
+        }
     });
 }
 
@@ -1463,7 +1548,19 @@ void Vst3Logger::log_response(bool is_host_vst,
 void Vst3Logger::log_response(
     bool is_host_vst,
     const Vst3PluginProxy::InitializeResponse& response) {
-    log_response(is_host_vst, response.result);
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << response.result.string();
+        if (response.summary) {
+            message << ", <InstanceSummary with "
+                    << response.summary->bus_infos.size() << " busses";
+            if (response.summary->parameter_infos) {
+                message << " and "
+                        << response.summary->parameter_infos->infos.size()
+                        << " parameters";
+            }
+            message << ">";
+        }
+    });
 }
 
 void Vst3Logger::log_response(
@@ -1494,6 +1591,23 @@ void Vst3Logger::log_response(
     });
 }
 
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaEditController::GetAllParameterInfosResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << "<ParameterInfo for " << response.infos.size()
+                << " parameters>";
+    });
+}
+
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaEditController::GetAllParamNormalizedResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << "<values for " << response.values.size() << " parameters>";
+    });
+}
+
 void Vst3Logger::log_response(
     bool is_host_vst,
     const YaEditController::GetParamStringByValueResponse& response) {
@@ -1529,43 +1643,104 @@ void Vst3Logger::log_response(
     });
 }
 
+void Vst3Logger::log_response(bool is_host_vst,
+                              const YaContextMenu::AddItemsResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        size_t num_added = 0;
+        for (const auto& result : response.results) {
+            if (result == Steinberg::kResultOk) {
+                num_added++;
+            }
+        }
+
+        message << "<" << num_added << " of " << response.results.size()
+                << " items added>";
+    });
+}
+
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaKeyswitchController::GetKeyswitchInfoResponse& response) {
+    const YaKeyswitchController::GetKeyswitchInfoResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", <KeyswitchInfo for \""
                     << VST3::StringConvert::convert(response.info.title)
                     << "\">";
+            if (from_cache) {
+                message << " (from cache)";
+            }
         }
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaMidiMapping::GetMidiControllerAssignmentResponse& response) {
+    const YaKeyswitchController::GetAllKeyswitchInfosResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << "<KeyswitchInfo for " << response.infos.size()
+                << " keyswitches>";
+    });
+}
+
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaMidiMapping::GetMidiControllerAssignmentResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", " << response.id;
         }
+        if (from_cache) {
+            message << " (from cache)";
+        }
+    });
+}
+
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaMidiMapping::GetAllMidiControllerAssignmentsResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        size_t num_assigned = 0;
+        for (const auto& assignment : response.assignments) {
+            if (assignment.result == Steinberg::kResultOk) {
+                num_assigned++;
+            }
+        }
+
+        message << "<" << num_assigned << " assigned MIDI controllers>";
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaNoteExpressionController::GetNoteExpressionInfoResponse& response) {
+    const YaNoteExpressionController::GetNoteExpressionInfoResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", <NoteExpressionTypeInfo for \""
                     << VST3::StringConvert::convert(response.info.title)
                     << "\">";
+            if (from_cache) {
+                message << " (from cache)";
+            }
         }
     });
 }
 
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaNoteExpressionController::GetAllNoteExpressionInfosResponse&
+        response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << "<NoteExpressionTypeInfo for " << response.infos.size()
+                << " note expressions>";
+    });
+}
+
 void Vst3Logger::log_response(
     bool is_host_vst,
     const YaNoteExpressionController::GetNoteExpressionStringByValueResponse&
@@ -1625,12 +1800,16 @@ void Vst3Logger::log_response(
 void Vst3Logger::log_response(
     bool is_host_vst,
     const YaParameterFunctionName::GetParameterIDFromFunctionNameResponse&
-        response) {
+        response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", " << response.param_id;
         }
+        if (from_cache) {
+            message << " (from cache)";
+        }
     });
 }
 
@@ -1688,52 +1867,83 @@ void Vst3Logger::log_response(bool is_host_vst,
 }
 
 void Vst3Logger::log_response(bool is_host_vst,
-                              const YaUnitInfo::GetUnitInfoResponse& response) {
+                              const YaUnitInfo::GetUnitInfoResponse& response,
+                              bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", <UnitInfo for \""
                     << VST3::StringConvert::convert(response.info.name)
                     << "\">";
+            if (from_cache) {
+                message << " (from cache)";
+            }
         }
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaUnitInfo::GetProgramListInfoResponse& response) {
+    const YaUnitInfo::GetProgramListInfoResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", <ProgramListInfo for \""
                     << VST3::StringConvert::convert(response.info.name)
                     << "\">";
+            if (from_cache) {
+                message << " (from cache)";
+            }
         }
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaUnitInfo::GetProgramNameResponse& response) {
+    const YaUnitInfo::GetProgramNameResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", \"" << VST3::StringConvert::convert(response.name)
                     << "\"";
+            if (from_cache) {
+                message << " (from cache)";
+            }
         }
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaUnitInfo::GetProgramInfoResponse& response) {
+    const YaUnitInfo::GetProgramInfoResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", \""
                     << VST3::StringConvert::convert(response.attribute_value)
                     << "\"";
+            if (from_cache) {
+                message << " (from cache)";
+            }
+        }
+    });
+}
+
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaUnitInfo::GetAllUnitsAndProgramListsResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        size_t num_programs = 0;
+        for (const auto& program_list : response.program_lists) {
+            num_programs += program_list.program_names.size();
         }
+
+        message << "<UnitInfo for " << response.units.size() << " units, "
+                << response.program_lists.size() << " program lists with "
+                << num_programs << " programs>";
     });
 }
 
@@ -1763,18 +1973,23 @@ void Vst3Logger::log_response(
 void Vst3Logger::log_response(
     bool is_host_vst,
     const YaXmlRepresentationController::GetXmlRepresentationStreamResponse&
-        response) {
+        response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
             message << ", " << format_bstream(response.stream);
         }
+        if (from_cache) {
+            message << " (from cache)";
+        }
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_vst,
-    const YaAudioProcessor::GetBusArrangementResponse& response) {
+    const YaAudioProcessor::GetBusArrangementResponse& response,
+    bool from_cache) {
     log_response_base(is_host_vst, [&](auto& message) {
         message << response.result.string();
         if (response.result == Steinberg::kResultOk) {
@@ -1783,6 +1998,9 @@ void Vst3Logger::log_response(
                 << std::bitset<sizeof(Steinberg::Vst::SpeakerArrangement) * 8>(
                        response.arr)
                 << ">";
+            if (from_cache) {
+                message << " (from cache)";
+            }
         }
     });
 }
@@ -1795,7 +2013,7 @@ void Vst3Logger::log_response(
 
         // This is incredibly verbose, but if you're really a plugin that
         // handles processing in a weird way you're going to need all of this
-        std::ostringstream num_output_channels;
+        LogStream num_output_channels;
         num_output_channels << "[";
         assert(response.output_data.outputs);
         for (bool is_first = true;
@@ -65,6 +65,8 @@ class Vst3Logger {
     bool log_request(bool is_host_vst, const Vst3PlugViewProxy::Destruct&);
     bool log_request(bool is_host_vst, const Vst3PluginProxy::Construct&);
     bool log_request(bool is_host_vst, const Vst3PluginProxy::Destruct&);
+    bool log_request(bool is_host_vst,
+                     const Vst3PluginProxy::StartAudioProcessor&);
     bool log_request(bool is_host_vst, const Vst3PluginProxy::Initialize&);
     bool log_request(bool is_host_vst, const Vst3PluginProxy::SetState&);
     bool log_request(bool is_host_vst, const Vst3PluginProxy::GetState&);
@@ -84,6 +86,8 @@ class Vst3Logger {
                      const YaEditController::GetParameterCount&);
     bool log_request(bool is_host_vst,
                      const YaEditController::GetParameterInfo&);
+    bool log_request(bool is_host_vst,
+                     const YaEditController::GetAllParameterInfos&);
     bool log_request(bool is_host_vst,
                      const YaEditController::GetParamStringByValue&);
     bool log_request(bool is_host_vst,
@@ -94,6 +98,8 @@ class Vst3Logger {
                      const YaEditController::PlainParamToNormalized&);
     bool log_request(bool is_host_vst,
                      const YaEditController::GetParamNormalized&);
+    bool log_request(bool is_host_vst,
+                     const YaEditController::GetAllParamNormalized&);
     bool log_request(bool is_host_vst,
                      const YaEditController::SetParamNormalized&);
     bool log_request(bool is_host_vst,
@@ -112,14 +118,21 @@ class Vst3Logger {
                      const YaKeyswitchController::GetKeyswitchCount&);
     bool log_request(bool is_host_vst,
                      const YaKeyswitchController::GetKeyswitchInfo&);
+    bool log_request(bool is_host_vst,
+                     const YaKeyswitchController::GetAllKeyswitchInfos&);
     bool log_request(bool is_host_vst,
                      const YaMidiLearn::OnLiveMIDIControllerInput&);
     bool log_request(bool is_host_vst,
                      const YaMidiMapping::GetMidiControllerAssignment&);
+    bool log_request(bool is_host_vst,
+                     const YaMidiMapping::GetAllMidiControllerAssignments&);
     bool log_request(bool is_host_vst,
                      const YaNoteExpressionController::GetNoteExpressionCount&);
     bool log_request(bool is_host_vst,
                      const YaNoteExpressionController::GetNoteExpressionInfo&);
+    bool log_request(
+        bool is_host_vst,
+        const YaNoteExpressionController::GetAllNoteExpressionInfos&);
     bool log_request(
         bool is_host_vst,
         const YaNoteExpressionController::GetNoteExpressionStringByValue&);
@@ -169,6 +182,8 @@ class Vst3Logger {
     bool log_request(bool is_host_vst, const YaUnitInfo::GetProgramListInfo&);
     bool log_request(bool is_host_vst, const YaUnitInfo::GetProgramName&);
     bool log_request(bool is_host_vst, const YaUnitInfo::GetProgramInfo&);
+    bool log_request(bool is_host_vst,
+                     const YaUnitInfo::GetAllUnitsAndProgramLists&);
     bool log_request(bool is_host_vst, const YaUnitInfo::HasProgramPitchNames&);
     bool log_request(bool is_host_vst, const YaUnitInfo::GetProgramPitchName&);
     bool log_request(bool is_host_vst, const YaUnitInfo::GetSelectedUnit&);
@@ -208,6 +223,8 @@ class Vst3Logger {
     bool log_request(bool is_host_vst, const WantsConfiguration&);
     bool log_request(bool is_host_vst, const YaComponentHandler::BeginEdit&);
     bool log_request(bool is_host_vst, const YaComponentHandler::PerformEdit&);
+    bool log_request(bool is_host_vst,
+                     const YaComponentHandler::PerformEdits&);
     bool log_request(bool is_host_vst, const YaComponentHandler::EndEdit&);
     bool log_request(bool is_host_vst,
                      const YaComponentHandler::RestartComponent&);
@@ -223,7 +240,7 @@ class Vst3Logger {
     bool log_request(
         bool is_host_vst,
         const YaComponentHandlerBusActivation::RequestBusActivation&);
-    bool log_request(bool is_host_vst, const YaContextMenu::AddItem&);
+    bool log_request(bool is_host_vst, const YaContextMenu::AddItems&);
     bool log_request(bool is_host_vst, const YaContextMenu::RemoveItem&);
     bool log_request(bool is_host_vst, const YaContextMenu::Popup&);
     bool log_request(bool is_host_vst, const YaHostApplication::GetName&);
@@ -256,6 +273,10 @@ class Vst3Logger {
     void log_response(bool is_host_vst,
                       const YaEditController::GetParameterInfoResponse&,
                       bool from_cache = false);
+    void log_response(bool is_host_vst,
+                      const YaEditController::GetAllParameterInfosResponse&);
+    void log_response(bool is_host_vst,
+                      const YaEditController::GetAllParamNormalizedResponse&);
     void log_response(bool is_host_vst,
                       const YaEditController::GetParamStringByValueResponse&);
     void log_response(bool is_host_vst,
@@ -263,13 +284,25 @@ class Vst3Logger {
     void log_response(bool is_host_vst,
                       const YaEditController::CreateViewResponse&);
     void log_response(bool is_host_vst,
-                      const YaKeyswitchController::GetKeyswitchInfoResponse&);
+                      const YaKeyswitchController::GetKeyswitchInfoResponse&,
+                      bool from_cache = false);
+    void log_response(
+        bool is_host_vst,
+        const YaKeyswitchController::GetAllKeyswitchInfosResponse&);
+    void log_response(
+        bool is_host_vst,
+        const YaMidiMapping::GetMidiControllerAssignmentResponse&,
+        bool from_cache = false);
     void log_response(
         bool is_host_vst,
-        const YaMidiMapping::GetMidiControllerAssignmentResponse&);
+        const YaMidiMapping::GetAllMidiControllerAssignmentsResponse&);
     void log_response(
         bool is_host_vst,
-        const YaNoteExpressionController::GetNoteExpressionInfoResponse&);
+        const YaNoteExpressionController::GetNoteExpressionInfoResponse&,
+        bool from_cache = false);
+    void log_response(
+        bool is_host_vst,
+        const YaNoteExpressionController::GetAllNoteExpressionInfosResponse&);
     void log_response(bool is_host_vst,
                       const YaNoteExpressionController::
                           GetNoteExpressionStringByValueResponse&);
@@ -283,7 +316,8 @@ class Vst3Logger {
                       const YaParameterFinder::FindParameterResponse&);
     void log_response(
         bool is_host_vst,
-        const YaParameterFunctionName::GetParameterIDFromFunctionNameResponse&);
+        const YaParameterFunctionName::GetParameterIDFromFunctionNameResponse&,
+        bool from_cache = false);
     void log_response(bool is_host_vst, const YaPlugView::GetSizeResponse&);
     void log_response(bool is_host_vst,
                       const YaPlugView::CheckSizeConstraintResponse&);
@@ -291,23 +325,33 @@ class Vst3Logger {
     void log_response(bool is_host_vst,
                       const YaProgramListData::GetProgramDataResponse&);
     void log_response(bool is_host_vst, const YaUnitData::GetUnitDataResponse&);
-    void log_response(bool is_host_vst, const YaUnitInfo::GetUnitInfoResponse&);
     void log_response(bool is_host_vst,
-                      const YaUnitInfo::GetProgramListInfoResponse&);
+                      const YaUnitInfo::GetUnitInfoResponse&,
+                      bool from_cache = false);
+    void log_response(bool is_host_vst,
+                      const YaUnitInfo::GetProgramListInfoResponse&,
+                      bool from_cache = false);
     void log_response(bool is_host_vst,
-                      const YaUnitInfo::GetProgramNameResponse&);
+                      const YaUnitInfo::GetProgramNameResponse&,
+                      bool from_cache = false);
     void log_response(bool is_host_vst,
-                      const YaUnitInfo::GetProgramInfoResponse&);
+                      const YaUnitInfo::GetProgramInfoResponse&,
+                      bool from_cache = false);
+    void log_response(
+        bool is_host_vst,
+        const YaUnitInfo::GetAllUnitsAndProgramListsResponse&);
     void log_response(bool is_host_vst,
                       const YaUnitInfo::GetProgramPitchNameResponse&);
     void log_response(bool is_host_vst,
                       const YaUnitInfo::GetUnitByBusResponse&);
     void log_response(bool is_host_vst,
                       const YaXmlRepresentationController::
-                          GetXmlRepresentationStreamResponse&);
+                          GetXmlRepresentationStreamResponse&,
+                      bool from_cache = false);
 
     void log_response(bool is_host_vst,
-                      const YaAudioProcessor::GetBusArrangementResponse&);
+                      const YaAudioProcessor::GetBusArrangementResponse&,
+                      bool from_cache = false);
     void log_response(bool is_host_vst,
                       const YaAudioProcessor::ProcessResponse&);
     void log_response(bool is_host_vst,
@@ -324,6 +368,8 @@ class Vst3Logger {
 
     void log_response(bool is_host_vst,
                       const YaComponentHandler3::CreateContextMenuResponse&);
+    void log_response(bool is_host_vst,
+                      const YaContextMenu::AddItemsResponse&);
     void log_response(bool is_host_vst,
                       const YaHostApplication::GetNameResponse&);
     void log_response(bool is_host_vst, const YaProgress::StartResponse&);
@@ -334,7 +380,7 @@ class Vst3Logger {
                       bool from_cache = false) {
         // For logging all primitive return values other than `tresult`
         log_response_base(is_host_vst, [&](auto& message) {
-            message << value;
+            message << static_cast<T>(value);
             if (from_cache) {
                 message << " (from cache)";
             }
@@ -354,17 +400,20 @@ class Vst3Logger {
    private:
     /**
      * Log a request with a standard prefix based on the boolean flag we pass to
-     * every logging function so we don't have to repeat it everywhere.
+     * every logging function so we don't have to repeat it everywhere. The
+     * message is built in a `LogStream` that's reused for every message logged
+     * from the calling thread, so this doesn't allocate once the buffer is
+     * large enough.
      *
      * Returns `true` if the log message was displayed, and the response should
      * thus also be logged.
      */
-    template <std::invocable<std::ostringstream&> F>
+    template <std::invocable<LogStream&> F>
     bool log_request_base(bool is_host_vst,
                           Logger::Verbosity min_verbosity,
                           F callback) {
         if (logger_.verbosity_ >= min_verbosity) [[unlikely]] {
-            std::ostringstream message;
+            LogStream& message = thread_message_buffer();
             if (is_host_vst) {
                 message << "[host -> vst] >> ";
             } else {
@@ -380,7 +429,7 @@ class Vst3Logger {
         }
     }
 
-    template <std::invocable<std::ostringstream&> F>
+    template <std::invocable<LogStream&> F>
     bool log_request_base(bool is_host_vst, F callback) {
         return log_request_base(is_host_vst, Logger::Verbosity::most_events,
                                 callback);
@@ -393,9 +442,9 @@ class Vst3Logger {
      * This should only be called when the corresonding `log_request()` returned
      * `true`.
      */
-    template <std::invocable<std::ostringstream&> F>
+    template <std::invocable<LogStream&> F>
     void log_response_base(bool is_host_vst, F callback) {
-        std::ostringstream message;
+        LogStream& message = thread_message_buffer();
         if (is_host_vst) {
             message << "[vst <- host]    ";
         } else {
@@ -405,4 +454,17 @@ class Vst3Logger {
         callback(message);
         log(message.str());
     }
+
+    /**
+     * The cleared `LogStream` used by `log_request_base()` and
+     * `log_response_base()` on the calling thread. The formatting callbacks
+     * never log anything themselves, so this is never used for two messages
+     * at the same time.
+     */
+    static LogStream& thread_message_buffer() noexcept {
+        thread_local LogStream message;
+        message.clear();
+
+        return message;
+    }
 };
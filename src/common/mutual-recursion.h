@@ -16,9 +16,13 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <functional>
 #include <future>
+#include <memory>
 #include <optional>
 #include <type_traits>
+#include <vector>
 
 #ifdef __WINE__
 #include "../wine-host/asio-fix.h"
@@ -26,6 +30,9 @@
 #include <asio/dispatch.hpp>
 #include <asio/io_context.hpp>
 
+#include "logging/trace.h"
+#include "probes.h"
+
 /**
  * A helper to allow mutually recursive calling sequences with remote function
  * calls. Some plugins (and hosts) are very picky about which thread a function
@@ -49,14 +56,28 @@
  * thread 2:            \-----waiting for fn() to return-----/
  * ```
  *
- * Here `fork(fn)` will call the function `fn` on a new thread (which presumably
- * does some blocking socket operations), and `handle(foo)` will call `foo()` on
+ * Here `fork(fn)` will call the function `fn` on another thread (which
+ * presumably does some blocking socket operations), and `handle(foo)` will call
+ * `foo()` on
  * the thread that originally called `fork(fn)`. If the function passed to
  * `handle()` also calls `fork()` (or more likely, the function pass to
  * `handle()` calls an unmanaged plugin/host function that ends up performing a
  * mutually recursive callback), then this sequence allows for arbitrarily
  * nested mutual recursion.
  *
+ * The threads used to call `fn` are kept around after `fork()` returns, since
+ * mutually recursive calls like `IComponentHandler::restartComponent()` and
+ * `audioMasterSizeWindow()` tend to come in bursts and spawning a new thread
+ * for each of them adds noticeable latency. Nested calls to `fork()` each need
+ * their own thread, so there will be as many of these as the deepest level of
+ * mutual recursion we've encountered so far.
+ *
+ * NOTE: This can't be replaced by coroutines awaiting on the calling thread's
+ *       executor. The nested calls come in while the plugin's or the host's
+ *       own (synchronous) stack frames are still active on the calling
+ *       thread, so the blocking socket operation has to happen somewhere
+ *       else.
+ *
  * @tparam Thread The thread implementation to use. On the Linux side this
  *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
  */
@@ -78,6 +99,10 @@ class MutualRecursionHelper {
     std::invoke_result_t<F> fork(F&& fn) {
         using Result = std::invoke_result_t<F>;
 
+        // Calls handled on this thread show up as nested slices in the trace
+        const TraceScope trace_scope("mutual recursion", "recursion");
+        YABRIDGE_PROBE(mutual_recursion_enter);
+
         // This IO context will accept incoming calls from `handle()` and
         // `maybe_handle()` until the function returns. We keep these on a stack
         // as we need to support multiple levels of mutual recursion. This can
@@ -97,8 +122,20 @@ class MutualRecursionHelper {
 
         // We will call the function from another thread so we can handle calls
         // to `handle()`/`maybe_handle()` from this thread
+        std::unique_ptr<Worker> worker;
+        {
+            std::lock_guard lock(idle_workers_mutex_);
+            if (!idle_workers_.empty()) {
+                worker = std::move(idle_workers_.back());
+                idle_workers_.pop_back();
+            }
+        }
+        if (!worker) {
+            worker = std::make_unique<Worker>();
+        }
+
         std::promise<Result> response_promise{};
-        Thread sending_thread([&]() {
+        worker->run([&]() {
             const Result response = fn();
 
             // Stop accepting additional work to be run from the calling thread
@@ -119,7 +156,14 @@ class MutualRecursionHelper {
         // which point the context will be stopped
         current_io_context->run();
 
-        return response_promise.get_future().get();
+        Result response = response_promise.get_future().get();
+        {
+            std::lock_guard lock(idle_workers_mutex_);
+            idle_workers_.push_back(std::move(worker));
+        }
+
+        YABRIDGE_PROBE(mutual_recursion_exit);
+        return response;
     }
 
     /**
@@ -176,6 +220,76 @@ class MutualRecursionHelper {
     }
 
    private:
+    /**
+     * A thread that calls the functions passed to `fork()`. These are reused
+     * between calls to `fork()`.
+     */
+    class Worker {
+       public:
+        Worker()
+            : thread_([this]() {
+                  std::unique_lock lock(mutex_);
+                  while (true) {
+                      has_task_.wait(lock,
+                                     [this]() { return task_ || stopping_; });
+                      if (!task_) {
+                          return;
+                      }
+
+                      const std::function<void()> task = std::move(task_);
+                      task_ = nullptr;
+                      lock.unlock();
+                      task();
+                      lock.lock();
+                  }
+              }) {}
+
+        /**
+         * Let the thread exit. It's joined when `thread_` gets destroyed right
+         * after this.
+         */
+        ~Worker() noexcept {
+            {
+                std::lock_guard lock(mutex_);
+                stopping_ = true;
+            }
+            has_task_.notify_one();
+        }
+
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        /**
+         * Run `task` on this worker's thread. The worker should not currently
+         * be running another task.
+         */
+        void run(std::function<void()> task) {
+            {
+                std::lock_guard lock(mutex_);
+                task_ = std::move(task);
+            }
+            has_task_.notify_one();
+        }
+
+       private:
+        std::mutex mutex_;
+        std::condition_variable has_task_;
+        std::function<void()> task_;
+        bool stopping_ = false;
+
+        /**
+         * Defined last so the thread can only start once the other fields have
+         * been initialized.
+         */
+        Thread thread_;
+    };
+
+    /**
+     * Workers from earlier calls to `fork()` that are currently not in use.
+     */
+    std::vector<std::unique_ptr<Worker>> idle_workers_;
+    std::mutex idle_workers_mutex_;
+
     /**
      * These IO contexts will let us call functions from the thread that's
      * currently calling `fork()` while we're waiting for the passed function to
@@ -16,10 +16,309 @@
 
 #include "notifications.h"
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <type_traits>
+
+#include <dlfcn.h>
 
 #include "process.h"
-#include "utils.h"
+
+namespace {
+
+/**
+ * The libdbus soname. This has been stable since 2006.
+ */
+constexpr char libdbus_name[] = "libdbus-1.so.3";
+
+/**
+ * How long to wait for the notification daemon to respond before falling back
+ * to `notify-send`.
+ */
+constexpr int notify_timeout_ms = 1000;
+
+// These mirror the public parts of libdbus' ABI, since we don't want to link
+// against or include libdbus. The structs only need to have the right size and
+// alignment.
+struct DBusError {
+    const char* name;
+    const char* message;
+    unsigned int dummy;
+    void* padding1;
+};
+struct DBusMessageIter {
+    void* dummy1;
+    void* dummy2;
+    uint32_t dummy3;
+    int dummy4, dummy5, dummy6, dummy7, dummy8, dummy9, dummy10, dummy11;
+    int pad1;
+    void* pad2;
+    void* pad3;
+};
+struct DBusConnection;
+struct DBusMessage;
+
+constexpr int dbus_bus_session = 0;
+constexpr int dbus_type_array = 'a';
+constexpr int dbus_type_int32 = 'i';
+constexpr int dbus_type_string = 's';
+constexpr int dbus_type_uint32 = 'u';
+
+/**
+ * The handful of libdbus functions needed to call
+ * `org.freedesktop.Notifications.Notify`, loaded on first use.
+ */
+class LibDBus {
+   public:
+    /**
+     * Load libdbus. Check `loaded()` afterwards.
+     */
+    LibDBus() noexcept : handle_(dlopen(libdbus_name, RTLD_NOW | RTLD_LOCAL)) {
+        if (!handle_) {
+            return;
+        }
+
+        const auto load = [&](auto& function, const char* name) {
+            function = reinterpret_cast<std::remove_reference_t<decltype(
+                function)>>(dlsym(handle_, name));
+            return function != nullptr;
+        };
+        loaded_ =
+            load(error_init, "dbus_error_init") &&
+            load(error_free, "dbus_error_free") &&
+            load(bus_get_private, "dbus_bus_get_private") &&
+            load(connection_set_exit_on_disconnect,
+                 "dbus_connection_set_exit_on_disconnect") &&
+            load(connection_send_with_reply_and_block,
+                 "dbus_connection_send_with_reply_and_block") &&
+            load(connection_close, "dbus_connection_close") &&
+            load(connection_unref, "dbus_connection_unref") &&
+            load(message_new_method_call, "dbus_message_new_method_call") &&
+            load(message_unref, "dbus_message_unref") &&
+            load(message_iter_init_append, "dbus_message_iter_init_append") &&
+            load(message_iter_append_basic, "dbus_message_iter_append_basic") &&
+            load(message_iter_open_container,
+                 "dbus_message_iter_open_container") &&
+            load(message_iter_close_container,
+                 "dbus_message_iter_close_container");
+    }
+
+    ~LibDBus() noexcept {
+        if (handle_) {
+            dlclose(handle_);
+        }
+    }
+
+    LibDBus(const LibDBus&) = delete;
+    LibDBus& operator=(const LibDBus&) = delete;
+
+    bool loaded() const noexcept { return loaded_; }
+
+    /**
+     * Send a notification to the notification daemon over the session bus,
+     * and wait for it to respond.
+     *
+     * @return Whether the notification daemon accepted the notification.
+     */
+    bool notify(const std::string& title, const std::string& body) noexcept {
+        DBusError error;
+        error_init(&error);
+
+        // A private connection so we never affect the host's own use of
+        // libdbus. By default libdbus would call `_exit()` when the bus goes
+        // away.
+        DBusConnection* connection = bus_get_private(dbus_bus_session, &error);
+        if (!connection) {
+            error_free(&error);
+            return false;
+        }
+        connection_set_exit_on_disconnect(connection, false);
+
+        bool success = false;
+        if (DBusMessage* message = message_new_method_call(
+                "org.freedesktop.Notifications",
+                "/org/freedesktop/Notifications",
+                "org.freedesktop.Notifications", "Notify")) {
+            const char* app_name = "yabridge";
+            const uint32_t replaces_id = 0;
+            const char* app_icon = "";
+            const char* summary = title.c_str();
+            const char* body_str = body.c_str();
+            const int32_t expire_timeout = -1;
+
+            DBusMessageIter args;
+            DBusMessageIter actions;
+            DBusMessageIter hints;
+            message_iter_init_append(message, &args);
+            message_iter_append_basic(&args, dbus_type_string, &app_name);
+            message_iter_append_basic(&args, dbus_type_uint32, &replaces_id);
+            message_iter_append_basic(&args, dbus_type_string, &app_icon);
+            message_iter_append_basic(&args, dbus_type_string, &summary);
+            message_iter_append_basic(&args, dbus_type_string, &body_str);
+            message_iter_open_container(&args, dbus_type_array, "s", &actions);
+            message_iter_close_container(&args, &actions);
+            message_iter_open_container(&args, dbus_type_array, "{sv}",
+                                        &hints);
+            message_iter_close_container(&args, &hints);
+            message_iter_append_basic(&args, dbus_type_int32, &expire_timeout);
+
+            if (DBusMessage* reply = connection_send_with_reply_and_block(
+                    connection, message, notify_timeout_ms, &error)) {
+                success = true;
+                message_unref(reply);
+            } else {
+                error_free(&error);
+            }
+            message_unref(message);
+        }
+
+        connection_close(connection);
+        connection_unref(connection);
+
+        return success;
+    }
+
+   private:
+    void* handle_;
+    bool loaded_ = false;
+
+    void (*error_init)(DBusError*) = nullptr;
+    void (*error_free)(DBusError*) = nullptr;
+    DBusConnection* (*bus_get_private)(int, DBusError*) = nullptr;
+    void (*connection_set_exit_on_disconnect)(DBusConnection*,
+                                              uint32_t) = nullptr;
+    DBusMessage* (*connection_send_with_reply_and_block)(DBusConnection*,
+                                                         DBusMessage*,
+                                                         int,
+                                                         DBusError*) = nullptr;
+    void (*connection_close)(DBusConnection*) = nullptr;
+    void (*connection_unref)(DBusConnection*) = nullptr;
+    DBusMessage* (*message_new_method_call)(const char*,
+                                            const char*,
+                                            const char*,
+                                            const char*) = nullptr;
+    void (*message_unref)(DBusMessage*) = nullptr;
+    void (*message_iter_init_append)(DBusMessage*, DBusMessageIter*) = nullptr;
+    uint32_t (*message_iter_append_basic)(DBusMessageIter*,
+                                          int,
+                                          const void*) = nullptr;
+    uint32_t (*message_iter_open_container)(DBusMessageIter*,
+                                            int,
+                                            const char*,
+                                            DBusMessageIter*) = nullptr;
+    uint32_t (*message_iter_close_container)(DBusMessageIter*,
+                                             DBusMessageIter*) = nullptr;
+};
+
+/**
+ * Send a notification using `notify-send`, for when libdbus is not available or
+ * when sending the notification through D-Bus failed.
+ */
+void notify_send(const std::string& title, const std::string& body) {
+    Process process("notify-send");
+    process.arg("--urgency=normal");
+    process.arg("--app-name=yabridge");
+    process.arg(title);
+    process.arg(body);
+
+    // We will have printed the message to the terminal anyways, so if the user
+    // doesn't have libnotify installed we'll just fail silently
+    process.spawn_get_status();
+}
+
+/**
+ * Sends notifications from a background thread, started when the first
+ * notification gets queued. The destructor runs when the library gets
+ * unloaded, and it waits for the queued notifications to be sent so the
+ * thread never outlives the library's code.
+ */
+class NotificationSender {
+   public:
+    ~NotificationSender() noexcept {
+        {
+            std::lock_guard lock(mutex_);
+            shutting_down_ = true;
+        }
+        queue_cv_.notify_one();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    static NotificationSender& get() {
+        static NotificationSender sender;
+
+        return sender;
+    }
+
+    /**
+     * Queue a notification, unless an identical notification has already been
+     * queued before.
+     */
+    bool send(std::string title, std::string body) {
+        std::lock_guard lock(mutex_);
+        if (!sent_.emplace(title, body).second) {
+            return false;
+        }
+
+        queue_.emplace_back(std::move(title), std::move(body));
+        if (!thread_.joinable()) {
+            thread_ = std::thread([this]() { run(); });
+        } else {
+            queue_cv_.notify_one();
+        }
+
+        return true;
+    }
+
+   private:
+    NotificationSender() = default;
+
+    void run() {
+        pthread_setname_np(pthread_self(), "notifications");
+
+        // libdbus is only loaded on this thread, and only once
+        LibDBus dbus;
+
+        std::unique_lock lock(mutex_);
+        while (true) {
+            queue_cv_.wait(lock,
+                           [&]() { return shutting_down_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+
+            const auto [title, body] = std::move(queue_.front());
+            queue_.pop_front();
+
+            lock.unlock();
+            if (!(dbus.loaded() && dbus.notify(title, body))) {
+                notify_send(title, body);
+            }
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::pair<std::string, std::string>> queue_;
+    /**
+     * Every notification that has been queued so far, used to only show
+     * identical notifications once.
+     */
+    std::set<std::pair<std::string, std::string>> sent_;
+    bool shutting_down_ = false;
+
+    std::thread thread_;
+};
+
+}  // namespace
 
 bool send_notification(const std::string& title,
                        const std::string body,
@@ -49,22 +348,7 @@ bool send_notification(const std::string& title,
         }
     }
 
-    Process process("notify-send");
-    process.arg("--urgency=normal");
-    process.arg("--app-name=yabridge");
-    process.arg(title);
-    process.arg(formatted_body.str());
-
-    // We will have printed the message to the terminal anyways, so if the user
-    // doesn't have libnotify installed we'll just fail silently
-    const auto result = process.spawn_get_status();
-    return std::visit(
-        overload{
-            [](int status) -> bool { return status == EXIT_SUCCESS; },
-            [](const Process::CommandNotFound&) -> bool { return false; },
-            [](const std::error_code&) -> bool { return false; },
-        },
-        result);
+    return NotificationSender::get().send(title, formatted_body.str());
 }
 
 std::string xml_escape(std::string string) {
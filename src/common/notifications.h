@@ -22,14 +22,16 @@
 #include <ghc/filesystem.hpp>
 #include <optional>
 
-// TODO: At some point, provide an alternative to notify-send by dlopen()-ing
-//       libdbus instead. Some more obscure distros won't have notify-send
-//       available.
-
 /**
- * Send a desktop notification using `notify-send`. Used for diagnostics when a
- * plugin fails to load since the user may not be checking the output in a
- * terminal.
+ * Send a desktop notification. Used for diagnostics when a plugin fails to load
+ * since the user may not be checking the output in a terminal. The
+ * notification is sent asynchronously from a background thread so this never
+ * blocks the plugin's initialization. It's sent directly over D-Bus using a
+ * `dlopen()`-ed libdbus, with `notify-send` as a fallback. Identical
+ * notifications are only shown once per process, so a warning that applies to
+ * every plugin instance doesn't get repeated for each of them. Notifications
+ * that are still queued when the library gets unloaded will be sent before
+ * unloading finishes.
  *
  * @param title The title (or technically, summary) of the notification.
  * @param body The message to display. This can contain line feeds, and it any
@@ -39,8 +41,8 @@
  *   notification will append a 'Source: <XXX.so>' hyperlink to the body so the
  *   user can more easily navigate to the plugin's path.
  *
- * @return Whether the notification was sent. This will be false if
- *   `notify-send` is not available.
+ * @return Whether the notification was queued. This will be false if an
+ *   identical notification has already been sent.
  */
 bool send_notification(const std::string& title,
                        const std::string body,
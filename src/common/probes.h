@@ -0,0 +1,49 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+/**
+ * Static tracepoints for `perf`, `bpftrace` and SystemTap. These are only
+ * compiled in when yabridge is built with `-Dusdt-probes=true`, in which case
+ * every probe is a single `nop` instruction until a tracer attaches to it. The
+ * probes all use the `yabridge` provider, so they can be listed with
+ * `bpftrace -l 'usdt:/path/to/libyabridge-vst2.so:yabridge:*'`. Probe
+ * arguments should be integers or pointers. The arguments are not evaluated
+ * when the probes are compiled out.
+ *
+ * - `process_begin(sample_frames)` and `process_end(sample_frames)`: The native
+ *   plugin's audio processing function.
+ * - `plugin_process_begin(sample_frames)` and
+ *   `plugin_process_end(sample_frames)`: The Windows plugin's audio processing
+ *   function, in the Wine plugin host.
+ * - `message_write(size)` and `message_read(size)`: A serialized object of
+ *   `size` bytes being written to or read from a socket.
+ * - `secondary_socket_opened()`: An additional socket that was connected to
+ *   handle concurrent requests.
+ * - `mutual_recursion_enter()` and `mutual_recursion_exit()`: Around
+ *   `MutualRecursionHelper::fork()`.
+ * - `audio_shm_resize(capacity, remapped)`: The shared audio buffers were
+ *   resized, and `remapped` is 1 if they had to be remapped for that.
+ */
+#ifdef WITH_USDT_PROBES
+#include <sys/sdt.h>
+
+#define YABRIDGE_PROBE(name, ...) \
+    STAP_PROBEV(yabridge, name __VA_OPT__(, ) __VA_ARGS__)
+#else
+#define YABRIDGE_PROBE(name, ...) ((void)0)
+#endif
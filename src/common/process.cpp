@@ -17,13 +17,70 @@
 #include "process.h"
 
 #include <cassert>
+#include <charconv>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include <spawn.h>
 #include <sys/wait.h>
 
 namespace fs = ghc::filesystem;
 
+namespace {
+
+/**
+ * Add file actions that close all non-STDIO file descriptors in the child
+ * process. On older glibc versions without
+ * `posix_spawn_file_actions_addclosefrom_np()` we'll only close the file
+ * descriptors that are actually open. Adding a close action for every possible
+ * file descriptor up to `_SC_OPEN_MAX` can add hundreds of thousands of file
+ * actions when the file descriptor limit has been raised, and the child would
+ * then have to make just as many system calls before it can run the command.
+ *
+ * NOTE: On those older glibc versions this is only a best effort. The list of
+ *       open file descriptors is a snapshot taken before spawning, so file
+ *       descriptors that the host's other threads open without `O_CLOEXEC`
+ *       in between taking that snapshot and `posix_spawnp()` will still leak
+ *       into the child process. If `/proc/self/fd` can't be read, then we'll
+ *       fall back to closing every possible file descriptor, which does not
+ *       have this race.
+ */
+void add_close_non_stdio_fds(posix_spawn_file_actions_t& actions) {
+#if (__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)
+    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#else
+    std::error_code err;
+    std::vector<int> open_fds;
+    for (const auto& entry : fs::directory_iterator("/proc/self/fd", err)) {
+        const std::string fd_str = entry.path().filename().string();
+        int fd = -1;
+        if (std::from_chars(fd_str.data(), fd_str.data() + fd_str.size(), fd)
+                    .ec == std::errc() &&
+            fd > STDERR_FILENO) {
+            open_fds.push_back(fd);
+        }
+    }
+
+    // NOTE: This list will also contain the directory iterator's own file
+    //       descriptor. Closing file descriptors that are not open is not
+    //       treated as an error by `posix_spawn()`.
+    if (!err) {
+        for (const int fd : open_fds) {
+            posix_spawn_file_actions_addclose(&actions, fd);
+        }
+    } else {
+        const int max_fds = static_cast<int>(sysconf(_SC_OPEN_MAX));
+        for (int fd = STDERR_FILENO + 1; fd < max_fds; fd++) {
+            posix_spawn_file_actions_addclose(&actions, fd);
+        }
+    }
+#endif
+}
+
+}  // namespace
+
 bool pid_running(pid_t pid) {
     // In theory you could `kill(0)` a process to check if it's still active,
     // but that doesn't distinguish between actually running processes and
@@ -59,41 +116,66 @@ std::vector<fs::path> get_augmented_search_path() {
     //        technically get rid of this, but we could also leave it in place
     //        since this may still cause other crashes for the user if we don't
     //        do it.
-    try {
-        std::locale("");
-    } catch (const std::runtime_error&) {
-        // We normally avoid modifying the current process' environment and
-        // instead use `boost::process::environment` to only modify the
-        // environment of launched child processes, but in this case we do need
-        // to fix this
-        // TODO: We don't have access to the logger here, so we cannot yet
-        //       properly print the message inform the user that their locale is
-        //       broken when this happens
-        std::cerr << std::endl;
-        std::cerr << "WARNING: Your locale is broken. Yabridge was kind enough "
-                     "to monkey patch it for you in this DAW session, but you "
-                     "should probably take a look at it ;)"
-                  << std::endl;
-        std::cerr << std::endl;
-
-        setenv("LC_ALL", "C", true);  // NOLINT(concurrency-mt-unsafe)
-    }
+    static std::once_flag locale_checked;
+    std::call_once(locale_checked, []() {
+        try {
+            std::locale("");
+        } catch (const std::runtime_error&) {
+            // We normally avoid modifying the current process' environment and
+            // instead use `boost::process::environment` to only modify the
+            // environment of launched child processes, but in this case we do
+            // need to fix this
+            // TODO: We don't have access to the logger here, so we cannot yet
+            //       properly print the message inform the user that their
+            //       locale is broken when this happens
+            std::cerr << std::endl;
+            std::cerr << "WARNING: Your locale is broken. Yabridge was kind "
+                         "enough to monkey patch it for you in this DAW "
+                         "session, but you should probably take a look at it ;)"
+                      << std::endl;
+            std::cerr << std::endl;
+
+            setenv("LC_ALL", "C", true);  // NOLINT(concurrency-mt-unsafe)
+        }
+    });
 
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
     const char* path_env = getenv("PATH");
     assert(path_env);
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* xdg_data_home = getenv("XDG_DATA_HOME");
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* home_directory = getenv("HOME");
+
+    // This gets called every time we launch a Wine plugin host, but these
+    // environment variables will almost never change during the host's
+    // lifetime. The search path is thus built once and then only rebuilt if
+    // one of them does change.
+    using CacheKey = std::tuple<std::string, std::optional<std::string>,
+                                std::optional<std::string>>;
+    static std::mutex cache_mutex;
+    static std::optional<std::pair<CacheKey, std::vector<fs::path>>> cache;
+
+    CacheKey key(path_env,
+                 xdg_data_home ? std::optional<std::string>(xdg_data_home)
+                               : std::nullopt,
+                 home_directory ? std::optional<std::string>(home_directory)
+                                : std::nullopt);
+    std::lock_guard lock(cache_mutex);
+    if (cache && cache->first == key) {
+        return cache->second;
+    }
 
     std::vector<fs::path> search_path = split_path(path_env);
-
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    if (const char* xdg_data_home = getenv("XDG_DATA_HOME")) {
+    if (xdg_data_home) {
         search_path.push_back(fs::path(xdg_data_home) / "yabridge");
-        // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    } else if (const char* home_directory = getenv("HOME")) {
+    } else if (home_directory) {
         search_path.push_back(fs::path(home_directory) / ".local" / "share" /
                               "yabridge");
     }
 
+    cache.emplace(std::move(key), search_path);
+
     return search_path;
 }
 
@@ -124,9 +206,35 @@ std::vector<ghc::filesystem::path> split_path(
 std::optional<ghc::filesystem::path> search_in_path(
     const std::vector<ghc::filesystem::path>& path,
     const std::string_view& target) {
+    // Searching for `yabridge-host.exe` through a long `PATH` on every host
+    // launch means checking the same directories over and over again.
+    // Previous results are cached, but we'll still check whether the cached
+    // file is executable since it may have been removed in the meantime.
+    // Failed lookups are not cached.
+    static std::mutex cache_mutex;
+    static std::map<
+        std::pair<std::vector<ghc::filesystem::path>, std::string>,
+        ghc::filesystem::path>
+        cache;
+
+    auto key = std::pair(path, std::string(target));
+    {
+        std::lock_guard lock(cache_mutex);
+        if (auto it = cache.find(key); it != cache.end()) {
+            if (access(it->second.c_str(), X_OK) == 0) {
+                return it->second;
+            }
+
+            cache.erase(it);
+        }
+    }
+
     for (const auto& dir : path) {
         ghc::filesystem::path candidate = dir / target;
         if (access(candidate.c_str(), X_OK) == 0) {
+            std::lock_guard lock(cache_mutex);
+            cache[std::move(key)] = candidate;
+
             return candidate;
         }
     }
@@ -259,6 +367,7 @@ Process::StringResult Process::spawn_get_stdout_line() const {
     pid_t child_pid = 0;
     const auto result = posix_spawnp(&child_pid, command_.c_str(), &actions,
                                      nullptr, argv, envp);
+    posix_spawn_file_actions_destroy(&actions);
 
     close(stdout_pipe_fds[1]);
     if (result == 2) {
@@ -340,23 +449,17 @@ Process::HandleResult Process::spawn_child_piped(
                                      STDERR_FILENO);
     // We'll close the four pipe fds along with the rest of the file descriptors
 
-// NOTE: If the Wine process outlives the host, then it may cause issues if
-//       our process is still keeping the host's file descriptors alive
-//       that. This can prevent Ardour from restarting after an unexpected
-//       shutdown. Because of this we won't use `vfork()`, but instead we'll
-//       just manually close all non-STDIO file descriptors.
-#if (__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)
-    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
-#else
-    const int max_fds = static_cast<int>(sysconf(_SC_OPEN_MAX));
-    for (int fd = STDERR_FILENO + 1; fd < max_fds; fd++) {
-        posix_spawn_file_actions_addclose(&actions, fd);
-    }
-#endif
+    // NOTE: If the Wine process outlives the host, then it may cause issues if
+    //       our process is still keeping the host's file descriptors alive
+    //       that. This can prevent Ardour from restarting after an unexpected
+    //       shutdown. Because of this we won't use `vfork()`, but instead we'll
+    //       just manually close all non-STDIO file descriptors.
+    add_close_non_stdio_fds(actions);
 
     pid_t child_pid = 0;
     const auto result = posix_spawnp(&child_pid, command_.c_str(), &actions,
                                      nullptr, argv, envp);
+    posix_spawn_file_actions_destroy(&actions);
 
     // We'll assign the read ends of the pipes to the Asio stream descriptors
     // passed to this function, even if launching the process failed.
@@ -400,18 +503,12 @@ Process::HandleResult Process::spawn_child_redirected(
                                      O_WRONLY | O_CREAT | O_APPEND, 0640);
 
     // See the note in the other function
-#if (__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)
-    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
-#else
-    const int max_fds = static_cast<int>(sysconf(_SC_OPEN_MAX));
-    for (int fd = STDERR_FILENO + 1; fd < max_fds; fd++) {
-        posix_spawn_file_actions_addclose(&actions, fd);
-    }
-#endif
+    add_close_non_stdio_fds(actions);
 
     pid_t child_pid = 0;
     const auto result = posix_spawnp(&child_pid, command_.c_str(), &actions,
                                      nullptr, argv, envp);
+    posix_spawn_file_actions_destroy(&actions);
     if (result == 2) {
         return Process::CommandNotFound{};
     } else if (result != 0) {
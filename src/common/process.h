@@ -53,6 +53,8 @@ bool pid_running(pid_t pid);
  * environment variable can be a big hurdle if you've never done anything like
  * that before. And since this is the recommended installation location, it
  * makes sense to also search there by default.
+ *
+ * The result is cached until `PATH`, `XDG_DATA_HOME` or `HOME` changes.
  */
 std::vector<ghc::filesystem::path> get_augmented_search_path();
 
@@ -64,7 +66,9 @@ std::vector<ghc::filesystem::path> split_path(const std::string_view& path_env);
 
 /**
  * Search through a search path vector created by `split_path` for an executable
- * binary called `target`, returning the first match if any.
+ * binary called `target`, returning the first match if any. Matches are cached
+ * for the lifetime of the process for every combination of search path and
+ * target, as long as the matched file stays executable.
  */
 std::optional<ghc::filesystem::path> search_in_path(
     const std::vector<ghc::filesystem::path>& path,
@@ -125,6 +129,12 @@ class ProcessEnvironment {
  * A child process whose output can be captured. Simple wrapper around the Posix
  * APIs. The functions provided for running processes this way are very much
  * tailored towards yabridge's needs.
+ *
+ * All processes are launched with `posix_spawn()`. glibc implements this using
+ * `clone(CLONE_VM | CLONE_VFORK)`, so unlike `fork()` the cost of spawning a
+ * process does not depend on the size of the host's address space. The argument
+ * and environment arrays are built before spawning the process, so the child
+ * never has to allocate.
  */
 class Process {
    public:
@@ -0,0 +1,434 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "realtime-allocation-check.h"
+
+#ifdef WITH_REALTIME_ALLOCATION_CHECK
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <execinfo.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * How many `ScopedRealtimeSection`s are currently alive on this thread. This
+ * needs to be a trivially constructible type since it's accessed from within
+ * `operator new`.
+ */
+thread_local int realtime_section_depth = 0;
+
+/**
+ * Set when `YABRIDGE_ALLOCATION_PROFILE` is set. In that case allocations are
+ * counted per thread instead of aborting, and a report gets printed to STDERR
+ * when the process exits.
+ */
+bool profiling_enabled = false;
+
+/**
+ * The profiler's state has to live in fixed size static storage since we
+ * can't allocate from within `operator new`. Threads beyond the last slot all
+ * share that slot.
+ */
+constexpr size_t max_profiled_threads = 256;
+constexpr size_t max_recorded_stacks = 64;
+constexpr size_t max_stack_depth = 32;
+/**
+ * How often we'll reread a thread's name. Threads are usually named after they
+ * made their first allocation.
+ */
+constexpr uint32_t name_refresh_interval = 1024;
+
+struct ProfiledThread {
+    /**
+     * The name as returned by `PR_GET_NAME`, which is at most 16 bytes
+     * including the terminating null byte.
+     */
+    std::array<char, 16> name;
+    std::atomic_uint64_t allocations;
+    std::atomic_uint64_t frees;
+    /**
+     * Allocations and frees made inside of a `ScopedRealtimeSection`.
+     */
+    std::atomic_uint64_t realtime_allocations;
+};
+
+/**
+ * A unique call stack that allocated inside of a realtime section.
+ */
+struct RecordedStack {
+    /**
+     * Set after the frames have been written.
+     */
+    std::atomic_bool ready;
+    uint64_t hash;
+    std::array<void*, max_stack_depth> frames;
+    int depth;
+    std::atomic_uint64_t count;
+};
+
+std::array<ProfiledThread, max_profiled_threads> profiled_threads{};
+std::atomic_size_t num_profiled_threads = 0;
+std::array<RecordedStack, max_recorded_stacks> recorded_stacks{};
+std::atomic_size_t num_recorded_stacks = 0;
+/**
+ * Realtime allocations we could not record a stack for because all slots were
+ * taken.
+ */
+std::atomic_uint64_t num_dropped_stacks = 0;
+std::atomic_bool profile_written = false;
+
+thread_local ProfiledThread* current_profiled_thread = nullptr;
+thread_local uint32_t allocations_since_name_refresh = 0;
+/**
+ * Set while this thread is inside of the profiler, since `backtrace()` may
+ * allocate the first time it gets called.
+ */
+thread_local bool in_profiler = false;
+
+/**
+ * Write a string to STDERR without allocating.
+ */
+void write_stderr(const char* message) noexcept {
+    [[maybe_unused]] const ssize_t written =
+        write(STDERR_FILENO, message, strlen(message));
+}
+
+/**
+ * Get this thread's slot in `profiled_threads`, claiming a new one on the
+ * first call.
+ */
+ProfiledThread& profiled_thread() noexcept {
+    if (!current_profiled_thread) [[unlikely]] {
+        const size_t index =
+            num_profiled_threads.fetch_add(1, std::memory_order_relaxed);
+        current_profiled_thread =
+            &profiled_threads[std::min(index, max_profiled_threads - 1)];
+        allocations_since_name_refresh = name_refresh_interval;
+    }
+
+    if (allocations_since_name_refresh++ >= name_refresh_interval) {
+        allocations_since_name_refresh = 0;
+        if (current_profiled_thread == &profiled_threads.back() &&
+            num_profiled_threads.load(std::memory_order_relaxed) >
+                max_profiled_threads) {
+            strncpy(current_profiled_thread->name.data(), "<other>",
+                    current_profiled_thread->name.size());
+        } else {
+            prctl(PR_GET_NAME, current_profiled_thread->name.data(), 0, 0, 0);
+        }
+    }
+
+    return *current_profiled_thread;
+}
+
+/**
+ * Record the current call stack, or increment the counter for an existing
+ * identical stack. This is never inlined so we can reliably skip its own frame
+ * in the report.
+ */
+[[gnu::noinline]] void record_realtime_stack() noexcept {
+    std::array<void*, max_stack_depth> frames;
+    const int depth = backtrace(frames.data(), frames.size());
+
+    // FNV-1a over the return addresses
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < depth; i++) {
+        hash ^= reinterpret_cast<uintptr_t>(frames[i]);
+        hash *= 1099511628211ull;
+    }
+
+    const size_t num_stacks = std::min(
+        num_recorded_stacks.load(std::memory_order_acquire),
+        max_recorded_stacks);
+    for (size_t i = 0; i < num_stacks; i++) {
+        RecordedStack& stack = recorded_stacks[i];
+        if (stack.ready.load(std::memory_order_acquire) && stack.hash == hash) {
+            stack.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Two threads recording the same new stack at the same time will end up
+    // with two entries, which is fine for a report
+    const size_t index =
+        num_recorded_stacks.fetch_add(1, std::memory_order_acq_rel);
+    if (index >= max_recorded_stacks) {
+        num_dropped_stacks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    RecordedStack& stack = recorded_stacks[index];
+    stack.hash = hash;
+    stack.frames = frames;
+    stack.depth = depth;
+    stack.count.store(1, std::memory_order_relaxed);
+    stack.ready.store(true, std::memory_order_release);
+}
+
+/**
+ * Count an allocation or free for the current thread when profiling.
+ */
+void profile_allocation(bool is_free) noexcept {
+    if (in_profiler) {
+        return;
+    }
+    in_profiler = true;
+
+    ProfiledThread& thread = profiled_thread();
+    if (is_free) {
+        thread.frees.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        thread.allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (realtime_section_depth > 0) [[unlikely]] {
+        thread.realtime_allocations.fetch_add(1, std::memory_order_relaxed);
+        record_realtime_stack();
+    }
+
+    in_profiler = false;
+}
+
+/**
+ * Print the profile. Threads with the same name are merged together. This
+ * works on a best effort basis if other threads are still allocating.
+ */
+void print_allocation_profile() noexcept {
+    in_profiler = true;
+
+    std::array<char, 256> line;
+    const auto write_line = [&](const char* format, auto... args) {
+        snprintf(line.data(), line.size(), format, args...);
+        write_stderr(line.data());
+    };
+
+    write_line("[yabridge] Allocation profile for process %d:\n", getpid());
+    write_line("[yabridge] %-16s %8s %12s %12s %12s\n", "thread", "threads",
+               "allocations", "frees", "realtime");
+
+    const size_t num_threads =
+        std::min(num_profiled_threads.load(), max_profiled_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+        const ProfiledThread& thread = profiled_threads[i];
+        bool already_printed = false;
+        for (size_t j = 0; j < i; j++) {
+            if (profiled_threads[j].name == thread.name) {
+                already_printed = true;
+                break;
+            }
+        }
+        if (already_printed) {
+            continue;
+        }
+
+        size_t threads = 0;
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t realtime_allocations = 0;
+        for (size_t j = i; j < num_threads; j++) {
+            const ProfiledThread& other = profiled_threads[j];
+            if (other.name == thread.name) {
+                threads++;
+                allocations += other.allocations.load();
+                frees += other.frees.load();
+                realtime_allocations += other.realtime_allocations.load();
+            }
+        }
+
+        // The name is always null terminated by `PR_GET_NAME`
+        write_line("[yabridge] %-16s %8zu %12" PRIu64 " %12" PRIu64
+                   " %12" PRIu64 "\n",
+                   thread.name[0] ? thread.name.data() : "<unnamed>", threads,
+                   allocations, frees, realtime_allocations);
+    }
+
+    const size_t num_stacks =
+        std::min(num_recorded_stacks.load(), max_recorded_stacks);
+    for (size_t i = 0; i < num_stacks; i++) {
+        const RecordedStack& stack = recorded_stacks[i];
+        if (!stack.ready.load()) {
+            continue;
+        }
+
+        write_line("[yabridge]\n[yabridge] %" PRIu64
+                   " allocations or frees during audio processing from:\n",
+                   stack.count.load());
+        // Skip the frame for `record_realtime_stack()` itself
+        if (stack.depth > 1) {
+            backtrace_symbols_fd(stack.frames.data() + 1, stack.depth - 1,
+                                 STDERR_FILENO);
+        }
+    }
+    if (const uint64_t dropped = num_dropped_stacks.load(); dropped > 0) {
+        write_line("[yabridge]\n[yabridge] %" PRIu64
+                   " more allocations or frees during audio processing "
+                   "came from call stacks that were not recorded\n",
+                   dropped);
+    }
+}
+
+/**
+ * Read `YABRIDGE_ALLOCATION_PROFILE` when the library or the Wine plugin host
+ * gets loaded, and set up the exit handler for printing the report.
+ */
+__attribute__((constructor)) void init_allocation_profiling() {
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* profile_env = getenv("YABRIDGE_ALLOCATION_PROFILE");
+    if (!profile_env || profile_env[0] == '\0') {
+        return;
+    }
+
+    // The first call to `backtrace()` loads `libgcc_s`, which allocates. We
+    // don't want that to happen for the first time on the audio thread.
+    std::array<void*, 1> frames;
+    backtrace(frames.data(), frames.size());
+
+    profiling_enabled = true;
+    atexit(write_allocation_profile);
+}
+
+/**
+ * Abort if the current thread is in a realtime section. We can't use any of
+ * the normal logging facilities here since those would allocate. When
+ * profiling, the allocation is counted instead.
+ */
+void check_allocation(const char* function, bool is_free) noexcept {
+    if (profiling_enabled) [[unlikely]] {
+        profile_allocation(is_free);
+        return;
+    }
+
+    if (realtime_section_depth > 0) [[unlikely]] {
+        // Prevent recursion in case anything below ends up allocating
+        realtime_section_depth = 0;
+
+        write_stderr("[yabridge] Realtime allocation check failed: ");
+        write_stderr(function);
+        write_stderr(" was called during audio processing\n");
+
+        std::abort();
+    }
+}
+
+void* checked_allocate(std::size_t size, const char* function) {
+    check_allocation(function, false);
+
+    // `operator new` should return a unique pointer even for empty allocations
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void checked_free(void* ptr, const char* function) noexcept {
+    if (ptr) {
+        check_allocation(function, true);
+        std::free(ptr);
+    }
+}
+
+}  // namespace
+
+void write_allocation_profile() noexcept {
+    if (profiling_enabled && !profile_written.exchange(true)) {
+        print_allocation_profile();
+    }
+}
+
+ScopedRealtimeSection::ScopedRealtimeSection() noexcept {
+    realtime_section_depth++;
+}
+
+ScopedRealtimeSection::~ScopedRealtimeSection() noexcept {
+    if (realtime_section_depth > 0) {
+        realtime_section_depth--;
+    }
+}
+
+ScopedRealtimeSectionExit::ScopedRealtimeSectionExit() noexcept
+    : previous_depth_(realtime_section_depth) {
+    realtime_section_depth = 0;
+}
+
+ScopedRealtimeSectionExit::~ScopedRealtimeSectionExit() noexcept {
+    realtime_section_depth = previous_depth_;
+}
+
+// These are the replaceable global allocation functions. The aligned variants
+// are left alone since we never use overaligned types on the audio thread.
+// NOLINTBEGIN(cert-dcl54-cpp,misc-new-delete-overloads)
+
+void* operator new(std::size_t size) {
+    return checked_allocate(size, "operator new");
+}
+
+void* operator new[](std::size_t size) {
+    return checked_allocate(size, "operator new[]");
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return checked_allocate(size, "operator new");
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return checked_allocate(size, "operator new[]");
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept {
+    checked_free(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr) noexcept {
+    checked_free(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    checked_free(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    checked_free(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    checked_free(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    checked_free(ptr, "operator delete[]");
+}
+
+// NOLINTEND(cert-dcl54-cpp,misc-new-delete-overloads)
+
+#endif
@@ -0,0 +1,97 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+/**
+ * Marks the current thread as being in a realtime section for as long as this
+ * object is alive. If yabridge was built with the `realtime-allocation-check`
+ * build option, then any call to `operator new` or `operator delete` on this
+ * thread while this object is alive will print the offending call and abort
+ * the process so it can be inspected with a debugger. This lets us enforce
+ * that our audio processing paths never allocate, instead of just hoping they
+ * don't. Without the build option this does nothing and it will be optimized
+ * away entirely.
+ *
+ * When the `YABRIDGE_ALLOCATION_PROFILE` environment variable is set, the
+ * allocation functions won't abort and they will instead count every
+ * allocation per thread. Allocations made inside of these sections are counted
+ * separately together with their call stacks. See `write_allocation_profile()`.
+ *
+ * These sections can be nested. Host callbacks made from the audio thread
+ * should be kept outside of these sections, since the host may allocate
+ * there.
+ *
+ * @note This only checks the C++ allocation functions. In the Wine plugin host
+ *   this only covers yabridge's own code, since Windows plugins allocate
+ *   through the Windows heap functions.
+ */
+class ScopedRealtimeSection {
+   public:
+#ifdef WITH_REALTIME_ALLOCATION_CHECK
+    ScopedRealtimeSection() noexcept;
+    ~ScopedRealtimeSection() noexcept;
+#else
+    ScopedRealtimeSection() noexcept {}
+    ~ScopedRealtimeSection() noexcept {}
+#endif
+
+    ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+    ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+};
+
+/**
+ * Leaves all `ScopedRealtimeSection`s on the current thread for as long as this
+ * object is alive, and enters them again afterwards. This is meant for error
+ * paths in realtime sections that are about to throw an exception, since
+ * constructing the exception allocates. Without the `realtime-allocation-check`
+ * build option this does nothing.
+ */
+class ScopedRealtimeSectionExit {
+   public:
+#ifdef WITH_REALTIME_ALLOCATION_CHECK
+    ScopedRealtimeSectionExit() noexcept;
+    ~ScopedRealtimeSectionExit() noexcept;
+#else
+    ScopedRealtimeSectionExit() noexcept {}
+    ~ScopedRealtimeSectionExit() noexcept {}
+#endif
+
+    ScopedRealtimeSectionExit(const ScopedRealtimeSectionExit&) = delete;
+    ScopedRealtimeSectionExit& operator=(const ScopedRealtimeSectionExit&) =
+        delete;
+
+#ifdef WITH_REALTIME_ALLOCATION_CHECK
+   private:
+    int previous_depth_;
+#endif
+};
+
+/**
+ * Print the allocation profile gathered when `YABRIDGE_ALLOCATION_PROFILE` is
+ * set to STDERR. This lists the number of allocations and frees per thread
+ * name, followed by the deduplicated call stacks of the allocations made
+ * inside of a `ScopedRealtimeSection`. This is called automatically when the
+ * process exits normally, and it only prints the profile once. The Wine plugin
+ * host calls this manually before terminating itself since that skips the
+ * exit handlers. Does nothing if profiling is disabled or if yabridge was not
+ * built with the `realtime-allocation-check` build option.
+ */
+#ifdef WITH_REALTIME_ALLOCATION_CHECK
+void write_allocation_profile() noexcept;
+#else
+inline void write_allocation_profile() noexcept {}
+#endif
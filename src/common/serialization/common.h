@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <type_traits>
 
+#include "../bitsery/ext/in-place-optional.h"
 #include "../plugins.h"
 
 // The plugin should always be compiled to a 64-bit version, but the host
@@ -43,6 +44,46 @@ struct Ack {
     void serialize(S&) {}
 };
 
+/**
+ * The optional fast paths supported by one side of the bridge. The Wine plugin
+ * host sends its capabilities to the native plugin during startup, and the
+ * native plugin will then turn off any of the options in its `Configuration`
+ * that the Wine plugin host does not support before sending that configuration
+ * back. This way both sides always agree on which fast paths are in use, even
+ * if the native plugin library and the Wine plugin host are out of sync.
+ *
+ * NOTE: This only covers features that can be turned on and off at runtime.
+ *       Changes to the serialization format itself still require both sides
+ *       to use the same version of yabridge.
+ * NOTE: Flags should only ever be added, and their values should never be
+ *       reused.
+ */
+struct Capabilities {
+    enum Flag : uint64_t {
+        futex_signalling = 1 << 0,
+        vst2_pipelined_processing = 1 << 1,
+        vst3_fast_offline_processing = 1 << 2,
+        pinned_audio_buffers = 1 << 3,
+    };
+
+    /**
+     * All capabilities supported by this version of yabridge.
+     */
+    static constexpr uint64_t all = futex_signalling |
+                                    vst2_pipelined_processing |
+                                    vst3_fast_offline_processing |
+                                    pinned_audio_buffers;
+
+    bool supports(Flag flag) const noexcept { return (flags & flag) != 0; }
+
+    uint64_t flags = all;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value8b(flags);
+    }
+};
+
 /**
  * An object containing the startup options for hosting a plugin. These options
  * are passed to `yabridge-host.exe` as command line arguments, and they are
@@ -53,6 +94,13 @@ struct HostRequest {
     std::string plugin_path;
     std::string endpoint_base_dir;
     pid_t parent_pid;
+    /**
+     * The plugin's actual library file, set when the `group_parallel_loading`
+     * option is enabled. Group host processes will then load this library on a
+     * separate thread before initializing the plugin on the main thread. This
+     * is ignored by individually hosted plugins.
+     */
+    std::optional<std::string> preload_library_path;
 
     template <typename S>
     void serialize(S& s) {
@@ -60,6 +108,8 @@ struct HostRequest {
         s.text1b(plugin_path, 4096);
         s.text1b(endpoint_base_dir, 4096);
         s.value4b(parent_pid);
+        s.ext(preload_library_path, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.text1b(v, 4096); });
     }
 };
 
@@ -16,6 +16,40 @@
 
 #include "vst2.h"
 
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+
+/**
+ * Call `fn(index, lhs_field, rhs_field)` for every value field in two `AEffect`
+ * structs, in the same order as `serialize(S&, AEffect&)`.
+ */
+template <typename L, typename R, typename F>
+void for_each_aeffect_field(L& lhs, R& rhs, F&& fn) {
+    fn(0, lhs.magic, rhs.magic);
+    fn(1, lhs.numPrograms, rhs.numPrograms);
+    fn(2, lhs.numParams, rhs.numParams);
+    fn(3, lhs.numInputs, rhs.numInputs);
+    fn(4, lhs.numOutputs, rhs.numOutputs);
+    fn(5, lhs.flags, rhs.flags);
+    fn(6, lhs.initialDelay, rhs.initialDelay);
+    fn(7, lhs.empty3a, rhs.empty3a);
+    fn(8, lhs.empty3b, rhs.empty3b);
+    fn(9, lhs.unkown_float, rhs.unkown_float);
+    fn(10, lhs.uniqueID, rhs.uniqueID);
+    fn(11, lhs.version, rhs.version);
+}
+
+/**
+ * The index of `initialDelay` in `for_each_aeffect_field()`.
+ */
+constexpr size_t initial_delay_field = 6;
+
+}  // namespace
+
 AEffect& update_aeffect(AEffect& plugin,
                         const AEffect& updated_plugin) noexcept {
     plugin.magic = updated_plugin.magic;
@@ -34,10 +68,177 @@ AEffect& update_aeffect(AEffect& plugin,
     return plugin;
 }
 
+AEffectDelta AEffectDelta::between(const AEffect& previous,
+                                   const AEffect& current) noexcept {
+    AEffectDelta delta{};
+    for_each_aeffect_field(
+        previous, current,
+        [&](size_t index, const auto& old_value, const auto& new_value) {
+            // Comparing bitwise also handles the float field
+            const auto old_bits = std::bit_cast<int32_t>(old_value);
+            const auto new_bits = std::bit_cast<int32_t>(new_value);
+            if (old_bits != new_bits) {
+                delta.changed_fields |= static_cast<uint16_t>(1 << index);
+                delta.values[index] = new_bits;
+            }
+        });
+
+    return delta;
+}
+
+AEffect& AEffectDelta::apply(AEffect& plugin) const noexcept {
+    for_each_aeffect_field(
+        plugin, plugin, [&](size_t index, auto& field, const auto&) {
+            if (changed_fields & (1 << index)) {
+                field =
+                    std::bit_cast<std::remove_cvref_t<decltype(field)>>(
+                        values[index]);
+            }
+        });
+
+    return plugin;
+}
+
+int32_t* AEffectDelta::initial_delay() noexcept {
+    if (changed_fields & (1 << initial_delay_field)) {
+        return &values[initial_delay_field];
+    } else {
+        return nullptr;
+    }
+}
+
+uint64_t hash_chunk_data(const std::vector<uint8_t>& buffer) noexcept {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const uint8_t byte : buffer) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+void Vst2TimeInfoEncoder::encode(const VstTimeInfo* current,
+                                 int sample_frames,
+                                 Vst2TimeInfoDelta& delta) noexcept {
+    // The decoder's state only changes when we send transport information, so
+    // we won't touch our own state either if there's nothing to send
+    if (!current) {
+        delta.changed_fields = 0;
+        return;
+    }
+
+    uint16_t changed_fields = Vst2TimeInfoDelta::has_time_info;
+    if (!has_last_time_info_) {
+        changed_fields |= Vst2TimeInfoDelta::all_fields;
+    } else {
+        const VstTimeInfo& last = last_time_info_;
+        // The decoder makes this exact same prediction, so comparing the
+        // floating point values for equality is fine here
+        if (current->samplePos != last.samplePos + last_sample_frames_) {
+            changed_fields |= Vst2TimeInfoDelta::sample_pos;
+        }
+        if (current->sampleRate != last.sampleRate) {
+            changed_fields |= Vst2TimeInfoDelta::sample_rate;
+        }
+        if (current->nanoSeconds != last.nanoSeconds) {
+            changed_fields |= Vst2TimeInfoDelta::nano_seconds;
+        }
+        if (current->ppqPos != last.ppqPos) {
+            changed_fields |= Vst2TimeInfoDelta::ppq_pos;
+        }
+        if (current->tempo != last.tempo) {
+            changed_fields |= Vst2TimeInfoDelta::tempo;
+        }
+        if (current->barStartPos != last.barStartPos) {
+            changed_fields |= Vst2TimeInfoDelta::bar_start_pos;
+        }
+        if (current->cycleStartPos != last.cycleStartPos) {
+            changed_fields |= Vst2TimeInfoDelta::cycle_start_pos;
+        }
+        if (current->cycleEndPos != last.cycleEndPos) {
+            changed_fields |= Vst2TimeInfoDelta::cycle_end_pos;
+        }
+        if (current->timeSigNumerator != last.timeSigNumerator ||
+            current->timeSigDenominator != last.timeSigDenominator) {
+            changed_fields |= Vst2TimeInfoDelta::time_signature;
+        }
+        if (current->flags != last.flags ||
+            !std::equal(std::begin(current->empty3), std::end(current->empty3),
+                        std::begin(last.empty3))) {
+            changed_fields |= Vst2TimeInfoDelta::flags;
+        }
+    }
+
+    delta.changed_fields = changed_fields;
+    delta.time_info = *current;
+
+    last_time_info_ = *current;
+    last_sample_frames_ = sample_frames;
+    has_last_time_info_ = true;
+}
+
+const VstTimeInfo* Vst2TimeInfoDecoder::decode(const Vst2TimeInfoDelta& delta,
+                                               int sample_frames) noexcept {
+    const uint16_t changed_fields = delta.changed_fields;
+    if (!(changed_fields & Vst2TimeInfoDelta::has_time_info)) {
+        return nullptr;
+    }
+
+    VstTimeInfo& time_info = last_time_info_;
+    const VstTimeInfo& new_time_info = delta.time_info;
+    if (changed_fields & Vst2TimeInfoDelta::sample_pos) {
+        time_info.samplePos = new_time_info.samplePos;
+    } else {
+        time_info.samplePos += last_sample_frames_;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::sample_rate) {
+        time_info.sampleRate = new_time_info.sampleRate;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::nano_seconds) {
+        time_info.nanoSeconds = new_time_info.nanoSeconds;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::ppq_pos) {
+        time_info.ppqPos = new_time_info.ppqPos;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::tempo) {
+        time_info.tempo = new_time_info.tempo;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::bar_start_pos) {
+        time_info.barStartPos = new_time_info.barStartPos;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::cycle_start_pos) {
+        time_info.cycleStartPos = new_time_info.cycleStartPos;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::cycle_end_pos) {
+        time_info.cycleEndPos = new_time_info.cycleEndPos;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::time_signature) {
+        time_info.timeSigNumerator = new_time_info.timeSigNumerator;
+        time_info.timeSigDenominator = new_time_info.timeSigDenominator;
+    }
+    if (changed_fields & Vst2TimeInfoDelta::flags) {
+        std::copy(std::begin(new_time_info.empty3),
+                  std::end(new_time_info.empty3), std::begin(time_info.empty3));
+        time_info.flags = new_time_info.flags;
+    }
+
+    last_sample_frames_ = sample_frames;
+
+    return &time_info;
+}
+
 DynamicVstEvents::DynamicVstEvents() noexcept {}
 
-DynamicVstEvents::DynamicVstEvents(const VstEvents& c_events)
-    : events_(c_events.numEvents) {
+DynamicVstEvents::DynamicVstEvents(const VstEvents& c_events) {
+    assign(c_events);
+}
+
+void DynamicVstEvents::assign(const VstEvents& c_events) {
+    // These only change the sizes, so the buffers' capacities are kept
+    events_.resize(c_events.numEvents);
+    sysex_data_.clear();
+    sysex_buffer_.clear();
+
     // Copy from the C-style array into a vector for serialization
     for (int i = 0; i < c_events.numEvents; i++) {
         events_[i] = *c_events.events[i];
@@ -47,8 +248,11 @@ DynamicVstEvents::DynamicVstEvents(const VstEvents& c_events)
         const auto sysex_event =
             reinterpret_cast<VstMidiSysExEvent*>(c_events.events[i]);
         if (sysex_event->type == kVstSysExType) {
-            sysex_data_.emplace_back(
-                i, std::string(sysex_event->sysexDump, sysex_event->byteSize));
+            sysex_data_.emplace_back(i, sysex_buffer_.size());
+
+            const uint8_t* data =
+                reinterpret_cast<const uint8_t*>(sysex_event->sysexDump);
+            sysex_buffer_.append(data, data + sysex_event->byteSize);
         }
     }
 }
@@ -58,10 +262,11 @@ VstEvents& DynamicVstEvents::as_c_events() {
     // `VstEvents` struct by hand on the heap since it's actually a dynamically
     // sized object. If we encountered any SysEx events, then we'll need to
     // update the pointers in `events` to point to the correct data location.
-    for (const auto& [event_idx, data] : sysex_data_) {
+    for (const auto& [event_idx, offset] : sysex_data_) {
         auto& sysex_event =
             reinterpret_cast<VstMidiSysExEvent&>(events_[event_idx]);
-        sysex_event.sysexDump = const_cast<char*>(data.data());
+        sysex_event.sysexDump =
+            reinterpret_cast<char*>(sysex_buffer_.data() + offset);
     }
 
     // First we need to allocate enough memory for the entire object. The events
@@ -122,9 +327,12 @@ VstSpeakerArrangement& DynamicSpeakerArrangement::as_c_speaker_arrangement() {
     return *speaker_arrangement;
 }
 
-std::vector<uint8_t>& DynamicSpeakerArrangement::as_raw_data() {
-    // This will populate the buffer for us with the struct data
-    as_c_speaker_arrangement();
-
-    return speaker_arrangement_buffer_;
+void DynamicSpeakerArrangement::write_to(
+    VstSpeakerArrangement& speaker_arrangement) const noexcept {
+    // Building the object in our own buffer first and then copying that would
+    // only cost us two more copies
+    speaker_arrangement.flags = flags_;
+    speaker_arrangement.num_speakers = static_cast<int>(speakers_.size());
+    std::copy(speakers_.begin(), speakers_.end(),
+              speaker_arrangement.speakers);
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <variant>
 
 #include <bitsery/traits/array.h>
@@ -26,6 +27,7 @@
 #include "../audio-shm.h"
 #include "../bitsery/ext/in-place-optional.h"
 #include "../bitsery/ext/in-place-variant.h"
+#include "../bitsery/ext/shared-memory-blob.h"
 #include "../bitsery/traits/small-vector.h"
 #include "../utils.h"
 #include "../vst24.h"
@@ -64,6 +66,57 @@ constexpr size_t max_midi_events = max_buffer_size;
  */
 constexpr size_t binary_buffer_size = 50 << 20;
 
+/**
+ * The capacity in bytes of the request and response metadata regions in the
+ * shared audio buffers used for VST2 plugins. A serialized `Vst2ProcessRequest`
+ * takes up a bit over a hundred bytes, so this leaves plenty of room.
+ *
+ * @see AudioShmBuffer::Config::metadata_capacity
+ */
+constexpr uint32_t vst2_process_metadata_capacity = 512;
+
+/**
+ * The maximum number of MIDI events that will be sent together with a
+ * processing request when the `vst2_batch_midi_events` option is enabled.
+ * Larger batches are sent through `effProcessEvents()` instead.
+ *
+ * @see Vst2BatchedProcessRequest
+ */
+constexpr size_t max_batched_midi_events = 512;
+
+/**
+ * The maximum number of host callbacks the Wine plugin host will queue during a
+ * single processing cycle when the `vst2_async_automation` option is enabled.
+ * Any callbacks beyond this are sent to the host right away as usual.
+ *
+ * @see Vst2ProcessResponse
+ */
+constexpr size_t max_queued_host_callbacks = 512;
+
+/**
+ * The capacity in bytes of the metadata regions in the shared audio buffers
+ * when the `vst2_batch_midi_events` or `vst2_async_automation` options are
+ * enabled. A serialized `VstEvent` takes up a bit over 32 bytes, so this fits a
+ * `Vst2ProcessRequest` along with `max_batched_midi_events` events, and it also
+ * fits `max_queued_host_callbacks` queued host callbacks.
+ */
+constexpr uint32_t vst2_batched_process_metadata_capacity = 1 << 15;
+
+/**
+ * The maximum number of parameters described in a single
+ * `WantsParameterDescriptions` request when the `vst2_parameter_info_cache`
+ * option is enabled.
+ */
+constexpr int max_parameter_descriptions = 64;
+
+/**
+ * The maximum number of program names returned by a single `WantsProgramNames`
+ * request when the `vst2_program_name_cache` option is enabled. Almost all
+ * plugins have fewer programs than this, so their entire program list can be
+ * fetched at once.
+ */
+constexpr int max_program_names = 128;
+
 /**
  * Update an `AEffect` object, copying values from `updated_plugin` to `plugin`.
  * This will copy all flags and regular values, leaving all pointers in `plugin`
@@ -73,6 +126,13 @@ constexpr size_t binary_buffer_size = 50 << 20;
 AEffect& update_aeffect(AEffect& plugin,
                         const AEffect& updated_plugin) noexcept;
 
+/**
+ * Compute a 64-bit FNV-1a hash of some chunk data. This is used to tell whether
+ * a chunk returned by `effGetChunk()` is the same as the one the native plugin
+ * has cached when the `vst2_chunk_cache` option is enabled.
+ */
+uint64_t hash_chunk_data(const std::vector<uint8_t>& buffer) noexcept;
+
 /**
  * Wrapper for chunk data.
  */
@@ -83,7 +143,7 @@ struct ChunkData {
 
     template <typename S>
     void serialize(S& s) {
-        s.container1b(buffer, binary_buffer_size);
+        s.ext(buffer, bitsery::ext::SharedMemoryBlob(binary_buffer_size));
     }
 };
 
@@ -100,7 +160,10 @@ struct ChunkData {
  * can be reconstructed using the `as_c_events()` method.
  *
  * Using preallocated small vectors here gets rid of all event related
- * allocations in normal use cases.
+ * allocations in normal use cases. Objects that get reused for every processing
+ * cycle, either by deserializing into them or through `assign()` and copy
+ * assignment, keep all of their buffers, so even large batches of events and
+ * SysEx data only cause allocations the first time they're encountered.
  */
 class alignas(16) DynamicVstEvents {
    public:
@@ -110,6 +173,12 @@ class alignas(16) DynamicVstEvents {
 
     explicit DynamicVstEvents(const VstEvents& c_events);
 
+    /**
+     * Replace the events stored in this object with a copy of `c_events`,
+     * reusing the already allocated buffers.
+     */
+    void assign(const VstEvents& c_events);
+
     /**
      * Construct a `VstEvents` struct from the events vector. This contains a
      * pointer to that vector's elements, so the returned object should not
@@ -122,30 +191,38 @@ class alignas(16) DynamicVstEvents {
      * host can call `effProcessEvents()` multiple times, but in practice this
      * of course doesn't happen. In case the host or plugin sent SysEx data, we
      * will need to update the `dumpBytes` field to point to the data stored in
-     * the `sysex_data_` field before dumping everything to
-     * `vst_events_buffer_`.
+     * `sysex_data_` before dumping everything to `vst_events_buffer_`.
      */
     llvm::SmallVector<VstEvent, 64> events_;
 
     /**
      * If the host or a plugin sends SysEx data, then we will store that data
      * here. I've only seen this happen with the combination of an Arturia
-     * MiniLab keyboard, REAPER, and D16 Group plugins. We'll store this as an
-     * associative list of `(index, data)` pairs, where `index` corresponds to
-     * an event in `events`. There's no 'SmallUnorderedMap' equivalent to the
-     * `SmallVector`.
+     * MiniLab keyboard, REAPER, and D16 Group plugins. This is an associative
+     * list of `(index, offset)` pairs, where `index` corresponds to an event in
+     * `events` and `offset` is the start of that event's data in
+     * `sysex_buffer_`. The length of the data is stored in the event itself.
+     * There's no 'SmallUnorderedMap' equivalent to the `SmallVector`.
+     */
+    llvm::SmallVector<std::pair<native_size_t, native_size_t>, 8> sysex_data_;
+
+    /**
+     * The SysEx data for all events in `sysex_data_`, stored back to back.
+     * Using a single buffer instead of a string per event means that the
+     * storage can be reused between processing cycles.
      */
-    llvm::SmallVector<std::pair<native_size_t, std::string>, 8> sysex_data_;
+    llvm::SmallVector<uint8_t, 256> sysex_buffer_;
 
     template <typename S>
     void serialize(S& s) {
         s.container(events_, max_midi_events,
                     [](S& s, VstEvent& event) { s.container1b(event.dump); });
         s.container(sysex_data_, max_midi_events,
-                    [](S& s, std::pair<native_size_t, std::string>& pair) {
+                    [](S& s, std::pair<native_size_t, native_size_t>& pair) {
                         s.value8b(pair.first);
-                        s.text1b(pair.second, max_buffer_size);
+                        s.value8b(pair.second);
                     });
+        s.container1b(sysex_buffer_, max_buffer_size);
     }
 
    private:
@@ -197,11 +274,12 @@ class alignas(16) DynamicSpeakerArrangement {
     VstSpeakerArrangement& as_c_speaker_arrangement();
 
     /**
-     * Reconstruct the dynamically sized `VstSpeakerArrangement` object and
-     * return the raw data buffer. Needed to write the results back to the host
-     * since we can't just reassign the object.
+     * Write the flags and the speakers directly to a `VstSpeakerArrangement`
+     * object provided by the host. Needed to write the results back to the
+     * host since we can't just reassign the object. `speaker_arrangement`
+     * needs to have room for all of our speakers.
      */
-    std::vector<uint8_t>& as_raw_data();
+    void write_to(VstSpeakerArrangement& speaker_arrangement) const noexcept;
 
     /**
      * The flags field from `VstSpeakerArrangement`
@@ -249,6 +327,54 @@ struct WantsAEffectUpdate {
     void serialize(S&) {}
 };
 
+/**
+ * The fields of the plugin's `AEffect` object that changed since the native
+ * plugin last received it. This is sent instead of an entire `AEffect` when the
+ * plugin calls `audioMasterIOChanged()`, since plugins that call it whenever
+ * their latency changes will usually only change a single field. This covers
+ * the same fields as `update_aeffect()`.
+ */
+struct AEffectDelta {
+    /**
+     * Find all fields in `current` that are different from `previous`.
+     */
+    static AEffectDelta between(const AEffect& previous,
+                                const AEffect& current) noexcept;
+
+    /**
+     * Write the changed fields to `plugin`, leaving everything else untouched.
+     */
+    AEffect& apply(AEffect& plugin) const noexcept;
+
+    /**
+     * A pointer to the new value for `initialDelay`, or a null pointer if the
+     * plugin's latency did not change. The native plugin adds its own latency
+     * to this when `vst2_pipelined_processing` is enabled.
+     */
+    int32_t* initial_delay() noexcept;
+
+    /**
+     * One bit for every field, in the order they're listed in
+     * `serialize(S&, AEffect&)`.
+     */
+    uint16_t changed_fields = 0;
+    /**
+     * The new values for the fields set in `changed_fields`. The float field is
+     * stored bitwise.
+     */
+    std::array<int32_t, 12> values{};
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value2b(changed_fields);
+        for (size_t i = 0; i < values.size(); i++) {
+            if (changed_fields & (1 << i)) {
+                s.value4b(values[i]);
+            }
+        }
+    }
+};
+
 /**
  * Marker struct to indicate that the Wine plugin host should set up shared
  * memory buffers for audio processing. The size for this depends on the maximum
@@ -277,6 +403,28 @@ struct WantsAudioShmBufferConfig {
 struct WantsChunkBuffer {
     using Response = ChunkData;
 
+    /**
+     * The hash of the chunk the native plugin has cached for this `index`, if
+     * the `vst2_chunk_cache` option is enabled. If the chunk returned by the
+     * plugin has the same hash, then the Wine plugin host will respond with
+     * `UnchangedChunkData` instead of sending the entire chunk again.
+     */
+    std::optional<uint64_t> cached_hash;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.ext(cached_hash, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value8b(v); });
+    }
+};
+
+/**
+ * Sent in response to `effGetChunk()` instead of `ChunkData` if the chunk is
+ * the same as the one the native plugin has cached.
+ *
+ * @see WantsChunkBuffer::cached_hash
+ */
+struct UnchangedChunkData {
     template <typename S>
     void serialize(S&) {}
 };
@@ -316,6 +464,81 @@ struct WantsString {
     void serialize(S&) {}
 };
 
+/**
+ * The name, label, and display string for a single VST2 parameter, as returned
+ * by `effGetParamName()`, `effGetParamLabel()`, and `effGetParamDisplay()`.
+ */
+struct Vst2ParameterDescription {
+    std::string name;
+    std::string label;
+    std::string display;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.text1b(name, max_string_length);
+        s.text1b(label, max_string_length);
+        s.text1b(display, max_string_length);
+    }
+};
+
+/**
+ * The response to a `WantsParameterDescriptions` request. Contains one
+ * description for every parameter in the requested range.
+ */
+struct Vst2ParameterDescriptions {
+    std::vector<Vst2ParameterDescription> descriptions;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.container(descriptions, max_parameter_descriptions);
+    }
+};
+
+/**
+ * Marker struct to indicate that the Wine plugin host should call
+ * `effGetParamName()`, `effGetParamLabel()`, and `effGetParamDisplay()` for
+ * `value` parameters starting at `index`, and return the results as a single
+ * `Vst2ParameterDescriptions` object. This is used for the
+ * `vst2_parameter_info_cache` option, and it is handled directly in
+ * `Vst2Bridge::run()` instead of being passed to the plugin.
+ */
+struct WantsParameterDescriptions {
+    using Response = Vst2ParameterDescriptions;
+
+    template <typename S>
+    void serialize(S&) {}
+};
+
+/**
+ * The response to a `WantsProgramNames` request. Contains the name of every
+ * program in the requested range. This will be empty if the plugin does not
+ * support `effGetProgramNameIndexed()`.
+ */
+struct Vst2ProgramNames {
+    std::vector<std::string> names;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.container(names, max_program_names, [](S& s, std::string& name) {
+            s.text1b(name, max_string_length);
+        });
+    }
+};
+
+/**
+ * Marker struct to indicate that the Wine plugin host should call
+ * `effGetProgramNameIndexed()` for `value` programs starting at `index`, and
+ * return the results as a single `Vst2ProgramNames` object. This is used for
+ * the `vst2_program_name_cache` option, and just like
+ * `WantsParameterDescriptions` it is handled directly in `Vst2Bridge::run()`.
+ */
+struct WantsProgramNames {
+    using Response = Vst2ProgramNames;
+
+    template <typename S>
+    void serialize(S&) {}
+};
+
 /**
  * AN instance of this should be sent back as a response to an incoming event.
  */
@@ -345,7 +568,10 @@ struct Vst2EventResult {
                                  VstMidiKeyName,
                                  VstParameterProperties,
                                  VstRect,
-                                 VstTimeInfo>;
+                                 VstTimeInfo,
+                                 Vst2ParameterDescriptions,
+                                 Vst2ProgramNames,
+                                 UnchangedChunkData>;
 
     /**
      * The result that should be returned from the dispatch function.
@@ -435,6 +661,7 @@ struct Vst2Event {
                                  std::string,
                                  native_size_t,
                                  AEffect,
+                                 AEffectDelta,
                                  ChunkData,
                                  DynamicVstEvents,
                                  DynamicSpeakerArrangement,
@@ -447,7 +674,9 @@ struct Vst2Event {
                                  VstPatchChunkInfo,
                                  WantsVstRect,
                                  WantsVstTimeInfo,
-                                 WantsString>;
+                                 WantsString,
+                                 WantsParameterDescriptions,
+                                 WantsProgramNames>;
 
     int opcode;
     int index;
@@ -530,15 +759,149 @@ struct Parameter {
     }
 };
 
+/**
+ * A `VstTimeInfo` struct that's delta encoded against the last transport
+ * information sent for the same plugin instance. Only the fields marked in
+ * `changed_fields` are serialized. The sample position is predicted by
+ * advancing the last sample position by the last block's size, so a playing
+ * transport with a steady tempo only needs to send the fields that actually
+ * move along with the playhead, and a stopped transport only needs two bytes.
+ *
+ * These are created with `Vst2TimeInfoEncoder::encode()` on the native plugin
+ * side, and then turned back into a full `VstTimeInfo` with
+ * `Vst2TimeInfoDecoder::decode()` on the Wine side.
+ */
+struct Vst2TimeInfoDelta {
+    enum Field : uint16_t {
+        sample_pos = 1 << 0,
+        sample_rate = 1 << 1,
+        nano_seconds = 1 << 2,
+        ppq_pos = 1 << 3,
+        tempo = 1 << 4,
+        bar_start_pos = 1 << 5,
+        cycle_start_pos = 1 << 6,
+        cycle_end_pos = 1 << 7,
+        time_signature = 1 << 8,
+        flags = 1 << 9,
+        all_fields = (1 << 10) - 1,
+        /**
+         * If this is not set, then the host did not return any transport
+         * information during this processing cycle.
+         */
+        has_time_info = 1 << 15,
+    };
+
+    uint16_t changed_fields = 0;
+    /**
+     * The new transport information. Only the fields marked in
+     * `changed_fields` are meaningful.
+     */
+    VstTimeInfo time_info;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value2b(changed_fields);
+
+        if (changed_fields & sample_pos) {
+            s.value8b(time_info.samplePos);
+        }
+        if (changed_fields & sample_rate) {
+            s.value8b(time_info.sampleRate);
+        }
+        if (changed_fields & nano_seconds) {
+            s.value8b(time_info.nanoSeconds);
+        }
+        if (changed_fields & ppq_pos) {
+            s.value8b(time_info.ppqPos);
+        }
+        if (changed_fields & tempo) {
+            s.value8b(time_info.tempo);
+        }
+        if (changed_fields & bar_start_pos) {
+            s.value8b(time_info.barStartPos);
+        }
+        if (changed_fields & cycle_start_pos) {
+            s.value8b(time_info.cycleStartPos);
+        }
+        if (changed_fields & cycle_end_pos) {
+            s.value8b(time_info.cycleEndPos);
+        }
+        if (changed_fields & time_signature) {
+            s.value4b(time_info.timeSigNumerator);
+            s.value4b(time_info.timeSigDenominator);
+        }
+        if (changed_fields & flags) {
+            s.container1b(time_info.empty3);
+            s.value4b(time_info.flags);
+        }
+    }
+};
+
+/**
+ * Keeps track of the last transport information sent to the Wine plugin host
+ * so it can be delta encoded. There should be one of these per plugin
+ * instance, and every encoded delta must be decoded by that instance's
+ * `Vst2TimeInfoDecoder` in the same order.
+ */
+class Vst2TimeInfoEncoder {
+   public:
+    /**
+     * Encode the transport information returned by the host during this
+     * processing cycle.
+     *
+     * @param current The result of `audioMasterGetTime()`. This may be a null
+     *   pointer if the host did not return any transport information.
+     * @param sample_frames The number of samples in this processing cycle.
+     * @param delta The object to write the encoded transport information to.
+     */
+    void encode(const VstTimeInfo* current,
+                int sample_frames,
+                Vst2TimeInfoDelta& delta) noexcept;
+
+   private:
+    VstTimeInfo last_time_info_{};
+    int last_sample_frames_ = 0;
+    /**
+     * Whether `last_time_info_` contains anything. If it doesn't, then all
+     * fields are sent.
+     */
+    bool has_last_time_info_ = false;
+};
+
+/**
+ * The counterpart to `Vst2TimeInfoEncoder` used on the Wine side.
+ */
+class Vst2TimeInfoDecoder {
+   public:
+    /**
+     * Apply a delta created by `Vst2TimeInfoEncoder::encode()`.
+     *
+     * @param delta The encoded transport information.
+     * @param sample_frames The number of samples in this processing cycle.
+     *
+     * @return A pointer to the reconstructed transport information, or a null
+     *   pointer if the host did not return any transport information during
+     *   this processing cycle. This pointer stays valid until the next call.
+     */
+    const VstTimeInfo* decode(const Vst2TimeInfoDelta& delta,
+                              int sample_frames) noexcept;
+
+   private:
+    VstTimeInfo last_time_info_{};
+    int last_sample_frames_ = 0;
+};
+
 /**
  * When the host calls `processReplacing()`, `processDoubleReplacing()`, or the
  * deprecated `process()` function on our VST2 plugin, we'll write the input
  * buffers to an `AudioShmBuffer` object that's shared between the native plugin
- * an the Wine plugin host, and we'll then send this object to the Wine plugin
- * host with the rest of the .
+ * an the Wine plugin host. This object containing the rest of the information
+ * needed to process audio is then written to the request metadata region of
+ * that same shared memory object using `write_shm_object()`, and the Wine
+ * plugin host is woken up by sending a `Vst2ProcessWakeUp` over the socket.
+ * This means the socket doesn't carry any payload during audio processing.
  */
 struct Vst2ProcessRequest {
-    using Response = Ack;
 
     /**
      * The number of samples per channel. We'll trust the host to never provide
@@ -556,9 +919,11 @@ struct Vst2ProcessRequest {
     /**
      * We'll prefetch the current transport information as part of handling an
      * audio processing call. This lets us a void an unnecessary callback (or in
-     * some cases, more than one) during every processing cycle.
+     * some cases, more than one) during every processing cycle. This is delta
+     * encoded against the transport information from the last processing
+     * cycle.
      */
-    std::optional<VstTimeInfo> current_time_info;
+    Vst2TimeInfoDelta current_time_info;
 
     /**
      * Some plugins will also ask for the current process level during audio
@@ -568,24 +933,124 @@ struct Vst2ProcessRequest {
     int current_process_level;
 
     /**
-     * We'll periodically synchronize the realtime priority setting of the
-     * host's audio thread with the Wine plugin host. We'll do this
-     * approximately every ten seconds, as doing this getting and setting
-     * scheduler information has a non trivial amount of overhead (even if it's
-     * only a single microsoecond).
+     * The realtime priority of the host's audio thread, if it changed since
+     * the last processing cycle. This lets the Wine plugin host's audio
+     * thread follow priority changes made by the host or by rtkit
+     * immediately, while only having to set the scheduler parameters when
+     * something actually changed.
      */
     std::optional<int> new_realtime_priority;
 
+    /**
+     * The CPU core the host's audio thread is currently running on. This is
+     * only set when the `audio_thread_follow_host_cpu` option is enabled, and
+     * like `new_realtime_priority` it's only sent when it changes.
+     */
+    std::optional<int> host_audio_thread_cpu;
+
+    /**
+     * The NUMA node the host's audio thread is currently running on. This is
+     * only set when the `audio_thread_follow_host_numa_node` option is enabled,
+     * and it's also only sent when it changes.
+     */
+    std::optional<int> host_audio_thread_numa_node;
+
+    /**
+     * The thread ID of the host's audio thread making this processing call,
+     * when the `audio_thread_host_mapping` option is enabled.
+     *
+     * @see HostAudioThreadMap
+     */
+    std::optional<int> host_thread_id;
+
     template <typename S>
     void serialize(S& s) {
         s.value4b(sample_frames);
         s.value1b(double_precision);
 
-        s.ext(current_time_info, bitsery::ext::InPlaceOptional{});
+        s.object(current_time_info);
         s.value4b(current_process_level);
 
         s.ext(new_realtime_priority, bitsery::ext::InPlaceOptional{},
               [](S& s, int& priority) { s.value4b(priority); });
+        s.ext(host_audio_thread_cpu, bitsery::ext::InPlaceOptional{},
+              [](S& s, int& cpu) { s.value4b(cpu); });
+        s.ext(host_audio_thread_numa_node, bitsery::ext::InPlaceOptional{},
+              [](S& s, int& node) { s.value4b(node); });
+        s.ext(host_thread_id, bitsery::ext::InPlaceOptional{},
+              [](S& s, int& id) { s.value4b(id); });
+    }
+};
+
+// This object is built on the audio thread every processing cycle, so it must
+// never contain anything that could allocate
+static_assert(std::is_trivially_copyable_v<Vst2ProcessRequest>);
+static_assert(std::is_trivially_destructible_v<Vst2ProcessRequest>);
+
+/**
+ * A `Vst2ProcessRequest` along with the MIDI events the host passed to
+ * `effProcessEvents()` since the last processing cycle. This is written to the
+ * shared audio buffers instead of a plain `Vst2ProcessRequest` when the
+ * `vst2_batch_midi_events` option is enabled. `midi_events` will be empty if
+ * there were no new events. Both sides reuse a single instance of this object,
+ * so the small vectors in `DynamicVstEvents` only allocate when a batch
+ * contains more events than fit in their inline storage.
+ */
+struct Vst2BatchedProcessRequest {
+    Vst2ProcessRequest request;
+    DynamicVstEvents midi_events;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.object(request);
+        s.object(midi_events);
+    }
+};
+
+/**
+ * Sent over the `host_vst_process_replacing_` socket after the native plugin
+ * has written the input audio and a `Vst2ProcessRequest` to the shared audio
+ * buffers. When the `futex_signalling` option is disabled, the Wine plugin host
+ * will respond with an `Ack` after it has finished processing audio.
+ */
+struct Vst2ProcessWakeUp {
+    using Response = Ack;
+
+    template <typename S>
+    void serialize(S&) {}
+};
+
+/**
+ * A host callback made by the plugin from the Wine plugin host's audio thread
+ * that has been queued instead of being sent to the host right away. These
+ * callbacks don't use their `value` or `data` arguments.
+ */
+struct Vst2QueuedHostCallback {
+    int opcode;
+    int index;
+    float option;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value4b(opcode);
+        s.value4b(index);
+        s.value4b(option);
+    }
+};
+
+/**
+ * Written to the response metadata region of the shared audio buffers by the
+ * Wine plugin host after processing a block of audio when the
+ * `vst2_async_automation` option is enabled. The native plugin will make these
+ * callbacks to the host after it has received the processed audio. Both sides
+ * reuse a single instance of this object.
+ */
+struct Vst2ProcessResponse {
+    llvm::SmallVector<Vst2QueuedHostCallback, 64> host_callbacks;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.container(host_callbacks, max_queued_host_callbacks);
     }
 };
 
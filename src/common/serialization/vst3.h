@@ -54,15 +54,19 @@
  * the configuration. During this process we will also transmit the version
  * string from the host, so we can show a little warning when the user forgot to
  * rerun `yabridgectl sync` (and the initialization was still successful).
+ * The Wine plugin host's capabilities are sent along so the plugin can disable
+ * any options the host doesn't support.
  */
 struct WantsConfiguration {
     using Response = Configuration;
 
     std::string host_version;
+    Capabilities host_capabilities;
 
     template <typename S>
     void serialize(S& s) {
         s.text1b(host_version, 128);
+        s.object(host_capabilities);
     }
 };
 
@@ -76,6 +80,7 @@ using ControlRequest =
                  Vst3PlugViewProxy::Destruct,
                  Vst3PluginProxy::Construct,
                  Vst3PluginProxy::Destruct,
+                 Vst3PluginProxy::StartAudioProcessor,
                  // This is actually part of `YaPluginBase`, but thanks to Waves
                  // we had to move this message to the main `Vst3PluginProxy`
                  // class
@@ -92,11 +97,13 @@ using ControlRequest =
                  YaEditController::SetComponentState,
                  YaEditController::GetParameterCount,
                  YaEditController::GetParameterInfo,
+                 YaEditController::GetAllParameterInfos,
                  YaEditController::GetParamStringByValue,
                  YaEditController::GetParamValueByString,
                  YaEditController::NormalizedParamToPlain,
                  YaEditController::PlainParamToNormalized,
                  YaEditController::GetParamNormalized,
+                 YaEditController::GetAllParamNormalized,
                  YaEditController::SetParamNormalized,
                  YaEditController::SetComponentHandler,
                  YaEditController::CreateView,
@@ -108,10 +115,13 @@ using ControlRequest =
                  YaInfoListener::SetChannelContextInfos,
                  YaKeyswitchController::GetKeyswitchCount,
                  YaKeyswitchController::GetKeyswitchInfo,
+                 YaKeyswitchController::GetAllKeyswitchInfos,
                  YaMidiLearn::OnLiveMIDIControllerInput,
                  YaMidiMapping::GetMidiControllerAssignment,
+                 YaMidiMapping::GetAllMidiControllerAssignments,
                  YaNoteExpressionController::GetNoteExpressionCount,
                  YaNoteExpressionController::GetNoteExpressionInfo,
+                 YaNoteExpressionController::GetAllNoteExpressionInfos,
                  YaNoteExpressionController::GetNoteExpressionStringByValue,
                  YaNoteExpressionController::GetNoteExpressionValueByString,
                  YaNoteExpressionPhysicalUIMapping::GetNotePhysicalUIMapping,
@@ -145,6 +155,7 @@ using ControlRequest =
                  YaUnitInfo::GetProgramListInfo,
                  YaUnitInfo::GetProgramName,
                  YaUnitInfo::GetProgramInfo,
+                 YaUnitInfo::GetAllUnitsAndProgramLists,
                  YaUnitInfo::HasProgramPitchNames,
                  YaUnitInfo::GetProgramPitchName,
                  YaUnitInfo::GetSelectedUnit,
@@ -247,6 +258,7 @@ using CallbackRequest =
                  WantsConfiguration,
                  YaComponentHandler::BeginEdit,
                  YaComponentHandler::PerformEdit,
+                 YaComponentHandler::PerformEdits,
                  YaComponentHandler::EndEdit,
                  YaComponentHandler::RestartComponent,
                  YaComponentHandler2::SetDirty,
@@ -260,7 +272,7 @@ using CallbackRequest =
                  // `IConnectionPoint::notify` calls through
                  // there
                  YaConnectionPoint::Notify,
-                 YaContextMenu::AddItem,
+                 YaContextMenu::AddItems,
                  YaContextMenu::RemoveItem,
                  YaContextMenu::Popup,
                  YaContextMenuTarget::ExecuteMenuItem,
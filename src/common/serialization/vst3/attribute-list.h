@@ -22,6 +22,7 @@
 #include <pluginterfaces/vst/ivstmessage.h>
 
 #include "../../bitsery/ext/in-place-optional.h"
+#include "../../bitsery/ext/shared-memory-blob.h"
 #include "base.h"
 
 #pragma GCC diagnostic push
@@ -107,10 +108,13 @@ class YaAttributeList : public Steinberg::Vst::IAttributeList {
                   s.text1b(key, 1024);
                   s.text2b(value, 1 << 20);
               });
+        // Large binary attributes are written to shared memory once instead
+        // of being copied into the serialization buffer and then copied out
+        // again on the other side. This also lifts the 1 MiB size limit.
         s.ext(attrs_binary_, bitsery::ext::StdMap{1 << 20},
               [](S& s, std::string& key, std::vector<uint8_t>& value) {
                   s.text1b(key, 1024);
-                  s.container1b(value, 1 << 20);
+                  s.ext(value, bitsery::ext::SharedMemoryBlob(1 << 20));
               });
     }
 
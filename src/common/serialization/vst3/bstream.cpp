@@ -19,6 +19,12 @@
 #include <cassert>
 #include <stdexcept>
 
+/**
+ * The size of the windows we'll copy data from and to the host's stream in.
+ */
+constexpr size_t stream_window_size =
+    bitsery::ext::SharedMemoryBlob::shared_memory_threshold;
+
 YaBStream::YaBStream() noexcept {FUNKNOWN_CTOR}
 
 YaBStream::YaBStream(Steinberg::IBStream* stream) {
@@ -43,13 +49,28 @@ YaBStream::YaBStream(Steinberg::IBStream* stream) {
         size -= old_position;
 
         if (size > 0) {
-            int32 num_bytes_read = 0;
-            buffer_.resize(size);
             stream->seek(old_position,
                          Steinberg::IBStream::IStreamSeekMode::kIBSeekSet);
-            stream->read(buffer_.data(), static_cast<int32>(size),
-                         &num_bytes_read);
-            assert(num_bytes_read == 0 || num_bytes_read == size);
+
+            // Large streams end up in shared memory, so we'll copy them in
+            // small windows to avoid having to store the full stream in memory
+            // twice
+            std::vector<uint8_t> window(
+                std::min(static_cast<size_t>(size), stream_window_size));
+            for (int64 offset = 0; offset < size;) {
+                const int32 window_size = static_cast<int32>(
+                    std::min(static_cast<int64>(window.size()), size - offset));
+
+                int32 num_bytes_read = 0;
+                stream->read(window.data(), window_size, &num_bytes_read);
+                assert(num_bytes_read == 0 || num_bytes_read == window_size);
+                if (num_bytes_read <= 0 ||
+                    !buffer_.write(offset, window.data(), num_bytes_read)) {
+                    break;
+                }
+
+                offset += num_bytes_read;
+            }
         }
     }
 
@@ -113,13 +134,22 @@ tresult YaBStream::write_back(Steinberg::IBStream* stream) const {
 
     // A `stream->seek(0, kIBSeekSet)` breaks restoring states in Bitwig. Not
     // sure if Bitwig is prepending a header or if this is expected behaviour.
-    int32 num_bytes_written = 0;
-    if (stream->write(const_cast<uint8_t*>(buffer_.data()),
-                      static_cast<int32>(buffer_.size()),
-                      &num_bytes_written) == Steinberg::kResultOk) {
-        // Some implementations will return `kResultFalse` when writing 0 bytes
-        assert(num_bytes_written == 0 ||
-               static_cast<size_t>(num_bytes_written) == buffer_.size());
+    const size_t size = buffer_.size();
+    std::vector<uint8_t> window(std::min(size, stream_window_size));
+    for (size_t offset = 0; offset < size; offset += window.size()) {
+        const size_t window_size = std::min(window.size(), size - offset);
+        if (!buffer_.read(offset, window.data(), window_size)) {
+            break;
+        }
+
+        int32 num_bytes_written = 0;
+        if (stream->write(window.data(), static_cast<int32>(window_size),
+                          &num_bytes_written) == Steinberg::kResultOk) {
+            // Some implementations will return `kResultFalse` when writing 0
+            // bytes
+            assert(num_bytes_written == 0 ||
+                   static_cast<size_t>(num_bytes_written) == window_size);
+        }
     }
 
     // Write back any attributes written by the plugin if the host supports
@@ -154,8 +184,10 @@ tresult PLUGIN_API YaBStream::read(void* buffer,
                  static_cast<int64_t>(buffer_.size()) - seek_position_);
 
     if (bytes_to_read > 0) {
-        std::copy_n(&buffer_[seek_position_], bytes_to_read,
-                    reinterpret_cast<uint8_t*>(buffer));
+        if (!buffer_.read(seek_position_, buffer, bytes_to_read)) {
+            return Steinberg::kResultFalse;
+        }
+
         seek_position_ += bytes_to_read;
     }
 
@@ -173,13 +205,10 @@ tresult PLUGIN_API YaBStream::write(void* buffer,
         return Steinberg::kInvalidArgument;
     }
 
-    if (seek_position_ + numBytes > static_cast<int64_t>(buffer_.size())) {
-        buffer_.resize(seek_position_ + numBytes);
+    if (!buffer_.write(seek_position_, buffer, numBytes)) {
+        return Steinberg::kResultFalse;
     }
 
-    std::copy_n(reinterpret_cast<uint8_t*>(buffer), numBytes,
-                &buffer_[seek_position_]);
-
     seek_position_ += numBytes;
     if (numBytesWritten) {
         *numBytesWritten = numBytes;
@@ -229,8 +258,12 @@ tresult PLUGIN_API YaBStream::getStreamSize(int64& size) {
 }
 
 tresult PLUGIN_API YaBStream::setStreamSize(int64 size) {
-    buffer_.resize(size);
-    return Steinberg::kResultOk;
+    if (size < 0) {
+        return Steinberg::kInvalidArgument;
+    }
+
+    return buffer_.resize(size) ? Steinberg::kResultOk
+                                : Steinberg::kResultFalse;
 }
 
 tresult PLUGIN_API YaBStream::getFileName(Steinberg::Vst::String128 name) {
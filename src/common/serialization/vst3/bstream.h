@@ -21,6 +21,7 @@
 #include <pluginterfaces/base/ibstream.h>
 #include <pluginterfaces/vst/ivstattributes.h>
 
+#include "../../bitsery/ext/shared-memory-blob.h"
 #include "attribute-list.h"
 #include "base.h"
 
@@ -28,9 +29,15 @@
 #pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
 
 /**
- * Serialize an `IBStream` into an `std::vector<uint8_t>`, and allow the
- * receiving side to use it as an `IBStream` again. `ISizeableStream` is defined
- * but then for whatever reason never used, but we'll implement it anyways.
+ * Serialize an `IBStream` into a buffer, and allow the receiving side to use it
+ * as an `IBStream` again. `ISizeableStream` is defined but then for whatever
+ * reason never used, but we'll implement it anyways.
+ *
+ * Large streams are stored in a temporary shared memory object instead of in
+ * a vector. See `bitsery::ext::SharedMemoryBuffer`. Data is copied from and to
+ * the host's stream in fixed size windows, and both sides of the bridge then
+ * use the same shared memory object, so saving and loading a large plugin
+ * state no longer requires several full copies of that state in memory.
  *
  * If we're copying data from an existing `IBstream` and that stream supports
  * VST 3.6.0 preset meta data, then we'll copy that meta data as well.
@@ -53,12 +60,17 @@ class YaBStream : public Steinberg::IBStream,
      */
     YaBStream(Steinberg::IBStream* stream);
 
+    YaBStream(const YaBStream&) = default;
+    YaBStream& operator=(const YaBStream&) = default;
+    YaBStream(YaBStream&&) = default;
+    YaBStream& operator=(YaBStream&&) = default;
+
     virtual ~YaBStream() noexcept;
 
     DECLARE_FUNKNOWN_METHODS
 
     /**
-     * Write the vector buffer back to a host provided `IBStream`. After writing
+     * Write the buffer back to a host provided `IBStream`. After writing
      * the seek position will be left at the end of the stream.
      */
     tresult write_back(Steinberg::IBStream* stream) const;
@@ -90,7 +102,7 @@ class YaBStream : public Steinberg::IBStream,
 
     template <typename S>
     void serialize(S& s) {
-        s.container1b(buffer_, max_vector_stream_size);
+        s.ext(buffer_, bitsery::ext::SharedMemoryBlob(max_vector_stream_size));
         // The seek position should always be initialized at 0
 
         s.value1b(supports_stream_attributes_);
@@ -119,7 +131,7 @@ class YaBStream : public Steinberg::IBStream,
     std::optional<YaAttributeList> attributes_;
 
    private:
-    std::vector<uint8_t> buffer_;
+    bitsery::ext::SharedMemoryBuffer buffer_;
     int64_t seek_position_ = 0;
 };
 
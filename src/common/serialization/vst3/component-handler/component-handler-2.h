@@ -69,6 +69,7 @@ class YaComponentHandler2 : public Steinberg::Vst::IComponentHandler2 {
      */
     struct SetDirty {
         using Response = UniversalTResult;
+        static constexpr bool fire_and_forget = true;
 
         native_size_t owner_instance_id;
 
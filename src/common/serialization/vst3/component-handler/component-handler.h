@@ -108,6 +108,38 @@ class YaComponentHandler : public Steinberg::Vst::IComponentHandler {
     performEdit(Steinberg::Vst::ParamID id,
                 Steinberg::Vst::ParamValue valueNormalized) override = 0;
 
+    /**
+     * Several coalesced `IComponentHandler::performEdit(id, value_normalized)`
+     * calls that should be passed to the component handler provided by the
+     * host in order. This is used instead of `PerformEdit` when the
+     * `vst3_edit_coalescing_ms` option is enabled. Every parameter occurs at
+     * most once in `edits`, with the last value the plugin set for it.
+     */
+    struct PerformEdits {
+        using Response = UniversalTResult;
+
+        native_size_t owner_instance_id;
+
+        struct Edit {
+            Steinberg::Vst::ParamID id;
+            Steinberg::Vst::ParamValue value_normalized;
+
+            template <typename S>
+            void serialize(S& s) {
+                s.value4b(id);
+                s.value8b(value_normalized);
+            }
+        };
+
+        std::vector<Edit> edits;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(owner_instance_id);
+            s.container(edits, 1 << 16);
+        }
+    };
+
     /**
      * Message to pass through a call to `IComponentHandler::endEdit(id)` to the
      * component handler provided by the host.
@@ -135,6 +167,7 @@ class YaComponentHandler : public Steinberg::Vst::IComponentHandler {
      */
     struct RestartComponent {
         using Response = UniversalTResult;
+        static constexpr bool fire_and_forget = true;
 
         native_size_t owner_instance_id;
 
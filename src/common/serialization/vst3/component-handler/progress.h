@@ -118,6 +118,7 @@ class YaProgress : public Steinberg::Vst::IProgress {
      */
     struct Update {
         using Response = UniversalTResult;
+        static constexpr bool fire_and_forget = true;
 
         native_size_t owner_instance_id;
 
@@ -70,6 +70,7 @@ class YaUnitHandler2 : public Steinberg::Vst::IUnitHandler2 {
      */
     struct NotifyUnitByBusChange {
         using Response = UniversalTResult;
+        static constexpr bool fire_and_forget = true;
 
         native_size_t owner_instance_id;
 
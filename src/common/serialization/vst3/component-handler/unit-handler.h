@@ -70,6 +70,7 @@ class YaUnitHandler : public Steinberg::Vst::IUnitHandler {
      */
     struct NotifyUnitSelection {
         using Response = UniversalTResult;
+        static constexpr bool fire_and_forget = true;
 
         native_size_t owner_instance_id;
 
@@ -92,6 +93,7 @@ class YaUnitHandler : public Steinberg::Vst::IUnitHandler {
      */
     struct NotifyProgramListChange {
         using Response = UniversalTResult;
+        static constexpr bool fire_and_forget = true;
 
         native_size_t owner_instance_id;
 
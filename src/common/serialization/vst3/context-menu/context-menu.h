@@ -87,35 +87,72 @@ class YaContextMenu : public Steinberg::Vst::IContextMenu {
             Steinberg::Vst::IContextMenuTarget** target /*out*/) override = 0;
 
     /**
-     * Message to pass through a call to `IContextMenu::addItem(item, <target>)`
-     * to the corresponding context menu instance returned by the host. We'll
-     * create a proxy for `target` based on `item->tag` on the plugin side that
-     * forwards a call to the original target passed by the Windows VST3 plugin.
+     * A single `IContextMenu::addItem(item, <target>)` call made by the plugin
+     * as part of an `AddItems` batch. The target's owner instance and context
+     * menu IDs are the same for every item, so a target is described only by
+     * the item's ID and tag.
      */
-    struct AddItem {
-        using Response = UniversalTResult;
-
-        native_size_t owner_instance_id;
-        native_size_t context_menu_id;
-
+    struct BatchedItem {
         // Steinberg seems to hav emessed up their naming scheme here, since
         // this is most definitely not an interface
         Steinberg::Vst::IContextMenuItem item;
 
         /**
-         * Will be a nullopt if the plugin does not pass a `target` pointer. I'm
-         * not sure if this is optional since there are no implementations for
-         * this interface to be found, but I can imagine that this could be
-         * optional for disabled menu items or for group starts/ends.
+         * The ID of the menu item at the time it was added. See
+         * `YaContextMenuTarget::ConstructArgs::item_id`.
+         */
+        int32 item_id;
+        /**
+         * Whether the plugin passed a `target` pointer. I'm not sure if this is
+         * optional since there are no implementations for this interface to be
+         * found, but I can imagine that this could be optional for disabled
+         * menu items or for group starts/ends.
          */
-        std::optional<YaContextMenuTarget::ConstructArgs> target;
+        bool has_target;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.object(item);
+            s.value4b(item_id);
+            s.value1b(has_target);
+        }
+    };
+
+    /**
+     * The results of the `IContextMenu::addItem()` calls in an `AddItems`
+     * batch, in the same order as the items.
+     */
+    struct AddItemsResponse {
+        std::vector<UniversalTResult> results;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(results, 1 << 16);
+        }
+    };
+
+    /**
+     * Message to pass through all of the plugin's `IContextMenu::addItem(item,
+     * <target>)` calls since the last message for this context menu to the
+     * corresponding context menu instance returned by the host. Plugins that
+     * build large menus would otherwise need one round trip per item. We'll
+     * create a proxy for each target based on `item->tag` on the plugin side
+     * that forwards a call to the original target passed by the Windows VST3
+     * plugin.
+     */
+    struct AddItems {
+        using Response = AddItemsResponse;
+
+        native_size_t owner_instance_id;
+        native_size_t context_menu_id;
+
+        std::vector<BatchedItem> items;
 
         template <typename S>
         void serialize(S& s) {
             s.value8b(owner_instance_id);
             s.value8b(context_menu_id);
-            s.object(item);
-            s.ext(target, bitsery::ext::InPlaceOptional{});
+            s.container(items, 1 << 16);
         }
     };
 
@@ -183,32 +183,53 @@ YaEventList::YaEventList() noexcept {
 }
 
 void YaEventList::clear() noexcept {
+    event_types_.clear();
+    event_headers_.clear();
+    event_payloads_.clear();
     events_.clear();
 }
 
 void YaEventList::repopulate(Steinberg::Vst::IEventList& event_list) {
-    // Copy over all events. Everything gets converted to `YaEvent`s. We sadly
-    // can't construct these in place because we don't know the event type yet.
-    events_.clear();
-    events_.reserve(event_list.getEventCount());
-    for (int i = 0; i < event_list.getEventCount(); i++) {
+    // Copy over all events. The common event types are stored directly in the
+    // packed arrays, everything else gets converted to a `YaEvent`.
+    clear();
+
+    const int32 num_events = event_list.getEventCount();
+    event_types_.reserve(num_events);
+    event_headers_.reserve(num_events);
+    event_payloads_.reserve(num_events);
+    for (int i = 0; i < num_events; i++) {
         // We're skipping the `kResultOk` assertions here
         Steinberg::Vst::Event event;
         event_list.getEvent(i, event);
-        events_.emplace_back(event);
+        push_event(event);
     }
 }
 
+void YaEventList::reserve(size_t num_events) {
+    event_types_.reserve(num_events);
+    event_headers_.reserve(num_events);
+    event_payloads_.reserve(num_events);
+}
+
+size_t YaEventList::capacity() const noexcept {
+    return event_types_.capacity();
+}
+
 YaEventList::~YaEventList() noexcept {FUNKNOWN_DTOR}
 
 size_t YaEventList::num_events() const noexcept {
-    return events_.size();
+    return event_types_.size();
 }
 
 void YaEventList::write_back_outputs(
     Steinberg::Vst::IEventList& output_events) const {
-    for (auto& event : events_) {
-        Steinberg::Vst::Event reconstructed_event = event.get();
+    // `getEvent()` isn't const because of the COM-style interface, but it
+    // doesn't modify anything
+    YaEventList& self = const_cast<YaEventList&>(*this);
+    for (int32 i = 0; i < static_cast<int32>(event_types_.size()); i++) {
+        Steinberg::Vst::Event reconstructed_event;
+        self.getEvent(i, reconstructed_event);
         output_events.addEvent(reconstructed_event);
     }
 }
@@ -221,25 +242,82 @@ IMPLEMENT_FUNKNOWN_METHODS(YaEventList,
 #pragma GCC diagnostic pop
 
 int32 PLUGIN_API YaEventList::getEventCount() {
-    return static_cast<int32>(events_.size());
+    return static_cast<int32>(event_types_.size());
 }
 
 tresult PLUGIN_API YaEventList::getEvent(int32 index,
                                          Steinberg::Vst::Event& e /*out*/) {
-    if (index < 0 || index >= static_cast<int32>(events_.size())) {
+    if (index < 0 || index >= static_cast<int32>(event_types_.size())) {
         return Steinberg::kInvalidArgument;
     }
 
-    // Reconstructing an event is cheap, but some events may contain pointers to
-    // heap data stored within the `events` vector so this event will still have
-    // the same lifetime as this class
-    e = events_[index].get();
+    const YaPackedEventPayload& payload = event_payloads_[index];
+    switch (event_types_[index]) {
+        case Steinberg::Vst::Event::kNoteOnEvent:
+            e.noteOn = payload.note_on;
+            break;
+        case Steinberg::Vst::Event::kNoteOffEvent:
+            e.noteOff = payload.note_off;
+            break;
+        case Steinberg::Vst::Event::kNoteExpressionValueEvent:
+            e.noteExpressionValue = payload.note_expression_value;
+            break;
+        case Steinberg::Vst::Event::kLegacyMIDICCOutEvent:
+            e.midiCCOut = payload.midi_cc_out;
+            break;
+        default:
+            if (payload.event_index >= events_.size()) {
+                return Steinberg::kInvalidArgument;
+            }
+
+            // Reconstructing these events is still cheap, but they may contain
+            // pointers to heap data stored within the `events_` vector so this
+            // event will still have the same lifetime as this class
+            e = events_[payload.event_index].get();
+            return Steinberg::kResultOk;
+    }
+
+    const YaPackedEventHeader& header = event_headers_[index];
+    e.busIndex = header.bus_index;
+    e.sampleOffset = header.sample_offset;
+    e.ppqPosition = header.ppq_position;
+    e.flags = header.flags;
+    e.type = event_types_[index];
 
     return Steinberg::kResultOk;
 }
 
 tresult PLUGIN_API YaEventList::addEvent(Steinberg::Vst::Event& e /*in*/) {
-    events_.push_back(e);
+    push_event(e);
 
     return Steinberg::kResultOk;
 }
+
+void YaEventList::push_event(const Steinberg::Vst::Event& event) {
+    YaPackedEventPayload& payload = event_payloads_.emplace_back();
+    switch (event.type) {
+        case Steinberg::Vst::Event::kNoteOnEvent:
+            payload.note_on = event.noteOn;
+            break;
+        case Steinberg::Vst::Event::kNoteOffEvent:
+            payload.note_off = event.noteOff;
+            break;
+        case Steinberg::Vst::Event::kNoteExpressionValueEvent:
+            payload.note_expression_value = event.noteExpressionValue;
+            break;
+        case Steinberg::Vst::Event::kLegacyMIDICCOutEvent:
+            payload.midi_cc_out = event.midiCCOut;
+            break;
+        default:
+            payload.event_index = static_cast<uint32>(events_.size());
+            events_.emplace_back(event);
+            break;
+    }
+
+    event_types_.push_back(event.type);
+    event_headers_.push_back(
+        YaPackedEventHeader{.bus_index = event.busIndex,
+                            .sample_offset = event.sampleOffset,
+                            .ppq_position = event.ppqPosition,
+                            .flags = event.flags});
+}
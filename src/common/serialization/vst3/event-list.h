@@ -20,6 +20,7 @@
 #include <pluginterfaces/vst/ivstevents.h>
 
 #include "../../bitsery/ext/in-place-variant.h"
+#include "../../bitsery/ext/trivial-container.h"
 #include "../../bitsery/traits/small-vector.h"
 #include "base.h"
 
@@ -214,6 +215,34 @@ struct alignas(16) YaEvent {
     }
 };
 
+/**
+ * The fields shared by every event in `YaEventList`'s packed representation.
+ * These directly reflect those from `Event`.
+ */
+struct YaPackedEventHeader {
+    int32 bus_index;
+    int32 sample_offset;
+    Steinberg::Vst::TQuarterNotes ppq_position;
+    uint16 flags;
+};
+
+/**
+ * The payload for an event in `YaEventList`'s packed representation. The most
+ * common event types don't contain any pointers, so they can be stored inline.
+ * For every other event type this contains an index into
+ * `YaEventList::events_`.
+ */
+union YaPackedEventPayload {
+    Steinberg::Vst::NoteOnEvent note_on;
+    Steinberg::Vst::NoteOffEvent note_off;
+    Steinberg::Vst::NoteExpressionValueEvent note_expression_value;
+    Steinberg::Vst::LegacyMIDICCOutEvent midi_cc_out;
+    uint32 event_index;
+};
+
+static_assert(std::is_trivially_copyable_v<YaPackedEventHeader>);
+static_assert(std::is_trivially_copyable_v<YaPackedEventPayload>);
+
 /**
  * Wraps around `IEventList` for serialization purposes. Used in
  * `YaProcessData`.
@@ -239,6 +268,19 @@ class YaEventList : public Steinberg::Vst::IEventList {
      */
     void repopulate(Steinberg::Vst::IEventList& event_list);
 
+    /**
+     * Preallocate space for `num_events` events so the plugin can output that
+     * many events without us having to allocate on the audio thread. Events
+     * that contain pointers to heap data are not covered by this since those
+     * are rare.
+     */
+    void reserve(size_t num_events);
+
+    /**
+     * The number of events we can store without reallocating.
+     */
+    size_t capacity() const noexcept;
+
     virtual ~YaEventList() noexcept;
 
     DECLARE_FUNKNOWN_METHODS
@@ -263,11 +305,37 @@ class YaEventList : public Steinberg::Vst::IEventList {
 
     template <typename S>
     void serialize(S& s) {
+        s.container2b(event_types_, 1 << 16);
+        s.ext(event_headers_, bitsery::ext::TrivialContainer(1 << 16));
+        s.ext(event_payloads_, bitsery::ext::TrivialContainer(1 << 16));
         s.container(events_, 1 << 16);
     }
 
    private:
-    llvm::SmallVector<YaEvent, 64> events_;
+    /**
+     * Append an event to the packed arrays below. Note on, note off, note
+     * expression value and legacy MIDI CC events are stored inline, all other
+     * events are converted to a `YaEvent` and stored in `events_`.
+     */
+    void push_event(const Steinberg::Vst::Event& event);
+
+    // MPE controllers and instruments that make heavy use of note expressions
+    // can send hundreds of events every processing cycle, so instead of
+    // storing every event as a `YaEvent` we'll store them as a structure of
+    // arrays. These three arrays contain the `Event::EventTypes` type, the
+    // common fields, and the payload for every event in order. They can be
+    // serialized as contiguous blocks of memory, and we'll only reconstruct
+    // an `Event` from them when the plugin calls `getEvent()`.
+
+    llvm::SmallVector<uint16, 64> event_types_;
+    llvm::SmallVector<YaPackedEventHeader, 64> event_headers_;
+    llvm::SmallVector<YaPackedEventPayload, 64> event_payloads_;
+
+    /**
+     * Events with types that can contain pointers to heap data. These are
+     * referenced through `YaPackedEventPayload::event_index`.
+     */
+    llvm::SmallVector<YaEvent, 8> events_;
 };
 
 #pragma GCC diagnostic pop
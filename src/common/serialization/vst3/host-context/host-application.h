@@ -34,6 +34,21 @@
  */
 class YaHostApplication : public Steinberg::Vst::IHostApplication {
    public:
+    /**
+     * The response code and resulting value for a call to
+     * `IHostApplication::getName()`.
+     */
+    struct GetNameResponse {
+        UniversalTResult result;
+        std::u16string name;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.object(result);
+            s.text2b(name, std::extent_v<Steinberg::Vst::String128>);
+        }
+    };
+
     /**
      * These are the arguments for creating a `YaHostApplication`.
      */
@@ -51,9 +66,20 @@ class YaHostApplication : public Steinberg::Vst::IHostApplication {
          */
         bool supported;
 
+        /**
+         * The host's name, fetched when the host context is passed to the
+         * plugin. Plugins tend to query this many times, and since it won't
+         * change we can answer those queries without a round trip. This is
+         * filled in by `Vst3PluginBridge::create_host_context_args()` since
+         * it depends on the `hide_daw` option. If this is empty, then
+         * `getName()` will be passed through to the host.
+         */
+        std::optional<GetNameResponse> name;
+
         template <typename S>
         void serialize(S& s) {
             s.value1b(supported);
+            s.ext(name, bitsery::ext::InPlaceOptional{});
         }
     };
 
@@ -68,19 +94,13 @@ class YaHostApplication : public Steinberg::Vst::IHostApplication {
     inline bool supported() const noexcept { return arguments_.supported; }
 
     /**
-     * The response code and resulting value for a call to
-     * `IHostApplication::getName()`.
+     * The host's name and the result code returned by `getName()`, if it was
+     * fetched when this host context proxy was created.
      */
-    struct GetNameResponse {
-        UniversalTResult result;
-        std::u16string name;
-
-        template <typename S>
-        void serialize(S& s) {
-            s.object(result);
-            s.text2b(name, std::extent_v<Steinberg::Vst::String128>);
-        }
-    };
+    inline const std::optional<GetNameResponse>& prefetched_name()
+        const noexcept {
+        return arguments_.name;
+    }
 
     /**
      * Message to pass through a call to `IHostApplication::getName()` to the
@@ -16,12 +16,105 @@
 
 #include "plug-interface-support.h"
 
+#include <algorithm>
+
+#include <pluginterfaces/gui/iplugview.h>
+#include <pluginterfaces/gui/iplugviewcontentscalesupport.h>
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstautomationstate.h>
+#include <pluginterfaces/vst/ivstchannelcontextinfo.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivstmessage.h>
+#include <pluginterfaces/vst/ivstmidilearn.h>
+#include <pluginterfaces/vst/ivstnoteexpression.h>
+#include <pluginterfaces/vst/ivstparameterfunctionname.h>
+#include <pluginterfaces/vst/ivstphysicalui.h>
+#include <pluginterfaces/vst/ivstplugview.h>
+#include <pluginterfaces/vst/ivstprefetchablesupport.h>
+#include <pluginterfaces/vst/ivstrepresentation.h>
+#include <pluginterfaces/vst/ivstunits.h>
+
+namespace {
+
+/**
+ * The interfaces we'll ask the host about when creating a host context proxy.
+ * These are all of the plugin interfaces implemented by `Vst3PluginProxy` and
+ * `Vst3PlugViewProxy`, since those are the ones plugins will ask about.
+ */
+const Steinberg::FUID* const prefetched_plug_interfaces[] = {
+    &Steinberg::IPlugView::iid,
+    &Steinberg::IPlugViewContentScaleSupport::iid,
+    &Steinberg::Vst::ChannelContext::IInfoListener::iid,
+    &Steinberg::Vst::IAudioPresentationLatency::iid,
+    &Steinberg::Vst::IAudioProcessor::iid,
+    &Steinberg::Vst::IAutomationState::iid,
+    &Steinberg::Vst::IComponent::iid,
+    &Steinberg::Vst::IConnectionPoint::iid,
+    &Steinberg::Vst::IEditController2::iid,
+    &Steinberg::Vst::IEditController::iid,
+    &Steinberg::Vst::IEditControllerHostEditing::iid,
+    &Steinberg::Vst::IKeyswitchController::iid,
+    &Steinberg::Vst::IMidiLearn::iid,
+    &Steinberg::Vst::IMidiMapping::iid,
+    &Steinberg::Vst::INoteExpressionController::iid,
+    &Steinberg::Vst::INoteExpressionPhysicalUIMapping::iid,
+    &Steinberg::Vst::IParameterFinder::iid,
+    &Steinberg::Vst::IParameterFunctionName::iid,
+    &Steinberg::Vst::IPrefetchableSupport::iid,
+    &Steinberg::Vst::IProcessContextRequirements::iid,
+    &Steinberg::Vst::IProgramListData::iid,
+    &Steinberg::Vst::IUnitData::iid,
+    &Steinberg::Vst::IUnitInfo::iid,
+    &Steinberg::Vst::IXmlRepresentationController::iid,
+};
+
+}  // namespace
+
 YaPlugInterfaceSupport::ConstructArgs::ConstructArgs() noexcept {}
 
 YaPlugInterfaceSupport::ConstructArgs::ConstructArgs(
     Steinberg::IPtr<Steinberg::FUnknown> object) noexcept
-    : supported(Steinberg::FUnknownPtr<Steinberg::Vst::IPlugInterfaceSupport>(
-          object)) {}
+    : supported(false) {
+    Steinberg::FUnknownPtr<Steinberg::Vst::IPlugInterfaceSupport>
+        plug_interface_support(object);
+    if (!plug_interface_support) {
+        return;
+    }
+
+    supported = true;
+    for (const Steinberg::FUID* iid : prefetched_plug_interfaces) {
+        if (plug_interface_support->isPlugInterfaceSupported(iid->toTUID()) ==
+            Steinberg::kResultTrue) {
+            supported_interfaces.emplace_back(iid->toTUID());
+        } else {
+            unsupported_interfaces.emplace_back(iid->toTUID());
+        }
+    }
+}
 
 YaPlugInterfaceSupport::YaPlugInterfaceSupport(ConstructArgs&& args) noexcept
     : arguments_(std::move(args)) {}
+
+std::optional<tresult>
+YaPlugInterfaceSupport::prefetched_plug_interface_support(
+    const Steinberg::TUID iid) const noexcept {
+    // The prefetched UIDs use the native byte order, so we need to convert the
+    // plugin's query to match
+    const ArrayUID native_iid =
+        WineUID(*reinterpret_cast<const Steinberg::TUID*>(iid))
+            .get_native_uid();
+    const auto matches = [&](const NativeUID& uid) {
+        return uid.native_uid() == native_iid;
+    };
+
+    if (std::any_of(arguments_.supported_interfaces.begin(),
+                    arguments_.supported_interfaces.end(), matches)) {
+        return Steinberg::kResultTrue;
+    } else if (std::any_of(arguments_.unsupported_interfaces.begin(),
+                           arguments_.unsupported_interfaces.end(), matches)) {
+        return Steinberg::kResultFalse;
+    } else {
+        return std::nullopt;
+    }
+}
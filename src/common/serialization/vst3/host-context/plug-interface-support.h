@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <pluginterfaces/vst/ivstpluginterfacesupport.h>
 
 #include "../../../bitsery/ext/in-place-optional.h"
@@ -48,9 +50,22 @@ class YaPlugInterfaceSupport : public Steinberg::Vst::IPlugInterfaceSupport {
          */
         bool supported;
 
+        /**
+         * The interfaces from `prefetched_plug_interfaces` the host claimed to
+         * support, and the ones it said it didn't support. Some plugins query
+         * dozens of interfaces during initialization and every time the editor
+         * is opened, so we'll ask the host about all of the interfaces yabridge
+         * can bridge up front. Queries for other interfaces are still passed
+         * through to the host.
+         */
+        std::vector<NativeUID> supported_interfaces;
+        std::vector<NativeUID> unsupported_interfaces;
+
         template <typename S>
         void serialize(S& s) {
             s.value1b(supported);
+            s.container(supported_interfaces, 64);
+            s.container(unsupported_interfaces, 64);
         }
     };
 
@@ -64,6 +79,14 @@ class YaPlugInterfaceSupport : public Steinberg::Vst::IPlugInterfaceSupport {
 
     inline bool supported() const noexcept { return arguments_.supported; }
 
+    /**
+     * Look up the host's answer for `iid` if it was prefetched when this host
+     * context proxy was created. Returns an empty optional when the query
+     * should be passed through to the host.
+     */
+    std::optional<tresult> prefetched_plug_interface_support(
+        const Steinberg::TUID iid) const noexcept;
+
     /**
      * Message to pass through a call to
      * `IPlugInterfaceSupport::isPlugInterfaceSupported(iid)` to the host
@@ -18,12 +18,13 @@
 
 YaMessagePtr::YaMessagePtr() noexcept {FUNKNOWN_CTOR}
 
-YaMessagePtr::YaMessagePtr(IMessage& message)
+YaMessagePtr::YaMessagePtr(IMessage& message, native_size_t sender_instance_id)
     : message_id_(message.getMessageID()
                       ? std::make_optional<std::string>(message.getMessageID())
                       : std::nullopt),
-      original_message_ptr_(static_cast<native_size_t>(
-          reinterpret_cast<size_t>(&message))){FUNKNOWN_CTOR}
+      original_message_ptr_(
+          static_cast<native_size_t>(reinterpret_cast<size_t>(&message))),
+      sender_instance_id_(sender_instance_id){FUNKNOWN_CTOR}
 
       YaMessagePtr::~YaMessagePtr() noexcept {
     FUNKNOWN_DTOR
@@ -51,8 +51,12 @@ class YaMessagePtr : public Steinberg::Vst::IMessage {
      * round trip from the Wine plugin host, to the native plugin, to the host,
      * back to the native plugin, and then finally back to the Wine plugin host
      * again.
+     *
+     * @param sender_instance_id The instance ID of the object that sent this
+     *   message through the host's connection proxy. This lets the Wine plugin
+     *   host learn which object is on the other side of that proxy.
      */
-    explicit YaMessagePtr(IMessage& message);
+    YaMessagePtr(IMessage& message, native_size_t sender_instance_id);
 
     virtual ~YaMessagePtr() noexcept;
 
@@ -65,6 +69,14 @@ class YaMessagePtr : public Steinberg::Vst::IMessage {
      */
     Steinberg::Vst::IMessage* get_original() const noexcept;
 
+    /**
+     * The instance ID of the object that sent this message. See the
+     * constructor.
+     */
+    inline native_size_t sender_instance_id() const noexcept {
+        return sender_instance_id_;
+    }
+
     virtual Steinberg::FIDString PLUGIN_API getMessageID() override;
     virtual void PLUGIN_API
     setMessageID(Steinberg::FIDString id /*in*/) override;
@@ -75,6 +87,7 @@ class YaMessagePtr : public Steinberg::Vst::IMessage {
         s.ext(message_id_, bitsery::ext::InPlaceOptional{},
               [](S& s, std::string& id) { s.text1b(id, 1024); });
         s.value8b(original_message_ptr_);
+        s.value8b(sender_instance_id_);
     }
 
    private:
@@ -91,6 +104,11 @@ class YaMessagePtr : public Steinberg::Vst::IMessage {
      */
     native_size_t original_message_ptr_ = 0;
 
+    /**
+     * The instance ID of the object that sent the message.
+     */
+    native_size_t sender_instance_id_ = 0;
+
     /**
      * An empty attribute list, in case the host checks this for some reason.
      */
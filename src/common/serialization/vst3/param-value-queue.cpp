@@ -16,6 +16,9 @@
 
 #include "param-value-queue.h"
 
+#include <algorithm>
+#include <limits>
+
 YaParamValueQueue::YaParamValueQueue() noexcept {FUNKNOWN_CTOR}
 
 YaParamValueQueue::~YaParamValueQueue() noexcept {
@@ -29,7 +32,8 @@ void YaParamValueQueue::clear_for_parameter(
 }
 
 void YaParamValueQueue::repopulate(
-    Steinberg::Vst::IParamValueQueue& original_queue) {
+    Steinberg::Vst::IParamValueQueue& original_queue,
+    std::optional<float> thinning_tolerance) {
     parameter_id_ = original_queue.getParameterId();
 
     // Copy over all points to our vector
@@ -39,6 +43,71 @@ void YaParamValueQueue::repopulate(
         // returns `kResultOk`
         original_queue.getPoint(i, queue_[i].first, queue_[i].second);
     }
+
+    if (thinning_tolerance) {
+        thin(*thinning_tolerance);
+    }
+}
+
+void YaParamValueQueue::thin(float tolerance) noexcept {
+    if (queue_.size() <= 2) {
+        return;
+    }
+
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+
+    // We'll compact the queue in place. `anchor` is the last point we've kept.
+    // Every point after it can be dropped as long as the line from the anchor
+    // to the next point we keep stays within `tolerance` of all of the dropped
+    // points, which is the case when that line's slope lies within
+    // `[min_slope, max_slope]`.
+    const size_t last = queue_.size() - 1;
+    size_t num_kept = 1;
+    size_t anchor_index = 0;
+    std::pair<int32, Steinberg::Vst::ParamValue> anchor = queue_[0];
+    double min_slope = -infinity;
+    double max_slope = infinity;
+    std::pair<int32, Steinberg::Vst::ParamValue> previous = anchor;
+    for (size_t i = 1; i <= last; i++) {
+        const std::pair<int32, Steinberg::Vst::ParamValue> point = queue_[i];
+        double offset = point.first - anchor.first;
+        const double slope = (point.second - anchor.second) / offset;
+        if (offset <= 0.0 || slope < min_slope || slope > max_slope) {
+            // The line to this point would stray too far from the points we
+            // skipped, so we'll need to keep the previous point
+            if (i - 1 != anchor_index) {
+                anchor_index = i - 1;
+                anchor = previous;
+                queue_[num_kept++] = anchor;
+            }
+            min_slope = -infinity;
+            max_slope = infinity;
+
+            // Points sharing a sample offset with the anchor can't be
+            // interpolated, so those are always kept. The last point is added
+            // after the loop.
+            offset = point.first - anchor.first;
+            if (offset <= 0.0) {
+                if (i != last) {
+                    queue_[num_kept++] = point;
+                }
+
+                anchor_index = i;
+                anchor = point;
+                previous = point;
+                continue;
+            }
+        }
+
+        min_slope = std::max(
+            min_slope, (point.second - tolerance - anchor.second) / offset);
+        max_slope = std::min(
+            max_slope, (point.second + tolerance - anchor.second) / offset);
+        previous = point;
+    }
+
+    queue_[num_kept++] = queue_[last];
+    queue_.resize(num_kept);
 }
 
 #pragma GCC diagnostic push
@@ -19,6 +19,7 @@
 #include <llvm/small-vector.h>
 #include <pluginterfaces/vst/ivstparameterchanges.h>
 
+#include "../../bitsery/ext/compact-param-points.h"
 #include "../../bitsery/traits/small-vector.h"
 #include "base.h"
 
@@ -49,8 +50,14 @@ class alignas(16) YaParamValueQueue : public Steinberg::Vst::IParamValueQueue {
 
     /**
      * Read data from an `IParamValueQueue` object into this existing object.
+     *
+     * @param thinning_tolerance If set, drop points that lie within this
+     *   distance of the line between the points around them. The first and the
+     *   last points are always kept. This is used for the
+     *   `vst3_automation_thinning` option.
      */
-    void repopulate(Steinberg::Vst::IParamValueQueue& original_queue);
+    void repopulate(Steinberg::Vst::IParamValueQueue& original_queue,
+                    std::optional<float> thinning_tolerance = std::nullopt);
 
     DECLARE_FUNKNOWN_METHODS
 
@@ -75,11 +82,7 @@ class alignas(16) YaParamValueQueue : public Steinberg::Vst::IParamValueQueue {
     template <typename S>
     void serialize(S& s) {
         s.value4b(parameter_id_);
-        // TODO: Does bitsery have a built in way to serialize pairs?
-        s.container(queue_, 1 << 16, [](S& s, std::pair<int32, double>& pair) {
-            s.value4b(pair.first);
-            s.value8b(pair.second);
-        });
+        s.ext(queue_, bitsery::ext::CompactParamPoints(1 << 16));
     }
 
     /**
@@ -88,6 +91,15 @@ class alignas(16) YaParamValueQueue : public Steinberg::Vst::IParamValueQueue {
     Steinberg::Vst::ParamID parameter_id_;
 
    private:
+    /**
+     * Remove points from `queue_` that can be reconstructed through linear
+     * interpolation between the points we keep, with an error of at most
+     * `tolerance`. This runs in linear time by keeping track of the range of
+     * slopes from the last kept point that still pass within `tolerance` of
+     * every point we've skipped since.
+     */
+    void thin(float tolerance) noexcept;
+
     /**
      * The actual parameter changes queue. The specification doesn't mention
      * that this should be a priority queue or something, but I'd assume both
@@ -27,16 +27,26 @@ void YaParameterChanges::clear() noexcept {
 }
 
 void YaParameterChanges::repopulate(
-    Steinberg::Vst::IParameterChanges& original_queues) {
+    Steinberg::Vst::IParameterChanges& original_queues,
+    std::optional<float> thinning_tolerance) {
     // Copy over all parameter change queues
     const size_t num_queues = original_queues.getParameterCount();
     queues_.resize(num_queues);
     for (size_t i = 0; i < num_queues; i++) {
         queues_[i].repopulate(
-            *original_queues.getParameterData(static_cast<int>(i)));
+            *original_queues.getParameterData(static_cast<int>(i)),
+            thinning_tolerance);
     }
 }
 
+void YaParameterChanges::reserve(size_t num_queues) {
+    queues_.reserve(num_queues);
+}
+
+size_t YaParameterChanges::capacity() const noexcept {
+    return queues_.capacity();
+}
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
 IMPLEMENT_FUNKNOWN_METHODS(YaParameterChanges,
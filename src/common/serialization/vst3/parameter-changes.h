@@ -50,8 +50,24 @@ class YaParameterChanges : public Steinberg::Vst::IParameterChanges {
 
     /**
      * Read data from an `IParameterChanges` object into this existing object.
+     *
+     * @see YaParamValueQueue::repopulate
      */
-    void repopulate(Steinberg::Vst::IParameterChanges& original_queues);
+    void repopulate(Steinberg::Vst::IParameterChanges& original_queues,
+                    std::optional<float> thinning_tolerance = std::nullopt);
+
+    /**
+     * Preallocate space for `num_queues` parameter change queues, so the plugin
+     * can output changes for that many parameters without us having to
+     * allocate on the audio thread.
+     */
+    void reserve(size_t num_queues);
+
+    /**
+     * The number of parameter change queues we can store without
+     * reallocating.
+     */
+    size_t capacity() const noexcept;
 
     DECLARE_FUNKNOWN_METHODS
 
@@ -22,8 +22,14 @@ Vst3PluginFactoryProxy::ConstructArgs::ConstructArgs(
     Steinberg::IPtr<Steinberg::FUnknown> object) noexcept
     : plugin_factory_args(object) {}
 
-Vst3PluginFactoryProxy::Vst3PluginFactoryProxy(ConstructArgs&& args) noexcept
-    : YaPluginFactory3(std::move(args.plugin_factory_args)),
+// `YaPluginFactory3`'s arguments are part of ours, so we'll use
+// `std::shared_ptr`'s aliasing constructor to share the same reference count
+Vst3PluginFactoryProxy::Vst3PluginFactoryProxy(
+    std::shared_ptr<const ConstructArgs> args) noexcept
+    : YaPluginFactory3(
+          std::shared_ptr<const YaPluginFactory3::ConstructArgs>(
+              args,
+              &args->plugin_factory_args)),
       arguments_(std::move(args)){FUNKNOWN_CTOR}
 
       // clang-format just doesn't understand these macros, I guess
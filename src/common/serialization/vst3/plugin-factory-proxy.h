@@ -66,9 +66,10 @@ class Vst3PluginFactoryProxy : public YaPluginFactory3 {
     /**
      * Instantiate this instance with arguments read from an actual plugin
      * factory. The is done once during startup and the plugin factory gets
-     * reused for the lifetime of the module.
+     * reused for the lifetime of the module. These arguments may be shared
+     * with other bridges in the same process that load the same module.
      */
-    Vst3PluginFactoryProxy(ConstructArgs&& args) noexcept;
+    Vst3PluginFactoryProxy(std::shared_ptr<const ConstructArgs> args) noexcept;
 
     /**
      * We do not need special handling here since the Window VST3 plugin's
@@ -80,7 +81,7 @@ class Vst3PluginFactoryProxy : public YaPluginFactory3 {
     DECLARE_FUNKNOWN_METHODS
 
    private:
-    ConstructArgs arguments_;
+    std::shared_ptr<const ConstructArgs> arguments_;
 };
 
 #pragma GCC diagnostic pop
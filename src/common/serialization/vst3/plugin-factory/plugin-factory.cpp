@@ -99,13 +99,14 @@ YaPluginFactory3::ConstructArgs::ConstructArgs(
     }
 }
 
-YaPluginFactory3::YaPluginFactory3(ConstructArgs&& args) noexcept
+YaPluginFactory3::YaPluginFactory3(
+    std::shared_ptr<const ConstructArgs> args) noexcept
     : arguments_(std::move(args)) {}
 
 tresult PLUGIN_API
 YaPluginFactory3::getFactoryInfo(Steinberg::PFactoryInfo* info) {
-    if (info && arguments_.factory_info) {
-        *info = *arguments_.factory_info;
+    if (info && arguments_->factory_info) {
+        *info = *arguments_->factory_info;
         return Steinberg::kResultOk;
     } else {
         return Steinberg::kNotInitialized;
@@ -113,19 +114,19 @@ YaPluginFactory3::getFactoryInfo(Steinberg::PFactoryInfo* info) {
 }
 
 int32 PLUGIN_API YaPluginFactory3::countClasses() {
-    return arguments_.num_classes;
+    return arguments_->num_classes;
 }
 
 tresult PLUGIN_API YaPluginFactory3::getClassInfo(Steinberg::int32 index,
                                                   Steinberg::PClassInfo* info) {
-    if (index >= static_cast<int32>(arguments_.class_infos_1.size())) {
+    if (index >= static_cast<int32>(arguments_->class_infos_1.size())) {
         return Steinberg::kInvalidArgument;
     }
 
     // We will have already converted these class IDs to the native
     // representation in `YaPluginFactory3::ConstructArgs`
-    if (arguments_.class_infos_1[index]) {
-        *info = *arguments_.class_infos_1[index];
+    if (arguments_->class_infos_1[index]) {
+        *info = *arguments_->class_infos_1[index];
         return Steinberg::kResultOk;
     } else {
         return Steinberg::kResultFalse;
@@ -134,14 +135,14 @@ tresult PLUGIN_API YaPluginFactory3::getClassInfo(Steinberg::int32 index,
 
 tresult PLUGIN_API
 YaPluginFactory3::getClassInfo2(int32 index, Steinberg::PClassInfo2* info) {
-    if (index >= static_cast<int32>(arguments_.class_infos_2.size())) {
+    if (index >= static_cast<int32>(arguments_->class_infos_2.size())) {
         return Steinberg::kInvalidArgument;
     }
 
     // We will have already converted these class IDs to the native
     // representation in `YaPluginFactory3::ConstructArgs`
-    if (arguments_.class_infos_2[index]) {
-        *info = *arguments_.class_infos_2[index];
+    if (arguments_->class_infos_2[index]) {
+        *info = *arguments_->class_infos_2[index];
         return Steinberg::kResultOk;
     } else {
         return Steinberg::kResultFalse;
@@ -151,14 +152,14 @@ YaPluginFactory3::getClassInfo2(int32 index, Steinberg::PClassInfo2* info) {
 tresult PLUGIN_API
 YaPluginFactory3::getClassInfoUnicode(int32 index,
                                       Steinberg::PClassInfoW* info) {
-    if (index >= static_cast<int32>(arguments_.class_infos_unicode.size())) {
+    if (index >= static_cast<int32>(arguments_->class_infos_unicode.size())) {
         return Steinberg::kInvalidArgument;
     }
 
     // We will have already converted these class IDs to the native
     // representation in `YaPluginFactory3::ConstructArgs`
-    if (arguments_.class_infos_unicode[index]) {
-        *info = *arguments_.class_infos_unicode[index];
+    if (arguments_->class_infos_unicode[index]) {
+        *info = *arguments_->class_infos_unicode[index];
         return Steinberg::kResultOk;
     } else {
         return Steinberg::kResultFalse;
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include <bitsery/traits/string.h>
 #include <pluginterfaces/base/ipluginbase.h>
 
@@ -120,22 +122,23 @@ class YaPluginFactory3 : public Steinberg::IPluginFactory3 {
 
     /**
      * Instantiate this instance with arguments read from the Windows VST3
-     * plugin's plugin factory.
+     * plugin's plugin factory. These arguments are never modified, so they can
+     * be shared between all factories for the same Windows VST3 module.
      */
-    YaPluginFactory3(ConstructArgs&& args) noexcept;
+    YaPluginFactory3(std::shared_ptr<const ConstructArgs> args) noexcept;
 
     virtual ~YaPluginFactory3() noexcept = default;
 
     inline bool supports_plugin_factory() const noexcept {
-        return arguments_.supports_plugin_factory;
+        return arguments_->supports_plugin_factory;
     }
 
     inline bool supports_plugin_factory_2() const noexcept {
-        return arguments_.supports_plugin_factory_2;
+        return arguments_->supports_plugin_factory_2;
     }
 
     inline bool supports_plugin_factory_3() const noexcept {
-        return arguments_.supports_plugin_factory_3;
+        return arguments_->supports_plugin_factory_3;
     }
 
     // All of these functiosn returning class information are fetched once on
@@ -184,7 +187,7 @@ class YaPluginFactory3 : public Steinberg::IPluginFactory3 {
     setHostContext(Steinberg::FUnknown* context) override = 0;
 
    protected:
-    ConstructArgs arguments_;
+    std::shared_ptr<const ConstructArgs> arguments_;
 };
 
 #pragma GCC diagnostic pop
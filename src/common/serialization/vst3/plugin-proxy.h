@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "../../bitsery/ext/in-place-optional.h"
 #include "../../bitsery/ext/in-place-variant.h"
 
 #include "../common.h"
@@ -218,6 +219,25 @@ class Vst3PluginProxy : public YaAudioPresentationLatency,
         }
     };
 
+    /**
+     * Message to request the Wine plugin host to spawn the dedicated
+     * `IAudioProcessor`/`IComponent` thread for this object instance. Only
+     * used with the `vst3_lazy_audio_threads` option, in which case the
+     * native plugin sends this right before the instance's first audio
+     * processor call. Once this returns, the Wine plugin host is listening on
+     * the instance's audio processor socket.
+     */
+    struct StartAudioProcessor {
+        using Response = Ack;
+
+        native_size_t instance_id;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+        }
+    };
+
     /**
      * @remark The plugin side implementation should send a control message to
      *   clean up the instance on the Wine side in its destructor.
@@ -237,6 +257,81 @@ class Vst3PluginProxy : public YaAudioPresentationLatency,
     // These have to be defined here instead of in `YaPluginBase` because we
     // need to reference the `ConstructArgs`
 
+    /**
+     * The answers to the questions every host asks right after initializing a
+     * plugin object. When the `vst3_prefetch_instance_info` option is enabled,
+     * the Wine plugin host will query this information right after
+     * `IPluginBase::initialize()` and send it back as part of the
+     * `InitializeResponse`, so the native plugin can prepopulate its caches
+     * instead of doing a round trip for every one of these function calls.
+     */
+    struct InstanceSummary {
+        /**
+         * The results of `IComponent::getBusCount()` for every media type and
+         * bus direction. Empty if the object does not implement `IComponent`.
+         */
+        struct BusCount {
+            Steinberg::Vst::MediaType type;
+            Steinberg::Vst::BusDirection dir;
+            int32 count;
+
+            template <typename S>
+            void serialize(S& s) {
+                s.value4b(type);
+                s.value4b(dir);
+                s.value4b(count);
+            }
+        };
+
+        /**
+         * The results of successful `IComponent::getBusInfo()` calls for all
+         * of the busses listed in `bus_counts`.
+         */
+        struct BusInfo {
+            Steinberg::Vst::MediaType type;
+            Steinberg::Vst::BusDirection dir;
+            int32 index;
+            Steinberg::Vst::BusInfo info;
+
+            template <typename S>
+            void serialize(S& s) {
+                s.value4b(type);
+                s.value4b(dir);
+                s.value4b(index);
+                s.object(info);
+            }
+        };
+
+        std::vector<BusCount> bus_counts;
+        std::vector<BusInfo> bus_infos;
+
+        /**
+         * The results of `IEditController::getParameterInfo()` for every
+         * parameter, or a nullopt if the object does not implement
+         * `IEditController`. The number of elements is the plugin's parameter
+         * count.
+         */
+        std::optional<YaEditController::GetAllParameterInfosResponse>
+            parameter_infos;
+
+        /**
+         * The result of
+         * `IProcessContextRequirements::getProcessContextRequirements()`, if
+         * the object implements that interface.
+         */
+        std::optional<uint32> process_context_requirements;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(bus_counts, 1 << 4);
+            s.container(bus_infos, 1 << 16);
+            s.ext(parameter_infos, bitsery::ext::InPlaceOptional{});
+            s.ext(process_context_requirements,
+                  bitsery::ext::InPlaceOptional{},
+                  [](S& s, auto& v) { s.value4b(v); });
+        }
+    };
+
     /**
      * The response code and updated supported interface list after a call to
      * `IPluginBase::initialize()`.
@@ -252,10 +347,17 @@ class Vst3PluginProxy : public YaAudioPresentationLatency,
         // plugin-side proxy object
         Vst3PluginProxy::ConstructArgs updated_plugin_interfaces;
 
+        /**
+         * Information prefetched right after initializing the object when the
+         * `vst3_prefetch_instance_info` option is enabled.
+         */
+        std::optional<InstanceSummary> summary;
+
         template <typename S>
         void serialize(S& s) {
             s.object(result);
             s.object(updated_plugin_interfaces);
+            s.ext(summary, bitsery::ext::InPlaceOptional{});
         }
     };
 
@@ -225,12 +225,22 @@ class YaAudioProcessor : public Steinberg::Vst::IAudioProcessor {
      */
     struct ProcessResponse {
         UniversalTResult result;
+
+        /**
+         * If this is set, then `output_data` has been written to the response
+         * metadata region of the instance's shared audio buffers instead, and
+         * it should be read from there using `read_shm_object()`.
+         */
+        bool output_data_in_shm = false;
         YaProcessData::Response output_data;
 
         template <typename S>
         void serialize(S& s) {
             s.object(result);
-            s.object(output_data);
+            s.value1b(output_data_in_shm);
+            if (!output_data_in_shm) {
+                s.object(output_data);
+            }
         }
     };
 
@@ -250,24 +260,63 @@ class YaAudioProcessor : public Steinberg::Vst::IAudioProcessor {
 
         native_size_t instance_id;
 
+        /**
+         * If this is set, then `data` has been written to the request metadata
+         * region of the instance's shared audio buffers instead, and it should
+         * be read from there using `read_shm_object()`. This is only the case
+         * when the serialized data fits in that region.
+         */
+        bool data_in_shm = false;
         YaProcessData data;
 
         /**
-         * We'll periodically synchronize the realtime priority setting of the
-         * host's audio thread with the Wine plugin host. We'll do this
-         * approximately every ten seconds, as doing this getting and setting
-         * scheduler information has a non trivial amount of overhead (even if
-         * it's only a single microsoecond).
+         * The realtime priority of the host's audio thread, if it changed since
+         * the last processing cycle. This lets the Wine plugin host's audio
+         * thread follow priority changes made by the host or by rtkit
+         * immediately, while only having to set the scheduler parameters when
+         * something actually changed.
          */
         std::optional<int> new_realtime_priority;
 
+        /**
+         * The CPU core the host's audio thread is currently running on. This
+         * is only set when the `audio_thread_follow_host_cpu` option is
+         * enabled, and like `new_realtime_priority` it's only sent when it
+         * changes.
+         */
+        std::optional<int> host_audio_thread_cpu;
+
+        /**
+         * The NUMA node the host's audio thread is currently running on. This
+         * is only set when the `audio_thread_follow_host_numa_node` option is
+         * enabled, and it's also only sent when it changes.
+         */
+        std::optional<int> host_audio_thread_numa_node;
+
+        /**
+         * The thread ID of the host's audio thread making this processing
+         * call, when the `audio_thread_host_mapping` option is enabled.
+         *
+         * @see HostAudioThreadMap
+         */
+        std::optional<int> host_thread_id;
+
         template <typename S>
         void serialize(S& s) {
             s.value8b(instance_id);
-            s.object(data);
+            s.value1b(data_in_shm);
+            if (!data_in_shm) {
+                s.object(data);
+            }
 
             s.ext(new_realtime_priority, bitsery::ext::InPlaceOptional{},
                   [](S& s, int& priority) { s.value4b(priority); });
+            s.ext(host_audio_thread_cpu, bitsery::ext::InPlaceOptional{},
+                  [](S& s, int& cpu) { s.value4b(cpu); });
+            s.ext(host_audio_thread_numa_node, bitsery::ext::InPlaceOptional{},
+                  [](S& s, int& node) { s.value4b(node); });
+            s.ext(host_thread_id, bitsery::ext::InPlaceOptional{},
+                  [](S& s, int& id) { s.value4b(id); });
         }
     };
 
@@ -152,6 +152,40 @@ class YaEditController : public Steinberg::Vst::IEditController {
     getParameterInfo(int32 paramIndex,
                      Steinberg::Vst::ParameterInfo& info /*out*/) override = 0;
 
+    /**
+     * The results from calling `IEditController::getParameterInfo()` for every
+     * parameter index in `[0, getParameterCount())`. The response at index `i`
+     * corresponds to parameter index `i`.
+     */
+    struct GetAllParameterInfosResponse {
+        std::vector<GetParameterInfoResponse> infos;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(infos, 1 << 16);
+        }
+    };
+
+    /**
+     * Message to fetch the information for all of a plugin's parameters at
+     * once. This is not part of the VST3 interface. Instead, this is used to
+     * populate `Vst3PluginProxyImpl`'s parameter info cache on the first call
+     * to `IEditController::getParameterInfo()`, since hosts tend to enumerate
+     * every parameter right after initializing the plugin. For plugins with
+     * thousands of parameters doing that with one round trip per parameter
+     * adds up very quickly.
+     */
+    struct GetAllParameterInfos {
+        using Response = GetAllParameterInfosResponse;
+
+        native_size_t instance_id;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+        }
+    };
+
     /**
      * The response code and returned parameter information for a call to
      * `IEditController::getParamStringByValue(id, value_normalized,
@@ -307,6 +341,48 @@ class YaEditController : public Steinberg::Vst::IEditController {
     virtual Steinberg::Vst::ParamValue PLUGIN_API
     getParamNormalized(Steinberg::Vst::ParamID id) override = 0;
 
+    /**
+     * The normalized values of all of a plugin's parameters. These are
+     * returned in the same order as the parameters are enumerated through
+     * `IEditController::getParameterInfo()`.
+     */
+    struct GetAllParamNormalizedResponse {
+        struct Value {
+            Steinberg::Vst::ParamID id;
+            Steinberg::Vst::ParamValue value;
+
+            template <typename S>
+            void serialize(S& s) {
+                s.value4b(id);
+                s.value8b(value);
+            }
+        };
+
+        std::vector<Value> values;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(values, 1 << 16);
+        }
+    };
+
+    /**
+     * Message to fetch the normalized values of all of a plugin's parameters
+     * at once. Like `GetAllParameterInfos` this is not part of the VST3
+     * interface, and it's used to populate the parameter value mirror in
+     * `Vst3PluginProxyImpl` when `vst3_parameter_value_cache` is enabled.
+     */
+    struct GetAllParamNormalized {
+        using Response = GetAllParamNormalizedResponse;
+
+        native_size_t instance_id;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+        }
+    };
+
     /**
      * Message to pass through a call to
      * `IEditController::setParamNormalized(id, value)` to the Wine plugin host.
@@ -132,6 +132,46 @@ class YaKeyswitchController : public Steinberg::Vst::IKeyswitchController {
                      int32 keySwitchIndex,
                      Steinberg::Vst::KeyswitchInfo& info /*out*/) override = 0;
 
+    /**
+     * The result of `IKeyswitchController::getKeyswitchCount(bus_index,
+     * channel)` together with the results from calling
+     * `IKeyswitchController::getKeyswitchInfo()` for every keyswitch index in
+     * `[0, count)`.
+     */
+    struct GetAllKeyswitchInfosResponse {
+        int32 count;
+        std::vector<GetKeyswitchInfoResponse> infos;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value4b(count);
+            s.container(infos, 1 << 16);
+        }
+    };
+
+    /**
+     * Message to fetch all keyswitch information for a bus and channel at
+     * once. This is not part of the VST3 interface. Hosts with key editors
+     * query this information for every channel whenever the editor redraws,
+     * so this is used to populate `Vst3PluginProxyImpl`'s keyswitch cache on
+     * the first query for a bus and channel.
+     */
+    struct GetAllKeyswitchInfos {
+        using Response = GetAllKeyswitchInfosResponse;
+
+        native_size_t instance_id;
+
+        int32 bus_index;
+        int16 channel;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+            s.value4b(bus_index);
+            s.value2b(channel);
+        }
+    };
+
    protected:
     ConstructArgs arguments_;
 };
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivstmidicontrollers.h>
 
 #include "../../common.h"
 #include "../base.h"
@@ -108,6 +109,50 @@ class YaMidiMapping : public Steinberg::Vst::IMidiMapping {
         Steinberg::Vst::CtrlNumber midiControllerNumber,
         Steinberg::Vst::ParamID& id /*out*/) override = 0;
 
+    /**
+     * The number of MIDI channels included in a
+     * `GetAllMidiControllerAssignmentsResponse`.
+     */
+    static constexpr int16 num_midi_channels = 16;
+
+    /**
+     * The results from calling `IMidiMapping::getMidiControllerAssignment()`
+     * for every channel in `[0, num_midi_channels)` and every controller
+     * number in `[0, kCountCtrlNumber)` for a single bus. The response for
+     * channel `c` and controller number `n` is stored at index
+     * `c * kCountCtrlNumber + n`.
+     */
+    struct GetAllMidiControllerAssignmentsResponse {
+        std::vector<GetMidiControllerAssignmentResponse> assignments;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(assignments,
+                        num_midi_channels * Steinberg::Vst::kCountCtrlNumber);
+        }
+    };
+
+    /**
+     * Message to fetch a bus' entire MIDI controller assignment table at once.
+     * This is not part of the VST3 interface. Some hosts query the assignment
+     * for every controller on every channel, sometimes from the audio thread,
+     * so this is used to populate `Vst3PluginProxyImpl`'s cache the first time
+     * the host queries an assignment for a bus.
+     */
+    struct GetAllMidiControllerAssignments {
+        using Response = GetAllMidiControllerAssignmentsResponse;
+
+        native_size_t instance_id;
+
+        int32 bus_index;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+            s.value4b(bus_index);
+        }
+    };
+
    protected:
     ConstructArgs arguments_;
 };
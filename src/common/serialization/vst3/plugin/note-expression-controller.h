@@ -136,6 +136,45 @@ class YaNoteExpressionController
         int32 noteExpressionIndex,
         Steinberg::Vst::NoteExpressionTypeInfo& info /*out*/) override = 0;
 
+    /**
+     * The result of `INoteExpressionController::getNoteExpressionCount(
+     * bus_index, channel)` together with the results from calling
+     * `INoteExpressionController::getNoteExpressionInfo()` for every note
+     * expression index in `[0, count)`.
+     */
+    struct GetAllNoteExpressionInfosResponse {
+        int32 count;
+        std::vector<GetNoteExpressionInfoResponse> infos;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value4b(count);
+            s.container(infos, 1 << 16);
+        }
+    };
+
+    /**
+     * Message to fetch all note expression information for a bus and channel
+     * at once. Like `YaKeyswitchController::GetAllKeyswitchInfos` this is not
+     * part of the VST3 interface, and it's used to populate
+     * `Vst3PluginProxyImpl`'s note expression cache.
+     */
+    struct GetAllNoteExpressionInfos {
+        using Response = GetAllNoteExpressionInfosResponse;
+
+        native_size_t instance_id;
+
+        int32 bus_index;
+        int16 channel;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+            s.value4b(bus_index);
+            s.value2b(channel);
+        }
+    };
+
     /**
      * The response code and returned string for a call to
      * `INoteExpressionController::getNoteExpressionStringByValue(bus_index,
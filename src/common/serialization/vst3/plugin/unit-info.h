@@ -257,6 +257,60 @@ class YaUnitInfo : public Steinberg::Vst::IUnitInfo {
         Steinberg::Vst::CString attributeId /*in*/,
         Steinberg::Vst::String128 attributeValue /*out*/) override = 0;
 
+    /**
+     * A program list's information together with the results of calling
+     * `IUnitInfo::getProgramName()` for every program index in
+     * `[0, info.programCount)`. The name at index `i` corresponds to program
+     * index `i`.
+     */
+    struct ProgramListDescription {
+        GetProgramListInfoResponse list_info;
+        std::vector<GetProgramNameResponse> program_names;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.object(list_info);
+            s.container(program_names, 1 << 16);
+        }
+    };
+
+    /**
+     * The results from calling `IUnitInfo::getUnitInfo()` for every unit index
+     * in `[0, getUnitCount())`, and the information and program names for
+     * every program list index in `[0, getProgramListCount())`.
+     */
+    struct GetAllUnitsAndProgramListsResponse {
+        std::vector<GetUnitInfoResponse> units;
+        std::vector<ProgramListDescription> program_lists;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(units, 1 << 16);
+            s.container(program_lists, 1 << 16);
+        }
+    };
+
+    /**
+     * Message to fetch all of a plugin's units and program lists at once. Like
+     * `YaEditController::GetAllParameterInfos` this is not part of the VST3
+     * interface. Hosts that build preset browsers enumerate every program of
+     * every program list, and plugins with thousands of factory presets would
+     * otherwise need thousands of round trips for that. This is used to
+     * populate `Vst3PluginProxyImpl`'s unit information cache, which is
+     * invalidated when the plugin calls
+     * `IUnitHandler::notifyProgramListChange()`.
+     */
+    struct GetAllUnitsAndProgramLists {
+        using Response = GetAllUnitsAndProgramListsResponse;
+
+        native_size_t instance_id;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+        }
+    };
+
     /**
      * Message to pass through a call to
      * `IUnitInfo::hasProgramPitchNames(list_id, program_index)` to the Wine
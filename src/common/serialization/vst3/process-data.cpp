@@ -16,6 +16,10 @@
 
 #include "process-data.h"
 
+#include <algorithm>
+#include <type_traits>
+
+#include "../../audio-kernels.h"
 #include "../../utils.h"
 
 YaProcessData::YaProcessData() noexcept
@@ -41,14 +45,40 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
     // not use `push_back`/`emplace_back` anywhere. Resizing vectors and
     // modifying them in place performs much better because that avoids
     // destroying and creating objects most of the time.
+    // If the plugin doesn't support the host's precision, then the shared
+    // memory buffers use the plugin's precision and we'll convert the audio
+    // while copying it
+    const int32 shm_sample_size =
+        plugin_sample_size_.value_or(process_data.symbolicSampleSize);
+    const bool sample_size_changed = shm_sample_size != symbolic_sample_size_;
     process_mode_ = process_data.processMode;
-    symbolic_sample_size_ = process_data.symbolicSampleSize;
+    symbolic_sample_size_ = shm_sample_size;
     num_samples_ = process_data.numSamples;
 
     // The actual audio is stored in an accompanying `AudioShmBuffer` object, so
     // these inputs and outputs objects are only used to serialize metadata
     // about the input and output audio bus buffers
     inputs_.resize(process_data.numInputs);
+
+    // We keep track of which input channels in the shared memory object
+    // currently only contain silence. This information has to be discarded when
+    // the buffers get resized or when the block size grows, since we only clear
+    // `zeroed_input_num_samples_` samples at a time.
+    // NOTE: This assumes that the plugin doesn't write to its input buffers,
+    //       which VST3 doesn't guarantee. That's why this is only done with
+    //       the `vst3_skip_silent_inputs` option.
+    if (shared_audio_buffers.generation() != zeroed_input_generation_ ||
+        process_data.numSamples > zeroed_input_num_samples_ ||
+        sample_size_changed) {
+        zeroed_input_channels_.clear();
+        zeroed_input_generation_ = shared_audio_buffers.generation();
+        zeroed_input_num_samples_ = process_data.numSamples;
+    }
+    zeroed_input_channels_.resize(
+        std::max(zeroed_input_channels_.size(),
+                 static_cast<size_t>(process_data.numInputs)),
+        0);
+
     for (int bus = 0; bus < process_data.numInputs; bus++) {
         // NOTE: The host might provide more input channels than what the plugin
         //       asked for. Carla does this for some reason. We should just
@@ -59,18 +89,62 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
         inputs_[bus].silenceFlags = process_data.inputs[bus].silenceFlags;
 
         // We copy the actual input audio for every bus to the shared memory
-        // object
+        // object. If the host's buffers already point to the shared memory
+        // object then we can skip the copy. With `vst3_skip_silent_inputs`,
+        // channels the host has marked as silent are not copied either.
+        // Instead we'll clear the shared memory channel once, and we'll then
+        // skip it entirely for as long as the channel stays silent.
+        uint64_t& zeroed_channels = zeroed_input_channels_[bus];
         for (int channel = 0; channel < inputs_[bus].numChannels; channel++) {
+            const uint64_t channel_bit = channel < 64 ? 1ULL << channel : 0;
+            const bool silent =
+                skip_silent_inputs_ &&
+                (process_data.inputs[bus].silenceFlags & channel_bit) != 0;
+
+            const auto transfer = [&]<typename T, typename U>(
+                                      const T* host_channel, U* shm_channel) {
+                if constexpr (std::is_same_v<T, U>) {
+                    if (host_channel == shm_channel) {
+                        zeroed_channels &= ~channel_bit;
+                        return;
+                    }
+                }
+
+                if (silent) {
+                    if (!(zeroed_channels & channel_bit)) {
+                        audio_kernels::clear(shm_channel,
+                                             zeroed_input_num_samples_);
+                        zeroed_channels |= channel_bit;
+                    }
+                } else {
+                    if constexpr (std::is_same_v<T, U>) {
+                        audio_kernels::copy(host_channel, shm_channel,
+                                            process_data.numSamples);
+                    } else {
+                        audio_kernels::convert(host_channel, shm_channel,
+                                               process_data.numSamples);
+                    }
+                    zeroed_channels &= ~channel_bit;
+                }
+            };
+            const auto transfer_to_shm = [&](const auto* host_channel) {
+                if (shm_sample_size == Steinberg::Vst::kSample64) {
+                    transfer(host_channel,
+                             shared_audio_buffers.input_channel_ptr<double>(
+                                 bus, channel));
+                } else {
+                    transfer(host_channel,
+                             shared_audio_buffers.input_channel_ptr<float>(
+                                 bus, channel));
+                }
+            };
+
             if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
-                std::copy_n(process_data.inputs[bus].channelBuffers64[channel],
-                            process_data.numSamples,
-                            shared_audio_buffers.input_channel_ptr<double>(
-                                bus, channel));
+                transfer_to_shm(
+                    process_data.inputs[bus].channelBuffers64[channel]);
             } else {
-                std::copy_n(process_data.inputs[bus].channelBuffers32[channel],
-                            process_data.numSamples,
-                            shared_audio_buffers.input_channel_ptr<float>(
-                                bus, channel));
+                transfer_to_shm(
+                    process_data.inputs[bus].channelBuffers32[channel]);
             }
         }
     }
@@ -90,7 +164,8 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
     // validator will pass a null pointer here
     if (process_data.inputParameterChanges) {
         input_parameter_changes_.repopulate(
-            *process_data.inputParameterChanges);
+            *process_data.inputParameterChanges,
+            automation_thinning_tolerance_);
     } else {
         input_parameter_changes_.clear();
     }
@@ -100,6 +175,8 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
     if (process_data.outputParameterChanges) {
         if (!output_parameter_changes_) {
             output_parameter_changes_.emplace();
+            output_parameter_changes_->reserve(
+                output_parameter_changes_capacity_);
         }
     } else {
         output_parameter_changes_.reset();
@@ -118,21 +195,105 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
     if (process_data.outputEvents) {
         if (!output_events_) {
             output_events_.emplace();
+            output_events_->reserve(output_events_capacity_);
         }
     } else {
         output_events_.reset();
     }
 
+    // The process context is delta encoded against the last context we sent
+    // to the Wine plugin host. When nothing changed this only costs the four
+    // bytes for the bit mask.
     if (process_data.processContext) {
-        process_context_.emplace(*process_data.processContext);
+        using Delta = YaProcessContextDelta;
+
+        const Steinberg::Vst::ProcessContext& context =
+            *process_data.processContext;
+        const Steinberg::Vst::ProcessContext& last = process_context_;
+
+        uint32_t changed_fields = Delta::has_process_context;
+        if (!has_sent_process_context_ ||
+            shared_audio_buffers.generation() != process_context_generation_) {
+            changed_fields |= Delta::all_fields;
+        } else {
+            if (context.state != last.state) {
+                changed_fields |= Delta::state;
+            }
+            if (context.sampleRate != last.sampleRate) {
+                changed_fields |= Delta::sample_rate;
+            }
+            if (context.projectTimeSamples ==
+                last.projectTimeSamples + process_context_num_samples_) {
+                changed_fields |= Delta::project_time_samples_advanced;
+            } else if (context.projectTimeSamples != last.projectTimeSamples) {
+                changed_fields |= Delta::project_time_samples;
+            }
+            if (context.systemTime != last.systemTime) {
+                changed_fields |= Delta::system_time;
+            }
+            if (context.continousTimeSamples ==
+                last.continousTimeSamples + process_context_num_samples_) {
+                changed_fields |= Delta::continuous_time_samples_advanced;
+            } else if (context.continousTimeSamples !=
+                       last.continousTimeSamples) {
+                changed_fields |= Delta::continuous_time_samples;
+            }
+            if (context.projectTimeMusic != last.projectTimeMusic) {
+                changed_fields |= Delta::project_time_music;
+            }
+            if (context.barPositionMusic != last.barPositionMusic) {
+                changed_fields |= Delta::bar_position_music;
+            }
+            if (context.cycleStartMusic != last.cycleStartMusic) {
+                changed_fields |= Delta::cycle_start_music;
+            }
+            if (context.cycleEndMusic != last.cycleEndMusic) {
+                changed_fields |= Delta::cycle_end_music;
+            }
+            if (context.tempo != last.tempo) {
+                changed_fields |= Delta::tempo;
+            }
+            if (context.timeSigNumerator != last.timeSigNumerator ||
+                context.timeSigDenominator != last.timeSigDenominator) {
+                changed_fields |= Delta::time_signature;
+            }
+            if (context.chord.keyNote != last.chord.keyNote ||
+                context.chord.rootNote != last.chord.rootNote ||
+                context.chord.chordMask != last.chord.chordMask) {
+                changed_fields |= Delta::chord;
+            }
+            if (context.smpteOffsetSubframes != last.smpteOffsetSubframes) {
+                changed_fields |= Delta::smpte_offset_subframes;
+            }
+            if (context.frameRate.framesPerSecond !=
+                    last.frameRate.framesPerSecond ||
+                context.frameRate.flags != last.frameRate.flags) {
+                changed_fields |= Delta::frame_rate;
+            }
+            if (context.samplesToNextClock != last.samplesToNextClock) {
+                changed_fields |= Delta::samples_to_next_clock;
+            }
+        }
+
+        process_context_delta_.changed_fields =
+            changed_fields &
+            (required_process_context_fields_ | Delta::has_process_context);
+        process_context_delta_.context = context;
+
+        process_context_ = context;
+        process_context_num_samples_ = process_data.numSamples;
+        process_context_generation_ = shared_audio_buffers.generation();
+        has_sent_process_context_ = true;
     } else {
-        process_context_.reset();
+        // The Wine side won't touch its state in this case, so we won't either
+        process_context_delta_.changed_fields = 0;
     }
 }
 
 Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
     std::vector<std::vector<void*>>& input_pointers,
-    std::vector<std::vector<void*>>& output_pointers) {
+    std::vector<std::vector<void*>>& output_pointers,
+    YaProcessContextBase& process_context_base) {
     reconstructed_process_data_.processMode = process_mode_;
     reconstructed_process_data_.symbolicSampleSize = symbolic_sample_size_;
     reconstructed_process_data_.numSamples = num_samples_;
@@ -167,6 +328,7 @@ Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
 
     if (output_parameter_changes_) {
         output_parameter_changes_->clear();
+        output_parameter_changes_->reserve(output_parameter_changes_capacity_);
         reconstructed_process_data_.outputParameterChanges =
             &*output_parameter_changes_;
     } else {
@@ -181,13 +343,75 @@ Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
 
     if (output_events_) {
         output_events_->clear();
+        output_events_->reserve(output_events_capacity_);
         reconstructed_process_data_.outputEvents = &*output_events_;
     } else {
         reconstructed_process_data_.outputEvents = nullptr;
     }
 
-    if (process_context_) {
-        reconstructed_process_data_.processContext = &*process_context_;
+    // This is the inverse of the delta encoding done in `repopulate()`
+    if (has_process_context()) {
+        using Delta = YaProcessContextDelta;
+
+        const uint32_t changed_fields = process_context_delta_.changed_fields;
+        const Steinberg::Vst::ProcessContext& new_context =
+            process_context_delta_.context;
+        Steinberg::Vst::ProcessContext& context = process_context_base.context;
+
+        if (changed_fields & Delta::state) {
+            context.state = new_context.state;
+        }
+        if (changed_fields & Delta::sample_rate) {
+            context.sampleRate = new_context.sampleRate;
+        }
+        if (changed_fields & Delta::project_time_samples) {
+            context.projectTimeSamples = new_context.projectTimeSamples;
+        } else if (changed_fields & Delta::project_time_samples_advanced) {
+            context.projectTimeSamples += process_context_base.num_samples;
+        }
+        if (changed_fields & Delta::system_time) {
+            context.systemTime = new_context.systemTime;
+        }
+        if (changed_fields & Delta::continuous_time_samples) {
+            context.continousTimeSamples = new_context.continousTimeSamples;
+        } else if (changed_fields & Delta::continuous_time_samples_advanced) {
+            context.continousTimeSamples += process_context_base.num_samples;
+        }
+        if (changed_fields & Delta::project_time_music) {
+            context.projectTimeMusic = new_context.projectTimeMusic;
+        }
+        if (changed_fields & Delta::bar_position_music) {
+            context.barPositionMusic = new_context.barPositionMusic;
+        }
+        if (changed_fields & Delta::cycle_start_music) {
+            context.cycleStartMusic = new_context.cycleStartMusic;
+        }
+        if (changed_fields & Delta::cycle_end_music) {
+            context.cycleEndMusic = new_context.cycleEndMusic;
+        }
+        if (changed_fields & Delta::tempo) {
+            context.tempo = new_context.tempo;
+        }
+        if (changed_fields & Delta::time_signature) {
+            context.timeSigNumerator = new_context.timeSigNumerator;
+            context.timeSigDenominator = new_context.timeSigDenominator;
+        }
+        if (changed_fields & Delta::chord) {
+            context.chord = new_context.chord;
+        }
+        if (changed_fields & Delta::smpte_offset_subframes) {
+            context.smpteOffsetSubframes = new_context.smpteOffsetSubframes;
+        }
+        if (changed_fields & Delta::frame_rate) {
+            context.frameRate = new_context.frameRate;
+        }
+        if (changed_fields & Delta::samples_to_next_clock) {
+            context.samplesToNextClock = new_context.samplesToNextClock;
+        }
+
+        process_context_base.num_samples = num_samples_;
+        reconstructed_process_data_.processContext =
+            &process_context_base.context;
     } else {
         reconstructed_process_data_.processContext = nullptr;
     }
@@ -195,6 +419,69 @@ Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
     return reconstructed_process_data_;
 }
 
+void YaProcessData::reserve_outputs(size_t num_parameters) {
+    output_parameter_changes_capacity_ =
+        std::min(num_parameters, max_reserved_output_parameter_changes);
+    output_events_capacity_ = reserved_output_events;
+
+    if (output_parameter_changes_) {
+        output_parameter_changes_->reserve(output_parameter_changes_capacity_);
+    }
+    if (output_events_) {
+        output_events_->reserve(output_events_capacity_);
+    }
+}
+
+void YaProcessData::set_process_context_requirements(
+    std::optional<uint32> requirements) noexcept {
+    using Delta = YaProcessContextDelta;
+    using Requirements = Steinberg::Vst::IProcessContextRequirements;
+
+    uint32_t fields = Delta::all_fields | Delta::project_time_samples_advanced |
+                      Delta::continuous_time_samples_advanced;
+    if (requirements) {
+        // These fields don't have corresponding flags, and the state also
+        // contains the flags indicating which of the other fields are valid
+        fields = Delta::state | Delta::sample_rate |
+                 Delta::project_time_samples |
+                 Delta::project_time_samples_advanced;
+
+        const auto require = [&](uint32 flag, uint32_t flag_fields) {
+            if (*requirements & flag) {
+                fields |= flag_fields;
+            }
+        };
+        require(Requirements::kNeedSystemTime, Delta::system_time);
+        require(Requirements::kNeedContinousTimeSamples,
+                Delta::continuous_time_samples |
+                    Delta::continuous_time_samples_advanced);
+        require(Requirements::kNeedProjectTimeMusic, Delta::project_time_music);
+        require(Requirements::kNeedBarPositionMusic, Delta::bar_position_music);
+        require(Requirements::kNeedCycleMusic,
+                Delta::cycle_start_music | Delta::cycle_end_music);
+        require(Requirements::kNeedSamplesToNextClock,
+                Delta::samples_to_next_clock);
+        require(Requirements::kNeedTempo, Delta::tempo);
+        require(Requirements::kNeedTimeSignature, Delta::time_signature);
+        require(Requirements::kNeedChord, Delta::chord);
+        require(Requirements::kNeedFrameRate,
+                Delta::frame_rate | Delta::smpte_offset_subframes);
+    }
+
+    if (fields != required_process_context_fields_) {
+        required_process_context_fields_ = fields;
+        has_sent_process_context_ = false;
+    }
+}
+
+bool YaProcessData::outputs_exceeded_capacity() const noexcept {
+    return (output_parameter_changes_ &&
+            output_parameter_changes_->num_parameters() >
+                output_parameter_changes_capacity_) ||
+           (output_events_ &&
+            output_events_->num_events() > output_events_capacity_);
+}
+
 YaProcessData::Response& YaProcessData::create_response() noexcept {
     // NOTE: We return an object that only contains references to these original
     //       fields to avoid any copies or moves
@@ -214,18 +501,52 @@ void YaProcessData::write_back_outputs(
         //       by the plugin during `YaProcessData::repopulate()`.
         for (int channel = 0; channel < outputs_[bus].numChannels; channel++) {
             // We copy the output audio for every bus from the shared memory
-            // object back to the buffer provided by the host
+            // object back to the buffer provided by the host, unless the host
+            // is already using the shared memory object as its output buffer.
+            // If the plugin marked the channel as silent, then we'll clear the
+            // host's buffer instead so we don't have to read from the shared
+            // memory object.
+            const bool silent =
+                channel < 64 &&
+                (outputs_[bus].silenceFlags & (1ULL << channel)) != 0;
+
+            const auto transfer = [&]<typename T, typename U>(
+                                      const T* shm_channel, U* host_channel) {
+                if constexpr (std::is_same_v<T, U>) {
+                    if (host_channel == shm_channel) {
+                        return;
+                    }
+                }
+
+                if (silent) {
+                    audio_kernels::clear(host_channel, process_data.numSamples);
+                } else if constexpr (std::is_same_v<T, U>) {
+                    audio_kernels::copy(shm_channel, host_channel,
+                                        process_data.numSamples);
+                } else {
+                    audio_kernels::convert(shm_channel, host_channel,
+                                           process_data.numSamples);
+                }
+            };
+            // `symbolic_sample_size_` is the precision used in the shared
+            // memory buffers, which may differ from the host's precision
+            const auto transfer_from_shm = [&](auto* host_channel) {
+                if (symbolic_sample_size_ == Steinberg::Vst::kSample64) {
+                    transfer(shared_audio_buffers.output_channel_ptr<double>(
+                                 bus, channel),
+                             host_channel);
+                } else {
+                    transfer(shared_audio_buffers.output_channel_ptr<float>(
+                                 bus, channel),
+                             host_channel);
+                }
+            };
+
             if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
-                std::copy_n(
-                    shared_audio_buffers.output_channel_ptr<double>(bus,
-                                                                    channel),
-                    process_data.numSamples,
+                transfer_from_shm(
                     process_data.outputs[bus].channelBuffers64[channel]);
             } else {
-                std::copy_n(
-                    shared_audio_buffers.output_channel_ptr<float>(bus,
-                                                                   channel),
-                    process_data.numSamples,
+                transfer_from_shm(
                     process_data.outputs[bus].channelBuffers32[channel]);
             }
         }
@@ -29,6 +29,156 @@
 
 // This header provides serialization wrappers around `ProcessData`
 
+/**
+ * The capacity in bytes of the request and response metadata regions in the
+ * shared audio buffers used for VST3 plugins. The serialized `YaProcessData`
+ * object and its response will usually fit in here, so no process data needs
+ * to be written to the socket. Blocks with a huge number of events or parameter
+ * changes will still be sent over the socket.
+ *
+ * @see AudioShmBuffer::Config::metadata_capacity
+ */
+constexpr uint32_t vst3_process_metadata_capacity = 1 << 15;
+
+/**
+ * The maximum number of output parameter change queues we'll preallocate in
+ * `YaProcessData::reserve_outputs()`. Plugins with tens of thousands of
+ * parameters will never output changes for all of them at once, and
+ * preallocating that many queues would waste a couple megabytes per instance.
+ */
+constexpr size_t max_reserved_output_parameter_changes = 2048;
+
+/**
+ * The number of output events we'll preallocate in
+ * `YaProcessData::reserve_outputs()`.
+ */
+constexpr size_t reserved_output_events = 512;
+
+/**
+ * A `ProcessContext` that's delta encoded against the last process context sent
+ * for the same plugin instance. Only the fields marked in `changed_fields`
+ * are serialized. The two sample position counters can also be marked as
+ * having advanced by exactly the last block's size, which is what they'll do
+ * most of the time. With a steady transport only the musical positions and the
+ * system time will then need to be sent, and a stopped transport will only
+ * send the system time.
+ *
+ * This is encoded in `YaProcessData::repopulate()` and decoded again in
+ * `YaProcessData::reconstruct()`. The plugin side stores the last process
+ * context in `YaProcessData`'s `process_context_` field, and the Wine side
+ * decodes against the instance's `YaProcessContextBase`.
+ */
+struct YaProcessContextDelta {
+    enum Field : uint32_t {
+        state = 1 << 0,
+        sample_rate = 1 << 1,
+        project_time_samples = 1 << 2,
+        system_time = 1 << 3,
+        continuous_time_samples = 1 << 4,
+        project_time_music = 1 << 5,
+        bar_position_music = 1 << 6,
+        cycle_start_music = 1 << 7,
+        cycle_end_music = 1 << 8,
+        tempo = 1 << 9,
+        time_signature = 1 << 10,
+        chord = 1 << 11,
+        smpte_offset_subframes = 1 << 12,
+        frame_rate = 1 << 13,
+        samples_to_next_clock = 1 << 14,
+        all_fields = (1 << 15) - 1,
+        /**
+         * `projectTimeSamples` equals the last value plus the last block's
+         * number of samples. Mutually exclusive with `project_time_samples`.
+         */
+        project_time_samples_advanced = 1 << 16,
+        /**
+         * The same as the above, but for `continousTimeSamples`.
+         */
+        continuous_time_samples_advanced = 1 << 17,
+        /**
+         * If this is not set, then the host did not pass a process context
+         * during this processing cycle.
+         */
+        has_process_context = 1u << 31,
+    };
+
+    uint32_t changed_fields = 0;
+    /**
+     * The new process context. Only the fields marked in `changed_fields` are
+     * meaningful.
+     */
+    Steinberg::Vst::ProcessContext context{};
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value4b(changed_fields);
+
+        if (changed_fields & state) {
+            s.value4b(context.state);
+        }
+        if (changed_fields & sample_rate) {
+            s.value8b(context.sampleRate);
+        }
+        if (changed_fields & project_time_samples) {
+            s.value8b(context.projectTimeSamples);
+        }
+        if (changed_fields & system_time) {
+            s.value8b(context.systemTime);
+        }
+        if (changed_fields & continuous_time_samples) {
+            s.value8b(context.continousTimeSamples);
+        }
+        if (changed_fields & project_time_music) {
+            s.value8b(context.projectTimeMusic);
+        }
+        if (changed_fields & bar_position_music) {
+            s.value8b(context.barPositionMusic);
+        }
+        if (changed_fields & cycle_start_music) {
+            s.value8b(context.cycleStartMusic);
+        }
+        if (changed_fields & cycle_end_music) {
+            s.value8b(context.cycleEndMusic);
+        }
+        if (changed_fields & tempo) {
+            s.value8b(context.tempo);
+        }
+        if (changed_fields & time_signature) {
+            s.value4b(context.timeSigNumerator);
+            s.value4b(context.timeSigDenominator);
+        }
+        if (changed_fields & chord) {
+            s.object(context.chord);
+        }
+        if (changed_fields & smpte_offset_subframes) {
+            s.value4b(context.smpteOffsetSubframes);
+        }
+        if (changed_fields & frame_rate) {
+            s.object(context.frameRate);
+        }
+        if (changed_fields & samples_to_next_clock) {
+            s.value4b(context.samplesToNextClock);
+        }
+    }
+};
+
+/**
+ * The last process context decoded from a `YaProcessContextDelta` on the Wine
+ * side. The `YaProcessData` objects used for deserialization on the Wine side
+ * are thread local, and a `process()` call can arrive on any of an instance's
+ * audio processor connections, so this needs to be stored per plugin instance
+ * instead of in `YaProcessData`. The plugin will be passed a pointer to
+ * `context`.
+ */
+struct YaProcessContextBase {
+    Steinberg::Vst::ProcessContext context{};
+    /**
+     * The number of samples in the processing cycle `context` was last
+     * updated in, used to predict the sample position counters.
+     */
+    int32 num_samples = 0;
+};
+
 /**
  * A serializable wrapper around `ProcessData`. We'll read all information from
  * the host so we can serialize it and provide an equivalent `ProcessData`
@@ -64,7 +214,9 @@ class YaProcessData {
      * we've received in previous calls).
      *
      * During this process the input audio will be written to
-     * `shared_audio_buffers`. There's no direct link between this
+     * `shared_audio_buffers`. With `set_skip_silent_inputs()`, channels marked
+     * as silent through `AudioBusBuffers::silenceFlags` are only cleared once
+     * instead of being copied every cycle. There's no direct link between this
      * `YaProcessData` object and those buffers, but they should be used as a
      * pair. This is a bit ugly, but optimizations sadly never made code
      * prettier.
@@ -90,10 +242,93 @@ class YaProcessData {
      * but we'll accept these as void pointers since the stride will be
      * different depending on whether the host is going to be sending double or
      * single precision audio.
+     *
+     * The delta encoded process context is decoded against
+     * `process_context_base`, which should belong to the plugin instance.
      */
     Steinberg::Vst::ProcessData& reconstruct(
         std::vector<std::vector<void*>>& input_pointers,
-        std::vector<std::vector<void*>>& output_pointers);
+        std::vector<std::vector<void*>>& output_pointers,
+        YaProcessContextBase& process_context_base);
+
+    /**
+     * Preallocate the output parameter changes and output events so the plugin
+     * can write to them during `IAudioProcessor::process()` without us having
+     * to allocate memory on the audio thread. This is sized from the plugin's
+     * parameter count, with a fixed capacity for the events. The capacity is
+     * remembered, and it will also be applied when the output fields get
+     * (re)initialized in `repopulate()` or during deserialization. This
+     * should be called before `reconstruct()`, and it's essentially free when
+     * the outputs already have enough capacity.
+     *
+     * @param num_parameters The number of parameters reported by the plugin's
+     *   `IEditController::getParameterCount()`, or 0 if the object doesn't
+     *   implement `IEditController`.
+     */
+    void reserve_outputs(size_t num_parameters);
+
+    /**
+     * Only send the process context fields the plugin asked for through
+     * `IProcessContextRequirements::getProcessContextRequirements()`. The
+     * other fields will be left at whatever values were last sent for them.
+     * The state, the sample rate, and the project time in samples are always
+     * sent. Changing the requirements causes the next process context to be
+     * sent in full. This should be called from
+     * `IAudioProcessor::setupProcessing()` on the plugin side.
+     *
+     * @param requirements The flags returned by the plugin, or an empty
+     *   optional if the plugin does not implement
+     *   `IProcessContextRequirements`. In that case every field will be sent.
+     */
+    void set_process_context_requirements(
+        std::optional<uint32> requirements) noexcept;
+
+    /**
+     * Thin out the input parameter changes using this tolerance before
+     * sending them to the Wine plugin host, for the `vst3_automation_thinning`
+     * option.
+     *
+     * @see YaParamValueQueue::repopulate
+     */
+    inline void set_automation_thinning_tolerance(
+        std::optional<float> tolerance) noexcept {
+        automation_thinning_tolerance_ = tolerance;
+    }
+
+    /**
+     * Skip copying input channels the host marked as silent to the shared
+     * memory audio buffers, for the `vst3_skip_silent_inputs` option. Those
+     * channels are only cleared once. This is off by default since plugins
+     * processing in place may write to their input buffers.
+     */
+    inline void set_skip_silent_inputs(bool skip) noexcept {
+        skip_silent_inputs_ = skip;
+    }
+
+    /**
+     * Use this precision for the shared memory audio buffers instead of the
+     * host's precision. This is used when the plugin only supports the other
+     * precision. The audio is then converted while it's being copied to and
+     * from the shared memory buffers, so this doesn't add another pass over
+     * the audio. This should be called from
+     * `IAudioProcessor::setupProcessing()` on the plugin side.
+     *
+     * @param sample_size The plugin's `Steinberg::Vst::SymbolicSampleSizes`, or
+     *   an empty optional if the plugin supports the host's precision.
+     */
+    inline void set_plugin_sample_size(
+        std::optional<int32> sample_size) noexcept {
+        plugin_sample_size_ = sample_size;
+    }
+
+    /**
+     * Whether the plugin output changes for more parameters or output more
+     * events during the last processing cycle than we preallocated space for
+     * in `reserve_outputs()`. In that case the vectors will have been
+     * reallocated on the audio thread. Meant to be checked on the Wine side
+     * after calling the plugin's `IAudioProcessor::process()`.
+     */
+    bool outputs_exceeded_capacity() const noexcept;
 
     /**
      * A serializable wrapper around the output fields of `ProcessData`, so we
@@ -149,7 +384,8 @@ class YaProcessData {
     /**
      * Write all of this output data back to the host's `ProcessData` object.
      * During this process we'll also write the output audio from the
-     * corresponding shared memory audio buffers back.
+     * corresponding shared memory audio buffers back. Output channels the
+     * plugin marked as silent are cleared instead of copied.
      */
     void write_back_outputs(Steinberg::Vst::ProcessData& process_data,
                             const AudioShmBuffer& shared_audio_buffers);
@@ -173,7 +409,7 @@ class YaProcessData {
         s.ext(input_events_, bitsery::ext::InPlaceOptional{});
         s.ext(output_events_, bitsery::ext::InPlaceOptional{});
 
-        s.ext(process_context_, bitsery::ext::InPlaceOptional{});
+        s.object(process_context_delta_);
 
         // We of course won't serialize the `reconstructed_process_data` and all
         // of the `output*` fields defined below it
@@ -240,9 +476,18 @@ class YaProcessData {
     std::optional<YaEventList> output_events_;
 
     /**
-     * Some more information about the project and transport.
+     * Some more information about the project and transport, delta encoded
+     * against the last process context.
      */
-    std::optional<Steinberg::Vst::ProcessContext> process_context_;
+    YaProcessContextDelta process_context_delta_;
+
+    /**
+     * Whether the host passed a process context during this processing cycle.
+     */
+    inline bool has_process_context() const noexcept {
+        return process_context_delta_.changed_fields &
+               YaProcessContextDelta::has_process_context;
+    }
 
    private:
     // These last few members are used on the Wine plugin host side to
@@ -266,6 +511,84 @@ class YaProcessData {
      * The process data we reconstruct from the other fields during `get()`.
      */
     Steinberg::Vst::ProcessData reconstructed_process_data_;
+
+    /**
+     * The last process context on the plugin side. This is the context
+     * `process_context_delta_` was last encoded from. The Wine side uses a
+     * `YaProcessContextBase` instead.
+     */
+    Steinberg::Vst::ProcessContext process_context_{};
+    /**
+     * The number of samples in the processing cycle `process_context_` was
+     * last updated in, used to predict the sample position counters.
+     */
+    int32 process_context_num_samples_ = 0;
+    /**
+     * On the plugin side, whether `process_context_` contains a context that
+     * has also been sent to the Wine plugin host. If this is not the case, then
+     * the next context will be sent in full.
+     */
+    bool has_sent_process_context_ = false;
+    /**
+     * The `AudioShmBuffer::generation()` the last process context was sent
+     * for. We'll send the full context again after the buffers get resized,
+     * since that's a good point to resynchronize.
+     */
+    uint32_t process_context_generation_ = 0;
+    /**
+     * The `YaProcessContextDelta` fields the plugin needs, based on its
+     * `IProcessContextRequirements`. Fields not in this mask are never sent.
+     *
+     * @see set_process_context_requirements
+     */
+    uint32_t required_process_context_fields_ =
+        YaProcessContextDelta::all_fields |
+        YaProcessContextDelta::project_time_samples_advanced |
+        YaProcessContextDelta::continuous_time_samples_advanced;
+
+    /**
+     * @see set_automation_thinning_tolerance
+     */
+    std::optional<float> automation_thinning_tolerance_;
+
+    /**
+     * @see set_skip_silent_inputs
+     */
+    bool skip_silent_inputs_ = false;
+
+    /**
+     * @see set_plugin_sample_size
+     */
+    std::optional<int32> plugin_sample_size_;
+
+    /**
+     * The number of output parameter change queues set during
+     * `reserve_outputs()`.
+     */
+    size_t output_parameter_changes_capacity_ = 0;
+    /**
+     * The number of output events set during `reserve_outputs()`.
+     */
+    size_t output_events_capacity_ = 0;
+
+    // These fields are used on the plugin side in `repopulate()` to avoid
+    // copying silent input channels to the shared memory object
+
+    /**
+     * A bitmask per input bus of the channels in the shared memory object that
+     * currently only contain zeroes. Like `AudioBusBuffers::silenceFlags` this
+     * can only track the first 64 channels of every bus.
+     */
+    llvm::SmallVector<uint64_t, 8> zeroed_input_channels_;
+    /**
+     * The number of samples at the start of the channels in
+     * `zeroed_input_channels_` that have been cleared.
+     */
+    int32 zeroed_input_num_samples_ = 0;
+    /**
+     * The `AudioShmBuffer::generation()` `zeroed_input_channels_` is valid for.
+     */
+    uint32_t zeroed_input_generation_ = 0;
 };
 
 namespace Steinberg {
@@ -299,7 +622,6 @@ void serialize(S& s, Steinberg::Vst::ProcessContext& process_context) {
     s.value4b(process_context.timeSigDenominator);
     s.object(process_context.chord);
     s.value4b(process_context.smpteOffsetSubframes);
-    s.value4b(process_context.smpteOffsetSubframes);
     s.object(process_context.frameRate);
     s.value4b(process_context.samplesToNextClock);
 }
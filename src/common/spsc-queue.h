@@ -0,0 +1,104 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+/**
+ * A bounded lock-free single-producer single-consumer queue. Instead of moving
+ * objects in and out of the queue, the producer and the consumer get direct
+ * access to the preallocated slots. This way objects with heap buffers such as
+ * `DynamicVstEvents` can reuse those buffers, and as long as the producer
+ * assigns to the slot instead of replacing it, the consumer will never have to
+ * free any memory.
+ *
+ * For a push, call `begin_push()`, write to the returned slot, and then call
+ * `end_push()` to make it visible to the consumer. For a pop, read from the
+ * slot returned by `front()` and then call `pop()`. Only a single thread may
+ * push at a time and only a single thread may pop at a time. If multiple
+ * threads need to push, then those pushes need to be serialized with a mutex
+ * the consumer doesn't touch.
+ */
+template <typename T>
+class SpscQueue {
+   public:
+    /**
+     * Allocate `capacity` default initialized slots.
+     */
+    explicit SpscQueue(size_t capacity) : slots_(capacity) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * The maximum number of elements in the queue.
+     */
+    size_t capacity() const noexcept { return slots_.size(); }
+
+    /**
+     * Get the next free slot, or a null pointer if the queue is full. Should
+     * only be called from the producer thread, and it should be followed by a
+     * call to `end_push()` if it returned a slot.
+     */
+    T* begin_push() noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+            return nullptr;
+        }
+
+        return &slots_[tail % slots_.size()];
+    }
+
+    /**
+     * Publish the slot returned by the last call to `begin_push()`.
+     */
+    void end_push() noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+    /**
+     * Get the oldest element in the queue, or a null pointer if the queue is
+     * empty. Should only be called from the consumer thread.
+     */
+    T* front() noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        return &slots_[head % slots_.size()];
+    }
+
+    /**
+     * Release the element returned by `front()` back to the producer.
+     */
+    void pop() noexcept {
+        head_.store(head_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+   private:
+    std::vector<T> slots_;
+
+    // These positions only ever increase, so the number of elements in the
+    // queue is always `tail_ - head_`. They're kept on separate cache lines to
+    // avoid false sharing between the producer and the consumer.
+    alignas(64) std::atomic_size_t head_ = 0;
+    alignas(64) std::atomic_size_t tail_ = 0;
+};
@@ -17,8 +17,12 @@
 #include "utils.h"
 
 #include <stdlib.h>
+#include <algorithm>
+#include <fstream>
 
 #include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <xmmintrin.h>
 
 namespace fs = ghc::filesystem;
@@ -39,6 +43,42 @@ constexpr char disable_watchdog_timer_env_var[] = "YABRIDGE_NO_WATCHDOG";
  */
 constexpr char temp_dir_override_env_var[] = "YABRIDGE_TEMP_DIR";
 
+/**
+ * The fraction of an audio block's duration an audio thread is allowed to
+ * spend processing that block when using `SCHED_DEADLINE`. Plugins that need
+ * more than this will be throttled until the next period, but reserving the
+ * entire period would make admission control reject more than one instance per
+ * core.
+ */
+constexpr double deadline_runtime_fraction = 0.5;
+
+/**
+ * The kernel refuses `SCHED_DEADLINE` runtimes smaller than this.
+ */
+constexpr uint64_t min_deadline_runtime_ns = 1024;
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#ifndef SCHED_FLAG_RESET_ON_FORK
+#define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+
+/**
+ * The kernel's `struct sched_attr`. glibc only started exposing this together
+ * with `sched_setattr()` in version 2.41, so we'll use the raw syscall instead.
+ */
+struct KernelSchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
 fs::path get_temporary_directory() {
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
     if (const auto directory = getenv(temp_dir_override_env_var)) {
@@ -51,6 +91,13 @@ fs::path get_temporary_directory() {
     }
 }
 
+std::string format_duration_ms(std::chrono::steady_clock::duration duration) {
+    return std::to_string(
+               std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+                   .count()) +
+           " ms";
+}
+
 std::optional<int> get_realtime_priority() noexcept {
     sched_param current_params{};
     if (sched_getparam(0, &current_params) == 0 &&
@@ -61,12 +108,123 @@ std::optional<int> get_realtime_priority() noexcept {
     }
 }
 
+bool is_realtime_scheduled() noexcept {
+    const int policy = sched_getscheduler(0);
+    return policy == SCHED_FIFO || policy == SCHED_RR ||
+           policy == SCHED_DEADLINE;
+}
+
 bool set_realtime_priority(bool sched_fifo, int priority) noexcept {
     sched_param params{.sched_priority = (sched_fifo ? priority : 0)};
     return sched_setscheduler(0, sched_fifo ? SCHED_FIFO : SCHED_OTHER,
                               &params) == 0;
 }
 
+bool set_deadline_scheduling(uint64_t period_ns) noexcept {
+    const uint64_t runtime_ns = static_cast<uint64_t>(
+        static_cast<double>(period_ns) * deadline_runtime_fraction);
+    if (runtime_ns < min_deadline_runtime_ns) {
+        return false;
+    }
+
+    KernelSchedAttr attr{.size = sizeof(KernelSchedAttr),
+                         .sched_policy = SCHED_DEADLINE,
+                         .sched_flags = SCHED_FLAG_RESET_ON_FORK,
+                         .sched_nice = 0,
+                         .sched_priority = 0,
+                         .sched_runtime = runtime_ns,
+                         .sched_deadline = period_ns,
+                         .sched_period = period_ns};
+
+    return syscall(SYS_sched_setattr, 0, &attr, 0) == 0;
+}
+
+uint64_t audio_block_period_ns(int64_t block_size,
+                               double sample_rate) noexcept {
+    if (block_size <= 0 || sample_rate <= 0.0) {
+        return 0;
+    }
+
+    return static_cast<uint64_t>(
+        (static_cast<double>(block_size) / sample_rate) * 1.0e9);
+}
+
+std::optional<int> get_current_cpu() noexcept {
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        return cpu;
+    } else {
+        return std::nullopt;
+    }
+}
+
+std::optional<int> get_current_numa_node() noexcept {
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (getcpu(&cpu, &node) == 0) {
+        return static_cast<int>(node);
+    } else {
+        return std::nullopt;
+    }
+}
+
+int get_current_thread_id() noexcept {
+    thread_local const int thread_id = static_cast<int>(gettid());
+
+    return thread_id;
+}
+
+bool set_audio_thread_affinity(const std::vector<int>& cpus,
+                               std::optional<int> follow_cpu) noexcept {
+    if (follow_cpu && !cpus.empty() &&
+        std::find(cpus.begin(), cpus.end(), *follow_cpu) == cpus.end()) {
+        follow_cpu.reset();
+    }
+    if (cpus.empty() && !follow_cpu) {
+        return false;
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (follow_cpu) {
+        CPU_SET(*follow_cpu, &cpu_set);
+    } else {
+        for (const int cpu : cpus) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+
+    return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+}
+
+bool set_audio_thread_numa_affinity(const std::vector<int>& cpus,
+                                    int node) noexcept {
+    // The node's cores are stored as a list of ranges, like `0-15,32-47`
+    std::ifstream cpulist_file("/sys/devices/system/node/node" +
+                               std::to_string(node) + "/cpulist");
+    std::vector<int> node_cpus;
+    int first = 0;
+    while (cpulist_file >> first) {
+        int last = first;
+        if (cpulist_file.peek() == '-') {
+            cpulist_file.ignore();
+            cpulist_file >> last;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            if (cpus.empty() ||
+                std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+                node_cpus.push_back(cpu);
+            }
+        }
+
+        if (cpulist_file.peek() == ',') {
+            cpulist_file.ignore();
+        }
+    }
+
+    return !node_cpus.empty() && set_audio_thread_affinity(node_cpus);
+}
+
 std::optional<rlim_t> get_memlock_limit() noexcept {
     rlimit limits{};
     if (getrlimit(RLIMIT_MEMLOCK, &limits) == 0) {
@@ -85,6 +243,24 @@ std::optional<rlim_t> get_rttime_limit() noexcept {
     }
 }
 
+std::optional<std::string> get_shmem_huge_page_mode() {
+    // The file will contain all options on a single line, with the selected
+    // option between square brackets
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+    std::string options;
+    if (!std::getline(file, options)) {
+        return std::nullopt;
+    }
+
+    const size_t start = options.find('[');
+    const size_t end = options.find(']', start);
+    if (start == std::string::npos || end == std::string::npos) {
+        return std::nullopt;
+    }
+
+    return options.substr(start + 1, end - start - 1);
+}
+
 bool is_watchdog_timer_disabled() {
     // This is safe because we're not storing the pointer anywhere and the
     // environment doesn't get modified anywhere
@@ -94,6 +270,30 @@ bool is_watchdog_timer_disabled() {
     return disable_watchdog_env && disable_watchdog_env == "1"sv;
 }
 
+PiMutex::PiMutex() noexcept {
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&mutex_, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+}
+
+PiMutex::~PiMutex() noexcept {
+    pthread_mutex_destroy(&mutex_);
+}
+
+void PiMutex::lock() noexcept {
+    pthread_mutex_lock(&mutex_);
+}
+
+bool PiMutex::try_lock() noexcept {
+    return pthread_mutex_trylock(&mutex_) == 0;
+}
+
+void PiMutex::unlock() noexcept {
+    pthread_mutex_unlock(&mutex_);
+}
+
 ScopedFlushToZero::ScopedFlushToZero() noexcept {
     old_ftz_mode_ = _MM_GET_FLUSH_ZERO_MODE();
     _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
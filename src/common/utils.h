@@ -16,21 +16,18 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <optional>
+#include <string>
+#include <vector>
 
+#include <pthread.h>
 #include <sys/resource.h>
 #include <ghc/filesystem.hpp>
 
 #define YABRIDGE_EXPORT __attribute__((visibility("default")))
 
-/**
- * The interval in seconds between synchronizing the Wine plugin host's audio
- * thread scheduling priority with the host's audio thread.
- *
- * @relates Vst2Bridge::last_audio_thread_priority_synchronization
- */
-constexpr time_t audio_thread_priority_synchronization_interval = 10;
-
 /**
  * When the `hide_daw` compatibility option is enabled, we'll report this
  * instead of the actual DAW's name. This can be useful when plugins are
@@ -79,6 +76,12 @@ overload(Ts...) -> overload<Ts...>;
  */
 ghc::filesystem::path get_temporary_directory();
 
+/**
+ * Format a duration as a whole number of milliseconds for the timings we log
+ * while initializing plugins and opening editors.
+ */
+std::string format_duration_ms(std::chrono::steady_clock::duration duration);
+
 /**
  * Get the current thread's scheduling priority if the thread is using
  * `SCHED_FIFO`. Returns a nullopt of the calling thread is not under realtime
@@ -86,6 +89,12 @@ ghc::filesystem::path get_temporary_directory();
  */
 std::optional<int> get_realtime_priority() noexcept;
 
+/**
+ * Whether the calling thread uses one of the realtime scheduling policies. In
+ * contrast to `get_realtime_priority()`, this also includes `SCHED_DEADLINE`.
+ */
+bool is_realtime_scheduled() noexcept;
+
 /**
  * Set the scheduling policy to `SCHED_FIFO` with priority 5 for this process.
  * We explicitly don't do this for wineserver itself since from my testing that
@@ -95,8 +104,8 @@ std::optional<int> get_realtime_priority() noexcept;
  *   to `SCHED_FIFO`. Otherwise reset it back to `SCHWED_OTHER`.
  * @param priority The scheduling priority to use. The exact value usually
  *   doesn't really matter unless there are a lot of other active `SCHED_FIFO`
- *   background tasks. We'll use 5 as a default, but we'll periodically copy the
- *   priority set by the host on the audio threads.
+ *   background tasks. We'll use 5 as a default, but we'll copy the priority set
+ *   by the host on the audio threads whenever it changes.
  *
  * @return Whether the operation was successful or not. This will fail if the
  *   user does not have the privileges to set realtime priorities.
@@ -109,6 +118,102 @@ std::optional<int> get_realtime_priority() noexcept;
  */
 bool set_realtime_priority(bool sched_fifo, int priority = 5) noexcept;
 
+/**
+ * Switch the calling thread to `SCHED_DEADLINE` scheduling for an audio thread
+ * that processes one block of audio every `period_ns` nanoseconds. The thread
+ * gets a runtime budget of `deadline_runtime_fraction` of that period, and its
+ * deadline is the end of the period. The kernel will refuse this if it doesn't
+ * support `SCHED_DEADLINE`, if the user lacks the privileges for it, if the
+ * thread's CPU affinity has been restricted, or if admission control rejects
+ * the additional bandwidth.
+ *
+ * NOTE: This sets `SCHED_FLAG_RESET_ON_FORK`, since `SCHED_DEADLINE` threads
+ *       are otherwise not allowed to spawn new threads. Any threads spawned
+ *       from this thread will use the normal scheduler.
+ *
+ * @return Whether the scheduling policy was changed. If this returns false,
+ *   then the thread's existing scheduling policy is left untouched.
+ */
+bool set_deadline_scheduling(uint64_t period_ns) noexcept;
+
+/**
+ * The duration of a block of `block_size` samples at `sample_rate` in
+ * nanoseconds, for use with `set_deadline_scheduling()`. Returns 0 if either of
+ * the values is not positive.
+ */
+uint64_t audio_block_period_ns(int64_t block_size, double sample_rate) noexcept;
+
+/**
+ * Get the CPU core the calling thread is currently running on. Returns a
+ * nullopt if this could not be determined.
+ */
+std::optional<int> get_current_cpu() noexcept;
+
+/**
+ * Get the NUMA node the calling thread is currently running on. Returns a
+ * nullopt if this could not be determined.
+ */
+std::optional<int> get_current_numa_node() noexcept;
+
+/**
+ * Used to only send the host's audio thread's realtime priority and CPU core to
+ * the Wine plugin host when they change. Returns `current` if it contains a
+ * value that differs from `last_sent`, and updates `last_sent` in that case.
+ * Returns a nullopt otherwise.
+ */
+inline std::optional<int> take_if_changed(
+    std::optional<int> current,
+    std::optional<int>& last_sent) noexcept {
+    if (current && current != last_sent) {
+        last_sent = current;
+        return current;
+    } else {
+        return std::nullopt;
+    }
+}
+
+/**
+ * Get the calling thread's kernel thread ID. The result is cached per thread
+ * since this is called during every processing cycle when the
+ * `audio_thread_host_mapping` option is enabled.
+ */
+int get_current_thread_id() noexcept;
+
+/**
+ * Restrict the calling thread to a set of CPU cores. This is used for the
+ * Wine plugin host's audio threads so they can be kept on isolated cores,
+ * away from the GUI and X11 threads.
+ *
+ * @param cpus The CPU cores the thread is allowed to run on, set through the
+ *   `audio_thread_cpus` option. If this is empty, then the thread's affinity
+ *   will only be changed when `follow_cpu` is set.
+ * @param follow_cpu The CPU core the host's audio thread was last seen
+ *   running on, if the `audio_thread_follow_host_cpu` option is enabled. If
+ *   this core is one of `cpus` (or if `cpus` is empty), then the thread will be
+ *   pinned to only this core.
+ *
+ * @return Whether the affinity was changed. This will also return false if
+ *   there was nothing to change.
+ */
+bool set_audio_thread_affinity(
+    const std::vector<int>& cpus,
+    std::optional<int> follow_cpu = std::nullopt) noexcept;
+
+/**
+ * Restrict the calling thread to the CPU cores belonging to a NUMA node, for
+ * the `audio_thread_follow_host_numa_node` option. This reads the node's cores
+ * from sysfs, so it should only be called when the node changes.
+ *
+ * @param cpus The CPU cores set through the `audio_thread_cpus` option. If this
+ *   is not empty, then only the node's cores from this list will be used.
+ * @param node The NUMA node the host's audio thread was last seen running on.
+ *
+ * @return Whether the affinity was changed. This returns false if none of the
+ *   allowed cores belong to the node.
+ */
+bool set_audio_thread_numa_affinity(const std::vector<int>& cpus,
+                                    int node) noexcept;
+
 /**
  * Get the (soft) `RLIMIT_MEMLOCK` resource limit. If this is set to some low
  * value, then we'll print a warning during initialization because mapping
@@ -130,6 +235,18 @@ std::optional<rlim_t> get_memlock_limit() noexcept;
  */
 std::optional<rlim_t> get_rttime_limit() noexcept;
 
+/**
+ * Get the kernel's transparent huge page policy for shared memory, i.e. the
+ * currently selected value in `/sys/kernel/mm/transparent_hugepage/
+ * shmem_enabled`. This will be one of `always`, `within_size`, `advise`,
+ * `never`, `deny` or `force`. Used in the initialization message when the
+ * `pin_audio_buffers` option is enabled, since the shared audio buffers can
+ * only be backed by huge pages when this is not set to `never` or `deny`. If
+ * the file does not exist or it could not be parsed, then a nullopt will be
+ * returned.
+ */
+std::optional<std::string> get_shmem_huge_page_mode();
+
 /**
  * Returns `true` if `YABRIDGE_NO_WATCHDOG` is set to `1`. In that case we will
  * not check if the Wine plugin host process successfully started, and we'll
@@ -166,6 +283,32 @@ class ScopedFlushToZero {
     std::optional<unsigned int> old_ftz_mode_;
 };
 
+/**
+ * A mutex with priority inheritance (`PTHREAD_PRIO_INHERIT`). This should be
+ * used instead of `std::mutex` for locks that are taken on an audio thread as
+ * well as on non-realtime threads. If a non-realtime thread holds the lock
+ * while the audio thread wants to acquire it, then the kernel will temporarily
+ * boost the holder to the audio thread's priority. Otherwise the holder could
+ * be preempted by unrelated realtime threads while the audio thread is waiting
+ * on it. This satisfies the `Lockable` requirements, so it can be used with
+ * `std::lock_guard` and `std::unique_lock`.
+ */
+class PiMutex {
+   public:
+    PiMutex() noexcept;
+    ~PiMutex() noexcept;
+
+    PiMutex(const PiMutex&) = delete;
+    PiMutex& operator=(const PiMutex&) = delete;
+
+    void lock() noexcept;
+    bool try_lock() noexcept;
+    void unlock() noexcept;
+
+   private:
+    pthread_mutex_t mutex_;
+};
+
 /**
  * A helper to temporarily cache a value. Calling `ScopedValueCache::set(x)`
  * will return a guard object. When `ScopedValueCache::get()` is called while
@@ -293,6 +436,11 @@ class TimedValueCache {
         valid_until_ = time(nullptr) + lifetime_seconds;
     }
 
+    /**
+     * Drop the cached value, if there is one.
+     */
+    void clear() noexcept { valid_until_ = 0; }
+
    private:
     T value_;
     time_t valid_until_ = 0;
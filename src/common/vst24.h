@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 // This file contains important opcodes and structs missing from
 // `vestige/aeffectx.h`
 
@@ -55,6 +57,88 @@
  */
 [[maybe_unused]] constexpr int effVendorSpecific = 50;
 
+/**
+ * A yabridge specific `effVendorSpecific` extension. When the host calls
+ * `effVendorSpecific` with this value as its `index` argument, the native
+ * plugin writes pointers to the shared memory audio buffers for the plugin's
+ * input channels (when `value` is `kYabridgeInputBuffers`) or its output
+ * channels (when `value` is `kYabridgeOutputBuffers`) to the `void*` array
+ * passed through the `data` argument. That array needs to be large enough to
+ * hold `numInputs` or `numOutputs` pointers. The pointers are either `float*`
+ * or `double*` depending on the processing precision set through
+ * `effSetProcessPrecision()`. This returns 1 if the pointers were written, or 0
+ * if the buffers have not yet been set up.
+ *
+ * A host that writes its input audio to and reads its output audio from these
+ * buffers by passing the same pointers to `processReplacing()` or
+ * `processDoubleReplacing()` avoids both audio copies done while bridging.
+ * These pointers are only valid until the next call to `effMainsChanged()`.
+ * This is handled entirely on the native plugin side and it's never passed
+ * through to the Windows plugin. The value spells out 'ybab'.
+ */
+[[maybe_unused]] constexpr int yabridgeVendorSpecificAudioBuffers =
+    0x79626162;
+[[maybe_unused]] constexpr intptr_t kYabridgeInputBuffers = 0;
+[[maybe_unused]] constexpr intptr_t kYabridgeOutputBuffers = 1;
+
+/**
+ * Another yabridge specific `effVendorSpecific` extension that lets the host
+ * process audio for multiple bridged plugin instances at once. The host passes
+ * an array of `value` `YabridgeProcessBatchEntry` structs through the `data`
+ * argument, and it can call this on any of the instances in the batch. All
+ * instances will first be sent their processing requests, and only after that
+ * do we wait for the results. Since every instance has its own audio thread on
+ * the Wine side, the instances will process their audio in parallel. This means
+ * that processing `n` instances takes about as long as the slowest instance
+ * instead of the sum of all instances.
+ *
+ * This returns 1 if every entry was processed, or 0 if nothing was processed
+ * because one of the entries does not refer to a yabridge plugin, because an
+ * instance's buffers have not yet been set up, because an entry's block size
+ * or precision doesn't match what the instance was set up for using
+ * `effSetBlockSize()` and `effSetProcessPrecision()`, because an instance uses
+ * pipelined processing, or because an instance appears more than once in the
+ * batch. In that case the host should process the instances one
+ * by one like it normally would. The value spells out 'ybbp'.
+ */
+[[maybe_unused]] constexpr int yabridgeVendorSpecificProcessBatch = 0x79626270;
+
+/**
+ * An entry in the array passed to `yabridgeVendorSpecificProcessBatch`. These
+ * fields correspond to the arguments of `processReplacing()`, or to those of
+ * `processDoubleReplacing()` when `double_precision` is non-zero. In that case
+ * `inputs` and `outputs` should be `double**`.
+ */
+struct YabridgeProcessBatchEntry {
+    AEffect* effect;
+    void** inputs;
+    void** outputs;
+    int sample_frames;
+    int double_precision;
+};
+
+/**
+ * Whether an instance appears more than once in a
+ * `yabridgeVendorSpecificProcessBatch` batch. Every instance has a single
+ * shared memory audio buffer and a single pending processing request, so the
+ * second entry would overwrite the first entry's audio or wait for a response
+ * that has already been consumed. Batches are small, so a quadratic search is
+ * fine here.
+ */
+inline bool process_batch_has_duplicates(
+    const YabridgeProcessBatchEntry* entries,
+    size_t num_entries) noexcept {
+    for (size_t i = 1; i < num_entries; i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (entries[i].effect == entries[j].effect) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 /**
  * Set a parameter based on a string, kind of the inverse of the inverse of
  * `effGetParamDisplay()` and an alternative to `setParameter()`. Also found in
@@ -169,6 +169,10 @@ constexpr int kVstMidiType = 1;
 // https://github.com/x42/lv2vst/blob/30a669a021812da05258519cef9d4202f5ce26c3/include/vestige.h#L139
 constexpr int kVstSysExType = 6;
 
+// Returned by `audioMasterGetCurrentProcessLevel` while the host is rendering
+// offline
+constexpr int kVstProcessLevelOffline = 4;
+
 constexpr int kVstNanosValid = 1 << 8;
 constexpr int kVstPpqPosValid = 1 << 9;
 constexpr int kVstTempoValid = 1 << 10;
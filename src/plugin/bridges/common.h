@@ -20,6 +20,7 @@
 #include <iomanip>
 
 #include <sys/resource.h>
+#include <asio/executor_work_guard.hpp>
 
 // Generated inside of the build directory
 #include <config.h>
@@ -28,6 +29,7 @@
 #include "../../common/configuration.h"
 #include "../../common/linking.h"
 #include "../../common/notifications.h"
+#include "../../common/serialization/common.h"
 #include "../../common/utils.h"
 #include "../host-process.h"
 
@@ -48,6 +50,14 @@ constexpr int memlock_min_safe_threshold = 256 << 20;
  */
 constexpr int rttime_min_safe_threshold = 30'000'000;
 
+/**
+ * The period used to check whether we can use `SCHED_DEADLINE` scheduling when
+ * the `audio_thread_sched_deadline` option is enabled. This corresponds to a
+ * block of 480 samples at 48 kHz. The actual period used on the Wine side
+ * depends on the host's block size and sample rate.
+ */
+constexpr uint64_t deadline_probe_period_ns = 10'000'000;
+
 /**
  * Handles all common operations for hosting plugins such as initializing up the
  * plugin host process, setting up the logger, and logging debug information on
@@ -70,52 +80,41 @@ class PluginBridge {
      *   should load.
      * @param create_socket_instance A function to create a socket instance.
      *   Using a lambda here feels wrong, but I can't think of a better
-     *   solution right now.
+     *   solution right now. The boolean argument indicates whether the sockets
+     *   should use abstract socket endpoints, which is only the case when we
+     *   spawn an individual Wine plugin host for this plugin.
+     * @param defer_host_launch If set, the Wine plugin host won't be started
+     *   here. The derived class then has to call `launch_plugin_host()` before
+     *   doing anything else that requires the Wine plugin host. This is used
+     *   for the `vst2_scan_cache` option.
      *
      * @throw std::runtime_error Thrown when the Wine plugin host could not be
      *   found, or if it could not locate and load a corresponding Windows
      *   plugin library.
      */
-    template <
-        invocable_returning<TSockets, asio::io_context&, const PluginInfo&> F>
+    template <invocable_returning<TSockets,
+                                  asio::io_context&,
+                                  const PluginInfo&,
+                                  bool> F>
     PluginBridge(PluginType plugin_type,
                  const ghc::filesystem::path& plugin_path,
-                 F&& create_socket_instance)
+                 F&& create_socket_instance,
+                 bool defer_host_launch = false)
         // This is still correct for VST3 plugins because we can configure an
         // entire directory (the module's bundle) at once
         : config_(load_config_for(plugin_path)),
           info_(plugin_type, plugin_path, config_.vst3_prefer_32bit),
           io_context_(),
-          sockets_(create_socket_instance(io_context_, info_)),
+          io_context_work_guard_(asio::make_work_guard(io_context_)),
+          sockets_(create_socket_instance(
+              io_context_,
+              info_,
+              !config_.group && !config_.host_pool_size)),
           generic_logger_(Logger::create_from_environment(
               create_logger_prefix(sockets_.base_dir_))),
-          plugin_host_(
-              config_.group
-                  ? std::unique_ptr<HostProcess>(std::make_unique<GroupHost>(
-                        io_context_,
-                        generic_logger_,
-                        config_,
-                        sockets_,
-                        info_,
-                        HostRequest{
-                            .plugin_type = plugin_type,
-                            .plugin_path = info_.windows_plugin_path_.string(),
-                            .endpoint_base_dir = sockets_.base_dir_.string(),
-                            .parent_pid = getpid()}))
-                  : std::unique_ptr<HostProcess>(
-                        std::make_unique<IndividualHost>(
-                            io_context_,
-                            generic_logger_,
-                            config_,
-                            sockets_,
-                            info_,
-                            HostRequest{.plugin_type = plugin_type,
-                                        .plugin_path =
-                                            info_.windows_plugin_path_.string(),
-                                        .endpoint_base_dir =
-                                            sockets_.base_dir_.string(),
-                                        .parent_pid = getpid()}))),
           has_realtime_priority_(has_realtime_priority_promise_.get_future()),
+          has_deadline_scheduling_(
+              has_deadline_scheduling_promise_.get_future()),
           wine_io_handler_([&]() {
               // We no longer run this thread with realtime scheduling because
               // plugins that produce a lot of FIXMEs could in theory cause
@@ -123,15 +122,82 @@ class PluginBridge {
               // to check whether we support it
               has_realtime_priority_promise_.set_value(
                   set_realtime_priority(true));
+              has_deadline_scheduling_promise_.set_value(
+                  config_.audio_thread_sched_deadline &&
+                  set_deadline_scheduling(deadline_probe_period_ns));
               set_realtime_priority(false);
               pthread_setname_np(pthread_self(), "wine-stdio");
 
               io_context_.run();
-          }) {}
+          }) {
+        if (!defer_host_launch) {
+            launch_plugin_host();
+        }
+    }
 
     virtual ~PluginBridge() noexcept = default;
 
    protected:
+    /**
+     * Start the Wine plugin host, or connect to an existing group host process.
+     * This is called from the constructor unless `defer_host_launch` was set.
+     * The Windows plugin library gets read into the page cache in the
+     * background while Wine starts.
+     *
+     * @throw std::runtime_error Thrown when the Wine plugin host could not be
+     *   found or started.
+     */
+    void launch_plugin_host() {
+        host_launch_started_at_ = std::chrono::steady_clock::now();
+        readahead_handler_ = std::jthread([&](std::stop_token st) {
+            pthread_setname_np(pthread_self(), "readahead");
+
+            info_.readahead_plugin_files(st);
+        });
+
+        try {
+            if (config_.wineserver_persistence) {
+                wineserver_status_ = info_.start_persistent_wineserver(
+                    *config_.wineserver_persistence);
+            }
+            wineserver_started_at_ = std::chrono::steady_clock::now();
+
+            HostRequest request{
+                .plugin_type = info_.plugin_type_,
+                .plugin_path = info_.windows_plugin_path_.string(),
+                .endpoint_base_dir = sockets_.base_dir_.string(),
+                .parent_pid = getpid()};
+            if (config_.group) {
+                if (config_.group_parallel_loading) {
+                    request.preload_library_path =
+                        info_.windows_library_path_.string();
+                }
+
+                plugin_host_ = std::make_unique<GroupHost>(
+                    io_context_, generic_logger_, config_, sockets_, info_,
+                    request);
+            } else if (config_.host_pool_size) {
+                plugin_host_ = std::make_unique<PooledHost>(
+                    io_context_, generic_logger_, config_, sockets_, info_,
+                    request);
+            } else {
+                plugin_host_ = std::make_unique<IndividualHost>(
+                    io_context_, generic_logger_, config_, sockets_, info_,
+                    request);
+            }
+            host_launched_at_ = std::chrono::steady_clock::now();
+        } catch (...) {
+            // `wine_io_handler_` would otherwise keep waiting for work that
+            // will never come when the bridge gets destroyed
+            io_context_.stop();
+            throw;
+        }
+
+        // From here on `wine_io_handler_` runs until the Wine plugin host's
+        // output pipes get closed, just like before we had to defer this
+        io_context_work_guard_.reset();
+    }
+
     /**
      * Format and log all relevant debug information during initialization.
      */
@@ -194,6 +260,15 @@ class PluginBridge {
         } else {
             init_msg << "'no'" << std::endl;
         }
+        if (config_.audio_thread_sched_deadline) {
+            init_msg << "scheduling:    '";
+            if (has_deadline_scheduling_.get()) {
+                init_msg << "SCHED_DEADLINE";
+            } else {
+                init_msg << "SCHED_FIFO, SCHED_DEADLINE is not available";
+            }
+            init_msg << "'" << std::endl;
+        }
         // This doesn't really fit here, but this seems like the place to warn
         // about low memlock limits. Because this is meant to just be a helpful
         // warning, we won't print anything at all when there's no need to.
@@ -231,8 +306,32 @@ class PluginBridge {
                 << "memlock limit: 'WARNING: Could not fetch RLIMIT_MEMLOCK'"
                 << std::endl;
         }
+        // When the shared audio buffers should be pinned we'll also show
+        // whether they can be backed by huge pages, since that depends on the
+        // kernel's configuration
+        if (config_.pin_audio_buffers) {
+            init_msg << "huge pages:    '";
+            if (const auto mode = get_shmem_huge_page_mode()) {
+                init_msg << *mode;
+                if (*mode == "never" || *mode == "deny") {
+                    init_msg << ", audio buffers will use regular pages";
+                }
+            } else {
+                init_msg << "WARNING: Could not read the shared memory "
+                            "transparent huge page policy";
+            }
+            init_msg << "'" << std::endl;
+        }
         init_msg << "sockets:       '" << sockets_.base_dir_.string() << "'"
                  << std::endl;
+        // Requests and responses won't be logged at all when yabridge was
+        // built with `-Devent-logging=false`
+        if constexpr (!event_logging_enabled) {
+            if (generic_logger_.verbosity_ >= Logger::Verbosity::most_events) {
+                init_msg << "event logging: 'disabled in this build'"
+                         << std::endl;
+            }
+        }
 
         init_msg << "wine prefix:   '";
         std::visit(
@@ -250,6 +349,10 @@ class PluginBridge {
 
         init_msg << "wine version:  '" << info_.wine_version() << "'"
                  << std::endl;
+        if (wineserver_status_) {
+            init_msg << "wineserver:    '" << *wineserver_status_ << "'"
+                     << std::endl;
+        }
         init_msg << std::endl;
 
         // Print the path to the currently loaded configuration file and all
@@ -268,8 +371,17 @@ class PluginBridge {
         init_msg << "hosting mode:  '";
         if (config_.group) {
             init_msg << "plugin group \"" << *config_.group << "\"";
+            if (config_.group_parallel_loading) {
+                init_msg << ", parallel loading";
+            }
+            if (config_.group_module_cache) {
+                init_msg << ", module cache";
+            }
         } else {
             init_msg << "individually";
+            if (config_.host_pool_size) {
+                init_msg << ", host pool of " << *config_.host_pool_size;
+            }
         }
         switch (info_.plugin_arch_) {
             case LibArchitecture::dll_32:
@@ -281,8 +393,69 @@ class PluginBridge {
         }
         init_msg << "'" << std::endl;
 
+        // The remaining phases happen after this message has been printed, see
+        // `log_startup_timings()`
+        init_msg << "startup:       'config "
+                 << format_duration_ms(config_loaded_at_ - startup_started_at_)
+                 << ", plugin library "
+                 << format_duration_ms(library_resolved_at_ -
+                                       config_loaded_at_);
+        if (wineserver_status_) {
+            init_msg << ", wineserver "
+                     << format_duration_ms(wineserver_started_at_ -
+                                           host_launch_started_at_);
+        }
+        init_msg << ", host launch "
+                 << format_duration_ms(host_launched_at_ -
+                                       wineserver_started_at_)
+                 << "'" << std::endl;
+
         init_msg << "other options: ";
         std::vector<std::string> other_options;
+        if (config_.audio_buffer_headroom) {
+            std::ostringstream option;
+            option << "audio: buffer headroom " << std::setprecision(2)
+                   << *config_.audio_buffer_headroom << "x";
+            other_options.push_back(option.str());
+        }
+        if (config_.audio_buffer_idle_release_s) {
+            other_options.push_back(
+                "audio: release idle buffers after " +
+                std::to_string(*config_.audio_buffer_idle_release_s) + " s");
+        }
+        if (config_.audio_buffer_reclaim) {
+            other_options.push_back("audio: reclaim buffers");
+        }
+        if (config_.audio_deadline_warning) {
+            std::ostringstream option;
+            option << "audio: deadline warnings at "
+                   << *config_.audio_deadline_warning;
+            other_options.push_back(option.str());
+        }
+        if (!config_.audio_thread_cpus.empty()) {
+            std::string cpus;
+            for (const int cpu : config_.audio_thread_cpus) {
+                if (!cpus.empty()) {
+                    cpus += ",";
+                }
+                cpus += std::to_string(cpu);
+            }
+            other_options.push_back("audio: threads on CPUs " + cpus);
+        }
+        if (config_.audio_thread_follow_host_cpu) {
+            other_options.push_back("audio: follow host CPU");
+        }
+        if (config_.audio_thread_follow_host_numa_node) {
+            other_options.push_back("audio: follow host NUMA node");
+        }
+        if (config_.audio_thread_host_mapping) {
+            other_options.push_back("audio: core per host thread");
+        }
+        if (config_.audio_wait_spin_us) {
+            other_options.push_back("audio: spin for " +
+                                    std::to_string(*config_.audio_wait_spin_us) +
+                                    " us");
+        }
         if (config_.disable_pipes) {
             other_options.push_back(
                 "hack: pipes disabled, plugin output will go to \"" +
@@ -294,24 +467,143 @@ class PluginBridge {
         if (config_.editor_force_dnd) {
             other_options.push_back("editor: force drag-and-drop");
         }
+        if (config_.editor_obscured_frame_rate) {
+            std::ostringstream option;
+            option << "editor: obscured frame rate: " << std::setprecision(2)
+                   << *config_.editor_obscured_frame_rate << " fps";
+            other_options.push_back(option.str());
+        }
+        if (config_.editor_precreate_window) {
+            other_options.push_back("editor: precreate window");
+        }
         if (config_.editor_xembed) {
             other_options.push_back("editor: XEmbed");
         }
+        if (config_.event_loop_idle_backoff) {
+            other_options.push_back("event loop: idle back-off");
+        }
         if (config_.frame_rate) {
             std::ostringstream option;
             option << "frame rate: " << std::setprecision(2)
                    << *config_.frame_rate << " fps";
             other_options.push_back(option.str());
         }
+        if (config_.futex_signalling) {
+            other_options.push_back("audio: futex signalling");
+        }
         if (config_.hide_daw) {
             other_options.push_back("hack: hide DAW name");
         }
+        if (config_.memory_huge_pages) {
+            other_options.push_back("memory: huge pages");
+        }
+        if (config_.memory_merging) {
+            other_options.push_back("memory: same-page merging");
+        }
+        if (config_.offline_render_non_realtime) {
+            other_options.push_back("audio: non-realtime offline rendering");
+        }
+        if (config_.parameter_metadata_cache) {
+            other_options.push_back("parameter metadata cache");
+        }
+        if (config_.pin_audio_buffers) {
+            other_options.push_back("audio: pinned buffers");
+        }
+        if (config_.profile) {
+            other_options.push_back("profile: " + *config_.profile);
+        }
+        if (config_.speaker_arrangement_cache) {
+            other_options.push_back("speaker arrangement cache");
+        }
+        if (config_.vst2_async_automation) {
+            other_options.push_back("vst2: asynchronous automation");
+        }
+        if (config_.vst2_batch_midi_events) {
+            other_options.push_back("vst2: batched MIDI events");
+        }
+        if (config_.vst2_chunk_cache) {
+            other_options.push_back("vst2: chunk cache");
+        }
+        if (config_.vst2_coalesce_io_changed) {
+            other_options.push_back("vst2: coalesce IO changes");
+        }
+        if (config_.vst2_detect_silence) {
+            other_options.push_back("vst2: silence detection");
+        }
+        if (config_.vst2_midi_output_queue_size) {
+            other_options.push_back(
+                "vst2: MIDI output queue size " +
+                std::to_string(*config_.vst2_midi_output_queue_size));
+        }
+        if (config_.vst2_parameter_cache_ms) {
+            other_options.push_back(
+                "vst2: parameter cache " +
+                std::to_string(*config_.vst2_parameter_cache_ms) + " ms");
+        }
+        if (config_.vst2_parameter_info_cache) {
+            other_options.push_back("vst2: parameter info cache");
+        }
+        if (config_.vst2_pipelined_processing) {
+            other_options.push_back("vst2: pipelined processing");
+        }
+        if (config_.vst2_program_name_cache) {
+            other_options.push_back("vst2: program name cache");
+        }
+        if (config_.vst2_scan_cache) {
+            other_options.push_back("vst2: scan cache");
+        }
+        if (config_.vst3_async_callbacks) {
+            other_options.push_back("vst3: asynchronous callbacks");
+        }
+        if (config_.vst3_automation_thinning) {
+            std::ostringstream option;
+            option << "vst3: automation thinning at "
+                   << *config_.vst3_automation_thinning;
+            other_options.push_back(option.str());
+        }
+        if (config_.vst3_control_off_gui_thread) {
+            other_options.push_back("vst3: control off GUI thread");
+        }
+        if (config_.vst3_edit_coalescing_ms) {
+            other_options.push_back(
+                "vst3: coalesce edits for " +
+                std::to_string(*config_.vst3_edit_coalescing_ms) + " ms");
+        }
+        if (config_.vst3_fast_offline_processing) {
+            other_options.push_back("vst3: fast offline processing");
+        }
+        if (config_.vst3_get_state_off_gui_thread) {
+            other_options.push_back("vst3: getState() off GUI thread");
+        }
+        if (config_.vst3_lazy_audio_threads) {
+            other_options.push_back("vst3: lazy audio threads");
+        }
         if (config_.vst3_no_scaling) {
             other_options.push_back("vst3: no GUI scaling");
         }
+        if (config_.vst3_parameter_finder_cache) {
+            other_options.push_back("vst3: parameter finder cache");
+        }
+        if (config_.vst3_parameter_value_cache) {
+            other_options.push_back("vst3: parameter value cache");
+        }
         if (config_.vst3_prefer_32bit) {
             other_options.push_back("vst3: prefer 32-bit");
         }
+        if (config_.vst3_prefetch_instance_info) {
+            other_options.push_back("vst3: prefetch instance info");
+        }
+        if (config_.vst3_restart_coalescing_ms) {
+            other_options.push_back(
+                "vst3: coalesce restarts for " +
+                std::to_string(*config_.vst3_restart_coalescing_ms) + " ms");
+        }
+        if (config_.vst3_shared_bus_cache) {
+            other_options.push_back("vst3: shared bus cache");
+        }
+        if (config_.vst3_skip_silent_inputs) {
+            other_options.push_back("vst3: skip silent inputs");
+        }
         if (!other_options.empty()) {
             init_msg << join_quoted_strings(other_options) << std::endl;
         } else {
@@ -394,6 +686,7 @@ class PluginBridge {
                         "see the error.",
                         info_.native_library_path_);
 
+                    Logger::flush();
                     std::terminate();
                 }
 
@@ -403,11 +696,28 @@ class PluginBridge {
 #endif
 
         sockets_.connect();
+        sockets_connected_at_ = std::chrono::steady_clock::now();
 #ifndef WITH_WINEDBG
         host_watchdog_handler_.request_stop();
 #endif
     }
 
+    /**
+     * Log how long the remaining startup phases took. The init message only
+     * covers the phases up to launching the Wine plugin host. Connecting to
+     * the sockets includes starting Wine and loading the plugin's library,
+     * and the Wine plugin host logs how long that last part took on its own.
+     *
+     * @param plugin_phases A description of how long it took to create the
+     *   plugin after the sockets were connected, e.g. `"factory 20 ms"`.
+     */
+    void log_startup_timings(const std::string& plugin_phases) {
+        generic_logger_.log("startup: sockets connected after " +
+                            format_duration_ms(sockets_connected_at_ -
+                                               host_launched_at_) +
+                            ", " + plugin_phases);
+    }
+
     /**
      * Show a desktop notification if the Wine plugin host is using a different
      * version of yabridge than this library. Yabridge may still work (and we do
@@ -433,6 +743,48 @@ class PluginBridge {
         }
     }
 
+    /**
+     * Turn off any options in `config_` that the Wine plugin host does not
+     * support. This should be called during startup after receiving the host's
+     * capabilities, and before the configuration is sent to the Wine plugin
+     * host.
+     *
+     * @see Capabilities
+     */
+    void negotiate_capabilities(const Capabilities& host_capabilities) {
+        const auto disable_unsupported = [&](bool& option,
+                                             Capabilities::Flag flag,
+                                             const char* option_name) {
+            if (option && !host_capabilities.supports(flag)) {
+                generic_logger_.log(
+                    "WARNING: The Wine plugin host does not support '" +
+                    std::string(option_name) + "', disabling it.");
+                option = false;
+            }
+        };
+
+        disable_unsupported(config_.futex_signalling,
+                            Capabilities::futex_signalling, "futex_signalling");
+        disable_unsupported(config_.pin_audio_buffers,
+                            Capabilities::pinned_audio_buffers,
+                            "pin_audio_buffers");
+        disable_unsupported(config_.vst2_pipelined_processing,
+                            Capabilities::vst2_pipelined_processing,
+                            "vst2_pipelined_processing");
+        disable_unsupported(config_.vst3_fast_offline_processing,
+                            Capabilities::vst3_fast_offline_processing,
+                            "vst3_fast_offline_processing");
+    }
+
+    /**
+     * When this bridge started initializing. This and the other `*_at_`
+     * timestamps are initialized in between the members whose initialization
+     * they time, and they're printed as part of the init message and by
+     * `log_startup_timings()`.
+     */
+    const std::chrono::steady_clock::time_point startup_started_at_ =
+        std::chrono::steady_clock::now();
+
     /**
      * The configuration for this instance of yabridge. Set based on the values
      * from a `yabridge.toml`, if it exists.
@@ -440,14 +792,40 @@ class PluginBridge {
      * @see ../utils.h:load_config_for
      */
     Configuration config_;
+    const std::chrono::steady_clock::time_point config_loaded_at_ =
+        std::chrono::steady_clock::now();
 
     /**
      * Information about the plugin we're bridging.
      */
     const PluginInfo info_;
+    const std::chrono::steady_clock::time_point library_resolved_at_ =
+        std::chrono::steady_clock::now();
+
+   private:
+    /**
+     * Reads the Windows plugin library and its bundle into the page cache
+     * while we're launching the Wine plugin host. Started at the beginning of
+     * `launch_plugin_host()`.
+     *
+     * @see PluginInfo::readahead_plugin_files
+     */
+    std::jthread readahead_handler_;
+
+   protected:
 
     asio::io_context io_context_;
 
+   private:
+    /**
+     * Keeps `wine_io_handler_` running until `launch_plugin_host()` has
+     * started the Wine plugin host and has set up its output pipes.
+     */
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>>
+        io_context_work_guard_;
+
+   protected:
+
     /**
      * The sockets used for communication with the Wine process.
      *
@@ -466,12 +844,32 @@ class PluginBridge {
      */
     Logger generic_logger_;
 
+    /**
+     * What happened when we tried to start a persistent wineserver for the
+     * `wineserver_persistence` option, printed as part of the init message.
+     * This is done before launching the Wine plugin host so the host process
+     * connects to that wineserver.
+     */
+    std::optional<std::string> wineserver_status_;
+    /**
+     * When `launch_plugin_host()` was called. Without `defer_host_launch` this
+     * is right after the bridge has been set up.
+     */
+    std::chrono::steady_clock::time_point host_launch_started_at_;
+    std::chrono::steady_clock::time_point wineserver_started_at_;
+
     /**
      * The Wine process hosting our plugins. In the case of group hosts a
      * `PluginBridge` instance doesn't actually own a process, but rather either
      * spawns a new detached process or it connects to an existing one.
      */
     std::unique_ptr<HostProcess> plugin_host_;
+    std::chrono::steady_clock::time_point host_launched_at_;
+    /**
+     * Set in `connect_sockets_guarded()` once the Wine plugin host has
+     * connected to all of our sockets.
+     */
+    std::chrono::steady_clock::time_point sockets_connected_at_;
 
    private:
     /**
@@ -489,6 +887,21 @@ class PluginBridge {
      */
     std::future<bool> has_realtime_priority_;
 
+   private:
+    /**
+     * The promise belonging to `has_deadline_scheduling_` below.
+     */
+    std::promise<bool> has_deadline_scheduling_promise_;
+
+   public:
+    /**
+     * Whether this thread could switch to `SCHED_DEADLINE` scheduling when the
+     * `audio_thread_sched_deadline` option is enabled. Checked on the same
+     * thread as `has_realtime_priority_`. The Wine plugin host's audio threads
+     * will use `SCHED_FIFO` when this is not possible.
+     */
+    std::future<bool> has_deadline_scheduling_;
+
     /**
      * Runs the Asio `io_context_` thread for logging the Wine process
      * STDOUT and STDERR messages.
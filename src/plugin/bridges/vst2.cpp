@@ -16,7 +16,12 @@
 
 #include "vst2.h"
 
+#include <cstddef>
+#include <set>
+
+#include "../../common/audio-kernels.h"
 #include "../../common/communication/vst2.h"
+#include "../../common/realtime-allocation-check.h"
 #include "../utils.h"
 
 intptr_t dispatch_proxy(AEffect*, int, int, intptr_t, void*, float);
@@ -26,6 +31,13 @@ void process_double_replacing_proxy(AEffect*, double**, double**, int);
 void set_parameter_proxy(AEffect*, int, float);
 float get_parameter_proxy(AEffect*, int);
 
+/**
+ * How long a display string fetched together with a parameter's name and label
+ * can be used for when the `vst2_parameter_info_cache` option is enabled. Hosts
+ * tend to request all three strings for a parameter in quick succession.
+ */
+constexpr std::chrono::milliseconds parameter_display_lifetime(100);
+
 /**
  * Fetch the bridge instance stored in an unused pointer from a VST plugin. This
  * is sadly needed as a workaround to avoid using globals since we need free
@@ -35,33 +47,94 @@ Vst2PluginBridge& get_bridge_instance(const AEffect& plugin) noexcept {
     return *static_cast<Vst2PluginBridge*>(plugin.ptr3);
 }
 
+namespace {
+
+/**
+ * Check whether two `AEffect` structs contain the same values. This compares
+ * the same fields `update_aeffect()` copies.
+ */
+bool aeffect_values_equal(const AEffect& lhs, const AEffect& rhs) noexcept {
+    return lhs.magic == rhs.magic && lhs.numPrograms == rhs.numPrograms &&
+           lhs.numParams == rhs.numParams && lhs.numInputs == rhs.numInputs &&
+           lhs.numOutputs == rhs.numOutputs && lhs.flags == rhs.flags &&
+           lhs.initialDelay == rhs.initialDelay &&
+           lhs.empty3a == rhs.empty3a && lhs.empty3b == rhs.empty3b &&
+           lhs.unkown_float == rhs.unkown_float &&
+           lhs.uniqueID == rhs.uniqueID && lhs.version == rhs.version;
+}
+
+/**
+ * Speaker arrangements rejected by a VST2 plugin through
+ * `effSetSpeakerArrangement()` when the `speaker_arrangement_cache` option is
+ * enabled. This is shared between all plugin instances using this library, and
+ * it's indexed by the plugin's unique ID and version, and by the key returned
+ * from `speaker_arrangement_key()`.
+ */
+std::set<std::tuple<int32_t, int32_t, std::string>>
+    rejected_speaker_arrangements;
+std::mutex rejected_speaker_arrangements_mutex;
+
+/**
+ * Check whether a speaker arrangement's number of speakers is within the range
+ * we can serialize.
+ */
+bool valid_speaker_arrangement(
+    const VstSpeakerArrangement& arrangement) noexcept {
+    return arrangement.num_speakers >= 0 &&
+           static_cast<size_t>(arrangement.num_speakers) <= max_audio_channels;
+}
+
+/**
+ * Concatenate the raw input and output speaker arrangements passed to
+ * `effSetSpeakerArrangement()` so they can be compared and used as a key for
+ * the `speaker_arrangement_cache` option. Returns a nullopt if either of them
+ * has an invalid number of speakers.
+ */
+std::optional<std::string> speaker_arrangement_key(
+    const VstSpeakerArrangement& input,
+    const VstSpeakerArrangement& output) {
+    std::string key;
+    for (const VstSpeakerArrangement* arrangement : {&input, &output}) {
+        if (!valid_speaker_arrangement(*arrangement)) {
+            return std::nullopt;
+        }
+
+        key.append(reinterpret_cast<const char*>(arrangement),
+                   offsetof(VstSpeakerArrangement, speakers) +
+                       (arrangement->num_speakers * sizeof(VstSpeaker)));
+    }
+
+    return key;
+}
+
+}  // namespace
+
 Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
                                    audioMasterCallback host_callback)
     : PluginBridge(
           PluginType::vst2,
           plugin_path,
-          [](asio::io_context& io_context, const PluginInfo& info) {
+          [](asio::io_context& io_context,
+             const PluginInfo& info,
+             bool abstract_sockets) {
               return Vst2Sockets<std::jthread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path_.filename()
                                              .replace_extension("")
                                              .string()),
-                  true);
-          }),
+                  true, abstract_sockets);
+          },
+          true),
       // All the fields should be zero initialized because
       // `Vst2PluginInstance::vstAudioMasterCallback` from Bitwig's plugin
       // bridge will crash otherwise
       plugin_(),
       host_callback_function_(host_callback),
-      logger_(generic_logger_) {
-    log_init_message();
-
-    // This will block until all sockets have been connected to by the Wine VST
-    // host
-    connect_sockets_guarded();
-
+      logger_(generic_logger_),
+      incoming_midi_events_(config_.vst2_midi_output_queue_size.value_or(8)) {
     // Set up all pointers for our `AEffect` struct. We will fill this with data
-    // from the VST plugin loaded in Wine at the end of this constructor.
+    // from the VST plugin loaded in Wine in `initialize_plugin_host()`, or from
+    // the snapshot stored for the `vst2_scan_cache` option.
     plugin_.ptr3 = this;
     plugin_.dispatcher = dispatch_proxy;
     plugin_.process = process_proxy;
@@ -70,6 +143,44 @@ Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
     plugin_.processReplacing = process_replacing_proxy;
     plugin_.processDoubleReplacing = process_double_replacing_proxy;
 
+    if (config_.vst2_scan_cache) {
+        aeffect_snapshot_cache_.emplace(info_.windows_library_path_,
+                                        "vst2 aeffect", "snapshots");
+        stored_snapshot_ = aeffect_snapshot_cache_->read<AEffectSnapshot>();
+    }
+
+    // When we have a snapshot, the host can read the plugin's metadata without
+    // us having to start Wine. Most plugin scans never get any further than
+    // that.
+    if (stored_snapshot_) {
+        update_aeffect(plugin_, stored_snapshot_->initial);
+        {
+            std::lock_guard lock(dispatch_result_cache_mutex_);
+            dispatch_result_cache_ = stored_snapshot_->results;
+        }
+
+        generic_logger_.log(
+            "Created '" + info_.windows_plugin_path_.string() +
+            "' from its stored snapshot, the Wine plugin host will be started "
+            "once the host needs it");
+    } else {
+        initialize_plugin_host();
+    }
+}
+
+void Vst2PluginBridge::initialize_plugin_host() {
+    std::lock_guard initialization_lock(plugin_host_initialization_mutex_);
+    if (plugin_host_initialized_) {
+        return;
+    }
+
+    launch_plugin_host();
+    log_init_message();
+
+    // This will block until all sockets have been connected to by the Wine VST
+    // host
+    connect_sockets_guarded();
+
     // For our communication we use simple threads and blocking operations
     // instead of asynchronous IO since communication has to be handled in
     // lockstep anyway
@@ -81,6 +192,17 @@ Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
             std::pair<Vst2Logger&, bool>(logger_, false),
             [&](Vst2Event& event, bool /*on_main_thread*/) {
                 switch (event.opcode) {
+                    // When the plugin reports a parameter change we already
+                    // know the new value, so we can answer the host's next
+                    // `getParameter()` call for it from the cache
+                    case audioMasterAutomate: {
+                        cache_automated_parameter(event.index, event.option);
+                    } break;
+                    case audioMasterUpdateDisplay: {
+                        clear_parameter_cache();
+                        clear_program_name_cache();
+                        clear_dispatch_result_cache();
+                    } break;
                     // MIDI events sent from the plugin back to the host are
                     // a special case here. They have to sent during the
                     // `processReplacing()` function or else the host will
@@ -88,11 +210,43 @@ Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
                     // any MIDI events we receive here, and then we'll
                     // actually send them to the host at the end of the
                     // `process_replacing()` function.
+                    // With pipelined processing we add one block of latency on
+                    // top of the plugin's own latency
+                    case audioMasterIOChanged: {
+                        // The plugin's parameters may have changed
+                        clear_parameter_cache();
+                        clear_program_name_cache();
+                        clear_dispatch_result_cache();
+                        clear_speaker_arrangement_cache();
+
+                        if (auto* delta =
+                                std::get_if<AEffectDelta>(&event.payload)) {
+                            if (int32_t* initial_delay =
+                                    delta->initial_delay()) {
+                                *initial_delay +=
+                                    static_cast<int32_t>(pipeline_latency_);
+                            }
+                        }
+                    } break;
                     case audioMasterProcessEvents: {
                         std::lock_guard lock(incoming_midi_events_mutex_);
 
-                        incoming_midi_events_.push_back(
-                            std::get<DynamicVstEvents>(event.payload));
+                        if (DynamicVstEvents* events =
+                                incoming_midi_events_.begin_push()) {
+                            // Copying into an existing object reuses its
+                            // buffers, and building the `VstEvents` struct here
+                            // means that doing so again on the audio thread
+                            // will not need to grow any buffers
+                            *events = std::get<DynamicVstEvents>(event.payload);
+                            events->as_c_events();
+                            incoming_midi_events_.end_push();
+                        } else if (dropped_midi_events_++ == 0) {
+                            logger_.log(
+                                "WARNING: The plugin sent more MIDI events "
+                                "than we can buffer during a single processing "
+                                "cycle, dropping events. Consider increasing "
+                                "'vst2_midi_output_queue_size'.");
+                        }
 
                         return Vst2EventResult{.return_value = 1,
                                                .payload = nullptr,
@@ -179,24 +333,132 @@ Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
     // calls `audioMasterIOChanged()` and after the host calls `effOpen()`.
     const auto initialization_data =
         sockets_.host_vst_control_.receive_single<Vst2EventResult>();
+    plugin_created_at_ = std::chrono::steady_clock::now();
 
     const auto initialized_plugin =
         std::get<AEffect>(initialization_data.payload);
     const auto host_version =
         std::get<std::string>(*initialization_data.value_payload);
     warn_on_version_mismatch(host_version);
+    negotiate_capabilities(Capabilities{
+        .flags = static_cast<uint64_t>(initialization_data.return_value)});
 
     // After receiving the `AEffect` values we'll want to send the configuration
     // back to complete the startup process
     sockets_.host_vst_control_.send(config_);
 
     update_aeffect(plugin_, initialized_plugin);
+    captured_snapshot_.initial = initialized_plugin;
+
+    // The host will already have read the values from the snapshot, so it
+    // needs to know that they have changed
+    if (stored_snapshot_ &&
+        !aeffect_values_equal(stored_snapshot_->initial, initialized_plugin)) {
+        logger_.log(
+            "WARNING: The plugin's stored snapshot is out of date, it will be "
+            "replaced when the plugin gets closed");
+        stored_snapshot_.reset();
+        clear_dispatch_result_cache();
+
+        host_callback_function_(&plugin_, audioMasterIOChanged, 0, 0, nullptr,
+                                0.0);
+    }
+
+    // The names and labels stored for an earlier instance of this plugin can
+    // be used as long as the plugin still reports the same number of
+    // parameters. The unique ID and the version are part of the key.
+    if (config_.parameter_metadata_cache && config_.vst2_parameter_info_cache) {
+        parameter_metadata_cache_.emplace(
+            info_.windows_library_path_,
+            "vst2 " + std::to_string(plugin_.uniqueID) + " " +
+                std::to_string(plugin_.version));
+
+        if (auto stored_infos =
+                parameter_metadata_cache_->read<StoredParameterInfos>();
+            stored_infos && stored_infos->parameters.size() ==
+                                static_cast<size_t>(
+                                    std::max(plugin_.numParams, 0))) {
+            const auto now = std::chrono::steady_clock::now();
+
+            std::lock_guard lock(parameter_info_cache_mutex_);
+            for (size_t i = 0; i < stored_infos->parameters.size(); i++) {
+                StoredParameterInfo& info = stored_infos->parameters[i];
+                parameter_info_cache_[static_cast<int>(i)] =
+                    CachedParameterInfo{.name = std::move(info.name),
+                                        .label = std::move(info.label),
+                                        .display = std::nullopt,
+                                        .fetched_at = now};
+            }
+            parameter_metadata_stored_ = true;
+        }
+    }
+
+    // The queued callbacks are read from the audio thread, so this should not
+    // have to grow later
+    if (config_.vst2_async_automation) {
+        process_response_.host_callbacks.reserve(max_queued_host_callbacks);
+    }
+
+    plugin_host_initialized_ = true;
+
+    // If we answered the host's `effOpen()` call from the snapshot, then the
+    // plugin still needs to receive it before anything else
+    if (open_deferred_) {
+        open_deferred_ = false;
+        dispatch(&plugin_, effOpen, 0, 0, nullptr, 0.0);
+    }
+}
+
+void Vst2PluginBridge::launch_deferred_plugin_host() noexcept {
+    try {
+        initialize_plugin_host();
+    } catch (const std::exception& error) {
+        // There's no way to report this to the host at this point, so this is
+        // handled the same way as a Wine plugin host that fails to start
+        generic_logger_.log("Could not start the Wine plugin host: " +
+                            std::string(error.what()));
+        send_notification("Failed to start the Wine plugin host",
+                          error.what(), info_.native_library_path_);
+
+        Logger::flush();
+        std::terminate();
+    }
+}
+
+void Vst2PluginBridge::store_aeffect_snapshot() {
+    if (!aeffect_snapshot_cache_) {
+        return;
+    }
+
+    AEffectSnapshot snapshot = captured_snapshot_;
+    if (stored_snapshot_) {
+        snapshot.results = stored_snapshot_->results;
+    }
+    {
+        std::lock_guard lock(dispatch_result_cache_mutex_);
+        for (const auto& [opcode, result] : dispatch_result_cache_.strings) {
+            snapshot.results.strings.insert_or_assign(opcode, result);
+        }
+        for (const auto& [opcode, result] : dispatch_result_cache_.values) {
+            snapshot.results.values.insert_or_assign(opcode, result);
+        }
+        for (const auto& [query, result] : dispatch_result_cache_.can_do) {
+            snapshot.results.can_do.insert_or_assign(query, result);
+        }
+    }
+
+    if (!stored_snapshot_ || snapshot.results != stored_snapshot_->results) {
+        aeffect_snapshot_cache_->write(snapshot);
+    }
 }
 
 Vst2PluginBridge::~Vst2PluginBridge() noexcept {
     try {
-        // Drop all work make sure all sockets are closed
-        plugin_host_->terminate();
+        // Drop all work make sure all sockets are closed. With
+        // `vst2_scan_cache` the Wine plugin host may never have been started.
+        if (plugin_host_) {
+            plugin_host_->terminate();
+        }
 
         // The `stop()` method will cause the IO context to just drop all of its
         // outstanding work immediately
@@ -210,12 +472,17 @@ Vst2PluginBridge::~Vst2PluginBridge() noexcept {
 
 class DispatchDataConverter : public DefaultDataConverter {
    public:
-    DispatchDataConverter(std::optional<AudioShmBuffer>& process_buffers,
-                          std::vector<uint8_t>& chunk_data,
-                          AEffect& plugin,
-                          VstRect& editor_rectangle) noexcept
+    DispatchDataConverter(
+        std::optional<AudioShmBuffer>& process_buffers,
+        std::vector<uint8_t>& chunk_data,
+        std::optional<std::pair<int, uint64_t>>& chunk_data_hash,
+        bool cache_chunks,
+        AEffect& plugin,
+        VstRect& editor_rectangle) noexcept
         : process_buffers_(process_buffers),
           chunk_(chunk_data),
+          chunk_hash_(chunk_data_hash),
+          cache_chunks_(cache_chunks),
           plugin_(plugin),
           rect_(editor_rectangle) {}
 
@@ -256,7 +523,15 @@ class DispatchDataConverter : public DefaultDataConverter {
                 return reinterpret_cast<size_t>(data);
                 break;
             case effGetChunk:
-                return WantsChunkBuffer();
+                // With `vst2_chunk_cache` the Wine plugin host only needs to
+                // send the chunk if it's different from the one we have cached
+                requested_chunk_index_ = index;
+                if (cache_chunks_ && chunk_hash_ &&
+                    chunk_hash_->first == index) {
+                    return WantsChunkBuffer{.cached_hash = chunk_hash_->second};
+                } else {
+                    return WantsChunkBuffer{};
+                }
                 break;
             case effSetChunk: {
                 const uint8_t* chunk_data = static_cast<const uint8_t*>(data);
@@ -412,10 +687,17 @@ class DispatchDataConverter : public DefaultDataConverter {
             case effGetChunk: {
                 // Write the chunk data to some publically accessible place in
                 // `Vst2PluginBridge` and write a pointer to that struct to the
-                // data pointer
-                const auto& buffer =
-                    std::get<ChunkData>(response.payload).buffer;
-                chunk_.assign(buffer.begin(), buffer.end());
+                // data pointer. If the chunk has not changed, then we can
+                // reuse the one we already have.
+                if (const auto* chunk =
+                        std::get_if<ChunkData>(&response.payload)) {
+                    chunk_.assign(chunk->buffer.begin(), chunk->buffer.end());
+                    if (cache_chunks_) {
+                        chunk_hash_ =
+                            std::pair(requested_chunk_index_,
+                                      hash_chunk_data(chunk->buffer));
+                    }
+                }
 
                 *static_cast<uint8_t**>(data) = chunk_.data();
             } break;
@@ -448,19 +730,8 @@ class DispatchDataConverter : public DefaultDataConverter {
                 // with its preferred output speaker configuration if it
                 // supports this. The same thing happens for the input speaker
                 // configuration in `write_value()`.
-                auto speaker_arrangement =
-                    std::get<DynamicSpeakerArrangement>(response.payload);
-
-                // Reconstruct a dynamically sized `VstSpeakerArrangement`
-                // object to a buffer, and write back the results to the data
-                // parameter.
-                VstSpeakerArrangement* output =
-                    static_cast<VstSpeakerArrangement*>(data);
-                std::vector<uint8_t> reconstructed_object =
-                    speaker_arrangement.as_raw_data();
-                std::copy(reconstructed_object.begin(),
-                          reconstructed_object.end(),
-                          reinterpret_cast<uint8_t*>(output));
+                std::get<DynamicSpeakerArrangement>(response.payload)
+                    .write_to(*static_cast<VstSpeakerArrangement*>(data));
             } break;
             default:
                 DefaultDataConverter::write_data(opcode, data, response);
@@ -480,17 +751,8 @@ class DispatchDataConverter : public DefaultDataConverter {
             case effGetSpeakerArrangement: {
                 // Same as the above, but now for the input speaker
                 // configuration object under the `value` pointer
-                auto speaker_arrangement =
-                    std::get<DynamicSpeakerArrangement>(response.payload);
-
-                VstSpeakerArrangement* output =
-                    static_cast<VstSpeakerArrangement*>(
-                        reinterpret_cast<void*>(value));
-                std::vector<uint8_t> reconstructed_object =
-                    speaker_arrangement.as_raw_data();
-                std::copy(reconstructed_object.begin(),
-                          reconstructed_object.end(),
-                          reinterpret_cast<uint8_t*>(output));
+                std::get<DynamicSpeakerArrangement>(response.payload)
+                    .write_to(*reinterpret_cast<VstSpeakerArrangement*>(value));
             } break;
             default:
                 return DefaultDataConverter::write_value(opcode, value,
@@ -502,10 +764,78 @@ class DispatchDataConverter : public DefaultDataConverter {
    private:
     std::optional<AudioShmBuffer>& process_buffers_;
     std::vector<uint8_t>& chunk_;
+    std::optional<std::pair<int, uint64_t>>& chunk_hash_;
+    bool cache_chunks_;
+    /**
+     * The `index` argument passed to `effGetChunk()`, since `write_data()`
+     * doesn't receive it. Only used with `cache_chunks_`.
+     */
+    mutable int requested_chunk_index_ = 0;
     AEffect& plugin_;
     VstRect& rect_;
 };
 
+/**
+ * Used to fetch the names, labels, and display strings for a range of
+ * parameters at once for the `vst2_parameter_info_cache` option. The results
+ * are written to the object passed to the constructor.
+ */
+class ParameterDescriptionsConverter : public DefaultDataConverter {
+   public:
+    explicit ParameterDescriptionsConverter(
+        Vst2ParameterDescriptions& descriptions) noexcept
+        : descriptions_(descriptions) {}
+
+    Vst2Event::Payload read_data(const int /*opcode*/,
+                                 const int /*index*/,
+                                 const intptr_t /*value*/,
+                                 const void* /*data*/) const override {
+        return WantsParameterDescriptions{};
+    }
+
+    void write_data(const int /*opcode*/,
+                    void* /*data*/,
+                    const Vst2EventResult& response) const override {
+        if (const auto* descriptions =
+                std::get_if<Vst2ParameterDescriptions>(&response.payload)) {
+            descriptions_ = *descriptions;
+        }
+    }
+
+   private:
+    Vst2ParameterDescriptions& descriptions_;
+};
+
+/**
+ * Used to fetch the names of a range of programs at once for the
+ * `vst2_program_name_cache` option. The results are written to the object
+ * passed to the constructor.
+ */
+class ProgramNamesConverter : public DefaultDataConverter {
+   public:
+    explicit ProgramNamesConverter(Vst2ProgramNames& program_names) noexcept
+        : program_names_(program_names) {}
+
+    Vst2Event::Payload read_data(const int /*opcode*/,
+                                 const int /*index*/,
+                                 const intptr_t /*value*/,
+                                 const void* /*data*/) const override {
+        return WantsProgramNames{};
+    }
+
+    void write_data(const int /*opcode*/,
+                    void* /*data*/,
+                    const Vst2EventResult& response) const override {
+        if (const auto* program_names =
+                std::get_if<Vst2ProgramNames>(&response.payload)) {
+            program_names_ = *program_names;
+        }
+    }
+
+   private:
+    Vst2ProgramNames& program_names_;
+};
+
 intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
                                     int opcode,
                                     int index,
@@ -529,8 +859,64 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
         return 0;
     }
 
-    DispatchDataConverter converter(process_buffers_, chunk_data_, plugin_,
-                                    editor_rectangle_);
+    // When this instance was created from a stored snapshot, we'll only start
+    // the Wine plugin host once the host asks for something the snapshot
+    // can't answer
+    if (!plugin_host_initialized_) [[unlikely]] {
+        switch (opcode) {
+            case effOpen: {
+                logger_.log_event(true, opcode, index, value, nullptr, option,
+                                  std::nullopt);
+
+                if (stored_snapshot_->opened) {
+                    update_aeffect(plugin_, *stored_snapshot_->opened);
+                }
+                open_deferred_ = true;
+
+                logger_.log_event_response(true, opcode, 0, nullptr,
+                                           std::nullopt, true);
+                return 0;
+            } break;
+            case effClose: {
+                logger_.log_event(true, opcode, index, value, nullptr, option,
+                                  std::nullopt);
+                logger_.log_event_response(true, opcode, 0, nullptr,
+                                           std::nullopt, true);
+
+                delete this;
+
+                return 0;
+            } break;
+        }
+
+        if (const std::optional<intptr_t> cached_result =
+                get_cached_dispatch_result(opcode, index, value, data,
+                                           option)) {
+            return *cached_result;
+        }
+
+        launch_deferred_plugin_host();
+    }
+
+    DispatchDataConverter converter(process_buffers_, chunk_data_,
+                                    chunk_data_hash_, config_.vst2_chunk_cache,
+                                    plugin_, editor_rectangle_);
+
+    // With pipelined processing the Wine plugin host may still be processing
+    // the last block of audio after `processReplacing()` has returned. Any
+    // event that changes the audio buffers or the processing setup has to
+    // wait for that to finish first.
+    if (config_.vst2_pipelined_processing) {
+        switch (opcode) {
+            case effClose:
+            case effMainsChanged:
+            case effSetBlockSize:
+            case effSetSampleRate:
+            case effSetProcessPrecision:
+                drain_pipeline();
+                break;
+        }
+    }
 
     switch (opcode) {
         case effClose: {
@@ -550,6 +936,8 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
                 logger_.log("The plugin crashed during shutdown, ignoring");
             }
 
+            store_aeffect_snapshot();
+
             delete this;
 
             return return_value;
@@ -585,6 +973,165 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
             logger_.log_event_response(true, opcode, 0, nullptr, std::nullopt);
             return 0;
         }; break;
+        case effGetParamName:
+        case effGetParamLabel:
+        case effGetParamDisplay: {
+            if (!config_.vst2_parameter_info_cache || !data) {
+                break;
+            }
+
+            if (const std::optional<std::string> info =
+                    get_parameter_info(opcode, index)) {
+                logger_.log_event(true, opcode, index, value, WantsString{},
+                                  option, std::nullopt);
+
+                char* output = static_cast<char*>(data);
+                std::copy(info->begin(), info->end(), output);
+                output[info->size()] = 0;
+
+                logger_.log_event_response(true, opcode, 0, *info,
+                                           std::nullopt, true);
+                return 0;
+            }
+        } break;
+        case effGetProgramName:
+        case effGetProgramNameIndexed: {
+            if (!config_.vst2_program_name_cache || !data) {
+                break;
+            }
+
+            // Hosts that don't support `effGetProgramNameIndexed()` select
+            // every program and then ask for the current program's name
+            std::optional<int> program = index;
+            if (opcode == effGetProgramName) {
+                std::lock_guard lock(program_name_cache_mutex_);
+                program = current_program_;
+            }
+            if (!program) {
+                break;
+            }
+
+            if (const std::optional<std::string> name =
+                    get_program_name(*program)) {
+                logger_.log_event(true, opcode, index, value, WantsString{},
+                                  option, std::nullopt);
+
+                char* output = static_cast<char*>(data);
+                std::copy(name->begin(), name->end(), output);
+                output[name->size()] = 0;
+
+                // `effGetProgramNameIndexed()` returns 1 to indicate that the
+                // plugin supports it
+                const intptr_t return_value =
+                    opcode == effGetProgramNameIndexed ? 1 : 0;
+                logger_.log_event_response(true, opcode, return_value, *name,
+                                           std::nullopt, true);
+                return return_value;
+            }
+        } break;
+        case effSetProgramName: {
+            std::lock_guard lock(program_name_cache_mutex_);
+            if (current_program_) {
+                program_name_cache_.erase(*current_program_);
+            } else {
+                program_name_cache_.clear();
+            }
+        } break;
+        // Loading a program or a chunk can change any of the plugin's
+        // parameters
+        case effSetProgram:
+        case effSetChunk:
+        case effBeginLoadBank:
+        case effBeginLoadProgram: {
+            clear_parameter_cache();
+
+            // Selecting a program doesn't change the names of any programs,
+            // but loading a chunk can
+            if (opcode == effSetProgram) {
+                std::lock_guard lock(program_name_cache_mutex_);
+                current_program_ = static_cast<int>(value);
+            } else {
+                clear_program_name_cache();
+            }
+        } break;
+        case effSetSpeakerArrangement:
+        case effGetSpeakerArrangement: {
+            if (!config_.speaker_arrangement_cache || !data || !value) {
+                break;
+            }
+
+            if (const std::optional<intptr_t> cached_result =
+                    get_cached_speaker_arrangement_result(opcode, index, value,
+                                                          data, option)) {
+                return *cached_result;
+            }
+        } break;
+        case effSetProcessPrecision: {
+            // We'll pass this through to the plugin as usual, but we also need
+            // to know this for `yabridgeVendorSpecificAudioBuffers`
+            double_precision_ = value == kVstProcessPrecision64;
+        } break;
+        case effVendorSpecific: {
+            // This is our own extension that lets the host process audio
+            // directly in our shared memory audio buffers. See the docstring on
+            // `yabridgeVendorSpecificAudioBuffers` for more information.
+            if (index == yabridgeVendorSpecificAudioBuffers) {
+                logger_.log_event(true, opcode, index, value, nullptr, option,
+                                  std::nullopt);
+
+                // This can't be used together with pipelined processing since
+                // the plugin would still be writing to these buffers while the
+                // host is reading from them
+                intptr_t return_value = 0;
+                if (process_buffers_ && data &&
+                    !config_.vst2_pipelined_processing &&
+                    (value == kYabridgeInputBuffers ||
+                     value == kYabridgeOutputBuffers)) {
+                    void** channel_pointers = static_cast<void**>(data);
+                    const bool inputs = value == kYabridgeInputBuffers;
+                    const int num_channels =
+                        inputs ? plugin_.numInputs : plugin_.numOutputs;
+                    for (int channel = 0; channel < num_channels; channel++) {
+                        if (double_precision_) {
+                            channel_pointers[channel] =
+                                inputs ? process_buffers_->input_channel_ptr<
+                                             double>(0, channel)
+                                       : process_buffers_->output_channel_ptr<
+                                             double>(0, channel);
+                        } else {
+                            channel_pointers[channel] =
+                                inputs ? process_buffers_->input_channel_ptr<
+                                             float>(0, channel)
+                                       : process_buffers_->output_channel_ptr<
+                                             float>(0, channel);
+                        }
+                    }
+
+                    return_value = 1;
+                }
+
+                logger_.log_event_response(true, opcode, return_value,
+                                           nullptr, std::nullopt);
+                return return_value;
+            }
+
+            // See the docstring on `yabridgeVendorSpecificProcessBatch`
+            if (index == yabridgeVendorSpecificProcessBatch) {
+                logger_.log_event(true, opcode, index, value, nullptr, option,
+                                  std::nullopt);
+
+                intptr_t return_value = 0;
+                if (data && value > 0) {
+                    return_value = process_batch(
+                        static_cast<const YabridgeProcessBatchEntry*>(data),
+                        static_cast<size_t>(value));
+                }
+
+                logger_.log_event_response(true, opcode, return_value,
+                                           nullptr, std::nullopt);
+                return return_value;
+            }
+        } break;
         case effCanDo: {
             const std::string query(static_cast<const char*>(data));
 
@@ -605,6 +1152,10 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
                 logger_.log("   when using REAPER.");
                 logger_.log("");
 
+                // This way the query also ends up in the `vst2_scan_cache`
+                // snapshot, so REAPER's plugin scans don't need Wine for it
+                cache_dispatch_result(opcode, data, -1);
+
                 logger_.log_event_response(true, opcode, -1, nullptr,
                                            std::nullopt);
                 return -1;
@@ -612,19 +1163,229 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
         } break;
     }
 
+    // Some opcodes return the same values for the entire lifetime of the
+    // plugin, so we don't need to ask the Wine plugin host more than once
+    if (const std::optional<intptr_t> cached_result =
+            get_cached_dispatch_result(opcode, index, value, data, option)) {
+        return *cached_result;
+    }
+
+    // With `vst2_batch_midi_events` we'll send these events together with the
+    // next processing request. Like most plugins we'll just report that the
+    // events have been processed. Any other event that reaches the Wine plugin
+    // host will first send the events we're still holding on to, so the
+    // plugin won't receive events out of order. `effEditIdle()` and the
+    // opcodes we can answer ourselves have already returned above, so they
+    // don't cause a flush.
+    if (config_.vst2_batch_midi_events) {
+        if (opcode == effProcessEvents && data &&
+            maybe_batch_midi_events(*static_cast<const VstEvents*>(data))) {
+            return 1;
+        }
+
+        flush_pending_midi_events();
+    }
+
     // We don't reuse any buffers here like we do for audio processing. This
     // would be useful for chunk data, but since that's only needed when saving
     // and loading plugin state it's much better to have bitsery or our
     // receiving function temporarily allocate a large enough buffer rather than
     // to have a bunch of allocated memory sitting around doing nothing.
-    return sockets_.host_vst_dispatch_.send_event(
+    const std::optional<std::chrono::steady_clock::time_point> open_start =
+        opcode == effOpen && !startup_timings_logged_
+            ? std::optional(std::chrono::steady_clock::now())
+            : std::nullopt;
+    const intptr_t return_value = sockets_.host_vst_dispatch_.send_event(
         converter, std::pair<Vst2Logger&, bool>(logger_, true), opcode, index,
         value, data, option);
+
+    cache_dispatch_result(opcode, data, return_value);
+    if (config_.speaker_arrangement_cache) {
+        cache_speaker_arrangement_result(opcode, value, data, return_value);
+    }
+    if (opcode == effOpen) {
+        captured_snapshot_.opened = plugin_;
+    }
+
+    if (open_start) {
+        startup_timings_logged_ = true;
+        log_startup_timings(
+            "VSTPluginMain() " +
+            format_duration_ms(plugin_created_at_ - sockets_connected_at_) +
+            ", effOpen() " +
+            format_duration_ms(std::chrono::steady_clock::now() - *open_start));
+    }
+
+    if (opcode == effSetSampleRate) {
+        sample_rate_ = option;
+    }
+    if (opcode == effSetBlockSize) {
+        max_block_size_ = static_cast<int>(value);
+    }
+
+    if (config_.vst2_pipelined_processing) {
+        switch (opcode) {
+            case effOpen:
+                // The plugin's `AEffect` will have been updated from the Wine
+                // side
+                plugin_.initialDelay += static_cast<int>(pipeline_latency_);
+                break;
+            case effSetBlockSize:
+                pipeline_block_size_ = static_cast<int>(value);
+                break;
+            case effMainsChanged:
+                if (value) {
+                    setup_pipeline();
+                }
+                break;
+        }
+    }
+
+    if (opcode == effMainsChanged && !value) {
+        std::lock_guard lock(incoming_midi_events_mutex_);
+        if (dropped_midi_events_ > 0) {
+            logger_.log("WARNING: Dropped " +
+                        std::to_string(dropped_midi_events_) +
+                        " batches of MIDI events sent by the plugin");
+            dropped_midi_events_ = 0;
+        }
+    }
+
+    // Printing these statistics when the plugin gets suspended makes it
+    // possible to tell whether the spin budget is large enough without having
+    // to log anything from the audio thread
+    if (opcode == effMainsChanged && !value && config_.audio_wait_spin_us &&
+        logger_.logger_.verbosity_ >= Logger::Verbosity::most_events) {
+        const uint64_t hits = spin_wait_hits_.exchange(0);
+        const uint64_t misses = spin_wait_misses_.exchange(0);
+        if (hits + misses > 0) {
+            logger_.log("Audio processing spin waits: " +
+                        std::to_string(hits) + " hits, " +
+                        std::to_string(misses) + " misses with a " +
+                        std::to_string(*config_.audio_wait_spin_us) +
+                        " us budget");
+        }
+    }
+
+    return return_value;
 }
 
 template <typename T, bool replacing>
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
 void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
+    // The host should have called `effMainsChanged()` before sending audio to
+    // process
+    assert(process_buffers_);
+
+    const TraceScope trace_scope("process", "audio");
+    YABRIDGE_PROBE(process_begin, sample_frames);
+    const auto process_start = std::chrono::steady_clock::now();
+
+    // With pipelined processing we'll first wait for the previous block to
+    // finish processing, and we'll then move its outputs into our delay lines.
+    // Blocks larger than the block size the host announced can't be pipelined
+    // since that would exceed our added latency, so those are processed
+    // synchronously instead.
+    std::unique_lock pipeline_lock(pipeline_mutex_, std::defer_lock);
+    bool pipelined = false;
+    if (config_.vst2_pipelined_processing) {
+        const ScopedRealtimeSection realtime_section{};
+
+        pipeline_lock.lock();
+        if (pipeline_pending_) {
+            wait_for_process_response(pipeline_last_sequence_);
+            receive_queued_host_callbacks();
+            pipeline_pending_ = false;
+
+            auto& delay_lines = pipeline_outputs<T>();
+            const size_t frames =
+                static_cast<size_t>(pipeline_pending_frames_);
+            const size_t first_frames =
+                std::min(frames, pipeline_latency_ - pipeline_write_pos_);
+            for (int channel = 0; channel < plugin_.numOutputs; channel++) {
+                const T* output_channel =
+                    process_buffers_->output_channel_ptr<T>(0, channel);
+                T* delay_line = delay_lines[channel].data();
+
+                audio_kernels::copy(output_channel,
+                                    delay_line + pipeline_write_pos_,
+                                    first_frames);
+                audio_kernels::copy(output_channel + first_frames, delay_line,
+                                    frames - first_frames);
+            }
+            pipeline_write_pos_ =
+                (pipeline_write_pos_ + frames) % pipeline_latency_;
+        }
+
+        pipelined = sample_frames > 0 &&
+                    static_cast<size_t>(sample_frames) <= pipeline_latency_;
+    }
+
+    const uint32_t last_response_sequence =
+        start_process(inputs, sample_frames);
+
+    if (pipelined) {
+        const ScopedRealtimeSection realtime_section{};
+
+        // Instead of waiting for the Wine plugin host to finish processing this
+        // block, we'll return the output from exactly `pipeline_latency_`
+        // samples ago from our delay lines. This block's output will be moved
+        // to the delay lines during the next processing cycle, overwriting the
+        // samples we're reading here.
+        pipeline_pending_ = true;
+        pipeline_last_sequence_ = last_response_sequence;
+        pipeline_pending_frames_ = sample_frames;
+
+        auto& delay_lines = pipeline_outputs<T>();
+        const size_t frames = static_cast<size_t>(sample_frames);
+        const size_t first_frames =
+            std::min(frames, pipeline_latency_ - pipeline_write_pos_);
+        for (int channel = 0; channel < plugin_.numOutputs; channel++) {
+            const T* delay_line = delay_lines[channel].data();
+            if constexpr (replacing) {
+                audio_kernels::copy(delay_line + pipeline_write_pos_,
+                                    outputs[channel], first_frames);
+                audio_kernels::copy(delay_line, outputs[channel] + first_frames,
+                                    frames - first_frames);
+            } else {
+                audio_kernels::accumulate(delay_line + pipeline_write_pos_,
+                                          outputs[channel], first_frames);
+                audio_kernels::accumulate(delay_line,
+                                          outputs[channel] + first_frames,
+                                          frames - first_frames);
+            }
+        }
+    } else {
+        finish_process<T, replacing>(outputs, sample_frames,
+                                     last_response_sequence);
+    }
+
+    // Together with the time spent in the plugin recorded by the Wine plugin
+    // host, this tells us how much overhead yabridge adds
+    const auto process_end = std::chrono::steady_clock::now();
+    process_buffers_->record_total_time(process_end - process_start);
+    YABRIDGE_PROBE(process_end, sample_frames);
+
+    // Pipelined blocks don't wait for the Wine plugin host, so there's nothing
+    // to break down there
+    if (config_.audio_deadline_warning && !pipelined) {
+        deadline_monitor_.check(
+            logger_.logger_, *config_.audio_deadline_warning, sample_rate_,
+            sample_frames, *process_buffers_,
+            ProcessDeadlineMonitor::BlockTimes{
+                .start = process_start,
+                .sent = process_request_sent_,
+                .response_received = process_response_received_,
+                .end = process_end});
+    }
+
+    send_incoming_midi_events();
+    send_queued_host_callbacks();
+}
+
+template <typename T>
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+uint32_t Vst2PluginBridge::start_process(T** inputs, int sample_frames) {
     // During audio processing we'll write the inputs to shared memory buffers,
     // and we'll then send this request alongside it with additional information
     // needed to process audio
@@ -640,11 +1401,8 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
         reinterpret_cast<const VstTimeInfo*>(
             host_callback_function_(&plugin_, audioMasterGetTime, 0,
                                     ~static_cast<intptr_t>(0), nullptr, 0.0));
-    if (returned_time_info) {
-        request.current_time_info = *returned_time_info;
-    } else {
-        request.current_time_info.reset();
-    }
+    time_info_encoder_.encode(returned_time_info, sample_frames,
+                              request.current_time_info);
 
     // Some plugisn also ask for the current process level, so we'll prefetch
     // that information as well
@@ -652,15 +1410,25 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
         &plugin_, audioMasterGetCurrentProcessLevel, 0, 0, nullptr, 0.0));
 
     // We'll synchronize the scheduling priority of the audio thread on the Wine
-    // plugin host with that of the host's audio thread every once in a while
-    const time_t now = time(nullptr);
-    if (now > last_audio_thread_priority_synchronization_ +
-                  audio_thread_priority_synchronization_interval) {
-        request.new_realtime_priority = get_realtime_priority();
-        last_audio_thread_priority_synchronization_ = now;
-    } else {
-        request.new_realtime_priority.reset();
-    }
+    // plugin host with that of the host's audio thread whenever it changes
+    request.new_realtime_priority = take_if_changed(
+        get_realtime_priority(), last_synchronized_realtime_priority_);
+    request.host_audio_thread_cpu =
+        config_.follows_host_audio_thread_cpu()
+            ? take_if_changed(get_current_cpu(),
+                              last_synchronized_host_audio_thread_cpu_)
+            : std::nullopt;
+    request.host_audio_thread_numa_node =
+        config_.audio_thread_follow_host_numa_node
+            ? take_if_changed(get_current_numa_node(),
+                              last_synchronized_host_audio_thread_numa_node_)
+            : std::nullopt;
+
+    // With this option every host audio thread gets its own core on the Wine
+    // side, so the Wine plugin host needs to know which thread is calling us
+    request.host_thread_id = config_.audio_thread_host_mapping
+                                 ? std::optional(get_current_thread_id())
+                                 : std::nullopt;
 
     // We reuse this audio buffers object both for the request and the response
     // to avoid unnecessary allocations. The inputs and outputs arrays should be
@@ -681,60 +1449,810 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
         static_assert(std::is_same_v<T, float>);
     }
 
-    // The host should have called `effMainsChanged()` before sending audio to
-    // process
-    assert(process_buffers_);
+    // Everything from here on out shouldn't allocate. The host callbacks above
+    // are excluded since we have no control over what the host does there.
+    const ScopedRealtimeSection realtime_section{};
+
+    // With the `vst2_detect_silence` option enabled we'll keep track of which
+    // input channels in the shared memory object only contain zeroes, so we
+    // don't have to copy silent inputs every processing cycle. This is
+    // invalidated when the buffers get resized, or when the block size grows.
+    const bool detect_silence = config_.vst2_detect_silence;
+    if (detect_silence) {
+        constexpr bool is_double = std::is_same_v<T, double>;
+        if (process_buffers_->generation() != zeroed_input_generation_ ||
+            sample_frames > zeroed_input_num_samples_ ||
+            is_double != zeroed_input_double_precision_ ||
+            zeroed_input_channels_.size() !=
+                static_cast<size_t>(plugin_.numInputs)) {
+            zeroed_input_channels_.assign(plugin_.numInputs, false);
+            zeroed_input_num_samples_ = sample_frames;
+            zeroed_input_generation_ = process_buffers_->generation();
+            zeroed_input_double_precision_ = is_double;
+        }
+    }
+
     for (int channel = 0; channel < plugin_.numInputs; channel++) {
+        // If the host obtained these pointers through our
+        // `yabridgeVendorSpecificAudioBuffers` extension then it will have
+        // already written its input audio to the shared memory buffers
         T* input_channel = process_buffers_->input_channel_ptr<T>(0, channel);
-        std::copy_n(inputs[channel], sample_frames, input_channel);
+        if (inputs[channel] == input_channel) {
+            if (detect_silence) {
+                zeroed_input_channels_[channel] = false;
+            }
+        } else if (detect_silence &&
+                   audio_kernels::is_silent(inputs[channel], sample_frames)) {
+            if (!zeroed_input_channels_[channel]) {
+                audio_kernels::clear(input_channel, zeroed_input_num_samples_);
+                zeroed_input_channels_[channel] = true;
+            }
+        } else {
+            audio_kernels::copy(inputs[channel], input_channel, sample_frames);
+            if (detect_silence) {
+                zeroed_input_channels_[channel] = false;
+            }
+        }
     }
 
-    // After writing audio to the shared memory buffers, we'll send the
-    // processing request parameters to the Wine plugin host so it can start
-    // processing audio. This is why we don't need any explicit synchronisation.
-    sockets_.host_vst_process_replacing_.send(request);
+    // The processing request parameters are also written to the shared memory
+    // object. The buffer's metadata regions are sized so this always fits,
+    // including any MIDI events that are sent along with the request.
+    if (config_.vst2_batch_midi_events) {
+        std::lock_guard lock(batched_process_request_mutex_);
 
-    // From the Wine side we'll send a zero byte struct back as an
-    // acknowledgement that audio processing has finished. At this point the
-    // audio will have been written to our buffers.
-    sockets_.host_vst_process_replacing_.receive_single<Ack>();
+        batched_process_request_.request = request;
+        [[maybe_unused]] const bool request_written =
+            write_shm_object(*process_buffers_,
+                             AudioShmBuffer::MetadataRegion::request,
+                             batched_process_request_);
+        assert(request_written);
+
+        batched_process_request_.midi_events.events_.clear();
+    } else {
+        [[maybe_unused]] const bool request_written = write_shm_object(
+            *process_buffers_, AudioShmBuffer::MetadataRegion::request,
+            request);
+        assert(request_written);
+    }
+
+    // After writing everything to the shared memory buffers, we'll wake up the
+    // Wine plugin host's audio thread so it can start processing audio. This is
+    // why we don't need any explicit synchronisation. When using futex
+    // signalling this sequence number needs to be read before sending the
+    // request, since otherwise we could miss the wakeup.
+    const uint32_t last_response_sequence =
+        process_buffers_->response_sequence();
+    sockets_.host_vst_process_replacing_.send(Vst2ProcessWakeUp{});
+    if (config_.audio_deadline_warning) {
+        process_request_sent_ = std::chrono::steady_clock::now();
+    }
+
+    return last_response_sequence;
+}
+
+template <typename T, bool replacing>
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+void Vst2PluginBridge::finish_process(T** outputs,
+                                      int sample_frames,
+                                      uint32_t last_sequence) {
+    const ScopedRealtimeSection realtime_section{};
+
+    wait_for_process_response(last_sequence);
+    if (config_.audio_deadline_warning) {
+        process_response_received_ = std::chrono::steady_clock::now();
+    }
+    receive_queued_host_callbacks();
 
     for (int channel = 0; channel < plugin_.numOutputs; channel++) {
         const T* output_channel =
             process_buffers_->output_channel_ptr<T>(0, channel);
 
         if constexpr (replacing) {
-            std::copy_n(output_channel, sample_frames, outputs[channel]);
+            // The same zero-copy check as for the inputs above
+            if (outputs[channel] != output_channel) {
+                audio_kernels::copy(output_channel, outputs[channel],
+                                    sample_frames);
+            }
         } else {
-            // The old `process()` function expects the plugin to add its output
-            // to the accumulated values in `outputs`. Since no host is ever
-            // going to call this anyways we won't even bother with a separate
-            // implementation and we'll just add `processReplacing()` results to
-            // `outputs`.
-            // We could use `std::execution::unseq` here but that would require
-            // linking to TBB and since this probably won't ever be used anyways
-            // that's a bit of a waste.
-            std::transform(output_channel, output_channel + sample_frames,
-                           outputs[channel], outputs[channel],
-                           [](const T& new_value, T& current_value) -> T {
-                               return new_value + current_value;
-                           });
+            // The old `process()` function expects the plugin to add its
+            // output to the accumulated values in `outputs`. Since no host
+            // is ever going to call this anyways we won't even bother with
+            // a separate implementation and we'll just add
+            // `processReplacing()` results to `outputs`.
+            audio_kernels::accumulate(output_channel, outputs[channel],
+                                      sample_frames);
         }
     }
+}
 
+void Vst2PluginBridge::send_incoming_midi_events() {
     // Plugins are allowed to send MIDI events during processing using a host
     // callback. These have to be processed during the actual
     // `processReplacing()` function or else the host will ignore them. To
     // prevent these events from getting delayed by a sample we'll process them
     // after the plugin is done processing audio rather than during the time
     // we're still waiting on the plugin.
-    std::lock_guard lock(incoming_midi_events_mutex_);
-    for (DynamicVstEvents& events : incoming_midi_events_) {
+    while (DynamicVstEvents* events = incoming_midi_events_.front()) {
         host_callback_function_(&plugin_, audioMasterProcessEvents, 0, 0,
-                                &events.as_c_events(), 0.0);
+                                &events->as_c_events(), 0.0);
+        incoming_midi_events_.pop();
+    }
+}
+
+bool Vst2PluginBridge::maybe_batch_midi_events(const VstEvents& events) {
+    if (!process_buffers_) {
+        return false;
+    }
+
+    std::lock_guard lock(batched_process_request_mutex_);
+
+    // While another thread is sending the previously held back events we
+    // can't add new ones, since those could then reach the plugin first
+    if (midi_events_flushing_) {
+        return false;
+    }
+
+    DynamicVstEvents& pending_events = batched_process_request_.midi_events;
+    if (pending_events.events_.size() +
+            static_cast<size_t>(std::max(events.numEvents, 0)) >
+        max_batched_midi_events) {
+        return false;
+    }
+    for (int i = 0; i < events.numEvents; i++) {
+        if (events.events[i]->type == kVstSysExType) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < events.numEvents; i++) {
+        pending_events.events_.push_back(*events.events[i]);
+    }
+
+    return true;
+}
+
+void Vst2PluginBridge::flush_pending_midi_events() {
+    // The events are moved out of the shared request so the lock isn't held
+    // while waiting for the Wine plugin host. Otherwise the audio thread would
+    // be blocked on this round trip in `start_process()`, and a host callback
+    // that causes the host to call `dispatch()` again would deadlock.
+    DynamicVstEvents events;
+    {
+        std::lock_guard lock(batched_process_request_mutex_);
+
+        DynamicVstEvents& pending_events =
+            batched_process_request_.midi_events;
+        if (midi_events_flushing_ || pending_events.events_.empty()) {
+            return;
+        }
+
+        events.events_.swap(pending_events.events_);
+        midi_events_flushing_ = true;
+    }
+
+    DispatchDataConverter converter(process_buffers_, chunk_data_,
+                                    chunk_data_hash_, config_.vst2_chunk_cache,
+                                    plugin_, editor_rectangle_);
+    try {
+        sockets_.host_vst_dispatch_.send_event(
+            converter, std::pair<Vst2Logger&, bool>(logger_, true),
+            effProcessEvents, 0, 0, &events.as_c_events(), 0.0);
+    } catch (...) {
+        std::lock_guard lock(batched_process_request_mutex_);
+        midi_events_flushing_ = false;
+        throw;
+    }
+
+    // The pending events vector gets its capacity back, so batching more
+    // events than fit in its inline storage doesn't allocate on the audio
+    // thread after this
+    std::lock_guard lock(batched_process_request_mutex_);
+    events.events_.clear();
+    if (batched_process_request_.midi_events.events_.empty()) {
+        events.events_.swap(batched_process_request_.midi_events.events_);
+    }
+    midi_events_flushing_ = false;
+}
+
+intptr_t Vst2PluginBridge::process_batch(
+    const YabridgeProcessBatchEntry* entries,
+    size_t num_entries) {
+    // We'll only process the batch if we can process every entry, so the host
+    // can simply fall back to processing every instance separately
+    if (process_batch_has_duplicates(entries, num_entries)) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < num_entries; i++) {
+        const AEffect* effect = entries[i].effect;
+        if (!effect || effect->dispatcher != dispatch_proxy) {
+            return 0;
+        }
+
+        // The shared audio buffers are sized for the block size and the
+        // precision the host set before resuming the plugin, so anything
+        // else would not fit
+        const Vst2PluginBridge& bridge = get_bridge_instance(*effect);
+        if (!bridge.process_buffers_ ||
+            bridge.config_.vst2_pipelined_processing ||
+            entries[i].sample_frames < 0 ||
+            entries[i].sample_frames > bridge.max_block_size_ ||
+            (entries[i].double_precision != 0) != bridge.double_precision_) {
+            return 0;
+        }
+    }
+
+    // All instances get their processing requests first, and we'll only start
+    // waiting for the results once every Wine plugin host is busy
+    const auto process_start = std::chrono::steady_clock::now();
+    llvm::SmallVector<uint32_t, 16> last_sequences(num_entries);
+    for (size_t i = 0; i < num_entries; i++) {
+        const YabridgeProcessBatchEntry& entry = entries[i];
+        Vst2PluginBridge& bridge = get_bridge_instance(*entry.effect);
+        if (entry.double_precision) {
+            last_sequences[i] = bridge.start_process(
+                reinterpret_cast<double**>(entry.inputs), entry.sample_frames);
+        } else {
+            last_sequences[i] = bridge.start_process(
+                reinterpret_cast<float**>(entry.inputs), entry.sample_frames);
+        }
+    }
+
+    for (size_t i = 0; i < num_entries; i++) {
+        const YabridgeProcessBatchEntry& entry = entries[i];
+        Vst2PluginBridge& bridge = get_bridge_instance(*entry.effect);
+        if (entry.double_precision) {
+            bridge.finish_process<double, true>(
+                reinterpret_cast<double**>(entry.outputs), entry.sample_frames,
+                last_sequences[i]);
+        } else {
+            bridge.finish_process<float, true>(
+                reinterpret_cast<float**>(entry.outputs), entry.sample_frames,
+                last_sequences[i]);
+        }
+
+        bridge.process_buffers_->record_total_time(
+            std::chrono::steady_clock::now() - process_start);
+        bridge.send_incoming_midi_events();
+        bridge.send_queued_host_callbacks();
+    }
+
+    return 1;
+}
+
+void Vst2PluginBridge::wait_for_process_response(uint32_t last_sequence) {
+    // From the Wine side we'll send a zero byte struct back as an
+    // acknowledgement that audio processing has finished. At this point the
+    // audio will have been written to our buffers. With the `futex_signalling`
+    // option enabled the Wine plugin host will instead increment a counter in
+    // the shared memory object and wake us up using a futex. Since there's no
+    // socket that can be closed in that case, we'll periodically check whether
+    // the Wine plugin host is still alive while waiting.
+    if (process_buffers_->signalling_enabled()) {
+        // With the `audio_wait_spin_us` option enabled we'll first busy-wait
+        // for a bit before going to sleep
+        if (config_.audio_wait_spin_us) {
+            if (process_buffers_->spin_for_response(
+                    last_sequence,
+                    std::chrono::microseconds(*config_.audio_wait_spin_us))) {
+                spin_wait_hits_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            spin_wait_misses_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        while (!process_buffers_->wait_for_response(
+            last_sequence, std::chrono::milliseconds(1000))) {
+            if (!plugin_host_->running()) {
+                // We're called from a realtime section, and creating the
+                // exception allocates
+                const ScopedRealtimeSectionExit realtime_section_exit{};
+                throw std::runtime_error(
+                    "The Wine plugin host exited while processing audio");
+            }
+        }
+    } else {
+        // Reading from a closed socket would throw a `std::system_error`
+        // somewhere deep inside of Asio, so we'll check for that first
+        if (!sockets_.host_vst_process_replacing_.wait_for_data()) {
+            const ScopedRealtimeSectionExit realtime_section_exit{};
+            throw std::runtime_error(
+                "The Wine plugin host exited while processing audio");
+        }
+
+        sockets_.host_vst_process_replacing_.receive_single<Ack>();
+    }
+}
+
+void Vst2PluginBridge::receive_queued_host_callbacks() {
+    if (config_.vst2_async_automation) {
+        read_shm_object(*process_buffers_,
+                        AudioShmBuffer::MetadataRegion::response,
+                        process_response_);
+    }
+}
+
+void Vst2PluginBridge::send_queued_host_callbacks() {
+    for (const Vst2QueuedHostCallback& callback :
+         process_response_.host_callbacks) {
+        logger_.log_event(false, callback.opcode, callback.index, 0, nullptr,
+                          callback.option, std::nullopt);
+
+        if (callback.opcode == audioMasterAutomate) {
+            cache_automated_parameter(callback.index, callback.option);
+        }
+
+        const intptr_t return_value =
+            host_callback_function_(&plugin_, callback.opcode, callback.index,
+                                    0, nullptr, callback.option);
+
+        logger_.log_event_response(false, callback.opcode, return_value,
+                                   nullptr, std::nullopt);
     }
 
-    incoming_midi_events_.clear();
+    process_response_.host_callbacks.clear();
+}
+
+void Vst2PluginBridge::cache_automated_parameter(int index, float value) {
+    if (config_.vst2_parameter_cache_ms) {
+        std::lock_guard lock(parameter_cache_mutex_);
+        parameter_cache_[index] = CachedParameter{
+            .value = value, .updated_at = std::chrono::steady_clock::now()};
+    }
+}
+
+void Vst2PluginBridge::drain_pipeline() {
+    std::lock_guard lock(pipeline_mutex_);
+    if (pipeline_pending_) {
+        pipeline_pending_ = false;
+        try {
+            wait_for_process_response(pipeline_last_sequence_);
+            receive_queued_host_callbacks();
+            send_queued_host_callbacks();
+        } catch (const std::exception&) {
+            // If the Wine plugin host crashed while processing the last block
+            // then the event we're about to send will fail anyways, and we
+            // don't want to throw from `effClose()`
+            logger_.log(
+                "The plugin crashed while processing audio, ignoring the last "
+                "block");
+        }
+    }
+}
+
+void Vst2PluginBridge::clear_parameter_cache() {
+    if (config_.vst2_parameter_cache_ms) {
+        std::lock_guard lock(parameter_cache_mutex_);
+        parameter_cache_.clear();
+    }
+
+    if (config_.vst2_parameter_info_cache) {
+        std::lock_guard lock(parameter_info_cache_mutex_);
+        parameter_info_cache_.clear();
+    }
+}
+
+std::optional<std::string> Vst2PluginBridge::get_program_name(int index) {
+    if (index < 0 || index >= plugin_.numPrograms) {
+        return std::nullopt;
+    }
+
+    {
+        std::lock_guard lock(program_name_cache_mutex_);
+        if (program_names_unsupported_) {
+            return std::nullopt;
+        }
+        if (auto it = program_name_cache_.find(index);
+            it != program_name_cache_.end()) {
+            return it->second;
+        }
+    }
+
+    // This request is sent over the dispatch socket, so any MIDI events we're
+    // still holding on to should be sent first
+    if (config_.vst2_batch_midi_events) {
+        flush_pending_midi_events();
+    }
+
+    // Just like in `get_parameter_info()`, the lock is not held while waiting
+    // for the response
+    const int first = index - (index % max_program_names);
+    Vst2ProgramNames response{};
+    ProgramNamesConverter converter(response);
+    sockets_.host_vst_dispatch_.send_event(
+        converter, std::pair<Vst2Logger&, bool>(logger_, true),
+        effGetProgramNameIndexed, first, max_program_names, nullptr, 0.0);
+
+    std::lock_guard lock(program_name_cache_mutex_);
+    if (response.names.empty()) {
+        program_names_unsupported_ = true;
+        return std::nullopt;
+    }
+
+    std::optional<std::string> result;
+    for (size_t i = 0; i < response.names.size(); i++) {
+        const int program = first + static_cast<int>(i);
+        if (program == index) {
+            result = response.names[i];
+        }
+
+        program_name_cache_[program] = std::move(response.names[i]);
+    }
+
+    return result;
+}
+
+void Vst2PluginBridge::clear_program_name_cache() {
+    if (config_.vst2_program_name_cache) {
+        std::lock_guard lock(program_name_cache_mutex_);
+        program_name_cache_.clear();
+        current_program_.reset();
+    }
+}
+
+std::optional<intptr_t> Vst2PluginBridge::get_cached_speaker_arrangement_result(
+    int opcode,
+    int index,
+    intptr_t value,
+    void* data,
+    float option) {
+    // Just like in `DispatchDataConverter`, `data` contains the output
+    // arrangement and `value` contains the input arrangement
+    VstSpeakerArrangement& input =
+        *reinterpret_cast<VstSpeakerArrangement*>(value);
+    VstSpeakerArrangement& output = *static_cast<VstSpeakerArrangement*>(data);
+
+    if (opcode == effSetSpeakerArrangement) {
+        const std::optional<std::string> key =
+            speaker_arrangement_key(input, output);
+        if (!key) {
+            return std::nullopt;
+        }
+
+        std::optional<intptr_t> return_value;
+        {
+            std::lock_guard lock(speaker_arrangement_cache_mutex_);
+            if (accepted_speaker_arrangement_ == key) {
+                return_value = 1;
+            }
+        }
+        if (!return_value) {
+            std::lock_guard lock(rejected_speaker_arrangements_mutex);
+            if (rejected_speaker_arrangements.contains(
+                    {plugin_.uniqueID, plugin_.version, *key})) {
+                return_value = 0;
+            }
+        }
+        if (!return_value) {
+            return std::nullopt;
+        }
+
+        logger_.log_event(true, opcode, index, value,
+                          DynamicSpeakerArrangement(output), option,
+                          DynamicSpeakerArrangement(input));
+        logger_.log_event_response(true, opcode, *return_value, nullptr,
+                                   std::nullopt, true);
+
+        return return_value;
+    }
+
+    std::lock_guard lock(speaker_arrangement_cache_mutex_);
+    if (!plugin_speaker_arrangement_) {
+        return std::nullopt;
+    }
+
+    logger_.log_event(true, opcode, index, value,
+                      DynamicSpeakerArrangement(output), option,
+                      DynamicSpeakerArrangement(input));
+
+    const CachedSpeakerArrangement& cached = *plugin_speaker_arrangement_;
+    cached.input.write_to(input);
+    cached.output.write_to(output);
+
+    logger_.log_event_response(true, opcode, cached.return_value, cached.output,
+                               cached.input, true);
+
+    return cached.return_value;
+}
+
+void Vst2PluginBridge::cache_speaker_arrangement_result(
+    int opcode,
+    intptr_t value,
+    const void* data,
+    intptr_t return_value) {
+    if (!data || !value) {
+        return;
+    }
+
+    const VstSpeakerArrangement& input =
+        *reinterpret_cast<const VstSpeakerArrangement*>(value);
+    const VstSpeakerArrangement& output =
+        *static_cast<const VstSpeakerArrangement*>(data);
+    switch (opcode) {
+        case effSetSpeakerArrangement: {
+            std::optional<std::string> key =
+                speaker_arrangement_key(input, output);
+            if (!key) {
+                break;
+            }
+
+            // Rejecting an arrangement doesn't change the plugin's current
+            // arrangement, so whatever it accepted last is still valid
+            if (return_value) {
+                std::lock_guard lock(speaker_arrangement_cache_mutex_);
+                accepted_speaker_arrangement_ = std::move(key);
+                plugin_speaker_arrangement_.reset();
+            } else {
+                std::lock_guard lock(rejected_speaker_arrangements_mutex);
+                rejected_speaker_arrangements.emplace(
+                    plugin_.uniqueID, plugin_.version, std::move(*key));
+            }
+        } break;
+        case effGetSpeakerArrangement: {
+            // At this point the plugin's arrangements have been written back
+            // to the host's objects
+            if (return_value && valid_speaker_arrangement(input) &&
+                valid_speaker_arrangement(output)) {
+                std::lock_guard lock(speaker_arrangement_cache_mutex_);
+                plugin_speaker_arrangement_.emplace(CachedSpeakerArrangement{
+                    .return_value = return_value,
+                    .input = DynamicSpeakerArrangement(input),
+                    .output = DynamicSpeakerArrangement(output)});
+            }
+        } break;
+    }
+}
+
+void Vst2PluginBridge::clear_speaker_arrangement_cache() {
+    std::lock_guard lock(speaker_arrangement_cache_mutex_);
+    accepted_speaker_arrangement_.reset();
+    plugin_speaker_arrangement_.reset();
+}
+
+std::optional<intptr_t> Vst2PluginBridge::get_cached_dispatch_result(
+    int opcode,
+    int index,
+    intptr_t value,
+    void* data,
+    float option) {
+    switch (opcode) {
+        case effGetEffectName:
+        case effGetVendorString:
+        case effGetProductString: {
+            if (!data) {
+                return std::nullopt;
+            }
+
+            std::unique_lock lock(dispatch_result_cache_mutex_);
+            const auto it = dispatch_result_cache_.strings.find(opcode);
+            if (it == dispatch_result_cache_.strings.end()) {
+                return std::nullopt;
+            }
+
+            const auto [return_value, string] = it->second;
+            lock.unlock();
+
+            logger_.log_event(true, opcode, index, value, WantsString{},
+                              option, std::nullopt);
+
+            char* output = static_cast<char*>(data);
+            std::copy(string.begin(), string.end(), output);
+            output[string.size()] = 0;
+
+            logger_.log_event_response(true, opcode, return_value, string,
+                                       std::nullopt, true);
+            return return_value;
+        } break;
+        case effGetVendorVersion:
+        case effGetPlugCategory:
+        case effGetVstVersion: {
+            std::unique_lock lock(dispatch_result_cache_mutex_);
+            const auto it = dispatch_result_cache_.values.find(opcode);
+            if (it == dispatch_result_cache_.values.end()) {
+                return std::nullopt;
+            }
+
+            const intptr_t return_value = it->second;
+            lock.unlock();
+
+            logger_.log_event(true, opcode, index, value, nullptr, option,
+                              std::nullopt);
+            logger_.log_event_response(true, opcode, return_value, nullptr,
+                                       std::nullopt, true);
+            return return_value;
+        } break;
+        case effCanDo: {
+            if (!data) {
+                return std::nullopt;
+            }
+
+            const std::string query(static_cast<const char*>(data));
+            std::unique_lock lock(dispatch_result_cache_mutex_);
+            const auto it = dispatch_result_cache_.can_do.find(query);
+            if (it == dispatch_result_cache_.can_do.end()) {
+                return std::nullopt;
+            }
+
+            const intptr_t return_value = it->second;
+            lock.unlock();
+
+            logger_.log_event(true, opcode, index, value, query, option,
+                              std::nullopt);
+            logger_.log_event_response(true, opcode, return_value, nullptr,
+                                       std::nullopt, true);
+            return return_value;
+        } break;
+        default:
+            return std::nullopt;
+            break;
+    }
+}
+
+void Vst2PluginBridge::cache_dispatch_result(int opcode,
+                                             const void* data,
+                                             intptr_t return_value) {
+    switch (opcode) {
+        case effOpen:
+            clear_dispatch_result_cache();
+            break;
+        case effGetEffectName:
+        case effGetVendorString:
+        case effGetProductString:
+            if (data) {
+                std::lock_guard lock(dispatch_result_cache_mutex_);
+                dispatch_result_cache_.strings[opcode] = std::pair(
+                    return_value, std::string(static_cast<const char*>(data)));
+            }
+            break;
+        case effGetVendorVersion:
+        case effGetPlugCategory:
+        case effGetVstVersion: {
+            std::lock_guard lock(dispatch_result_cache_mutex_);
+            dispatch_result_cache_.values[opcode] = return_value;
+        } break;
+        case effCanDo:
+            if (data) {
+                std::lock_guard lock(dispatch_result_cache_mutex_);
+                dispatch_result_cache_.can_do[static_cast<const char*>(data)] =
+                    return_value;
+            }
+            break;
+    }
+}
+
+void Vst2PluginBridge::clear_dispatch_result_cache() {
+    std::lock_guard lock(dispatch_result_cache_mutex_);
+    dispatch_result_cache_ = DispatchResultCache{};
+}
+
+std::optional<std::string> Vst2PluginBridge::get_parameter_info(int opcode,
+                                                                int index) {
+    if (index < 0 || index >= plugin_.numParams) {
+        return std::nullopt;
+    }
+
+    {
+        std::lock_guard lock(parameter_info_cache_mutex_);
+        if (auto it = parameter_info_cache_.find(index);
+            it != parameter_info_cache_.end()) {
+            CachedParameterInfo& info = it->second;
+            switch (opcode) {
+                case effGetParamName:
+                    return info.name;
+                    break;
+                case effGetParamLabel:
+                    return info.label;
+                    break;
+                default: {
+                    // The display string depends on the parameter's current
+                    // value, so we'll only use the one from the last batch
+                    // once
+                    std::optional<std::string> display;
+                    if (info.display && std::chrono::steady_clock::now() -
+                                                info.fetched_at <
+                                            parameter_display_lifetime) {
+                        display = std::move(info.display);
+                    }
+                    info.display.reset();
+
+                    return display;
+                } break;
+            }
+        }
+    }
+
+    // Fetching a whole range of parameters for a single display string would
+    // not save any round trips
+    if (opcode == effGetParamDisplay) {
+        return std::nullopt;
+    }
+
+    // This request is sent over the dispatch socket, so any MIDI events we're
+    // still holding on to should be sent first
+    if (config_.vst2_batch_midi_events) {
+        flush_pending_midi_events();
+    }
+
+    // The lock is not held here since the plugin could make callbacks that
+    // clear the cache while we're waiting for the response
+    const int first = index - (index % max_parameter_descriptions);
+    Vst2ParameterDescriptions response{};
+    ParameterDescriptionsConverter converter(response);
+    sockets_.host_vst_dispatch_.send_event(
+        converter, std::pair<Vst2Logger&, bool>(logger_, true), opcode, first,
+        max_parameter_descriptions, nullptr, 0.0);
+
+    const auto now = std::chrono::steady_clock::now();
+    std::optional<std::string> result;
+
+    std::lock_guard lock(parameter_info_cache_mutex_);
+    for (size_t i = 0; i < response.descriptions.size(); i++) {
+        Vst2ParameterDescription& description = response.descriptions[i];
+        const int described_index = first + static_cast<int>(i);
+        if (described_index == index) {
+            result = opcode == effGetParamName ? description.name
+                                               : description.label;
+        }
+
+        parameter_info_cache_[described_index] =
+            CachedParameterInfo{.name = std::move(description.name),
+                                .label = std::move(description.label),
+                                .display = std::move(description.display),
+                                .fetched_at = now};
+    }
+
+    // Once the host has seen every parameter, we can store their names and
+    // labels for the next instance of this plugin
+    if (parameter_metadata_cache_ && !parameter_metadata_stored_ &&
+        parameter_info_cache_.size() ==
+            static_cast<size_t>(plugin_.numParams)) {
+        StoredParameterInfos stored_infos{};
+        stored_infos.parameters.reserve(parameter_info_cache_.size());
+        for (int i = 0; i < plugin_.numParams; i++) {
+            const CachedParameterInfo& info = parameter_info_cache_[i];
+            stored_infos.parameters.push_back(
+                StoredParameterInfo{.name = info.name, .label = info.label});
+        }
+
+        parameter_metadata_cache_->write(stored_infos);
+        parameter_metadata_stored_ = true;
+    }
+
+    return result;
+}
+
+void Vst2PluginBridge::setup_pipeline() {
+    // The added latency is equal to the maximum block size. Some hosts don't
+    // call `effSetBlockSize()`, so we'll ask the host in that case.
+    int block_size = pipeline_block_size_;
+    if (block_size <= 0) {
+        block_size = static_cast<int>(host_callback_function_(
+            &plugin_, audioMasterGetBlockSize, 0, 0, nullptr, 0.0));
+    }
+    const size_t new_latency = static_cast<size_t>(std::max(block_size, 0));
+
+    const bool latency_changed = new_latency != pipeline_latency_;
+    plugin_.initialDelay += static_cast<int>(new_latency) -
+                            static_cast<int>(pipeline_latency_);
+    pipeline_latency_ = new_latency;
+
+    // Hosts only read `initialDelay` again after `audioMasterIOChanged()`, so
+    // without this the added latency would not get compensated for
+    if (latency_changed) {
+        host_callback_function_(&plugin_, audioMasterIOChanged, 0, 0, nullptr,
+                                0.0);
+    }
+
+    // The delay lines start out silent, so the first block of output after
+    // resuming will be silence
+    pipeline_outputs_32_.assign(plugin_.numOutputs,
+                                std::vector<float>(pipeline_latency_, 0.0f));
+    pipeline_outputs_64_.assign(plugin_.numOutputs,
+                                std::vector<double>(pipeline_latency_, 0.0));
+    pipeline_write_pos_ = 0;
+    pipeline_pending_ = false;
 }
 
 void Vst2PluginBridge::process(AEffect* /*plugin*/,
@@ -768,8 +2286,24 @@ void Vst2PluginBridge::process_double_replacing(AEffect* /*plugin*/,
 }
 
 float Vst2PluginBridge::get_parameter(AEffect* /*plugin*/, int index) {
+    if (!plugin_host_initialized_) [[unlikely]] {
+        launch_deferred_plugin_host();
+    }
+
     logger_.log_get_parameter(index);
 
+    if (config_.vst2_parameter_cache_ms) {
+        std::lock_guard lock(parameter_cache_mutex_);
+        if (const auto it = parameter_cache_.find(index);
+            it != parameter_cache_.end() &&
+            std::chrono::steady_clock::now() - it->second.updated_at <
+                std::chrono::milliseconds(*config_.vst2_parameter_cache_ms)) {
+            logger_.log_get_parameter_response(it->second.value, true);
+
+            return it->second.value;
+        }
+    }
+
     const Parameter request{index, std::nullopt};
     ParameterResult response;
 
@@ -785,12 +2319,23 @@ float Vst2PluginBridge::get_parameter(AEffect* /*plugin*/, int index) {
 
     logger_.log_get_parameter_response(*response.value);
 
+    if (config_.vst2_parameter_cache_ms) {
+        std::lock_guard lock(parameter_cache_mutex_);
+        parameter_cache_[index] =
+            CachedParameter{.value = *response.value,
+                            .updated_at = std::chrono::steady_clock::now()};
+    }
+
     return *response.value;
 }
 
 void Vst2PluginBridge::set_parameter(AEffect* /*plugin*/,
                                      int index,
                                      float value) {
+    if (!plugin_host_initialized_) [[unlikely]] {
+        launch_deferred_plugin_host();
+    }
+
     logger_.log_set_parameter(index, value);
 
     const Parameter request{index, value};
@@ -808,6 +2353,22 @@ void Vst2PluginBridge::set_parameter(AEffect* /*plugin*/,
 
     // This should not contain any values and just serve as an acknowledgement
     assert(!response.value);
+
+    // The plugin may round or clamp the value, so we'll fetch it again the
+    // next time the host asks for it
+    if (config_.vst2_parameter_cache_ms) {
+        std::lock_guard lock(parameter_cache_mutex_);
+        parameter_cache_.erase(index);
+    }
+
+    // The same goes for any prefetched display string
+    if (config_.vst2_parameter_info_cache) {
+        std::lock_guard lock(parameter_info_cache_mutex_);
+        if (auto it = parameter_info_cache_.find(index);
+            it != parameter_info_cache_.end()) {
+            it->second.display.reset();
+        }
+    }
 }
 
 // The below functions are proxy functions for the methods defined in
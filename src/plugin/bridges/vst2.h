@@ -19,10 +19,17 @@
 #include <vestige/aeffectx.h>
 
 #include <asio/io_context.hpp>
+#include <atomic>
+#include <bitsery/ext/std_map.h>
+#include <chrono>
 #include <thread>
+#include <unordered_map>
 
+#include "../../common/bitsery/ext/in-place-optional.h"
 #include "../../common/communication/vst2.h"
 #include "../../common/logging/vst2.h"
+#include "../../common/spsc-queue.h"
+#include "../parameter-metadata-cache.h"
 #include "common.h"
 
 /**
@@ -127,6 +134,272 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
     template <typename T, bool replacing>
     void do_process(T** inputs, T** outputs, int sample_frames);
 
+    /**
+     * Write the input audio and the processing request for a block of audio to
+     * the shared memory buffers, and wake up the Wine plugin host's audio
+     * thread. The results should be read back using `finish_process()`. This
+     * split lets us process multiple instances at once in `process_batch()`.
+     *
+     * @return The response sequence number that should be passed to
+     *   `finish_process()`.
+     */
+    template <typename T>
+    uint32_t start_process(T** inputs, int sample_frames);
+
+    /**
+     * Wait for a block of audio started with `start_process()` to finish, and
+     * write the plugin's output to `outputs`.
+     *
+     * @see Vst2PluginBridge::do_process
+     */
+    template <typename T, bool replacing>
+    void finish_process(T** outputs, int sample_frames, uint32_t last_sequence);
+
+    /**
+     * Pass the MIDI events the plugin sent during audio processing on to the
+     * host. This has to be done at the end of the processing call.
+     */
+    void send_incoming_midi_events();
+
+    /**
+     * When the `vst2_batch_midi_events` option is enabled, hold on to the MIDI
+     * events the host passed to `effProcessEvents()` so they can be sent
+     * together with the next processing request. Events are only held back
+     * while the shared audio buffers exist, and batches that contain SysEx
+     * data or that would exceed `max_batched_midi_events` are not held back.
+     *
+     * @return Whether the events have been added to the pending events in
+     *   `batched_process_request_`. If this returns `false`, then the events
+     *   should be sent to the Wine plugin host as usual.
+     */
+    bool maybe_batch_midi_events(const VstEvents& events);
+
+    /**
+     * Send the MIDI events held back by `maybe_batch_midi_events()` to the
+     * Wine plugin host through `effProcessEvents()`. This is called before any
+     * other dispatcher call gets sent to the Wine plugin host so the plugin
+     * receives all events in the same order the host sent them in, and so
+     * events aren't held back indefinitely when the host stops processing
+     * audio.
+     */
+    void flush_pending_midi_events();
+
+    /**
+     * Process a batch of yabridge VST2 plugin instances at once. This first
+     * starts processing on all instances and only then waits for their results,
+     * so the Wine plugin hosts can process the instances in parallel.
+     *
+     * @return 1 if all instances were processed, or 0 if nothing was processed
+     *   because one of the entries cannot be processed this way.
+     *
+     * @see yabridgeVendorSpecificProcessBatch
+     */
+    static intptr_t process_batch(const YabridgeProcessBatchEntry* entries,
+                                  size_t num_entries);
+
+    /**
+     * Wait for the Wine plugin host to finish processing the block of audio we
+     * sent after `process_buffers_->response_sequence()` returned
+     * `last_sequence`. This either receives the acknowledgement from the
+     * socket, or it waits for the futex when `futex_signalling` is enabled.
+     *
+     * @throw std::runtime_error If the Wine plugin host exited while we were
+     *   waiting for it. The realtime section gets left before throwing, so
+     *   this can safely be called from one.
+     */
+    void wait_for_process_response(uint32_t last_sequence);
+
+    /**
+     * Read the host callbacks the Wine plugin host queued during the last
+     * processing cycle into `process_response_` when the
+     * `vst2_async_automation` option is enabled. This should be called right
+     * after every call to `wait_for_process_response()`, since the Wine plugin
+     * host may overwrite them as soon as the next block gets sent.
+     *
+     * @see Configuration::vst2_async_automation
+     */
+    void receive_queued_host_callbacks();
+
+    /**
+     * Make the host callbacks read by `receive_queued_host_callbacks()`. This
+     * is done outside of the realtime sections since we have no control over
+     * what the host does in these callbacks.
+     */
+    void send_queued_host_callbacks();
+
+    /**
+     * Update the value for a parameter in `parameter_cache_` after the plugin
+     * has reported a change through `audioMasterAutomate()`. Does nothing if
+     * `vst2_parameter_cache_ms` is not enabled.
+     */
+    void cache_automated_parameter(int index, float value);
+
+    /**
+     * When using pipelined processing, wait for the block of audio that's
+     * currently being processed by the Wine plugin host to finish. This should
+     * be called before any event that changes the audio buffers or the
+     * processing setup.
+     *
+     * @see Configuration::vst2_pipelined_processing
+     */
+    void drain_pipeline();
+
+    /**
+     * Drop all values from the `getParameter()` cache, as well as all cached
+     * parameter names and labels. Called when the plugin loads a program or a
+     * chunk, since that can change any of its parameters without the plugin
+     * reporting those changes through `audioMasterAutomate()`.
+     *
+     * @see Configuration::vst2_parameter_cache_ms
+     * @see Configuration::vst2_parameter_info_cache
+     */
+    void clear_parameter_cache();
+
+    /**
+     * Answer an `effGetParamName()`, `effGetParamLabel()`, or
+     * `effGetParamDisplay()` call from `parameter_info_cache_`. On a cache miss
+     * for a name or a label this fetches the descriptions for the whole range
+     * of `max_parameter_descriptions` parameters containing `index` from the
+     * Wine plugin host. Returns a nullopt if the call should be sent to the
+     * Wine plugin host as usual instead.
+     *
+     * @see Configuration::vst2_parameter_info_cache
+     */
+    std::optional<std::string> get_parameter_info(int opcode, int index);
+
+    /**
+     * Answer an `effGetProgramName()` or `effGetProgramNameIndexed()` call for
+     * program `index` from `program_name_cache_`. On a cache miss this fetches
+     * the names for the whole range of `max_program_names` programs containing
+     * `index` from the Wine plugin host. Returns a nullopt if the call should
+     * be sent to the Wine plugin host as usual instead.
+     *
+     * @see Configuration::vst2_program_name_cache
+     */
+    std::optional<std::string> get_program_name(int index);
+
+    /**
+     * Drop all cached program names, and forget which program the host last
+     * selected. Called when the plugin loads a chunk or when it announces that
+     * its programs may have changed.
+     *
+     * @see Configuration::vst2_program_name_cache
+     */
+    void clear_program_name_cache();
+
+    /**
+     * Answer a `dispatch()` call from `dispatch_result_cache_` if the opcode
+     * is one of the cacheable opcodes and we have already seen its result.
+     * This also logs the event. Returns a nullopt if the event should be sent
+     * to the Wine plugin host instead.
+     *
+     * @see dispatch_result_cache_
+     */
+    std::optional<intptr_t> get_cached_dispatch_result(int opcode,
+                                                       int index,
+                                                       intptr_t value,
+                                                       void* data,
+                                                       float option);
+
+    /**
+     * Store the result of a `dispatch()` call that was sent to the Wine plugin
+     * host in `dispatch_result_cache_`, if the opcode can be cached.
+     *
+     * @see dispatch_result_cache_
+     */
+    void cache_dispatch_result(int opcode,
+                               const void* data,
+                               intptr_t return_value);
+
+    /**
+     * Drop everything from `dispatch_result_cache_`. Called when the plugin
+     * calls `audioMasterIOChanged()` or `audioMasterUpdateDisplay()`.
+     */
+    void clear_dispatch_result_cache();
+
+    /**
+     * Answer an `effSetSpeakerArrangement()` call for arrangements the plugin
+     * has either already accepted or that an instance of this plugin has
+     * rejected before, or answer an `effGetSpeakerArrangement()` call from
+     * `plugin_speaker_arrangement_`. This also logs the event. Returns a
+     * nullopt if the event should be sent to the Wine plugin host instead.
+     *
+     * @see Configuration::speaker_arrangement_cache
+     */
+    std::optional<intptr_t> get_cached_speaker_arrangement_result(
+        int opcode,
+        int index,
+        intptr_t value,
+        void* data,
+        float option);
+
+    /**
+     * Remember the result of an `effSetSpeakerArrangement()` or
+     * `effGetSpeakerArrangement()` call that was sent to the Wine plugin host.
+     * Does nothing for other opcodes.
+     *
+     * @see Configuration::speaker_arrangement_cache
+     */
+    void cache_speaker_arrangement_result(int opcode,
+                                          intptr_t value,
+                                          const void* data,
+                                          intptr_t return_value);
+
+    /**
+     * Forget the arrangements this instance has accepted and reported. Called
+     * when the plugin calls `audioMasterIOChanged()`.
+     */
+    void clear_speaker_arrangement_cache();
+
+    /**
+     * Start the Wine plugin host, connect to it, and receive the plugin's
+     * `AEffect`. This is normally done from the constructor. When the bridge
+     * was created from a stored `AEffect` snapshot for the `vst2_scan_cache`
+     * option this is instead done the first time the host does something
+     * that can't be answered from that snapshot. If the host had already
+     * called `effOpen()` at that point, then that call is sent to the plugin
+     * first. Does nothing if the Wine plugin host has already been started.
+     *
+     * @throw std::runtime_error Thrown when the Wine plugin host could not be
+     *   found or started.
+     */
+    void initialize_plugin_host();
+
+    /**
+     * Call `initialize_plugin_host()` for an instance that was created from a
+     * stored snapshot. Since this happens from within one of the host's calls,
+     * any errors will terminate the process.
+     */
+    void launch_deferred_plugin_host() noexcept;
+
+    /**
+     * Write the `AEffect` snapshot for the `vst2_scan_cache` option when the
+     * plugin gets closed, if we did not already have an up to date snapshot.
+     * The `dispatch_result_cache_` entries are merged into the stored ones, so
+     * later scans can answer everything any earlier host asked for.
+     */
+    void store_aeffect_snapshot();
+
+    /**
+     * Reset the delay lines used for pipelined processing and update the
+     * plugin's reported latency after the host resumes the plugin. If the
+     * added latency changed, then the host is notified through
+     * `audioMasterIOChanged()`.
+     */
+    void setup_pipeline();
+
+    /**
+     * Get the delay lines for pipelined processing for a given sample type.
+     */
+    template <typename T>
+    std::vector<std::vector<T>>& pipeline_outputs() noexcept {
+        if constexpr (std::is_same_v<T, double>) {
+            return pipeline_outputs_64_;
+        } else {
+            return pipeline_outputs_32_;
+        }
+    }
+
     /**
      * This AEffect struct will be populated using the data passed by the Wine
      * VST host during initialization and then passed as a pointer to the Linux
@@ -148,6 +421,269 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      */
     std::mutex parameters_mutex_;
 
+    /**
+     * A value in `parameter_cache_`, along with the time it was last fetched
+     * from or reported by the plugin.
+     */
+    struct CachedParameter {
+        float value;
+        std::chrono::steady_clock::time_point updated_at;
+    };
+
+    /**
+     * Parameter values we can return from `getParameter()` without asking the
+     * Wine plugin host when `vst2_parameter_cache_ms` is enabled. These are
+     * filled in by `getParameter()` and by `audioMasterAutomate()` callbacks,
+     * and entries are removed when the host calls `setParameter()`.
+     *
+     * @see Configuration::vst2_parameter_cache_ms
+     */
+    std::unordered_map<int, CachedParameter> parameter_cache_;
+    /**
+     * Protects `parameter_cache_`. This is separate from `parameters_mutex_` so
+     * `audioMasterAutomate()` callbacks can update the cache while a
+     * `getParameter()` call is waiting for a response.
+     */
+    std::mutex parameter_cache_mutex_;
+
+    /**
+     * The host callbacks queued by the Wine plugin host during the last
+     * processing cycle when the `vst2_async_automation` option is enabled.
+     * This object is reused to avoid allocations.
+     *
+     * @see send_queued_host_callbacks
+     */
+    Vst2ProcessResponse process_response_;
+
+    /**
+     * A parameter's name and label as stored in `parameter_info_cache_`. The
+     * display string fetched along with them is only kept until it has been
+     * used once, and it's only used if it has been fetched recently.
+     */
+    struct CachedParameterInfo {
+        std::string name;
+        std::string label;
+        std::optional<std::string> display;
+        std::chrono::steady_clock::time_point fetched_at;
+    };
+
+    /**
+     * Parameter names and labels fetched in bulk from the Wine plugin host when
+     * the `vst2_parameter_info_cache` option is enabled.
+     *
+     * @see get_parameter_info
+     */
+    std::unordered_map<int, CachedParameterInfo> parameter_info_cache_;
+    std::mutex parameter_info_cache_mutex_;
+
+    /**
+     * The parameter names and labels stored on disk for the
+     * `parameter_metadata_cache` option.
+     */
+    struct StoredParameterInfo {
+        std::string name;
+        std::string label;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.text1b(name, max_string_length);
+            s.text1b(label, max_string_length);
+        }
+    };
+
+    struct StoredParameterInfos {
+        std::vector<StoredParameterInfo> parameters;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(parameters, 1 << 16);
+        }
+    };
+
+    /**
+     * The on-disk cache used to pre-fill `parameter_info_cache_` when both the
+     * `parameter_metadata_cache` and `vst2_parameter_info_cache` options are
+     * enabled. This is read once when the plugin gets initialized and written
+     * once after the host has fetched the names and labels of all parameters.
+     */
+    std::optional<ParameterMetadataCache> parameter_metadata_cache_;
+    /**
+     * Set once the cache has either been read from or written to, so it only
+     * gets written once per instance. Protected by
+     * `parameter_info_cache_mutex_`.
+     */
+    bool parameter_metadata_stored_ = false;
+
+    /**
+     * Program names fetched in bulk from the Wine plugin host when the
+     * `vst2_program_name_cache` option is enabled, indexed by the program's
+     * index.
+     *
+     * @see get_program_name
+     */
+    std::unordered_map<int, std::string> program_name_cache_;
+    /**
+     * The program the host last selected through `effSetProgram()`, so
+     * `effGetProgramName()` can be answered from `program_name_cache_`. This
+     * is reset together with the cache since the plugin may have switched
+     * programs on its own by then.
+     */
+    std::optional<int> current_program_;
+    /**
+     * Set when the plugin returned nothing for `effGetProgramNameIndexed()`.
+     * All program name requests are then passed through as usual.
+     */
+    bool program_names_unsupported_ = false;
+    std::mutex program_name_cache_mutex_;
+
+    /**
+     * The input and output arrangements the plugin returned from
+     * `effGetSpeakerArrangement()`, along with the return value.
+     */
+    struct CachedSpeakerArrangement {
+        intptr_t return_value;
+        DynamicSpeakerArrangement input;
+        DynamicSpeakerArrangement output;
+    };
+
+    /**
+     * The key for the arrangements from the last `effSetSpeakerArrangement()`
+     * call the plugin accepted when the `speaker_arrangement_cache` option is
+     * enabled. See `speaker_arrangement_key()` in `vst2.cpp`.
+     *
+     * @see get_cached_speaker_arrangement_result
+     */
+    std::optional<std::string> accepted_speaker_arrangement_;
+    /**
+     * The result of the last `effGetSpeakerArrangement()` call. Reset when the
+     * plugin accepts new arrangements.
+     *
+     * @see get_cached_speaker_arrangement_result
+     */
+    std::optional<CachedSpeakerArrangement> plugin_speaker_arrangement_;
+    std::mutex speaker_arrangement_cache_mutex_;
+
+    /**
+     * A cache for `dispatch()` calls whose results should not change during
+     * the lifetime of a plugin instance. Some hosts query these over and over
+     * again, for instance every time the plugin list gets redrawn.
+     *
+     * @see dispatch_result_cache_
+     */
+    struct DispatchResultCache {
+        /**
+         * Memoizes `effGetEffectName()`, `effGetVendorString()`, and
+         * `effGetProductString()`, along with their return values.
+         */
+        std::unordered_map<int, std::pair<intptr_t, std::string>> strings;
+        /**
+         * Memoizes `effGetVendorVersion()`, `effGetPlugCategory()`, and
+         * `effGetVstVersion()`.
+         */
+        std::unordered_map<int, intptr_t> values;
+        /**
+         * Memoizes `effCanDo()`, indexed by the query string.
+         */
+        std::unordered_map<std::string, intptr_t> can_do;
+
+        bool operator==(const DispatchResultCache&) const = default;
+    };
+
+    /**
+     * The results from the opcodes described in `DispatchResultCache`.
+     * Similar to the function call cache for VST3 plugins, this cache is
+     * cleared when the plugin tells the host that something about it has
+     * changed through `audioMasterIOChanged()` or `audioMasterUpdateDisplay()`.
+     * It's also cleared after `effOpen()`, since some plugins only fully
+     * initialize themselves at that point.
+     *
+     * @see get_cached_dispatch_result
+     * @see cache_dispatch_result
+     */
+    DispatchResultCache dispatch_result_cache_;
+    std::mutex dispatch_result_cache_mutex_;
+
+    /**
+     * Everything we store on disk for the `vst2_scan_cache` option. The return
+     * values are stored as 64-bit integers so 32-bit and 64-bit builds of
+     * yabridge can read each other's snapshots.
+     */
+    struct AEffectSnapshot {
+        /**
+         * The `AEffect` the Wine plugin host sent us during initialization,
+         * before the host called `effOpen()`.
+         */
+        AEffect initial{};
+        /**
+         * The `AEffect` after `effOpen()`, if the host called it. Some plugins
+         * only fully initialize themselves at that point.
+         */
+        std::optional<AEffect> opened;
+        /**
+         * The `dispatch()` results memoized after `effOpen()`.
+         */
+        DispatchResultCache results;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.object(initial);
+            s.ext(opened, bitsery::ext::InPlaceOptional());
+            s.ext(results.strings, bitsery::ext::StdMap{1 << 8},
+                  [](S& s, int& opcode, std::pair<intptr_t, std::string>& v) {
+                      native_intptr_t return_value = v.first;
+                      s.value4b(opcode);
+                      s.value8b(return_value);
+                      s.text1b(v.second, max_string_length);
+                      v.first = static_cast<intptr_t>(return_value);
+                  });
+            s.ext(results.values, bitsery::ext::StdMap{1 << 8},
+                  [](S& s, int& opcode, intptr_t& v) {
+                      native_intptr_t return_value = v;
+                      s.value4b(opcode);
+                      s.value8b(return_value);
+                      v = static_cast<intptr_t>(return_value);
+                  });
+            s.ext(results.can_do, bitsery::ext::StdMap{1 << 12},
+                  [](S& s, std::string& query, intptr_t& v) {
+                      native_intptr_t return_value = v;
+                      s.text1b(query, max_string_length);
+                      s.value8b(return_value);
+                      v = static_cast<intptr_t>(return_value);
+                  });
+        }
+    };
+
+    /**
+     * The on-disk cache for the `AEffect` snapshot when the `vst2_scan_cache`
+     * option is enabled.
+     */
+    std::optional<ParameterMetadataCache> aeffect_snapshot_cache_;
+    /**
+     * The snapshot this instance was created from, if `aeffect_snapshot_cache_`
+     * contained one. This is reset when the plugin turns out to report a
+     * different `AEffect` so the snapshot gets replaced.
+     */
+    std::optional<AEffectSnapshot> stored_snapshot_;
+    /**
+     * The `AEffect` values reported by the Wine plugin host during this
+     * instance's lifetime, used to write a new snapshot in
+     * `store_aeffect_snapshot()`.
+     */
+    AEffectSnapshot captured_snapshot_;
+
+    /**
+     * Whether `initialize_plugin_host()` has been called. This is only ever
+     * false when the instance was created from a stored snapshot. Checked
+     * before every call that needs the Wine plugin host.
+     */
+    std::atomic_bool plugin_host_initialized_ = false;
+    std::mutex plugin_host_initialization_mutex_;
+    /**
+     * Set when we answered the host's `effOpen()` call from the snapshot, in
+     * which case `initialize_plugin_host()` still has to send it to the plugin.
+     */
+    bool open_deferred_ = false;
+
     /**
      * The callback function passed by the host to the VST plugin instance.
      */
@@ -174,11 +710,135 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
     std::optional<AudioShmBuffer> process_buffers_;
 
     /**
-     * We'll periodically synchronize the Wine host's audio thread priority with
-     * that of the host. Since the overhead from doing so does add up, we'll
-     * only do this every once in a while.
+     * Whether the host has indicated that it's going to send double precision
+     * audio through `effSetProcessPrecision()`. We only need this to know what
+     * type of pointers we're handing out to the host in our
+     * `yabridgeVendorSpecificAudioBuffers` extension, and to check that the
+     * entries passed to `process_batch()` match the buffers' precision.
+     */
+    bool double_precision_ = false;
+
+    /**
+     * When the `vst2_detect_silence` option is enabled, this contains a flag
+     * for every input channel in `process_buffers_` indicating that the
+     * channel only contains zeroes for the first `zeroed_input_num_samples_`
+     * samples. We can skip copying silent inputs to those channels. This is
+     * only valid for `zeroed_input_generation_`, and it needs to be discarded
+     * when the buffers get resized.
+     */
+    std::vector<uint8_t> zeroed_input_channels_;
+    int zeroed_input_num_samples_ = 0;
+    uint32_t zeroed_input_generation_ = 0;
+    bool zeroed_input_double_precision_ = false;
+
+    /**
+     * The block size the host last set using `effSetBlockSize()`, used to
+     * determine how much latency pipelined processing adds.
+     */
+    int pipeline_block_size_ = 0;
+    /**
+     * The number of samples of latency we're adding with pipelined
+     * processing. This is added to the plugin's reported `initialDelay`, and
+     * it's also the length of the delay lines below. Zero when pipelining is
+     * not enabled or when the plugin has not been resumed yet.
+     */
+    size_t pipeline_latency_ = 0;
+    /**
+     * Whether the Wine plugin host is still processing a block of audio that
+     * we have not yet received the output for. In that case
+     * `pipeline_last_sequence_` and `pipeline_pending_frames_` describe that
+     * block.
+     */
+    bool pipeline_pending_ = false;
+    uint32_t pipeline_last_sequence_ = 0;
+    int pipeline_pending_frames_ = 0;
+    /**
+     * Ring buffers per output channel containing the last
+     * `pipeline_latency_` samples of output produced by the plugin. The host
+     * receives its output from here when using pipelined processing. Both
+     * precisions are allocated since we only know which one the host is going
+     * to use when it starts processing.
+     */
+    std::vector<std::vector<float>> pipeline_outputs_32_;
+    std::vector<std::vector<double>> pipeline_outputs_64_;
+    /**
+     * The write position in the ring buffers above. Reading the oldest
+     * samples starts at this same position.
+     */
+    size_t pipeline_write_pos_ = 0;
+    /**
+     * Protects the pipelining state above, since `drain_pipeline()` is called
+     * from `dispatch()` which may be called from another thread than the audio
+     * thread. This is never contested during normal processing.
+     */
+    std::mutex pipeline_mutex_;
+
+    /**
+     * The number of times `wait_for_process_response()` did and did not receive
+     * a response while spinning when the `audio_wait_spin_us` option is
+     * enabled. These are printed and reset when the plugin gets suspended.
+     */
+    std::atomic_uint64_t spin_wait_hits_ = 0;
+    std::atomic_uint64_t spin_wait_misses_ = 0;
+
+    /**
+     * When we received the plugin's `AEffect` from the Wine plugin host during
+     * initialization. The startup timings are logged after the host's first
+     * `effOpen()` call, since that's the last part of the plugin's startup.
+     *
+     * @see PluginBridge::log_startup_timings
+     */
+    std::chrono::steady_clock::time_point plugin_created_at_;
+    bool startup_timings_logged_ = false;
+
+    /**
+     * The sample rate the host last set using `effSetSampleRate()`, used to
+     * compute the deadline for the `audio_deadline_warning` option.
+     */
+    float sample_rate_ = 0.0f;
+    /**
+     * The block size the host last set using `effSetBlockSize()`. The Wine
+     * plugin host sizes the shared audio buffers for this many samples, so
+     * `process_batch()` uses this to reject entries with larger blocks.
+     */
+    int max_block_size_ = 0;
+    /**
+     * When `start_process()` sent the last processing request and when
+     * `finish_process()` learned that it had been processed. These are only
+     * used with the `audio_deadline_warning` option, and they're only accessed
+     * from the audio thread.
+     */
+    std::chrono::steady_clock::time_point process_request_sent_;
+    std::chrono::steady_clock::time_point process_response_received_;
+    ProcessDeadlineMonitor deadline_monitor_;
+
+    /**
+     * The transport information we send as part of every processing request is
+     * delta encoded against the last transport information we sent. This is
+     * only ever accessed from the audio thread.
+     */
+    Vst2TimeInfoEncoder time_info_encoder_;
+
+    /**
+     * The realtime priority of the host's audio thread we last sent to the Wine
+     * plugin host. We check the priority during every processing cycle, but we
+     * only send it when it changes. This way the Wine plugin host's audio
+     * thread immediately follows priority changes made by the host or by
+     * rtkit. Only accessed from the audio thread.
+     */
+    std::optional<int> last_synchronized_realtime_priority_;
+    /**
+     * The CPU core the host's audio thread was running on when we last sent it
+     * to the Wine plugin host for the `audio_thread_follow_host_cpu` option.
+     * Like with the priority, this is only sent when it changes.
      */
-    time_t last_audio_thread_priority_synchronization_ = 0;
+    std::optional<int> last_synchronized_host_audio_thread_cpu_;
+    /**
+     * The NUMA node the host's audio thread was running on when we last sent
+     * it to the Wine plugin host for the `audio_thread_follow_host_numa_node`
+     * option.
+     */
+    std::optional<int> last_synchronized_host_audio_thread_numa_node_;
 
     /**
      * The VST host can query a plugin for arbitrary binary data such as
@@ -187,6 +847,16 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      * `effGetChunk` event.
      */
     std::vector<uint8_t> chunk_data_;
+
+    /**
+     * The `index` argument and the hash of the chunk stored in `chunk_data_`
+     * when the `vst2_chunk_cache` option is enabled. This is sent to the Wine
+     * plugin host during `effGetChunk()` so it can avoid sending the same chunk
+     * again.
+     *
+     * @see WantsChunkBuffer::cached_hash
+     */
+    std::optional<std::pair<int, uint64_t>> chunk_data_hash_;
     /**
      * The VST host will expect to be returned a pointer to a struct that stores
      * the dimensions of the editor window.
@@ -201,13 +871,51 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      * callbacks on a separate thread, we have to temporarily store any events
      * we receive so we can send them to host on the audio thread at the end of
      * `process_replacing()`.
+     *
+     * This is a lock-free queue of event objects that are reused between
+     * processing cycles, so the audio thread never has to wait on the host
+     * callback thread. The events are copied into these objects on the host
+     * callback thread, so the audio thread also never has to allocate or free
+     * any memory. The capacity is set through the
+     * `vst2_midi_output_queue_size` option, and events that don't fit are
+     * dropped and counted in `dropped_midi_events_`.
+     */
+    SpscQueue<DynamicVstEvents> incoming_midi_events_;
+
+    /**
+     * Used instead of a plain `Vst2ProcessRequest` when the
+     * `vst2_batch_midi_events` option is enabled. Between processing cycles
+     * `batched_process_request_.midi_events` holds the events the host passed
+     * to `effProcessEvents()` that have not yet been sent to the Wine plugin
+     * host. These are cleared again after every processing cycle.
+     *
+     * @see maybe_batch_midi_events
+     */
+    Vst2BatchedProcessRequest batched_process_request_;
+    /**
+     * Protects `batched_process_request_`. This is locked by the audio thread
+     * every processing cycle when batching is enabled, so it uses priority
+     * inheritance.
      */
-    llvm::SmallVector<DynamicVstEvents, 1> incoming_midi_events_;
+    PiMutex batched_process_request_mutex_;
     /**
-     * Mutex for locking the above event queue, since recieving and processing
-     * now happens in two different threads.
+     * Set while `flush_pending_midi_events()` is sending held back events to
+     * the Wine plugin host without holding the lock above. New events won't
+     * be held back during that time so they can't overtake the flushed events.
+     */
+    bool midi_events_flushing_ = false;
+    /**
+     * Host callbacks can in theory be handled on multiple threads, so pushes
+     * to the queue above are serialized with this mutex. The audio thread
+     * never locks this.
      */
     std::mutex incoming_midi_events_mutex_;
+    /**
+     * The number of batches of MIDI events we had to drop because
+     * `incoming_midi_events_` was full. This is printed and reset when the
+     * plugin gets suspended, and the first drop is also printed immediately.
+     */
+    uint64_t dropped_midi_events_ = 0;
 
     /**
      * REAPER requires us to call `audioMasterSizeWidnow()` from the same thread
@@ -16,6 +16,29 @@
 
 #include "plug-view-proxy.h"
 
+/**
+ * The size in pixels of the grid cells `IParameterFinder::findParameter()`
+ * coordinates get snapped to when the `vst3_parameter_finder_cache` option is
+ * enabled. Plugin controls are much larger than this, so this should not cause
+ * noticeable inaccuracies.
+ */
+constexpr int32 parameter_finder_grid_size = 4;
+
+/**
+ * How long a cached `IParameterFinder::findParameter()` result stays valid.
+ * This is long enough to absorb a flood of mouse move events, while still
+ * picking up editors that change their layout, like when switching between
+ * tabs.
+ */
+constexpr std::chrono::milliseconds parameter_finder_cache_lifetime(250);
+
+/**
+ * The maximum number of grid cells we'll cache. The cache gets cleared when it
+ * grows past this size so it doesn't keep growing while the mouse moves all
+ * over a large editor.
+ */
+constexpr size_t parameter_finder_cache_max_size = 4096;
+
 RunLoopTasks::RunLoopTasks(Steinberg::IPtr<Steinberg::IPlugFrame> plug_frame)
     : run_loop_(plug_frame) {
     FUNKNOWN_CTOR
@@ -129,6 +152,9 @@ Vst3PlugViewProxyImpl::isPlatformTypeSupported(Steinberg::FIDString type) {
 tresult PLUGIN_API Vst3PlugViewProxyImpl::attached(void* parent,
                                                    Steinberg::FIDString type) {
     if (parent && type) {
+        clear_parameter_finder_cache();
+        clear_size_caches();
+
         // We will embed the Wine Win32 window into the X11 window provided by
         // the host
         return bridge_.send_mutually_recursive_message(YaPlugView::Attached{
@@ -143,6 +169,9 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::attached(void* parent,
 }
 
 tresult PLUGIN_API Vst3PlugViewProxyImpl::removed() {
+    clear_parameter_finder_cache();
+    clear_size_caches();
+
     return bridge_.send_mutually_recursive_message(
         YaPlugView::Removed{.owner_instance_id = owner_instance_id()});
 }
@@ -174,9 +203,34 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::onKeyUp(char16 key,
 
 tresult PLUGIN_API Vst3PlugViewProxyImpl::getSize(Steinberg::ViewRect* size) {
     if (size) {
+        const auto request =
+            YaPlugView::GetSize{.owner_instance_id = owner_instance_id()};
+
+        {
+            std::lock_guard lock(size_cache_mutex_);
+            if (size_cache_) {
+                const bool log_response =
+                    bridge_.logger_.log_request(true, request);
+                if (log_response) {
+                    bridge_.logger_.log_response(
+                        true,
+                        GetSizeResponse{.result = Steinberg::kResultOk,
+                                        .size = *size_cache_},
+                        true);
+                }
+
+                *size = *size_cache_;
+
+                return Steinberg::kResultOk;
+            }
+        }
+
         const GetSizeResponse response =
-            bridge_.send_mutually_recursive_message(
-                YaPlugView::GetSize{.owner_instance_id = owner_instance_id()});
+            bridge_.send_mutually_recursive_message(request);
+        if (response.result == Steinberg::kResultOk) {
+            std::lock_guard lock(size_cache_mutex_);
+            size_cache_ = response.size;
+        }
 
         *size = response.size;
 
@@ -190,8 +244,23 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::getSize(Steinberg::ViewRect* size) {
 
 tresult PLUGIN_API Vst3PlugViewProxyImpl::onSize(Steinberg::ViewRect* newSize) {
     if (newSize) {
-        return bridge_.send_mutually_recursive_message(YaPlugView::OnSize{
-            .owner_instance_id = owner_instance_id(), .new_size = *newSize});
+        clear_parameter_finder_cache();
+
+        const tresult result =
+            bridge_.send_mutually_recursive_message(YaPlugView::OnSize{
+                .owner_instance_id = owner_instance_id(),
+                .new_size = *newSize});
+
+        // If the plugin didn't accept the new size then we can't know what size
+        // it ended up at, so we'll ask again next time
+        std::lock_guard lock(size_cache_mutex_);
+        if (result == Steinberg::kResultOk) {
+            size_cache_ = *newSize;
+        } else {
+            size_cache_.reset();
+        }
+
+        return result;
     } else {
         bridge_.logger_.log(
             "WARNING: Null pointer passed to 'IPlugView::onSize()'");
@@ -250,16 +319,17 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::canResize() {
         YaPlugView::CanResize{.owner_instance_id = owner_instance_id()};
 
     {
-        std::lock_guard lock(can_resize_cache_mutex_);
-        if (const tresult* result = can_resize_cache_.get_and_keep_alive(5)) {
+        std::lock_guard lock(size_cache_mutex_);
+        if (can_resize_cache_) {
             const bool log_response =
                 bridge_.logger_.log_request(true, request);
             if (log_response) {
                 bridge_.logger_.log_response(
-                    true, YaPlugView::CanResize::Response(*result), true);
+                    true, YaPlugView::CanResize::Response(*can_resize_cache_),
+                    true);
             }
 
-            return *result;
+            return *can_resize_cache_;
         }
     }
 
@@ -267,8 +337,8 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::canResize() {
         bridge_.send_mutually_recursive_message(request);
 
     {
-        std::lock_guard lock(can_resize_cache_mutex_);
-        can_resize_cache_.set(result, 5);
+        std::lock_guard lock(size_cache_mutex_);
+        can_resize_cache_ = result;
     }
 
     return result;
@@ -297,12 +367,63 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::findParameter(
     int32 xPos,
     int32 yPos,
     Steinberg::Vst::ParamID& resultTag /*out*/) {
+    if (!bridge_.config().vst3_parameter_finder_cache) {
+        const FindParameterResponse response =
+            bridge_.send_mutually_recursive_message(
+                YaParameterFinder::FindParameter{
+                    .owner_instance_id = owner_instance_id(),
+                    .x_pos = xPos,
+                    .y_pos = yPos});
+
+        resultTag = response.result_tag;
+
+        return response.result;
+    }
+
+    // We'll query the parameter at the center of the grid cell so that every
+    // coordinate within a cell gets the same answer, regardless of which
+    // coordinate happened to be queried first
+    const std::pair<int32, int32> grid_cell(
+        xPos / parameter_finder_grid_size, yPos / parameter_finder_grid_size);
+    const auto request = YaParameterFinder::FindParameter{
+        .owner_instance_id = owner_instance_id(),
+        .x_pos = (grid_cell.first * parameter_finder_grid_size) +
+                 (parameter_finder_grid_size / 2),
+        .y_pos = (grid_cell.second * parameter_finder_grid_size) +
+                 (parameter_finder_grid_size / 2)};
+
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard lock(parameter_finder_cache_mutex_);
+        if (const auto cached = parameter_finder_cache_.find(grid_cell);
+            cached != parameter_finder_cache_.end() &&
+            now < cached->second.expires_at) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, cached->second.response,
+                                             true);
+            }
+
+            resultTag = cached->second.response.result_tag;
+
+            return cached->second.response.result;
+        }
+    }
+
     const FindParameterResponse response =
-        bridge_.send_mutually_recursive_message(
-            YaParameterFinder::FindParameter{
-                .owner_instance_id = owner_instance_id(),
-                .x_pos = xPos,
-                .y_pos = yPos});
+        bridge_.send_mutually_recursive_message(request);
+
+    {
+        std::lock_guard lock(parameter_finder_cache_mutex_);
+        if (parameter_finder_cache_.size() >= parameter_finder_cache_max_size) {
+            parameter_finder_cache_.clear();
+        }
+
+        parameter_finder_cache_[grid_cell] = CachedFindParameterResponse{
+            .response = response,
+            .expires_at = now + parameter_finder_cache_lifetime};
+    }
 
     resultTag = response.result_tag;
 
@@ -311,7 +432,27 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::findParameter(
 
 tresult PLUGIN_API
 Vst3PlugViewProxyImpl::setContentScaleFactor(ScaleFactor factor) {
+    clear_parameter_finder_cache();
+    clear_size_caches();
+
     return bridge_.send_mutually_recursive_message(
         YaPlugViewContentScaleSupport::SetContentScaleFactor{
             .owner_instance_id = owner_instance_id(), .factor = factor});
 }
+
+void Vst3PlugViewProxyImpl::update_size_cache(
+    const Steinberg::ViewRect& size) noexcept {
+    std::lock_guard lock(size_cache_mutex_);
+    size_cache_ = size;
+}
+
+void Vst3PlugViewProxyImpl::clear_size_caches() noexcept {
+    std::lock_guard lock(size_cache_mutex_);
+    can_resize_cache_.reset();
+    size_cache_.reset();
+}
+
+void Vst3PlugViewProxyImpl::clear_parameter_finder_cache() noexcept {
+    std::lock_guard lock(parameter_finder_cache_mutex_);
+    parameter_finder_cache_.clear();
+}
@@ -164,6 +164,15 @@ class Vst3PlugViewProxyImpl : public Vst3PlugViewProxy {
         }
     }
 
+    /**
+     * Remember the editor's size after the host has accepted a
+     * `IPlugFrame::resizeView()` request from the plugin, so the host's next
+     * `IPlugView::getSize()` calls can be answered without a round trip.
+     *
+     * @see size_cache_
+     */
+    void update_size_cache(const Steinberg::ViewRect& size) noexcept;
+
     // From `IPlugView`
     tresult PLUGIN_API
     isPlatformTypeSupported(Steinberg::FIDString type) override;
@@ -214,6 +223,13 @@ class Vst3PlugViewProxyImpl : public Vst3PlugViewProxy {
 
     // Caches
 
+    /**
+     * Drop the cached editor size and resizability. Called when the editor
+     * gets attached to or removed from a window, and when the content scale
+     * factor changes.
+     */
+    void clear_size_caches() noexcept;
+
     /**
      * During resizing the host will likely constantly ask the plugin if it can
      * be freely resized. Even if it is technically possible, I'm not aware of
@@ -222,9 +238,51 @@ class Vst3PlugViewProxyImpl : public Vst3PlugViewProxy {
      * `IPlugView::canResize()` is because this function has to be run on the
      * GUI thread, just like `IPlugView::onSize()` and
      * `IPlugView::checkSizeConstraint`. Everything running in lockstep makes
-     * resizing a lot laggier than they would have to be, so as a compromise
-     * we'll remember this value for the duration of the resize.
+     * resizing a lot laggier than they would have to be, so we'll remember
+     * this value for as long as the editor stays attached to the same window.
+     */
+    std::optional<tresult> can_resize_cache_;
+
+    /**
+     * The editor's last known size. Hosts call `IPlugView::getSize()` all the
+     * time on open editors, and just like `IPlugView::canResize()` that needs
+     * to go through the GUI thread on the Wine side. This is updated from the
+     * plugin's `getSize()` responses, from successful `IPlugView::onSize()`
+     * calls, and from `IPlugFrame::resizeView()` calls the host accepted.
+     */
+    std::optional<Steinberg::ViewRect> size_cache_;
+
+    /**
+     * Protects both `can_resize_cache_` and `size_cache_`.
+     */
+    std::mutex size_cache_mutex_;
+
+    /**
+     * Drop all cached `IParameterFinder::findParameter()` results. Called
+     * whenever the editor gets resized, rescaled, attached, or removed, since
+     * the parameters under the cursor will likely have moved.
+     */
+    void clear_parameter_finder_cache() noexcept;
+
+    /**
+     * A cached `IParameterFinder::findParameter()` result along with the time
+     * at which it should no longer be used.
+     */
+    struct CachedFindParameterResponse {
+        FindParameterResponse response;
+        std::chrono::steady_clock::time_point expires_at;
+    };
+
+    /**
+     * Some hosts call `IParameterFinder::findParameter()` every time the mouse
+     * moves over the editor so they can show which parameter is under the
+     * cursor. When the `vst3_parameter_finder_cache` option is enabled, we'll
+     * snap those coordinates to a coarse grid and answer repeated queries for
+     * the same grid cell from this cache for a short while, instead of doing a
+     * round trip to the Wine plugin host's GUI thread for every pixel the
+     * mouse moves.
      */
-    TimedValueCache<tresult> can_resize_cache_;
-    std::mutex can_resize_cache_mutex_;
+    std::map<std::pair<int32, int32>, CachedFindParameterResponse>
+        parameter_finder_cache_;
+    std::mutex parameter_finder_cache_mutex_;
 };
@@ -23,7 +23,7 @@
 
 Vst3PluginFactoryProxyImpl::Vst3PluginFactoryProxyImpl(
     Vst3PluginBridge& bridge,
-    Vst3PluginFactoryProxy::ConstructArgs&& args) noexcept
+    std::shared_ptr<const Vst3PluginFactoryProxy::ConstructArgs> args) noexcept
     : Vst3PluginFactoryProxy(std::move(args)), bridge_(bridge) {}
 
 tresult PLUGIN_API
@@ -49,6 +49,8 @@ Vst3PluginFactoryProxyImpl::createInstance(Steinberg::FIDString cid,
 
     Steinberg::TUID cid_array;
     std::copy(cid, cid + std::extent_v<Steinberg::TUID>, cid_array);
+    ArrayUID class_id;
+    std::copy(cid, cid + std::extent_v<Steinberg::TUID>, class_id.begin());
 
     // I don't think they include a safe way to convert a `FIDString/char*` into
     // a `FUID`, so this will have to do
@@ -84,7 +86,8 @@ Vst3PluginFactoryProxyImpl::createInstance(Steinberg::FIDString cid,
                 // reference count of 1), and then the receiving side will use
                 // `Steinberg::owned()` to adopt it to an `IPtr<T>`.
                 Vst3PluginProxyImpl* proxy_object =
-                    new Vst3PluginProxyImpl(bridge_, std::move(args));
+                    new Vst3PluginProxyImpl(bridge_, std::move(args),
+                                            class_id);
 
                 // We return a properly downcasted version of the proxy object
                 // we just created
@@ -120,8 +123,8 @@ Vst3PluginFactoryProxyImpl::setHostContext(Steinberg::FUnknown* context) {
         plug_interface_support_ = host_context_;
 
         return bridge_.send_message(YaPluginFactory3::SetHostContext{
-            .host_context_args = Vst3HostContextProxy::ConstructArgs(
-                host_context_, std::nullopt)});
+            .host_context_args =
+                bridge_.create_host_context_args(host_context_, std::nullopt)});
     } else {
         bridge_.logger_.log(
             "WARNING: Null pointer passed to "
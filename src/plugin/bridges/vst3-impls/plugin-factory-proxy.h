@@ -26,7 +26,8 @@ class Vst3PluginFactoryProxyImpl : public Vst3PluginFactoryProxy {
    public:
     Vst3PluginFactoryProxyImpl(
         Vst3PluginBridge& bridge,
-        Vst3PluginFactoryProxy::ConstructArgs&& args) noexcept;
+        std::shared_ptr<const Vst3PluginFactoryProxy::ConstructArgs>
+            args) noexcept;
 
     /**
      * We'll override the query interface to log queries for interfaces we do
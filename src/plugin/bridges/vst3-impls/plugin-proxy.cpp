@@ -16,6 +16,8 @@
 
 #include "plugin-proxy.h"
 
+#include <algorithm>
+
 #include <pluginterfaces/vst/ivstmidicontrollers.h>
 
 #include "plug-view-proxy.h"
@@ -42,8 +44,18 @@ Vst3PluginProxyImpl::ContextMenu::ContextMenu(
     : menu(menu) {}
 
 Vst3PluginProxyImpl::Vst3PluginProxyImpl(Vst3PluginBridge& bridge,
-                                         Vst3PluginProxy::ConstructArgs&& args)
-    : Vst3PluginProxy(std::move(args)), bridge_(bridge) {
+                                         Vst3PluginProxy::ConstructArgs&& args,
+                                         const ArrayUID& class_id)
+    : Vst3PluginProxy(std::move(args)), bridge_(bridge), class_id_(class_id) {
+    if (bridge.config().vst3_shared_bus_cache) {
+        shared_bus_cache_key_ =
+            Vst3PluginBridge::SharedBusCacheKey{class_id, {}, {}};
+    }
+    if (bridge.config().parameter_metadata_cache) {
+        parameter_metadata_cache_.emplace(
+            bridge.parameter_metadata_cache(class_id));
+    }
+
     bridge.register_plugin_proxy(*this);
 }
 
@@ -85,11 +97,211 @@ bool Vst3PluginProxyImpl::unregister_context_menu(size_t context_menu_id) {
     return context_menus_.erase(context_menu_id);
 }
 
-void Vst3PluginProxyImpl::clear_caches() noexcept {
-    clear_bus_cache();
+void Vst3PluginProxyImpl::clear_caches(int32 restart_flags) noexcept {
+    using namespace Steinberg::Vst;
+
+    // Some plugins call `restartComponent()` many times in a row, so we'll only
+    // clear the information the flags tell us has changed. Parameter value
+    // changes are still treated as parameter information changes since some
+    // plugins also change their parameters' default values or step counts
+    // without setting `kParamTitlesChanged`. For any other flag we'll still err
+    // on the safe side and clear everything.
+    constexpr int32 selective_flags =
+        kIoChanged | kParamValuesChanged | kLatencyChanged |
+        kParamTitlesChanged | kMidiCCAssignmentChanged |
+        kNoteExpressionChanged | kIoTitlesChanged | kKeyswitchChanged;
+    if (restart_flags & ~selective_flags) {
+        clear_bus_cache();
+        clear_parameter_values();
+        bridge_.clear_class_representation_cache(class_id_);
+        bridge_.clear_rejected_bus_arrangements(class_id_);
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        function_result_cache_ = FunctionResultCache{};
+        function_result_cache_generation_++;
+
+        return;
+    }
+
+    if (restart_flags & (kIoChanged | kLatencyChanged | kIoTitlesChanged)) {
+        clear_bus_cache();
+    }
+    if (restart_flags & kParamValuesChanged) {
+        clear_parameter_values();
+    }
+
+    if (restart_flags & kIoChanged) {
+        bridge_.clear_rejected_bus_arrangements(class_id_);
+    }
 
     std::lock_guard lock(function_result_cache_mutex_);
-    function_result_cache_ = FunctionResultCache{};
+    if (restart_flags & kIoChanged) {
+        function_result_cache_.can_process_sample_size.clear();
+        function_result_cache_.accepted_bus_arrangements.reset();
+    }
+    if (restart_flags & (kParamValuesChanged | kParamTitlesChanged)) {
+        function_result_cache_.parameter_count.reset();
+        function_result_cache_.parameter_info.clear();
+        function_result_cache_.parameter_info_prefetched = false;
+        function_result_cache_.units_and_program_lists.reset();
+        function_result_cache_.program_info.clear();
+    }
+    if (restart_flags & kMidiCCAssignmentChanged) {
+        function_result_cache_.midi_controller_assignments.clear();
+    }
+    if (restart_flags & kNoteExpressionChanged) {
+        function_result_cache_.note_expression_infos.clear();
+    }
+    if (restart_flags & kKeyswitchChanged) {
+        function_result_cache_.keyswitch_infos.clear();
+    }
+    function_result_cache_generation_++;
+}
+
+void Vst3PluginProxyImpl::clear_unit_info_cache() noexcept {
+    std::lock_guard lock(function_result_cache_mutex_);
+    function_result_cache_.units_and_program_lists.reset();
+    function_result_cache_.program_info.clear();
+    function_result_cache_generation_++;
+}
+
+void Vst3PluginProxyImpl::prefetch_units_and_program_lists() {
+    uint64_t generation;
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_.units_and_program_lists) {
+            return;
+        }
+
+        generation = function_result_cache_generation_;
+    }
+
+    YaUnitInfo::GetAllUnitsAndProgramListsResponse response =
+        bridge_.send_message(YaUnitInfo::GetAllUnitsAndProgramLists{
+            .instance_id = instance_id()});
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (function_result_cache_generation_ == generation) {
+        function_result_cache_.units_and_program_lists = std::move(response);
+    }
+}
+
+void Vst3PluginProxyImpl::prefetch_keyswitch_infos(int32 bus_index,
+                                                   int16 channel) {
+    const auto key = std::tuple(bus_index, channel);
+
+    uint64_t generation;
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_.keyswitch_infos.contains(key)) {
+            return;
+        }
+
+        generation = function_result_cache_generation_;
+    }
+
+    YaKeyswitchController::GetAllKeyswitchInfosResponse response =
+        bridge_.send_message(YaKeyswitchController::GetAllKeyswitchInfos{
+            .instance_id = instance_id(),
+            .bus_index = bus_index,
+            .channel = channel});
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (function_result_cache_generation_ == generation) {
+        function_result_cache_.keyswitch_infos[key] = std::move(response);
+    }
+}
+
+void Vst3PluginProxyImpl::prefetch_note_expression_infos(int32 bus_index,
+                                                         int16 channel) {
+    const auto key = std::tuple(bus_index, channel);
+
+    uint64_t generation;
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_.note_expression_infos.contains(key)) {
+            return;
+        }
+
+        generation = function_result_cache_generation_;
+    }
+
+    YaNoteExpressionController::GetAllNoteExpressionInfosResponse response =
+        bridge_.send_message(
+            YaNoteExpressionController::GetAllNoteExpressionInfos{
+                .instance_id = instance_id(),
+                .bus_index = bus_index,
+                .channel = channel});
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (function_result_cache_generation_ == generation) {
+        function_result_cache_.note_expression_infos[key] = std::move(response);
+    }
+}
+
+void Vst3PluginProxyImpl::prefetch_midi_controller_assignments(
+    int32 bus_index) {
+    uint64_t generation;
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_.midi_controller_assignments.contains(
+                bus_index)) {
+            return;
+        }
+
+        generation = function_result_cache_generation_;
+    }
+
+    YaMidiMapping::GetAllMidiControllerAssignmentsResponse response =
+        bridge_.send_message(YaMidiMapping::GetAllMidiControllerAssignments{
+            .instance_id = instance_id(), .bus_index = bus_index});
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (function_result_cache_generation_ == generation) {
+        function_result_cache_.midi_controller_assignments[bus_index] =
+            std::move(response);
+    }
+}
+
+YaEditController::GetAllParameterInfosResponse
+Vst3PluginProxyImpl::fetch_all_parameter_infos() {
+    const auto request =
+        YaEditController::GetAllParameterInfos{.instance_id = instance_id()};
+    if (!parameter_metadata_cache_ ||
+        parameter_metadata_cache_consulted_.exchange(true)) {
+        return bridge_.send_message(request);
+    }
+
+    // The parameter count is almost always cached, so this is a cheap way to
+    // detect stale metadata that the cache key didn't catch
+    const size_t parameter_count =
+        static_cast<size_t>(std::max(getParameterCount(), 0));
+    if (auto cached_response =
+            parameter_metadata_cache_
+                ->read<YaEditController::GetAllParameterInfosResponse>();
+        cached_response && cached_response->infos.size() == parameter_count) {
+        return std::move(*cached_response);
+    }
+
+    const YaEditController::GetAllParameterInfosResponse response =
+        bridge_.send_message(request);
+    parameter_metadata_cache_->write(response);
+
+    return response;
+}
+
+void Vst3PluginProxyImpl::update_parameter_value(
+    Steinberg::Vst::ParamID id,
+    Steinberg::Vst::ParamValue value) noexcept {
+    std::lock_guard lock(parameter_values_mutex_);
+    if (parameter_values_) {
+        (*parameter_values_)[id] = value;
+    }
+}
+
+void Vst3PluginProxyImpl::clear_parameter_values() noexcept {
+    std::lock_guard lock(parameter_values_mutex_);
+    parameter_values_.reset();
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::setAudioPresentationLatencySamples(
@@ -109,50 +321,165 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setBusArrangements(
     int32 numIns,
     Steinberg::Vst::SpeakerArrangement* outputs,
     int32 numOuts) {
-    clear_bus_cache();
-
     // NOTE: Ardour passes a null pointer when `numIns` or `numOuts` is 0, so we
     //       need to work around that
-    return bridge_.send_audio_processor_message(
-        YaAudioProcessor::SetBusArrangements{
-            .instance_id = instance_id(),
-            .inputs =
-                (inputs ? std::vector<Steinberg::Vst::SpeakerArrangement>(
-                              inputs, &inputs[numIns])
-                        : std::vector<Steinberg::Vst::SpeakerArrangement>()),
-            .num_ins = numIns,
-            .outputs =
-                (outputs ? std::vector<Steinberg::Vst::SpeakerArrangement>(
-                               outputs, &outputs[numOuts])
-                         : std::vector<Steinberg::Vst::SpeakerArrangement>()),
-            .num_outs = numOuts,
-        });
+    const YaAudioProcessor::SetBusArrangements request{
+        .instance_id = instance_id(),
+        .inputs = (inputs ? std::vector<Steinberg::Vst::SpeakerArrangement>(
+                                inputs, &inputs[numIns])
+                          : std::vector<Steinberg::Vst::SpeakerArrangement>()),
+        .num_ins = numIns,
+        .outputs =
+            (outputs ? std::vector<Steinberg::Vst::SpeakerArrangement>(
+                           outputs, &outputs[numOuts])
+                     : std::vector<Steinberg::Vst::SpeakerArrangement>()),
+        .num_outs = numOuts,
+    };
+
+    if (bridge_.config().speaker_arrangement_cache) {
+        const Vst3PluginBridge::BusArrangements arrangements{request.inputs,
+                                                             request.outputs};
+
+        std::optional<tresult> cached_result;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_.accepted_bus_arrangements ==
+                arrangements) {
+                cached_result = Steinberg::kResultTrue;
+            }
+        }
+        // NOTE: The VST3 specification allows plugins to adapt to the nearest
+        //       supported arrangement when they reject one. We'll skip that
+        //       here, so the host will see the instance's current
+        //       arrangement when it calls `getBusArrangement()` afterwards.
+        if (!cached_result &&
+            bridge_.bus_arrangements_rejected(class_id_, arrangements)) {
+            cached_result = Steinberg::kResultFalse;
+        }
+
+        if (cached_result) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(
+                    true, UniversalTResult(*cached_result), true);
+            }
+
+            return *cached_result;
+        }
+    }
+
+    clear_bus_cache();
+    const tresult result = bridge_.send_audio_processor_message(request);
+
+    if (bridge_.config().speaker_arrangement_cache) {
+        Vst3PluginBridge::BusArrangements arrangements{request.inputs,
+                                                       request.outputs};
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (result == Steinberg::kResultTrue) {
+                function_result_cache_.accepted_bus_arrangements =
+                    arrangements;
+            } else {
+                function_result_cache_.accepted_bus_arrangements.reset();
+            }
+        }
+        if (result == Steinberg::kResultFalse) {
+            bridge_.remember_rejected_bus_arrangements(class_id_,
+                                                       std::move(arrangements));
+        }
+    }
+
+    // From now on we'll only share bus information with other instances that
+    // were given the same speaker arrangements
+    {
+        std::lock_guard lock(shared_bus_cache_key_mutex_);
+        if (shared_bus_cache_key_) {
+            std::get<1>(*shared_bus_cache_key_) = request.inputs;
+            std::get<2>(*shared_bus_cache_key_) = request.outputs;
+        }
+    }
+
+    return result;
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getBusArrangement(
     Steinberg::Vst::BusDirection dir,
     int32 index,
     Steinberg::Vst::SpeakerArrangement& arr) {
+    const auto request = YaAudioProcessor::GetBusArrangement{
+        .instance_id = instance_id(), .dir = dir, .index = index};
+
+    const std::tuple<Steinberg::Vst::BusDirection, int32> args{dir, index};
+    std::optional<Steinberg::Vst::SpeakerArrangement> cached_arr;
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        if (auto it = cache.bus_arrangements.find(args);
+            it != cache.bus_arrangements.end()) {
+            cached_arr = it->second;
+        }
+    });
+    if (cached_arr) {
+        const bool log_response = bridge_.logger_.log_request(true, request);
+        if (log_response) {
+            bridge_.logger_.log_response(
+                true,
+                YaAudioProcessor::GetBusArrangement::Response{
+                    .result = Steinberg::kResultOk, .arr = *cached_arr},
+                true);
+        }
+
+        arr = *cached_arr;
+
+        return Steinberg::kResultOk;
+    }
+
     const GetBusArrangementResponse response =
-        bridge_.send_audio_processor_message(
-            YaAudioProcessor::GetBusArrangement{
-                .instance_id = instance_id(), .dir = dir, .index = index});
+        bridge_.send_audio_processor_message(request);
 
     arr = response.arr;
 
+    if (response.result == Steinberg::kResultOk) {
+        with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+            cache.bus_arrangements[args] = response.arr;
+        });
+    }
+
     return response.result;
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::canProcessSampleSize(int32 symbolicSampleSize) {
+    const tresult result = plugin_can_process_sample_size(symbolicSampleSize);
+
+    // If the plugin only supports the other precision, then we can convert the
+    // audio on the shared memory copy we already make during `process()`. That
+    // way hosts don't have to reject the plugin or do their own conversion.
+    if (result != Steinberg::kResultTrue &&
+        (symbolicSampleSize == Steinberg::Vst::kSample32 ||
+         symbolicSampleSize == Steinberg::Vst::kSample64)) {
+        const int32 other_sample_size =
+            symbolicSampleSize == Steinberg::Vst::kSample32
+                ? Steinberg::Vst::kSample64
+                : Steinberg::Vst::kSample32;
+        if (plugin_can_process_sample_size(other_sample_size) ==
+            Steinberg::kResultTrue) {
+            return Steinberg::kResultTrue;
+        }
+    }
+
+    return result;
+}
+
+tresult Vst3PluginProxyImpl::plugin_can_process_sample_size(
+    int32 symbolic_sample_size) {
     const auto request = YaAudioProcessor::CanProcessSampleSize{
         .instance_id = instance_id(),
-        .symbolic_sample_size = symbolicSampleSize};
+        .symbolic_sample_size = symbolic_sample_size};
 
     {
         std::lock_guard lock(function_result_cache_mutex_);
         if (auto it = function_result_cache_.can_process_sample_size.find(
-                symbolicSampleSize);
+                symbolic_sample_size);
             it != function_result_cache_.can_process_sample_size.end()) {
             const bool log_response =
                 bridge_.logger_.log_request(true, request);
@@ -172,7 +499,7 @@ Vst3PluginProxyImpl::canProcessSampleSize(int32 symbolicSampleSize) {
 
     {
         std::lock_guard lock(function_result_cache_mutex_);
-        function_result_cache_.can_process_sample_size[symbolicSampleSize] =
+        function_result_cache_.can_process_sample_size[symbolic_sample_size] =
             result;
     }
 
@@ -180,15 +507,77 @@ Vst3PluginProxyImpl::canProcessSampleSize(int32 symbolicSampleSize) {
 }
 
 uint32 PLUGIN_API Vst3PluginProxyImpl::getLatencySamples() {
-    return bridge_.send_audio_processor_message(
-        YaAudioProcessor::GetLatencySamples{.instance_id = instance_id()});
+    const auto request =
+        YaAudioProcessor::GetLatencySamples{.instance_id = instance_id()};
+
+    std::optional<uint32> cached_latency;
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        cached_latency = cache.latency_samples;
+    });
+    if (cached_latency) {
+        const bool log_response = bridge_.logger_.log_request(true, request);
+        if (log_response) {
+            bridge_.logger_.log_response(
+                true,
+                YaAudioProcessor::GetLatencySamples::Response(*cached_latency),
+                true);
+        }
+
+        return *cached_latency;
+    }
+
+    const uint32 latency = bridge_.send_audio_processor_message(request);
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        cache.latency_samples = latency;
+    });
+
+    return latency;
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::setupProcessing(Steinberg::Vst::ProcessSetup& setup) {
+    // The Wine plugin host preallocates the output parameter changes and
+    // events based on the plugin's parameter count, and we'll do the same on
+    // this side since we'll be deserializing those outputs into this object
+    process_request_.data.reserve_outputs(
+        YaEditController::supported()
+            ? static_cast<size_t>(std::max(getParameterCount(), 0))
+            : 0);
+    sample_rate_ = setup.sampleRate;
+
+    // We only need to send the process context fields the plugin asked for.
+    // This is usually answered from the cached instance summary.
+    process_request_.data.set_process_context_requirements(
+        YaProcessContextRequirements::supported()
+            ? std::optional<uint32>(getProcessContextRequirements())
+            : std::nullopt);
+    process_request_.data.set_automation_thinning_tolerance(
+        bridge_.config().vst3_automation_thinning);
+    process_request_.data.set_skip_silent_inputs(
+        bridge_.config().vst3_skip_silent_inputs);
+
+    // If the plugin doesn't support the host's precision, then we'll set the
+    // plugin up with the other precision and convert the audio during
+    // `process()`. We advertise this in `canProcessSampleSize()`.
+    Steinberg::Vst::ProcessSetup plugin_setup = setup;
+    std::optional<int32> plugin_sample_size;
+    if (plugin_can_process_sample_size(setup.symbolicSampleSize) !=
+        Steinberg::kResultTrue) {
+        const int32 other_sample_size =
+            setup.symbolicSampleSize == Steinberg::Vst::kSample64
+                ? Steinberg::Vst::kSample32
+                : Steinberg::Vst::kSample64;
+        if (plugin_can_process_sample_size(other_sample_size) ==
+            Steinberg::kResultTrue) {
+            plugin_setup.symbolicSampleSize = other_sample_size;
+            plugin_sample_size = other_sample_size;
+        }
+    }
+    process_request_.data.set_plugin_sample_size(plugin_sample_size);
+
     return bridge_.send_audio_processor_message(
         YaAudioProcessor::SetupProcessing{.instance_id = instance_id(),
-                                          .setup = setup});
+                                          .setup = plugin_setup});
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::setProcessing(TBool state) {
@@ -196,13 +585,14 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setProcessing(TBool state) {
     // every processing cycle. Because this really adds up in terms of latency
     // we sadly have to deviate from yabridge's principles and implement a
     // cache. We keep this in because it can still help performance a little in
-    // some DAWs.
-    {
+    // some DAWs. Hosts like Ableton Live toggle processing whenever a track
+    // gets muted, so the cache is kept when processing stops. Everything that
+    // could change the bus layout, like reactivating the plugin, still clears
+    // it.
+    if (state) {
         std::lock_guard lock(processing_bus_cache_mutex_);
-        if (state) {
+        if (!processing_bus_cache_) {
             processing_bus_cache_.emplace();
-        } else {
-            processing_bus_cache_.reset();
         }
     }
 
@@ -212,15 +602,8 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setProcessing(TBool state) {
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
-    // We'll synchronize the scheduling priority of the audio thread on the Wine
-    // plugin host with that of the host's audio thread every once in a while
-    std::optional<int> new_realtime_priority = std::nullopt;
-    time_t now = time(nullptr);
-    if (now > last_audio_thread_priority_synchronization_ +
-                  audio_thread_priority_synchronization_interval) {
-        new_realtime_priority = get_realtime_priority();
-        last_audio_thread_priority_synchronization_ = now;
-    }
+    YABRIDGE_PROBE(process_begin, data.numSamples);
+    const auto process_start = std::chrono::steady_clock::now();
 
     // We reuse this existing object to avoid allocations.
     // `YaProcessData::repopulate()` will write the input audio to the shared
@@ -228,7 +611,35 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
     assert(process_buffers_);
     process_request_.instance_id = instance_id();
     process_request_.data.repopulate(data, *process_buffers_);
-    process_request_.new_realtime_priority = new_realtime_priority;
+
+    // We'll synchronize the scheduling priority of the audio thread on the Wine
+    // plugin host with that of the host's audio thread whenever it changes
+    process_request_.new_realtime_priority = take_if_changed(
+        get_realtime_priority(), last_synchronized_realtime_priority_);
+    process_request_.host_audio_thread_cpu =
+        bridge_.config().follows_host_audio_thread_cpu()
+            ? take_if_changed(get_current_cpu(),
+                              last_synchronized_host_audio_thread_cpu_)
+            : std::nullopt;
+    process_request_.host_audio_thread_numa_node =
+        bridge_.config().audio_thread_follow_host_numa_node
+            ? take_if_changed(get_current_numa_node(),
+                              last_synchronized_host_audio_thread_numa_node_)
+            : std::nullopt;
+    process_request_.host_thread_id =
+        bridge_.config().audio_thread_host_mapping
+            ? std::optional(get_current_thread_id())
+            : std::nullopt;
+
+    // The process data will be written directly to the shared memory object if
+    // it fits, so the socket only has to carry the instance ID. When logging
+    // all events we'll keep sending everything over the socket so the Wine
+    // plugin host can log the request.
+    process_request_.data_in_shm =
+        bridge_.logger_.logger_.verbosity_ < Logger::Verbosity::all_events &&
+        write_shm_object(*process_buffers_,
+                         AudioShmBuffer::MetadataRegion::request,
+                         process_request_.data);
 
     // HACK: This is a bit ugly. This `YaProcessData::Response` object actually
     //       contains pointers to the corresponding `YaProcessData` fields in
@@ -246,9 +657,16 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
 
     // We'll also receive the response into an existing object so we can also
     // avoid heap allocations there
+    const auto request_sent = std::chrono::steady_clock::now();
     bridge_.receive_audio_processor_message_into(
         MessageReference<YaAudioProcessor::Process>(process_request_),
         process_response_);
+    if (process_response_.output_data_in_shm) {
+        read_shm_object(*process_buffers_,
+                        AudioShmBuffer::MetadataRegion::response,
+                        process_response_.output_data);
+    }
+    const auto response_received = std::chrono::steady_clock::now();
 
     // At this point the shared audio buffers should contain the output audio,
     // so we'll write that back to the host along with any metadata (which in
@@ -256,12 +674,53 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
     // changes and events
     process_request_.data.write_back_outputs(data, *process_buffers_);
 
+    // Together with the time spent in the plugin recorded by the Wine plugin
+    // host, this tells us how much overhead yabridge adds
+    const auto process_end = std::chrono::steady_clock::now();
+    process_buffers_->record_total_time(process_end - process_start);
+    YABRIDGE_PROBE(process_end, data.numSamples);
+
+    // The request is sent and its response is read in a single call, so the
+    // Wine wakeup time here also includes writing the request to the socket
+    if (bridge_.config().audio_deadline_warning) {
+        deadline_monitor_.check(
+            bridge_.logger_.logger_, *bridge_.config().audio_deadline_warning,
+            sample_rate_, data.numSamples, *process_buffers_,
+            ProcessDeadlineMonitor::BlockTimes{
+                .start = process_start,
+                .sent = request_sent,
+                .response_received = response_received,
+                .end = process_end});
+    }
+
     return process_response_.result;
 }
 
 uint32 PLUGIN_API Vst3PluginProxyImpl::getTailSamples() {
-    return bridge_.send_audio_processor_message(
-        YaAudioProcessor::GetTailSamples{.instance_id = instance_id()});
+    const auto request =
+        YaAudioProcessor::GetTailSamples{.instance_id = instance_id()};
+
+    std::optional<uint32> cached_tail;
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        cached_tail = cache.tail_samples;
+    });
+    if (cached_tail) {
+        const bool log_response = bridge_.logger_.log_request(true, request);
+        if (log_response) {
+            bridge_.logger_.log_response(
+                true, YaAudioProcessor::GetTailSamples::Response(*cached_tail),
+                true);
+        }
+
+        return *cached_tail;
+    }
+
+    const uint32 tail = bridge_.send_audio_processor_message(request);
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        cache.tail_samples = tail;
+    });
+
+    return tail;
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::setAutomationState(int32 state) {
@@ -320,6 +779,22 @@ Vst3PluginProxyImpl::getBusCount(Steinberg::Vst::MediaType type,
         }
     }
 
+    std::optional<int32> cached_count;
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        if (auto it = cache.bus_count.find(args); it != cache.bus_count.end()) {
+            cached_count = it->second;
+        }
+    });
+    if (cached_count) {
+        const bool log_response = bridge_.logger_.log_request(true, request);
+        if (log_response) {
+            bridge_.logger_.log_response(
+                true, YaComponent::GetBusCount::Response(*cached_count), true);
+        }
+
+        return *cached_count;
+    }
+
     const int32 result = bridge_.send_audio_processor_message(request);
 
     {
@@ -328,6 +803,9 @@ Vst3PluginProxyImpl::getBusCount(Steinberg::Vst::MediaType type,
             processing_bus_cache_->bus_count[args] = result;
         }
     }
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        cache.bus_count[args] = result;
+    });
 
     return result;
 }
@@ -364,6 +842,27 @@ Vst3PluginProxyImpl::getBusInfo(Steinberg::Vst::MediaType type,
         }
     }
 
+    std::optional<Steinberg::Vst::BusInfo> cached_bus;
+    with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+        if (auto it = cache.bus_info.find(args); it != cache.bus_info.end()) {
+            cached_bus = it->second;
+        }
+    });
+    if (cached_bus) {
+        const bool log_response = bridge_.logger_.log_request(true, request);
+        if (log_response) {
+            bridge_.logger_.log_response(
+                true,
+                YaComponent::GetBusInfo::Response{
+                    .result = Steinberg::kResultOk, .bus = *cached_bus},
+                true);
+        }
+
+        bus = *cached_bus;
+
+        return Steinberg::kResultOk;
+    }
+
     const GetBusInfoResponse response =
         bridge_.send_audio_processor_message(request);
 
@@ -375,6 +874,11 @@ Vst3PluginProxyImpl::getBusInfo(Steinberg::Vst::MediaType type,
             processing_bus_cache_->bus_info[args] = response.bus;
         }
     }
+    if (response.result == Steinberg::kResultOk) {
+        with_shared_bus_cache([&](Vst3PluginBridge::SharedBusCache& cache) {
+            cache.bus_info[args] = response.bus;
+        });
+    }
 
     return response.result;
 }
@@ -441,9 +945,14 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setState(Steinberg::IBStream* state) {
         //       GUI thread. So if the GUI is active, we'll use the mutual
         //       recursion mechanism to allow this resize call to also be
         //       performed from the GUI thread.
-        return bridge_.send_mutually_recursive_message(
+        const tresult result = bridge_.send_mutually_recursive_message(
             Vst3PluginProxy::SetState{.instance_id = instance_id(),
                                       .state = state});
+
+        // Restoring the state will have changed the plugin's parameter values
+        clear_parameter_values();
+
+        return result;
     } else {
         bridge_.logger_.log(
             "WARNING: Null pointer passed to "
@@ -612,8 +1121,12 @@ Vst3PluginProxyImpl::notify(Steinberg::Vst::IMessage* message) {
 tresult PLUGIN_API
 Vst3PluginProxyImpl::setComponentState(Steinberg::IBStream* state) {
     if (state) {
-        return bridge_.send_message(YaEditController::SetComponentState{
-            .instance_id = instance_id(), .state = state});
+        const tresult result =
+            bridge_.send_message(YaEditController::SetComponentState{
+                .instance_id = instance_id(), .state = state});
+        clear_parameter_values();
+
+        return result;
     } else {
         bridge_.logger_.log(
             "WARNING: Null pointer passed to "
@@ -659,6 +1172,30 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getParameterInfo(
     const auto request = YaEditController::GetParameterInfo{
         .instance_id = instance_id(), .param_index = paramIndex};
 
+    // Hosts usually enumerate all parameters right after initializing the
+    // plugin, so instead of doing one round trip per parameter we'll fetch all
+    // of them in one go the first time this function is called. The lock is
+    // not held while sending the message since the plugin may call
+    // `IComponentHandler::restartComponent()` in the meantime.
+    bool should_prefetch;
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        should_prefetch = !function_result_cache_.parameter_info_prefetched;
+    }
+    if (should_prefetch) {
+        const YaEditController::GetAllParameterInfosResponse response =
+            fetch_all_parameter_infos();
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        for (size_t i = 0; i < response.infos.size(); i++) {
+            if (response.infos[i].result == Steinberg::kResultOk) {
+                function_result_cache_.parameter_info[static_cast<int32>(i)] =
+                    response.infos[i].info;
+            }
+        }
+        function_result_cache_.parameter_info_prefetched = true;
+    }
+
     {
         std::lock_guard lock(function_result_cache_mutex_);
         if (auto it = function_result_cache_.parameter_info.find(paramIndex);
@@ -754,15 +1291,77 @@ Vst3PluginProxyImpl::plainParamToNormalized(
 
 Steinberg::Vst::ParamValue PLUGIN_API
 Vst3PluginProxyImpl::getParamNormalized(Steinberg::Vst::ParamID id) {
-    return bridge_.send_message(YaEditController::GetParamNormalized{
-        .instance_id = instance_id(), .id = id});
+    const auto request = YaEditController::GetParamNormalized{
+        .instance_id = instance_id(), .id = id};
+    if (!bridge_.config().vst3_parameter_value_cache) {
+        return bridge_.send_message(request);
+    }
+
+    // The values are fetched without holding the lock since the plugin may
+    // call `IComponentHandler::performEdit()` in the meantime
+    bool should_fetch;
+    {
+        std::lock_guard lock(parameter_values_mutex_);
+        should_fetch = !parameter_values_;
+    }
+    if (should_fetch) {
+        const YaEditController::GetAllParamNormalizedResponse response =
+            bridge_.send_message(YaEditController::GetAllParamNormalized{
+                .instance_id = instance_id()});
+
+        std::unordered_map<Steinberg::Vst::ParamID, Steinberg::Vst::ParamValue>
+            values;
+        for (const auto& [param_id, value] : response.values) {
+            values[param_id] = value;
+        }
+
+        std::lock_guard lock(parameter_values_mutex_);
+        parameter_values_ = std::move(values);
+    }
+
+    {
+        std::lock_guard lock(parameter_values_mutex_);
+        if (parameter_values_) {
+            if (const auto it = parameter_values_->find(id);
+                it != parameter_values_->end()) {
+                const bool log_response =
+                    bridge_.logger_.log_request(true, request);
+                if (log_response) {
+                    bridge_.logger_.log_response(
+                        true,
+                        YaEditController::GetParamNormalized::Response(
+                            it->second),
+                        true);
+                }
+
+                return it->second;
+            }
+        }
+    }
+
+    const Steinberg::Vst::ParamValue value = bridge_.send_message(request);
+    update_parameter_value(id, value);
+
+    return value;
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::setParamNormalized(Steinberg::Vst::ParamID id,
                                         Steinberg::Vst::ParamValue value) {
-    return bridge_.send_message(YaEditController::SetParamNormalized{
-        .instance_id = instance_id(), .id = id, .value = value});
+    const tresult result =
+        bridge_.send_message(YaEditController::SetParamNormalized{
+            .instance_id = instance_id(), .id = id, .value = value});
+
+    // The plugin may quantize or clamp the value, so we can't just store the
+    // value the host passed to us
+    if (bridge_.config().vst3_parameter_value_cache) {
+        std::lock_guard lock(parameter_values_mutex_);
+        if (parameter_values_) {
+            parameter_values_->erase(id);
+        }
+    }
+
+    return result;
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::setComponentHandler(
@@ -885,10 +1484,32 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setChannelContextInfos(
 
 int32 PLUGIN_API Vst3PluginProxyImpl::getKeyswitchCount(int32 busIndex,
                                                         int16 channel) {
-    return bridge_.send_message(
+    const auto request =
         YaKeyswitchController::GetKeyswitchCount{.instance_id = instance_id(),
                                                  .bus_index = busIndex,
-                                                 .channel = channel});
+                                                 .channel = channel};
+
+    prefetch_keyswitch_infos(busIndex, channel);
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (auto it = function_result_cache_.keyswitch_infos.find(
+                std::tuple(busIndex, channel));
+            it != function_result_cache_.keyswitch_infos.end()) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(
+                    true,
+                    YaKeyswitchController::GetKeyswitchCount::Response(
+                        it->second.count),
+                    true);
+            }
+
+            return it->second.count;
+        }
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getKeyswitchInfo(
@@ -896,12 +1517,36 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getKeyswitchInfo(
     int16 channel,
     int32 keySwitchIndex,
     Steinberg::Vst::KeyswitchInfo& info /*out*/) {
-    const GetKeyswitchInfoResponse response =
-        bridge_.send_message(YaKeyswitchController::GetKeyswitchInfo{
-            .instance_id = instance_id(),
-            .bus_index = busIndex,
-            .channel = channel,
-            .key_switch_index = keySwitchIndex});
+    const auto request =
+        YaKeyswitchController::GetKeyswitchInfo{.instance_id = instance_id(),
+                                                .bus_index = busIndex,
+                                                .channel = channel,
+                                                .key_switch_index =
+                                                    keySwitchIndex};
+
+    prefetch_keyswitch_infos(busIndex, channel);
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (auto it = function_result_cache_.keyswitch_infos.find(
+                std::tuple(busIndex, channel));
+            it != function_result_cache_.keyswitch_infos.end() &&
+            keySwitchIndex >= 0 &&
+            static_cast<size_t>(keySwitchIndex) < it->second.infos.size()) {
+            const GetKeyswitchInfoResponse& response =
+                it->second.infos[keySwitchIndex];
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, response, true);
+            }
+
+            info = response.info;
+
+            return response.result;
+        }
+    }
+
+    const GetKeyswitchInfoResponse response = bridge_.send_message(request);
 
     info = response.info;
 
@@ -924,12 +1569,44 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getMidiControllerAssignment(
     int16 channel,
     Steinberg::Vst::CtrlNumber midiControllerNumber,
     Steinberg::Vst::ParamID& id /*out*/) {
+    const auto request = YaMidiMapping::GetMidiControllerAssignment{
+        .instance_id = instance_id(),
+        .bus_index = busIndex,
+        .channel = channel,
+        .midi_controller_number = midiControllerNumber};
+
+    // Anything outside of the prefetched table is still sent to the plugin
+    if (channel >= 0 && channel < YaMidiMapping::num_midi_channels &&
+        midiControllerNumber >= 0 &&
+        midiControllerNumber < Steinberg::Vst::kCountCtrlNumber) {
+        prefetch_midi_controller_assignments(busIndex);
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (auto it =
+                function_result_cache_.midi_controller_assignments.find(
+                    busIndex);
+            it != function_result_cache_.midi_controller_assignments.end() &&
+            it->second.assignments.size() ==
+                static_cast<size_t>(YaMidiMapping::num_midi_channels *
+                                    Steinberg::Vst::kCountCtrlNumber)) {
+            const GetMidiControllerAssignmentResponse& response =
+                it->second.assignments[(channel *
+                                        Steinberg::Vst::kCountCtrlNumber) +
+                                       midiControllerNumber];
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, response, true);
+            }
+
+            id = response.id;
+
+            return response.result;
+        }
+    }
+
     const GetMidiControllerAssignmentResponse response =
-        bridge_.send_message(YaMidiMapping::GetMidiControllerAssignment{
-            .instance_id = instance_id(),
-            .bus_index = busIndex,
-            .channel = channel,
-            .midi_controller_number = midiControllerNumber});
+        bridge_.send_message(request);
 
     id = response.id;
 
@@ -938,11 +1615,32 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getMidiControllerAssignment(
 
 int32 PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionCount(int32 busIndex,
                                                              int16 channel) {
-    return bridge_.send_message(
-        YaNoteExpressionController::GetNoteExpressionCount{
-            .instance_id = instance_id(),
-            .bus_index = busIndex,
-            .channel = channel});
+    const auto request = YaNoteExpressionController::GetNoteExpressionCount{
+        .instance_id = instance_id(),
+        .bus_index = busIndex,
+        .channel = channel};
+
+    prefetch_note_expression_infos(busIndex, channel);
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (auto it = function_result_cache_.note_expression_infos.find(
+                std::tuple(busIndex, channel));
+            it != function_result_cache_.note_expression_infos.end()) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(
+                    true,
+                    YaNoteExpressionController::GetNoteExpressionCount::
+                        Response(it->second.count),
+                    true);
+            }
+
+            return it->second.count;
+        }
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionInfo(
@@ -950,12 +1648,37 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionInfo(
     int16 channel,
     int32 noteExpressionIndex,
     Steinberg::Vst::NoteExpressionTypeInfo& info /*out*/) {
+    const auto request = YaNoteExpressionController::GetNoteExpressionInfo{
+        .instance_id = instance_id(),
+        .bus_index = busIndex,
+        .channel = channel,
+        .note_expression_index = noteExpressionIndex};
+
+    prefetch_note_expression_infos(busIndex, channel);
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (auto it = function_result_cache_.note_expression_infos.find(
+                std::tuple(busIndex, channel));
+            it != function_result_cache_.note_expression_infos.end() &&
+            noteExpressionIndex >= 0 &&
+            static_cast<size_t>(noteExpressionIndex) <
+                it->second.infos.size()) {
+            const GetNoteExpressionInfoResponse& response =
+                it->second.infos[noteExpressionIndex];
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, response, true);
+            }
+
+            info = response.info;
+
+            return response.result;
+        }
+    }
+
     const GetNoteExpressionInfoResponse response =
-        bridge_.send_message(YaNoteExpressionController::GetNoteExpressionInfo{
-            .instance_id = instance_id(),
-            .bus_index = busIndex,
-            .channel = channel,
-            .note_expression_index = noteExpressionIndex});
+        bridge_.send_message(request);
 
     info = response.info;
 
@@ -1038,12 +1761,46 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getParameterIDFromFunctionName(
     Steinberg::FIDString functionName,
     Steinberg::Vst::ParamID& paramID) {
     if (functionName) {
+        const auto request =
+            YaParameterFunctionName::GetParameterIDFromFunctionName{
+                .instance_id = instance_id(),
+                .unit_id = unitID,
+                .function_name = functionName};
+        const auto key = std::tuple(request.unit_id, request.function_name);
+
+        // These mappings are fixed for a plugin build, so they're shared
+        // between all instances of the same class
+        if (const std::optional<GetParameterIDFromFunctionNameResponse>
+                cached = bridge_.with_class_representation_cache(
+                    class_id_,
+                    [&](Vst3PluginBridge::ClassRepresentationCache& cache)
+                        -> std::optional<
+                            GetParameterIDFromFunctionNameResponse> {
+                        if (const auto it =
+                                cache.parameter_ids_by_function_name.find(key);
+                            it != cache.parameter_ids_by_function_name.end()) {
+                            return it->second;
+                        } else {
+                            return std::nullopt;
+                        }
+                    })) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, *cached, true);
+            }
+
+            paramID = cached->param_id;
+
+            return cached->result;
+        }
+
         const GetParameterIDFromFunctionNameResponse response =
-            bridge_.send_message(
-                YaParameterFunctionName::GetParameterIDFromFunctionName{
-                    .instance_id = instance_id(),
-                    .unit_id = unitID,
-                    .function_name = functionName});
+            bridge_.send_message(request);
+        bridge_.with_class_representation_cache(
+            class_id_, [&](Vst3PluginBridge::ClassRepresentationCache& cache) {
+                cache.parameter_ids_by_function_name[key] = response;
+            });
 
         paramID = response.param_id;
 
@@ -1072,7 +1829,7 @@ tresult PLUGIN_API Vst3PluginProxyImpl::initialize(FUnknown* context) {
         InitializeResponse response =
             bridge_.send_message(Vst3PluginProxy::Initialize{
                 .instance_id = instance_id(),
-                .host_context_args = Vst3HostContextProxy::ConstructArgs(
+                .host_context_args = bridge_.create_host_context_args(
                     host_context_, instance_id())});
 
         // HACK: For some reason, Waves plugins will only allow querying the
@@ -1081,6 +1838,10 @@ tresult PLUGIN_API Vst3PluginProxyImpl::initialize(FUnknown* context) {
         update_supported_interfaces(
             std::move(response.updated_plugin_interfaces));
 
+        if (response.summary) {
+            apply_instance_summary(*response.summary);
+        }
+
         return response.result;
     } else {
         bridge_.logger_.log(
@@ -1107,9 +1868,30 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getPrefetchableSupport(
 }
 
 uint32 PLUGIN_API Vst3PluginProxyImpl::getProcessContextRequirements() {
-    return bridge_.send_message(
+    const auto request =
         YaProcessContextRequirements::GetProcessContextRequirements{
-            .instance_id = instance_id()});
+            .instance_id = instance_id()};
+
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_.process_context_requirements) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(
+                    true,
+                    YaProcessContextRequirements::
+                        GetProcessContextRequirements::Response(
+                            *function_result_cache_
+                                 .process_context_requirements),
+                    true);
+            }
+
+            return *function_result_cache_.process_context_requirements;
+        }
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::programDataSupported(
@@ -1195,17 +1977,60 @@ Vst3PluginProxyImpl::setUnitData(Steinberg::Vst::UnitID unitId,
     }
 }
 
+// Hosts that show preset browsers enumerate every program of every program
+// list, so the first call to any of the functions below fetches all units and
+// program lists at once. Anything the cache can't answer, like out of bounds
+// indices, is still sent to the plugin.
+
 int32 PLUGIN_API Vst3PluginProxyImpl::getUnitCount() {
-    return bridge_.send_message(
-        YaUnitInfo::GetUnitCount{.instance_id = instance_id()});
+    const auto request = YaUnitInfo::GetUnitCount{.instance_id = instance_id()};
+
+    prefetch_units_and_program_lists();
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (const auto& cache =
+                function_result_cache_.units_and_program_lists) {
+            const auto result = static_cast<int32>(cache->units.size());
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(
+                    true, YaUnitInfo::GetUnitCount::Response(result), true);
+            }
+
+            return result;
+        }
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::getUnitInfo(int32 unitIndex,
                                  Steinberg::Vst::UnitInfo& info /*out*/) {
-    const GetUnitInfoResponse response =
-        bridge_.send_message(YaUnitInfo::GetUnitInfo{
-            .instance_id = instance_id(), .unit_index = unitIndex});
+    const auto request = YaUnitInfo::GetUnitInfo{.instance_id = instance_id(),
+                                                 .unit_index = unitIndex};
+
+    prefetch_units_and_program_lists();
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (const auto& cache = function_result_cache_.units_and_program_lists;
+            cache && unitIndex >= 0 &&
+            static_cast<size_t>(unitIndex) < cache->units.size()) {
+            const GetUnitInfoResponse& response = cache->units[unitIndex];
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, response, true);
+            }
+
+            info = response.info;
+
+            return response.result;
+        }
+    }
+
+    const GetUnitInfoResponse response = bridge_.send_message(request);
 
     info = response.info;
 
@@ -1213,16 +2038,57 @@ Vst3PluginProxyImpl::getUnitInfo(int32 unitIndex,
 }
 
 int32 PLUGIN_API Vst3PluginProxyImpl::getProgramListCount() {
-    return bridge_.send_message(
-        YaUnitInfo::GetProgramListCount{.instance_id = instance_id()});
+    const auto request =
+        YaUnitInfo::GetProgramListCount{.instance_id = instance_id()};
+
+    prefetch_units_and_program_lists();
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (const auto& cache =
+                function_result_cache_.units_and_program_lists) {
+            const auto result = static_cast<int32>(cache->program_lists.size());
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(
+                    true, YaUnitInfo::GetProgramListCount::Response(result),
+                    true);
+            }
+
+            return result;
+        }
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getProgramListInfo(
     int32 listIndex,
     Steinberg::Vst::ProgramListInfo& info /*out*/) {
-    const GetProgramListInfoResponse response =
-        bridge_.send_message(YaUnitInfo::GetProgramListInfo{
-            .instance_id = instance_id(), .list_index = listIndex});
+    const auto request = YaUnitInfo::GetProgramListInfo{
+        .instance_id = instance_id(), .list_index = listIndex};
+
+    prefetch_units_and_program_lists();
+    {
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (const auto& cache = function_result_cache_.units_and_program_lists;
+            cache && listIndex >= 0 &&
+            static_cast<size_t>(listIndex) < cache->program_lists.size()) {
+            const GetProgramListInfoResponse& response =
+                cache->program_lists[listIndex].list_info;
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, response, true);
+            }
+
+            info = response.info;
+
+            return response.result;
+        }
+    }
+
+    const GetProgramListInfoResponse response = bridge_.send_message(request);
 
     info = response.info;
 
@@ -1234,10 +2100,43 @@ Vst3PluginProxyImpl::getProgramName(Steinberg::Vst::ProgramListID listId,
                                     int32 programIndex,
                                     Steinberg::Vst::String128 name /*out*/) {
     if (name) {
-        const GetProgramNameResponse response = bridge_.send_message(
+        const auto request =
             YaUnitInfo::GetProgramName{.instance_id = instance_id(),
                                        .list_id = listId,
-                                       .program_index = programIndex});
+                                       .program_index = programIndex};
+
+        prefetch_units_and_program_lists();
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (const auto& cache =
+                    function_result_cache_.units_and_program_lists) {
+                for (const auto& program_list : cache->program_lists) {
+                    if (program_list.list_info.result != Steinberg::kResultOk ||
+                        program_list.list_info.info.id != listId ||
+                        programIndex < 0 ||
+                        static_cast<size_t>(programIndex) >=
+                            program_list.program_names.size()) {
+                        continue;
+                    }
+
+                    const GetProgramNameResponse& response =
+                        program_list.program_names[programIndex];
+                    const bool log_response =
+                        bridge_.logger_.log_request(true, request);
+                    if (log_response) {
+                        bridge_.logger_.log_response(true, response, true);
+                    }
+
+                    std::copy(response.name.begin(), response.name.end(),
+                              name);
+                    name[response.name.size()] = 0;
+
+                    return response.result;
+                }
+            }
+        }
+
+        const GetProgramNameResponse response = bridge_.send_message(request);
 
         std::copy(response.name.begin(), response.name.end(), name);
         name[response.name.size()] = 0;
@@ -1256,16 +2155,49 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getProgramInfo(
     Steinberg::Vst::CString attributeId /*in*/,
     Steinberg::Vst::String128 attributeValue /*out*/) {
     if (attributeId && attributeValue) {
-        const GetProgramInfoResponse response = bridge_.send_message(
+        const auto request =
             YaUnitInfo::GetProgramInfo{.instance_id = instance_id(),
                                        .list_id = listId,
                                        .program_index = programIndex,
-                                       .attribute_id = attributeId});
+                                       .attribute_id = attributeId};
+        const auto key =
+            std::tuple(listId, programIndex, request.attribute_id);
+
+        uint64_t generation;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (auto it = function_result_cache_.program_info.find(key);
+                it != function_result_cache_.program_info.end()) {
+                const GetProgramInfoResponse& response = it->second;
+                const bool log_response =
+                    bridge_.logger_.log_request(true, request);
+                if (log_response) {
+                    bridge_.logger_.log_response(true, response, true);
+                }
+
+                std::copy(response.attribute_value.begin(),
+                          response.attribute_value.end(), attributeValue);
+                attributeValue[response.attribute_value.size()] = 0;
+
+                return response.result;
+            }
+
+            generation = function_result_cache_generation_;
+        }
+
+        const GetProgramInfoResponse response = bridge_.send_message(request);
 
         std::copy(response.attribute_value.begin(),
                   response.attribute_value.end(), attributeValue);
         attributeValue[response.attribute_value.size()] = 0;
 
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_generation_ == generation) {
+                function_result_cache_.program_info[key] = response;
+            }
+        }
+
         return response.result;
     } else {
         bridge_.logger_.log(
@@ -1341,11 +2273,16 @@ Vst3PluginProxyImpl::setUnitProgramData(int32 listOrUnitId,
                                         int32 programIndex,
                                         Steinberg::IBStream* data) {
     if (data) {
-        return bridge_.send_message(
+        // Loading program data may rename programs, and not every plugin
+        // notifies the host about that
+        const tresult result = bridge_.send_message(
             YaUnitInfo::SetUnitProgramData{.instance_id = instance_id(),
                                            .list_or_unit_id = listOrUnitId,
                                            .program_index = programIndex,
                                            .data = data});
+        clear_unit_info_cache();
+
+        return result;
     } else {
         bridge_.logger_.log(
             "WARNING: Null pointer passed to "
@@ -1358,12 +2295,76 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getXmlRepresentationStream(
     Steinberg::Vst::RepresentationInfo& info /*in*/,
     Steinberg::IBStream* stream /*out*/) {
     if (stream) {
+        const auto request =
+            YaXmlRepresentationController::GetXmlRepresentationStream{
+                .instance_id = instance_id(), .info = info, .stream = stream};
+
+        // The XML representations are fixed for a plugin build, so they're
+        // shared between all instances of the same class. With the
+        // `parameter_metadata_cache` option they're also stored on disk.
+        const auto field = [](const auto& string) {
+            return std::string(string, strnlen(string, sizeof(string)));
+        };
+        const auto key = std::tuple(field(info.vendor), field(info.name),
+                                    field(info.version), field(info.host));
+        const auto find_cached = [&]() {
+            return bridge_.with_class_representation_cache(
+                class_id_,
+                [&](Vst3PluginBridge::ClassRepresentationCache& cache)
+                    -> std::optional<GetXmlRepresentationStreamResponse> {
+                    if (const auto it = cache.xml_representations.find(key);
+                        it != cache.xml_representations.end()) {
+                        return it->second;
+                    } else {
+                        return std::nullopt;
+                    }
+                });
+        };
+        const auto store_cached =
+            [&](const GetXmlRepresentationStreamResponse& response) {
+                bridge_.with_class_representation_cache(
+                    class_id_,
+                    [&](Vst3PluginBridge::ClassRepresentationCache& cache) {
+                        cache.xml_representations[key] = response;
+                    });
+            };
+
+        std::optional<ParameterMetadataCache> disk_cache;
+        if (bridge_.config().parameter_metadata_cache) {
+            disk_cache.emplace(bridge_.xml_representation_cache(
+                class_id_, std::get<0>(key) + "/" + std::get<1>(key) + "/" +
+                               std::get<2>(key) + "/" + std::get<3>(key)));
+        }
+
+        std::optional<GetXmlRepresentationStreamResponse> cached =
+            find_cached();
+        if (!cached && disk_cache) {
+            cached = disk_cache->read<GetXmlRepresentationStreamResponse>();
+            if (cached) {
+                store_cached(*cached);
+            }
+        }
+
+        if (cached) {
+            const bool log_response =
+                bridge_.logger_.log_request(true, request);
+            if (log_response) {
+                bridge_.logger_.log_response(true, *cached, true);
+            }
+
+            cached->stream.write_back(stream);
+
+            return cached->result;
+        }
+
         const GetXmlRepresentationStreamResponse response =
-            bridge_.send_message(
-                YaXmlRepresentationController::GetXmlRepresentationStream{
-                    .instance_id = instance_id(),
-                    .info = info,
-                    .stream = stream});
+            bridge_.send_message(request);
+        if (response.result == Steinberg::kResultOk) {
+            store_cached(response);
+            if (disk_cache) {
+                disk_cache->write(response);
+            }
+        }
 
         response.stream.write_back(stream);
 
@@ -1382,3 +2383,37 @@ void Vst3PluginProxyImpl::clear_bus_cache() noexcept {
         processing_bus_cache_.emplace();
     }
 }
+
+void Vst3PluginProxyImpl::apply_instance_summary(
+    const Vst3PluginProxy::InstanceSummary& summary) {
+    {
+        std::lock_guard lock(processing_bus_cache_mutex_);
+        BusInfoCache& bus_cache = processing_bus_cache_.emplace();
+        for (const auto& [type, dir, count] : summary.bus_counts) {
+            bus_cache.bus_count[{type, dir}] = count;
+        }
+        for (const auto& [type, dir, index, info] : summary.bus_infos) {
+            bus_cache.bus_info[{type, dir, index}] = info;
+        }
+    }
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (summary.parameter_infos) {
+        const auto& infos = summary.parameter_infos->infos;
+        function_result_cache_.parameter_count =
+            static_cast<int32>(infos.size());
+        for (size_t param_index = 0; param_index < infos.size();
+             param_index++) {
+            if (infos[param_index].result == Steinberg::kResultOk) {
+                function_result_cache_
+                    .parameter_info[static_cast<int32>(param_index)] =
+                    infos[param_index].info;
+            }
+        }
+        function_result_cache_.parameter_info_prefetched = true;
+    }
+    if (summary.process_context_requirements) {
+        function_result_cache_.process_context_requirements =
+            summary.process_context_requirements;
+    }
+}
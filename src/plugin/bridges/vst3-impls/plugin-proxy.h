@@ -17,6 +17,7 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 
 #include "../vst3.h"
 #include "plug-view-proxy.h"
@@ -30,8 +31,15 @@
  */
 class Vst3PluginProxyImpl : public Vst3PluginProxy {
    public:
+    /**
+     * @param class_id The class ID the host passed to
+     *   `IPluginFactory::createInstance()` to create this object. Used to share
+     *   bus information between instances of the same class when the
+     *   `vst3_shared_bus_cache` option is enabled.
+     */
     Vst3PluginProxyImpl(Vst3PluginBridge& bridge,
-                        Vst3PluginProxy::ConstructArgs&& args);
+                        Vst3PluginProxy::ConstructArgs&& args,
+                        const ArrayUID& class_id);
 
     /**
      * When the reference count reaches zero and this destructor is called,
@@ -68,13 +76,48 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      * `IComponentHandler::restartComponent()`. These caching layers are
      * necessary to get decent performance in certain hosts because they will
      * call these functions repeatedly even when their values cannot change.
+     * Only the information affected by `restart_flags` is cleared. If the
+     * flags contain anything else, like `kReloadComponent`, then everything
+     * gets cleared.
      *
      * See the bottom of this class for more information on what we're caching.
      *
+     * @param restart_flags The flags passed to
+     *   `IComponentHandler::restartComponent()`.
+     *
      * @see clear_bus_cache_
      * @see function_result_cache_
      */
-    void clear_caches() noexcept;
+    void clear_caches(int32 restart_flags) noexcept;
+
+    /**
+     * Update a value in the parameter value mirror after the plugin reported a
+     * change through `IComponentHandler::performEdit()`. This does nothing if
+     * the mirror has not been populated yet.
+     *
+     * @see parameter_values_
+     */
+    void update_parameter_value(Steinberg::Vst::ParamID id,
+                                Steinberg::Vst::ParamValue value) noexcept;
+
+    /**
+     * Drop the parameter value mirror so it gets fetched again the next time
+     * the host calls `IEditController::getParamNormalized()`. Called when the
+     * plugin's state changes, and as part of `clear_caches()`.
+     *
+     * @see parameter_values_
+     */
+    void clear_parameter_values() noexcept;
+
+    /**
+     * Drop the cached unit and program list information so it gets fetched
+     * again the next time the host asks for it. Called when the plugin calls
+     * `IUnitHandler::notifyProgramListChange()`, and as part of
+     * `clear_caches()`.
+     *
+     * @see FunctionResultCache::units_and_program_lists
+     */
+    void clear_unit_info_cache() noexcept;
 
     // From `IAudioPresentationLatency`
     tresult PLUGIN_API
@@ -414,6 +457,85 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     void clear_bus_cache() noexcept;
 
+    /**
+     * Ask the plugin whether it supports a precision through
+     * `IAudioProcessor::canProcessSampleSize()`. Our own
+     * `canProcessSampleSize()` also reports the precision the plugin doesn't
+     * support as supported, since we can convert between them while copying
+     * the audio to and from the shared memory buffers.
+     */
+    tresult plugin_can_process_sample_size(int32 symbolic_sample_size);
+
+    /**
+     * Populate `function_result_cache_.units_and_program_lists` using
+     * `YaUnitInfo::GetAllUnitsAndProgramLists` if it has not been populated
+     * yet. The lock is not held while sending the message, and the result is
+     * discarded if the cache was cleared in the meantime.
+     */
+    void prefetch_units_and_program_lists();
+
+    /**
+     * Populate `function_result_cache_.keyswitch_infos` for a bus and channel
+     * using `YaKeyswitchController::GetAllKeyswitchInfos` if it has not been
+     * populated yet. This works the same way as
+     * `prefetch_units_and_program_lists()`.
+     */
+    void prefetch_keyswitch_infos(int32 bus_index, int16 channel);
+
+    /**
+     * Populate `function_result_cache_.note_expression_infos` for a bus and
+     * channel using `YaNoteExpressionController::GetAllNoteExpressionInfos` if
+     * it has not been populated yet. This works the same way as
+     * `prefetch_units_and_program_lists()`.
+     */
+    void prefetch_note_expression_infos(int32 bus_index, int16 channel);
+
+    /**
+     * Populate `function_result_cache_.midi_controller_assignments` for a bus
+     * using `YaMidiMapping::GetAllMidiControllerAssignments` if it has not
+     * been populated yet. This works the same way as
+     * `prefetch_units_and_program_lists()`.
+     */
+    void prefetch_midi_controller_assignments(int32 bus_index);
+
+    /**
+     * Fetch the information for all of the plugin's parameters using
+     * `YaEditController::GetAllParameterInfos`. With the
+     * `parameter_metadata_cache` option enabled, the first call to this
+     * function will use the information stored on disk by an earlier instance
+     * of the same plugin class instead if that still matches the plugin's
+     * parameter count, and it will otherwise store the plugin's response
+     * there. The lock on `function_result_cache_mutex_` should not be held when
+     * calling this.
+     */
+    YaEditController::GetAllParameterInfosResponse fetch_all_parameter_infos();
+
+    /**
+     * Fill our bus information and function result caches with the
+     * information the Wine plugin host prefetched after initializing the
+     * object.
+     *
+     * @see Configuration::vst3_prefetch_instance_info
+     */
+    void apply_instance_summary(
+        const Vst3PluginProxy::InstanceSummary& summary);
+
+    /**
+     * Run `fn` with the bus information shared between all instances of this
+     * plugin class with the same bus arrangements. This does nothing if the
+     * `vst3_shared_bus_cache` option is not enabled.
+     *
+     * @see shared_bus_cache_key_
+     */
+    template <std::invocable<Vst3PluginBridge::SharedBusCache&> F>
+    void with_shared_bus_cache(F&& fn) {
+        std::lock_guard lock(shared_bus_cache_key_mutex_);
+        if (shared_bus_cache_key_) {
+            bridge_.with_shared_bus_cache(*shared_bus_cache_key_,
+                                          std::forward<F>(fn));
+        }
+    }
+
     Vst3PluginBridge& bridge_;
 
     /**
@@ -426,11 +548,25 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
     Steinberg::IPtr<Steinberg::FUnknown> host_context_;
 
     /**
-     * We'll periodically synchronize the Wine host's audio thread priority with
-     * that of the host. Since the overhead from doing so does add up, we'll
-     * only do this every once in a while.
+     * The realtime priority of the host's audio thread we last sent to the Wine
+     * plugin host. We check the priority during every processing cycle, but we
+     * only send it when it changes. This way the Wine plugin host's audio
+     * thread immediately follows priority changes made by the host or by
+     * rtkit. Only accessed from the audio thread.
+     */
+    std::optional<int> last_synchronized_realtime_priority_;
+    /**
+     * The CPU core the host's audio thread was running on when we last sent it
+     * to the Wine plugin host for the `audio_thread_follow_host_cpu` option.
+     * Like with the priority, this is only sent when it changes.
      */
-    time_t last_audio_thread_priority_synchronization_ = 0;
+    std::optional<int> last_synchronized_host_audio_thread_cpu_;
+    /**
+     * The NUMA node the host's audio thread was running on when we last sent
+     * it to the Wine plugin host for the `audio_thread_follow_host_numa_node`
+     * option.
+     */
+    std::optional<int> last_synchronized_host_audio_thread_numa_node_;
 
     /**
      * Used to assign unique identifiers to context menus created by
@@ -472,6 +608,19 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     std::optional<AudioShmBuffer> process_buffers_;
 
+    /**
+     * The sample rate from the last call to
+     * `IAudioProcessor::setupProcessing()`, used to compute the deadline for
+     * the `audio_deadline_warning` option.
+     */
+    double sample_rate_ = 0.0;
+    /**
+     * Checks whether `process()` calls finish in time when the
+     * `audio_deadline_warning` option is enabled. Only used from the audio
+     * thread.
+     */
+    ProcessDeadlineMonitor deadline_monitor_;
+
     // Caches
 
     /**
@@ -507,12 +656,20 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      * in.
      *
      * Since this information is immutable during audio processing, this cache
-     * will only be available at those times.
+     * only becomes available once processing starts, or right after
+     * `IPluginBase::initialize()` when the `vst3_prefetch_instance_info` option
+     * is enabled. It then stays available when processing stops so toggling
+     * processing on and off doesn't require fetching everything again.
+     * Anything that could change the bus layout clears the cache.
      *
      * @see clear_bus_cache_
      */
     std::optional<BusInfoCache> processing_bus_cache_;
-    std::mutex processing_bus_cache_mutex_;
+    /**
+     * Some hosts query the bus information from the audio thread, so this uses
+     * priority inheritance.
+     */
+    PiMutex processing_bus_cache_mutex_;
 
     /**
      * A cache for several function calls that should be safe to cache since
@@ -528,14 +685,91 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
          * call this every processing cycle.
          */
         std::map<int32, tresult> can_process_sample_size;
+        /**
+         * The arrangements from the last
+         * `IAudioProcessor::setBusArrangements()` call the plugin accepted when the `speaker_arrangement_cache` option
+         * is enabled. Setting these same arrangements again is answered
+         * without a round trip. This is cleared together with
+         * `can_process_sample_size`.
+         */
+        std::optional<Vst3PluginBridge::BusArrangements>
+            accepted_bus_arrangements;
         /**
          * Memoizes `IEditController::getParameterCount()`.
          */
         std::optional<int32> parameter_count;
         /**
-         * Memoizes `IEditController::getParameterInfo()`.
+         * Memoizes `IEditController::getParameterInfo()`. On the first cache
+         * miss we'll fetch the information for all parameters at once using
+         * `YaEditController::GetAllParameterInfos`.
          */
         std::unordered_map<int32, Steinberg::Vst::ParameterInfo> parameter_info;
+        /**
+         * Whether `parameter_info` has already been populated using
+         * `YaEditController::GetAllParameterInfos`. If a parameter is still
+         * missing after that, then we'll fall back to fetching it individually.
+         */
+        bool parameter_info_prefetched = false;
+        /**
+         * Memoizes
+         * `IProcessContextRequirements::getProcessContextRequirements()`.
+         * This is only populated from a prefetched
+         * `Vst3PluginProxy::InstanceSummary`.
+         */
+        std::optional<uint32> process_context_requirements;
+        /**
+         * Memoizes `IUnitInfo::getUnitCount()`, `IUnitInfo::getUnitInfo()`,
+         * `IUnitInfo::getProgramListCount()`,
+         * `IUnitInfo::getProgramListInfo()`, and `IUnitInfo::getProgramName()`.
+         * This is fetched in one go on the first call to any of these
+         * functions. Unlike the other fields this can change at run time, so
+         * this is also cleared when the plugin calls
+         * `IUnitHandler::notifyProgramListChange()`.
+         *
+         * @see clear_unit_info_cache
+         */
+        std::optional<YaUnitInfo::GetAllUnitsAndProgramListsResponse>
+            units_and_program_lists;
+        /**
+         * Memoizes `IUnitInfo::getProgramInfo()`, indexed by the program list
+         * ID, the program index, and the attribute ID. This is cleared
+         * together with `units_and_program_lists`.
+         */
+        std::map<std::tuple<Steinberg::Vst::ProgramListID, int32, std::string>,
+                 YaUnitInfo::GetProgramInfoResponse>
+            program_info;
+        /**
+         * Memoizes `IKeyswitchController::getKeyswitchCount()` and
+         * `IKeyswitchController::getKeyswitchInfo()` per bus and channel. Hosts
+         * with key editors query these for every channel whenever the editor
+         * redraws. All keyswitches for a bus and channel are fetched at once
+         * on the first query.
+         */
+        std::map<std::tuple<int32, int16>,
+                 YaKeyswitchController::GetAllKeyswitchInfosResponse>
+            keyswitch_infos;
+        /**
+         * Memoizes `INoteExpressionController::getNoteExpressionCount()` and
+         * `INoteExpressionController::getNoteExpressionInfo()` per bus and
+         * channel, just like `keyswitch_infos`. Plugins announce changes to
+         * these through `IComponentHandler::restartComponent()` with
+         * `kNoteExpressionChanged`, at which point this is cleared along with
+         * everything else.
+         */
+        std::map<std::tuple<int32, int16>,
+                 YaNoteExpressionController::GetAllNoteExpressionInfosResponse>
+            note_expression_infos;
+        /**
+         * Memoizes `IMidiMapping::getMidiControllerAssignment()` per bus.
+         * Some hosts query the assignment for every controller on every
+         * channel, sometimes from the audio thread, so a bus' entire table is
+         * fetched on the first query for that bus. Plugins announce changes
+         * through `IComponentHandler::restartComponent()` with
+         * `kMidiCCAssignmentChanged`, at which point this is cleared.
+         */
+        std::map<int32,
+                 YaMidiMapping::GetAllMidiControllerAssignmentsResponse>
+            midi_controller_assignments;
     };
 
     /**
@@ -553,5 +787,60 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      * @see clear_caches
      */
     FunctionResultCache function_result_cache_;
-    std::mutex function_result_cache_mutex_;
+    /**
+     * The cached functions may be called from the audio thread, so this uses
+     * priority inheritance.
+     */
+    PiMutex function_result_cache_mutex_;
+    /**
+     * Incremented whenever `function_result_cache_` or the unit information
+     * in it is cleared, so a prefetch that was already in flight at that point
+     * won't store stale information. Protected by
+     * `function_result_cache_mutex_`.
+     */
+    uint64_t function_result_cache_generation_ = 0;
+
+    /**
+     * The on-disk cache for this plugin class' parameter information, if the
+     * `parameter_metadata_cache` option is enabled. This only describes the
+     * parameters as they are right after initializing the plugin, so it is
+     * only consulted once per instance.
+     *
+     * @see fetch_all_parameter_infos
+     */
+    std::optional<ParameterMetadataCache> parameter_metadata_cache_;
+    std::atomic_bool parameter_metadata_cache_consulted_ = false;
+
+    /**
+     * The class ID this object was created from. Used to share cached results
+     * between instances of the same plugin class.
+     *
+     * @see Vst3PluginBridge::with_class_representation_cache
+     */
+    const ArrayUID class_id_;
+
+    /**
+     * A mirror of the plugin's normalized parameter values used to answer
+     * `IEditController::getParamNormalized()` without a round trip when the
+     * `vst3_parameter_value_cache` option is enabled. This is fetched in bulk
+     * using `YaEditController::GetAllParamNormalized`, updated through
+     * `performEdit()` callbacks, and reset whenever the plugin's state changes.
+     * Unlike `function_result_cache_` these values do change at run time.
+     */
+    std::optional<std::unordered_map<Steinberg::Vst::ParamID,
+                                     Steinberg::Vst::ParamValue>>
+        parameter_values_;
+    std::mutex parameter_values_mutex_;
+
+    /**
+     * Our key in `Vst3PluginBridge`'s shared bus cache, if the
+     * `vst3_shared_bus_cache` option is enabled. The speaker arrangements in
+     * here are updated whenever the host calls
+     * `IAudioProcessor::setBusArrangements()`, so instances only share bus
+     * information with instances that use the same layout.
+     *
+     * @see with_shared_bus_cache
+     */
+    std::optional<Vst3PluginBridge::SharedBusCacheKey> shared_bus_cache_key_;
+    std::mutex shared_bus_cache_key_mutex_;
 };
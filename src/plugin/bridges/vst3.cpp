@@ -28,13 +28,15 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
     : PluginBridge(
           PluginType::vst3,
           plugin_path,
-          [](asio::io_context& io_context, const PluginInfo& info) {
+          [](asio::io_context& io_context,
+             const PluginInfo& info,
+             bool abstract_sockets) {
               return Vst3Sockets<std::jthread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path_.filename()
                                              .replace_extension("")
                                              .string()),
-                  true);
+                  true, abstract_sockets);
           }),
       logger_(generic_logger_) {
     log_init_message();
@@ -68,6 +70,7 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                 [&](const WantsConfiguration& request)
                     -> WantsConfiguration::Response {
                     warn_on_version_mismatch(request.host_version);
+                    negotiate_capabilities(request.host_capabilities);
 
                     return config_;
                 },
@@ -84,9 +87,38 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                     const auto& [proxy_object, _] =
                         get_proxy(request.owner_instance_id);
 
+                    if (config_.vst3_parameter_value_cache) {
+                        proxy_object.update_parameter_value(
+                            request.id, request.value_normalized);
+                    }
+
                     return proxy_object.component_handler_->performEdit(
                         request.id, request.value_normalized);
                 },
+                [&](const YaComponentHandler::PerformEdits& request)
+                    -> YaComponentHandler::PerformEdits::Response {
+                    const auto& [proxy_object, _] =
+                        get_proxy(request.owner_instance_id);
+
+                    // We'll report the first failure, if any of these calls
+                    // fail
+                    tresult result = Steinberg::kResultOk;
+                    for (const auto& [id, value_normalized] : request.edits) {
+                        if (config_.vst3_parameter_value_cache) {
+                            proxy_object.update_parameter_value(
+                                id, value_normalized);
+                        }
+
+                        const tresult edit_result =
+                            proxy_object.component_handler_->performEdit(
+                                id, value_normalized);
+                        if (result == Steinberg::kResultOk) {
+                            result = edit_result;
+                        }
+                    }
+
+                    return result;
+                },
                 [&](const YaComponentHandler::EndEdit& request)
                     -> YaComponentHandler::EndEdit::Response {
                     const auto& [proxy_object, _] =
@@ -99,9 +131,14 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                     const auto& [proxy_object, _] =
                         get_proxy(request.owner_instance_id);
 
-                    // To err on the safe side, we'll just always clear out all
-                    // of our caches whenever a plugin requests a restart
-                    proxy_object.clear_caches();
+                    // This only clears the information affected by the flags.
+                    // With `vst3_restart_coalescing_ms` these flags may be
+                    // combined from several calls.
+                    proxy_object.clear_caches(request.flags);
+                    if (request.flags & (Steinberg::Vst::kLatencyChanged |
+                                         Steinberg::Vst::kIoChanged)) {
+                        invalidate_shared_bus_cache();
+                    }
 
                     return proxy_object.component_handler_->restartComponent(
                         request.flags);
@@ -184,26 +221,39 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                                                  request.type, request.dir,
                                                  request.index, request.state);
                                      },
-                [&](YaContextMenu::AddItem& request)
-                    -> YaContextMenu::AddItem::Response {
+                [&](const YaContextMenu::AddItems& request)
+                    -> YaContextMenu::AddItems::Response {
                     const auto& [proxy_object, _] =
                         get_proxy(request.owner_instance_id);
 
                     Vst3PluginProxyImpl::ContextMenu& context_menu =
                         proxy_object.context_menus_.at(request.context_menu_id);
 
-                    if (request.target) {
-                        context_menu.plugin_targets[request.item.tag] =
-                            Steinberg::owned(new YaContextMenuTargetImpl(
-                                *this, std::move(*request.target)));
+                    YaContextMenu::AddItemsResponse response{};
+                    response.results.reserve(request.items.size());
+                    for (const auto& [item, item_id, has_target] :
+                         request.items) {
+                        if (!has_target) {
+                            response.results.push_back(
+                                context_menu.menu->addItem(item, nullptr));
+                            continue;
+                        }
 
-                        return context_menu.menu->addItem(
-                            request.item,
-                            context_menu.plugin_targets[request.item.tag]);
-                    } else {
-                        return context_menu.menu->addItem(request.item,
-                                                          nullptr);
+                        auto& target = context_menu.plugin_targets[item.tag];
+                        target = Steinberg::owned(new YaContextMenuTargetImpl(
+                            *this, YaContextMenuTarget::ConstructArgs{
+                                       .owner_instance_id =
+                                           request.owner_instance_id,
+                                       .context_menu_id =
+                                           request.context_menu_id,
+                                       .item_id = item_id,
+                                       .tag = item.tag}));
+
+                        response.results.push_back(
+                            context_menu.menu->addItem(item, target));
                     }
+
+                    return response;
                 },
                 [&](const YaContextMenu::RemoveItem& request)
                     -> YaContextMenu::RemoveItem::Response {
@@ -271,44 +321,18 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                 },
                 [&](const YaHostApplication::GetName& request)
                     -> YaHostApplication::GetName::Response {
-                    tresult result;
-                    Steinberg::Vst::String128 name{0};
-
-                    // HACK: Certain plugins may have undesirable DAW-specific
-                    //       behaviour. Chromaphone 3 for instance has broken
-                    //       text input dialogs when using Bitwig. We can work
-                    //       around these issues by reporting we're running
-                    //       under some other host. We do this here to stay
-                    //       consistent with the VST2 version, where it has to
-                    //       be done on the plugin's side.
-                    if (config_.hide_daw) {
-                        // This is the only sane-ish way to copy a c-style
-                        // string to an UTF-16 string buffer
-                        Steinberg::UString128(product_name_override)
-                            .copyTo(name, 128);
-
-                        result = Steinberg::kResultOk;
+                    // There can be a global host context in addition to
+                    // plugin-specific host contexts, so we need to call the
+                    // function on correct context
+                    if (request.owner_instance_id) {
+                        const auto& [proxy_object, _] =
+                            get_proxy(*request.owner_instance_id);
+
+                        return get_host_name(proxy_object.host_application_);
                     } else {
-                        // There can be a global host context in addition to
-                        // plugin-specific host contexts, so we need to call the
-                        // function on correct context
-                        if (request.owner_instance_id) {
-                            const auto& [proxy_object, _] =
-                                get_proxy(*request.owner_instance_id);
-
-                            result =
-                                proxy_object.host_application_->getName(name);
-                        } else {
-                            result =
-                                plugin_factory_->host_application_->getName(
-                                    name);
-                        }
+                        return get_host_name(
+                            plugin_factory_->host_application_);
                     }
-
-                    return YaHostApplication::GetNameResponse{
-                        .result = result,
-                        .name = tchar_pointer_to_u16string(name),
-                    };
                 },
                 [&](YaPlugFrame::ResizeView& request)
                     -> YaPlugFrame::ResizeView::Response {
@@ -325,10 +349,16 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
 
                     // REAPER requires this to be run from its provided event
                     // loop or else it will likely segfault at some point
-                    return plug_view->run_gui_task([&]() -> tresult {
-                        return plug_view->plug_frame_->resizeView(
-                            plug_view, &request.new_size);
-                    });
+                    const tresult result =
+                        plug_view->run_gui_task([&]() -> tresult {
+                            return plug_view->plug_frame_->resizeView(
+                                plug_view, &request.new_size);
+                        });
+                    if (result == Steinberg::kResultTrue) {
+                        plug_view->update_size_cache(request.new_size);
+                    }
+
+                    return result;
                 },
                 [&](const YaPlugInterfaceSupport::IsPlugInterfaceSupported&
                         request)
@@ -396,6 +426,10 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                     const auto& [proxy_object, _] =
                         get_proxy(request.owner_instance_id);
 
+                    // The host will likely query the new program names in
+                    // response to this
+                    proxy_object.clear_unit_info_cache();
+
                     return proxy_object.unit_handler_->notifyProgramListChange(
                         request.list_id, request.program_index);
                 },
@@ -434,12 +468,14 @@ Steinberg::IPluginFactory* Vst3PluginBridge::get_plugin_factory() {
         // will request after loading the module. Host callback handlers should
         // have started before this since the Wine plugin host will request a
         // copy of the configuration during its initialization.
-        Vst3PluginFactoryProxy::ConstructArgs factory_args =
-            sockets_.host_vst_control_.send_message(
-                Vst3PluginFactoryProxy::Construct{},
-                std::pair<Vst3Logger&, bool>(logger_, true));
+        const auto factory_start = std::chrono::steady_clock::now();
         plugin_factory_ = Steinberg::owned(
-            new Vst3PluginFactoryProxyImpl(*this, std::move(factory_args)));
+            new Vst3PluginFactoryProxyImpl(*this, fetch_plugin_factory_args()));
+
+        log_startup_timings(
+            "plugin factory " +
+            format_duration_ms(std::chrono::steady_clock::now() -
+                               factory_start));
     }
 
     // Because we're returning a raw pointer, we have to increase the reference
@@ -449,6 +485,59 @@ Steinberg::IPluginFactory* Vst3PluginBridge::get_plugin_factory() {
     return plugin_factory_;
 }
 
+std::shared_ptr<const Vst3PluginFactoryProxy::ConstructArgs>
+Vst3PluginBridge::fetch_plugin_factory_args() {
+    // The factory's information only depends on the Windows module, so when
+    // the host loads multiple (chainloaded) copies of the same module in a
+    // single process they can all share that information. Scanning hosts also
+    // tend to load the same modules multiple times.
+    static std::mutex shared_factory_args_mutex;
+    static std::map<
+        std::string,
+        std::weak_ptr<const Vst3PluginFactoryProxy::ConstructArgs>>
+        shared_factory_args;
+
+    std::optional<std::string> key;
+    std::error_code err;
+    const ghc::filesystem::path canonical_path =
+        ghc::filesystem::canonical(info_.windows_library_path_, err);
+    if (!err) {
+        const auto last_write_time =
+            ghc::filesystem::last_write_time(canonical_path, err);
+        if (!err) {
+            key = canonical_path.string() + '\n' +
+                  std::to_string(last_write_time.time_since_epoch().count());
+        }
+    }
+
+    if (key) {
+        std::lock_guard lock(shared_factory_args_mutex);
+        if (auto it = shared_factory_args.find(*key);
+            it != shared_factory_args.end()) {
+            if (auto args = it->second.lock()) {
+                return args;
+            }
+        }
+    }
+
+    // The lock is not held while waiting for the Wine plugin host, since
+    // bridges for other modules may be initializing at the same time
+    auto args = std::make_shared<const Vst3PluginFactoryProxy::ConstructArgs>(
+        sockets_.host_vst_control_.send_message(
+            Vst3PluginFactoryProxy::Construct{},
+            std::pair<Vst3Logger&, bool>(logger_, true)));
+
+    if (key) {
+        std::lock_guard lock(shared_factory_args_mutex);
+        std::erase_if(shared_factory_args, [](const auto& entry) {
+            return entry.second.expired();
+        });
+        shared_factory_args[*key] = args;
+    }
+
+    return args;
+}
+
 std::pair<Vst3PluginProxyImpl&, std::shared_lock<std::shared_mutex>>
 Vst3PluginBridge::get_proxy(size_t instance_id) noexcept {
     std::shared_lock lock(plugin_proxies_mutex_);
@@ -465,9 +554,11 @@ void Vst3PluginBridge::register_plugin_proxy(
                             std::ref<Vst3PluginProxyImpl>(proxy_object));
 
     // For optimization reaons we use dedicated sockets for functions that will
-    // be run in the audio processing loop
-    if (proxy_object.YaAudioProcessor::supported() ||
-        proxy_object.YaComponent::supported()) {
+    // be run in the audio processing loop. With `vst3_lazy_audio_threads`
+    // these are only set up once the host first calls one of those functions.
+    if (!config_.vst3_lazy_audio_threads &&
+        (proxy_object.YaAudioProcessor::supported() ||
+         proxy_object.YaComponent::supported())) {
         sockets_.add_audio_processor_and_connect(proxy_object.instance_id());
     }
 }
@@ -482,3 +573,109 @@ void Vst3PluginBridge::unregister_plugin_proxy(
         sockets_.remove_audio_processor(proxy_object.instance_id());
     }
 }
+
+void Vst3PluginBridge::start_audio_processor(size_t instance_id) {
+    std::lock_guard lock(start_audio_processor_mutex_);
+    if (sockets_.has_audio_processor(instance_id)) {
+        return;
+    }
+
+    // The Wine plugin host only responds once the new socket is listening
+    send_message(
+        Vst3PluginProxy::StartAudioProcessor{.instance_id = instance_id});
+    sockets_.add_audio_processor_and_connect(instance_id);
+}
+
+void Vst3PluginBridge::invalidate_shared_bus_cache() noexcept {
+    std::lock_guard lock(shared_bus_caches_mutex_);
+    shared_bus_caches_.clear();
+    shared_bus_cache_valid_ = false;
+}
+
+Vst3HostContextProxy::ConstructArgs Vst3PluginBridge::create_host_context_args(
+    Steinberg::IPtr<Steinberg::FUnknown> host_context,
+    std::optional<size_t> owner_instance_id) {
+    Vst3HostContextProxy::ConstructArgs args(host_context, owner_instance_id);
+
+    // The host's name won't change, so the Wine plugin host can answer
+    // `IHostApplication::getName()` on its own
+    if (Steinberg::FUnknownPtr<Steinberg::Vst::IHostApplication>
+            host_application(host_context)) {
+        args.host_application_args.name = get_host_name(host_application);
+    }
+
+    return args;
+}
+
+YaHostApplication::GetNameResponse Vst3PluginBridge::get_host_name(
+    Steinberg::Vst::IHostApplication* host_application) {
+    tresult result;
+    Steinberg::Vst::String128 name{0};
+
+    // HACK: Certain plugins may have undesirable DAW-specific behaviour.
+    //       Chromaphone 3 for instance has broken text input dialogs when using
+    //       Bitwig. We can work around these issues by reporting we're running
+    //       under some other host. We do this here to stay consistent with the
+    //       VST2 version, where it has to be done on the plugin's side.
+    if (config_.hide_daw) {
+        // This is the only sane-ish way to copy a c-style string to an UTF-16
+        // string buffer
+        Steinberg::UString128(product_name_override).copyTo(name, 128);
+
+        result = Steinberg::kResultOk;
+    } else {
+        result = host_application->getName(name);
+    }
+
+    return YaHostApplication::GetNameResponse{
+        .result = result,
+        .name = tchar_pointer_to_u16string(name),
+    };
+}
+
+bool Vst3PluginBridge::bus_arrangements_rejected(
+    const ArrayUID& class_id,
+    const BusArrangements& arrangements) {
+    std::lock_guard lock(rejected_bus_arrangements_mutex_);
+    if (auto it = rejected_bus_arrangements_.find(class_id);
+        it != rejected_bus_arrangements_.end()) {
+        return it->second.contains(arrangements);
+    }
+
+    return false;
+}
+
+void Vst3PluginBridge::remember_rejected_bus_arrangements(
+    const ArrayUID& class_id,
+    BusArrangements arrangements) {
+    std::lock_guard lock(rejected_bus_arrangements_mutex_);
+    rejected_bus_arrangements_[class_id].insert(std::move(arrangements));
+}
+
+void Vst3PluginBridge::clear_rejected_bus_arrangements(
+    const ArrayUID& class_id) noexcept {
+    std::lock_guard lock(rejected_bus_arrangements_mutex_);
+    rejected_bus_arrangements_.erase(class_id);
+}
+
+void Vst3PluginBridge::clear_class_representation_cache(
+    const ArrayUID& class_id) noexcept {
+    std::lock_guard lock(class_representation_caches_mutex_);
+    class_representation_caches_.erase(class_id);
+}
+
+ParameterMetadataCache Vst3PluginBridge::parameter_metadata_cache(
+    const ArrayUID& class_id) const {
+    return ParameterMetadataCache(
+        info_.windows_library_path_,
+        "vst3 " + format_uid(Steinberg::FUID::fromTUID(class_id.data())));
+}
+
+ParameterMetadataCache Vst3PluginBridge::xml_representation_cache(
+    const ArrayUID& class_id,
+    const std::string& representation) const {
+    return ParameterMetadataCache(
+        info_.windows_library_path_,
+        "vst3 " + format_uid(Steinberg::FUID::fromTUID(class_id.data())) +
+            " xml " + representation);
+}
@@ -16,12 +16,15 @@
 
 #pragma once
 
+#include <map>
+#include <set>
 #include <shared_mutex>
 #include <thread>
 
 #include "../../common/communication/vst3.h"
 #include "../../common/logging/vst3.h"
 #include "../../common/mutual-recursion.h"
+#include "../parameter-metadata-cache.h"
 #include "common.h"
 #include "vst3-impls/plugin-factory-proxy.h"
 
@@ -94,7 +97,8 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      * can handle host callbacks. This function is called in
      * `Vst3PluginProxyImpl`'s constructor. If the plugin supports the
      * `IAudioProcessor` or `IComponent` interfaces, then we'll also connect to
-     * a dedicated audio processing socket.
+     * a dedicated audio processing socket. With `vst3_lazy_audio_threads` this
+     * is deferred to `start_audio_processor()`.
      *
      * @param proxy_object The proxy object so we can access its host context
      *   and unique instance identifier.
@@ -115,6 +119,189 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      */
     void unregister_plugin_proxy(Vst3PluginProxyImpl& proxy_object);
 
+    /**
+     * Ask the Wine plugin host to spawn the dedicated audio thread for an
+     * object instance and connect to its socket, if that hasn't happened yet.
+     * This is only used with the `vst3_lazy_audio_threads` option, and it's
+     * called before sending any `IAudioProcessor` or `IComponent` calls.
+     */
+    void start_audio_processor(size_t instance_id);
+
+    /**
+     * The configuration for this instance of yabridge. The VST3 interface
+     * implementations use this to check whether optional caching behaviour has
+     * been enabled.
+     */
+    inline const Configuration& config() const noexcept { return config_; }
+
+    /**
+     * The bus information, speaker arrangements, and latency and tail lengths
+     * shared between all instances of a plugin class when the
+     * `vst3_shared_bus_cache` option is enabled.
+     *
+     * @see with_shared_bus_cache
+     */
+    struct SharedBusCache {
+        std::map<
+            std::tuple<Steinberg::Vst::MediaType, Steinberg::Vst::BusDirection>,
+            int32>
+            bus_count;
+        std::map<std::tuple<Steinberg::Vst::MediaType,
+                            Steinberg::Vst::BusDirection,
+                            int32>,
+                 Steinberg::Vst::BusInfo>
+            bus_info;
+        std::map<std::tuple<Steinberg::Vst::BusDirection, int32>,
+                 Steinberg::Vst::SpeakerArrangement>
+            bus_arrangements;
+        std::optional<uint32> latency_samples;
+        std::optional<uint32> tail_samples;
+    };
+
+    /**
+     * Instances share a `SharedBusCache` when they have been created from the
+     * same class ID and when the host has passed them the same input and
+     * output speaker arrangements in their last call to
+     * `IAudioProcessor::setBusArrangements()`. Both vectors are empty when the
+     * host hasn't called that function yet.
+     */
+    using SharedBusCacheKey =
+        std::tuple<ArrayUID,
+                   std::vector<Steinberg::Vst::SpeakerArrangement>,
+                   std::vector<Steinberg::Vst::SpeakerArrangement>>;
+
+    /**
+     * Run `fn` with the shared bus cache for `key` while holding a lock on it.
+     * This does nothing if the shared bus cache has been invalidated.
+     *
+     * @see SharedBusCache
+     * @see invalidate_shared_bus_cache
+     */
+    template <std::invocable<SharedBusCache&> F>
+    void with_shared_bus_cache(const SharedBusCacheKey& key, F&& fn) {
+        std::lock_guard lock(shared_bus_caches_mutex_);
+        if (shared_bus_cache_valid_) {
+            fn(shared_bus_caches_[key]);
+        }
+    }
+
+    /**
+     * Drop all shared bus information and stop sharing it between instances.
+     * Called when any instance calls `IComponentHandler::restartComponent()`
+     * with the `kLatencyChanged` or `kIoChanged` flags. At that point we can
+     * no longer tell which instances still report the same information,
+     * especially when the component and the edit controller are separate
+     * objects.
+     */
+    void invalidate_shared_bus_cache() noexcept;
+
+    /**
+     * The input and output speaker arrangements passed to
+     * `IAudioProcessor::setBusArrangements()`.
+     */
+    using BusArrangements =
+        std::pair<std::vector<Steinberg::Vst::SpeakerArrangement>,
+                  std::vector<Steinberg::Vst::SpeakerArrangement>>;
+
+    /**
+     * Check whether an instance of the plugin class `class_id` has rejected
+     * `arrangements` before when the `speaker_arrangement_cache` option is
+     * enabled.
+     *
+     * @see remember_rejected_bus_arrangements
+     */
+    bool bus_arrangements_rejected(const ArrayUID& class_id,
+                                   const BusArrangements& arrangements);
+
+    /**
+     * Remember that an instance of the plugin class `class_id` has rejected
+     * `arrangements`, so other instances of that class can reject them
+     * without a round trip.
+     */
+    void remember_rejected_bus_arrangements(const ArrayUID& class_id,
+                                            BusArrangements arrangements);
+
+    /**
+     * Forget the rejected arrangements for a plugin class. Called when one of
+     * its instances reports an IO change, since the plugin may now accept
+     * different arrangements.
+     */
+    void clear_rejected_bus_arrangements(const ArrayUID& class_id) noexcept;
+
+    /**
+     * Create the arguments for a `Vst3HostContextProxy` for a host context
+     * passed to `IPluginBase::initialize()` or
+     * `IPluginFactory3::setHostContext()`. Along with the interfaces the host
+     * context supports, this also includes the host's name and its answers for
+     * `IPlugInterfaceSupport::isPlugInterfaceSupported()` for all interfaces
+     * yabridge can bridge, so the Wine plugin host can answer those queries
+     * without any round trips.
+     */
+    Vst3HostContextProxy::ConstructArgs create_host_context_args(
+        Steinberg::IPtr<Steinberg::FUnknown> host_context,
+        std::optional<size_t> owner_instance_id);
+
+    /**
+     * Results for `IXmlRepresentationController::getXmlRepresentationStream()`
+     * and `IParameterFunctionName::getParameterIDFromFunctionName()` shared
+     * between all instances of a plugin class. These only depend on the plugin
+     * build, and hosts with controller surface integrations query them over
+     * and over again.
+     *
+     * @see with_class_representation_cache
+     */
+    struct ClassRepresentationCache {
+        /**
+         * Indexed by the `RepresentationInfo`'s vendor, name, version, and
+         * host fields.
+         */
+        std::map<std::tuple<std::string, std::string, std::string, std::string>,
+                 YaXmlRepresentationController::
+                     GetXmlRepresentationStreamResponse>
+            xml_representations;
+        std::map<std::tuple<Steinberg::Vst::UnitID, std::string>,
+                 YaParameterFunctionName::
+                     GetParameterIDFromFunctionNameResponse>
+            parameter_ids_by_function_name;
+    };
+
+    /**
+     * Run `fn` with the representation cache for the plugin class `class_id`
+     * while holding a lock on it, and return the result.
+     *
+     * @see ClassRepresentationCache
+     */
+    template <std::invocable<ClassRepresentationCache&> F>
+    std::invoke_result_t<F, ClassRepresentationCache&>
+    with_class_representation_cache(const ArrayUID& class_id, F&& fn) {
+        std::lock_guard lock(class_representation_caches_mutex_);
+        return fn(class_representation_caches_[class_id]);
+    }
+
+    /**
+     * Drop the representation cache for a plugin class. Called when one of its
+     * instances asks the host to reload the component.
+     */
+    void clear_class_representation_cache(const ArrayUID& class_id) noexcept;
+
+    /**
+     * The on-disk cache for the parameter information of instances of the
+     * plugin class `class_id`, used for the `parameter_metadata_cache` option.
+     */
+    ParameterMetadataCache parameter_metadata_cache(
+        const ArrayUID& class_id) const;
+
+    /**
+     * The on-disk cache for an XML representation of the plugin class
+     * `class_id`, also used for the `parameter_metadata_cache` option.
+     *
+     * @param representation A string identifying the `RepresentationInfo` the
+     *   host asked for.
+     */
+    ParameterMetadataCache xml_representation_cache(
+        const ArrayUID& class_id,
+        const std::string& representation) const;
+
     /**
      * Send a control message to the Wine plugin host return the response. This
      * is a shorthand for `sockets_.host_vst_control_.send_message()` for use in
@@ -134,6 +321,13 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      */
     template <typename T>
     typename T::Response send_audio_processor_message(const T& object) {
+        // NOTE: `receive_audio_processor_message_into()` below doesn't need
+        //       this check since hosts can only call `process()` after
+        //       `setupProcessing()` and `setActive()`
+        if (config_.vst3_lazy_audio_threads) {
+            start_audio_processor(object.instance_id);
+        }
+
         return sockets_.send_audio_processor_message(
             object, std::pair<Vst3Logger&, bool>(logger_, true));
     }
@@ -194,6 +388,24 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
     Vst3Logger logger_;
 
    private:
+    /**
+     * Call `IHostApplication::getName()` on the host's host context, or return
+     * a fake name when the `hide_daw` option is enabled. Used both for
+     * prefetching the name in `create_host_context_args()` and for handling
+     * `YaHostApplication::GetName` callbacks.
+     */
+    YaHostApplication::GetNameResponse get_host_name(
+        Steinberg::Vst::IHostApplication* host_application);
+
+    /**
+     * Fetch the Windows VST3 module's plugin factory information from the Wine
+     * plugin host, or reuse the information fetched by another bridge in this
+     * process that loaded the same module. This information is shared for as
+     * long as any plugin factory using it is still alive.
+     */
+    std::shared_ptr<const Vst3PluginFactoryProxy::ConstructArgs>
+    fetch_plugin_factory_args();
+
     /**
      * Handles callbacks from the plugin to the host over the
      * `vst_host_callback_` sockets.
@@ -236,6 +448,40 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      */
     std::shared_mutex plugin_proxies_mutex_;
 
+    /**
+     * Makes sure two threads calling `start_audio_processor()` for the same
+     * instance don't both ask the Wine plugin host to spawn a thread.
+     */
+    std::mutex start_audio_processor_mutex_;
+
+    /**
+     * Bus information shared between instances of the same plugin class with
+     * the `vst3_shared_bus_cache` option.
+     *
+     * @see with_shared_bus_cache
+     */
+    std::map<SharedBusCacheKey, SharedBusCache> shared_bus_caches_;
+    /**
+     * Set to false when any of the plugin's instances announce a latency or IO
+     * change.
+     *
+     * @see invalidate_shared_bus_cache
+     */
+    bool shared_bus_cache_valid_ = true;
+    std::mutex shared_bus_caches_mutex_;
+
+    /**
+     * @see with_class_representation_cache
+     */
+    std::map<ArrayUID, ClassRepresentationCache> class_representation_caches_;
+    std::mutex class_representation_caches_mutex_;
+
+    /**
+     * @see bus_arrangements_rejected
+     */
+    std::map<ArrayUID, std::set<BusArrangements>> rejected_bus_arrangements_;
+    std::mutex rejected_bus_arrangements_mutex_;
+
     /**
      * Used in `Vst3Bridge::send_mutually_recursive_message()` to be able to
      * execute functions from that same calling thread while we're waiting for a
@@ -16,12 +16,132 @@
 
 #include "host-process.h"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <array>
+#include <deque>
+#include <map>
+#include <mutex>
+
 #include <asio/read_until.hpp>
 
 #include "../common/utils.h"
 
 namespace fs = ghc::filesystem;
 
+using namespace std::literals::chrono_literals;
+
+/**
+ * How long the pre-warmed host processes from the `host_pool_size` option wait
+ * for a plugin before shutting down again. This also prevents idle processes
+ * from sticking around after the host crashes.
+ */
+constexpr std::chrono::seconds host_pool_idle_timeout = 10min;
+
+/**
+ * The idle host processes for the `host_pool_size` option, indexed by Wine
+ * prefix and architecture. This pool is shared between all plugin instances
+ * using this library. Any processes still left in here will be terminated when
+ * the library gets unloaded.
+ */
+std::map<std::pair<std::string, LibArchitecture>,
+         std::deque<PooledHostProcess>>
+    host_pool;
+std::mutex host_pool_mutex;
+
+/**
+ * Used to give every pooled host process its own socket.
+ */
+std::atomic_size_t next_pooled_host_id = 0;
+
+/**
+ * An exclusive `flock()` on a lock file next to a group host's socket. This is
+ * held while spawning a new group host process and until that process accepts
+ * our connection, so when a host loads many plugins from the same group at the
+ * same time only the first one spawns a group host. All other plugins wait for
+ * the lock and then connect to that group host right away. If the lock file
+ * can't be opened we'll just continue without a lock.
+ */
+class GroupSpawnLock {
+   public:
+    explicit GroupSpawnLock(const fs::path& group_socket_path)
+        : fd_(open((group_socket_path.string() + ".lock").c_str(),
+                   O_RDWR | O_CREAT | O_CLOEXEC,
+                   0600)) {
+        if (fd_ != -1) {
+            flock(fd_, LOCK_EX);
+        }
+    }
+
+    ~GroupSpawnLock() noexcept {
+        if (fd_ != -1) {
+            close(fd_);
+        }
+    }
+
+    GroupSpawnLock(const GroupSpawnLock&) = delete;
+    GroupSpawnLock& operator=(const GroupSpawnLock&) = delete;
+
+    GroupSpawnLock(GroupSpawnLock&& o) noexcept
+        : fd_(std::exchange(o.fd_, -1)) {}
+    GroupSpawnLock& operator=(GroupSpawnLock&&) = delete;
+
+   private:
+    int fd_;
+};
+
+/**
+ * Call `connect` until it succeeds or until `process` exits. Instead of polling
+ * we'll watch the socket's directory using inotify, so we can connect as soon
+ * as the host process creates its socket. We still wake up every so often to
+ * check whether the process is still running.
+ *
+ * @return Whether `connect` succeeded.
+ */
+template <std::invocable F>
+bool connect_when_listening(const fs::path& socket_path,
+                            const Process::Handle& process,
+                            F&& connect) {
+    // The watch needs to be set up before the first attempt so we can't miss
+    // the socket getting created in between
+    const int inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd != -1) {
+        inotify_add_watch(inotify_fd, socket_path.parent_path().c_str(),
+                          IN_CREATE);
+    }
+
+    bool connected = false;
+    while (!connected && process.running()) {
+        try {
+            connect();
+            connected = true;
+        } catch (const std::system_error&) {
+            // The socket file gets created when the host process binds to it,
+            // which happens just before it starts listening. If that's what
+            // woke us up then we'll retry after the short timeout.
+            if (inotify_fd != -1) {
+                pollfd poll_fd{
+                    .fd = inotify_fd, .events = POLLIN, .revents = 0};
+                if (poll(&poll_fd, 1, 50) > 0) {
+                    std::array<char, 4096> events;
+                    while (read(inotify_fd, events.data(), events.size()) > 0) {
+                    }
+                }
+            } else {
+                std::this_thread::sleep_for(20ms);
+            }
+        }
+    }
+
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+    }
+
+    return connected;
+}
+
 HostProcess::HostProcess(asio::io_context& io_context, Sockets& sockets)
     : sockets_(sockets), stdout_pipe_(io_context), stderr_pipe_(io_context) {}
 
@@ -30,7 +150,8 @@ Process::Handle HostProcess::launch_host(
     std::initializer_list<std::string> args,
     Logger& logger,
     const Configuration& config,
-    const PluginInfo& plugin_info) {
+    const PluginInfo& plugin_info,
+    bool pipe_output) {
 #ifdef WITH_WINEDBG
     // This is set up for KDE Plasma. Other desktop environments and window
     // managers require some slight modifications to spawn a detached terminal
@@ -76,10 +197,17 @@ Process::Handle HostProcess::launch_host(
         //       reason necessary for ujam's plugins and all other plugins made
         //       with Gorilla Engine to function. Otherwise they'll print a
         //       nondescriptive `JS_EXEC_FAILED` error message.
-        config.disable_pipes
-            ? child.spawn_child_redirected(*config.disable_pipes)
+        config.disable_pipes || !pipe_output
+            ? child.spawn_child_redirected(
+                  config.disable_pipes.value_or(fs::path("/dev/null")))
             : child.spawn_child_piped(stdout_pipe_, stderr_pipe_));
 
+    // Pre-warmed host processes are not tied to this plugin instance, so
+    // there's nothing to log here
+    if (!pipe_output) {
+        return child_handle;
+    }
+
     // See the above comment
     if (config.disable_pipes) {
         logger.log("");
@@ -172,12 +300,14 @@ GroupHost::GroupHost(asio::io_context& io_context,
                                plugin_info.plugin_arch_)) {
     // When using plugin groups, we'll first try to connect to an existing group
     // host process and ask it to host our plugin. If no such process exists,
-    // then we'll start a new process. In the event that multiple yabridge
-    // instances simultaneously try to start a new group process for the same
-    // group, then the first process to listen on the socket will win and all
-    // other processes will exit. When a plugin's host process has exited, it
-    // will try to connect to the socket once more in the case that another
-    // process is now listening on it.
+    // then we'll take the group's spawn lock and start a new process. Other
+    // yabridge instances trying to do the same will block on that lock until
+    // the new group host accepts our connection, after which they can connect
+    // to it directly. Without the lock (or for instances in other sandboxes)
+    // the first process to listen on the socket will win and all other
+    // processes will exit. When a plugin's host process has exited, it will try
+    // to connect to the socket once more in the case that another process is
+    // now listening on it.
     const fs::path endpoint_base_dir = sockets.base_dir_;
     const fs::path group_socket_path = generate_group_endpoint(
         *config.group, plugin_info.normalize_wine_prefix(),
@@ -195,6 +325,15 @@ GroupHost::GroupHost(asio::io_context& io_context,
     try {
         // Request an existing group host process to host our plugin
         connect();
+        return;
+    } catch (const std::system_error&) {
+    }
+
+    // Another instance may have spawned the group host while we were waiting
+    // for the lock
+    GroupSpawnLock spawn_lock(group_socket_path);
+    try {
+        connect();
     } catch (const std::system_error&) {
         // In case we could not connect to the socket, then we'll start a
         // new group host process. This process is detached immediately
@@ -205,25 +344,18 @@ GroupHost::GroupHost(asio::io_context& io_context,
                         logger, config, plugin_info);
         group_host.detach();
 
-        group_host_connect_handler_ =
-            std::jthread([this, connect, group_host = std::move(group_host)]() {
+        group_host_connect_handler_ = std::jthread(
+            [this, connect, group_socket_path,
+             group_host = std::move(group_host),
+             spawn_lock = std::move(spawn_lock)]() {
                 set_realtime_priority(true);
                 pthread_setname_np(pthread_self(), "group-connect");
 
-                using namespace std::literals::chrono_literals;
-
-                // We'll first try to connect to the group host we just spawned
-                // TODO: Replace this polling with inotify
-                while (group_host.running()) {
-                    std::this_thread::sleep_for(20ms);
-
-                    try {
-                        connect();
-                        return;
-                    } catch (const std::system_error&) {
-                        // Keep trying to connect until either connection gets
-                        // accepted or the group host crashes
-                    }
+                // We'll first try to connect to the group host we just
+                // spawned. The spawn lock is released when this thread exits.
+                if (connect_when_listening(group_socket_path, group_host,
+                                           connect)) {
+                    return;
                 }
 
                 // When the group host exits before we can connect to it this
@@ -257,3 +389,103 @@ void GroupHost::terminate() {
     // the sockets will cause the associated plugin to exit.
     sockets_.close();
 }
+
+PooledHost::PooledHost(asio::io_context& io_context,
+                       Logger& logger,
+                       const Configuration& config,
+                       Sockets& sockets,
+                       const PluginInfo& plugin_info,
+                       const HostRequest& host_request)
+    : HostProcess(io_context, sockets),
+      plugin_info_(plugin_info),
+      host_path_(find_vst_host(plugin_info.native_library_path_,
+                               plugin_info.plugin_arch_)),
+      host_(acquire_pooled_host(logger, config)) {
+    pooled_host_connect_handler_ = std::jthread([this, &io_context,
+                                                 host_request]() {
+        set_realtime_priority(true);
+        pthread_setname_np(pthread_self(), "pool-connect");
+
+        // Processes taken from the pool will usually already be listening on
+        // their socket, but if the pool was empty or if the process was only
+        // just launched we'll need to wait for Wine to start up
+        const bool connected =
+            connect_when_listening(host_.socket_path, host_.handle, [&]() {
+                asio::local::stream_protocol::socket pool_socket(io_context);
+                pool_socket.connect(host_.socket_path.string());
+
+                write_object(pool_socket, host_request);
+                const auto response = read_object<HostResponse>(pool_socket);
+                assert(response.pid > 0);
+            });
+        if (!connected) {
+            startup_failed_ = true;
+        }
+    });
+}
+
+fs::path PooledHost::path() {
+    return host_path_;
+}
+
+bool PooledHost::running() noexcept {
+    return !startup_failed_ && host_.handle.running();
+}
+
+void PooledHost::terminate() {
+    // See `IndividualHost::terminate()`. The pooled process only ever hosts
+    // this plugin, so we can just terminate it.
+    sockets_.close();
+    host_.handle.terminate();
+}
+
+PooledHostProcess PooledHost::acquire_pooled_host(
+    Logger& logger,
+    const Configuration& config) {
+    std::lock_guard lock(host_pool_mutex);
+    std::deque<PooledHostProcess>& pool =
+        host_pool[std::pair(plugin_info_.normalize_wine_prefix().string(),
+                            plugin_info_.plugin_arch_)];
+
+    // Processes that have reached their idle timeout or that crashed while
+    // starting Wine are simply discarded
+    std::optional<PooledHostProcess> host;
+    while (!host && !pool.empty()) {
+        PooledHostProcess candidate = std::move(pool.front());
+        pool.pop_front();
+
+        if (candidate.handle.running()) {
+            host.emplace(std::move(candidate));
+        }
+    }
+
+    if (host) {
+        logger.log("Using a pre-warmed Wine host process from the pool");
+    } else {
+        host.emplace(launch_pooled_host(logger, config, true));
+    }
+
+    // Launching the process itself is quick, and Wine will initialize in the
+    // background while this plugin gets set up
+    while (pool.size() < *config.host_pool_size) {
+        pool.push_back(launch_pooled_host(logger, config, false));
+    }
+
+    return std::move(*host);
+}
+
+PooledHostProcess PooledHost::launch_pooled_host(Logger& logger,
+                                                 const Configuration& config,
+                                                 bool pipe_output) {
+    const fs::path socket_path = generate_group_endpoint(
+        "pool-" + std::to_string(getpid()) + "-" +
+            std::to_string(next_pooled_host_id.fetch_add(1)),
+        plugin_info_.normalize_wine_prefix(), plugin_info_.plugin_arch_);
+
+    return PooledHostProcess{
+        .socket_path = socket_path,
+        .handle = launch_host(host_path_,
+                              {"group", socket_path.string(),
+                               std::to_string(host_pool_idle_timeout.count())},
+                              logger, config, plugin_info_, pipe_output)};
+}
@@ -87,12 +87,19 @@ class HostProcess {
      *   use pipes or to redirect the output to a file instead.
      * @param plugin_info Information about the plugin, used to determine the
      *   plugin's Wine prefix.
+     * @param pipe_output Whether to write the process's output to `logger`.
+     *   This can only be done once per `HostProcess` since the pipes are bound
+     *   to this object. Pre-warmed host processes are not tied to the plugin
+     *   instance that launched them, so their output is discarded instead
+     *   (or written to the `disable_pipes` file) until the group host
+     *   redirects it to its own logger.
      */
     Process::Handle launch_host(const ghc::filesystem::path& host_path,
                                 std::initializer_list<std::string> args,
                                 Logger& logger,
                                 const Configuration& config,
-                                const PluginInfo& plugin_info);
+                                const PluginInfo& plugin_info,
+                                bool pipe_output = true);
 
     /**
      * The associated sockets for the plugin we're hosting. This is used to
@@ -210,11 +217,14 @@ class GroupHost : public HostProcess {
      * loading a project). On startup we'll go through the following sequence:
      *
      * 1. Try to connect to an existing group host process.
-     * 2. Spawn a new group host process and connect to it. When multiple
-     *    plugins launch at the same time the first to start listening on the
-     *    socket wins and the other processes will shut down gracefully.
-     * 3.  When the group host process exits, try to connect again (potentially
-     *     to a group host process spawned by another instance).
+     * 2. Take the group's spawn lock, and try connecting once more in case
+     *    another plugin spawned a group host while we were waiting for it.
+     * 3. Spawn a new group host process and connect to it while still holding
+     *    the lock. If some other process did end up spawning a group host at
+     *    the same time, then the first to start listening on the socket wins
+     *    and the other processes will shut down gracefully.
+     * 4. When the group host process exits, try to connect again (potentially
+     *    to a group host process spawned by another instance).
      *
      * When this last step also fails, then we'll say that startup has failed
      * and we will terminate the plugin initialization process.
@@ -225,10 +235,102 @@ class GroupHost : public HostProcess {
      * A thread that waits for the group host to have started and then ask it to
      * host our plugin. This is used to defer the request since it may take a
      * little while until the group host process is up and running. This way we
-     * don't have to delay the rest of the initialization process.
+     * don't have to delay the rest of the initialization process. This thread
+     * also holds on to the group's spawn lock until we've connected.
      *
-     * TODO: Replace the polling with inotify to prevent delays and to reduce
-     *       wasting resources
+     * @see connect_when_listening
      */
     std::jthread group_host_connect_handler_;
 };
+
+/**
+ * An idle group host process launched ahead of time for the `host_pool_size`
+ * option. Every pooled process listens on its own unique socket, so it will
+ * only ever receive a single plugin.
+ */
+struct PooledHostProcess {
+    ghc::filesystem::path socket_path;
+    Process::Handle handle;
+};
+
+/**
+ * Host a plugin individually using one of the pre-warmed host processes from
+ * the `host_pool_size` option. Launching a Wine process and waiting for Wine to
+ * initialize accounts for most of the time it takes to load a plugin, so we'll
+ * keep a couple of idle group host processes around per Wine prefix and
+ * architecture. When a plugin gets loaded it takes one of those processes and
+ * sends it a host request just like `GroupHost` would, and a new process is
+ * launched in the background to take its place. If the pool is empty we'll
+ * launch a process for this plugin right away. The taken process will only
+ * ever host this one plugin, so from the plugin's perspective this behaves
+ * exactly like `IndividualHost`.
+ */
+class PooledHost : public HostProcess {
+   public:
+    /**
+     * Take a process from the pool and ask it to host our plugin, and then top
+     * up the pool again. The host request is sent from a thread like in
+     * `GroupHost` so we don't block in case the process is still starting.
+     *
+     * @param io_context The IO context that the STDIO redurection will be
+     *   handled on.
+     * @param logger The `Logger` instance the redirected STDIO streams will be
+     *   written to.
+     * @param config The configuration for this plugin instance. The pool size
+     *   will be retrieved from here.
+     * @param sockets The socket endpoints that will be used for communication
+     *   with the plugin. When the plugin shuts down, we'll close all of the
+     *   sockets used by the plugin.
+     * @param plugin_info Information about the plugin we're going to use. Used
+     *   to retrieve the Wine prefix and the plugin's architecture.
+     * @param host_request The information about the plugin we should launch a
+     *   host process for. This object will be sent to the pooled process.
+     */
+    PooledHost(asio::io_context& io_context,
+               Logger& logger,
+               const Configuration& config,
+               Sockets& sockets,
+               const PluginInfo& plugin_info,
+               const HostRequest& host_request);
+
+    ghc::filesystem::path path() override;
+    bool running() noexcept override;
+    void terminate() override;
+
+   private:
+    /**
+     * Take an idle process for this plugin's Wine prefix and architecture from
+     * the pool, launching a new one if the pool doesn't contain any running
+     * processes, and then launch new processes until the pool contains
+     * `host_pool_size` idle processes again.
+     */
+    PooledHostProcess acquire_pooled_host(Logger& logger,
+                                          const Configuration& config);
+
+    /**
+     * Launch a new group host process on a unique socket that waits up to
+     * `host_pool_idle_timeout` for a plugin.
+     *
+     * @param pipe_output Whether this process's output should be written to
+     *   our logger. Only the process used for this plugin should do that.
+     */
+    PooledHostProcess launch_pooled_host(Logger& logger,
+                                         const Configuration& config,
+                                         bool pipe_output);
+
+    const PluginInfo& plugin_info_;
+    ghc::filesystem::path host_path_;
+    PooledHostProcess host_;
+
+    /**
+     * Set when we could not send the host request to the pooled process before
+     * it exited.
+     */
+    std::atomic_bool startup_failed_;
+
+    /**
+     * Sends the host request to `host_`, polling until the process accepts the
+     * connection in case it's still starting up.
+     */
+    std::jthread pooled_host_connect_handler_;
+};
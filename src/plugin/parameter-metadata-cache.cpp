@@ -0,0 +1,138 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "parameter-metadata-cache.h"
+
+#include <unistd.h>
+#include <fstream>
+#include <iterator>
+
+#include <version.h>
+
+namespace fs = ghc::filesystem;
+
+/**
+ * The directory the cache files are stored in. This follows the XDG base
+ * directory specification. Returns a nullopt if neither `$XDG_CACHE_HOME` nor
+ * `$HOME` are set.
+ */
+std::optional<fs::path> get_cache_directory(const char* subdirectory) {
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    if (const char* directory = getenv("XDG_CACHE_HOME");
+        directory && directory[0] != '\0') {
+        return fs::path(directory) / "yabridge" / subdirectory;
+        // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    } else if (const char* home_directory = getenv("HOME")) {
+        return fs::path(home_directory) / ".cache" / "yabridge" /
+               subdirectory;
+    } else {
+        return std::nullopt;
+    }
+}
+
+ParameterMetadataCache::ParameterMetadataCache(
+    const fs::path& windows_library_path,
+    const std::string& plugin_id,
+    const char* subdirectory) noexcept {
+    const std::optional<fs::path> cache_directory =
+        get_cache_directory(subdirectory);
+    if (!cache_directory) {
+        return;
+    }
+
+    // Hashing the entire library would take longer than just asking the plugin
+    // for its parameters, so the size and modification time will have to do
+    std::error_code err;
+    const fs::path canonical_path =
+        fs::canonical(windows_library_path, err);
+    if (err) {
+        return;
+    }
+    const uintmax_t file_size = fs::file_size(canonical_path, err);
+    if (err) {
+        return;
+    }
+    const fs::file_time_type last_write_time =
+        fs::last_write_time(canonical_path, err);
+    if (err) {
+        return;
+    }
+
+    try {
+        key_ = canonical_path.string() + '\n' + std::to_string(file_size) +
+               '\n' +
+               std::to_string(last_write_time.time_since_epoch().count()) +
+               '\n' + plugin_id + '\n' + yabridge_git_version;
+        path_ = *cache_directory /
+                (std::to_string(std::hash<std::string>{}(key_)) + ".bin");
+    } catch (const std::exception&) {
+        key_.clear();
+    }
+}
+
+std::optional<std::vector<uint8_t>> ParameterMetadataCache::read_file()
+    const noexcept {
+    if (key_.empty()) {
+        return std::nullopt;
+    }
+
+    try {
+        std::ifstream file(path_, std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                                    std::istreambuf_iterator<char>());
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+void ParameterMetadataCache::write_file(
+    const std::vector<uint8_t>& buffer) const noexcept {
+    std::error_code err;
+    fs::create_directories(path_.parent_path(), err);
+    if (err) {
+        return;
+    }
+
+    // Multiple instances of the same plugin may try to write the same file at
+    // the same time, so every process writes to its own temporary file first
+    try {
+        fs::path temporary_path = path_;
+        temporary_path += "." + std::to_string(getpid()) + ".tmp";
+
+        {
+            std::ofstream file(temporary_path,
+                               std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(buffer.data()),
+                       static_cast<std::streamsize>(buffer.size()));
+            if (!file) {
+                file.close();
+                fs::remove(temporary_path, err);
+                return;
+            }
+        }
+
+        fs::rename(temporary_path, path_, err);
+        if (err) {
+            fs::remove(temporary_path, err);
+        }
+    } catch (const std::exception&) {
+        // Same as in `write()`, this is only an optimization
+    }
+}
@@ -0,0 +1,155 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <bitsery/adapter/buffer.h>
+#include <bitsery/bitsery.h>
+#include <bitsery/traits/string.h>
+#include <bitsery/traits/vector.h>
+#include <ghc/filesystem.hpp>
+
+/**
+ * An on-disk cache for a plugin's parameter metadata, used for the
+ * `parameter_metadata_cache` option. Hosts usually enumerate all of a plugin's
+ * parameters every time the plugin gets instantiated, and even when those
+ * queries are batched this still requires the plugin to generate all of that
+ * information. Since the parameter names, units, ranges and flags are almost
+ * always fixed for a plugin binary, we can store them in
+ * `${XDG_CACHE_HOME:-$HOME/.cache}/yabridge/parameters` the first time the
+ * host enumerates them and reuse that information for later instances.
+ *
+ * Every cache file is keyed by the Windows plugin library's path, size and
+ * modification time, the plugin's own identifier (its VST2 unique ID and
+ * version, or its VST3 class ID), and yabridge's version. That key is also
+ * stored inside of the file so hash collisions can never result in the wrong
+ * information being used. Callers should still validate the cached data against
+ * one cheap query, like comparing the number of parameters, before using it.
+ *
+ * Reading and writing never throws. Any errors will cause the cache to be
+ * skipped, after which the caller should simply query the plugin instead.
+ *
+ * The same mechanism is used to store the `AEffect` snapshots for the
+ * `vst2_scan_cache` option, which live in a different subdirectory.
+ */
+class ParameterMetadataCache {
+   public:
+    /**
+     * Determine the cache file for a plugin. If the plugin library can't be
+     * found or if the cache directory can't be determined, then `read()` will
+     * always return a nullopt and `write()` won't do anything.
+     *
+     * @param windows_library_path The path to the Windows `.dll` or `.vst3`
+     *   file. Its size and modification time are part of the cache key.
+     * @param plugin_id A string uniquely identifying the plugin (or for VST3
+     *   plugins, the plugin class) within that library.
+     * @param subdirectory The directory within `~/.cache/yabridge` the file
+     *   should be stored in.
+     */
+    ParameterMetadataCache(const ghc::filesystem::path& windows_library_path,
+                           const std::string& plugin_id,
+                           const char* subdirectory = "parameters") noexcept;
+
+    /**
+     * Read an object previously stored with `write()`. Returns a nullopt if the
+     * file doesn't exist, if it was written for a different key, or if it could
+     * not be deserialized.
+     */
+    template <typename T>
+    std::optional<T> read() const noexcept {
+        const std::optional<std::vector<uint8_t>> buffer = read_file();
+        if (!buffer) {
+            return std::nullopt;
+        }
+
+        Entry<T> entry{};
+        try {
+            const auto [error, completed] = bitsery::quickDeserialization<
+                bitsery::InputBufferAdapter<std::vector<uint8_t>>>(
+                {buffer->begin(), buffer->size()}, entry);
+            if (error != bitsery::ReaderError::NoError || !completed ||
+                entry.key != key_) {
+                return std::nullopt;
+            }
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+
+        return std::move(entry.metadata);
+    }
+
+    /**
+     * Store an object in the cache, replacing the old file if it exists. The
+     * file is written to a temporary file first and then moved into place, so
+     * other processes reading the cache at the same time will never see a
+     * partially written file.
+     */
+    template <typename T>
+    void write(const T& metadata) const noexcept {
+        if (key_.empty()) {
+            return;
+        }
+
+        try {
+            // Bitsery needs a mutable object here, but it won't modify it
+            Entry<T> entry{.key = key_, .metadata = metadata};
+            std::vector<uint8_t> buffer;
+            const size_t size = bitsery::quickSerialization<
+                bitsery::OutputBufferAdapter<std::vector<uint8_t>>>(buffer,
+                                                                    entry);
+            buffer.resize(size);
+
+            write_file(buffer);
+        } catch (const std::exception&) {
+            // The cache is only an optimization, so we'll just try again the
+            // next time
+        }
+    }
+
+   private:
+    /**
+     * The contents of a cache file. The key is stored alongside the metadata so
+     * we can detect hash collisions.
+     */
+    template <typename T>
+    struct Entry {
+        std::string key;
+        T metadata;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.text1b(key, 4096);
+            s.object(metadata);
+        }
+    };
+
+    std::optional<std::vector<uint8_t>> read_file() const noexcept;
+    void write_file(const std::vector<uint8_t>& buffer) const noexcept;
+
+    /**
+     * The full cache key, or an empty string if the plugin's library could not
+     * be found.
+     */
+    std::string key_;
+    /**
+     * The file for `key_`, based on a hash of that key.
+     */
+    ghc::filesystem::path path_;
+};
@@ -16,7 +16,13 @@
 
 #include "utils.h"
 
+#include <fcntl.h>
 #include <unistd.h>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
 
 // Generated inside of the build directory
@@ -38,6 +44,35 @@ fs::path normalize_plugin_path(const fs::path& windows_library_path,
 std::variant<OverridenWinePrefix, fs::path, DefaultWinePrefix> find_wine_prefix(
     fs::path windows_plugin_path);
 
+/**
+ * Every plugin instance creates its own `PluginInfo`, so when loading a project
+ * we would end up locating the same Windows plugin library and parsing the
+ * same PE headers over and over again. These results are cached for the
+ * lifetime of this process. Cached libraries are checked for modifications
+ * using their modification times, since a plugin may get updated while the
+ * host is running, and failed lookups are never cached.
+ */
+fs::path find_plugin_library_cached(const fs::path& this_plugin_path,
+                                    PluginType plugin_type,
+                                    bool prefer_32bit_vst3);
+LibArchitecture find_dll_architecture_cached(const fs::path& plugin_path);
+
+/**
+ * Return the canonical path to the Wine binary and its modification time, used
+ * as the key for caching `PluginInfo::wine_version()`. Returns `std::nullopt`
+ * if the binary can't be found, in which case we'll skip the cache.
+ */
+std::optional<std::pair<fs::path, int64_t>> wine_binary_identity(
+    const std::string& wine_path);
+
+/**
+ * The file used to cache the output of `wine --version` across processes for
+ * the Wine binary at `wine_path`. Plugin scanners and hosts that sandbox
+ * plugins in separate processes would otherwise still spawn Wine for every
+ * plugin.
+ */
+fs::path wine_version_cache_path(const fs::path& wine_path);
+
 PluginInfo::PluginInfo(PluginType plugin_type,
                        const ghc::filesystem::path& plugin_path,
                        bool prefer_32bit_vst3)
@@ -47,10 +82,10 @@ PluginInfo::PluginInfo(PluginType plugin_type,
       // VST3 plugins that come in a module we should be loading that module
       // instead of the `.vst3` file within in, which is where
       // `windows_plugin_path` comes in.
-      windows_library_path_(find_plugin_library(native_library_path_,
-                                                plugin_type,
-                                                prefer_32bit_vst3)),
-      plugin_arch_(find_dll_architecture(windows_library_path_)),
+      windows_library_path_(find_plugin_library_cached(native_library_path_,
+                                                       plugin_type,
+                                                       prefer_32bit_vst3)),
+      plugin_arch_(find_dll_architecture_cached(windows_library_path_)),
       windows_plugin_path_(
           normalize_plugin_path(windows_library_path_, plugin_type)),
       wine_prefix_(find_wine_prefix(windows_plugin_path_)) {}
@@ -100,6 +135,31 @@ std::string PluginInfo::wine_version() const {
         wine_path = wineloader_path;
     }
 
+    // Spawning Wine just to print its version takes a while, so we'll cache
+    // the result both in memory and in the temporary directory. The version
+    // can only change when the binary itself changes.
+    static std::mutex wine_versions_mutex;
+    static std::map<std::pair<fs::path, int64_t>, std::string> wine_versions;
+    const auto identity = wine_binary_identity(wine_path);
+    if (identity) {
+        std::lock_guard lock(wine_versions_mutex);
+        if (auto it = wine_versions.find(*identity);
+            it != wine_versions.end()) {
+            return it->second;
+        }
+
+        std::ifstream cache_file(wine_version_cache_path(identity->first));
+        std::string cached_mtime;
+        std::string cached_version;
+        if (std::getline(cache_file, cached_mtime) &&
+            std::getline(cache_file, cached_version) &&
+            cached_mtime == std::to_string(identity->second) &&
+            !cached_version.empty()) {
+            wine_versions[*identity] = cached_version;
+            return cached_version;
+        }
+    }
+
     Process process(wine_path);
     process.arg("--version");
     process.environment(create_host_env());
@@ -107,7 +167,7 @@ std::string PluginInfo::wine_version() const {
     const auto result = process.spawn_get_stdout_line();
     return std::visit(
         overload{
-            [](std::string version_string) -> std::string {
+            [&](std::string version_string) -> std::string {
                 // Strip the `wine-` prefix from the output, could potentially
                 // be absent in custom Wine builds
                 constexpr std::string_view version_prefix("wine-");
@@ -116,6 +176,19 @@ std::string PluginInfo::wine_version() const {
                         version_string.substr(version_prefix.size());
                 }
 
+                if (identity && !version_string.empty()) {
+                    std::lock_guard lock(wine_versions_mutex);
+                    wine_versions[*identity] = version_string;
+
+                    // If writing the file fails then we'll just spawn Wine
+                    // again next time
+                    std::ofstream cache_file(
+                        wine_version_cache_path(identity->first),
+                        std::ios::trunc);
+                    cache_file << identity->second << std::endl
+                               << version_string << std::endl;
+                }
+
                 return version_string;
             },
             [](const Process::CommandNotFound&) -> std::string {
@@ -128,6 +201,203 @@ std::string PluginInfo::wine_version() const {
         result);
 }
 
+std::string PluginInfo::start_persistent_wineserver(
+    uint32_t persistence_seconds) const {
+    // Every plugin instance in this process loaded from the same Wine prefix
+    // would otherwise try to start its own wineserver
+    static std::mutex started_prefixes_mutex;
+    static std::set<fs::path> started_prefixes;
+    {
+        std::lock_guard lock(started_prefixes_mutex);
+        if (!started_prefixes.insert(normalize_wine_prefix()).second) {
+            return "persistent, started earlier";
+        }
+    }
+
+    // Wine itself also uses `WINESERVER` to find the server binary. Custom
+    // Wine builds used through `WINELOADER` ship their own wineserver, and
+    // the two need to match.
+    std::string wineserver_path = "wineserver";
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* wineserver_env = getenv("WINESERVER");
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* wineloader_env = getenv("WINELOADER");
+    if (wineserver_env && access(wineserver_env, X_OK) == 0) {
+        wineserver_path = wineserver_env;
+    } else if (wineloader_env) {
+        const fs::path sibling_path =
+            fs::path(wineloader_env).parent_path() / "wineserver";
+        if (access(sibling_path.c_str(), X_OK) == 0) {
+            wineserver_path = sibling_path.string();
+        }
+    }
+
+    // The wineserver forks to the background by itself, and it exits right
+    // away when a server is already running for this prefix
+    Process process(wineserver_path);
+    process.arg("-p" + std::to_string(persistence_seconds));
+    process.environment(create_host_env());
+
+    const auto result = process.spawn_get_status();
+    return std::visit(
+        overload{
+            [&](int status) -> std::string {
+                if (status == 0) {
+                    return "persistent for " +
+                           std::to_string(persistence_seconds) + " seconds";
+                } else {
+                    return "already running";
+                }
+            },
+            [](const Process::CommandNotFound&) -> std::string {
+                return "<NOT FOUND>";
+            },
+            [](const std::error_code& err) -> std::string {
+                return "<ERROR SPAWNING WINESERVER: " + err.message() + " >";
+            },
+        },
+        result);
+}
+
+void PluginInfo::readahead_plugin_files(std::stop_token stop_token) const {
+    // Some VST3 bundles also contain huge sample libraries in their resources
+    // directory, and we don't want to push everything else out of the page
+    // cache for those
+    constexpr uintmax_t max_readahead_bytes = 1ull << 30;
+
+    uintmax_t total_bytes = 0;
+    const auto readahead_file = [&](const fs::path& path) {
+        std::error_code err;
+        const uintmax_t file_size = fs::file_size(path, err);
+        if (err || total_bytes + file_size > max_readahead_bytes) {
+            return;
+        }
+
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return;
+        }
+
+        // This only schedules the reads, so it returns before all of the data
+        // has been read
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+
+        total_bytes += file_size;
+    };
+
+    // The library itself is the most important part, so that comes first
+    readahead_file(windows_library_path_);
+
+    std::error_code err;
+    if (!fs::is_directory(windows_plugin_path_, err)) {
+        return;
+    }
+
+    for (auto it = fs::recursive_directory_iterator(windows_plugin_path_, err);
+         !err && it != fs::recursive_directory_iterator();
+         it.increment(err)) {
+        if (stop_token.stop_requested()) {
+            return;
+        }
+
+        if (it->is_regular_file(err) && it->path() != windows_library_path_) {
+            readahead_file(it->path());
+        }
+    }
+}
+
+fs::path find_plugin_library_cached(const fs::path& this_plugin_path,
+                                    PluginType plugin_type,
+                                    bool prefer_32bit_vst3) {
+    static std::mutex libraries_mutex;
+    static std::map<std::tuple<fs::path, PluginType, bool>, fs::path> libraries;
+
+    const auto key =
+        std::tuple(this_plugin_path, plugin_type, prefer_32bit_vst3);
+    {
+        std::lock_guard lock(libraries_mutex);
+        if (auto it = libraries.find(key);
+            it != libraries.end() && fs::exists(it->second)) {
+            return it->second;
+        }
+    }
+
+    // This may throw, in which case we won't cache anything
+    fs::path library_path =
+        find_plugin_library(this_plugin_path, plugin_type, prefer_32bit_vst3);
+
+    std::lock_guard lock(libraries_mutex);
+    libraries[key] = library_path;
+
+    return library_path;
+}
+
+LibArchitecture find_dll_architecture_cached(const fs::path& plugin_path) {
+    static std::mutex architectures_mutex;
+    static std::map<fs::path, std::pair<fs::file_time_type, LibArchitecture>>
+        architectures;
+
+    std::error_code err;
+    const fs::file_time_type last_write_time =
+        fs::last_write_time(plugin_path, err);
+    if (!err) {
+        std::lock_guard lock(architectures_mutex);
+        if (auto it = architectures.find(plugin_path);
+            it != architectures.end() &&
+            it->second.first == last_write_time) {
+            return it->second.second;
+        }
+    }
+
+    // Just like the above, this throws if the file isn't a valid PE file
+    const LibArchitecture architecture = find_dll_architecture(plugin_path);
+    if (!err) {
+        std::lock_guard lock(architectures_mutex);
+        architectures[plugin_path] = std::pair(last_write_time, architecture);
+    }
+
+    return architecture;
+}
+
+std::optional<std::pair<fs::path, int64_t>> wine_binary_identity(
+    const std::string& wine_path) {
+    std::optional<fs::path> resolved_path;
+    if (wine_path.find('/') != std::string::npos) {
+        resolved_path = wine_path;
+    } else {
+        // NOLINTNEXTLINE(concurrency-mt-unsafe)
+        const char* path_env = getenv("PATH");
+        resolved_path = search_in_path(split_path(path_env ? path_env : ""),
+                                       wine_path);
+    }
+    if (!resolved_path) {
+        return std::nullopt;
+    }
+
+    std::error_code err;
+    const fs::path canonical_path = fs::canonical(*resolved_path, err);
+    if (err) {
+        return std::nullopt;
+    }
+
+    const fs::file_time_type last_write_time =
+        fs::last_write_time(canonical_path, err);
+    if (err) {
+        return std::nullopt;
+    }
+
+    return std::pair(canonical_path,
+                     static_cast<int64_t>(
+                         last_write_time.time_since_epoch().count()));
+}
+
+fs::path wine_version_cache_path(const fs::path& wine_path) {
+    return get_temporary_directory() /
+           ("yabridge-wine-version-" +
+            std::to_string(std::hash<std::string>{}(wine_path.string())));
+}
+
 fs::path find_plugin_library(const fs::path& this_plugin_path,
                              PluginType plugin_type,
                              bool prefer_32bit_vst3) {
@@ -355,12 +625,116 @@ ghc::filesystem::path generate_group_endpoint(
 
 Configuration load_config_for(const fs::path& yabridge_path) {
     // First find the closest `yabridge.tmol` file for the plugin, falling back
-    // to default configuration settings if it doesn't exist
-    const std::optional<fs::path> config_file =
-        find_dominating_file("yabridge.toml", yabridge_path);
+    // to default configuration settings if it doesn't exist. Plugins in the
+    // same directory will always end up with the same file, so we'll remember
+    // where we found it. Negative results are not cached so a new
+    // `yabridge.toml` file will still be picked up without restarting the
+    // host, as long as no other file higher up the tree was used already.
+    static std::mutex config_files_mutex;
+    static std::map<fs::path, fs::path> config_files;
+
+    const fs::path plugin_dir = yabridge_path.parent_path();
+    std::optional<fs::path> config_file;
+    {
+        std::lock_guard lock(config_files_mutex);
+        if (auto it = config_files.find(plugin_dir);
+            it != config_files.end() && fs::exists(it->second)) {
+            config_file = it->second;
+        }
+    }
+
     if (!config_file) {
-        return Configuration();
+        config_file = find_dominating_file("yabridge.toml", yabridge_path);
+        if (!config_file) {
+            return Configuration();
+        }
+
+        std::lock_guard lock(config_files_mutex);
+        config_files[plugin_dir] = *config_file;
     }
 
     return Configuration(*config_file, yabridge_path);
 }
+
+void ProcessDeadlineMonitor::check(Logger& logger,
+                                   float deadline_fraction,
+                                   double sample_rate,
+                                   int sample_frames,
+                                   const AudioShmBuffer& buffer,
+                                   const BlockTimes& times) {
+    using namespace std::chrono_literals;
+
+    if (sample_rate <= 0.0 || sample_frames <= 0) {
+        return;
+    }
+
+    const auto deadline = std::chrono::duration<double>(
+        static_cast<double>(sample_frames) / sample_rate);
+    const auto total = times.end - times.start;
+    if (total <= deadline * static_cast<double>(deadline_fraction)) {
+        return;
+    }
+
+    if (times.end - last_warning_ < 1s) {
+        suppressed_warnings_++;
+        return;
+    }
+
+    const AudioShmBuffer::BlockTimings& wine_timings =
+        buffer.last_block_timings();
+    const auto from_ns = [](uint64_t ns) {
+        return std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(ns)));
+    };
+    const auto received =
+        from_ns(wine_timings.received_ns.load(std::memory_order_relaxed));
+    const auto plugin_start =
+        from_ns(wine_timings.plugin_start_ns.load(std::memory_order_relaxed));
+    const auto plugin_end =
+        from_ns(wine_timings.plugin_end_ns.load(std::memory_order_relaxed));
+    const std::chrono::nanoseconds callbacks(
+        wine_timings.callbacks_ns.load(std::memory_order_relaxed));
+    const bool wine_realtime =
+        wine_timings.realtime.load(std::memory_order_relaxed) != 0;
+
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(3);
+    const auto print_duration = [&](const char* label, auto duration) {
+        // Both processes use the same clock, but the Wine plugin host may start
+        // handling the request before our write returns
+        message << label
+                << std::max(
+                       std::chrono::duration<double, std::milli>(duration)
+                           .count(),
+                       0.0)
+                << " ms";
+    };
+
+    message << "WARNING: Processing " << sample_frames << " samples took ";
+    print_duration("", total);
+    message << ", exceeding " << std::setprecision(0)
+            << (deadline_fraction * 100.0f) << "% of the "
+            << std::setprecision(3);
+    print_duration("", deadline);
+    message << " deadline (";
+    print_duration("send: ", times.sent - times.start);
+    print_duration(", Wine wakeup: ", received - times.sent);
+    print_duration(", Wine setup: ", plugin_start - received);
+    print_duration(", plugin: ", plugin_end - plugin_start - callbacks);
+    print_duration(", host callbacks: ", callbacks);
+    print_duration(", response: ", times.response_received - plugin_end);
+    print_duration(", copy back: ", times.end - times.response_received);
+    message << ", realtime scheduling: host "
+            << (is_realtime_scheduled() ? "yes" : "no")
+            << ", Wine " << (wine_realtime ? "yes" : "no") << ")";
+    if (suppressed_warnings_ > 0) {
+        message << ", " << suppressed_warnings_
+                << " more blocks exceeded the deadline since the last warning";
+    }
+
+    logger.log(message.str());
+
+    last_warning_ = times.end;
+    suppressed_warnings_ = 0;
+}
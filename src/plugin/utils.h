@@ -16,9 +16,12 @@
 
 #pragma once
 
+#include <stop_token>
 #include <variant>
 
+#include "../common/audio-shm.h"
 #include "../common/configuration.h"
+#include "../common/logging/common.h"
 #include "../common/plugins.h"
 #include "../common/process.h"
 #include "../common/utils.h"
@@ -97,9 +100,38 @@ struct PluginInfo {
      *
      * This will *not* throw when Wine can not be found, but will instead return
      * '<NOT FOUND>'. This way the user will still get some useful log files.
+     *
+     * The result is cached in memory and in `get_temporary_directory()`, keyed
+     * by the Wine binary's canonical path and modification time, so we only
+     * have to spawn Wine again after it has been updated.
      */
     std::string wine_version() const;
 
+    /**
+     * Start a wineserver for the plugin's Wine prefix that keeps running for
+     * `persistence_seconds` after the last Wine process in the prefix exits,
+     * using `wineserver -p<seconds>`. This respects the `WINESERVER`
+     * environment variable, and otherwise uses the `wineserver` binary next to
+     * `WINELOADER` if that is set. This is only done once per Wine prefix per
+     * process. Like `wine_version()`, this will not throw, and it instead
+     * returns a short description of what happened for the init message.
+     *
+     * @see Configuration::wineserver_persistence
+     */
+    std::string start_persistent_wineserver(uint32_t persistence_seconds) const;
+
+    /**
+     * Ask the kernel to start reading the Windows plugin library into the page
+     * cache using `posix_fadvise(POSIX_FADV_WILLNEED)`. For VST3 bundles this
+     * also covers the rest of the bundle's files, up to a fixed total size.
+     * Large instruments can easily be hundreds of megabytes, and this lets the
+     * disk I/O overlap with Wine's startup instead of only starting once the
+     * Wine plugin host loads the library. This should be run from a
+     * background thread, and it will stop early when `stop_token` is
+     * triggered. Errors are ignored.
+     */
+    void readahead_plugin_files(std::stop_token stop_token) const;
+
     const PluginType plugin_type_;
 
     /**
@@ -109,17 +141,16 @@ struct PluginInfo {
      */
     const ghc::filesystem::path native_library_path_;
 
-   private:
     /**
      * The path to the Windows library (`.dll` or `.vst3`, not to be confused
      * with a `.vst3` bundle) that we're targeting. This should **not** be
      * passed to the plugin host and `windows_plugin_path_` should be used
      * instead. We store this intermediate value so we can determine the
-     * plugin's architecture.
+     * plugin's architecture, and so we can detect when the plugin has been
+     * updated for the `parameter_metadata_cache` option.
      */
     const ghc::filesystem::path windows_library_path_;
 
-   public:
     const LibArchitecture plugin_arch_;
 
     /**
@@ -152,6 +183,64 @@ struct PluginInfo {
             wine_prefix_;
 };
 
+/**
+ * Checks whether bridged audio processing calls finished within the duration
+ * of the block they processed, for the `audio_deadline_warning` option. Blocks
+ * that take too long are logged with a breakdown of where the time went,
+ * combining the timestamps taken on this side with the `BlockTimings` the Wine
+ * plugin host wrote to the shared memory object. Warnings are limited to one
+ * per second since a plugin that's too heavy for the current buffer size would
+ * otherwise produce one for every block. There should be one of these per
+ * plugin instance, and it should only be used from the audio thread.
+ */
+class ProcessDeadlineMonitor {
+   public:
+    /**
+     * The timestamps taken on the native side for a single processing call.
+     */
+    struct BlockTimes {
+        /**
+         * When the host called the plugin's processing function.
+         */
+        std::chrono::steady_clock::time_point start;
+        /**
+         * When the request was sent to the Wine plugin host, after the inputs
+         * had been written to the shared memory object.
+         */
+        std::chrono::steady_clock::time_point sent;
+        /**
+         * When we learned that the Wine plugin host had finished processing.
+         */
+        std::chrono::steady_clock::time_point response_received;
+        /**
+         * When the outputs have been copied back to the host's buffers.
+         */
+        std::chrono::steady_clock::time_point end;
+    };
+
+    /**
+     * Log a warning with a breakdown of the block's timings if processing
+     * took longer than `deadline_fraction` times the duration of
+     * `sample_frames` samples at `sample_rate`. This may allocate when it
+     * needs to log something, so it should not be called from within a
+     * `ScopedRealtimeSection`, and it has to be called from the host's audio
+     * thread.
+     */
+    void check(Logger& logger,
+               float deadline_fraction,
+               double sample_rate,
+               int sample_frames,
+               const AudioShmBuffer& buffer,
+               const BlockTimes& times);
+
+   private:
+    std::chrono::steady_clock::time_point last_warning_;
+    /**
+     * The number of blocks that exceeded the deadline since the last warning.
+     */
+    uint64_t suppressed_warnings_ = 0;
+};
+
 /**
  * Returns equality for two strings when ignoring casing. Used for comparing
  * filenames inside of Wine prefixes since Windows/Wine does case folding for
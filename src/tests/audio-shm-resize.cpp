@@ -0,0 +1,83 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Checks that growing a shared audio buffer within the capacity it already has
+// doesn't remap it, and that every resize still counts as a new generation
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "../common/audio-shm.h"
+
+namespace {
+
+bool check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << message << std::endl;
+    }
+
+    return condition;
+}
+
+}  // namespace
+
+int main() {
+    AudioShmBuffer::Config config{
+        .name = "yabridge-audio-shm-resize-test-" + std::to_string(getpid()),
+        .size = 4096,
+        .capacity = 8192,
+        .input_offsets = {{0}},
+        .output_offsets = {{512}}};
+    AudioShmBuffer buffer(config);
+
+    bool success = true;
+    success &= check(buffer.capacity() == 8192,
+                     "The initial capacity was not allocated");
+
+    float* input = buffer.input_channel_ptr<float>(0, 0);
+    *input = 42.0f;
+    const uint32_t initial_generation = buffer.generation();
+
+    // The requested capacity including the headroom grows, but the new size
+    // still fits in the existing mapping
+    config.size = 6144;
+    config.capacity = 9216;
+    buffer.resize(config);
+    success &= check(buffer.capacity() == 8192,
+                     "Growing within the capacity changed the capacity");
+    success &= check(buffer.input_channel_ptr<float>(0, 0) == input &&
+                         *input == 42.0f,
+                     "Growing within the capacity remapped the buffer");
+    success &= check(buffer.generation() == initial_generation + 1,
+                     "Resizing in place did not start a new generation");
+
+    // This no longer fits, so the buffer grows to the requested capacity
+    config.size = 12288;
+    config.capacity = 18432;
+    buffer.resize(config);
+    success &= check(buffer.capacity() == 18432,
+                     "Growing past the capacity did not grow the buffer");
+    success &= check(*buffer.input_channel_ptr<float>(0, 0) == 42.0f,
+                     "Growing the buffer lost its contents");
+    success &= check(buffer.generation() == initial_generation + 2,
+                     "Growing the buffer did not start a new generation");
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
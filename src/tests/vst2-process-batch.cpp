@@ -0,0 +1,65 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Checks that batches passed to `yabridgeVendorSpecificProcessBatch` that
+// contain the same plugin instance more than once get rejected, so the host
+// falls back to processing every instance separately
+
+#include <cstdlib>
+#include <iostream>
+
+#include <vestige/aeffectx.h>
+
+#include "../common/vst24.h"
+
+namespace {
+
+YabridgeProcessBatchEntry entry_for(AEffect& effect) {
+    YabridgeProcessBatchEntry entry{};
+    entry.effect = &effect;
+
+    return entry;
+}
+
+}  // namespace
+
+int main() {
+    AEffect first{};
+    AEffect second{};
+
+    const YabridgeProcessBatchEntry unique_entries[] = {entry_for(first),
+                                                        entry_for(second)};
+    const YabridgeProcessBatchEntry duplicate_entries[] = {
+        entry_for(first), entry_for(second), entry_for(first)};
+
+    bool success = true;
+    if (process_batch_has_duplicates(unique_entries, 2)) {
+        std::cerr << "A batch without duplicates was rejected" << std::endl;
+        success = false;
+    }
+    if (!process_batch_has_duplicates(duplicate_entries, 3)) {
+        std::cerr << "A batch with a duplicated instance was accepted"
+                  << std::endl;
+        success = false;
+    }
+    if (process_batch_has_duplicates(duplicate_entries, 1)) {
+        std::cerr << "A single entry batch was rejected" << std::endl;
+        success = false;
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -17,6 +17,7 @@
 #include "common.h"
 
 #include <iostream>
+#include <sstream>
 
 #include "../../common/process.h"
 #include "../editor.h"
@@ -48,6 +49,13 @@ constexpr int extended_max_win32_messages = 8192;
  */
 constexpr unsigned int juce_message_id = WM_USER + 123;
 
+/**
+ * How often `HostBridge::async_advise_anonymous_memory()` looks for newly
+ * allocated memory regions. Sample libraries are usually loaded well after the
+ * plugin has been initialized, but they're not loaded in a hurry either.
+ */
+constexpr std::chrono::seconds memory_advice_interval(30);
+
 HostBridge::HostBridge(MainContext& main_context,
                        ghc::filesystem::path plugin_path,
                        pid_t parent_pid)
@@ -55,14 +63,26 @@ HostBridge::HostBridge(MainContext& main_context,
       main_context_(main_context),
       generic_logger_(Logger::create_wine_stderr()),
       parent_pid_(parent_pid),
-      watchdog_guard_(main_context.register_watchdog(*this)) {}
+      watchdog_guard_(main_context.register_watchdog(*this, parent_pid)),
+      idle_release_timer_(main_context.context_),
+      memory_advice_timer_(main_context.context_) {}
+
+bool HostBridge::handle_events() noexcept {
+    // Checking the queue status first is much cheaper than a full
+    // `PeekMessage()` sweep when nothing is pending, which is the common case
+    // when a process hosts a lot of plugins without open editors. We can't
+    // actually block in `MsgWaitForMultipleObjectsEx()`, since this thread also
+    // needs to run `main_context_`, so we only use it to poll.
+    if (MsgWaitForMultipleObjectsEx(0, nullptr, 0, QS_ALLINPUT,
+                                    MWMO_INPUTAVAILABLE) != WAIT_OBJECT_0) {
+        return false;
+    }
 
-void HostBridge::handle_events() noexcept {
     MSG msg;
 
     int limit = max_win32_messages;
-    for (int i = 0; i < limit && PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE);
-         i++) {
+    int i = 0;
+    for (; i < limit && PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE); i++) {
         // HACK: See the docstring on `juce_win32_message_limit`
         if (msg.message == juce_message_id) {
             limit = extended_max_win32_messages;
@@ -71,6 +91,8 @@ void HostBridge::handle_events() noexcept {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
+
+    return i > 0;
 }
 
 void HostBridge::shutdown_if_dangling() {
@@ -78,8 +100,8 @@ void HostBridge::shutdown_if_dangling() {
     // outliving the process it's supposed to be connected to (because in some
     // situations sockets won't get closed when this happens so we'd hang on
     // `recv()`), then we'll close the sockets here so that the plugin bridge
-    // exits gracefully. This will be periodically called from `MainContext`'s
-    // watchdog thread.
+    // exits gracefully. This will be called from `MainContext`'s watchdog
+    // thread.
     if (!pid_running(parent_pid_)) {
         std::cerr << "WARNING: The native plugin host seems to have died."
                   << std::endl;
@@ -98,3 +120,142 @@ void HostBridge::shutdown_if_dangling() {
         TerminateProcess(GetCurrentProcess(), 0);
     }
 }
+
+std::vector<HostBridge::AudioBufferInfo> HostBridge::audio_buffers() {
+    std::lock_guard lock(audio_buffers_mutex_);
+
+    std::vector<AudioBufferInfo> buffers;
+    buffers.reserve(audio_buffers_.size());
+    for (const auto& [instance_id, info] : audio_buffers_) {
+        buffers.push_back(info);
+    }
+
+    return buffers;
+}
+
+void HostBridge::track_audio_buffer(size_t instance_id,
+                                    const AudioShmBuffer::Config& config) {
+    std::lock_guard lock(audio_buffers_mutex_);
+    audio_buffers_[instance_id] = AudioBufferInfo{.instance_id = instance_id,
+                                                  .shm_name = config.name,
+                                                  .capacity = config.capacity};
+}
+
+void HostBridge::untrack_audio_buffer(size_t instance_id) {
+    std::lock_guard lock(audio_buffers_mutex_);
+    audio_buffers_.erase(instance_id);
+}
+
+void HostBridge::async_release_idle_audio_buffers(
+    std::chrono::steady_clock::duration timeout) {
+    idle_release_timer_.expires_after(timeout);
+    idle_release_timer_.async_wait(
+        [&, timeout](const std::error_code& error) {
+            // The timer gets cancelled when the bridge shuts down
+            if (error) {
+                return;
+            }
+
+            release_idle_audio_buffers(timeout);
+            async_release_idle_audio_buffers(timeout);
+        });
+}
+
+void HostBridge::async_advise_anonymous_memory(bool mergeable,
+                                               bool huge_pages) {
+    advise_anonymous_memory(mergeable, huge_pages);
+
+    memory_advice_timer_.expires_after(memory_advice_interval);
+    memory_advice_timer_.async_wait(
+        [&, mergeable, huge_pages](const std::error_code& error) {
+            // The timer gets cancelled when the bridge shuts down
+            if (error) {
+                return;
+            }
+
+            async_advise_anonymous_memory(mergeable, huge_pages);
+        });
+}
+
+void HostBridge::follow_numa_node(const Configuration& config,
+                                  int node,
+                                  std::optional<AudioShmBuffer>& buffers) {
+    if (!config.follows_host_audio_thread_cpu() &&
+        !config.audio_thread_host_mapping) {
+        set_audio_thread_numa_affinity(config.audio_thread_cpus, node);
+    }
+    if (buffers) {
+        buffers->bind_to_numa_node(node);
+    }
+}
+
+void HostBridge::watch_config_file(Configuration& config) {
+    if (!config.matched_file) {
+        return;
+    }
+
+    config_watch_ = main_context_.watch_file(
+        *config.matched_file, [this, &config]() { reload_config(config); });
+}
+
+void HostBridge::reload_config(Configuration& config) {
+    Configuration new_config;
+    try {
+        new_config = config.reload();
+    } catch (const std::exception& error) {
+        generic_logger_.log("Could not reload '" +
+                            config.matched_file->string() + "':");
+        generic_logger_.log(error.what());
+        return;
+    }
+
+    // These options are only read from the main thread, so they can be changed
+    // while the plugin is running. All options except for `frame_rate` are
+    // read when opening an editor, so they'll apply to the next editor. The
+    // diagnostic fields are not options, so those don't need to be compared.
+    std::vector<std::string> applied_options;
+    const auto apply = [&](auto& option, const auto& new_value,
+                           const char* name) {
+        if (option != new_value) {
+            option = new_value;
+            applied_options.push_back(name);
+        }
+    };
+    apply(config.editor_coordinate_hack, new_config.editor_coordinate_hack,
+          "editor_coordinate_hack");
+    apply(config.editor_force_dnd, new_config.editor_force_dnd,
+          "editor_force_dnd");
+    apply(config.editor_obscured_frame_rate,
+          new_config.editor_obscured_frame_rate, "editor_obscured_frame_rate");
+    apply(config.editor_xembed, new_config.editor_xembed, "editor_xembed");
+    if (config.frame_rate != new_config.frame_rate) {
+        apply(config.frame_rate, new_config.frame_rate, "frame_rate");
+        main_context_.update_timer_interval(config.event_loop_interval(),
+                                            config.event_loop_idle_backoff);
+    }
+
+    new_config.matched_file = config.matched_file;
+    new_config.matched_pattern = config.matched_pattern;
+    new_config.invalid_options = config.invalid_options;
+    new_config.unknown_options = config.unknown_options;
+
+    std::ostringstream message;
+    message << "Reloaded '" << config.matched_file->string() << "'";
+    if (applied_options.empty()) {
+        message << ", none of the options that can be changed at runtime "
+                   "were changed";
+    } else {
+        message << ", applied ";
+        for (bool first = true; const auto& option : applied_options) {
+            message << (first ? "" : ", ") << option;
+            first = false;
+        }
+    }
+    generic_logger_.log(message.str());
+
+    if (new_config != config) {
+        generic_logger_.log(
+            "Some of the other changed options will only take effect after "
+            "the plugin has been reloaded");
+    }
+}
@@ -18,8 +18,13 @@
 
 #include "../asio-fix.h"
 
+#include <map>
+#include <mutex>
+
 #include <ghc/filesystem.hpp>
 
+#include "../../common/audio-shm.h"
+#include "../../common/configuration.h"
 #include "../../common/logging/common.h"
 #include "../utils.h"
 
@@ -66,6 +71,19 @@ class HostBridge {
      */
     virtual void run() = 0;
 
+    /**
+     * Get a handle that keeps this plugin's library loaded after the bridge
+     * has been destroyed, if the `group_module_cache` option is enabled. Group
+     * host processes will hold on to this for `module_unload_grace_period`
+     * after the plugin exits so new instances of the same plugin don't have to
+     * load the library again. The handle has to be released on the main
+     * thread, just like the bridge itself.
+     *
+     * @return A handle to the plugin's library or module, or a null pointer if
+     *   the option is not enabled.
+     */
+    virtual std::shared_ptr<void> retain_module() = 0;
+
     /**
      * Run the message loop for this plugin. This should be called from a timer.
      * X11 events for the open editors are also handled in this same way,
@@ -84,8 +102,17 @@ class HostBridge {
      * specific situation that can cause a race condition in some plugins
      * because of incorrect assumptions made by the plugin. See the dostring for
      * `Vst2Bridge::editor` for more information.
+     *
+     * NOTE: The Win32 message queue belongs to the thread, not to a plugin
+     *       instance, so there's no way to only pump messages for the
+     *       instances that have an editor open or a timer pending. What we can
+     *       do is skip the sweep entirely when the queue is empty.
+     *
+     * @return Whether any messages were handled. This is used to decide whether
+     *   the event loop can back off when the `event_loop_idle_backoff` option
+     *   is enabled.
      */
-    static void handle_events() noexcept;
+    static bool handle_events() noexcept;
 
     /**
      * Used as part of the watchdog. This will check whether the remote host
@@ -95,6 +122,27 @@ class HostBridge {
      */
     void shutdown_if_dangling();
 
+    /**
+     * A shared memory audio buffer used by one of this bridge's plugin
+     * instances.
+     */
+    struct AudioBufferInfo {
+        /**
+         * The VST3 object instance ID. Always 0 for VST2 plugins.
+         */
+        size_t instance_id;
+        std::string shm_name;
+        uint32_t capacity;
+    };
+
+    /**
+     * The shared memory audio buffers currently used by this bridge, for the
+     * group host's metrics endpoint. This can be called from any thread. The
+     * statistics stored in these buffers can be read with
+     * `AudioShmBuffer::read_processing_stats()`.
+     */
+    std::vector<AudioBufferInfo> audio_buffers();
+
     /**
      * The path to the .dll being loaded in the Wine plugin host.
      */
@@ -109,6 +157,75 @@ class HostBridge {
      */
     virtual void close_sockets() = 0;
 
+    /**
+     * Remember the name and size of an instance's audio buffers after they
+     * have been set up or resized.
+     *
+     * @see audio_buffers
+     */
+    void track_audio_buffer(size_t instance_id,
+                            const AudioShmBuffer::Config& config);
+
+    /**
+     * Forget about an instance's audio buffers after it has been destroyed.
+     */
+    void untrack_audio_buffer(size_t instance_id);
+
+    /**
+     * Call `release_idle_audio_buffers()` every `timeout` on the main thread.
+     * This should be called at the end of the bridge's constructor when the
+     * `audio_buffer_idle_release_s` option is set.
+     */
+    void async_release_idle_audio_buffers(
+        std::chrono::steady_clock::duration timeout);
+
+    /**
+     * Call `advise_anonymous_memory()` now and then periodically on the main
+     * thread, so memory the plugin allocates later on is also covered. This
+     * should be called at the end of the bridge's constructor when the
+     * `memory_merging` or `memory_huge_pages` options are enabled.
+     */
+    void async_advise_anonymous_memory(bool mergeable, bool huge_pages);
+
+    /**
+     * Move the calling audio thread and an instance's audio buffers to the
+     * host audio thread's NUMA node for the
+     * `audio_thread_follow_host_numa_node` option. The thread's affinity is
+     * left alone when it's already pinned to a single core by
+     * `audio_thread_follow_host_cpu` or `audio_thread_host_mapping`. Called
+     * from the audio thread when the node changes.
+     *
+     * @param config The bridge's configuration.
+     * @param node The NUMA node the host's audio thread is now running on.
+     * @param buffers The instance's audio buffers, if they have been set up.
+     */
+    static void follow_numa_node(const Configuration& config,
+                                 int node,
+                                 std::optional<AudioShmBuffer>& buffers);
+
+    /**
+     * Release the memory backing the shared audio buffers of every plugin
+     * instance that has not processed any audio for at least `timeout` and
+     * that doesn't have an open editor.
+     *
+     * @see IdleBufferRelease
+     */
+    virtual void release_idle_audio_buffers(
+        std::chrono::steady_clock::duration timeout) = 0;
+
+    /**
+     * Watch the configuration file `config` was loaded from, and apply changes
+     * made to that file to the options that can safely be changed while the
+     * plugin is running. These are the options that are only read from the
+     * main thread. Changes to any other options are logged, but those will
+     * only take effect after the plugin has been reloaded. This should be
+     * called at the end of the bridge's constructor.
+     *
+     * @param config The bridge's configuration. This will only be modified
+     *   from the main thread.
+     */
+    void watch_config_file(Configuration& config);
+
     /**
      * The IO context used for event handling so that all events and window
      * message handling can be performed from a single thread, even when hosting
@@ -125,19 +242,54 @@ class HostBridge {
      */
     Logger generic_logger_;
 
+    /**
+     * When this bridge started initializing. Used to log how long loading the
+     * plugin's library took, since that happens before the native plugin can
+     * time anything.
+     */
+    const std::chrono::steady_clock::time_point construction_start_ =
+        std::chrono::steady_clock::now();
+
    private:
     /**
      * The process ID of the native plugin host we are bridging for. This should
      * be the parent, but it might not be because of Wine's startup script,
-     * `WINELOADER`s and Wine's `start.exe` behaviour. We'll periodically check
-     * if this process is still alive, and close the sockets if it is not to
-     * prevent dangling processes.
+     * `WINELOADER`s and Wine's `start.exe` behaviour. We'll watch this process,
+     * and close the sockets when it exits to prevent dangling processes.
      */
     const pid_t parent_pid_;
 
     /**
-     * A guard that, while in scope, will cause `shutdown_if_dangling()` to
-     * periodically be called.
+     * A guard that, while in scope, will cause `shutdown_if_dangling()` to be
+     * called when the native host process exits.
      */
     MainContext::WatchdogGuard watchdog_guard_;
+
+    /**
+     * @see audio_buffers
+     */
+    std::map<size_t, AudioBufferInfo> audio_buffers_;
+    std::mutex audio_buffers_mutex_;
+
+    /**
+     * @see async_release_idle_audio_buffers
+     */
+    asio::steady_timer idle_release_timer_;
+
+    /**
+     * @see async_advise_anonymous_memory
+     */
+    asio::steady_timer memory_advice_timer_;
+
+    /**
+     * Reread `config` from its configuration file after it has changed.
+     *
+     * @see watch_config_file
+     */
+    void reload_config(Configuration& config);
+
+    /**
+     * @see watch_config_file
+     */
+    std::unique_ptr<MainContext::FileWatchGuard> config_watch_;
 };
@@ -18,10 +18,14 @@
 
 #include "../asio-fix.h"
 
+#include <fcntl.h>
 #include <unistd.h>
+#include <fstream>
 #include <regex>
+#include <sstream>
 
 #include "../../common/communication/common.h"
+#include "../../common/logging/histograms.h"
 #include "vst2.h"
 #ifdef WITH_VST3
 #include "vst3.h"
@@ -33,6 +37,42 @@ namespace fs = ghc::filesystem;
 
 using namespace std::literals::chrono_literals;
 
+/**
+ * How long a group host process keeps a plugin's library loaded after the
+ * plugin has exited when the `group_module_cache` option is enabled.
+ */
+constexpr std::chrono::steady_clock::duration module_unload_grace_period = 30s;
+
+/**
+ * How long a group host process waits after a plugin has exited before it
+ * unloads the exited plugins. Every plugin that exits in the meantime restarts
+ * this timer, so when the host closes a project all of its plugins get torn
+ * down in a single batch. This keeps the main thread free to handle the other
+ * plugins' shutdown while the host is still closing them.
+ */
+constexpr std::chrono::steady_clock::duration closing_batch_delay = 250ms;
+
+/**
+ * The size we'll try to resize the STDOUT and STDERR capture pipes to. The
+ * default of 64 KiB fills up quickly when a plugin prints something for every
+ * processed block. This is the default maximum for unprivileged users, and the
+ * default size is kept if the kernel doesn't allow it.
+ */
+constexpr int captured_pipe_size = 1 << 20;
+
+/**
+ * How many bytes worth of captured output lines `StdIoForwarder` may queue
+ * before it starts dropping lines.
+ */
+constexpr size_t max_queued_output_bytes = 1 << 20;
+
+/**
+ * How many captured output lines `StdIoForwarder` forwards to the log per
+ * second. Anything beyond this is dropped, since a log file full of the same
+ * line printed every processing cycle is not useful anyways.
+ */
+constexpr uint32_t max_output_lines_per_second = 1000;
+
 /**
  * Listen on the specified endpoint if no process is already listening there,
  * otherwise throw. This is needed to handle these three situations:
@@ -58,6 +98,21 @@ asio::local::stream_protocol::acceptor create_acceptor_if_inactive(
  */
 std::string create_logger_prefix(const fs::path& socket_path);
 
+/**
+ * Escape a string for use as a label value in Prometheus' text format.
+ */
+std::string escape_label_value(const std::string& value);
+
+/**
+ * The state for a single connection to the metrics socket. This is kept alive
+ * by the asynchronous operations' completion handlers.
+ */
+struct MetricsConnection {
+    asio::local::stream_protocol::socket socket;
+    std::array<char, 1024> request_buffer{};
+    std::string response{};
+};
+
 StdIoCapture::StdIoCapture(asio::io_context& io_context, int file_descriptor)
     : pipe_(io_context),
       target_fd_(file_descriptor),
@@ -69,6 +124,10 @@ StdIoCapture::StdIoCapture(asio::io_context& io_context, int file_descriptor)
         throw std::system_error(errno, std::system_category());
     }
 
+    // Plugins writing to the pipe block when it's full, so we'll give the
+    // reading end some more slack. Failing to do so is not an issue.
+    fcntl(pipe_fd_[0], F_SETPIPE_SZ, captured_pipe_size);
+
     // We've already created a copy of the original file descriptor, so we can
     // reopen it using the newly created pipe
     dup2(pipe_fd_[1], target_fd_);
@@ -85,9 +144,100 @@ StdIoCapture::~StdIoCapture() noexcept {
     close(pipe_fd_[0]);
 }
 
-GroupBridge::GroupBridge(ghc::filesystem::path group_socket_path)
+StdIoForwarder::StdIoForwarder(Logger& logger)
+    : logger_(logger),
+      window_start_(std::chrono::steady_clock::now()),
+      writer_([this](std::stop_token stop_token) {
+          pthread_setname_np(pthread_self(), "group-stdio-log");
+
+          write_lines(stop_token);
+      }) {}
+
+void StdIoForwarder::async_forward_lines(asio::posix::stream_descriptor& pipe,
+                                         asio::streambuf& buffer,
+                                         std::string prefix) {
+    asio::async_read_until(
+        pipe, buffer, '\n',
+        [&, prefix = std::move(prefix)](const std::error_code& error, size_t) {
+            // Just like in `Logger::async_log_pipe_lines()`, this means that
+            // the pipe has been closed
+            if (error) {
+                return;
+            }
+
+            std::string line;
+            std::getline(std::istream(&buffer), line);
+            push(prefix + line);
+
+            async_forward_lines(pipe, buffer, prefix);
+        });
+}
+
+uint64_t StdIoForwarder::dropped_lines_total() const noexcept {
+    return dropped_lines_total_.load(std::memory_order_relaxed);
+}
+
+void StdIoForwarder::push(std::string line) {
+    std::lock_guard lock(lines_mutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - window_start_ >= 1s) {
+        window_start_ = now;
+        window_lines_ = 0;
+    }
+
+    if (window_lines_ >= max_output_lines_per_second ||
+        queued_bytes_ + line.size() > max_queued_output_bytes) {
+        unreported_dropped_lines_ += 1;
+        dropped_lines_total_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    window_lines_ += 1;
+    queued_bytes_ += line.size();
+    lines_.push_back(std::move(line));
+    lines_available_.notify_one();
+}
+
+void StdIoForwarder::write_lines(std::stop_token stop_token) {
+    std::vector<std::string> lines;
+    while (true) {
+        uint64_t dropped_lines = 0;
+        {
+            std::unique_lock lock(lines_mutex_);
+            // We'll wake up at least once a second to report dropped lines
+            lines_available_.wait_for(lock, stop_token, 1s,
+                                      [&]() { return !lines_.empty(); });
+            if (stop_token.stop_requested() && lines_.empty()) {
+                break;
+            }
+
+            lines.swap(lines_);
+            queued_bytes_ = 0;
+            dropped_lines = unreported_dropped_lines_;
+            unreported_dropped_lines_ = 0;
+        }
+
+        // The actual writing happens without holding the lock so the reading
+        // side never has to wait for the log output
+        for (const auto& line : lines) {
+            logger_.log(line);
+        }
+        lines.clear();
+
+        if (dropped_lines > 0) {
+            logger_.log("Dropped " + std::to_string(dropped_lines) +
+                        " lines of output because plugins in this group are "
+                        "printing too much");
+        }
+    }
+}
+
+GroupBridge::GroupBridge(ghc::filesystem::path group_socket_path,
+                         std::chrono::steady_clock::duration idle_timeout)
     : logger_(Logger::create_from_environment(
           create_logger_prefix(group_socket_path))),
+      stdio_forwarder_(logger_),
       main_context_(),
       stdio_context_(),
       stdout_redirect_(stdio_context_, STDOUT_FILENO),
@@ -96,18 +246,45 @@ GroupBridge::GroupBridge(ghc::filesystem::path group_socket_path)
       group_socket_acceptor_(
           create_acceptor_if_inactive(main_context_.context_,
                                       group_socket_endpoint_)),
-      shutdown_timer_(main_context_.context_) {
-    // Write this process's original STDOUT and STDERR streams to the logger
-    logger_.async_log_pipe_lines(stdout_redirect_.pipe_, stdout_buffer_,
-                                 "[STDOUT] ");
-    logger_.async_log_pipe_lines(stderr_redirect_.pipe_, stderr_buffer_,
-                                 "[STDERR] ");
-
-    stdio_handler_ = Win32Thread([&]() {
+      idle_timeout_(idle_timeout),
+      shutdown_timer_(main_context_.context_),
+      closing_timer_(main_context_.context_) {
+    // Write this process's original STDOUT and STDERR streams to the logger.
+    // This goes through `StdIoForwarder` so a slow log file can never cause
+    // the pipes to fill up.
+    stdio_forwarder_.async_forward_lines(stdout_redirect_.pipe_,
+                                         stdout_buffer_, "[STDOUT] ");
+    stdio_forwarder_.async_forward_lines(stderr_redirect_.pipe_,
+                                         stderr_buffer_, "[STDERR] ");
+
+    stdio_handler_ = std::jthread([&]() {
         pthread_setname_np(pthread_self(), "group-stdio");
 
         stdio_context_.run();
     });
+
+    // The metrics socket lives next to the group socket, so scrapers can find
+    // it using the group's name
+    if (const char* metrics_env = getenv("YABRIDGE_GROUP_METRICS");
+        metrics_env && std::string_view(metrics_env) != "" &&
+        std::string_view(metrics_env) != "0") {
+        const fs::path metrics_socket_path =
+            group_socket_path.parent_path() /
+            (group_socket_path.stem().string() + "-metrics.sock");
+
+        metrics_socket_endpoint_.emplace(metrics_socket_path.string());
+        metrics_socket_acceptor_.emplace(create_acceptor_if_inactive(
+            metrics_context_, *metrics_socket_endpoint_));
+        logger_.log("Serving metrics on '" + metrics_socket_path.string() +
+                    "'");
+
+        accept_metrics_requests();
+        metrics_handler_ = std::jthread([&]() {
+            pthread_setname_np(pthread_self(), "group-metrics");
+
+            metrics_context_.run();
+        });
+    }
 }
 
 GroupBridge::~GroupBridge() noexcept {
@@ -115,8 +292,12 @@ GroupBridge::~GroupBridge() noexcept {
     // here we need to do it manually
     // TODO: Encapsulate this, destructors are evil
     fs::remove(group_socket_endpoint_.path());
+    if (metrics_socket_endpoint_) {
+        fs::remove(metrics_socket_endpoint_->path());
+    }
 
     stdio_context_.stop();
+    metrics_context_.stop();
 }
 
 bool GroupBridge::is_event_loop_inhibited() noexcept {
@@ -141,14 +322,24 @@ void GroupBridge::handle_plugin_run(size_t plugin_id, HostBridge* bridge) {
     // active plugins. This is done within the IO context because the call to
     // `FreeLibrary()` has to be done from the main thread, or else we'll
     // potentially corrupt our heap. This way we can also properly join the
-    // thread again. If no active plugins remain, then we'll terminate the
-    // process.
+    // thread again. The plugin is not unloaded right away, see
+    // `unload_closing_plugins()`. If no active plugins remain, then we'll
+    // terminate the process.
     main_context_.schedule_task([this, plugin_id]() {
         std::lock_guard lock(active_plugins_mutex_);
 
-        // The join is implicit because we're using Win32Thread (which mimics
-        // std::jthread)
-        active_plugins_.erase(plugin_id);
+        auto plugin = active_plugins_.extract(plugin_id);
+        closing_plugins_.push_back(std::move(plugin.mapped()));
+
+        closing_timer_.expires_after(closing_batch_delay);
+        closing_timer_.async_wait([this](const std::error_code& error) {
+            // The timer gets restarted when another plugin exits
+            if (error) {
+                return;
+            }
+
+            unload_closing_plugins();
+        });
     });
 
     // Defer actually shutting down the process to allow for fast plugin
@@ -156,25 +347,366 @@ void GroupBridge::handle_plugin_run(size_t plugin_id, HostBridge* bridge) {
     maybe_schedule_shutdown(4s);
 }
 
+void GroupBridge::unload_closing_plugins() {
+    std::lock_guard lock(active_plugins_mutex_);
+
+    // With the `group_module_cache` option we'll keep the plugin's library
+    // loaded for a while so new instances of the plugin can skip loading it
+    // again
+    std::vector<std::shared_ptr<void>> retained_modules;
+    for (auto& [thread, bridge] : closing_plugins_) {
+        if (std::shared_ptr<void> module = bridge->retain_module()) {
+            retained_modules.push_back(std::move(module));
+        }
+    }
+
+    // When several plugins exit at once and nothing else is left in this
+    // process, the host is closing a project (or the host itself is shutting
+    // down). Every plugin has already handled its own shutdown at that point,
+    // so instead of destroying the bridges one by one we'll terminate the
+    // whole process. Individually hosted plugins do the same thing in
+    // `host.cpp`. We can't do this with a single exited plugin since that
+    // could just be the host scanning plugins or removing a single instance.
+    if (closing_plugins_.size() > 1 && retained_modules.empty() &&
+        active_plugins_.empty() && preloading_threads_.empty()) {
+        logger_.log("Closing " + std::to_string(closing_plugins_.size()) +
+                    " plugin instances at once, shutting down the group "
+                    "process without unloading them");
+
+        // The worker threads have already finished running their plugins, so
+        // joining them here is almost instant. The bridges are intentionally
+        // leaked.
+        for (auto& [thread, bridge] : closing_plugins_) {
+            bridge.release();
+        }
+        closing_plugins_.clear();
+
+        // The whole process will exit in `host.cpp` because of this
+        main_context_.stop();
+        return;
+    }
+
+    if (closing_plugins_.size() > 1) {
+        logger_.log("Unloading " + std::to_string(closing_plugins_.size()) +
+                    " closed plugin instances");
+    }
+
+    // The join is implicit because we're using Win32Thread (which mimics
+    // std::jthread)
+    closing_plugins_.clear();
+
+    for (auto& module : retained_modules) {
+        retain_module_until_grace_period(std::move(module));
+    }
+}
+
+void GroupBridge::retain_module_until_grace_period(
+    std::shared_ptr<void> module) {
+    auto timer = std::make_shared<asio::steady_timer>(main_context_.context_);
+    timer->expires_after(module_unload_grace_period);
+
+    // The module will be released when this handler runs or gets destroyed
+    // together with the IO context, both of which happen on the main thread
+    timer->async_wait(
+        [timer, module = std::move(module)](const std::error_code&) {});
+}
+
 void GroupBridge::handle_incoming_connections() {
     accept_requests();
     async_handle_events();
 
-    // If we don't get a request to host a plugin within five seconds, we'll
+    // If we don't get a request to host a plugin within five seconds (or
+    // within the pool's idle timeout for pre-warmed host processes), we'll
     // shut the process down again.
-    maybe_schedule_shutdown(5s);
+    maybe_schedule_shutdown(idle_timeout_);
 
     logger_.log(
         "Group host is up and running, now accepting incoming connections");
     main_context_.run();
 }
 
+void GroupBridge::accept_metrics_requests() {
+    metrics_socket_acceptor_->async_accept(
+        [&](const std::error_code& error,
+            asio::local::stream_protocol::socket socket) {
+            // This only happens when the acceptor gets closed
+            if (error) {
+                return;
+            }
+
+            // We only serve a single document, so the request itself is read
+            // and then ignored. Doing this asynchronously means that a client
+            // that never sends anything can't block other scrapes.
+            auto connection = std::make_shared<MetricsConnection>(
+                MetricsConnection{.socket = std::move(socket)});
+            connection->socket.async_read_some(
+                asio::buffer(connection->request_buffer),
+                [this, connection](const std::error_code& error, size_t) {
+                    if (error) {
+                        return;
+                    }
+
+                    const std::string metrics = format_metrics();
+                    connection->response =
+                        "HTTP/1.0 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: " +
+                        std::to_string(metrics.size()) +
+                        "\r\n"
+                        "Connection: close\r\n"
+                        "\r\n" +
+                        metrics;
+                    asio::async_write(
+                        connection->socket, asio::buffer(connection->response),
+                        [connection](const std::error_code&, size_t) {
+                            std::error_code ignored;
+                            connection->socket.shutdown(
+                                asio::local::stream_protocol::socket::
+                                    shutdown_both,
+                                ignored);
+                        });
+                });
+
+            accept_metrics_requests();
+        });
+}
+
+std::string GroupBridge::format_metrics() {
+    std::ostringstream metrics;
+    const auto write_header = [&](const char* name, const char* type,
+                                  const char* help) {
+        metrics << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " " << type << "\n";
+    };
+
+    // We'll copy the information we need so the lock is held as short as
+    // possible, since the main thread also needs it to spawn plugins
+    struct InstanceInfo {
+        std::string labels;
+        HostBridge::AudioBufferInfo buffer;
+    };
+    std::vector<InstanceInfo> instances;
+    size_t num_plugins = 0;
+    {
+        std::lock_guard lock(active_plugins_mutex_);
+
+        num_plugins = active_plugins_.size();
+        for (const auto& [plugin_id, value] : active_plugins_) {
+            const auto& [thread, bridge] = value;
+            const std::string plugin_label = escape_label_value(
+                bridge->plugin_path_.filename().string());
+            for (auto& buffer : bridge->audio_buffers()) {
+                instances.push_back(InstanceInfo{
+                    .labels = "plugin=\"" + plugin_label + "\",instance=\"" +
+                              std::to_string(plugin_id) + ":" +
+                              std::to_string(buffer.instance_id) + "\"",
+                    .buffer = std::move(buffer)});
+            }
+        }
+    }
+
+    // This lets tools like `yabridgectl top` match this socket to the process
+    // IDs stored in the audio buffers
+    write_header("yabridge_host_pid", "gauge",
+                 "The process ID of this group host process.");
+    metrics << "yabridge_host_pid " << getpid() << "\n";
+
+    write_header("yabridge_group_plugins", "gauge",
+                 "The number of plugins hosted by this group host process.");
+    metrics << "yabridge_group_plugins " << num_plugins << "\n";
+
+    // The processing statistics are read straight from the audio buffers'
+    // control headers. Instances that have been removed in the meantime are
+    // skipped.
+    std::vector<std::pair<const InstanceInfo&,
+                          AudioShmBuffer::ProcessingStatsSnapshot>>
+        instance_stats;
+    for (const auto& instance : instances) {
+        if (const auto stats = AudioShmBuffer::read_processing_stats(
+                instance.buffer.shm_name)) {
+            instance_stats.emplace_back(instance, *stats);
+        }
+    }
+
+    write_header("yabridge_audio_blocks_total", "counter",
+                 "The number of audio blocks processed by a plugin instance.");
+    for (const auto& [instance, stats] : instance_stats) {
+        metrics << "yabridge_audio_blocks_total{" << instance.labels << "} "
+                << stats.num_blocks << "\n";
+    }
+    write_header("yabridge_audio_bridge_seconds_total", "counter",
+                 "The time spent round tripping audio blocks, as measured by "
+                 "the native plugin.");
+    for (const auto& [instance, stats] : instance_stats) {
+        metrics << "yabridge_audio_bridge_seconds_total{" << instance.labels
+                << "} " << (static_cast<double>(stats.total_ns) / 1.0e9)
+                << "\n";
+    }
+    write_header("yabridge_audio_plugin_seconds_total", "counter",
+                 "The time spent in the Windows plugin's process function.");
+    for (const auto& [instance, stats] : instance_stats) {
+        metrics << "yabridge_audio_plugin_seconds_total{" << instance.labels
+                << "} " << (static_cast<double>(stats.plugin_ns) / 1.0e9)
+                << "\n";
+    }
+    write_header("yabridge_audio_host_callback_seconds_total", "counter",
+                 "The part of the plugin's processing time spent waiting for "
+                 "host callbacks.");
+    for (const auto& [instance, stats] : instance_stats) {
+        metrics << "yabridge_audio_host_callback_seconds_total{"
+                << instance.labels << "} "
+                << (static_cast<double>(stats.callbacks_ns) / 1.0e9) << "\n";
+    }
+    write_header("yabridge_audio_buffer_bytes", "gauge",
+                 "The size of a plugin instance's shared audio buffer.");
+    for (const auto& instance : instances) {
+        metrics << "yabridge_audio_buffer_bytes{" << instance.labels << "} "
+                << instance.buffer.capacity << "\n";
+    }
+
+    // These histograms are shared by all plugins in this process. The
+    // `(during processing)` histograms only contain callbacks that are already
+    // counted in the `(round trip)` histograms, so they're skipped here.
+    write_header("yabridge_requests_total", "counter",
+                 "The number of requests sent or handled by this process.");
+    LatencyHistograms::get().for_each_summary(
+        [&](const std::string& label,
+            const LatencyHistogram::Summary& summary) {
+            if (label.ends_with(" (during processing)")) {
+                return;
+            }
+
+            metrics << "yabridge_requests_total{request=\""
+                    << escape_label_value(label) << "\"} " << summary.count
+                    << "\n";
+        });
+
+    write_header("yabridge_dropped_output_lines_total", "counter",
+                 "The number of STDOUT and STDERR lines that were not logged "
+                 "because plugins were printing too much.");
+    metrics << "yabridge_dropped_output_lines_total "
+            << stdio_forwarder_.dropped_lines_total() << "\n";
+
+    write_header("yabridge_secondary_connections_opened_total", "counter",
+                 "The number of additional sockets opened for concurrent "
+                 "requests.");
+    metrics << "yabridge_secondary_connections_opened_total "
+            << secondary_socket_counters.opened.load(std::memory_order_relaxed)
+            << "\n";
+    write_header("yabridge_secondary_connections_active", "gauge",
+                 "The number of additional sockets currently handling a "
+                 "request.");
+    metrics << "yabridge_secondary_connections_active "
+            << secondary_socket_counters.handling.load(
+                   std::memory_order_relaxed)
+            << "\n";
+    write_header("yabridge_worker_threads", "gauge",
+                 "The number of pooled threads for handling requests on "
+                 "additional sockets, both busy and idle.");
+    metrics << "yabridge_worker_threads " << Win32ThreadPool::total_workers()
+            << "\n";
+    write_header("yabridge_worker_queued_tasks", "gauge",
+                 "The number of requests waiting for a pooled thread.");
+    metrics << "yabridge_worker_queued_tasks "
+            << Win32ThreadPool::total_queued() << "\n";
+
+    // The socket channels are shared by all plugins in this process
+    using TrafficField = std::atomic_uint64_t SocketTrafficCounters::*;
+    const auto write_traffic = [&](const char* name, const char* help,
+                                   TrafficField field) {
+        write_header(name, "counter", help);
+        LatencyHistograms::get().for_each_socket_traffic(
+            [&](const std::string& channel, const SocketTraffic& traffic) {
+                for (const auto& [connection, counters] :
+                     {std::pair<const char*, const SocketTrafficCounters*>(
+                          "primary", &traffic.primary),
+                      std::pair<const char*, const SocketTrafficCounters*>(
+                          "secondary", &traffic.secondary)}) {
+                    metrics << name << "{channel=\""
+                            << escape_label_value(channel)
+                            << "\",connection=\"" << connection << "\"} "
+                            << (counters->*field).load(
+                                   std::memory_order_relaxed)
+                            << "\n";
+                }
+            });
+    };
+    write_traffic("yabridge_socket_messages_sent_total",
+                  "The number of messages written to this process' sockets.",
+                  &SocketTrafficCounters::messages_sent);
+    write_traffic("yabridge_socket_bytes_sent_total",
+                  "The number of bytes written to this process' sockets.",
+                  &SocketTrafficCounters::bytes_sent);
+    write_traffic("yabridge_socket_messages_received_total",
+                  "The number of messages read from this process' sockets.",
+                  &SocketTrafficCounters::messages_received);
+    write_traffic("yabridge_socket_bytes_received_total",
+                  "The number of bytes read from this process' sockets.",
+                  &SocketTrafficCounters::bytes_received);
+
+    // The kernel already keeps track of these for us
+    std::ifstream status_file("/proc/self/status");
+    std::string line;
+    while (std::getline(status_file, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        uint64_t value = 0;
+        if (!(fields >> key >> value)) {
+            continue;
+        }
+
+        if (key == "Threads:") {
+            write_header("yabridge_threads", "gauge",
+                         "The number of threads in this process.");
+            metrics << "yabridge_threads " << value << "\n";
+        } else if (key == "VmRSS:") {
+            // This is always reported in kibibytes
+            write_header("yabridge_resident_memory_bytes", "gauge",
+                         "The resident set size of this process.");
+            metrics << "yabridge_resident_memory_bytes " << (value * 1024)
+                    << "\n";
+        }
+    }
+
+    // These are only interesting with the `memory_merging` and
+    // `memory_huge_pages` options. `/proc/self/ksm_stat` requires Linux 6.1.
+    std::ifstream ksm_stat_file("/proc/self/ksm_stat");
+    while (std::getline(ksm_stat_file, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        uint64_t value = 0;
+        if (fields >> key >> value && key == "ksm_merging_pages") {
+            write_header("yabridge_merged_memory_bytes", "gauge",
+                         "The amount of this process' memory that has been "
+                         "deduplicated by kernel same-page merging.");
+            metrics << "yabridge_merged_memory_bytes "
+                    << (value * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)))
+                    << "\n";
+        }
+    }
+
+    std::ifstream smaps_file("/proc/self/smaps_rollup");
+    while (std::getline(smaps_file, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        uint64_t value = 0;
+        if (fields >> key >> value && key == "AnonHugePages:") {
+            // This is also reported in kibibytes
+            write_header("yabridge_huge_page_memory_bytes", "gauge",
+                         "The amount of this process' anonymous memory that is "
+                         "backed by transparent huge pages.");
+            metrics << "yabridge_huge_page_memory_bytes " << (value * 1024)
+                    << "\n";
+        }
+    }
+
+    return metrics.str();
+}
+
 void GroupBridge::accept_requests() {
     group_socket_acceptor_.async_accept(
         [&](const std::error_code& error,
             asio::local::stream_protocol::socket socket) {
-            std::lock_guard lock(active_plugins_mutex_);
-
             // Stop the whole process when the socket gets closed unexpectedly
             if (error) {
                 logger_.log("Error while listening for incoming connections:");
@@ -192,80 +724,137 @@ void GroupBridge::accept_requests() {
             const auto request = read_object<HostRequest>(socket);
             write_object(socket, HostResponse{.pid = getpid()});
 
-            // The plugin has to be initiated on the IO context's thread because
-            // this has to be done on the same thread that's handling messages,
-            // and all window messages have to be handled from the same thread.
             logger_.log("Received request to host " +
                         plugin_type_to_string(request.plugin_type) +
                         " plugin at '" + request.plugin_path +
                         "' using socket endpoint base directory '" +
                         request.endpoint_base_dir + "'");
-            try {
-                // Cancel the (initial) shutdown timer, since the plugin may
-                // take longer to initialize if it is new
-                shutdown_timer_.cancel();
-
-                std::unique_ptr<HostBridge> bridge = nullptr;
-                switch (request.plugin_type) {
-                    case PluginType::vst2:
-                        bridge = std::make_unique<Vst2Bridge>(
-                            main_context_, request.plugin_path,
-                            request.endpoint_base_dir, request.parent_pid);
-                        break;
-                    case PluginType::vst3:
-#ifdef WITH_VST3
-                        bridge = std::make_unique<Vst3Bridge>(
-                            main_context_, request.plugin_path,
-                            request.endpoint_base_dir, request.parent_pid);
-#else
-                        throw std::runtime_error(
-                            "This version of yabridge has not been compiled "
-                            "with VST3 support");
-#endif
-                        break;
-                    case PluginType::unknown:
-                        throw std::runtime_error(
-                            "Invalid plugin host request received, how did you "
-                            "even manage to do this?");
-                        break;
-                }
 
-                logger_.log("Finished initializing '" + request.plugin_path +
-                            "'");
-
-                // Start listening for dispatcher events sent to the plugin's
-                // socket on another thread. Parts of the actual event handling
-                // will still be posted to this IO context so that any events
-                // that potentially interact with the Win32 message loop are
-                // handled from the main thread. We also pass a raw pointer to
-                // the plugin so we don't have to immediately look the instance
-                // up in the map again, as this would require us to immediately
-                // lock the map again. This could otherwise result in a deadlock
-                // when using the Spitfire plugins, as they will block the
-                // message loop until `effOpen()` has been called and thus
-                // prevent this lock from happening.
-                const size_t plugin_id = next_plugin_id_.fetch_add(1);
-                active_plugins_[plugin_id] = std::pair(
-                    Win32Thread([this, plugin_id, plugin_ptr = bridge.get()]() {
-                        const std::string thread_name =
-                            "worker-" + std::to_string(plugin_id);
-                        pthread_setname_np(pthread_self(), thread_name.c_str());
-
-                        handle_plugin_run(plugin_id, plugin_ptr);
-                    }),
-                    std::move(bridge));
-            } catch (const std::exception& error) {
-                logger_.log("Error while initializing '" + request.plugin_path +
-                            "':");
-                logger_.log(error.what());
-
-                maybe_schedule_shutdown(5s);
+            // Cancel the (initial) shutdown timer, since the plugin may take
+            // longer to initialize if it is new
+            shutdown_timer_.cancel();
+
+            // Plugins that want to be loaded in parallel will have their
+            // library loaded on another thread first. The main thread can
+            // keep accepting and initializing other plugins in the meantime.
+            if (request.preload_library_path) {
+                preload_plugin(request);
+            } else {
+                host_plugin(request);
             }
 
             accept_requests();
         });
 }
 
+void GroupBridge::preload_plugin(const HostRequest& request) {
+    const size_t preload_id = next_plugin_id_.fetch_add(1);
+    preloading_threads_[preload_id] = Win32Thread([this, preload_id,
+                                                   request]() {
+        const std::string thread_name = "preload-" + std::to_string(preload_id);
+        pthread_setname_np(pthread_self(), thread_name.c_str());
+
+        // This resolves and loads all of the library's dependencies and runs
+        // its `DllMain()`. The `LoadLibrary()` call in the bridge's
+        // constructor will then only have to increase the library's reference
+        // count. If this fails we'll still let the bridge try to load the
+        // library so it can report the error as usual.
+        const auto preload_start = std::chrono::steady_clock::now();
+        HMODULE library_handle =
+            LoadLibrary(request.preload_library_path->c_str());
+        const auto preload_end = std::chrono::steady_clock::now();
+
+        logger_.log("Preloaded '" + *request.preload_library_path + "' in " +
+                    format_duration_ms(preload_end - preload_start));
+
+        main_context_.schedule_task([this, preload_id, request, library_handle,
+                                     preload_end]() {
+            logger_.log(
+                "Waited " +
+                format_duration_ms(std::chrono::steady_clock::now() -
+                                   preload_end) +
+                " for the main thread to initialize '" + request.plugin_path +
+                "'");
+
+            host_plugin(request);
+
+            // The bridge holds its own reference to the library now. Like with
+            // plugin shutdown, `FreeLibrary()` is called from the main thread.
+            if (library_handle) {
+                FreeLibrary(library_handle);
+            }
+
+            // This thread has finished at this point, so this join will be
+            // almost instant
+            preloading_threads_.erase(preload_id);
+        });
+    });
+}
+
+void GroupBridge::host_plugin(const HostRequest& request) {
+    std::lock_guard lock(active_plugins_mutex_);
+
+    try {
+        const auto initialization_start = std::chrono::steady_clock::now();
+
+        std::unique_ptr<HostBridge> bridge = nullptr;
+        switch (request.plugin_type) {
+            case PluginType::vst2:
+                bridge = std::make_unique<Vst2Bridge>(
+                    main_context_, request.plugin_path,
+                    request.endpoint_base_dir, false, request.parent_pid);
+                break;
+            case PluginType::vst3:
+#ifdef WITH_VST3
+                bridge = std::make_unique<Vst3Bridge>(
+                    main_context_, request.plugin_path,
+                    request.endpoint_base_dir, false, request.parent_pid);
+#else
+                throw std::runtime_error(
+                    "This version of yabridge has not been compiled with VST3 "
+                    "support");
+#endif
+                break;
+            case PluginType::unknown:
+                throw std::runtime_error(
+                    "Invalid plugin host request received, how did you even "
+                    "manage to do this?");
+                break;
+        }
+
+        logger_.log("Finished initializing '" + request.plugin_path +
+                    "' in " +
+                    format_duration_ms(std::chrono::steady_clock::now() -
+                                       initialization_start));
+
+        // Start listening for dispatcher events sent to the plugin's socket on
+        // another thread. Parts of the actual event handling will still be
+        // posted to this IO context so that any events that potentially
+        // interact with the Win32 message loop are handled from the main
+        // thread. We also pass a raw pointer to the plugin so we don't have to
+        // immediately look the instance up in the map again, as this would
+        // require us to immediately lock the map again. This could otherwise
+        // result in a deadlock when using the Spitfire plugins, as they will
+        // block the message loop until `effOpen()` has been called and thus
+        // prevent this lock from happening.
+        const size_t plugin_id = next_plugin_id_.fetch_add(1);
+        active_plugins_[plugin_id] = std::pair(
+            Win32Thread([this, plugin_id, plugin_ptr = bridge.get()]() {
+                const std::string thread_name =
+                    "worker-" + std::to_string(plugin_id);
+                pthread_setname_np(pthread_self(), thread_name.c_str());
+
+                handle_plugin_run(plugin_id, plugin_ptr);
+            }),
+            std::move(bridge));
+    } catch (const std::exception& error) {
+        logger_.log("Error while initializing '" + request.plugin_path + "':");
+        logger_.log(error.what());
+
+        maybe_schedule_shutdown(5s);
+    }
+}
+
 void GroupBridge::async_handle_events() {
     main_context_.async_handle_events(
         [&]() {
@@ -279,7 +868,7 @@ void GroupBridge::async_handle_events() {
             // timer loop for a little while after opening a second editor.
             // Without this limit everything will get blocked indefinitely. How
             // could this be fixed?
-            HostBridge::handle_events();
+            return HostBridge::handle_events();
         },
         [&]() { return !is_event_loop_inhibited(); });
 }
@@ -328,7 +917,7 @@ void GroupBridge::maybe_schedule_shutdown(
         }
 
         std::lock_guard lock(active_plugins_mutex_);
-        if (active_plugins_.size() == 0) {
+        if (active_plugins_.size() == 0 && preloading_threads_.empty()) {
             logger_.log(
                 "All plugins have exited, shutting down the group process");
 
@@ -363,3 +952,27 @@ std::string create_logger_prefix(const fs::path& socket_path) {
 
     return "[" + socket_name + "] ";
 }
+
+
+std::string escape_label_value(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char c : value) {
+        switch (c) {
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped += c;
+                break;
+        }
+    }
+
+    return escaped;
+}
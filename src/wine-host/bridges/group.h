@@ -17,7 +17,11 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <thread>
+#include <vector>
 
 #include "../asio-fix.h"
 
@@ -90,6 +94,72 @@ class StdIoCapture {
     int pipe_fd_[2];
 };
 
+/**
+ * Writes the lines captured by `StdIoCapture` to the log from a separate
+ * thread. Plugins block inside of `write()` once the capture pipe is full, so
+ * the thread reading from that pipe should never have to wait for the log
+ * output to be written. Lines are instead queued here, and lines that exceed
+ * either the queue's size or the rate limit get dropped and counted. This way
+ * a plugin that prints something for every processed block cannot stall audio
+ * processing through its own debug output. The timestamps are added when the
+ * lines are written, so they may lag behind a bit when a lot of output is
+ * being written.
+ */
+class StdIoForwarder {
+   public:
+    /**
+     * Start the thread writing the queued lines to `logger`.
+     */
+    explicit StdIoForwarder(Logger& logger);
+
+    StdIoForwarder(const StdIoForwarder&) = delete;
+    StdIoForwarder& operator=(const StdIoForwarder&) = delete;
+
+    /**
+     * Asynchronously read lines from a captured pipe and queue them for
+     * writing, prefixed with `prefix`. This is the non-blocking equivalent of
+     * `Logger::async_log_pipe_lines()`.
+     */
+    void async_forward_lines(asio::posix::stream_descriptor& pipe,
+                             asio::streambuf& buffer,
+                             std::string prefix);
+
+    /**
+     * The number of lines that have been dropped so far.
+     */
+    uint64_t dropped_lines_total() const noexcept;
+
+   private:
+    /**
+     * Queue a line, or drop it if the queue is full or if the rate limit has
+     * been reached. This never waits for the writer.
+     */
+    void push(std::string line);
+
+    void write_lines(std::stop_token stop_token);
+
+    Logger& logger_;
+
+    std::mutex lines_mutex_;
+    std::condition_variable_any lines_available_;
+    std::vector<std::string> lines_;
+    size_t queued_bytes_ = 0;
+
+    /**
+     * The start of the current one second rate limiting window, and the
+     * number of lines queued during it.
+     */
+    std::chrono::steady_clock::time_point window_start_;
+    uint32_t window_lines_ = 0;
+    /**
+     * The lines dropped since the writer last reported on it.
+     */
+    uint64_t unreported_dropped_lines_ = 0;
+    std::atomic_uint64_t dropped_lines_total_ = 0;
+
+    std::jthread writer_;
+};
+
 /**
  * A 'plugin group' that listens on a _group socket_ for plugins to host in this
  * process. Once the plugin gets loaded into a new thread the actual bridging
@@ -116,6 +186,10 @@ class GroupBridge {
      *   `/tmp/yabridge-group-<group_name>-<wine_prefix_id>-<architecture>.sock`
      *   where `<wine_prefix_id>` is a numerical hash as explained in the
      *   `create_logger_prefix()` function in `./group.cpp`.
+     * @param idle_timeout How long to wait for the first request to host a
+     *   plugin before shutting down again. Pre-warmed host processes launched
+     *   for the `host_pool_size` option use a much longer timeout since they
+     *   may sit idle for a while before they receive a plugin.
      *
      * @throw std::system_error If we can't listen on the socket.
      * @throw std::system_error If the pipe could not be created.
@@ -124,7 +198,9 @@ class GroupBridge {
      *   STDOUT and STDERR streams of the current process will be redirected to
      *   a pipe so they can be properly written to a log file.
      */
-    explicit GroupBridge(ghc::filesystem::path group_socket_path);
+    explicit GroupBridge(ghc::filesystem::path group_socket_path,
+                         std::chrono::steady_clock::duration idle_timeout =
+                             std::chrono::seconds(5));
 
     ~GroupBridge() noexcept;
 
@@ -150,6 +226,8 @@ class GroupBridge {
      *
      * Once the plugin has exited, this thread will then be joined to the main
      * thread and removed from the `active_plugins_` from the main IO context.
+     * Plugins that exit shortly after each other are unloaded in a single
+     * batch.
      * If this causes the vector to become empty, we will terminate this
      * process. This check is delayed by a few seconds to prevent having to
      * constantly restart the group process during plugin scanning.
@@ -188,6 +266,61 @@ class GroupBridge {
      */
     void accept_requests();
 
+    /**
+     * Accept connections on the metrics socket and reply to every request with
+     * the output of `format_metrics()`. This runs on `metrics_context_`.
+     *
+     * @see metrics_socket_acceptor_
+     */
+    void accept_metrics_requests();
+
+    /**
+     * Describe the state of this group host process and of the plugins it's
+     * hosting in Prometheus' text based exposition format. This locks
+     * `active_plugins_mutex_`, and it only reads the audio buffers' control
+     * headers so it's safe to call from any thread.
+     */
+    std::string format_metrics();
+
+    /**
+     * Load the plugin's library from `request.preload_library_path` on a new
+     * thread, and then schedule `host_plugin()` to be run on the main thread.
+     * Used when the plugin has enabled the `group_parallel_loading` option.
+     * Because the library will already be loaded by then, the bridge's
+     * `LoadLibrary()` call will return immediately, and only the plugin's
+     * actual initialization has to be serialized on the main thread.
+     *
+     * @see preloading_threads_
+     */
+    void preload_plugin(const HostRequest& request);
+
+    /**
+     * Initialize a plugin bridge for the request, and hand it over to a new
+     * thread running `handle_plugin_run()`. This has to be called from the
+     * main thread. Errors are logged and will not be propagated.
+     */
+    void host_plugin(const HostRequest& request);
+
+    /**
+     * Unload all plugins in `closing_plugins_`. This is called from the main
+     * thread once no other plugins have exited for `closing_batch_delay`. If
+     * multiple plugins closed at once and no other plugins are left in this
+     * process, then the process will be shut down directly without unloading
+     * the plugins first.
+     *
+     * @see closing_plugins_
+     */
+    void unload_closing_plugins();
+
+    /**
+     * Keep `module` alive for `module_unload_grace_period`. Used for plugins
+     * that have enabled the `group_module_cache` option, so a new instance of
+     * the same plugin can reuse the already loaded library.
+     *
+     * @see HostBridge::retain_module
+     */
+    void retain_module_until_grace_period(std::shared_ptr<void> module);
+
     /**
      * Handle both Win32 messages and X11 events on a timer within the IO
      * context for all plugins.
@@ -208,6 +341,13 @@ class GroupBridge {
      */
     Logger logger_;
 
+    /**
+     * Writes the captured STDOUT and STDERR output to `logger_`. This is
+     * declared before the pipes and the thread reading from them so it
+     * outlives both.
+     */
+    StdIoForwarder stdio_forwarder_;
+
     /**
      * The IO context that connections will be accepted on, and that any plugin
      * operations that may involve the Win32 mesasge loop (e.g. initialization
@@ -238,9 +378,12 @@ class GroupBridge {
      */
     StdIoCapture stderr_redirect_;
     /**
-     * A thread that runs the `stdio_context_` loop.
+     * A thread that runs the `stdio_context_` loop. This only runs yabridge's
+     * own code and never calls any Win32 APIs, so it's a plain pthread instead
+     * of a `Win32Thread`. That makes it cheaper to create, and Wine doesn't
+     * need to know about it.
      */
-    Win32Thread stdio_handler_;
+    std::jthread stdio_handler_;
 
     asio::local::stream_protocol::endpoint group_socket_endpoint_;
     /**
@@ -249,6 +392,28 @@ class GroupBridge {
      */
     asio::local::stream_protocol::acceptor group_socket_acceptor_;
 
+    /**
+     * A separate IO context for serving metrics when the
+     * `YABRIDGE_GROUP_METRICS` environment variable is set. Scrapes should
+     * neither be blocked by nor interfere with GUI operations on the main
+     * thread, so this gets its own thread just like the STDIO capture.
+     */
+    asio::io_context metrics_context_;
+    /**
+     * A UNIX domain socket next to the group socket that answers every HTTP
+     * request with the output of `format_metrics()`. Only set when the
+     * `YABRIDGE_GROUP_METRICS` environment variable is set.
+     */
+    std::optional<asio::local::stream_protocol::endpoint>
+        metrics_socket_endpoint_;
+    std::optional<asio::local::stream_protocol::acceptor>
+        metrics_socket_acceptor_;
+    /**
+     * A thread that runs the `metrics_context_` loop, if metrics are enabled.
+     * Like `stdio_handler_`, this is a plain pthread.
+     */
+    std::jthread metrics_handler_;
+
     /**
      * A map of threads that are currently hosting a plugin within this process
      * along with their plugin instance. After a plugin has exited or its
@@ -275,6 +440,21 @@ class GroupBridge {
      */
     std::mutex active_plugins_mutex_;
 
+    /**
+     * The threads loading plugin libraries in `preload_plugin()`. These remove
+     * themselves from this map from the main thread after the plugin has been
+     * initialized. This is only accessed from the main thread, and the group
+     * host won't shut down while there are still plugins being preloaded.
+     */
+    std::unordered_map<size_t, Win32Thread> preloading_threads_;
+
+    /**
+     * How long to wait for the first plugin before shutting down the process.
+     *
+     * @see handle_incoming_connections
+     */
+    const std::chrono::steady_clock::duration idle_timeout_;
+
     /**
      * A timer to defer shutting down the process, allowing for fast plugin
      * scanning without having to start a new group host process for each
@@ -288,4 +468,19 @@ class GroupBridge {
      * timer when multiple plugins exit at the same time.
      */
     std::mutex shutdown_timer_mutex_;
+
+    /**
+     * Plugins that have exited but that have not yet been unloaded. Exited
+     * plugins are moved here from `active_plugins_` on the main thread, and
+     * they are unloaded together in `unload_closing_plugins()`. This is
+     * protected by `active_plugins_mutex_`.
+     */
+    std::vector<std::pair<Win32Thread, std::unique_ptr<HostBridge>>>
+        closing_plugins_;
+
+    /**
+     * The timer that calls `unload_closing_plugins()` after the last plugin has
+     * exited. Only accessed from the main thread.
+     */
+    asio::steady_timer closing_timer_;
 };
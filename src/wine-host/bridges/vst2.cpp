@@ -16,8 +16,10 @@
 
 #include "vst2.h"
 
+#include <algorithm>
 #include <iostream>
 #include <set>
+#include <string_view>
 
 // Generated inside of the build directory
 #include <version.h>
@@ -40,6 +42,15 @@ using VstEntryPoint = AEffect*(VST_CALL_CONV*)(audioMasterCallback);
  */
 constexpr size_t yabridge_ptr2_magic = 0xdeadbeef + 420;
 
+/**
+ * How long the sample rate and block size reported by the host are cached for.
+ * These are also dropped from the cache when the host calls
+ * `effSetSampleRate()` or `effSetBlockSize()`, so this only limits how long a
+ * stale value can stick around for hosts that change their setup without
+ * telling the plugin.
+ */
+constexpr unsigned int host_setup_cache_lifetime_seconds = 1;
+
 /**
  * This ugly global is needed so we can get the instance of a `Vst2Bridge` class
  * from an `AEffect` when it performs a host callback during its initialization.
@@ -154,16 +165,25 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
                        // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
                        std::string plugin_dll_path,
                        std::string endpoint_base_dir,
+                       bool abstract_sockets,
                        pid_t parent_pid)
     : HostBridge(main_context, plugin_dll_path, parent_pid),
       logger_(generic_logger_),
       plugin_handle_(LoadLibrary(plugin_dll_path.c_str()), FreeLibrary),
-      sockets_(main_context.context_, endpoint_base_dir, false) {
+      sockets_(main_context.context_,
+               endpoint_base_dir,
+               false,
+               abstract_sockets) {
     if (!plugin_handle_) {
         throw std::runtime_error("Could not load the Windows .dll file at '" +
                                  plugin_dll_path + "'");
     }
 
+    generic_logger_.log(
+        "Loaded the plugin library in " +
+        format_duration_ms(std::chrono::steady_clock::now() -
+                           construction_start_));
+
     // VST plugin entry point functions should be called `VSTPluginMain`, but
     // pre-VST2.4 `main` was also a valid name
     VstEntryPoint vst_entry_point = nullptr;
@@ -215,18 +235,28 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
     // of this object will be sent over the `dispatcher()` socket. This would be
     // done after the host calls `effOpen()`, and when the plugin calls
     // `audioMasterIOChanged()`. We will also send along this host's version so
-    // we can show a warning when the plugin's version doesn't match.
-    sockets_.host_vst_control_.send(
-        Vst2EventResult{.return_value = 0,
-                        .payload = *plugin_,
-                        .value_payload = yabridge_git_version});
+    // we can show a warning when the plugin's version doesn't match, and the
+    // flags from `Capabilities` in the otherwise unused return value so the
+    // plugin can disable options this host does not support.
+    sockets_.host_vst_control_.send(Vst2EventResult{
+        .return_value = static_cast<native_intptr_t>(Capabilities{}.flags),
+        .payload = *plugin_,
+        .value_payload = yabridge_git_version});
+    update_aeffect(native_aeffect_, *plugin_);
 
     // After sending the AEffect struct we'll receive this instance's
     // configuration as a response
     config_ = sockets_.host_vst_control_.receive_single<Configuration>();
 
     // Allow this plugin to configure the main context's tick rate
-    main_context.update_timer_interval(config_.event_loop_interval());
+    main_context.update_timer_interval(config_.event_loop_interval(),
+                                       config_.event_loop_idle_backoff);
+
+    // Create the editor's window ahead of time so it's ready by the time the
+    // host opens the editor. See the docstring on this function.
+    if (config_.editor_precreate_window) {
+        main_context.schedule_task([]() { Editor::precreate_window(); });
+    }
 
     parameters_handler_ = Win32Thread([&]() {
         set_realtime_priority(true);
@@ -257,38 +287,99 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
 
     process_replacing_handler_ = Win32Thread([&]() {
         set_realtime_priority(true);
+        set_audio_thread_affinity(config_.audio_thread_cpus);
         pthread_setname_np(pthread_self(), "audio");
+        audio_thread_id_ = GetCurrentThreadId();
 
         // Most plugins will already enable FTZ, but there are a handful of
         // plugins that don't that suffer from extreme DSP load increases when
         // they start producing denormals
         ScopedFlushToZero ftz_guard;
 
+        // This object is reused for every processing cycle. The actual request
+        // is written to the shared audio buffers, and the socket is only used
+        // as a wakeup. With `vst2_batch_midi_events` the request also contains
+        // the MIDI events for this cycle.
+        Vst2BatchedProcessRequest batched_process_request{};
+        Vst2ProcessRequest& process_request = batched_process_request.request;
+        // The host thread this thread was last pinned for, used with the
+        // `audio_thread_host_mapping` option
+        std::optional<int> last_host_thread_id;
+        // Switched to `SCHED_DEADLINE` when `deadline_period_ns_` changes if
+        // the `audio_thread_sched_deadline` option is enabled
+        AudioThreadScheduling scheduling;
         sockets_.host_vst_process_replacing_.receive_multi<
-            Vst2ProcessRequest>([&](Vst2ProcessRequest& process_request,
-                                    SerializationBufferBase& buffer) {
+            Vst2ProcessWakeUp>([&](Vst2ProcessWakeUp&,
+                                   SerializationBufferBase& buffer) {
+            assert(process_buffers_);
+            const auto received_time = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> idle_buffer_lock;
+            if (config_.audio_buffer_idle_release_s) {
+                idle_buffer_lock =
+                    idle_buffer_release_.begin_processing(process_buffers_);
+            }
+            if (config_.vst2_batch_midi_events) {
+                read_shm_object(*process_buffers_,
+                                AudioShmBuffer::MetadataRegion::request,
+                                batched_process_request);
+            } else {
+                read_shm_object(*process_buffers_,
+                                AudioShmBuffer::MetadataRegion::request,
+                                process_request);
+            }
+
             // Since the value cannot change during this processing cycle,
             // we'll send the current transport information as part of the
             // request so we prefetch it to avoid unnecessary callbacks from
-            // the audio thread
-            std::optional<decltype(time_info_cache_)::Guard>
-                time_info_cache_guard =
-                    process_request.current_time_info
-                        ? std::optional(time_info_cache_.set(
-                              *process_request.current_time_info))
-                        : std::nullopt;
+            // the audio thread. If the host did not return any transport
+            // information then we'll also cache that.
+            const VstTimeInfo* current_time_info = time_info_decoder_.decode(
+                process_request.current_time_info,
+                process_request.sample_frames);
+            decltype(time_info_cache_)::Guard time_info_cache_guard =
+                time_info_cache_.set(current_time_info);
 
             // We'll also prefetch the process level, since some plugins
             // will ask for this during every processing cycle
             decltype(process_level_cache_)::Guard process_level_cache_guard =
                 process_level_cache_.set(process_request.current_process_level);
 
+            // Offline renders don't need to preempt live audio processing
+            if (config_.offline_render_non_realtime) {
+                scheduling.set_offline(process_request.current_process_level ==
+                                       kVstProcessLevelOffline);
+            }
+
             // As suggested by Jack Winter, we'll synchronize this thread's
             // audio processing priority with that of the host's audio
-            // thread every once in a while
+            // thread whenever it changes
             if (process_request.new_realtime_priority) {
-                set_realtime_priority(true,
-                                      *process_request.new_realtime_priority);
+                scheduling.set_realtime_priority(
+                    *process_request.new_realtime_priority);
+            }
+            scheduling.set_deadline_period(
+                deadline_period_ns_.load(std::memory_order_relaxed));
+            if (process_request.host_audio_thread_cpu) {
+                set_audio_thread_affinity(
+                    config_.audio_thread_cpus,
+                    *process_request.host_audio_thread_cpu);
+            }
+            if (process_request.host_audio_thread_numa_node) {
+                follow_numa_node(config_,
+                                 *process_request.host_audio_thread_numa_node,
+                                 process_buffers_);
+            }
+            if (process_request.host_thread_id) {
+                HostAudioThreadMap::get().pin_for_host_thread(
+                    *process_request.host_thread_id, last_host_thread_id,
+                    config_.audio_thread_cpus);
+            }
+
+            // These are the events the host passed to `effProcessEvents()`
+            // right before this processing call
+            if (!batched_process_request.midi_events.events_.empty()) {
+                process_midi_events(batched_process_request.midi_events, 0, 0,
+                                    0.0);
             }
 
             // Let the plugin process the MIDI events that were received
@@ -307,6 +398,8 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
             // on the type of data we got sent and the plugin's reported
             // support for these functions.
             auto do_process = [&]<typename T>(T) {
+                const TraceScope trace_scope("process", "audio");
+
                 // These were set up after the host called
                 // `effMainsChanged()` with the correct size, so this
                 // reinterpret cast is safe even if the host suddenly starts
@@ -356,7 +449,12 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
                 }
             };
 
-            assert(process_buffers_);
+            // The time spent in the plugin is shared with the native plugin
+            // through the control header so the bridging overhead can be
+            // measured
+            ProcessCallbackTimer callback_timer{};
+            YABRIDGE_PROBE(plugin_process_begin, process_request.sample_frames);
+            const auto process_start = std::chrono::steady_clock::now();
             if (process_request.double_precision) {
                 // XXX: Clangd doesn't let you specify template parameters
                 //      for templated lambdas. This argument should get
@@ -365,18 +463,58 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
             } else {
                 do_process(float());
             }
+            const auto process_end = std::chrono::steady_clock::now();
+            YABRIDGE_PROBE(plugin_process_end, process_request.sample_frames);
+            process_buffers_->record_plugin_time(process_end - process_start,
+                                                 callback_timer.elapsed());
+            if (config_.audio_deadline_warning) {
+                process_buffers_->record_block_timings(
+                    received_time, process_start, process_end,
+                    callback_timer.elapsed(), is_realtime_scheduled());
+            }
+
+            // With `vst2_async_automation` the native plugin will make the
+            // callbacks we queued during processing after it has received the
+            // processed audio
+            if (config_.vst2_async_automation) {
+                [[maybe_unused]] const bool response_written =
+                    write_shm_object(*process_buffers_,
+                                     AudioShmBuffer::MetadataRegion::response,
+                                     process_response_);
+                assert(response_written);
+
+                process_response_.host_callbacks.clear();
+            }
 
             // We modified the buffers within the `process_response` object,
             // so we can just send that object back. Like on the plugin side
             // we cannot reuse the request object because a plugin may have
-            // a different number of input and output channels
-            sockets_.host_vst_process_replacing_.send(Ack{}, buffer);
+            // a different number of input and output channels. If the
+            // `futex_signalling` option is enabled, then the native plugin
+            // will be waiting on the futex in the shared memory object instead
+            // of on the socket.
+            if (process_buffers_->signalling_enabled()) {
+                process_buffers_->notify_response();
+            } else {
+                sockets_.host_vst_process_replacing_.send(Ack{}, buffer);
+            }
 
             // See the docstrong on `should_clear_midi_events` for why we
             // don't just clear `next_buffer_midi_events` here
             should_clear_midi_events_ = true;
         });
     });
+
+    if (config_.audio_buffer_idle_release_s) {
+        async_release_idle_audio_buffers(
+            std::chrono::seconds(*config_.audio_buffer_idle_release_s));
+    }
+    if (config_.memory_merging || config_.memory_huge_pages) {
+        async_advise_anonymous_memory(config_.memory_merging,
+                                      config_.memory_huge_pages);
+    }
+
+    watch_config_file(config_);
 }
 
 #pragma GCC diagnostic pop
@@ -385,6 +523,124 @@ bool Vst2Bridge::inhibits_event_loop() noexcept {
     return !is_initialized_;
 }
 
+intptr_t Vst2Bridge::process_midi_events(const DynamicVstEvents& events,
+                                         int index,
+                                         intptr_t value,
+                                         float option) {
+    // For 99% of the plugins we can just call `effProcessReplacing()` and be
+    // done with it, but a select few plugins (I could only find Kontakt that
+    // does this) don't actually make copies of the events they receive and
+    // only store pointers to those events, meaning that they have to live at
+    // least until the next audio buffer gets processed. We're not using
+    // `passthrough_events()` here directly because we need to store a copy of
+    // the `DynamicVstEvents` struct before passing the generated `VstEvents`
+    // object to the plugin.
+    std::lock_guard lock(next_buffer_midi_events_mutex_);
+
+    // See the docstring on `should_clear_midi_events` for why we only
+    // deallocate old MIDI events here instead of a at the end of every
+    // processing cycle
+    if (should_clear_midi_events_) {
+        num_next_audio_buffer_midi_events_ = 0;
+        should_clear_midi_events_ = false;
+    }
+
+    // Copying into an object that has been used before reuses its buffers
+    if (num_next_audio_buffer_midi_events_ <
+        next_audio_buffer_midi_events_.size()) {
+        next_audio_buffer_midi_events_[num_next_audio_buffer_midi_events_] =
+            events;
+    } else {
+        next_audio_buffer_midi_events_.push_back(events);
+    }
+    DynamicVstEvents& stored_events =
+        next_audio_buffer_midi_events_[num_next_audio_buffer_midi_events_++];
+
+    // Exact same handling as in `passthrough_event()`, apart from making a
+    // copy of the events first
+    return plugin_->dispatcher(plugin_, effProcessEvents, index, value,
+                               &stored_events.as_c_events(), option);
+}
+
+Vst2ParameterDescriptions Vst2Bridge::describe_parameters(int first,
+                                                          int count) {
+    Vst2ParameterDescriptions result{};
+    const int last =
+        std::min(first + std::min(count, max_parameter_descriptions),
+                 plugin_->numParams);
+    if (first < 0 || first >= last) {
+        return result;
+    }
+
+    // Just like in `passthrough_event()`, we'll zero out the buffer before
+    // every call since not all plugins write anything for every parameter
+    std::array<char, max_string_length> string_buffer;
+    const auto get_string = [&](int opcode, int index) -> std::string {
+        string_buffer.fill(0);
+        plugin_->dispatcher(plugin_, opcode, index, 0, string_buffer.data(),
+                            0.0);
+        string_buffer.back() = 0;
+
+        return std::string(string_buffer.data());
+    };
+
+    result.descriptions.reserve(last - first);
+    for (int index = first; index < last; index++) {
+        result.descriptions.push_back(Vst2ParameterDescription{
+            .name = get_string(effGetParamName, index),
+            .label = get_string(effGetParamLabel, index),
+            .display = get_string(effGetParamDisplay, index)});
+    }
+
+    return result;
+}
+
+Vst2ProgramNames Vst2Bridge::get_program_names(int first, int count) {
+    Vst2ProgramNames result{};
+    const int last = std::min(first + std::min(count, max_program_names),
+                              plugin_->numPrograms);
+    if (first < 0 || first >= last) {
+        return result;
+    }
+
+    std::array<char, max_string_length> string_buffer;
+    result.names.reserve(last - first);
+    for (int index = first; index < last; index++) {
+        string_buffer.fill(0);
+        const intptr_t return_value =
+            plugin_->dispatcher(plugin_, effGetProgramNameIndexed, index, 0,
+                                string_buffer.data(), 0.0);
+        string_buffer.back() = 0;
+
+        // The native plugin will pass all program name requests through as
+        // usual when the plugin doesn't support this
+        if (return_value == 0 && index == first) {
+            return Vst2ProgramNames{};
+        }
+
+        result.names.emplace_back(string_buffer.data());
+    }
+
+    return result;
+}
+
+std::shared_ptr<void> Vst2Bridge::retain_module() {
+    if (!config_.group_module_cache) {
+        return nullptr;
+    }
+
+    // This only increases the library's reference count since it's already
+    // loaded
+    HMODULE handle = LoadLibrary(plugin_path_.string().c_str());
+    if (!handle) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<void>(handle, [](void* handle) {
+        FreeLibrary(static_cast<HMODULE>(handle));
+    });
+}
+
 void Vst2Bridge::run() {
     set_realtime_priority(true);
 
@@ -392,42 +648,41 @@ void Vst2Bridge::run() {
         std::nullopt,
         [&](Vst2Event& event, bool /*on_main_thread*/) -> Vst2EventResult {
             if (event.opcode == effProcessEvents) {
-                // For 99% of the plugins we can just call
-                // `effProcessReplacing()` and be done with it, but a select few
-                // plugins (I could only find Kontakt that does this) don't
-                // actually make copies of the events they receive and only
-                // store pointers to those events, meaning that they have to
-                // live at least until the next audio buffer gets processed.
-                // We're not using `passthrough_events()` here directly because
-                // we need to store a copy of the `DynamicVstEvents` struct
-                // before passing the generated `VstEvents` object to the
-                // plugin.
-                std::lock_guard lock(next_buffer_midi_events_mutex_);
-
-                // See the docstring on `should_clear_midi_events` for why we
-                // only deallocate old MIDI events here instead of a at the end
-                // of every processing cycle
-                if (should_clear_midi_events_) {
-                    next_audio_buffer_midi_events_.clear();
-                    should_clear_midi_events_ = false;
-                }
-
-                next_audio_buffer_midi_events_.push_back(
-                    std::get<DynamicVstEvents>(event.payload));
-                DynamicVstEvents& events =
-                    next_audio_buffer_midi_events_.back();
-
-                // Exact same handling as in `passthrough_event()`, apart from
-                // making a copy of the events first
-                const intptr_t return_value = plugin_->dispatcher(
-                    plugin_, event.opcode, event.index, event.value,
-                    &events.as_c_events(), event.option);
+                const intptr_t return_value = process_midi_events(
+                    std::get<DynamicVstEvents>(event.payload), event.index,
+                    event.value, event.option);
 
                 return Vst2EventResult{.return_value = return_value,
                                        .payload = nullptr,
                                        .value_payload = std::nullopt};
             }
 
+            // See `WantsParameterDescriptions`
+            if (std::holds_alternative<WantsParameterDescriptions>(
+                    event.payload)) {
+                return Vst2EventResult{
+                    .return_value = 1,
+                    .payload = describe_parameters(
+                        event.index, static_cast<int>(event.value)),
+                    .value_payload = std::nullopt};
+            }
+
+            // See `WantsProgramNames`. Hosts often refresh their program lists
+            // in response to `audioMasterUpdateDisplay()`, so this is handled
+            // the same way as `effGetProgramNameIndexed()` would be.
+            if (std::holds_alternative<WantsProgramNames>(event.payload)) {
+                Vst2ProgramNames program_names =
+                    mutual_recursion_.handle([&]() {
+                        return get_program_names(
+                            event.index, static_cast<int>(event.value));
+                    });
+
+                return Vst2EventResult{
+                    .return_value = !program_names.names.empty(),
+                    .payload = std::move(program_names),
+                    .value_payload = std::nullopt};
+            }
+
             Vst2EventResult result = passthrough_event(
                 plugin_,
                 [&](AEffect* plugin, int opcode, int index, intptr_t value,
@@ -487,6 +742,41 @@ void Vst2Bridge::run() {
                 },
                 event);
 
+            // With `vst2_chunk_cache` the native plugin will send the hash of
+            // the chunk it has cached, and we don't need to send the chunk back
+            // if it did not change
+            if (const auto* request =
+                    std::get_if<WantsChunkBuffer>(&event.payload);
+                request && request->cached_hash) {
+                if (const auto* chunk =
+                        std::get_if<ChunkData>(&result.payload);
+                    chunk &&
+                    hash_chunk_data(chunk->buffer) == *request->cached_hash) {
+                    result.payload = UnchangedChunkData{};
+                }
+            }
+
+            // `effOpen()` sends the entire `AEffect` back, so any later
+            // `audioMasterIOChanged()` calls should be relative to that
+            if (const auto* updated_plugin =
+                    std::get_if<AEffect>(&result.payload)) {
+                std::lock_guard lock(native_aeffect_mutex_);
+                update_aeffect(native_aeffect_, *updated_plugin);
+            }
+
+            // Any of these misses would mean that we did a callback over the
+            // socket from the audio thread
+            if (event.opcode == effMainsChanged && event.value == 0) {
+                if (const uint64_t misses =
+                        audio_thread_cache_misses_.exchange(0);
+                    misses > 0) {
+                    logger_.log("WARNING: " + std::to_string(misses) +
+                                " transport or process level callbacks from "
+                                "the audio thread could not be answered from "
+                                "the prefetched values");
+                }
+            }
+
             // We also need some special handling to set up audio processing.
             // After the plugin has finished setting up audio processing, we'll
             // initialize our shared audio buffers on this side and send the
@@ -499,6 +789,16 @@ void Vst2Bridge::run() {
             //       playback has never been initialized (and `effSetBlockSize`
             //       has never been called)
             if (event.opcode == effMainsChanged && event.value == 1) {
+                // The audio thread will pick this up during the next
+                // processing cycle
+                if (config_.audio_thread_sched_deadline &&
+                    max_samples_per_block_ && sample_rate_) {
+                    deadline_period_ns_.store(
+                        audio_block_period_ns(*max_samples_per_block_,
+                                              *sample_rate_),
+                        std::memory_order_relaxed);
+                }
+
                 // Returning another result this way is a bit ugly, but sadly
                 // optimizations have never made code nicer to read
                 return Vst2EventResult{.return_value = result.return_value,
@@ -514,14 +814,27 @@ void Vst2Bridge::close_sockets() {
     sockets_.close();
 }
 
+void Vst2Bridge::release_idle_audio_buffers(
+    std::chrono::steady_clock::duration timeout) {
+    // Plugins with an open editor may still be drawing meters or be about to
+    // start processing again, so we'll leave those alone
+    if (!editor_) {
+        idle_buffer_release_.release_if_idle(process_buffers_, timeout);
+    }
+}
+
 class HostCallbackDataConverter : public DefaultDataConverter {
    public:
     HostCallbackDataConverter(
         AEffect* plugin,
         VstTimeInfo& last_time_info,
+        AEffect& native_aeffect,
+        std::mutex& native_aeffect_mutex,
         MutualRecursionHelper<Win32Thread>& mutual_recursion) noexcept
         : plugin_(plugin),
           last_time_info_(last_time_info),
+          native_aeffect_(native_aeffect),
+          native_aeffect_mutex_(native_aeffect_mutex),
           mutual_recursion_(mutual_recursion) {}
 
     Vst2Event::Payload read_data(const int opcode,
@@ -532,12 +845,18 @@ class HostCallbackDataConverter : public DefaultDataConverter {
             case audioMasterGetTime:
                 return WantsVstTimeInfo{};
                 break;
-            case audioMasterIOChanged:
+            case audioMasterIOChanged: {
                 // This is a helpful event that indicates that the VST
-                // plugin's `AEffect` struct has changed. Writing these
+                // plugin's `AEffect` struct has changed. Usually only one or
+                // two fields change, so we'll only send those. Writing these
                 // results back is done inside of `passthrough_event()`.
-                return AEffect(*plugin_);
-                break;
+                std::lock_guard lock(native_aeffect_mutex_);
+                const AEffectDelta delta =
+                    AEffectDelta::between(native_aeffect_, *plugin_);
+                update_aeffect(native_aeffect_, *plugin_);
+
+                return delta;
+            } break;
             case audioMasterProcessEvents:
                 return DynamicVstEvents(*static_cast<const VstEvents*>(data));
                 break;
@@ -651,6 +970,8 @@ class HostCallbackDataConverter : public DefaultDataConverter {
    private:
     AEffect* plugin_;
     VstTimeInfo& last_time_info_;
+    AEffect& native_aeffect_;
+    std::mutex& native_aeffect_mutex_;
     MutualRecursionHelper<Win32Thread>& mutual_recursion_;
 };
 
@@ -665,22 +986,30 @@ intptr_t Vst2Bridge::host_callback(AEffect* effect,
         // transport information from the plugin side to avoid an unnecessary
         // callback
         case audioMasterGetTime: {
-            const VstTimeInfo* cached_time_info = time_info_cache_.get();
-            if (cached_time_info) {
+            if (const VstTimeInfo* const* cached_time_info =
+                    time_info_cache_.get()) {
                 // This cached value is temporary, so we'll still use the
-                // regular time info storing mechanism
-                last_time_info_ = *cached_time_info;
-                const intptr_t result =
-                    reinterpret_cast<intptr_t>(&last_time_info_);
+                // regular time info storing mechanism. If the host didn't
+                // return any transport information, then we'll also return a
+                // null pointer here.
+                intptr_t result = 0;
+                Vst2EventResult::Payload response = nullptr;
+                if (*cached_time_info) {
+                    last_time_info_ = **cached_time_info;
+                    result = reinterpret_cast<intptr_t>(&last_time_info_);
+                    response = last_time_info_;
+                }
 
                 // Make sure that these cached events don't get lost in the logs
                 logger_.log_event(false, opcode, index, value,
                                   WantsVstTimeInfo{}, option, std::nullopt);
-                logger_.log_event_response(false, opcode, result,
-                                           last_time_info_, std::nullopt, true);
+                logger_.log_event_response(false, opcode, result, response,
+                                           std::nullopt, true);
 
                 return result;
             }
+
+            record_audio_thread_cache_miss(opcode);
         } break;
         // We also send the current process level for similar reasons
         case audioMasterGetCurrentProcessLevel: {
@@ -694,6 +1023,84 @@ intptr_t Vst2Bridge::host_callback(AEffect* effect,
 
                 return *current_process_level;
             }
+
+            record_audio_thread_cache_miss(opcode);
+        } break;
+        // These only change when the host changes its processing setup, but
+        // some plugins query them from the audio thread every processing cycle
+        case audioMasterGetSampleRate:
+        case audioMasterGetBlockSize:
+        case audioMasterGetVendorVersion:
+        case audioMasterGetVendorString:
+        case audioMasterGetProductString:
+        case audioMasterCanDo: {
+            if (const std::optional<intptr_t> result =
+                    get_cached_host_callback_result(opcode, index, value, data,
+                                                    option)) {
+                return *result;
+            }
+        } break;
+        // The return values for these callbacks are not used for anything, so
+        // with `vst2_async_automation` we'll let the native plugin make these
+        // callbacks after the processing cycle instead of waiting for a round
+        // trip from the audio thread
+        case audioMasterAutomate:
+        case audioMasterBeginEdit:
+        case audioMasterEndEdit: {
+            if (config_.vst2_async_automation &&
+                GetCurrentThreadId() ==
+                    audio_thread_id_.load(std::memory_order_relaxed) &&
+                process_response_.host_callbacks.size() <
+                    max_queued_host_callbacks) {
+                process_response_.host_callbacks.push_back(
+                    Vst2QueuedHostCallback{
+                        .opcode = opcode, .index = index, .option = option});
+
+                return opcode == audioMasterAutomate ? 0 : 1;
+            }
+        } break;
+        // Some plugins report a latency change every time a parameter changes,
+        // and the host would recalculate its latency compensation every time.
+        // With `vst2_coalesce_io_changed` we'll send a single call on the next
+        // main loop tick instead, at which point the plugin will have settled
+        // on its new values.
+        case audioMasterIOChanged: {
+            if (!config_.vst2_coalesce_io_changed) {
+                break;
+            }
+
+            logger_.log_event(false, opcode, index, value, nullptr, option,
+                              std::nullopt);
+
+            if (!io_changed_pending_->exchange(true)) {
+                main_context_.schedule_task(
+                    [this,
+                     pending = std::weak_ptr<std::atomic_bool>(
+                         io_changed_pending_)]() {
+                        const std::shared_ptr<std::atomic_bool> is_pending =
+                            pending.lock();
+                        if (!is_pending) {
+                            return;
+                        }
+                        is_pending->store(false);
+
+                        HostCallbackDataConverter converter(
+                            plugin_, last_time_info_, native_aeffect_,
+                            native_aeffect_mutex_, mutual_recursion_);
+                        try {
+                            sockets_.vst_host_callback_.send_event(
+                                converter, std::nullopt, audioMasterIOChanged,
+                                0, 0, nullptr, 0.0);
+                        } catch (const std::system_error&) {
+                            // The sockets may already have been closed if the
+                            // plugin did this while it was being shut down
+                        }
+                    });
+            }
+
+            logger_.log_event_response(false, opcode, 1, nullptr, std::nullopt,
+                                       true);
+            return 1;
         } break;
         // If the plugin changes its window size, we'll also resize the wrapper
         // window accordingly.
@@ -705,9 +1112,152 @@ intptr_t Vst2Bridge::host_callback(AEffect* effect,
     }
 
     HostCallbackDataConverter converter(effect, last_time_info_,
+                                        native_aeffect_, native_aeffect_mutex_,
                                         mutual_recursion_);
-    return sockets_.vst_host_callback_.send_event(
+    const ProcessCallbackTimer::Callback callback_timer(
+        vst2_process_callback_histogram(opcode));
+    const intptr_t result = sockets_.vst_host_callback_.send_event(
         converter, std::nullopt, opcode, index, value, data, option);
+    cache_host_callback_result(opcode, data, result);
+
+    return result;
+}
+
+std::optional<intptr_t> Vst2Bridge::get_cached_host_callback_result(
+    int opcode,
+    int index,
+    intptr_t value,
+    void* data,
+    float option) {
+    std::lock_guard lock(host_callback_cache_mutex_);
+
+    const auto log_cached_value = [&](intptr_t result) {
+        logger_.log_event(false, opcode, index, value, nullptr, option,
+                          std::nullopt);
+        logger_.log_event_response(false, opcode, result, nullptr,
+                                   std::nullopt, true);
+
+        return result;
+    };
+    const auto write_cached_string =
+        [&](const std::optional<std::pair<intptr_t, std::string>>& cached)
+        -> std::optional<intptr_t> {
+        if (!cached || !data) {
+            return std::nullopt;
+        }
+
+        // These strings are limited to `kVstMaxVendorStrLen` and
+        // `kVstMaxProductStrLen` characters, and the host will already have
+        // truncated them
+        std::copy(cached->second.begin(), cached->second.end(),
+                  static_cast<char*>(data));
+        static_cast<char*>(data)[cached->second.size()] = '\0';
+
+        logger_.log_event(false, opcode, index, value, WantsString{}, option,
+                          std::nullopt);
+        logger_.log_event_response(false, opcode, cached->first,
+                                   cached->second, std::nullopt, true);
+
+        return cached->first;
+    };
+
+    switch (opcode) {
+        case audioMasterGetSampleRate:
+            if (const intptr_t* sample_rate =
+                    host_callback_cache_.sample_rate.get()) {
+                return log_cached_value(*sample_rate);
+            }
+            break;
+        case audioMasterGetBlockSize:
+            if (const intptr_t* block_size =
+                    host_callback_cache_.block_size.get()) {
+                return log_cached_value(*block_size);
+            }
+            break;
+        case audioMasterGetVendorVersion:
+            if (host_callback_cache_.vendor_version) {
+                return log_cached_value(*host_callback_cache_.vendor_version);
+            }
+            break;
+        case audioMasterGetVendorString:
+            return write_cached_string(host_callback_cache_.vendor_string);
+        case audioMasterGetProductString:
+            return write_cached_string(host_callback_cache_.product_string);
+        case audioMasterCanDo:
+            if (data) {
+                const std::string_view query(static_cast<const char*>(data));
+                if (const auto cached = host_callback_cache_.can_do.find(query);
+                    cached != host_callback_cache_.can_do.end()) {
+                    logger_.log_event(false, opcode, index, value,
+                                      std::string(query), option,
+                                      std::nullopt);
+                    logger_.log_event_response(false, opcode, cached->second,
+                                               nullptr, std::nullopt, true);
+
+                    return cached->second;
+                }
+            }
+            break;
+    }
+
+    return std::nullopt;
+}
+
+void Vst2Bridge::cache_host_callback_result(int opcode,
+                                            void* data,
+                                            intptr_t result) {
+    switch (opcode) {
+        case audioMasterGetSampleRate: {
+            std::lock_guard lock(host_callback_cache_mutex_);
+            host_callback_cache_.sample_rate.set(
+                result, host_setup_cache_lifetime_seconds);
+        } break;
+        case audioMasterGetBlockSize: {
+            std::lock_guard lock(host_callback_cache_mutex_);
+            host_callback_cache_.block_size.set(
+                result, host_setup_cache_lifetime_seconds);
+        } break;
+        case audioMasterGetVendorVersion: {
+            std::lock_guard lock(host_callback_cache_mutex_);
+            host_callback_cache_.vendor_version = result;
+        } break;
+        case audioMasterGetVendorString:
+        case audioMasterGetProductString: {
+            if (!data) {
+                break;
+            }
+
+            std::lock_guard lock(host_callback_cache_mutex_);
+            (opcode == audioMasterGetVendorString
+                 ? host_callback_cache_.vendor_string
+                 : host_callback_cache_.product_string)
+                .emplace(result, static_cast<const char*>(data));
+        } break;
+        case audioMasterCanDo: {
+            if (!data) {
+                break;
+            }
+
+            std::lock_guard lock(host_callback_cache_mutex_);
+            host_callback_cache_.can_do.insert_or_assign(
+                static_cast<const char*>(data), result);
+        } break;
+    }
+}
+
+void Vst2Bridge::record_audio_thread_cache_miss(int opcode) {
+    if (GetCurrentThreadId() !=
+        audio_thread_id_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    audio_thread_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    logger_.log_trace([&]() {
+        return "WARNING: '" + plugin_path_.filename().string() + "' called " +
+               opcode_to_string(false, opcode).value_or(
+                   std::to_string(opcode)) +
+               "() from the audio thread outside of a processing cycle";
+    });
 }
 
 intptr_t Vst2Bridge::dispatch_wrapper(AEffect* plugin,
@@ -727,6 +1277,21 @@ intptr_t Vst2Bridge::dispatch_wrapper(AEffect* plugin,
             // Used to initialize the shared audio buffers when handling
             // `effMainsChanged` in `Vst2Bridge::run()`
             max_samples_per_block_ = value;
+            {
+                std::lock_guard lock(host_callback_cache_mutex_);
+                host_callback_cache_.block_size.clear();
+            }
+
+            return plugin->dispatcher(plugin, opcode, index, value, data,
+                                      option);
+        } break;
+        case effSetSampleRate: {
+            // Used for the `audio_thread_sched_deadline` option
+            sample_rate_ = option;
+            {
+                std::lock_guard lock(host_callback_cache_mutex_);
+                host_callback_cache_.sample_rate.clear();
+            }
 
             return plugin->dispatcher(plugin, opcode, index, value, data,
                                       option);
@@ -799,26 +1364,35 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
     // the information already passed to us by the host. The offsets for each
     // audio channel are in samples (since they'll be used with pointer
     // arithmetic in `AudioShmBuffer`), and we'll only use the first bus (since
-    // VST2 plugins don't have multiple audio busses).
+    // VST2 plugins don't have multiple audio busses). Every channel is aligned
+    // to a cache line, and the inputs and outputs are separated by some
+    // padding to avoid false sharing between the two processes.
     assert(max_samples_per_block_);
+    const size_t sample_size =
+        double_precision_ ? sizeof(double) : sizeof(float);
+    const uint32_t channel_samples = AudioShmBuffer::aligned_channel_samples(
+        *max_samples_per_block_, sample_size);
     uint32_t current_offset = 0;
 
     std::vector<uint32_t> input_channel_offsets(plugin_->numInputs);
     for (int channel = 0; channel < plugin_->numInputs; channel++) {
         input_channel_offsets[channel] = current_offset;
-        current_offset += *max_samples_per_block_;
+        current_offset += channel_samples;
+    }
+
+    if (plugin_->numInputs > 0 && plugin_->numOutputs > 0) {
+        current_offset += AudioShmBuffer::region_padding_samples(sample_size);
     }
 
     std::vector<uint32_t> output_channel_offsets(plugin_->numOutputs);
     for (int channel = 0; channel < plugin_->numOutputs; channel++) {
         output_channel_offsets[channel] = current_offset;
-        current_offset += *max_samples_per_block_;
+        current_offset += channel_samples;
     }
 
     // The size of the buffer is in bytes, and it will depend on whether the
     // host is going to pass 32-bit or 64-bit audio to the plugin
-    const uint32_t buffer_size =
-        current_offset * (double_precision_ ? sizeof(double) : sizeof(float));
+    const uint32_t buffer_size = current_offset * sample_size;
 
     // We'll set up these shared memory buffers on the Wine side first, and then
     // when this request returns we'll do the same thing on the native plugin
@@ -826,13 +1400,33 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
     AudioShmBuffer::Config buffer_config{
         .name = sockets_.base_dir_.filename().string(),
         .size = buffer_size,
+        .capacity = static_cast<uint32_t>(
+            buffer_size * config_.audio_buffer_headroom.value_or(1.0f)),
         .input_offsets = {std::move(input_channel_offsets)},
-        .output_offsets = {std::move(output_channel_offsets)}};
+        .output_offsets = {std::move(output_channel_offsets)},
+        .signalling = config_.futex_signalling,
+        .metadata_capacity = config_.vst2_batch_midi_events ||
+                                     config_.vst2_async_automation
+                                 ? vst2_batched_process_metadata_capacity
+                                 : vst2_process_metadata_capacity,
+        .pinned = config_.pin_audio_buffers,
+        .reclaimable = config_.audio_buffer_reclaim};
+    std::unique_lock<std::mutex> idle_buffer_lock;
+    if (config_.audio_buffer_idle_release_s) {
+        idle_buffer_lock =
+            idle_buffer_release_.begin_processing(process_buffers_);
+    }
     if (!process_buffers_) {
         process_buffers_.emplace(buffer_config);
     } else {
         process_buffers_->resize(buffer_config);
     }
+    track_audio_buffer(0, process_buffers_->config_);
+
+    // The audio thread should never have to allocate when queueing callbacks
+    if (config_.vst2_async_automation) {
+        process_response_.host_callbacks.reserve(max_queued_host_callbacks);
+    }
 
     // The process functions expect a `T**` for their inputs and outputs, so
     // we'll also set those up right now
@@ -858,7 +1452,9 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
         }
     }
 
-    return buffer_config;
+    // The buffer may have reserved more capacity than what we asked for, so the
+    // native plugin should use the buffer's actual configuration
+    return process_buffers_->config_;
 }
 
 intptr_t VST_CALL_CONV host_callback_proxy(AEffect* effect,
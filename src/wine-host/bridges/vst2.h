@@ -18,6 +18,11 @@
 
 #include "../asio-fix.h"
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include <vestige/aeffectx.h>
 #include <windows.h>
 
@@ -44,6 +49,8 @@ class Vst2Bridge : public HostBridge {
      *   to load.
      * @param endpoint_base_dir The base directory used for the socket
      *   endpoints. See `Sockets` for more information.
+     * @param abstract_sockets Whether the socket endpoints are in the abstract
+     *   socket namespace. This is the case for individually hosted plugins.
      * @param parent_pid The process ID of the native plugin host this bridge is
      *   supposed to communicate with. Used as part of our watchdog to prevent
      *   dangling Wine processes.
@@ -57,10 +64,13 @@ class Vst2Bridge : public HostBridge {
     Vst2Bridge(MainContext& main_context,
                std::string plugin_dll_path,
                std::string endpoint_base_dir,
+               bool abstract_sockets,
                pid_t parent_pid);
 
     bool inhibits_event_loop() noexcept override;
 
+    std::shared_ptr<void> retain_module() override;
+
     /**
      * Here we'll handle incoming `dispatch()` messages until the sockets get
      * closed during `effClose()`.
@@ -70,6 +80,9 @@ class Vst2Bridge : public HostBridge {
    protected:
     void close_sockets() override;
 
+    void release_idle_audio_buffers(
+        std::chrono::steady_clock::duration timeout) override;
+
    public:
     /**
      * Forward the host callback made by the plugin to the host and return the
@@ -89,6 +102,66 @@ class Vst2Bridge : public HostBridge {
                               void* data,
                               float option);
 
+    /**
+     * Pass MIDI events to the plugin through `effProcessEvents()`, storing a
+     * copy of the events in `next_audio_buffer_midi_events_` first. This is
+     * used both when the host calls `effProcessEvents()` and for the events
+     * sent together with a processing request when the
+     * `vst2_batch_midi_events` option is enabled.
+     */
+    intptr_t process_midi_events(const DynamicVstEvents& events,
+                                 int index,
+                                 intptr_t value,
+                                 float option);
+
+    /**
+     * Call `effGetParamName()`, `effGetParamLabel()`, and
+     * `effGetParamDisplay()` for `count` parameters starting at `first`, and
+     * return all of the results at once. This handles
+     * `WantsParameterDescriptions` requests for the `vst2_parameter_info_cache`
+     * option.
+     */
+    Vst2ParameterDescriptions describe_parameters(int first, int count);
+
+    /**
+     * Call `effGetProgramNameIndexed()` for `count` programs starting at
+     * `first`, and return all of the names at once. This handles
+     * `WantsProgramNames` requests for the `vst2_program_name_cache` option.
+     * The result is empty if the plugin does not support
+     * `effGetProgramNameIndexed()`.
+     */
+    Vst2ProgramNames get_program_names(int first, int count);
+
+    /**
+     * Count and log an `audioMasterGetTime()` or
+     * `audioMasterGetCurrentProcessLevel()` callback that could not be answered
+     * from the prefetched values, if it was made from the audio thread.
+     *
+     * @see audio_thread_cache_misses_
+     */
+    void record_audio_thread_cache_miss(int opcode);
+
+    /**
+     * Try to answer a host callback from `host_callback_cache_`. Returns the
+     * callback's return value if the result was cached, and writes cached
+     * strings to `data`.
+     *
+     * @see cache_host_callback_result
+     */
+    std::optional<intptr_t> get_cached_host_callback_result(int opcode,
+                                                            int index,
+                                                            intptr_t value,
+                                                            void* data,
+                                                            float option);
+
+    /**
+     * Store the result of a host callback in `host_callback_cache_` if it's
+     * one of the callbacks that we cache. Called after the callback has been
+     * sent to the host, so string results will have already been written to
+     * `data`.
+     */
+    void cache_host_callback_result(int opcode, void* data, intptr_t result);
+
     /**
      * Sets up the shared memory audio buffers for this plugin instance and
      * returns the configuration so the native plugin can connect to it as well.
@@ -125,6 +198,12 @@ class Vst2Bridge : public HostBridge {
      */
     std::optional<AudioShmBuffer> process_buffers_;
 
+    /**
+     * Used to release `process_buffers_`'s memory while the plugin is idle
+     * when the `audio_buffer_idle_release_s` option is enabled.
+     */
+    IdleBufferRelease idle_buffer_release_;
+
     /**
      * Pointers to the input channels in process_buffers so we can pass them to
      * the plugin. These can be either `float*` or `double*`, so we sadly have
@@ -151,6 +230,22 @@ class Vst2Bridge : public HostBridge {
      */
     std::optional<uint32_t> max_samples_per_block_;
 
+    /**
+     * The sample rate set by the host through `effSetSampleRate()`. Used
+     * together with `max_samples_per_block_` to compute the period for the
+     * `audio_thread_sched_deadline` option.
+     */
+    std::optional<float> sample_rate_;
+
+    /**
+     * The duration of a block of audio in nanoseconds when the
+     * `audio_thread_sched_deadline` option is enabled, or 0 otherwise. This is
+     * set on the dispatch thread during `effMainsChanged()`, and the audio
+     * thread will switch to `SCHED_DEADLINE` with this period at the start of
+     * the next processing cycle.
+     */
+    std::atomic_uint64_t deadline_period_ns_ = 0;
+
     /**
      * Whether the host is going to send double precision audio or not. This
      * will only be the case if the host has called `effSetProcessPrecision()`
@@ -169,13 +264,43 @@ class Vst2Bridge : public HostBridge {
      */
     VstTimeInfo last_time_info_;
 
+    /**
+     * The values of the plugin's `AEffect` struct as the native plugin last
+     * received them. `audioMasterIOChanged()` only sends the fields that
+     * changed since then.
+     *
+     * @see AEffectDelta
+     */
+    AEffect native_aeffect_{};
+    std::mutex native_aeffect_mutex_;
+
+    /**
+     * Set while an `audioMasterIOChanged()` call is scheduled to be sent to
+     * the host on the main thread when the `vst2_coalesce_io_changed` option
+     * is enabled. Any calls the plugin makes before then are dropped. The
+     * scheduled task only holds a weak reference to this so it won't do
+     * anything if the bridge has been destroyed by then.
+     */
+    std::shared_ptr<std::atomic_bool> io_changed_pending_ =
+        std::make_shared<std::atomic_bool>(false);
+
     /**
      * This will temporarily cache the current time info during an audio
      * processing call to avoid an additional callback every processing cycle.
      * Some faulty plugins may even request this information for every sample,
-     * which would otherwise cause a very noticeable performance hit.
+     * which would otherwise cause a very noticeable performance hit. This
+     * points to the transport information decoded by `time_info_decoder_`,
+     * and it's a null pointer during processing if the host did not return any
+     * transport information. That way `audioMasterGetTime()` calls made during
+     * processing never have to go through the socket.
+     */
+    ScopedValueCache<const VstTimeInfo*> time_info_cache_;
+
+    /**
+     * Reconstructs the delta encoded transport information sent as part of
+     * every processing request. Only accessed from the audio thread.
      */
-    ScopedValueCache<VstTimeInfo> time_info_cache_;
+    Vst2TimeInfoDecoder time_info_decoder_;
 
     /**
      * Some plugins will also ask for the current process level during audio
@@ -183,6 +308,50 @@ class Vst2Bridge : public HostBridge {
      */
     ScopedValueCache<int> process_level_cache_;
 
+    /**
+     * The number of `audioMasterGetTime()` and
+     * `audioMasterGetCurrentProcessLevel()` calls made from the audio thread
+     * that could not be answered using the values prefetched for the current
+     * processing cycle. This should always stay at zero. The count is printed
+     * when the host suspends the plugin.
+     *
+     * @see record_audio_thread_cache_miss
+     */
+    std::atomic_uint64_t audio_thread_cache_misses_ = 0;
+
+    /**
+     * Results for host callbacks that query the host's capabilities and its
+     * processing setup. These don't change while the plugin is running, but
+     * some plugins query them from the audio thread every processing cycle.
+     * The sample rate and the block size are dropped when the host sends us
+     * `effSetSampleRate()` or `effSetBlockSize()`, and they also expire after
+     * `host_setup_cache_lifetime_seconds` in case the host changes its setup
+     * without telling us.
+     *
+     * @see get_cached_host_callback_result
+     */
+    struct HostCallbackCache {
+        TimedValueCache<intptr_t> sample_rate;
+        TimedValueCache<intptr_t> block_size;
+        std::optional<intptr_t> vendor_version;
+        /**
+         * The return values and strings returned by
+         * `audioMasterGetVendorString()` and `audioMasterGetProductString()`.
+         */
+        std::optional<std::pair<intptr_t, std::string>> vendor_string;
+        std::optional<std::pair<intptr_t, std::string>> product_string;
+        /**
+         * The results from `audioMasterCanDo()`, indexed by the query string.
+         * This uses a transparent comparator so we can look up queries without
+         * allocating.
+         */
+        std::map<std::string, intptr_t, std::less<>> can_do;
+    } host_callback_cache_;
+    /**
+     * These callbacks may be made from any thread, including the audio thread.
+     */
+    PiMutex host_callback_cache_mutex_;
+
     // FIXME: This emits `-Wignored-attributes` as of Wine 5.22
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wignored-attributes"
@@ -207,6 +376,21 @@ class Vst2Bridge : public HostBridge {
      */
     bool is_initialized_ = false;
 
+    /**
+     * The Win32 thread ID of `process_replacing_handler_`. Used to tell whether
+     * a host callback was made from the audio thread for the
+     * `vst2_async_automation` option.
+     */
+    std::atomic<DWORD> audio_thread_id_ = 0;
+
+    /**
+     * The host callbacks the plugin has made from the audio thread during the
+     * current processing cycle when the `vst2_async_automation` option is
+     * enabled. These are sent to the native plugin together with the processed
+     * audio. Only accessed from the audio thread.
+     */
+    Vst2ProcessResponse process_response_;
+
     /**
      * The thread that responds to `getParameter` and `setParameter` requests.
      */
@@ -243,8 +427,13 @@ class Vst2Bridge : public HostBridge {
      * Technically a host can send more than one of these at a time, but in
      * practice every host will bundle all events in a single
      * `effProcessEvents()` call.
+     *
+     * Only the first `num_next_audio_buffer_midi_events_` elements are in use.
+     * The other objects are kept around so their buffers can be reused
+     * instead of having to allocate new buffers for every processing cycle.
      */
     llvm::SmallVector<DynamicVstEvents, 1> next_audio_buffer_midi_events_;
+    size_t num_next_audio_buffer_midi_events_ = 0;
     /**
      * Whether `next_audio_buffer_midi_events` should be cleared before
      * inserting new events.
@@ -257,9 +446,10 @@ class Vst2Bridge : public HostBridge {
     bool should_clear_midi_events_ = false;
     /**
      * Mutex for locking the above event queue, since recieving and processing
-     * now happens in two different threads.
+     * now happens in two different threads. This uses priority inheritance
+     * since the audio thread locks it during every processing cycle.
      */
-    std::mutex next_buffer_midi_events_mutex_;
+    PiMutex next_buffer_midi_events_mutex_;
 
     /**
      * Used to allow the responses to host callbacks to be handled on the same
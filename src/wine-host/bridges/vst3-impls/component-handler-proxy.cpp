@@ -16,6 +16,7 @@
 
 #include "component-handler-proxy.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "context-menu-proxy.h"
@@ -26,6 +27,22 @@ Vst3ComponentHandlerProxyImpl::Vst3ComponentHandlerProxyImpl(
     : Vst3ComponentHandlerProxy(std::move(args)), bridge_(bridge) {
     // The lifecycle of this object is managed together with that of the plugin
     // object instance this host context got passed to
+    if (bridge_.config().vst3_edit_coalescing_ms) {
+        edit_flush_thread_ = Win32Thread([this]() { run_edit_flush_loop(); });
+    }
+    if (bridge_.config().vst3_restart_coalescing_ms) {
+        restart_flush_thread_ =
+            Win32Thread([this]() { run_restart_flush_loop(); });
+    }
+}
+
+Vst3ComponentHandlerProxyImpl::~Vst3ComponentHandlerProxyImpl() noexcept {
+    {
+        std::lock_guard lock(pending_edits_mutex_);
+        stopping_ = true;
+    }
+    pending_edits_cv_.notify_all();
+    pending_restart_cv_.notify_all();
 }
 
 tresult PLUGIN_API
@@ -41,6 +58,9 @@ Vst3ComponentHandlerProxyImpl::queryInterface(const Steinberg::TUID _iid,
 
 tresult PLUGIN_API
 Vst3ComponentHandlerProxyImpl::beginEdit(Steinberg::Vst::ParamID id) {
+    std::lock_guard lock(edit_order_mutex_);
+    flush_pending_edits();
+
     return bridge_.send_message(YaComponentHandler::BeginEdit{
         .owner_instance_id = owner_instance_id(), .id = id});
 }
@@ -48,6 +68,27 @@ Vst3ComponentHandlerProxyImpl::beginEdit(Steinberg::Vst::ParamID id) {
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::performEdit(
     Steinberg::Vst::ParamID id,
     Steinberg::Vst::ParamValue valueNormalized) {
+    // With edit coalescing enabled the flush thread will send this edit to the
+    // host together with any other edits made in the same time window
+    if (bridge_.config().vst3_edit_coalescing_ms) {
+        {
+            std::lock_guard lock(pending_edits_mutex_);
+            if (auto it = std::find_if(
+                    pending_edits_.begin(), pending_edits_.end(),
+                    [id](const auto& edit) { return edit.id == id; });
+                it != pending_edits_.end()) {
+                it->value_normalized = valueNormalized;
+            } else {
+                pending_edits_.push_back(
+                    YaComponentHandler::PerformEdits::Edit{
+                        .id = id, .value_normalized = valueNormalized});
+            }
+        }
+        pending_edits_cv_.notify_one();
+
+        return Steinberg::kResultOk;
+    }
+
     // HACK: Ardour/Mixbus will in some cases immediately call
     //       `IEditController::setParamNormalized()` after this `performEdit()`,
     //       so we need to be able to receive that
@@ -61,20 +102,48 @@ tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::performEdit(
 
 tresult PLUGIN_API
 Vst3ComponentHandlerProxyImpl::endEdit(Steinberg::Vst::ParamID id) {
+    std::lock_guard lock(edit_order_mutex_);
+    flush_pending_edits();
+
     return bridge_.send_message(YaComponentHandler::EndEdit{
         .owner_instance_id = owner_instance_id(), .id = id});
 }
 
 tresult PLUGIN_API
 Vst3ComponentHandlerProxyImpl::restartComponent(int32 flags) {
-    return bridge_.send_mutually_recursive_message(
-        YaComponentHandler::RestartComponent{
-            .owner_instance_id = owner_instance_id(), .flags = flags});
+    // With restart coalescing enabled the flush thread will send a single
+    // `restartComponent()` call with the flags from all calls made in the same
+    // time window
+    if (bridge_.config().vst3_restart_coalescing_ms) {
+        {
+            std::lock_guard lock(pending_edits_mutex_);
+            pending_restart_flags_ |= flags;
+        }
+        pending_restart_cv_.notify_one();
+
+        return Steinberg::kResultOk;
+    }
+
+    std::lock_guard lock(edit_order_mutex_);
+    flush_pending_edits();
+
+    const YaComponentHandler::RestartComponent request{
+        .owner_instance_id = owner_instance_id(), .flags = flags};
+    if (bridge_.maybe_send_message_async(request)) {
+        return Steinberg::kResultOk;
+    }
+
+    return bridge_.send_mutually_recursive_message(request);
 }
 
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::setDirty(TBool state) {
-    return bridge_.send_message(YaComponentHandler2::SetDirty{
-        .owner_instance_id = owner_instance_id(), .state = state});
+    const YaComponentHandler2::SetDirty request{
+        .owner_instance_id = owner_instance_id(), .state = state};
+    if (bridge_.maybe_send_message_async(request)) {
+        return Steinberg::kResultOk;
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API
@@ -156,10 +225,14 @@ tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::start(
 tresult PLUGIN_API
 Vst3ComponentHandlerProxyImpl::update(ID id,
                                       Steinberg::Vst::ParamValue normValue) {
-    return bridge_.send_message(
-        YaProgress::Update{.owner_instance_id = owner_instance_id(),
-                           .id = id,
-                           .norm_value = normValue});
+    const YaProgress::Update request{.owner_instance_id = owner_instance_id(),
+                                     .id = id,
+                                     .norm_value = normValue};
+    if (bridge_.maybe_send_message_async(request)) {
+        return Steinberg::kResultOk;
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::finish(ID id) {
@@ -169,24 +242,131 @@ tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::finish(ID id) {
 
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::notifyUnitSelection(
     Steinberg::Vst::UnitID unitId) {
-    return bridge_.send_message(YaUnitHandler::NotifyUnitSelection{
-        .owner_instance_id = owner_instance_id(), .unit_id = unitId});
+    const YaUnitHandler::NotifyUnitSelection request{
+        .owner_instance_id = owner_instance_id(), .unit_id = unitId};
+    if (bridge_.maybe_send_message_async(request)) {
+        return Steinberg::kResultOk;
+    }
+
+    return bridge_.send_message(request);
 }
 
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::notifyProgramListChange(
     Steinberg::Vst::ProgramListID listId,
     int32 programIndex) {
+    const YaUnitHandler::NotifyProgramListChange request{
+        .owner_instance_id = owner_instance_id(),
+        .list_id = listId,
+        .program_index = programIndex};
+    if (bridge_.maybe_send_message_async(request)) {
+        return Steinberg::kResultOk;
+    }
+
     // NOTE: When a plugin calls this, Ardour will fetch the new program names
     //       with `IUnitInfo::getProgramName()`. TEOTE requires this to be
     //       called from the same thread.
-    return bridge_.send_mutually_recursive_message(
-        YaUnitHandler::NotifyProgramListChange{
-            .owner_instance_id = owner_instance_id(),
-            .list_id = listId,
-            .program_index = programIndex});
+    return bridge_.send_mutually_recursive_message(request);
 }
 
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::notifyUnitByBusChange() {
-    return bridge_.send_message(YaUnitHandler2::NotifyUnitByBusChange{
-        .owner_instance_id = owner_instance_id()});
+    const YaUnitHandler2::NotifyUnitByBusChange request{
+        .owner_instance_id = owner_instance_id()};
+    if (bridge_.maybe_send_message_async(request)) {
+        return Steinberg::kResultOk;
+    }
+
+    return bridge_.send_message(request);
+}
+
+void Vst3ComponentHandlerProxyImpl::flush_pending_edits() {
+    YaComponentHandler::PerformEdits request{
+        .owner_instance_id = owner_instance_id(), .edits = {}};
+    {
+        std::lock_guard lock(pending_edits_mutex_);
+        request.edits.swap(pending_edits_);
+    }
+
+    // HACK: Like with regular `performEdit()` calls, Ardour/Mixbus may call
+    //       `IEditController::setParamNormalized()` in response to these edits
+    if (!request.edits.empty()) {
+        bridge_.send_mutually_recursive_message(request);
+    }
+}
+
+void Vst3ComponentHandlerProxyImpl::run_edit_flush_loop() {
+    const std::chrono::milliseconds coalescing_window(
+        *bridge_.config().vst3_edit_coalescing_ms);
+
+    std::unique_lock lock(pending_edits_mutex_);
+    while (true) {
+        pending_edits_cv_.wait(
+            lock, [&]() { return stopping_ || !pending_edits_.empty(); });
+        if (stopping_) {
+            break;
+        }
+
+        // The first edit starts the coalescing window. Any more edits made
+        // during this window will be sent in the same batch.
+        if (pending_edits_cv_.wait_for(lock, coalescing_window,
+                                       [&]() { return stopping_; })) {
+            break;
+        }
+
+        lock.unlock();
+        {
+            std::lock_guard order_lock(edit_order_mutex_);
+            flush_pending_edits();
+        }
+        lock.lock();
+    }
+}
+
+void Vst3ComponentHandlerProxyImpl::flush_pending_restart() {
+    int32 flags;
+    {
+        std::lock_guard lock(pending_edits_mutex_);
+        flags = pending_restart_flags_;
+        pending_restart_flags_ = 0;
+    }
+
+    if (flags == 0) {
+        return;
+    }
+
+    // Any edits made before the restart request should still arrive first
+    flush_pending_edits();
+
+    // This runs on a background thread, so unlike in `restartComponent()`
+    // there's no point in allowing mutual recursion here
+    const YaComponentHandler::RestartComponent request{
+        .owner_instance_id = owner_instance_id(), .flags = flags};
+    if (!bridge_.maybe_send_message_async(request)) {
+        bridge_.send_message(request);
+    }
+}
+
+void Vst3ComponentHandlerProxyImpl::run_restart_flush_loop() {
+    const std::chrono::milliseconds coalescing_window(
+        *bridge_.config().vst3_restart_coalescing_ms);
+
+    std::unique_lock lock(pending_edits_mutex_);
+    while (true) {
+        pending_restart_cv_.wait(
+            lock, [&]() { return stopping_ || pending_restart_flags_ != 0; });
+        if (stopping_) {
+            break;
+        }
+
+        if (pending_restart_cv_.wait_for(lock, coalescing_window,
+                                         [&]() { return stopping_; })) {
+            break;
+        }
+
+        lock.unlock();
+        {
+            std::lock_guard order_lock(edit_order_mutex_);
+            flush_pending_restart();
+        }
+        lock.lock();
+    }
 }
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
+
 #include "../vst3.h"
 
 class Vst3ComponentHandlerProxyImpl : public Vst3ComponentHandlerProxy {
@@ -24,6 +27,13 @@ class Vst3ComponentHandlerProxyImpl : public Vst3ComponentHandlerProxy {
         Vst3Bridge& bridge,
         Vst3ComponentHandlerProxy::ConstructArgs&& args) noexcept;
 
+    /**
+     * Stop the thread used for sending coalesced parameter edits. Edits that
+     * have not yet been sent at this point are dropped, since the object
+     * instance this component handler belongs to is being torn down.
+     */
+    ~Vst3ComponentHandlerProxyImpl() noexcept override;
+
     /**
      * We'll override the query interface to log queries for interfaces we do
      * not (yet) support.
@@ -75,5 +85,79 @@ class Vst3ComponentHandlerProxyImpl : public Vst3ComponentHandlerProxy {
     tresult PLUGIN_API notifyUnitByBusChange() override;
 
    private:
+    /**
+     * Send all pending coalesced parameter edits to the host. This should be
+     * called while holding `edit_order_mutex_`.
+     *
+     * @see pending_edits_
+     */
+    void flush_pending_edits();
+
+    /**
+     * Wait for parameter edits to arrive, wait another
+     * `vst3_edit_coalescing_ms` milliseconds for more edits to come in, and
+     * then send them to the host. This runs on `edit_flush_thread_` until
+     * the object gets destroyed.
+     */
+    void run_edit_flush_loop();
+
+    /**
+     * Send the combined flags from all `restartComponent()` calls made since
+     * the last flush to the host, if there are any. This should be called
+     * while holding `edit_order_mutex_`.
+     *
+     * @see pending_restart_flags_
+     */
+    void flush_pending_restart();
+
+    /**
+     * Wait for a `restartComponent()` call, wait another
+     * `vst3_restart_coalescing_ms` milliseconds for more calls to come in, and
+     * then send a single call with all of their flags to the host. This runs on
+     * `restart_flush_thread_` until the object gets destroyed.
+     */
+    void run_restart_flush_loop();
+
     Vst3Bridge& bridge_;
+
+    /**
+     * The `performEdit()` calls made by the plugin that have not yet been sent
+     * to the host when the `vst3_edit_coalescing_ms` option is enabled. Every
+     * parameter occurs at most once, and later edits to the same parameter
+     * overwrite earlier ones. The edits are kept in the order the plugin first
+     * touched each parameter.
+     */
+    std::vector<YaComponentHandler::PerformEdits::Edit> pending_edits_;
+    std::mutex pending_edits_mutex_;
+    std::condition_variable pending_edits_cv_;
+    bool stopping_ = false;
+
+    /**
+     * Held while sending pending edits, and while sending the `beginEdit()`,
+     * `endEdit()`, and `restartComponent()` calls that have to be ordered
+     * with respect to those edits. Without this the flush thread could send a
+     * batch of edits after the `endEdit()` call that should have come after
+     * them.
+     */
+    std::mutex edit_order_mutex_;
+
+    /**
+     * The flags passed to all `restartComponent()` calls that have not yet
+     * been sent to the host when the `vst3_restart_coalescing_ms` option is
+     * enabled, OR'ed together. Protected by `pending_edits_mutex_`.
+     */
+    int32 pending_restart_flags_ = 0;
+    std::condition_variable pending_restart_cv_;
+
+    /**
+     * Sends coalesced parameter edits to the host. Only started when the
+     * `vst3_edit_coalescing_ms` option is enabled. This is declared last so it
+     * gets joined before any of the fields it uses are destroyed.
+     */
+    Win32Thread edit_flush_thread_;
+    /**
+     * Sends coalesced restart requests to the host. Only started when the
+     * `vst3_restart_coalescing_ms` option is enabled.
+     */
+    Win32Thread restart_flush_thread_;
 };
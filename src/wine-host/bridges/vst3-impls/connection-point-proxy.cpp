@@ -53,13 +53,29 @@ Vst3ConnectionPointProxyImpl::disconnect(IConnectionPoint* /*other*/) {
 tresult PLUGIN_API
 Vst3ConnectionPointProxyImpl::notify(Steinberg::Vst::IMessage* message) {
     if (message) {
+        // If we already know which object is on the other end of the host's
+        // connection proxy, then we can skip the round trip through the host
+        // entirely. This is the same as what happens when the host connects
+        // the objects directly.
+        if (const size_t peer_instance_id = peer_instance_id_.load();
+            peer_instance_id != no_peer_instance_id) {
+            if (const auto result = bridge_.notify_instance_directly(
+                    peer_instance_id, message)) {
+                return *result;
+            }
+
+            // The other object is gone, so we'll go through the host again
+            peer_instance_id_.store(no_peer_instance_id);
+        }
+
         // FabFilter plugins require this to be done from the GUI thread so we
         // need to use our mutual recursion mechanism. Luckily only Ardour uses
         // connection proxies, so if this ends up breaking something it will
         // only affect Ardour.
         return bridge_.send_mutually_recursive_message(
-            YaConnectionPoint::Notify{.instance_id = owner_instance_id(),
-                                      .message_ptr = YaMessagePtr(*message)});
+            YaConnectionPoint::Notify{
+                .instance_id = owner_instance_id(),
+                .message_ptr = YaMessagePtr(*message, owner_instance_id())});
     } else {
         std::cerr << "WARNING: Null pointer passed to "
                      "'IConnectionPoint::notify()', ignoring"
@@ -67,3 +83,8 @@ Vst3ConnectionPointProxyImpl::notify(Steinberg::Vst::IMessage* message) {
         return Steinberg::kInvalidArgument;
     }
 }
+
+void Vst3ConnectionPointProxyImpl::set_peer_instance_id(
+    size_t instance_id) noexcept {
+    peer_instance_id_.store(instance_id);
+}
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "../vst3.h"
 
 class Vst3ConnectionPointProxyImpl : public Vst3ConnectionPointProxy {
@@ -36,6 +38,27 @@ class Vst3ConnectionPointProxyImpl : public Vst3ConnectionPointProxy {
     tresult PLUGIN_API disconnect(IConnectionPoint* other) override;
     tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) override;
 
+    /**
+     * Remember that messages sent through this proxy end up at the object
+     * instance with the given ID. Called by the Wine plugin host after a
+     * message sent through the host's connection proxy arrives at another
+     * object in this same process. After that, `notify()` will pass messages
+     * to that object directly instead of sending them to the host.
+     */
+    void set_peer_instance_id(size_t instance_id) noexcept;
+
    private:
     Vst3Bridge& bridge_;
+
+    /**
+     * The instance ID of the object on the other side of the host's connection
+     * proxy, once we know it. Hosts like Ardour always place a single proxy
+     * between exactly two objects, so once a message has made it from this
+     * object to another object in the Wine plugin host, every later message
+     * will as well.
+     *
+     * @see set_peer_instance_id
+     */
+    std::atomic<size_t> peer_instance_id_ = no_peer_instance_id;
+    static constexpr size_t no_peer_instance_id = ~static_cast<size_t>(0);
 };
@@ -113,33 +113,29 @@ tresult PLUGIN_API Vst3ContextMenuProxyImpl::getItem(
 tresult PLUGIN_API
 Vst3ContextMenuProxyImpl::addItem(const Steinberg::Vst::IContextMenuItem& item,
                                   Steinberg::Vst::IContextMenuTarget* target) {
-    // TODO: I haven't come across a plugin that adds its own items to the
-    //       host's context menu, so this hasn't been tested yet
-    const tresult result = bridge_.send_message(YaContextMenu::AddItem{
-        .owner_instance_id = owner_instance_id(),
-        .context_menu_id = context_menu_id(),
+    // Plugins that build large menus add hundreds of items before showing the
+    // menu, so instead of doing a round trip for every item we'll send them to
+    // the host in one go right before the next message for this menu. This
+    // means that we can't return the host's result here, but the host's
+    // `addItem()` should only fail for invalid items anyways.
+    pending_items_.push_back(YaContextMenu::BatchedItem{
         .item = item,
-        .target = (target ? std::optional(YaContextMenuTarget::ConstructArgs{
-                                .owner_instance_id = owner_instance_id(),
-                                .context_menu_id = context_menu_id(),
-                                // This item ID isn't actually used here because
-                                // it's only needed to work around a Bitwig bug
-                                // when calling host menu items from a plugin
-                                .item_id = static_cast<int32>(items_.size()),
-                                .tag = item.tag})
-                          : std::nullopt)});
+        // This item ID isn't actually used here because it's only needed to
+        // work around a Bitwig bug when calling host menu items from a plugin
+        .item_id = static_cast<int32>(items_.size()),
+        .has_target = target != nullptr});
 
-    if (result == Steinberg::kResultOk) {
-        items_.push_back(item);
-        plugin_targets_[item.tag] = target;
-    }
+    items_.push_back(item);
+    plugin_targets_[item.tag] = target;
 
-    return result;
+    return Steinberg::kResultOk;
 }
 
 tresult PLUGIN_API Vst3ContextMenuProxyImpl::removeItem(
     const Steinberg::Vst::IContextMenuItem& item,
     Steinberg::Vst::IContextMenuTarget* /*target*/) {
+    flush_pending_items();
+
     const tresult result = bridge_.send_message(
         YaContextMenu::RemoveItem{.owner_instance_id = owner_instance_id(),
                                   .context_menu_id = context_menu_id(),
@@ -167,6 +163,8 @@ tresult PLUGIN_API Vst3ContextMenuProxyImpl::removeItem(
 
 tresult PLUGIN_API Vst3ContextMenuProxyImpl::popup(Steinberg::UCoord x,
                                                    Steinberg::UCoord y) {
+    flush_pending_items();
+
     // NOTE: This requires mutual recursion, because REAPER will call
     //       `getState()` whle the context menu is open, and `getState()` also
     //       has to be handled from the GUI thread
@@ -176,3 +174,37 @@ tresult PLUGIN_API Vst3ContextMenuProxyImpl::popup(Steinberg::UCoord x,
                              .x = x,
                              .y = y});
 }
+
+void Vst3ContextMenuProxyImpl::flush_pending_items() {
+    if (pending_items_.empty()) {
+        return;
+    }
+
+    const YaContextMenu::AddItems request{
+        .owner_instance_id = owner_instance_id(),
+        .context_menu_id = context_menu_id(),
+        .items = std::move(pending_items_)};
+    pending_items_.clear();
+
+    const YaContextMenu::AddItemsResponse response =
+        bridge_.send_message(request);
+
+    // We optimistically added the items in `addItem()`, so the ones the host
+    // rejected need to be removed again
+    for (size_t i = 0;
+         i < std::min(response.results.size(), request.items.size()); i++) {
+        if (response.results[i] == Steinberg::kResultOk) {
+            continue;
+        }
+
+        const int32 tag = request.items[i].item.tag;
+        items_.erase(
+            std::remove_if(
+                items_.begin(), items_.end(),
+                [&](const Steinberg::Vst::IContextMenuItem& candidate_item) {
+                    return candidate_item.tag == tag;
+                }),
+            items_.end());
+        plugin_targets_.erase(tag);
+    }
+}
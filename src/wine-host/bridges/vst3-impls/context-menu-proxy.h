@@ -50,6 +50,15 @@ class Vst3ContextMenuProxyImpl : public Vst3ContextMenuProxy {
                Steinberg::Vst::IContextMenuTarget* target) override;
     tresult PLUGIN_API popup(Steinberg::UCoord x, Steinberg::UCoord y) override;
 
+    /**
+     * Send all items added through `addItem()` since the last call to the host
+     * in a single `YaContextMenu::AddItems` message. Items the host rejected
+     * are removed again. This is called before any other message that
+     * concerns this context menu is sent so the host sees the calls in the
+     * same order the plugin made them.
+     */
+    void flush_pending_items();
+
     /**
      * The targets passed when to `addItem()` calls made by the plugin. This way
      * we can call these same targets later. The key here is the item's tag.
@@ -82,4 +91,11 @@ class Vst3ContextMenuProxyImpl : public Vst3ContextMenuProxy {
      * This will be initialized with targets created by the host.
      */
     std::vector<Steinberg::Vst::IContextMenuItem> items_;
+
+    /**
+     * Items added by the plugin that have not yet been sent to the host.
+     * `addItem()` only appends to this list, and the items are sent in one go
+     * by `flush_pending_items()`.
+     */
+    std::vector<YaContextMenu::BatchedItem> pending_items_;
 };
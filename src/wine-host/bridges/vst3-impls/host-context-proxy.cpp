@@ -43,8 +43,10 @@ tresult PLUGIN_API
 Vst3HostContextProxyImpl::getName(Steinberg::Vst::String128 name) {
     if (name) {
         const GetNameResponse response =
-            bridge_.send_message(YaHostApplication::GetName{
-                .owner_instance_id = owner_instance_id()});
+            prefetched_name()
+                ? *prefetched_name()
+                : bridge_.send_message(YaHostApplication::GetName{
+                      .owner_instance_id = owner_instance_id()});
 
         std::copy(response.name.begin(), response.name.end(), name);
         name[response.name.size()] = 0;
@@ -95,10 +97,23 @@ Vst3HostContextProxyImpl::createInstance(Steinberg::TUID /*cid*/,
 tresult PLUGIN_API
 Vst3HostContextProxyImpl::isPlugInterfaceSupported(const Steinberg::TUID _iid) {
     if (_iid) {
+        // The host's answers for all interfaces yabridge can bridge will have
+        // been fetched when the host context was passed to the plugin
+        if (const std::optional<tresult> result =
+                prefetched_plug_interface_support(_iid)) {
+            bridge_.logger_.log_trace([&]() {
+                return "IPlugInterfaceSupport::isPlugInterfaceSupported(" +
+                       format_uid(Steinberg::FUID::fromTUID(_iid)) +
+                       ") answered from the prefetched interfaces";
+            });
+
+            return *result;
+        }
+
         return bridge_.send_message(
             YaPlugInterfaceSupport::IsPlugInterfaceSupported{
                 .owner_instance_id = owner_instance_id(),
-                .iid = *reinterpret_cast<const Steinberg::TUID*>(&_iid)});
+                .iid = *reinterpret_cast<const Steinberg::TUID*>(&*_iid)});
     } else {
         bridge_.logger_.log(
             "WARNING: Null pointer passed to "
@@ -16,8 +16,10 @@
 
 #include "vst3.h"
 
+#include <algorithm>
 #include <bitset>
 
+#include "../../common/realtime-allocation-check.h"
 #include "vst3-impls/component-handler-proxy.h"
 #include "vst3-impls/connection-point-proxy.h"
 #include "vst3-impls/context-menu-proxy.h"
@@ -43,6 +45,27 @@ Steinberg::FUnknownPtr<Steinberg::IPluginBase> hack_init_plugin_base(
     Steinberg::IPtr<Steinberg::FUnknown> object,
     Steinberg::IPtr<Steinberg::Vst::IComponent> component);
 
+/**
+ * VST3 modules loaded by bridges with the `group_module_cache` option enabled,
+ * indexed by their canonical path. A new bridge for the same module will reuse
+ * the module and its plugin factory as long as it is still alive, either
+ * because another bridge is still using it or because the group host is
+ * holding on to it after the last bridge exited. This is only accessed from the
+ * main thread since that's where bridges are created and destroyed.
+ *
+ * NOTE: The plugin factory's host context will be the one set by the last
+ *       bridge that called `IPluginFactory3::setHostContext()`.
+ */
+std::unordered_map<std::string, std::weak_ptr<VST3::Hosting::Module>>
+    cached_vst3_modules;
+
+/**
+ * Get the key for a module in `cached_vst3_modules`. This resolves symlinks and
+ * relative components in the path, so the same module is always found under the
+ * same key.
+ */
+std::string vst3_module_cache_key(const std::string& module_path);
+
 Vst3PlugViewInterfaces::Vst3PlugViewInterfaces() noexcept {}
 
 Vst3PlugViewInterfaces::Vst3PlugViewInterfaces(
@@ -89,15 +112,38 @@ Vst3Bridge::Vst3Bridge(MainContext& main_context,
                        // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
                        std::string plugin_dll_path,
                        std::string endpoint_base_dir,
+                       bool abstract_sockets,
                        pid_t parent_pid)
     : HostBridge(main_context, plugin_dll_path, parent_pid),
       logger_(generic_logger_),
-      sockets_(main_context.context_, endpoint_base_dir, false) {
-    std::string error;
-    module_ = VST3::Hosting::Win32Module::create(plugin_dll_path, error);
-    if (!module_) {
-        throw std::runtime_error("Could not load the VST3 module for '" +
-                                 plugin_dll_path + "': " + error);
+      sockets_(main_context.context_,
+               endpoint_base_dir,
+               false,
+               abstract_sockets) {
+    // We can't know whether this plugin has enabled the `group_module_cache`
+    // option until we've received its configuration, but we can reuse a module
+    // that has been cached by another bridge
+    const std::string module_cache_key = vst3_module_cache_key(plugin_dll_path);
+    if (const auto cached_module = cached_vst3_modules.find(module_cache_key);
+        cached_module != cached_vst3_modules.end()) {
+        module_ = cached_module->second.lock();
+    }
+
+    if (module_) {
+        generic_logger_.log("Reusing the already loaded VST3 module for '" +
+                            plugin_dll_path + "'");
+    } else {
+        const auto load_start = std::chrono::steady_clock::now();
+        std::string error;
+        module_ = VST3::Hosting::Win32Module::create(plugin_dll_path, error);
+        if (!module_) {
+            throw std::runtime_error("Could not load the VST3 module for '" +
+                                     plugin_dll_path + "': " + error);
+        }
+
+        generic_logger_.log(
+            "Loaded the plugin library in " +
+            format_duration_ms(std::chrono::steady_clock::now() - load_start));
     }
 
     sockets_.connect();
@@ -105,10 +151,34 @@ Vst3Bridge::Vst3Bridge(MainContext& main_context,
     // Fetch this instance's configuration from the plugin to finish the setup
     // process
     config_ = sockets_.vst_host_callback_.send_message(
-        WantsConfiguration{.host_version = yabridge_git_version}, std::nullopt);
+        WantsConfiguration{.host_version = yabridge_git_version,
+                           .host_capabilities = Capabilities{}},
+        std::nullopt);
+
+    if (config_.group_module_cache) {
+        cached_vst3_modules[module_cache_key] = module_;
+    }
 
     // Allow this plugin to configure the main context's tick rate
-    main_context.update_timer_interval(config_.event_loop_interval());
+    main_context.update_timer_interval(config_.event_loop_interval(),
+                                       config_.event_loop_idle_backoff);
+
+    // Create the editor's window ahead of time so it's ready by the time the
+    // host opens the editor. See the docstring on this function.
+    if (config_.editor_precreate_window) {
+        main_context.schedule_task([]() { Editor::precreate_window(); });
+    }
+
+    if (config_.audio_buffer_idle_release_s) {
+        async_release_idle_audio_buffers(
+            std::chrono::seconds(*config_.audio_buffer_idle_release_s));
+    }
+    if (config_.memory_merging || config_.memory_huge_pages) {
+        async_advise_anonymous_memory(config_.memory_merging,
+                                      config_.memory_huge_pages);
+    }
+
+    watch_config_file(config_);
 }
 
 bool Vst3Bridge::inhibits_event_loop() noexcept {
@@ -123,6 +193,14 @@ bool Vst3Bridge::inhibits_event_loop() noexcept {
     return false;
 }
 
+std::shared_ptr<void> Vst3Bridge::retain_module() {
+    if (!config_.group_module_cache) {
+        return nullptr;
+    }
+
+    return module_;
+}
+
 void Vst3Bridge::run() {
     set_realtime_priority(true);
 
@@ -224,36 +302,19 @@ void Vst3Bridge::run() {
                 unregister_object_instance(request.instance_id);
                 return Ack{};
             },
+            [&](const Vst3PluginProxy::StartAudioProcessor& request)
+                -> Vst3PluginProxy::StartAudioProcessor::Response {
+                start_audio_processor(request.instance_id);
+                return Ack{};
+            },
             [&](Vst3PluginProxy::SetState& request)
                 -> Vst3PluginProxy::SetState::Response {
                 // We need to run `getState()` from the main thread, so we might
                 // as well do the same thing with `setState()`. See below.
                 // NOTE: We also try to handle mutual recursion here, in case
                 //       this happens during a resize
-                return do_mutual_recursion_on_gui_thread([&]() -> tresult {
-                    const auto& [instance, _] =
-                        get_instance(request.instance_id);
-
-                    // This same function is defined in both `IComponent` and
-                    // `IEditController`, so the host is calling one or the
-                    // other
-                    if (instance.interfaces.component) {
-                        return instance.interfaces.component->setState(
-                            &request.state);
-                    } else {
-                        return instance.interfaces.edit_controller->setState(
-                            &request.state);
-                    }
-                });
-            },
-            [&](Vst3PluginProxy::GetState& request)
-                -> Vst3PluginProxy::GetState::Response {
-                // NOTE: The VST3 version of Algonaut Atlas doesn't restore
-                //       state unless this function is run from the GUI thread
-                // NOTE: This also requires mutual recursion because REAPER will
-                //       call `getState()` while opening a popup menu
-                const tresult result =
-                    do_mutual_recursion_on_gui_thread([&]() -> tresult {
+                return do_request_on_gui_thread<Vst3PluginProxy::SetState>(
+                    [&]() -> tresult {
                         const auto& [instance, _] =
                             get_instance(request.instance_id);
 
@@ -261,13 +322,43 @@ void Vst3Bridge::run() {
                         // and `IEditController`, so the host is calling one or
                         // the other
                         if (instance.interfaces.component) {
-                            return instance.interfaces.component->getState(
+                            return instance.interfaces.component->setState(
                                 &request.state);
                         } else {
                             return instance.interfaces.edit_controller
-                                ->getState(&request.state);
+                                ->setState(&request.state);
                         }
                     });
+            },
+            [&](Vst3PluginProxy::GetState& request)
+                -> Vst3PluginProxy::GetState::Response {
+                // NOTE: The VST3 version of Algonaut Atlas doesn't restore
+                //       state unless this function is run from the GUI thread
+                // NOTE: This also requires mutual recursion because REAPER will
+                //       call `getState()` while opening a popup menu
+                const auto get_state = [&]() -> tresult {
+                    const auto& [instance, _] =
+                        get_instance(request.instance_id);
+
+                    // This same function is defined in both `IComponent` and
+                    // `IEditController`, so the host is calling one or the
+                    // other
+                    if (instance.interfaces.component) {
+                        return instance.interfaces.component->getState(
+                            &request.state);
+                    } else {
+                        return instance.interfaces.edit_controller->getState(
+                            &request.state);
+                    }
+                };
+
+                // Plugins that can save their state from any thread don't need
+                // to block the GUI thread while doing so
+                const tresult result =
+                    config_.vst3_get_state_off_gui_thread
+                        ? get_state()
+                        : do_request_on_gui_thread<Vst3PluginProxy::GetState>(
+                              get_state);
 
                 return Vst3PluginProxy::GetStateResponse{
                     .result = result, .state = std::move(request.state)};
@@ -371,13 +462,31 @@ void Vst3Bridge::run() {
                 //       much slower in Ardour, but there's no other non-hacky
                 //       solution for this (and bypassing Ardour's connection
                 //       proxies sort of goes against the idea behind yabridge)
-                return do_mutual_recursion_on_gui_thread([&]() -> tresult {
-                    const auto& [this_instance, _] =
-                        get_instance(request.instance_id);
+                const tresult result =
+                    do_request_on_gui_thread<YaConnectionPoint::Notify>(
+                        [&]() -> tresult {
+                            const auto& [this_instance, _] =
+                                get_instance(request.instance_id);
 
-                    return this_instance.interfaces.connection_point->notify(
-                        request.message_ptr.get_original());
-                });
+                            return this_instance.interfaces.connection_point
+                                ->notify(request.message_ptr.get_original());
+                        });
+
+                // The message made it from one of our objects, through the
+                // host's connection proxy, to another one of our objects. The
+                // next message from the sender can skip the host and go to this
+                // object directly, see `Vst3ConnectionPointProxyImpl::notify()`.
+                {
+                    const auto& [sender_instance, _] = get_instance(
+                        request.message_ptr.sender_instance_id());
+                    if (sender_instance.connection_point_proxy) {
+                        static_cast<Vst3ConnectionPointProxyImpl*>(
+                            sender_instance.connection_point_proxy.get())
+                            ->set_peer_instance_id(request.instance_id);
+                    }
+                }
+
+                return result;
             },
             [&](YaContextMenuTarget::ExecuteMenuItem& request)
                 -> YaContextMenuTarget::ExecuteMenuItem::Response {
@@ -418,6 +527,29 @@ void Vst3Bridge::run() {
                 return YaEditController::GetParameterInfoResponse{
                     .result = result, .info = std::move(info)};
             },
+            [&](const YaEditController::GetAllParameterInfos& request)
+                -> YaEditController::GetAllParameterInfos::Response {
+                const auto& [instance, _] = get_instance(request.instance_id);
+
+                const int32 num_parameters =
+                    instance.interfaces.edit_controller->getParameterCount();
+
+                YaEditController::GetAllParameterInfosResponse response{};
+                response.infos.reserve(std::max(num_parameters, 0));
+                for (int32 param_index = 0; param_index < num_parameters;
+                     param_index++) {
+                    Steinberg::Vst::ParameterInfo info{};
+                    const tresult result =
+                        instance.interfaces.edit_controller->getParameterInfo(
+                            param_index, info);
+
+                    response.infos.push_back(
+                        YaEditController::GetParameterInfoResponse{
+                            .result = result, .info = std::move(info)});
+                }
+
+                return response;
+            },
             [&](const YaEditController::GetParamStringByValue& request)
                 -> YaEditController::GetParamStringByValue::Response {
                 Steinberg::Vst::String128 string{0};
@@ -468,6 +600,32 @@ void Vst3Bridge::run() {
                 return instance.interfaces.edit_controller->getParamNormalized(
                     request.id);
             },
+            [&](const YaEditController::GetAllParamNormalized& request)
+                -> YaEditController::GetAllParamNormalized::Response {
+                const auto& [instance, _] = get_instance(request.instance_id);
+
+                const int32 num_parameters =
+                    instance.interfaces.edit_controller->getParameterCount();
+
+                YaEditController::GetAllParamNormalizedResponse response{};
+                response.values.reserve(std::max(num_parameters, 0));
+                for (int32 param_index = 0; param_index < num_parameters;
+                     param_index++) {
+                    Steinberg::Vst::ParameterInfo info{};
+                    if (instance.interfaces.edit_controller->getParameterInfo(
+                            param_index, info) == Steinberg::kResultOk) {
+                        response.values.push_back(
+                            YaEditController::GetAllParamNormalizedResponse::
+                                Value{.id = info.id,
+                                      .value = instance.interfaces
+                                                   .edit_controller
+                                                   ->getParamNormalized(
+                                                       info.id)});
+                    }
+                }
+
+                return response;
+            },
             [&](const YaEditController::SetParamNormalized& request)
                 -> YaEditController::SetParamNormalized::Response {
                 // HACK: Under Ardour/Mixbus, `IComponentHandler::performEdit()`
@@ -524,6 +682,21 @@ void Vst3Bridge::run() {
                                     instance.plug_view_instance.emplace(
                                         plug_view);
 
+                                    // Reapply the previously negotiated scale
+                                    // factor, if there is one. See the
+                                    // docstring on this field.
+                                    auto& view = *instance.plug_view_instance;
+                                    const auto& factor =
+                                        instance.last_content_scale_factor;
+                                    if (factor &&
+                                        view.plug_view_content_scale_support &&
+                                        view.plug_view_content_scale_support
+                                                ->setContentScaleFactor(
+                                                    *factor) ==
+                                            Steinberg::kResultOk) {
+                                        view.content_scale_factor = factor;
+                                    }
+
                                     // We'll create a proxy so the host can call
                                     // functions on this `IPlugView` object
                                     return std::make_optional<
@@ -581,15 +754,14 @@ void Vst3Bridge::run() {
                 // Melodyne wants to immediately update the GUI upon receiving
                 // certain channel context data, so this has to be run from the
                 // main thread
-                return main_context_
-                    .run_in_context([&]() -> tresult {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                return do_request_on_gui_thread<
+                    YaInfoListener::SetChannelContextInfos>([&]() -> tresult {
+                    const auto& [instance, _] =
+                        get_instance(request.instance_id);
 
-                        return instance.interfaces.info_listener
-                            ->setChannelContextInfos(&request.list);
-                    })
-                    .get();
+                    return instance.interfaces.info_listener
+                        ->setChannelContextInfos(&request.list);
+                });
             },
             [&](const YaKeyswitchController::GetKeyswitchCount& request)
                 -> YaKeyswitchController::GetKeyswitchCount::Response {
@@ -611,6 +783,32 @@ void Vst3Bridge::run() {
                 return YaKeyswitchController::GetKeyswitchInfoResponse{
                     .result = result, .info = std::move(info)};
             },
+            [&](const YaKeyswitchController::GetAllKeyswitchInfos& request)
+                -> YaKeyswitchController::GetAllKeyswitchInfos::Response {
+                const auto& [instance, _] = get_instance(request.instance_id);
+                Steinberg::Vst::IKeyswitchController& keyswitch_controller =
+                    *instance.interfaces.keyswitch_controller;
+
+                YaKeyswitchController::GetAllKeyswitchInfosResponse response{
+                    .count = keyswitch_controller.getKeyswitchCount(
+                        request.bus_index, request.channel),
+                    .infos = {}};
+                response.infos.reserve(std::max(response.count, 0));
+                for (int32 key_switch_index = 0;
+                     key_switch_index < response.count; key_switch_index++) {
+                    Steinberg::Vst::KeyswitchInfo info{};
+                    const tresult result =
+                        keyswitch_controller.getKeyswitchInfo(
+                            request.bus_index, request.channel,
+                            key_switch_index, info);
+
+                    response.infos.push_back(
+                        YaKeyswitchController::GetKeyswitchInfoResponse{
+                            .result = result, .info = std::move(info)});
+                }
+
+                return response;
+            },
             [&](const YaMidiLearn::OnLiveMIDIControllerInput& request)
                 -> YaMidiLearn::OnLiveMIDIControllerInput::Response {
                 const auto& [instance, _] = get_instance(request.instance_id);
@@ -633,6 +831,35 @@ void Vst3Bridge::run() {
                 return YaMidiMapping::GetMidiControllerAssignmentResponse{
                     .result = result, .id = id};
             },
+            [&](const YaMidiMapping::GetAllMidiControllerAssignments& request)
+                -> YaMidiMapping::GetAllMidiControllerAssignments::Response {
+                const auto& [instance, _] = get_instance(request.instance_id);
+
+                YaMidiMapping::GetAllMidiControllerAssignmentsResponse
+                    response{};
+                response.assignments.reserve(YaMidiMapping::num_midi_channels *
+                                             Steinberg::Vst::kCountCtrlNumber);
+                for (int16 channel = 0;
+                     channel < YaMidiMapping::num_midi_channels; channel++) {
+                    for (Steinberg::Vst::CtrlNumber midi_controller_number = 0;
+                         midi_controller_number <
+                         Steinberg::Vst::kCountCtrlNumber;
+                         midi_controller_number++) {
+                        Steinberg::Vst::ParamID id = 0;
+                        const tresult result =
+                            instance.interfaces.midi_mapping
+                                ->getMidiControllerAssignment(
+                                    request.bus_index, channel,
+                                    midi_controller_number, id);
+
+                        response.assignments.push_back(
+                            YaMidiMapping::GetMidiControllerAssignmentResponse{
+                                .result = result, .id = id});
+                    }
+                }
+
+                return response;
+            },
             [&](const YaNoteExpressionController::GetNoteExpressionCount&
                     request)
                 -> YaNoteExpressionController::GetNoteExpressionCount::
@@ -660,6 +887,43 @@ void Vst3Bridge::run() {
                     GetNoteExpressionInfoResponse{.result = result,
                                                   .info = std::move(info)};
             },
+            [&](const YaNoteExpressionController::GetAllNoteExpressionInfos&
+                    request)
+                -> YaNoteExpressionController::GetAllNoteExpressionInfos::
+                    Response {
+                        const auto& [instance, _] =
+                            get_instance(request.instance_id);
+                        Steinberg::Vst::INoteExpressionController&
+                            note_expression_controller =
+                                *instance.interfaces.note_expression_controller;
+
+                        YaNoteExpressionController::
+                            GetAllNoteExpressionInfosResponse response{
+                                .count = note_expression_controller
+                                             .getNoteExpressionCount(
+                                                 request.bus_index,
+                                                 request.channel),
+                                .infos = {}};
+                        response.infos.reserve(std::max(response.count, 0));
+                        for (int32 note_expression_index = 0;
+                             note_expression_index < response.count;
+                             note_expression_index++) {
+                            Steinberg::Vst::NoteExpressionTypeInfo info{};
+                            const tresult result =
+                                note_expression_controller
+                                    .getNoteExpressionInfo(
+                                        request.bus_index, request.channel,
+                                        note_expression_index, info);
+
+                            response.infos.push_back(
+                                YaNoteExpressionController::
+                                    GetNoteExpressionInfoResponse{
+                                        .result = result,
+                                        .info = std::move(info)});
+                        }
+
+                        return response;
+                    },
             [&](const YaNoteExpressionController::
                     GetNoteExpressionStringByValue& request)
                 -> YaNoteExpressionController::GetNoteExpressionStringByValue::
@@ -1010,10 +1274,42 @@ void Vst3Bridge::run() {
                                 .run_in_context([&]() -> tresult {
                                     const auto& [instance, _] =
                                         get_instance(request.owner_instance_id);
-
-                                    return instance.plug_view_instance
-                                        ->plug_view_content_scale_support
-                                        ->setContentScaleFactor(request.factor);
+                                    auto& view = *instance.plug_view_instance;
+                                    if (view.content_scale_factor ==
+                                        request.factor) {
+                                        return Steinberg::kResultOk;
+                                    }
+
+                                    const tresult result =
+                                        view.plug_view_content_scale_support
+                                            ->setContentScaleFactor(
+                                                request.factor);
+                                    if (result != Steinberg::kResultOk) {
+                                        return result;
+                                    }
+
+                                    view.content_scale_factor = request.factor;
+                                    instance.last_content_scale_factor =
+                                        request.factor;
+
+                                    // Instead of waiting for the host to
+                                    // reopen or resize the editor, we'll
+                                    // resize the Wine window to match the
+                                    // plugin's new size right away
+                                    if (instance.editor) {
+                                        std::lock_guard lock(
+                                            instance.get_size_mutex);
+
+                                        Steinberg::ViewRect size{};
+                                        if (view.plug_view->getSize(&size) ==
+                                            Steinberg::kResultOk) {
+                                            instance.editor->resize(
+                                                size.getWidth(),
+                                                size.getHeight());
+                                        }
+                                    }
+
+                                    return result;
                                 })
                                 .get();
                         }
@@ -1067,9 +1363,20 @@ void Vst3Bridge::run() {
                         // initialized states from misbehaving
                         instance.is_initialized = true;
 
+                        // Hosts will immediately ask for all of this after
+                        // initializing the object, so we can save a lot of
+                        // round trips by sending it along with the response
+                        std::optional<Vst3PluginProxy::InstanceSummary>
+                            summary;
+                        if (config_.vst3_prefetch_instance_info &&
+                            result == Steinberg::kResultOk) {
+                            summary = summarize_instance(instance);
+                        }
+
                         return Vst3PluginProxy::InitializeResponse{
                             .result = result,
-                            .updated_plugin_interfaces = updated_interfaces};
+                            .updated_plugin_interfaces = updated_interfaces,
+                            .summary = std::move(summary)};
                     })
                     .get();
             },
@@ -1239,6 +1546,76 @@ void Vst3Bridge::run() {
                     .attribute_value =
                         tchar_pointer_to_u16string(attribute_value)};
             },
+            [&](const YaUnitInfo::GetAllUnitsAndProgramLists& request)
+                -> YaUnitInfo::GetAllUnitsAndProgramLists::Response {
+                // NOTE: Just like `GetProgramName`, this will likely be
+                //       requested in response to
+                //       `IUnitHandler::notifyProgramListChange` since that
+                //       invalidates the cache on the native side
+                return do_mutual_recursion_on_off_thread(
+                    [&]() -> YaUnitInfo::GetAllUnitsAndProgramListsResponse {
+                        const auto& [instance, _] =
+                            get_instance(request.instance_id);
+                        Steinberg::Vst::IUnitInfo& unit_info =
+                            *instance.interfaces.unit_info;
+
+                        YaUnitInfo::GetAllUnitsAndProgramListsResponse
+                            response{};
+
+                        const int32 num_units = unit_info.getUnitCount();
+                        response.units.reserve(std::max(num_units, 0));
+                        for (int32 unit_index = 0; unit_index < num_units;
+                             unit_index++) {
+                            Steinberg::Vst::UnitInfo info{};
+                            const tresult result =
+                                unit_info.getUnitInfo(unit_index, info);
+
+                            response.units.push_back(
+                                YaUnitInfo::GetUnitInfoResponse{
+                                    .result = result, .info = info});
+                        }
+
+                        const int32 num_lists = unit_info.getProgramListCount();
+                        response.program_lists.reserve(std::max(num_lists, 0));
+                        for (int32 list_index = 0; list_index < num_lists;
+                             list_index++) {
+                            YaUnitInfo::ProgramListDescription description{};
+                            description.list_info.result =
+                                unit_info.getProgramListInfo(
+                                    list_index, description.list_info.info);
+
+                            // The names can only be fetched using the list's
+                            // ID, so we'll skip lists the plugin could not
+                            // describe
+                            const Steinberg::Vst::ProgramListInfo& list_info =
+                                description.list_info.info;
+                            if (description.list_info.result ==
+                                Steinberg::kResultOk) {
+                                description.program_names.reserve(
+                                    std::max(list_info.programCount, 0));
+                                for (int32 program_index = 0;
+                                     program_index < list_info.programCount;
+                                     program_index++) {
+                                    Steinberg::Vst::String128 name{0};
+                                    const tresult result =
+                                        unit_info.getProgramName(
+                                            list_info.id, program_index, name);
+
+                                    description.program_names.push_back(
+                                        YaUnitInfo::GetProgramNameResponse{
+                                            .result = result,
+                                            .name = tchar_pointer_to_u16string(
+                                                name)});
+                                }
+                            }
+
+                            response.program_lists.push_back(
+                                std::move(description));
+                        }
+
+                        return response;
+                    });
+            },
             [&](const YaUnitInfo::HasProgramPitchNames& request)
                 -> YaUnitInfo::HasProgramPitchNames::Response {
                 const auto& [instance, _] = get_instance(request.instance_id);
@@ -1349,10 +1726,37 @@ void Vst3Bridge::close_sockets() {
     sockets_.close();
 }
 
+void Vst3Bridge::release_idle_audio_buffers(
+    std::chrono::steady_clock::duration timeout) {
+    std::shared_lock lock(object_instances_mutex_);
+
+    // Like for VST2 plugins, instances with an open editor are left alone
+    for (auto& [instance_id, instance] : object_instances_) {
+        if (!instance.editor) {
+            instance.idle_buffer_release.release_if_idle(
+                instance.process_buffers, timeout);
+        }
+    }
+}
+
 size_t Vst3Bridge::generate_instance_id() noexcept {
     return current_instance_id_.fetch_add(1);
 }
 
+std::optional<tresult> Vst3Bridge::notify_instance_directly(
+    size_t instance_id,
+    Steinberg::Vst::IMessage* message) {
+    std::shared_lock lock(object_instances_mutex_);
+
+    const auto instance = object_instances_.find(instance_id);
+    if (instance == object_instances_.end() ||
+        !instance->second.interfaces.connection_point) {
+        return std::nullopt;
+    }
+
+    return instance->second.interfaces.connection_point->notify(message);
+}
+
 std::pair<Vst3PluginInstance&, std::shared_lock<std::shared_mutex>>
 Vst3Bridge::get_instance(size_t instance_id) noexcept {
     std::shared_lock lock(object_instances_mutex_);
@@ -1362,9 +1766,8 @@ Vst3Bridge::get_instance(size_t instance_id) noexcept {
 }
 
 std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
-    size_t instance_id) {
-    const auto& [instance, _] = get_instance(instance_id);
-
+    size_t instance_id,
+    Vst3PluginInstance& instance) {
     const Steinberg::IPtr<Steinberg::Vst::IComponent> component =
         instance.interfaces.component;
     const Steinberg::IPtr<Steinberg::Vst::IAudioProcessor> audio_processor =
@@ -1377,11 +1780,39 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
     // We'll query the plugin for its audio bus layouts, and then create
     // calculate the offsets in a large memory buffer for the different audio
     // channels. The offsets for each audio channel are in samples (since
-    // they'll be used with pointer arithmetic in `AudioShmBuffer`).
+    // they'll be used with pointer arithmetic in `AudioShmBuffer`). Every
+    // channel is aligned to a cache line, and this depends on whether the host
+    // is going to pass 32-bit or 64-bit audio to the plugin.
+    const bool double_precision =
+        instance.process_setup->symbolicSampleSize == Steinberg::Vst::kSample64;
+    const size_t sample_size =
+        double_precision ? sizeof(double) : sizeof(float);
+    const uint32_t channel_samples = AudioShmBuffer::aligned_channel_samples(
+        instance.process_setup->maxSamplesPerBlock, sample_size);
     uint32_t current_offset = 0;
 
-    auto create_bus_offsets = [&, &setup = instance.process_setup](
-                                  Steinberg::Vst::BusDirection direction) {
+    // Main busses are always laid out since some hosts never explicitly
+    // activate those. Auxiliary busses only get space in the buffers when
+    // they're active, either because the host activated them or because the
+    // plugin marked them as active by default.
+    auto is_bus_laid_out = [&](Steinberg::Vst::BusDirection direction,
+                               int32 bus) {
+        Steinberg::Vst::BusInfo info{};
+        if (component->getBusInfo(Steinberg::Vst::kAudio, direction, bus,
+                                  info) != Steinberg::kResultOk ||
+            info.busType == Steinberg::Vst::kMain) {
+            return true;
+        }
+
+        if (const auto state = instance.audio_bus_states.find({direction, bus});
+            state != instance.audio_bus_states.end()) {
+            return state->second;
+        } else {
+            return (info.flags & Steinberg::Vst::BusInfo::kDefaultActive) != 0;
+        }
+    };
+
+    auto create_bus_offsets = [&](Steinberg::Vst::BusDirection direction) {
         const auto num_busses =
             component->getBusCount(Steinberg::Vst::kAudio, direction);
 
@@ -1392,6 +1823,13 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
         llvm::SmallVector<llvm::SmallVector<uint32_t, 32>, 16> bus_offsets(
             num_busses);
         for (int bus = 0; bus < num_busses; bus++) {
+            // Inactive auxiliary busses don't get any space in the buffers.
+            // Their channel count will then be capped to zero in
+            // `YaProcessData::repopulate()`.
+            if (!is_bus_laid_out(direction, bus)) {
+                continue;
+            }
+
             Steinberg::Vst::SpeakerArrangement speaker_arrangement{};
             audio_processor->getBusArrangement(direction, bus,
                                                speaker_arrangement);
@@ -1404,7 +1842,7 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
 
             for (size_t channel = 0; channel < num_channels; channel++) {
                 bus_offsets[bus][channel] = current_offset;
-                current_offset += setup->maxSamplesPerBlock;
+                current_offset += channel_samples;
             }
         }
 
@@ -1413,21 +1851,45 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
 
     // Creating the audio buffer offsets for every channel in every bus will
     // advacne `current_offset` to keep pointing to the starting position for
-    // the next channel
+    // the next channel. The inputs and outputs are separated by some padding to
+    // avoid false sharing between the two processes.
     const auto input_bus_offsets = create_bus_offsets(Steinberg::Vst::kInput);
+    const uint32_t padded_output_offset =
+        current_offset > 0
+            ? current_offset +
+                  AudioShmBuffer::region_padding_samples(sample_size)
+            : 0;
+    const uint32_t input_end_offset = current_offset;
+    current_offset = padded_output_offset;
     const auto output_bus_offsets = create_bus_offsets(Steinberg::Vst::kOutput);
+    if (current_offset == padded_output_offset) {
+        // There are no output channels, so the padding is not needed
+        current_offset = input_end_offset;
+    }
 
-    // The size of the buffer is in bytes, and it will depend on whether the
-    // host is going to pass 32-bit or 64-bit audio to the plugin
-    const bool double_precision =
-        instance.process_setup->symbolicSampleSize == Steinberg::Vst::kSample64;
-    const uint32_t buffer_size =
-        current_offset * (double_precision ? sizeof(double) : sizeof(float));
-
-    // If this function has been called previously and the size did not change,
-    // then we should not do any work
+    // The size of the buffer is in bytes
+    const uint32_t buffer_size = current_offset * sample_size;
+
+    // If this function has been called previously and the layout did not
+    // change, then we should not do any work. Since inactive busses are not
+    // laid out, activating a different bus of the same size would result in
+    // the same buffer size but with different offsets.
+    const auto same_offsets = [](const auto& new_offsets,
+                                 const std::vector<std::vector<uint32_t>>&
+                                     old_offsets) {
+        return std::equal(
+            new_offsets.begin(), new_offsets.end(), old_offsets.begin(),
+            old_offsets.end(), [](const auto& lhs, const auto& rhs) {
+                return std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                                  rhs.end());
+            });
+    };
     if (instance.process_buffers &&
-        instance.process_buffers->config_.size == buffer_size) {
+        instance.process_buffers->config_.size == buffer_size &&
+        same_offsets(input_bus_offsets,
+                     instance.process_buffers->config_.input_offsets) &&
+        same_offsets(output_bus_offsets,
+                     instance.process_buffers->config_.output_offsets)) {
         return std::nullopt;
     }
 
@@ -1454,13 +1916,24 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
         .name = sockets_.base_dir_.filename().string() + "-" +
                 std::to_string(instance_id),
         .size = buffer_size,
+        .capacity = static_cast<uint32_t>(
+            buffer_size * config_.audio_buffer_headroom.value_or(1.0f)),
         .input_offsets = std::move(input_bus_offsets_vector),
-        .output_offsets = std::move(output_bus_offsets_vector)};
+        .output_offsets = std::move(output_bus_offsets_vector),
+        .metadata_capacity = vst3_process_metadata_capacity,
+        .pinned = config_.pin_audio_buffers,
+        .reclaimable = config_.audio_buffer_reclaim};
+    std::unique_lock<std::mutex> idle_buffer_lock;
+    if (config_.audio_buffer_idle_release_s) {
+        idle_buffer_lock = instance.idle_buffer_release.begin_processing(
+            instance.process_buffers);
+    }
     if (!instance.process_buffers) {
         instance.process_buffers.emplace(buffer_config);
     } else {
         instance.process_buffers->resize(buffer_config);
     }
+    track_audio_buffer(instance_id, instance.process_buffers->config_);
 
     // After setting up the shared memory buffer, we need to create a vector of
     // channel audio pointers for every bus. These will then be assigned to the
@@ -1510,7 +1983,69 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
             }
         });
 
-    return buffer_config;
+    // The buffer may have reserved more capacity than what we asked for, so the
+    // native plugin should use the buffer's actual configuration
+    return instance.process_buffers->config_;
+}
+
+Vst3PluginProxy::InstanceSummary Vst3Bridge::summarize_instance(
+    Vst3PluginInstance& instance) {
+    Vst3PluginProxy::InstanceSummary summary{};
+
+    if (instance.interfaces.component) {
+        for (const Steinberg::Vst::MediaType type :
+             {Steinberg::Vst::kAudio, Steinberg::Vst::kEvent}) {
+            for (const Steinberg::Vst::BusDirection dir :
+                 {Steinberg::Vst::kInput, Steinberg::Vst::kOutput}) {
+                const int32 num_busses =
+                    instance.interfaces.component->getBusCount(type, dir);
+                summary.bus_counts.push_back(
+                    Vst3PluginProxy::InstanceSummary::BusCount{
+                        .type = type, .dir = dir, .count = num_busses});
+
+                for (int32 index = 0; index < num_busses; index++) {
+                    Steinberg::Vst::BusInfo info{};
+                    if (instance.interfaces.component->getBusInfo(
+                            type, dir, index, info) == Steinberg::kResultOk) {
+                        summary.bus_infos.push_back(
+                            Vst3PluginProxy::InstanceSummary::BusInfo{
+                                .type = type,
+                                .dir = dir,
+                                .index = index,
+                                .info = info});
+                    }
+                }
+            }
+        }
+    }
+
+    if (instance.interfaces.edit_controller) {
+        const int32 num_parameters =
+            instance.interfaces.edit_controller->getParameterCount();
+
+        YaEditController::GetAllParameterInfosResponse& parameter_infos =
+            summary.parameter_infos.emplace();
+        parameter_infos.infos.reserve(std::max(num_parameters, 0));
+        for (int32 param_index = 0; param_index < num_parameters;
+             param_index++) {
+            Steinberg::Vst::ParameterInfo info{};
+            const tresult result =
+                instance.interfaces.edit_controller->getParameterInfo(
+                    param_index, info);
+
+            parameter_infos.infos.push_back(
+                YaEditController::GetParameterInfoResponse{
+                    .result = result, .info = std::move(info)});
+        }
+    }
+
+    if (instance.interfaces.process_context_requirements) {
+        summary.process_context_requirements =
+            instance.interfaces.process_context_requirements
+                ->getProcessContextRequirements();
+    }
+
+    return summary;
 }
 
 size_t Vst3Bridge::register_object_instance(
@@ -1519,17 +2054,36 @@ size_t Vst3Bridge::register_object_instance(
 
     const size_t instance_id = generate_instance_id();
     object_instances_.emplace(instance_id, std::move(object));
+    lock.unlock();
+
+    // With `vst3_lazy_audio_threads` the native plugin will request the audio
+    // thread using `Vst3PluginProxy::StartAudioProcessor` right before it
+    // sends the first `IAudioProcessor` or `IComponent` call instead
+    if (!config_.vst3_lazy_audio_threads) {
+        start_audio_processor(instance_id);
+    }
+
+    return instance_id;
+}
+
+void Vst3Bridge::start_audio_processor(size_t instance_id) {
+    // This thread belongs to the instance, and `unregister_object_instance()`
+    // joins it before the instance gets removed. The thread can thus access
+    // the instance through this reference without ever locking
+    // `object_instances_mutex_`, so it won't get blocked while other instances
+    // are being created or destroyed.
+    Vst3PluginInstance& this_instance = get_instance(instance_id).first;
 
     // If the object supports `IComponent` or `IAudioProcessor`,
     // then we'll set up a dedicated thread for function calls for
     // those interfaces.
-    if (object_instances_.at(instance_id).interfaces.audio_processor ||
-        object_instances_.at(instance_id).interfaces.component) {
+    if (this_instance.interfaces.audio_processor ||
+        this_instance.interfaces.component) {
         std::promise<void> socket_listening_latch;
 
-        object_instances_.at(instance_id)
-            .audio_processor_handler = Win32Thread([&, instance_id]() {
+        this_instance.audio_processor_handler = Win32Thread([&, instance_id]() {
             set_realtime_priority(true);
+            set_audio_thread_affinity(config_.audio_thread_cpus);
 
             // XXX: Like with VST2 worker threads, when using plugin groups the
             //      thread names from different plugins will clash. Not a huge
@@ -1544,8 +2098,7 @@ size_t Vst3Bridge::register_object_instance(
                 overload{
                     [&](YaAudioProcessor::SetBusArrangements& request)
                         -> YaAudioProcessor::SetBusArrangements::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         // HACK: WA Production Imperfect VST3 somehow requires
                         //       `inputs` to be a valid pointer, even if there
@@ -1564,8 +2117,7 @@ size_t Vst3Bridge::register_object_instance(
                     },
                     [&](YaAudioProcessor::GetBusArrangement& request)
                         -> YaAudioProcessor::GetBusArrangement::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         Steinberg::Vst::SpeakerArrangement arr{};
                         const tresult result =
@@ -1578,25 +2130,22 @@ size_t Vst3Bridge::register_object_instance(
                     },
                     [&](const YaAudioProcessor::CanProcessSampleSize& request)
                         -> YaAudioProcessor::CanProcessSampleSize::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         return instance.interfaces.audio_processor
                             ->canProcessSampleSize(
                                 request.symbolic_sample_size);
                     },
-                    [&](const YaAudioProcessor::GetLatencySamples& request)
+                    [&](const YaAudioProcessor::GetLatencySamples&)
                         -> YaAudioProcessor::GetLatencySamples::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         return instance.interfaces.audio_processor
                             ->getLatencySamples();
                     },
                     [&](YaAudioProcessor::SetupProcessing& request)
                         -> YaAudioProcessor::SetupProcessing::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         // We'll set up the shared audio buffers on the Wine
                         // side after the plugin has finished doing their setup.
@@ -1605,13 +2154,41 @@ size_t Vst3Bridge::register_object_instance(
                         // buffers.
                         instance.process_setup = request.setup;
 
+                        // This function is called on the audio thread, so we
+                        // can switch the thread to `SCHED_DEADLINE` right here
+                        // now that we know how long a block is
+                        if (config_.audio_thread_sched_deadline) {
+                            instance.audio_thread_scheduling
+                                .set_deadline_period(audio_block_period_ns(
+                                    request.setup.maxSamplesPerBlock,
+                                    request.setup.sampleRate));
+                        }
+                        // The process mode can only change here, so this is
+                        // also where we'll drop the realtime scheduling when
+                        // the host starts rendering offline
+                        if (config_.offline_render_non_realtime) {
+                            instance.audio_thread_scheduling.set_offline(
+                                request.setup.processMode ==
+                                Steinberg::Vst::kOffline);
+                        }
+
+                        // The output parameter changes and events will be
+                        // preallocated based on this during the next
+                        // processing cycle
+                        instance.num_output_parameters =
+                            instance.interfaces.edit_controller
+                                ? static_cast<size_t>(std::max(
+                                      instance.interfaces.edit_controller
+                                          ->getParameterCount(),
+                                      0))
+                                : 0;
+
                         return instance.interfaces.audio_processor
                             ->setupProcessing(request.setup);
                     },
                     [&](const YaAudioProcessor::SetProcessing& request)
                         -> YaAudioProcessor::SetProcessing::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
                         // HACK: MeldaProduction plugins for some reason cannot
                         //       handle it if this function is called from the
                         //       audio thread while at the same time
@@ -1633,17 +2210,55 @@ size_t Vst3Bridge::register_object_instance(
                         //       done during the deserialization in
                         //       `bitsery::ext::MessageReference`)
                         YaAudioProcessor::Process& request = request_ref.get();
+                        const auto received_time =
+                            std::chrono::steady_clock::now();
+
+                        assert(request.instance_id == instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         // As suggested by Jack Winter, we'll synchronize this
                         // thread's audio processing priority with that of the
-                        // host's audio thread every once in a while
+                        // host's audio thread whenever it changes
                         if (request.new_realtime_priority) {
-                            set_realtime_priority(
-                                true, *request.new_realtime_priority);
+                            instance.audio_thread_scheduling
+                                .set_realtime_priority(
+                                    *request.new_realtime_priority);
+                        }
+                        if (request.host_audio_thread_cpu) {
+                            set_audio_thread_affinity(
+                                config_.audio_thread_cpus,
+                                *request.host_audio_thread_cpu);
+                        }
+                        if (request.host_audio_thread_numa_node) {
+                            follow_numa_node(
+                                config_, *request.host_audio_thread_numa_node,
+                                instance.process_buffers);
+                        }
+
+                        if (request.host_thread_id) {
+                            HostAudioThreadMap::get().pin_for_host_thread(
+                                *request.host_thread_id,
+                                instance.last_host_thread_id,
+                                config_.audio_thread_cpus);
+                        }
+
+                        std::unique_lock<std::mutex> idle_buffer_lock;
+                        if (config_.audio_buffer_idle_release_s) {
+                            idle_buffer_lock =
+                                instance.idle_buffer_release.begin_processing(
+                                    instance.process_buffers);
+                        }
+
+                        // If the process data fit in the shared memory object,
+                        // then the native plugin will have written it there
+                        // instead of sending it over the socket
+                        if (request.data_in_shm) {
+                            read_shm_object(
+                                *instance.process_buffers,
+                                AudioShmBuffer::MetadataRegion::request,
+                                request.data);
                         }
 
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
                         // Most plugins will already enable FTZ, but there are a
                         // handful of plugins that don't that suffer from
                         // extreme DSP load increases when they start producing
@@ -1656,12 +2271,31 @@ size_t Vst3Bridge::register_object_instance(
                         // HACK: IK-Multimedia's T-RackS 5 will hang if audio
                         //       processing is done from the audio thread while
                         //       the plugin is in offline processing mode. Yes
-                        //       that's as silly as it sounds.
+                        //       that's as silly as it sounds. This can be
+                        //       disabled for other plugins with the
+                        //       `vst3_fast_offline_processing` option since
+                        //       it slows down offline rendering.
                         tresult result;
-                        auto& reconstructed = request.data.reconstruct(
-                            instance.process_buffers_input_pointers,
-                            instance.process_buffers_output_pointers);
-                        if (instance.process_setup &&
+                        request.data.reserve_outputs(
+                            instance.num_output_parameters);
+                        // Neither rebuilding the process data nor building
+                        // the response should allocate once the buffers have
+                        // grown to fit, but the plugin's `process()` call is
+                        // of course not covered by this
+                        auto& reconstructed = [&]() -> auto& {
+                            ScopedRealtimeSection realtime_section{};
+                            return request.data.reconstruct(
+                                instance.process_buffers_input_pointers,
+                                instance.process_buffers_output_pointers,
+                                instance.process_context_base);
+                        }();
+                        ProcessCallbackTimer callback_timer{};
+                        YABRIDGE_PROBE(plugin_process_begin,
+                                       reconstructed.numSamples);
+                        const auto process_start =
+                            std::chrono::steady_clock::now();
+                        if (!config_.vst3_fast_offline_processing &&
+                            instance.process_setup &&
                             instance.process_setup->processMode ==
                                 Steinberg::Vst::kOffline) {
                             result = main_context_
@@ -1677,23 +2311,54 @@ size_t Vst3Bridge::register_object_instance(
                                 instance.interfaces.audio_processor->process(
                                     reconstructed);
                         }
+                        const auto process_end =
+                            std::chrono::steady_clock::now();
+                        YABRIDGE_PROBE(plugin_process_end,
+                                       reconstructed.numSamples);
+                        instance.process_buffers->record_plugin_time(
+                            process_end - process_start,
+                            callback_timer.elapsed());
+                        if (config_.audio_deadline_warning) {
+                            instance.process_buffers->record_block_timings(
+                                received_time, process_start, process_end,
+                                callback_timer.elapsed(),
+                                is_realtime_scheduled());
+                        }
+                        if (request.data.outputs_exceeded_capacity()) {
+                            instance.output_capacity_overflows.fetch_add(
+                                1, std::memory_order_relaxed);
+                        }
+
+                        // The same goes for the response. We'll still send
+                        // everything over the socket when logging all events
+                        // so the response can be logged on the plugin side.
+                        YaProcessData::Response& output_data = [&]() -> auto& {
+                            ScopedRealtimeSection realtime_section{};
+                            return request.data.create_response();
+                        }();
+                        const bool output_data_in_shm =
+                            logger_.logger_.verbosity_ <
+                                Logger::Verbosity::all_events &&
+                            write_shm_object(
+                                *instance.process_buffers,
+                                AudioShmBuffer::MetadataRegion::response,
+                                output_data);
 
                         return YaAudioProcessor::ProcessResponse{
                             .result = result,
-                            .output_data = request.data.create_response()};
+                            .output_data_in_shm = output_data_in_shm,
+                            .output_data = output_data};
                     },
-                    [&](const YaAudioProcessor::GetTailSamples& request)
+                    [&](const YaAudioProcessor::GetTailSamples&)
                         -> YaAudioProcessor::GetTailSamples::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         return instance.interfaces.audio_processor
                             ->getTailSamples();
                     },
-                    [&](const YaComponent::GetControllerClassId& request)
+                    [&](const YaComponent::GetControllerClassId&)
                         -> YaComponent::GetControllerClassId::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         Steinberg::TUID cid{0};
                         const tresult result =
@@ -1705,24 +2370,21 @@ size_t Vst3Bridge::register_object_instance(
                     },
                     [&](const YaComponent::SetIoMode& request)
                         -> YaComponent::SetIoMode::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         return instance.interfaces.component->setIoMode(
                             request.mode);
                     },
                     [&](const YaComponent::GetBusCount& request)
                         -> YaComponent::GetBusCount::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         return instance.interfaces.component->getBusCount(
                             request.type, request.dir);
                     },
                     [&](YaComponent::GetBusInfo& request)
                         -> YaComponent::GetBusInfo::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         Steinberg::Vst::BusInfo bus{};
                         const tresult result =
@@ -1734,8 +2396,7 @@ size_t Vst3Bridge::register_object_instance(
                     },
                     [&](YaComponent::GetRoutingInfo& request)
                         -> YaComponent::GetRoutingInfo::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
                         Steinberg::Vst::RoutingInfo out_info{};
                         const tresult result =
@@ -1747,12 +2408,23 @@ size_t Vst3Bridge::register_object_instance(
                     },
                     [&](const YaComponent::ActivateBus& request)
                         -> YaComponent::ActivateBus::Response {
-                        const auto& [instance, _] =
-                            get_instance(request.instance_id);
+                        Vst3PluginInstance& instance = this_instance;
 
-                        return instance.interfaces.component->activateBus(
-                            request.type, request.dir, request.index,
-                            request.state);
+                        const tresult result =
+                            instance.interfaces.component->activateBus(
+                                request.type, request.dir, request.index,
+                                request.state);
+
+                        // We'll only lay out active audio busses in the shared
+                        // memory audio buffers. The buffers are set up again
+                        // during the next `IComponent::setActive()` call.
+                        if (request.type == Steinberg::Vst::kAudio &&
+                            result == Steinberg::kResultOk) {
+                            instance.audio_bus_states[{
+                                request.dir, request.index}] = request.state;
+                        }
+
+                        return result;
                     },
                     [&](const YaComponent::SetActive& request)
                         -> YaComponent::SetActive::Response {
@@ -1766,22 +2438,40 @@ size_t Vst3Bridge::register_object_instance(
                         //       calls.
                         return do_mutual_recursion_on_off_thread(
                             [&]() -> YaComponent::SetActive::Response {
-                                const auto& [instance, _] =
-                                    get_instance(request.instance_id);
+                                Vst3PluginInstance& instance = this_instance;
 
                                 const tresult result =
                                     instance.interfaces.component->setActive(
                                         request.state);
 
+                                if (!request.state) {
+                                    if (const uint32_t overflows =
+                                            instance.output_capacity_overflows
+                                                .exchange(0);
+                                        overflows > 0) {
+                                        logger_.log(
+                                            "WARNING: The plugin output more "
+                                            "parameter changes or events than "
+                                            "preallocated in " +
+                                            std::to_string(overflows) +
+                                            " processing cycles");
+                                    }
+                                }
+
                                 // NOTE: REAPER may change the bus layout after
                                 //       calling
                                 //       `IAudioProcessor::setupProcessing()`,
                                 //       so this place is the only safe place to
-                                //       setup the buffers
+                                //       setup the buffers. The buffers are
+                                //       kept around when the plugin gets
+                                //       deactivated so toggling the plugin
+                                //       doesn't cause any reallocations.
                                 const std::optional<AudioShmBuffer::Config>
                                     updated_audio_buffers_config =
-                                        setup_shared_audio_buffers(
-                                            request.instance_id);
+                                        request.state
+                                            ? setup_shared_audio_buffers(
+                                                  request.instance_id, instance)
+                                            : std::nullopt;
 
                                 return YaComponent::SetActiveResponse{
                                     .result = result,
@@ -1789,14 +2479,12 @@ size_t Vst3Bridge::register_object_instance(
                                         updated_audio_buffers_config)};
                             });
                     },
-                    [&](const YaPrefetchableSupport::GetPrefetchableSupport&
-                            request)
+                    [&](const YaPrefetchableSupport::GetPrefetchableSupport&)
                         -> YaPrefetchableSupport::GetPrefetchableSupport::
                             Response {
                                 Steinberg::Vst::PrefetchableSupport
                                     prefetchable;
-                                const auto& [instance, _] =
-                                    get_instance(request.instance_id);
+                                Vst3PluginInstance& instance = this_instance;
 
                                 const tresult result =
                                     instance.interfaces.prefetchable_support
@@ -1815,16 +2503,23 @@ size_t Vst3Bridge::register_object_instance(
         // connect to it before our thread is up and running.
         socket_listening_latch.get_future().wait();
     }
-
-    return instance_id;
 }
 
 void Vst3Bridge::unregister_object_instance(size_t instance_id) {
     // Tear the dedicated audio processing socket down again if we
-    // created one while handling `Vst3PluginProxy::Construct`
-    if (const auto& [instance, _] = get_instance(instance_id);
-        instance.interfaces.audio_processor || instance.interfaces.component) {
-        sockets_.remove_audio_processor(instance_id);
+    // created one while handling `Vst3PluginProxy::Construct`. The audio
+    // thread accesses the instance without locking while processing audio, so
+    // it needs to have exited before we can remove the instance. The thread is
+    // joined when `audio_processor_handler` goes out of scope.
+    {
+        Win32Thread audio_processor_handler;
+        if (const auto& [instance, _] = get_instance(instance_id);
+            instance.interfaces.audio_processor ||
+            instance.interfaces.component) {
+            sockets_.remove_audio_processor(instance_id);
+            audio_processor_handler =
+                std::move(instance.audio_processor_handler);
+        }
     }
 
     // Remove the instance from within the main IO context so
@@ -1841,6 +2536,7 @@ void Vst3Bridge::unregister_object_instance(size_t instance_id) {
             object_instances_.erase(instance_id);
         })
         .wait();
+    untrack_audio_buffer(instance_id);
 }
 
 Steinberg::FUnknownPtr<Steinberg::IPluginBase> hack_init_plugin_base(
@@ -1881,3 +2577,11 @@ Steinberg::FUnknownPtr<Steinberg::IPluginBase> hack_init_plugin_base(
         return nullptr;
     }
 }
+
+std::string vst3_module_cache_key(const std::string& module_path) {
+    std::error_code error;
+    const ghc::filesystem::path canonical_path =
+        ghc::filesystem::weakly_canonical(module_path, error);
+
+    return error ? module_path : canonical_path.string();
+}
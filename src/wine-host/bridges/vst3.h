@@ -32,6 +32,26 @@
 // Forward declarations
 class Vst3ContextMenuProxyImpl;
 
+/**
+ * VST3 control requests that we handle on the GUI thread by default even though
+ * they don't interact with the Win32 message loop, because some plugins require
+ * it. See the notes in the request handlers in `vst3.cpp` for which plugins
+ * need this. When the `vst3_control_off_gui_thread` option is enabled these
+ * requests are handled directly on the thread that received them instead, so
+ * they don't have to wait behind GUI work. This serves the same purpose as
+ * `unsafe_requests` in the VST2 bridge. Other requests that have to be run on
+ * the GUI thread, like everything related to `IPlugView` and
+ * `IPluginBase::initialize()`, are not listed here.
+ *
+ * @see Vst3Bridge::do_request_on_gui_thread
+ */
+template <typename T>
+constexpr bool gui_thread_agnostic_request =
+    std::is_same_v<T, Vst3PluginProxy::SetState> ||
+    std::is_same_v<T, Vst3PluginProxy::GetState> ||
+    std::is_same_v<T, YaConnectionPoint::Notify> ||
+    std::is_same_v<T, YaInfoListener::SetChannelContextInfos>;
+
 /**
  * A holder for an object instance's `IPlugView` object and all smart pointers
  * casted from it.
@@ -52,6 +72,15 @@ struct Vst3PlugViewInterfaces {
     Steinberg::FUnknownPtr<Steinberg::Vst::IParameterFinder> parameter_finder;
     Steinberg::FUnknownPtr<Steinberg::IPlugViewContentScaleSupport>
         plug_view_content_scale_support;
+
+    /**
+     * The scale factor that was last successfully applied to this view
+     * through `IPlugViewContentScaleSupport::setContentScaleFactor()`. Hosts
+     * tend to repeat the same scale factor every time the editor gets
+     * attached or moved, and we don't need to bother the GUI thread for that.
+     */
+    std::optional<Steinberg::IPlugViewContentScaleSupport::ScaleFactor>
+        content_scale_factor;
 };
 
 /**
@@ -179,6 +208,12 @@ struct Vst3PluginInstance {
      */
     std::optional<AudioShmBuffer> process_buffers;
 
+    /**
+     * Used to release `process_buffers`'s memory while this instance is idle
+     * when the `audio_buffer_idle_release_s` option is enabled.
+     */
+    IdleBufferRelease idle_buffer_release;
+
     /**
      * Pointers to the per-bus input channels in process_buffers so we can pass
      * them to the plugin after a call to `YaProcessData::reconstruct()`. These
@@ -195,12 +230,31 @@ struct Vst3PluginInstance {
      */
     std::vector<std::vector<void*>> process_buffers_output_pointers;
 
+    /**
+     * The process context delta encoded process contexts are decoded against.
+     * This lives here rather than in the thread local `YaProcessData` since
+     * `process()` calls may arrive on any of the instance's audio processor
+     * connections.
+     */
+    YaProcessContextBase process_context_base;
+
     /**
      * This instance's editor, if it has an open editor. Embedding here works
      * exactly the same as how it works for VST2 plugins.
      */
     std::optional<Editor> editor;
 
+    /**
+     * The last scale factor the host successfully negotiated with any of this
+     * instance's views. When the editor gets closed and then reopened later,
+     * we'll immediately apply this factor to the new view before the host
+     * embeds it. That way the editor opens at the correct size right away,
+     * instead of first opening unscaled and then getting resized again once
+     * the host repeats its scale factor.
+     */
+    std::optional<Steinberg::IPlugViewContentScaleSupport::ScaleFactor>
+        last_content_scale_factor;
+
     /**
      * The base object we cast from. This is upcasted form the object created by
      * the factory.
@@ -256,6 +310,54 @@ struct Vst3PluginInstance {
      * processing.
      */
     std::optional<Steinberg::Vst::ProcessSetup> process_setup;
+
+    /**
+     * The plugin's parameter count as reported during
+     * `IAudioProcessor::setupProcessing()`. We use this to preallocate the
+     * output parameter changes and events passed to the plugin during
+     * `IAudioProcessor::process()` so the plugin can write to them without us
+     * allocating memory on the audio thread.
+     *
+     * @see YaProcessData::reserve_outputs
+     */
+    size_t num_output_parameters = 0;
+
+    /**
+     * The number of processing cycles where the plugin output more parameter
+     * changes or events than we preallocated space for. This gets printed and
+     * reset when the plugin gets deactivated, since we don't want to log
+     * anything from the audio thread.
+     */
+    std::atomic_uint32_t output_capacity_overflows = 0;
+
+    /**
+     * The host audio thread this instance's audio thread was last pinned for
+     * with the `audio_thread_host_mapping` option. Only accessed from the
+     * instance's audio thread.
+     *
+     * @see HostAudioThreadMap
+     */
+    std::optional<int> last_host_thread_id;
+
+    /**
+     * The scheduling policy used for this instance's audio thread. With the
+     * `audio_thread_sched_deadline` option this is switched to
+     * `SCHED_DEADLINE` during `IAudioProcessor::setupProcessing()`, which is
+     * also handled on the audio thread. Only accessed from that thread.
+     */
+    AudioThreadScheduling audio_thread_scheduling;
+
+    /**
+     * The audio busses the host has explicitly activated or deactivated
+     * through `IComponent::activateBus()`, indexed by `(direction, index)`.
+     * Busses that don't have an entry here use the plugin's
+     * `BusInfo::kDefaultActive` flag instead. We only reserve space in the
+     * shared memory audio buffers for main busses and for active auxiliary
+     * busses, since plugins with dozens of sidechain and multi-out busses
+     * would otherwise use a lot of memory for busses the host never uses.
+     */
+    std::map<std::pair<Steinberg::Vst::BusDirection, int32>, bool>
+        audio_bus_states;
 };
 
 /**
@@ -275,6 +377,8 @@ class Vst3Bridge : public HostBridge {
      *   load.
      * @param endpoint_base_dir The base directory used for the socket
      *   endpoints. See `Sockets` for more information.
+     * @param abstract_sockets Whether the socket endpoints are in the abstract
+     *   socket namespace. This is the case for individually hosted plugins.
      * @param parent_pid The process ID of the native plugin host this bridge is
      *   supposed to communicate with. Used as part of our watchdog to prevent
      *   dangling Wine processes.
@@ -288,6 +392,7 @@ class Vst3Bridge : public HostBridge {
     Vst3Bridge(MainContext& main_context,
                std::string plugin_dll_path,
                std::string endpoint_base_dir,
+               bool abstract_sockets,
                pid_t parent_pid);
 
     /**
@@ -297,6 +402,15 @@ class Vst3Bridge : public HostBridge {
      */
     bool inhibits_event_loop() noexcept override;
 
+    /**
+     * Returns `module_` when the `group_module_cache` option is enabled. While
+     * the module is still alive, other bridges for the same plugin will reuse
+     * it instead of loading the module again.
+     *
+     * @see cached_vst3_modules
+     */
+    std::shared_ptr<void> retain_module() override;
+
     /**
      * Here we'll listen for and handle incoming control messages until the
      * sockets get closed.
@@ -328,7 +442,17 @@ class Vst3Bridge : public HostBridge {
    protected:
     void close_sockets() override;
 
+    void release_idle_audio_buffers(
+        std::chrono::steady_clock::duration timeout) override;
+
    public:
+    /**
+     * The configuration for this instance of yabridge, as sent by the native
+     * plugin during startup. The VST3 interface implementations use this to
+     * check whether optional behaviour has been enabled.
+     */
+    inline const Configuration& config() const noexcept { return config_; }
+
     /**
      * Send a callback message to the host return the response. This is a
      * shorthand for `sockets.vst_host_callback_.send_message` for use in VST3
@@ -336,9 +460,44 @@ class Vst3Bridge : public HostBridge {
      */
     template <typename T>
     typename T::Response send_message(const T& object) {
+        const ProcessCallbackTimer::Callback callback_timer(
+            vst3_process_callback_histogram<T>());
         return sockets_.vst_host_callback_.send_message(object, std::nullopt);
     }
 
+    /**
+     * Call `IConnectionPoint::notify(message)` on an object instance's
+     * connection point from the calling thread. `Vst3ConnectionPointProxyImpl`
+     * uses this to bypass the host's connection proxy once it knows which
+     * object is on the other side of it.
+     *
+     * @return The result of the call, or a nullopt if the object instance no
+     *   longer exists or does not implement `IConnectionPoint`.
+     */
+    std::optional<tresult> notify_instance_directly(
+        size_t instance_id,
+        Steinberg::Vst::IMessage* message);
+
+    /**
+     * If the `vst3_async_callbacks` option is enabled, queue a callback that
+     * doesn't need a response to be sent to the host from a background thread
+     * and return `true`. The caller should then return `kResultOk` without
+     * waiting. Otherwise this returns `false`, and the caller should send the
+     * message like it normally would.
+     *
+     * @see Vst3MessageHandler::send_message_async
+     */
+    template <FireAndForget T>
+    bool maybe_send_message_async(const T& object) {
+        if (config_.vst3_async_callbacks) {
+            sockets_.vst_host_callback_.send_message_async(object,
+                                                          std::nullopt);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
     /**
      * When called form the GUI thread, spawn a new thread and call
      * `send_message()` from there, and then handle functions passed by calls to
@@ -409,8 +568,27 @@ class Vst3Bridge : public HostBridge {
     }
 
     /**
-     * The same as the above function, but we'll just execute the function on
-     * this thread when the mutual recursion context is not active.
+     * Handle a request of type `T` on the GUI thread using
+     * `do_mutual_recursion_on_gui_thread()`. If `T` is listed in
+     * `gui_thread_agnostic_request` and the `vst3_control_off_gui_thread`
+     * option is enabled, then `fn` is called directly on the calling thread
+     * instead.
+     */
+    template <typename T, std::invocable F>
+    std::invoke_result_t<F> do_request_on_gui_thread(F&& fn) {
+        if constexpr (gui_thread_agnostic_request<T>) {
+            if (config_.vst3_control_off_gui_thread) {
+                return fn();
+            }
+        }
+
+        return do_mutual_recursion_on_gui_thread(std::forward<F>(fn));
+    }
+
+    /**
+     * The same as `do_mutual_recursion_on_gui_thread()`, but we'll just execute
+     * the function on this thread when the mutual recursion context is not
+     * active.
      *
      * @see Vst3Bridge::do_mutual_recursion_on_gui_thread
      */
@@ -461,19 +639,45 @@ class Vst3Bridge : public HostBridge {
      * interface.
      *
      * A nullopt will also be returned if this is called again after shared
-     * audio buffers have been set up and the audio buffer size has not changed.
+     * audio buffers have been set up and the audio buffer layout has not
+     * changed.
+     *
+     * Only main busses and active auxiliary busses are laid out in the
+     * buffers. See `Vst3PluginInstance::audio_bus_states`.
      */
     std::optional<AudioShmBuffer::Config> setup_shared_audio_buffers(
-        size_t instance_id);
+        size_t instance_id,
+        Vst3PluginInstance& instance);
+
+    /**
+     * Query the information hosts will ask for right after initializing a
+     * plugin object. Used when the `vst3_prefetch_instance_info` option is
+     * enabled. This should be called after `IPluginBase::initialize()`, since
+     * plugins will often only set up their busses and parameters there.
+     *
+     * @see Vst3PluginProxy::InstanceSummary
+     */
+    Vst3PluginProxy::InstanceSummary summarize_instance(
+        Vst3PluginInstance& instance);
 
     /**
      * Assign a unique identifier to an object and add it to
      * `object_instances_`. This will also set up listeners for
-     * `IAudioProcessor` and `IComponent` function calls.
+     * `IAudioProcessor` and `IComponent` function calls, unless the
+     * `vst3_lazy_audio_threads` option is enabled.
      */
     size_t register_object_instance(
         Steinberg::IPtr<Steinberg::FUnknown> object);
 
+    /**
+     * If the object supports `IAudioProcessor` or `IComponent`, spawn the
+     * instance's dedicated audio thread and wait until its socket is
+     * listening. Called right away from `register_object_instance()`, or when
+     * the native plugin sends `Vst3PluginProxy::StartAudioProcessor` when the
+     * `vst3_lazy_audio_threads` option is enabled.
+     */
+    void start_audio_processor(size_t instance_id);
+
     /**
      * Remove an object from `object_instances_`. Will also tear down the
      * `IAudioProcessor`/`IComponent` socket if it had one.
@@ -530,10 +734,10 @@ class Vst3Bridge : public HostBridge {
      * contested, we should also not get a measurable performance penalty from
      * making double sure nothing can go wrong.
      *
-     * TODO: At some point replace this with a multiple reader single writer
-     *       lock based by a spinlock. Because this lock is rarely contested
-     *       `get_instance()` never yields to the scheduler during audio
-     *       processing, but it's still something we should avoid at all costs.
+     * NOTE: The instances' audio threads never take this lock, since they
+     *       have stable references to their own instances. Creating or
+     *       destroying instances would otherwise stall every other instance's
+     *       audio processing.
      */
     std::shared_mutex object_instances_mutex_;
 
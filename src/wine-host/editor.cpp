@@ -21,6 +21,8 @@
 
 #include <llvm/small-vector.h>
 
+#include "../common/logging/trace.h"
+
 using namespace std::literals::chrono_literals;
 using namespace std::literals::string_literals;
 
@@ -58,19 +60,24 @@ constexpr size_t idle_timer_id = 1337;
 
 /**
  * The X11 event mask for the host window, which in most DAWs except for Ardour
- * and REAPER will be the same as `parent_window_`.
+ * and REAPER will be the same as `parent_window_`. `VisibilityNotify` events
+ * are only selected when we need them.
+ *
+ * @see Editor::host_event_mask
  */
-constexpr uint32_t host_event_mask =
-    XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_VISIBILITY_CHANGE;
+constexpr uint32_t base_host_event_mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
 
 /**
  * The X11 event mask for the parent window. We'll use this for input focus
  * grabbing (we'll receive the `EnterNotify` and `LeaveNotify` events for
  * `wrapper_window_`). We also need this structure notify here as well to detect
- * reparents.
+ * reparents. We never select pointer motion events, since the crossing events
+ * are all we need to know about the pointer.
+ *
+ * @see Editor::parent_event_mask
  */
-constexpr uint32_t parent_event_mask =
-    host_event_mask | XCB_EVENT_MASK_FOCUS_CHANGE |
+constexpr uint32_t base_parent_event_mask =
+    base_host_event_mask | XCB_EVENT_MASK_FOCUS_CHANGE |
     XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW;
 
 /**
@@ -119,6 +126,27 @@ constexpr uint32_t xembed_focus_first = 1;
 
 static const HCURSOR arrow_cursor = LoadCursor(nullptr, IDC_ARROW);
 
+/**
+ * A hidden editor window created ahead of time through
+ * `Editor::precreate_window()`, along with the X11 connection that was opened
+ * for it. The next `Editor` adopts this window instead of creating a new one.
+ * This is only ever accessed from the GUI thread.
+ */
+struct PrecreatedWindow {
+    HWND handle;
+    std::shared_ptr<SharedX11Connection> x11_connection;
+};
+std::optional<PrecreatedWindow> precreated_window;
+
+/**
+ * The number of levels above the host's parent window `find_host_window()`
+ * found the host's editor window at the last time it had to walk the entire
+ * window tree. The host will embed all of its editors the same way, so we'll
+ * first check whether the window at this depth is a valid host window before
+ * walking the tree again. This is only ever accessed from the GUI thread.
+ */
+std::optional<size_t> cached_host_window_depth;
+
 /**
  * Find the the ancestors for the given window. This returns a list of window
  * IDs that starts with `starting_at`, and then iteratively contains the parent
@@ -149,6 +177,12 @@ llvm::SmallVector<xcb_window_t, 8> find_ancestor_windows(
  * host window) doesn't pass through keyboard input for the window once the
  * mouse leaves the window.
  *
+ * Since walking the window tree takes a round trip to the X11 server for every
+ * ancestor, the depth of the window we found is cached in
+ * `cached_host_window_depth`. When opening other editors we'll then only
+ * follow the parents up to that depth and check the window we end up at,
+ * falling back to a full search when that window isn't valid.
+ *
  * @param x11_connection The X11 connection to use.
  * @param starting_at The window we want to know the ancestor windows of.
  * @param xcb_wm_state_property The X11 atom corresponding to `WM_STATE`
@@ -194,6 +228,132 @@ xcb_window_t get_x11_handle(HWND win32_handle) noexcept;
  * yabridge.
  */
 ATOM get_window_class() noexcept;
+/**
+ * Create a hidden Win32 window the plugin can embed its editor in.
+ *
+ * @param client_area The size of the window's client area. See
+ *   `Editor::client_area_`.
+ * @param editor The editor this window belongs to, accessible from the window
+ *   procedure through `GWLP_USERDATA`. This can be a null pointer when
+ *   creating the window ahead of time.
+ */
+HWND create_editor_window(const Size& client_area, Editor* editor) noexcept;
+/**
+ * Adopt the window created through `Editor::precreate_window()` if there is
+ * one, or create a new window otherwise. This prints the time spent creating
+ * the window when editor tracing is enabled.
+ */
+HWND take_or_create_editor_window(const Size& client_area,
+                                  Editor* editor,
+                                  Logger& logger) noexcept;
+/**
+ * Return the window an X11 event was reported on, i.e. the window the event
+ * was selected on. This is what `SharedX11Connection` uses to decide which
+ * editors should receive the event. Returns a nullopt for errors and for
+ * events editors never select.
+ */
+std::optional<xcb_window_t> get_event_window(
+    const xcb_generic_event_t& generic_event) noexcept;
+
+SharedX11Connection::SharedX11Connection()
+    : x11_connection_(xcb_connect(nullptr, nullptr), xcb_disconnect) {}
+
+std::shared_ptr<SharedX11Connection> SharedX11Connection::get() {
+    // This is only used from the GUI thread, so this doesn't need any locking
+    static std::weak_ptr<SharedX11Connection> instance;
+
+    std::shared_ptr<SharedX11Connection> connection = instance.lock();
+    if (!connection) {
+        connection = std::make_shared<SharedX11Connection>();
+        instance = connection;
+    }
+
+    return connection;
+}
+
+void SharedX11Connection::select_events(xcb_window_t window,
+                                        Editor* editor,
+                                        uint32_t mask) {
+    selections_[window][editor] = mask;
+    update_event_mask(window);
+}
+
+void SharedX11Connection::deselect_events(xcb_window_t window, Editor* editor) {
+    if (auto selection = selections_.find(window);
+        selection != selections_.end() && selection->second.erase(editor) > 0) {
+        update_event_mask(window);
+    }
+}
+
+void SharedX11Connection::unregister(Editor* editor) {
+    for (auto& [window, editor_masks] : selections_) {
+        if (editor_masks.erase(editor) > 0) {
+            update_event_mask(window);
+        }
+    }
+    std::erase_if(selections_, [](const auto& selection) {
+        return selection.second.empty();
+    });
+
+    queued_events_.erase(editor);
+    xcb_flush(x11_connection_.get());
+}
+
+void SharedX11Connection::poll_events() {
+    std::unique_ptr<xcb_generic_event_t> generic_event;
+    while (generic_event.reset(xcb_poll_for_event(x11_connection_.get())),
+           generic_event != nullptr) {
+        const std::optional<xcb_window_t> window =
+            get_event_window(*generic_event);
+        if (!window) {
+            continue;
+        }
+
+        const auto selection = selections_.find(*window);
+        if (selection == selections_.end() || selection->second.empty()) {
+            continue;
+        }
+
+        // If multiple editors selected events on the same window (which can
+        // happen when two editors share a host window), then every editor gets
+        // its own copy of the event. All events we select are regular 32-byte
+        // events.
+        auto editor_it = selection->second.begin();
+        for (auto next_it = std::next(editor_it);
+             next_it != selection->second.end(); next_it++) {
+            queued_events_[next_it->first].push_back(
+                std::make_unique<xcb_generic_event_t>(*generic_event));
+        }
+        queued_events_[editor_it->first].push_back(std::move(generic_event));
+    }
+}
+
+std::unique_ptr<xcb_generic_event_t> SharedX11Connection::take_event(
+    Editor* editor) {
+    const auto queue = queued_events_.find(editor);
+    if (queue == queued_events_.end() || queue->second.empty()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<xcb_generic_event_t> event =
+        std::move(queue->second.front());
+    queue->second.pop_front();
+
+    return event;
+}
+
+void SharedX11Connection::update_event_mask(xcb_window_t window) {
+    uint32_t mask = XCB_EVENT_MASK_NO_EVENT;
+    if (const auto selection = selections_.find(window);
+        selection != selections_.end()) {
+        for (const auto& [editor, editor_mask] : selection->second) {
+            mask |= editor_mask;
+        }
+    }
+
+    xcb_change_window_attributes(x11_connection_.get(), window,
+                                 XCB_CW_EVENT_MASK, &mask);
+}
 
 DeferredWin32Window::DeferredWin32Window(
     MainContext& main_context,
@@ -266,48 +426,32 @@ Editor::Editor(MainContext& main_context,
     : use_coordinate_hack_(config.editor_coordinate_hack),
       use_force_dnd_(config.editor_force_dnd),
       use_xembed_(config.editor_xembed),
+      use_precreated_window_(config.editor_precreate_window),
+      main_context_(main_context),
       logger_(logger),
-      x11_connection_(xcb_connect(nullptr, nullptr), xcb_disconnect),
+      open_editor_guard_(main_context),
+      shared_x11_connection_(SharedX11Connection::get()),
+      x11_connection_(shared_x11_connection_->x11_connection_),
       dnd_proxy_handle_(WineXdndProxy::get_handle()),
       client_area_(get_maximum_screen_dimensions(*x11_connection_)),
-      // Create a window without any decoratiosn for easy embedding. The
-      // combination of `WS_EX_TOOLWINDOW` and `WS_POPUP` causes the window to
-      // be drawn without any decorations (making resizes behave as you'd
-      // expect) and also causes mouse coordinates to be relative to the window
-      // itself.
-      win32_window_(main_context,
-                    x11_connection_,
-                    CreateWindowEx(WS_EX_TOOLWINDOW,
-                                   reinterpret_cast<LPCSTR>(get_window_class()),
-                                   "yabridge plugin",
-                                   WS_POPUP,
-                                   // NOTE: With certain DEs/WMs (notably,
-                                   //       Cinnamon), Wine does not render the
-                                   //       window at all when using a primary
-                                   //       display that's positioned to the
-                                   //       right of another display. Presumably
-                                   //       it tries to manually clip the client
-                                   //       rendered client area to the physical
-                                   //       display. During the reparenting and
-                                   //       `fix_local_coordinates()` the window
-                                   //       will be moved to `(0, 0)` anyways,
-                                   //       but setting its initial position
-                                   //       according to the primary display
-                                   //       fixes these rendering issues.
-                                   GetSystemMetrics(SM_XVIRTUALSCREEN),
-                                   GetSystemMetrics(SM_YVIRTUALSCREEN),
-                                   client_area_.width,
-                                   client_area_.height,
-                                   nullptr,
-                                   nullptr,
-                                   GetModuleHandle(nullptr),
-                                   this)),
-      idle_timer_(
-          Win32Timer(win32_window_.handle_,
-                     idle_timer_id,
-                     std::chrono::duration_cast<std::chrono::milliseconds>(
-                         config.event_loop_interval())
-                         .count())),
+      win32_window_(
+          main_context,
+          x11_connection_,
+          take_or_create_editor_window(client_area_, this, logger)),
+      idle_timer_interval_ms_(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              config.event_loop_interval())
+              .count()),
+      obscured_idle_timer_interval_ms_(
+          config.obscured_editor_idle_interval()
+              ? std::optional<unsigned int>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        *config.obscured_editor_idle_interval())
+                        .count())
+              : std::nullopt),
+      idle_timer_(Win32Timer(win32_window_.handle_,
+                             idle_timer_id,
+                             idle_timer_interval_ms_)),
       idle_timer_proc_([this, timer_proc = std::move(timer_proc)]() mutable {
           handle_x11_events();
           if (timer_proc) {
@@ -387,16 +531,20 @@ Editor::Editor(MainContext& main_context,
     // `parent_window_` themselves.
     // If we do enable XEmbed support, we'll also listen for visibility changes
     // and trigger the embedding when the window becomes visible
-    xcb_change_window_attributes(x11_connection_.get(), host_window_,
-                                 XCB_CW_EVENT_MASK, &host_event_mask);
-    xcb_change_window_attributes(x11_connection_.get(), parent_window_,
-                                 XCB_CW_EVENT_MASK, &parent_event_mask);
-    xcb_change_window_attributes(x11_connection_.get(), wrapper_window_.window_,
-                                 XCB_CW_EVENT_MASK, &wrapper_event_mask);
+    // NOTE: `host_window_` and `parent_window_` may be the same window, in
+    //       which case the parent window's event mask replaces the host
+    //       window's mask
+    shared_x11_connection_->select_events(host_window_, this,
+                                          host_event_mask());
+    shared_x11_connection_->select_events(parent_window_, this,
+                                          parent_event_mask());
+    shared_x11_connection_->select_events(wrapper_window_.window_, this,
+                                          wrapper_event_mask);
     xcb_flush(x11_connection_.get());
 
     // First reparent our dumb wrapper window to the host's window, and then
     // embed the Wine window into our wrapper window
+    const auto embed_start = std::chrono::steady_clock::now();
     do_reparent(wrapper_window_.window_, parent_window_);
     xcb_map_window(x11_connection_.get(), wrapper_window_.window_);
     xcb_flush(x11_connection_.get());
@@ -414,9 +562,56 @@ Editor::Editor(MainContext& main_context,
         // described in `Editor`'s docstring'.
         do_reparent(wine_window_, wrapper_window_.window_);
     }
+
+    embedded_at_ = std::chrono::steady_clock::now();
+    logger.log_editor_trace([&]() {
+        return "DEBUG: Embedded the editor window in " +
+               format_duration_ms(embedded_at_ - embed_start);
+    });
+}
+
+Editor::~Editor() noexcept {
+    shared_x11_connection_->unregister(this);
+
+    // The next editor that gets opened can then use a fresh window again
+    if (use_precreated_window_) {
+        main_context_.schedule_task([]() { Editor::precreate_window(); });
+    }
 }
 
 void Editor::resize(uint16_t width, uint16_t height) {
+    // VST3 plugins will resize the window twice for every resize they request,
+    // once in `IPlugFrame::resizeView()` and once in `IPlugView::onSize()`.
+    // The coordinate hack below should still run every time though, see the
+    // comment there.
+    if (!use_coordinate_hack_ && current_size_ &&
+        current_size_->width == width && current_size_->height == height) {
+        pending_size_.reset();
+        return;
+    }
+
+    pending_size_ = Size{.width = width, .height = height};
+    if (std::chrono::steady_clock::now() - last_resize_time_ >=
+        std::chrono::milliseconds(idle_timer_interval_ms_)) {
+        apply_pending_resize();
+    } else {
+        logger_.log_editor_trace([&]() {
+            return "DEBUG: Deferring resize to " + std::to_string(width) + "x" +
+                   std::to_string(height) + " until the next frame";
+        });
+    }
+}
+
+void Editor::apply_pending_resize() {
+    if (!pending_size_) {
+        return;
+    }
+
+    const auto [width, height] = *pending_size_;
+    pending_size_.reset();
+    current_size_ = Size{.width = width, .height = height};
+    last_resize_time_ = std::chrono::steady_clock::now();
+
     logger_.log_editor_trace([&]() {
         return "DEBUG: Resizing wrapper window to " + std::to_string(width) +
                "x" + std::to_string(height);
@@ -454,17 +649,60 @@ void Editor::resize(uint16_t width, uint16_t height) {
 }
 
 void Editor::show() noexcept {
+    // This includes the plugin opening its editor and the initial resize
+    logger_.log_editor_trace([&]() {
+        return "DEBUG: The plugin embedded itself in the editor window after " +
+               format_duration_ms(std::chrono::steady_clock::now() -
+                                   embedded_at_);
+    });
+
     ShowWindow(win32_window_.handle_, SW_SHOWNORMAL);
 }
 
+void Editor::precreate_window() noexcept {
+    if (precreated_window) {
+        return;
+    }
+
+    try {
+        std::shared_ptr<SharedX11Connection> x11_connection =
+            SharedX11Connection::get();
+        const Size client_area =
+            get_maximum_screen_dimensions(*x11_connection->x11_connection_);
+        if (const HWND handle = create_editor_window(client_area, nullptr)) {
+            precreated_window.emplace(PrecreatedWindow{
+                .handle = handle, .x11_connection = std::move(x11_connection)});
+        }
+    } catch (const std::bad_alloc&) {
+        // The editor will just create its own window when it gets opened
+    }
+}
+
 void Editor::handle_x11_events() noexcept {
+    const TraceScope trace_scope("handle_x11_events", "editor");
+
     // NOTE: Ardour will unmap the window instead of closing the editor. When
     //       the window is unmapped `wine_window_` doesn't exist and any X11
     //       function calls involving it will fail. All functions called from
     //       here should be able to handle that cleanly.
     try {
+        // Apply the last size requested during the previous frame, if any
+        // resizes were coalesced
+        apply_pending_resize();
+
+        // Spoofing the Wine window's coordinates requires a round trip to the
+        // X11 server, so we'll only do that once after handling all pending
+        // events instead of for every single event that may have moved our
+        // window
+        bool coordinates_changed = false;
+
+        // This reads the events for all editors in this process, and we'll
+        // then only handle the ones meant for us. The other editors will handle
+        // their events when their own timers fire.
+        shared_x11_connection_->poll_events();
+
         std::unique_ptr<xcb_generic_event_t> generic_event;
-        while (generic_event.reset(xcb_poll_for_event(x11_connection_.get())),
+        while (generic_event = shared_x11_connection_->take_event(this),
                generic_event != nullptr) {
             const uint8_t event_type =
                 generic_event->response_type & xcb_event_type_mask;
@@ -497,6 +735,11 @@ void Editor::handle_x11_events() noexcept {
 
                     redetect_host_window();
 
+                    // The window's coordinates relative to its new parent
+                    // can be the same as before, so the next `ConfigureNotify`
+                    // should never be skipped
+                    last_configure_geometry_.clear();
+
                     // If the `editor_force_dnd` option is set, we'll strip
                     // `XdndAware` from all of `wine_window_`'s ancestors
                     // (including `parent_window_`) to forcefully enable
@@ -541,11 +784,20 @@ void Editor::handle_x11_events() noexcept {
                                std::to_string(event->window);
                     });
 
+                    // Hosts and window managers will often send a bunch of
+                    // `ConfigureNotify` events for the same geometry. These
+                    // can't have moved the window, so we'll skip those.
                     if (event->window == host_window_ ||
                         event->window == parent_window_ ||
                         event->window == wrapper_window_.window_) {
-                        if (!use_xembed_) {
-                            fix_local_coordinates();
+                        const auto geometry =
+                            std::tuple(is_synthetic_event, event->x, event->y,
+                                       event->width, event->height);
+                        auto& last_geometry =
+                            last_configure_geometry_[event->window];
+                        if (last_geometry != geometry) {
+                            last_geometry = geometry;
+                            coordinates_changed = true;
                         }
                     }
                 } break;
@@ -567,6 +819,54 @@ void Editor::handle_x11_events() noexcept {
                             do_xembed();
                         }
                     }
+
+                    // We'll slow down the editor's idle timer while the host's
+                    // window is hidden behind other windows
+                    if (event->window == host_window_) {
+                        host_window_obscured_ =
+                            event->state == XCB_VISIBILITY_FULLY_OBSCURED;
+                        update_obscured();
+                    }
+                } break;
+                // An unmapped window does not get a `VisibilityNotify`, so
+                // we'll treat minimizing the host's window the same as it
+                // getting obscured. The next `VisibilityNotify` after the
+                // window gets mapped again will restore the normal rate. Some
+                // hosts, like Ardour and REAPER, will also hide an editor by
+                // unmapping `parent_window_` while the host's window itself
+                // stays visible, so we'll also track that window's map state.
+                case XCB_UNMAP_NOTIFY: {
+                    const auto event =
+                        reinterpret_cast<xcb_unmap_notify_event_t*>(
+                            generic_event.get());
+                    logger_.log_editor_trace([&]() {
+                        return "DEBUG: UnmapNotify for window " +
+                               std::to_string(event->window);
+                    });
+
+                    if (event->window == host_window_) {
+                        host_window_obscured_ = true;
+                    }
+                    if (event->window == parent_window_) {
+                        parent_window_unmapped_ = true;
+                    }
+                    update_obscured();
+                } break;
+                case XCB_MAP_NOTIFY: {
+                    const auto event =
+                        reinterpret_cast<xcb_map_notify_event_t*>(
+                            generic_event.get());
+                    logger_.log_editor_trace([&]() {
+                        return "DEBUG: MapNotify for window " +
+                               std::to_string(event->window);
+                    });
+
+                    // If this is also the host's window, then we'll wait for
+                    // the `VisibilityNotify` to restore the normal rate
+                    if (event->window == parent_window_) {
+                        parent_window_unmapped_ = false;
+                        update_obscured();
+                    }
                 } break;
                 // We want to grab keyboard input focus when the user hovers
                 // over our embedded Wine window AND that window is a child of
@@ -599,9 +899,7 @@ void Editor::handle_x11_events() noexcept {
 
                     if (window == parent_window_ ||
                         window == wrapper_window_.window_) {
-                        if (!use_xembed_) {
-                            fix_local_coordinates();
-                        }
+                        coordinates_changed = true;
 
                         // In case the WM somehow does not support
                         // `_NET_ACTIVE_WINDOW`, a more naive focus grabbing
@@ -741,6 +1039,10 @@ void Editor::handle_x11_events() noexcept {
                 }
             }
         }
+
+        if (coordinates_changed && !use_xembed_) {
+            fix_local_coordinates();
+        }
     } catch (const std::runtime_error& error) {
         std::cerr << error.what() << std::endl;
     }
@@ -766,7 +1068,13 @@ void Editor::fix_local_coordinates() const {
     // window created by the plugin itself. In this case it doesn't matter that
     // the Win32 window is larger than the part of the client area the plugin
     // draws to since any excess will be clipped off by the parent window.
-    const xcb_window_t root = get_root_window(*x11_connection_, parent_window_);
+    //
+    // X11 windows can't move between screens, so the root window will never
+    // change and we only have to query it once
+    if (!root_window_cache_) {
+        root_window_cache_ = get_root_window(*x11_connection_, parent_window_);
+    }
+    const xcb_window_t root = *root_window_cache_;
 
     // We can't directly use the `event.x` and `event.y` coordinates because the
     // parent window may also be embedded inside another window.
@@ -898,6 +1206,38 @@ void Editor::run_timer_proc() {
     idle_timer_proc_();
 }
 
+uint32_t Editor::host_event_mask() const noexcept {
+    // Compositors and window managers can send a steady stream of these while
+    // windows are being moved around, so we'll only ask for them when XEmbed
+    // or the `editor_obscured_frame_rate` option needs them
+    if (use_xembed_ || obscured_idle_timer_interval_ms_) {
+        return base_host_event_mask | XCB_EVENT_MASK_VISIBILITY_CHANGE;
+    } else {
+        return base_host_event_mask;
+    }
+}
+
+uint32_t Editor::parent_event_mask() const noexcept {
+    return host_event_mask() | base_parent_event_mask;
+}
+
+void Editor::update_obscured() noexcept {
+    const bool obscured = host_window_obscured_ || parent_window_unmapped_;
+    if (!obscured_idle_timer_interval_ms_ || obscured == is_obscured_) {
+        return;
+    }
+
+    logger_.log_editor_trace([&]() {
+        return obscured ? "DEBUG: Editor hidden, slowing down editor"
+                        : "DEBUG: Editor visible again, restoring the "
+                          "editor's frame rate";
+    });
+
+    is_obscured_ = obscured;
+    idle_timer_.set_interval(obscured ? *obscured_idle_timer_interval_ms_
+                                      : idle_timer_interval_ms_);
+}
+
 std::optional<uint16_t> Editor::get_active_modifiers() const noexcept {
     xcb_generic_error_t* error = nullptr;
     const xcb_query_pointer_cookie_t query_pointer_cookie =
@@ -995,22 +1335,29 @@ void Editor::redetect_host_window() noexcept {
     // We need to readjust the event masks for the new host window, keeping the
     // (very probable) possibility in mind that the old host window is the same
     // as the parent window or that the parent window now is the host window.
+    // Other editors may still be listening for events on the old host window,
+    // so `SharedX11Connection` will only clear the parts of its event mask
+    // that no other editors need.
     if (host_window_ != parent_window_) {
-        constexpr uint32_t no_event_mask = XCB_EVENT_MASK_NO_EVENT;
-        xcb_change_window_attributes(x11_connection_.get(), host_window_,
-                                     XCB_CW_EVENT_MASK, &no_event_mask);
+        shared_x11_connection_->deselect_events(host_window_, this);
     }
 
     if (new_host_window == parent_window_) {
-        xcb_change_window_attributes(x11_connection_.get(), new_host_window,
-                                     XCB_CW_EVENT_MASK, &parent_event_mask);
+        shared_x11_connection_->select_events(new_host_window, this,
+                                              parent_event_mask());
     } else {
-        xcb_change_window_attributes(x11_connection_.get(), new_host_window,
-                                     XCB_CW_EVENT_MASK, &host_event_mask);
+        shared_x11_connection_->select_events(new_host_window, this,
+                                              host_event_mask());
     }
 
     host_window_ = new_host_window;
     xcb_flush(x11_connection_.get());
+
+    // We don't know anything about the new window's visibility yet, so we'll
+    // assume it's visible until we receive a `VisibilityNotify` saying
+    // otherwise
+    host_window_obscured_ = false;
+    update_obscured();
 }
 
 bool Editor::supports_ewmh_active_window() const {
@@ -1269,27 +1616,69 @@ std::optional<xcb_window_t> find_host_window(
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     xcb_window_t starting_at,
     xcb_atom_t xcb_wm_state_property) {
-    // See the docstring for why this works the way it does
-    const auto ancestors = find_ancestor_windows(x11_connection, starting_at);
-    for (auto window = ancestors.rbegin(); window != ancestors.rend();
-         window++) {
+    const auto has_wm_state = [&](xcb_get_property_cookie_t property_cookie) {
         xcb_generic_error_t* error = nullptr;
-        const xcb_get_property_cookie_t property_cookie =
-            xcb_get_property(&x11_connection, false, *window,
-                             xcb_wm_state_property, XCB_ATOM_WINDOW, 0, 1);
         const std::unique_ptr<xcb_get_property_reply_t> property_reply(
             xcb_get_property_reply(&x11_connection, property_cookie, &error));
         if (error) {
             free(error);
-            continue;
+            return false;
         }
 
-        if (property_reply->type != XCB_NONE) {
-            return *window;
+        return property_reply->type != XCB_NONE;
+    };
+    const auto request_wm_state = [&](xcb_window_t window) {
+        return xcb_get_property(&x11_connection, false, window,
+                                xcb_wm_state_property, XCB_ATOM_WINDOW, 0, 1);
+    };
+
+    // If we already know at which depth the host's window is, then we'll only
+    // need to walk up that far. The root window is never a valid host window.
+    if (cached_host_window_depth) {
+        xcb_window_t window = starting_at;
+        bool reached_root = false;
+        for (size_t depth = 0; depth < *cached_host_window_depth; depth++) {
+            xcb_generic_error_t* error = nullptr;
+            const xcb_query_tree_cookie_t query_cookie =
+                xcb_query_tree(&x11_connection, window);
+            const std::unique_ptr<xcb_query_tree_reply_t> query_reply(
+                xcb_query_tree_reply(&x11_connection, query_cookie, &error));
+            THROW_X11_ERROR(error);
+
+            if (query_reply->parent == query_reply->root) {
+                reached_root = true;
+                break;
+            }
+
+            window = query_reply->parent;
+        }
+
+        if (!reached_root && has_wm_state(request_wm_state(window))) {
+            return window;
+        }
+    }
+
+    // See the docstring for why this works the way it does. All of the
+    // property requests are sent at once so we only have to wait for the
+    // server once.
+    const auto ancestors = find_ancestor_windows(x11_connection, starting_at);
+    llvm::SmallVector<xcb_get_property_cookie_t, 8> property_cookies;
+    for (const xcb_window_t window : ancestors) {
+        property_cookies.push_back(request_wm_state(window));
+    }
+
+    std::optional<xcb_window_t> host_window;
+    for (size_t depth = ancestors.size(); depth-- > 0;) {
+        if (host_window) {
+            xcb_discard_reply(&x11_connection,
+                              property_cookies[depth].sequence);
+        } else if (has_wm_state(property_cookies[depth])) {
+            host_window = ancestors[depth];
+            cached_host_window_depth = depth;
         }
     }
 
-    return std::nullopt;
+    return host_window;
 }
 
 bool is_child_window_or_same(
@@ -1366,11 +1755,119 @@ xcb_window_t get_root_window(xcb_connection_t& x11_connection,
     return query_reply->root;
 }
 
+std::optional<xcb_window_t> get_event_window(
+    const xcb_generic_event_t& generic_event) noexcept {
+    // These are all of the events editors select through the event masks at
+    // the top of this file
+    switch (generic_event.response_type & xcb_event_type_mask) {
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+            return reinterpret_cast<const xcb_key_press_event_t&>(generic_event)
+                .event;
+        case XCB_ENTER_NOTIFY:
+        case XCB_LEAVE_NOTIFY:
+            return reinterpret_cast<const xcb_enter_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_FOCUS_IN:
+        case XCB_FOCUS_OUT:
+            return reinterpret_cast<const xcb_focus_in_event_t&>(generic_event)
+                .event;
+        case XCB_VISIBILITY_NOTIFY:
+            return reinterpret_cast<const xcb_visibility_notify_event_t&>(
+                       generic_event)
+                .window;
+        case XCB_DESTROY_NOTIFY:
+            return reinterpret_cast<const xcb_destroy_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_UNMAP_NOTIFY:
+            return reinterpret_cast<const xcb_unmap_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_MAP_NOTIFY:
+            return reinterpret_cast<const xcb_map_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_REPARENT_NOTIFY:
+            return reinterpret_cast<const xcb_reparent_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_CONFIGURE_NOTIFY:
+            return reinterpret_cast<const xcb_configure_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_GRAVITY_NOTIFY:
+            return reinterpret_cast<const xcb_gravity_notify_event_t&>(
+                       generic_event)
+                .event;
+        case XCB_CIRCULATE_NOTIFY:
+            return reinterpret_cast<const xcb_circulate_notify_event_t&>(
+                       generic_event)
+                .event;
+        default:
+            return std::nullopt;
+    }
+}
+
 xcb_window_t get_x11_handle(HWND win32_handle) noexcept {
     return reinterpret_cast<size_t>(
         GetProp(win32_handle, "__wine_x11_whole_window"));
 }
 
+HWND create_editor_window(const Size& client_area, Editor* editor) noexcept {
+    // Create a window without any decoratiosn for easy embedding. The
+    // combination of `WS_EX_TOOLWINDOW` and `WS_POPUP` causes the window to be
+    // drawn without any decorations (making resizes behave as you'd expect)
+    // and also causes mouse coordinates to be relative to the window itself.
+    return CreateWindowEx(WS_EX_TOOLWINDOW,
+                          reinterpret_cast<LPCSTR>(get_window_class()),
+                          "yabridge plugin", WS_POPUP,
+                          // NOTE: With certain DEs/WMs (notably, Cinnamon),
+                          //       Wine does not render the window at all when
+                          //       using a primary display that's positioned to
+                          //       the right of another display. Presumably it
+                          //       tries to manually clip the client rendered
+                          //       client area to the physical display. During
+                          //       the reparenting and `fix_local_coordinates()`
+                          //       the window will be moved to `(0, 0)` anyways,
+                          //       but setting its initial position according
+                          //       to the primary display fixes these rendering
+                          //       issues.
+                          GetSystemMetrics(SM_XVIRTUALSCREEN),
+                          GetSystemMetrics(SM_YVIRTUALSCREEN),
+                          client_area.width, client_area.height, nullptr,
+                          nullptr, GetModuleHandle(nullptr), editor);
+}
+
+HWND take_or_create_editor_window(const Size& client_area,
+                                  Editor* editor,
+                                  Logger& logger) noexcept {
+    if (precreated_window) {
+        const HWND handle = precreated_window->handle;
+        precreated_window.reset();
+
+        // `WM_CREATE` did not have an editor to store yet when this window was
+        // created
+        SetWindowLongPtr(
+            handle, GWLP_USERDATA,
+            static_cast<LONG_PTR>(reinterpret_cast<size_t>(editor)));
+        logger.log_editor_trace(
+            []() { return "DEBUG: Using a precreated editor window"; });
+
+        return handle;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const HWND handle = create_editor_window(client_area, editor);
+    logger.log_editor_trace([&]() {
+        return "DEBUG: Created the editor window in " +
+               format_duration_ms(std::chrono::steady_clock::now() - start);
+    });
+
+    return handle;
+}
+
 ATOM get_window_class() noexcept {
     // Lazily iniitialize our window class
     static ATOM window_class_handle = 0;
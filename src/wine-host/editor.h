@@ -18,7 +18,11 @@
 
 #include <memory>
 #include <optional>
+#include <chrono>
+#include <deque>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 
 #include <windows.h>
 #include <function2/function2.hpp>
@@ -80,6 +84,93 @@ struct Size {
     uint16_t height;
 };
 
+// Forward declaration for `SharedX11Connection`
+class Editor;
+
+/**
+ * The X11 connection shared by all editors in this process. Every editor used
+ * to open its own connection, which with many open editors in a plugin group
+ * meant many connections to the X11 server each with their own event queue to
+ * drain.
+ * Instead, editors now share this connection and they select the events they
+ * are interested in through `select_events()`. `poll_events()` then reads all
+ * pending events from the connection and queues them for the editors that
+ * selected events on the window the event was reported on.
+ *
+ * This should only be used from the GUI thread. `WineXdndProxy` still has its
+ * own connection since it polls the X11 server from another thread while a
+ * drag-and-drop operation is active.
+ */
+class SharedX11Connection {
+   public:
+    /**
+     * Open a connection to the X11 server. Use `get()` instead.
+     */
+    SharedX11Connection();
+
+    /**
+     * Get the process's shared X11 connection. The connection is opened when
+     * the first editor gets opened, and it's closed again when the last editor
+     * and everything else holding on to the connection has been destroyed.
+     */
+    static std::shared_ptr<SharedX11Connection> get();
+
+    /**
+     * Select events on `window` for `editor`. The window's actual event mask
+     * will be the union of the masks selected by all editors. This does not
+     * include a flush.
+     */
+    void select_events(xcb_window_t window, Editor* editor, uint32_t mask);
+
+    /**
+     * Remove the events `editor` selected on `window`, if it selected any. This
+     * does not include a flush.
+     */
+    void deselect_events(xcb_window_t window, Editor* editor);
+
+    /**
+     * Remove all of `editor`'s event selections and drop any of its queued
+     * events. Should be called when the editor gets destroyed. This includes a
+     * flush.
+     */
+    void unregister(Editor* editor);
+
+    /**
+     * Read all pending events from the X11 connection and queue them for the
+     * editors that selected events on the window they were reported on. This
+     * does not block.
+     */
+    void poll_events();
+
+    /**
+     * Take the next event queued for `editor` by `poll_events()`. Returns a
+     * null pointer if there are no more events.
+     */
+    std::unique_ptr<xcb_generic_event_t> take_event(Editor* editor);
+
+    const std::shared_ptr<xcb_connection_t> x11_connection_;
+
+   private:
+    /**
+     * Apply the union of all event masks selected on `window`.
+     */
+    void update_event_mask(xcb_window_t window);
+
+    /**
+     * The event masks selected by each editor for every window.
+     */
+    std::unordered_map<xcb_window_t, std::unordered_map<Editor*, uint32_t>>
+        selections_;
+
+    /**
+     * Events read by `poll_events()` that haven't yet been handled by the
+     * editor they're queued for.
+     */
+    std::unordered_map<Editor*,
+                       std::deque<std::unique_ptr<xcb_generic_event_t>>>
+        queued_events_;
+};
+
 /**
  * A RAII wrapper around windows created using `CreateWindow()` that will post a
  * `WM_CLOSE` message to the window's message loop so it can clean itself up
@@ -158,6 +249,16 @@ class DeferredWin32Window {
  * window we created using `CreateWindowEx()`. We will need to manually resize
  * `wrapper_window` to match size changes coming from and going to the plugin
  * belonging to `wine_window`.
+ *
+ * NOTE: Everything related to editors is set up lazily when the first editor
+ *       gets opened. The `SharedX11Connection` is opened when the first
+ *       editor requests it, the window class is registered on demand in
+ *       `get_window_class()`, and the `WineXdndProxy` is created when the
+ *       first handle to it is requested.
+ *       Plugins whose editors never get opened thus don't pay for any of this.
+ *       The X11 connection Wine itself opens for its message loop cannot be
+ *       deferred since plugins may create hidden windows during
+ *       initialization.
  */
 class Editor {
    public:
@@ -188,10 +289,25 @@ class Editor {
         const size_t parent_window_handle,
         std::optional<fu2::unique_function<void()>> timer_proc = std::nullopt);
 
+    /**
+     * Remove this editor's event selections from the shared X11 connection.
+     */
+    ~Editor() noexcept;
+
+    Editor(const Editor&) = delete;
+    Editor& operator=(const Editor&) = delete;
+
     /**
      * Resize the `wrapper_window_` to this new size. We need to manually call
      * this whenever the plugin requests a resize, or when the host resizes the
      * window (using the plugin API). Before yabridge 3.5.0 this was implicit.
+     *
+     * While the window is being resized interactively, plugins and hosts can
+     * request many intermediate sizes per frame. Only the first resize in
+     * every event loop tick is applied directly. Any further resizes within
+     * that same tick are coalesced, and only the most recent size is applied
+     * on the next tick in `handle_x11_events()`. Resizing to the size the
+     * window already has does nothing.
      */
     void resize(uint16_t width, uint16_t height);
 
@@ -203,7 +319,20 @@ class Editor {
     void show() noexcept;
 
     /**
-     * Handle X11 events sent to the window our editor is embedded in.
+     * Create a hidden editor window ahead of time if there isn't one already,
+     * along with the shared X11 connection. The next editor that gets opened
+     * will adopt this window instead of creating a new one, and when an
+     * editor that was opened this way gets closed a new window will be
+     * created again. This is used for the `editor_precreate_window` option,
+     * and it should only be called from the GUI thread.
+     */
+    static void precreate_window() noexcept;
+
+    /**
+     * Handle X11 events sent to the window our editor is embedded in. This
+     * only queries the X11 server when one of the received events requires
+     * it, and the Wine window's local coordinates are fixed at most once per
+     * call.
      */
     void handle_x11_events() noexcept;
 
@@ -224,6 +353,12 @@ class Editor {
      */
     bool supports_ewmh_active_window() const;
 
+    /**
+     * Actually resize the window to `pending_size_`, if it is set. Called from
+     * `resize()` and on every event loop tick.
+     */
+    void apply_pending_resize();
+
     /**
      * Lie to the Wine window about its coordinates on the screen for
      * reparenting without using XEmbed. See the comment at the top of the
@@ -281,6 +416,27 @@ class Editor {
     const bool use_xembed_;
 
    private:
+    /**
+     * The X11 event mask for `host_window_`. This only includes
+     * `VisibilityNotify` events when XEmbed or the `editor_obscured_frame_rate`
+     * option needs them.
+     */
+    uint32_t host_event_mask() const noexcept;
+
+    /**
+     * The X11 event mask for `parent_window_`. This includes everything from
+     * `host_event_mask()`, since the two windows are often the same.
+     */
+    uint32_t parent_event_mask() const noexcept;
+
+    /**
+     * Switch `idle_timer_` between the normal and the obscured interval when
+     * the host's window gets obscured or `parent_window_` gets unmapped, or
+     * when the editor becomes visible again. This does nothing if the
+     * `editor_obscured_frame_rate` option is not set.
+     */
+    void update_obscured() noexcept;
+
     /**
      * Get the X11 event mask containing the current keyboard modifiers. Because
      * we don't want to link with `xcb-xkb` and we also can't really use
@@ -340,13 +496,38 @@ class Editor {
      */
     void do_xembed() const;
 
+    /**
+     * Whether a new window should be created ahead of time through
+     * `precreate_window()` when this editor gets closed. Set through the
+     * `editor_precreate_window` option.
+     */
+    const bool use_precreated_window_;
+
+    /**
+     * The application's main IO context, used to create a new window for the
+     * next editor after this editor gets closed.
+     */
+    MainContext& main_context_;
+
     /**
      * The logger instance we will print debug tracing information to.
      */
     Logger& logger_;
 
     /**
-     * Every editor window gets its own X11 connection.
+     * Keeps the event loop from backing off while this editor is open when the
+     * `event_loop_idle_backoff` option is enabled.
+     */
+    MainContext::OpenEditorGuard open_editor_guard_;
+
+    /**
+     * The X11 connection shared by all editors in this process. Events for this
+     * editor's windows are read through this.
+     */
+    std::shared_ptr<SharedX11Connection> shared_x11_connection_;
+
+    /**
+     * `shared_x11_connection_`'s underlying connection, for convenience.
      */
     std::shared_ptr<xcb_connection_t> x11_connection_;
 
@@ -373,6 +554,61 @@ class Editor {
      */
     DeferredWin32Window win32_window_;
 
+    /**
+     * The time at which the constructor finished embedding our windows into
+     * the host's window. Used to print how long the plugin took to open its
+     * editor when editor tracing is enabled.
+     */
+    std::chrono::steady_clock::time_point embedded_at_;
+
+    /**
+     * The interval for `idle_timer_` in milliseconds, based on `frame_rate`.
+     */
+    const unsigned int idle_timer_interval_ms_;
+
+    /**
+     * The interval for `idle_timer_` in milliseconds while the editor is
+     * obscured, based on `editor_obscured_frame_rate`. If that option is not
+     * set, then the editor will keep running at its normal rate.
+     *
+     * @see update_obscured
+     */
+    const std::optional<unsigned int> obscured_idle_timer_interval_ms_;
+
+    /**
+     * Whether the host's window is currently fully obscured or unmapped.
+     */
+    bool host_window_obscured_ = false;
+
+    /**
+     * Whether the host has hidden the editor by unmapping `parent_window_`.
+     */
+    bool parent_window_unmapped_ = false;
+
+    /**
+     * Whether either of the above is true, and `idle_timer_` is running at
+     * `obscured_idle_timer_interval_ms_`.
+     */
+    bool is_obscured_ = false;
+
+    /**
+     * The size `wrapper_window_` was last resized to in
+     * `apply_pending_resize()`. Used to skip redundant resizes.
+     */
+    std::optional<Size> current_size_;
+
+    /**
+     * The most recent size passed to `resize()` that has not been applied yet.
+     * This is applied and cleared on the next event loop tick.
+     */
+    std::optional<Size> pending_size_;
+
+    /**
+     * When we last resized `wrapper_window_`. A new size is only applied
+     * directly if at least one event loop tick has passed since then.
+     */
+    std::chrono::steady_clock::time_point last_resize_time_;
+
     /**
      * A timer we'll use to periodically run the X11 event loop plus
      * `idle_timer_proc_`, if that is set. We handle X11 events from within the
@@ -435,6 +671,24 @@ class Editor {
      */
     xcb_window_t host_window_;
 
+    /**
+     * The position and size from the last `ConfigureNotify` event we received
+     * for `host_window_`, `parent_window_`, and the wrapper window, along with
+     * whether that event was synthetic. Used in `handle_x11_events()` to skip
+     * events that can't have moved our window. This is cleared when
+     * `parent_window_` gets reparented.
+     */
+    std::unordered_map<
+        xcb_window_t,
+        std::optional<std::tuple<bool, int16_t, int16_t, uint16_t, uint16_t>>>
+        last_configure_geometry_;
+
+    /**
+     * The root window `parent_window_` is on, used in
+     * `fix_local_coordinates()`. This is queried once and then cached.
+     */
+    mutable std::optional<xcb_window_t> root_window_cache_;
+
     /**
      * The atom corresponding to `_NET_ACTIVE_WINDOW`.
      */
@@ -21,6 +21,7 @@
 #include <config.h>
 #include <version.h>
 
+#include "../common/realtime-allocation-check.h"
 #include "../common/utils.h"
 #include "bridges/group.h"
 #include "bridges/vst2.h"
@@ -59,7 +60,8 @@ int YABRIDGE_EXPORT
     // directory for the Unix domain socket endpoints to connect to and the
     // process ID of the process the native plugin is being hosted in as
     // arguments for yabridge-host.exe. Group host processes receive only a unix
-    // domain socket it should listen on.
+    // domain socket it should listen on, optionally followed by the number of
+    // seconds to wait for the first plugin before shutting down again.
     const bool is_group_host = (argc >= 3 && strcmp(argv[1], "group") == 0);
     if (!(is_group_host || argc >= 5)) {
         std::cerr << host_name << std::endl;
@@ -78,7 +80,8 @@ int YABRIDGE_EXPORT
 #else
                   << yabridge_host_name
 #endif
-                  << " group <unix_domain_socket>" << std::endl;
+                  << " group <unix_domain_socket> [<idle_timeout_seconds>]"
+                  << std::endl;
 
         return 1;
     }
@@ -95,9 +98,11 @@ int YABRIDGE_EXPORT
     // binary, but they have been merged since they share 95% of the same code.
     if (is_group_host) {
         const std::string group_socket_endpoint_path(argv[2]);
+        const std::chrono::seconds idle_timeout(argc >= 4 ? std::stoi(argv[3])
+                                                          : 5);
 
         try {
-            GroupBridge bridge(group_socket_endpoint_path);
+            GroupBridge bridge(group_socket_endpoint_path, idle_timeout);
 
             // Blocks the main thread until all plugins have exited
             bridge.handle_incoming_connections();
@@ -117,7 +122,11 @@ int YABRIDGE_EXPORT
         }
 
         // This shouldn't be needed, but sometimes with Wine background threads
-        // will be kept alive while this process exits
+        // will be kept alive while this process exits. This skips the static
+        // destructors, so queued log messages and the allocation profile need
+        // to be written first.
+        Logger::flush();
+        write_allocation_profile();
         TerminateProcess(GetCurrentProcess(), 0);
     } else {
         const std::string plugin_type_str(argv[1]);
@@ -141,13 +150,13 @@ int YABRIDGE_EXPORT
                 case PluginType::vst2:
                     bridge = std::make_unique<Vst2Bridge>(
                         main_context, plugin_location, socket_endpoint_path,
-                        parent_pid);
+                        true, parent_pid);
                     break;
                 case PluginType::vst3:
 #ifdef WITH_VST3
                     bridge = std::make_unique<Vst3Bridge>(
                         main_context, plugin_location, socket_endpoint_path,
-                        parent_pid);
+                        true, parent_pid);
 #else
                     std::cerr
                         << "This version of yabridge has not been compiled "
@@ -169,6 +178,8 @@ int YABRIDGE_EXPORT
 
             // See below, just returning from `main()` isn't enough to terminate
             // the process
+            Logger::flush();
+            write_allocation_profile();
             TerminateProcess(GetCurrentProcess(), 0);
 
             return 1;
@@ -193,6 +204,8 @@ int YABRIDGE_EXPORT
             //        'fixes' the issue.
             //
             //        https://github.com/robbert-vdh/yabridge/issues/69
+            Logger::flush();
+            write_allocation_profile();
             TerminateProcess(GetCurrentProcess(), 0);
         });
 
@@ -202,7 +215,7 @@ int YABRIDGE_EXPORT
         // Handle Win32 messages and X11 events on a timer, just like in
         // `GroupBridge::async_handle_events()``
         main_context.async_handle_events(
-            [&]() { bridge->handle_events(); },
+            [&]() { return bridge->handle_events(); },
             [&]() { return !bridge->inhibits_event_loop(); });
         main_context.run();
     }
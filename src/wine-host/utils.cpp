@@ -16,12 +16,71 @@
 
 #include "utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+
+#include <sched.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "bridges/common.h"
 
 using namespace std::literals::chrono_literals;
 
+namespace {
+
+/**
+ * Open a pidfd for a process, which becomes readable once that process exits.
+ * glibc only added a wrapper for this in version 2.36, so we'll do the syscall
+ * ourselves.
+ *
+ * @return The file descriptor, or -1 if the kernel does not support pidfds
+ *   (Linux 5.3 and up do) or if the process doesn't exist.
+ */
+int open_pidfd(pid_t pid) noexcept {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    return -1;
+#endif
+}
+
+/**
+ * The `ProcessCallbackTimer` for the block the calling thread is currently
+ * processing, if any.
+ */
+thread_local ProcessCallbackTimer* current_process_callback_timer = nullptr;
+
+/**
+ * This was added in Linux 6.4, and older kernel headers won't define it yet.
+ */
+#ifndef PR_SET_MEMORY_MERGE
+#define PR_SET_MEMORY_MERGE 67
+#endif
+
+/**
+ * Anonymous memory regions smaller than this are not worth advising the kernel
+ * about in `advise_anonymous_memory()`. Sample data is allocated in much
+ * larger chunks than this.
+ */
+constexpr size_t min_advised_region_size = 16 << 20;
+
+/**
+ * Whether `PR_SET_MEMORY_MERGE` has already enabled KSM for this entire
+ * process. In that case we don't need to mark individual regions as mergeable
+ * anymore.
+ */
+std::atomic_bool process_memory_merging_enabled = false;
+
+}  // namespace
+
 uint32_t WINAPI
 win32_thread_trampoline(fu2::unique_function<void()>* entry_point) {
     (*entry_point)();
@@ -50,6 +109,310 @@ Win32Thread& Win32Thread::operator=(Win32Thread&& o) noexcept {
     return *this;
 }
 
+Win32ThreadPool::Win32ThreadPool(size_t max_idle_workers)
+    : max_idle_workers_(max_idle_workers) {}
+
+Win32ThreadPool::~Win32ThreadPool() noexcept {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    has_work_.notify_all();
+
+    // The workers will exit once the queue is empty, and they're joined when
+    // their `Win32Thread`s get destroyed. The workers still need to lock the
+    // mutex before they exit, so we can't hold it here.
+    std::unordered_map<size_t, Win32Thread> workers;
+    {
+        std::lock_guard lock(mutex_);
+        workers = std::move(workers_);
+    }
+    workers.clear();
+}
+
+void Win32ThreadPool::submit(fu2::unique_function<void()> task) {
+    std::lock_guard lock(mutex_);
+    reap_finished_workers();
+
+    queue_.push_back(Task{.fn = std::move(task),
+                          .realtime_priority = get_realtime_priority()});
+    total_queued_.fetch_add(1, std::memory_order_relaxed);
+    if (queue_.size() > num_idle_workers_) {
+        const size_t worker_id = next_worker_id_++;
+        total_workers_.fetch_add(1, std::memory_order_relaxed);
+        workers_[worker_id] =
+            Win32Thread([this, worker_id]() { run_worker(worker_id); });
+    } else {
+        has_work_.notify_one();
+    }
+}
+
+size_t Win32ThreadPool::total_workers() noexcept {
+    return total_workers_.load(std::memory_order_relaxed);
+}
+
+size_t Win32ThreadPool::total_queued() noexcept {
+    return total_queued_.load(std::memory_order_relaxed);
+}
+
+void Win32ThreadPool::run_worker(size_t worker_id) {
+    pthread_setname_np(pthread_self(), "worker");
+
+    std::unique_lock lock(mutex_);
+    while (true) {
+        num_idle_workers_++;
+        has_work_.wait(lock, [&]() { return stopping_ || !queue_.empty(); });
+        num_idle_workers_--;
+        if (queue_.empty()) {
+            break;
+        }
+
+        Task task = std::move(queue_.front());
+        queue_.pop_front();
+        total_queued_.fetch_sub(1, std::memory_order_relaxed);
+        lock.unlock();
+
+        if (task.realtime_priority) {
+            set_realtime_priority(true, *task.realtime_priority);
+        } else {
+            set_realtime_priority(false);
+        }
+        task.fn();
+        // The function should be destroyed before we go idle again, since it
+        // may hold on to resources like sockets
+        task.fn = nullptr;
+
+        lock.lock();
+        if (num_idle_workers_ >= max_idle_workers_) {
+            break;
+        }
+    }
+
+    total_workers_.fetch_sub(1, std::memory_order_relaxed);
+    finished_worker_ids_.push_back(worker_id);
+}
+
+void Win32ThreadPool::reap_finished_workers() noexcept {
+    for (const size_t worker_id : finished_worker_ids_) {
+        // This waits for the thread to exit, which it will do right after
+        // releasing the mutex
+        workers_.erase(worker_id);
+    }
+    finished_worker_ids_.clear();
+}
+
+void AudioThreadScheduling::set_realtime_priority(int priority) noexcept {
+    realtime_priority_ = priority;
+    if (!uses_deadline_scheduling_ && !offline_) {
+        ::set_realtime_priority(true, realtime_priority_);
+    }
+}
+
+void AudioThreadScheduling::set_deadline_period(uint64_t period_ns) noexcept {
+    if (period_ns == deadline_period_ns_) {
+        return;
+    }
+    deadline_period_ns_ = period_ns;
+
+    // This will be applied when the host stops rendering offline
+    if (offline_) {
+        return;
+    }
+
+    const bool used_deadline_scheduling = uses_deadline_scheduling_;
+    uses_deadline_scheduling_ =
+        period_ns > 0 && set_deadline_scheduling(period_ns);
+    if (used_deadline_scheduling && !uses_deadline_scheduling_) {
+        ::set_realtime_priority(true, realtime_priority_);
+    }
+}
+
+void AudioThreadScheduling::set_offline(bool offline) noexcept {
+    if (offline == offline_) {
+        return;
+    }
+    offline_ = offline;
+
+    if (offline_) {
+        ::set_realtime_priority(false);
+        uses_deadline_scheduling_ = false;
+    } else {
+        uses_deadline_scheduling_ =
+            deadline_period_ns_ > 0 &&
+            set_deadline_scheduling(deadline_period_ns_);
+        if (!uses_deadline_scheduling_) {
+            ::set_realtime_priority(true, realtime_priority_);
+        }
+    }
+}
+
+ProcessCallbackTimer::ProcessCallbackTimer() noexcept
+    : previous_timer_(current_process_callback_timer) {
+    current_process_callback_timer = this;
+}
+
+ProcessCallbackTimer::~ProcessCallbackTimer() noexcept {
+    current_process_callback_timer = previous_timer_;
+}
+
+ProcessCallbackTimer::Callback::Callback(LatencyHistogram& histogram) noexcept
+    : timer_(current_process_callback_timer), histogram_(histogram) {
+    if (timer_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+ProcessCallbackTimer::Callback::~Callback() noexcept {
+    if (timer_) {
+        const auto duration = std::chrono::steady_clock::now() - start_;
+        timer_->elapsed_ += duration;
+        histogram_.record(duration);
+    }
+}
+
+/**
+ * The maximum number of host threads we'll keep track of in
+ * `HostAudioThreadMap`. Hosts may spawn new audio threads when the audio
+ * engine gets restarted, so we'll start over at some point to avoid growing
+ * indefinitely.
+ */
+constexpr size_t max_tracked_host_audio_threads = 512;
+
+HostAudioThreadMap& HostAudioThreadMap::get() {
+    static HostAudioThreadMap instance;
+    return instance;
+}
+
+void HostAudioThreadMap::pin_for_host_thread(
+    int host_thread_id,
+    std::optional<int>& last_host_thread_id,
+    const std::vector<int>& cpus) {
+    if (last_host_thread_id == host_thread_id) {
+        return;
+    }
+    last_host_thread_id = host_thread_id;
+
+    int cpu;
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = assigned_cpus_.find(host_thread_id);
+            it != assigned_cpus_.end()) {
+            cpu = it->second;
+        } else {
+            // The calling thread may already have been pinned to a single core,
+            // so we'll use the main thread's affinity mask instead. That thread
+            // ID is the same as the process ID.
+            if (cpus.empty() && !default_cpus_) {
+                default_cpus_.emplace();
+
+                cpu_set_t cpu_set;
+                CPU_ZERO(&cpu_set);
+                if (sched_getaffinity(getpid(), sizeof(cpu_set), &cpu_set) ==
+                    0) {
+                    for (int i = 0; i < CPU_SETSIZE; i++) {
+                        if (CPU_ISSET(i, &cpu_set)) {
+                            default_cpus_->push_back(i);
+                        }
+                    }
+                }
+            }
+
+            const std::vector<int>& available_cpus =
+                cpus.empty() ? *default_cpus_ : cpus;
+            if (available_cpus.empty()) {
+                return;
+            }
+
+            if (assigned_cpus_.size() >= max_tracked_host_audio_threads) {
+                assigned_cpus_.clear();
+            }
+
+            cpu = available_cpus[num_assigned_++ % available_cpus.size()];
+            assigned_cpus_[host_thread_id] = cpu;
+        }
+    }
+
+    set_audio_thread_affinity(cpus, cpu);
+}
+
+IdleBufferRelease::IdleBufferRelease() noexcept
+    : last_processed_(std::chrono::steady_clock::now()) {}
+
+std::unique_lock<std::mutex> IdleBufferRelease::begin_processing(
+    std::optional<AudioShmBuffer>& buffers) noexcept {
+    std::unique_lock lock(mutex_);
+    last_processed_ = std::chrono::steady_clock::now();
+    if (buffers) {
+        buffers->restore_memory();
+    }
+
+    return lock;
+}
+
+void IdleBufferRelease::release_if_idle(
+    std::optional<AudioShmBuffer>& buffers,
+    std::chrono::steady_clock::duration timeout) noexcept {
+    std::unique_lock lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || !buffers ||
+        std::chrono::steady_clock::now() - last_processed_ < timeout) {
+        return;
+    }
+
+    // This is a no-op if the memory has already been released
+    buffers->release_memory();
+}
+
+void advise_anonymous_memory(bool mergeable, bool huge_pages) noexcept {
+    if (mergeable && !process_memory_merging_enabled) {
+        process_memory_merging_enabled =
+            prctl(PR_SET_MEMORY_MERGE, 1, 0, 0, 0) == 0;
+    }
+
+    const bool mark_mergeable = mergeable && !process_memory_merging_enabled;
+    if (!mark_mergeable && !huge_pages) {
+        return;
+    }
+
+    // The fields are `start-end perms offset dev inode [path]`. We're only
+    // interested in private writable mappings that aren't backed by a file.
+    std::ifstream maps_file("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps_file, line)) {
+        std::istringstream fields(line);
+        std::string range, perms, offset, device, path;
+        uint64_t inode = 1;
+        if (!(fields >> range >> perms >> offset >> device >> inode)) {
+            continue;
+        }
+        fields >> path;
+        if (inode != 0 || perms.size() < 4 || perms[0] != 'r' ||
+            perms[1] != 'w' || perms[3] != 'p' ||
+            !(path.empty() || path == "[heap]")) {
+            continue;
+        }
+
+        char* range_end = nullptr;
+        const uintptr_t start = std::strtoull(range.c_str(), &range_end, 16);
+        if (*range_end != '-') {
+            continue;
+        }
+        const uintptr_t end = std::strtoull(range_end + 1, nullptr, 16);
+        if (end <= start || end - start < min_advised_region_size) {
+            continue;
+        }
+
+        // These may fail for some regions, and since this is only advice
+        // that's fine. Regions that have already been marked are unaffected.
+        void* address = reinterpret_cast<void*>(start);
+        if (mark_mergeable) {
+            madvise(address, end - start, MADV_MERGEABLE);
+        }
+        if (huge_pages) {
+            madvise(address, end - start, MADV_HUGEPAGE);
+        }
+    }
+}
+
 Win32Timer::Win32Timer() noexcept {}
 
 Win32Timer::Win32Timer(HWND window_handle,
@@ -78,10 +441,18 @@ Win32Timer& Win32Timer::operator=(Win32Timer&& o) noexcept {
     return *this;
 }
 
+void Win32Timer::set_interval(unsigned int interval_ms) noexcept {
+    // Calling `SetTimer()` again with the same ID replaces the existing timer
+    if (timer_id_) {
+        SetTimer(window_handle_, *timer_id_, interval_ms, nullptr);
+    }
+}
+
 MainContext::MainContext()
     : context_(),
       events_timer_(context_),
       watchdog_context_(),
+      watchdog_work_guard_(asio::make_work_guard(watchdog_context_)),
       watchdog_timer_(watchdog_context_) {}
 
 void MainContext::run() {
@@ -99,12 +470,9 @@ void MainContext::run() {
                   << std::endl;
         std::cerr << "         against dangling processes." << std::endl;
     } else {
-        // To account for hosts terminating before the bridged plugin has
-        // initialized, we'll do the first watchdog check five seconds. After
-        // this we'll run the timer on a 30 second interval.
-        async_handle_watchdog_timer(5s);
-
-        watchdog_handler_ = Win32Thread([&]() {
+        // The actual waiting happens in `register_watchdog()`, this thread
+        // only needs to be running
+        watchdog_handler_ = Win32Thread(Win32Thread::small_stack_size, [&]() {
             pthread_setname_np(pthread_self(), "watchdog");
 
             watchdog_context_.run();
@@ -125,19 +493,40 @@ void MainContext::stop() noexcept {
 }
 
 void MainContext::update_timer_interval(
-    std::chrono::steady_clock::duration new_interval) noexcept {
+    std::chrono::steady_clock::duration new_interval,
+    bool idle_backoff) noexcept {
     timer_interval_ = new_interval;
+    current_timer_interval_ = new_interval;
+    idle_backoff_ = idle_backoff_.value_or(true) && idle_backoff;
 }
 
-MainContext::WatchdogGuard::WatchdogGuard(
-    HostBridge& bridge,
-    std::unordered_set<HostBridge*>& watched_bridges,
-    std::mutex& watched_bridges_mutex)
+MainContext::OpenEditorGuard::OpenEditorGuard(MainContext& main_context)
+    : main_context_(main_context) {
+    main_context_.num_open_editors_++;
+
+    // If the event loop is currently backing off, then we'll handle events
+    // right away
+    if (main_context_.current_timer_interval_ >
+        main_context_.timer_interval_) {
+        main_context_.current_timer_interval_ = main_context_.timer_interval_;
+        main_context_.wake_up_requested_ = true;
+        main_context_.events_timer_.expires_at(
+            std::chrono::steady_clock::now());
+    }
+}
+
+MainContext::OpenEditorGuard::~OpenEditorGuard() noexcept {
+    main_context_.num_open_editors_--;
+}
+
+MainContext::WatchdogGuard::WatchdogGuard(HostBridge& bridge,
+                                          WatchedBridges& watched_bridges,
+                                          std::mutex& watched_bridges_mutex)
     : bridge_(&bridge),
       watched_bridges_(watched_bridges),
       watched_bridges_mutex_(watched_bridges_mutex) {
     std::lock_guard lock(watched_bridges_mutex);
-    watched_bridges.insert(&bridge);
+    watched_bridges.emplace(&bridge, nullptr);
 }
 
 MainContext::WatchdogGuard::~WatchdogGuard() noexcept {
@@ -164,10 +553,150 @@ MainContext::WatchdogGuard& MainContext::WatchdogGuard::operator=(
     return *this;
 }
 
-MainContext::WatchdogGuard MainContext::register_watchdog(HostBridge& bridge) {
+MainContext::WatchdogGuard MainContext::register_watchdog(HostBridge& bridge,
+                                                          pid_t parent_pid) {
     // The guard's constructor and destructor will handle actually registering
     // and unregistering the bridge from `watched_bridges`
-    return WatchdogGuard(bridge, watched_bridges_, watched_bridges_mutex_);
+    WatchdogGuard guard(bridge, watched_bridges_, watched_bridges_mutex_);
+    if (is_watchdog_timer_disabled()) {
+        return guard;
+    }
+
+    std::lock_guard lock(watched_bridges_mutex_);
+    if (const int pidfd = open_pidfd(parent_pid); pidfd != -1) {
+        // The pidfd becomes readable when the host process exits. If the
+        // bridge has already been unregistered at that point, then the
+        // descriptor will have been destroyed and we'll get an error instead.
+        auto& descriptor = watched_bridges_[&bridge] =
+            std::make_unique<asio::posix::stream_descriptor>(watchdog_context_,
+                                                             pidfd);
+        descriptor->async_wait(
+            asio::posix::stream_descriptor::wait_read,
+            [this, bridge_ptr = &bridge](const std::error_code& error) {
+                if (error) {
+                    return;
+                }
+
+                std::lock_guard lock(watched_bridges_mutex_);
+                if (watched_bridges_.contains(bridge_ptr)) {
+                    bridge_ptr->shutdown_if_dangling();
+                }
+            });
+    } else {
+        // This can happen on kernels older than Linux 5.3, or when the host
+        // runs in another PID namespace. In that case we'll poll the process
+        // on a timer instead. The first check happens after five seconds to
+        // account for hosts terminating before the bridged plugin has
+        // initialized. After this we'll run the timer on a 30 second interval.
+        asio::post(watchdog_context_, [this]() {
+            if (!watchdog_timer_active_) {
+                watchdog_timer_active_ = true;
+                async_handle_watchdog_timer(5s);
+            }
+        });
+    }
+
+    return guard;
+}
+
+MainContext::FileWatchGuard::FileWatchGuard(MainContext& main_context,
+                                            size_t watch_id) noexcept
+    : main_context_(main_context), watch_id_(watch_id) {}
+
+MainContext::FileWatchGuard::~FileWatchGuard() noexcept {
+    std::lock_guard lock(main_context_.file_watches_mutex_);
+    auto& file_watches = main_context_.file_watches_;
+    const auto watch = file_watches.find(watch_id_);
+    if (watch == file_watches.end()) {
+        return;
+    }
+
+    // Other files in the same directory may still be using the same inotify
+    // watch
+    const int watch_descriptor = watch->second.watch_descriptor;
+    file_watches.erase(watch);
+    if (std::none_of(file_watches.begin(), file_watches.end(),
+                     [&](const auto& other) {
+                         return other.second.watch_descriptor ==
+                                watch_descriptor;
+                     })) {
+        inotify_rm_watch(main_context_.inotify_descriptor_->native_handle(),
+                         watch_descriptor);
+    }
+}
+
+std::unique_ptr<MainContext::FileWatchGuard> MainContext::watch_file(
+    const ghc::filesystem::path& path,
+    fu2::unique_function<void()> callback) {
+    std::lock_guard lock(file_watches_mutex_);
+    if (!inotify_descriptor_) {
+        const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd == -1) {
+            return nullptr;
+        }
+
+        inotify_descriptor_.emplace(context_, inotify_fd);
+        async_handle_file_events();
+    }
+
+    // Editors that replace the file instead of writing to it will cause an
+    // `IN_MOVED_TO` event instead of an `IN_CLOSE_WRITE` event
+    const int watch_descriptor =
+        inotify_add_watch(inotify_descriptor_->native_handle(),
+                          path.parent_path().c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor == -1) {
+        return nullptr;
+    }
+
+    const size_t watch_id = next_file_watch_id_++;
+    file_watches_.emplace(
+        watch_id, FileWatch{.watch_descriptor = watch_descriptor,
+                            .file_name = path.filename().string(),
+                            .callback = std::move(callback)});
+
+    return std::make_unique<FileWatchGuard>(*this, watch_id);
+}
+
+void MainContext::async_handle_file_events() {
+    inotify_descriptor_->async_wait(
+        asio::posix::stream_descriptor::wait_read,
+        [&](const std::error_code& error) {
+            if (error) {
+                return;
+            }
+
+            std::lock_guard lock(file_watches_mutex_);
+
+            // Saving a file can generate multiple events, but we only want to
+            // run the callbacks once
+            std::unordered_set<size_t> triggered_watches;
+            alignas(inotify_event) char buffer[4096];
+            ssize_t bytes_read;
+            while ((bytes_read = read(inotify_descriptor_->native_handle(),
+                                      buffer, sizeof(buffer))) > 0) {
+                for (ssize_t offset = 0; offset < bytes_read;) {
+                    const auto event =
+                        reinterpret_cast<const inotify_event*>(buffer + offset);
+                    if (event->len > 0) {
+                        for (const auto& [watch_id, watch] : file_watches_) {
+                            if (watch.watch_descriptor == event->wd &&
+                                watch.file_name == event->name) {
+                                triggered_watches.insert(watch_id);
+                            }
+                        }
+                    }
+
+                    offset += sizeof(inotify_event) + event->len;
+                }
+            }
+
+            for (const size_t watch_id : triggered_watches) {
+                file_watches_.at(watch_id).callback();
+            }
+
+            async_handle_file_events();
+        });
 }
 
 void MainContext::async_handle_watchdog_timer(
@@ -183,12 +712,21 @@ void MainContext::async_handle_watchdog_timer(
         // When the `WatchdogGuard` field on `HostBridge` gets destroyed, that
         // bridge instance will be removed from `watched_bridges`. So if our
         // call to `HostBridge::shutdown_if_dangling()` shuts the plugin down,
-        // the instance will be removed after this lambda exits.
+        // the instance will be removed after this lambda exits. Bridges with
+        // a pidfd don't need to be polled.
         std::lock_guard lock(watched_bridges_mutex_);
-        for (auto& bridge : watched_bridges_) {
-            bridge->shutdown_if_dangling();
+        bool has_polled_bridges = false;
+        for (auto& [bridge, pidfd] : watched_bridges_) {
+            if (!pidfd) {
+                has_polled_bridges = true;
+                bridge->shutdown_if_dangling();
+            }
         }
 
-        async_handle_watchdog_timer(30s);
+        if (has_polled_bridges) {
+            async_handle_watchdog_timer(30s);
+        } else {
+            watchdog_timer_active_ = false;
+        }
     });
 }
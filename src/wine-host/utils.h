@@ -18,20 +18,34 @@
 
 #include "asio-fix.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <windows.h>
 #include <asio/dispatch.hpp>
+#include <asio/executor_work_guard.hpp>
 #include <asio/io_context.hpp>
+#include <asio/posix/stream_descriptor.hpp>
 #include <function2/function2.hpp>
+#include <ghc/filesystem.hpp>
 
+#include "../common/audio-shm.h"
+#include "../common/logging/histograms.h"
 #include "../common/utils.h"
 
 // Forward declaration for use in our watchdog in `MainContext`
 class HostBridge;
+class Win32ThreadPool;
 
 /**
  * A proxy function that calls `Win32Thread::entry_point` since `CreateThread()`
@@ -63,10 +77,42 @@ win32_thread_trampoline(fu2::unique_function<void()>* entry_point);
  * @note This should be used instead of `std::thread` or `std::jthread` whenever
  *   the thread directly calls third party library code, i.e. `LoadLibrary()`,
  *   `FreeLibrary()`, the plugin's entry point, or any of the `AEffect::*()`
- *   functions.
+ *   functions. The same applies to threads that call Win32 APIs, or that spawn
+ *   `Win32Thread`s themselves. Threads that only run yabridge's own code
+ *   without touching Win32 APIs, like the group host's STDIO handler, can use
+ *   a regular `std::jthread` instead. Those are much cheaper to create and
+ *   don't have to be registered with the wineserver.
  */
 class Win32Thread {
    public:
+    /**
+     * Creating Win32 threads is much more expensive than creating regular
+     * pthreads, so `AdHocSocketHandler::receive_multi()` will use this pool to
+     * handle secondary requests instead of spawning a new thread for every
+     * request.
+     */
+    using Pool = Win32ThreadPool;
+
+    /**
+     * The amount of stack space to reserve for a thread. Passing this as the
+     * first argument to the constructor overrides the default stack size, which
+     * is the 1 MiB (or whatever the executable's PE header says) that Windows
+     * threads get by default. A value of zero uses that default.
+     */
+    struct StackSize {
+        size_t bytes;
+    };
+
+    /**
+     * A stack size for threads that only run yabridge's own code, like the
+     * watchdog and the XDND proxy's polling loop, but that still need to be
+     * Win32 threads because they call Win32 APIs. These threads never call
+     * into the plugin, so they don't need to reserve as much address space as
+     * threads that can end up running arbitrary plugin code. Those should
+     * always use the default stack size.
+     */
+    static constexpr StackSize small_stack_size{256 * 1024};
+
     /**
      * Constructor that does not start any thread yet.
      */
@@ -81,9 +127,25 @@ class Win32Thread {
      */
     template <typename Function, typename... Args>
     Win32Thread(Function fn, Args... args)
+        : Win32Thread(StackSize{0}, std::move(fn), std::move(args)...) {}
+
+    /**
+     * The same as the above constructor, but with an explicit stack size. This
+     * only reserves the stack space, pages are still committed on demand.
+     *
+     * @param stack_size The amount of stack space to reserve for the thread.
+     *   This should only be smaller than the default for threads that don't run
+     *   any plugin code.
+     * @param entry_point The thread entry point that should be run.
+     * @param parameter The parameter passed to the entry point function.
+     *
+     * @see small_stack_size
+     */
+    template <typename Function, typename... Args>
+    Win32Thread(StackSize stack_size, Function fn, Args... args)
         : handle_(CreateThread(
                       nullptr,
-                      0,
+                      stack_size.bytes,
                       reinterpret_cast<LPTHREAD_START_ROUTINE>(
                           win32_thread_trampoline),
                       // `std::function` does not support functions with move
@@ -96,7 +158,8 @@ class Win32Thread {
                            ... args = std::move(args)]() mutable {
                               f(std::move(args)...);
                           }),
-                      0,
+                      stack_size.bytes > 0 ? STACK_SIZE_PARAM_IS_A_RESERVATION
+                                           : 0,
                       nullptr),
                   CloseHandle) {}
 
@@ -127,6 +190,323 @@ class Win32Thread {
 #pragma GCC diagnostic pop
 };
 
+/**
+ * A pool of reusable `Win32Thread`s for running short lived tasks without
+ * having to call `CreateThread()` every time. Tasks submitted to this pool
+ * always start right away: if no worker is currently idle, then a new worker
+ * will be spawned. This is important because the tasks we run here may block
+ * on each other through mutually recursive function calls, so they can never
+ * wait for another task to finish. After finishing its task a worker will wait
+ * for more work, unless there are already `max_idle_workers` idle workers in
+ * which case it exits.
+ *
+ * Every task runs with the scheduling priority of the thread that submitted
+ * it, just like it would have if it were run on a newly spawned thread. This
+ * also prevents a task changing its thread's priority from affecting later
+ * tasks.
+ */
+class Win32ThreadPool {
+   public:
+    /**
+     * @param max_idle_workers The maximum number of idle workers to keep
+     *   around.
+     */
+    explicit Win32ThreadPool(size_t max_idle_workers = 8);
+
+    /**
+     * Let the workers finish all pending tasks, and then join them.
+     */
+    ~Win32ThreadPool() noexcept;
+
+    Win32ThreadPool(const Win32ThreadPool&) = delete;
+    Win32ThreadPool& operator=(const Win32ThreadPool&) = delete;
+
+    /**
+     * Run a task on one of the pool's workers, spawning a new worker if they
+     * are all busy.
+     */
+    void submit(fu2::unique_function<void()> task);
+
+    /**
+     * The number of worker threads currently alive in all of this process'
+     * pools, both busy and idle. This is shown on the group host's metrics
+     * endpoint.
+     */
+    static size_t total_workers() noexcept;
+
+    /**
+     * The number of tasks in all of this process' pools that have been
+     * submitted but that have not yet been picked up by a worker.
+     */
+    static size_t total_queued() noexcept;
+
+   private:
+    /**
+     * A submitted task, along with the scheduling priority of the thread that
+     * submitted it.
+     */
+    struct Task {
+        fu2::unique_function<void()> fn;
+        std::optional<int> realtime_priority;
+    };
+
+    /**
+     * The worker loop. Runs tasks from `queue_` until the pool gets destroyed,
+     * or until there are too many idle workers.
+     */
+    void run_worker(size_t worker_id);
+
+    /**
+     * Join and remove workers that have exited. Should be called while holding
+     * `mutex_`.
+     */
+    void reap_finished_workers() noexcept;
+
+    const size_t max_idle_workers_;
+
+    std::mutex mutex_;
+    std::condition_variable has_work_;
+
+    std::deque<Task> queue_;
+    std::unordered_map<size_t, Win32Thread> workers_;
+    size_t next_worker_id_ = 0;
+    size_t num_idle_workers_ = 0;
+    /**
+     * Workers add their ID here right before they exit, so the thread can be
+     * joined the next time a task gets submitted.
+     */
+    std::vector<size_t> finished_worker_ids_;
+    bool stopping_ = false;
+
+    /**
+     * @see total_workers
+     */
+    static inline std::atomic_size_t total_workers_{0};
+    /**
+     * @see total_queued
+     */
+    static inline std::atomic_size_t total_queued_{0};
+};
+
+/**
+ * Keeps track of the scheduling policy used for one of the Wine plugin host's
+ * audio threads. These threads normally use `SCHED_FIFO` with a priority that's
+ * periodically synchronized with the host's audio thread, but with the
+ * `audio_thread_sched_deadline` option they are switched to `SCHED_DEADLINE`
+ * once the block size and sample rate are known. If that fails, the thread
+ * stays on (or goes back to) `SCHED_FIFO`. With the
+ * `offline_render_non_realtime` option the thread uses `SCHED_OTHER` while the
+ * host renders offline. This should only be used from the audio thread it
+ * belongs to.
+ */
+class AudioThreadScheduling {
+   public:
+    /**
+     * Use a new realtime priority synchronized from the host's audio thread.
+     * This priority is only applied when the thread is not using
+     * `SCHED_DEADLINE`, but it is remembered for when we fall back to
+     * `SCHED_FIFO`.
+     */
+    void set_realtime_priority(int priority) noexcept;
+
+    /**
+     * Switch to `SCHED_DEADLINE` with a period of `period_ns`. If `period_ns`
+     * is 0 or if the kernel refuses the new parameters, then the thread will
+     * use `SCHED_FIFO` again. Does nothing if the period has not changed.
+     *
+     * @see ::set_deadline_scheduling
+     */
+    void set_deadline_period(uint64_t period_ns) noexcept;
+
+    /**
+     * Switch to `SCHED_OTHER` while `offline` is true. The priority and period
+     * passed to the functions above are remembered in the meantime, and they
+     * will be applied again when this is called with `offline` set to false.
+     * Does nothing if the mode has not changed.
+     */
+    void set_offline(bool offline) noexcept;
+
+    /**
+     * Whether the thread is currently using `SCHED_DEADLINE`.
+     */
+    inline bool uses_deadline_scheduling() const noexcept {
+        return uses_deadline_scheduling_;
+    }
+
+   private:
+    /**
+     * The last priority synchronized from the host. The default matches the
+     * default for `::set_realtime_priority()`.
+     */
+    int realtime_priority_ = 5;
+    uint64_t deadline_period_ns_ = 0;
+    bool uses_deadline_scheduling_ = false;
+    bool offline_ = false;
+};
+
+/**
+ * Measures how long the calling thread spends waiting on host callbacks while
+ * it processes a block of audio. This is part of the `BlockTimings` reported to
+ * the native plugin and of the per-instance `ProcessingStats`. Create one of
+ * these around the plugin's processing function, and wrap every host callback
+ * in a `ProcessCallbackTimer::Callback`. Callbacks made from threads that
+ * aren't currently processing audio are not counted, and counting them costs
+ * nothing more than a thread local read.
+ */
+class ProcessCallbackTimer {
+   public:
+    ProcessCallbackTimer() noexcept;
+    ~ProcessCallbackTimer() noexcept;
+
+    ProcessCallbackTimer(const ProcessCallbackTimer&) = delete;
+    ProcessCallbackTimer& operator=(const ProcessCallbackTimer&) = delete;
+
+    /**
+     * The time spent in host callbacks since this object was created.
+     */
+    inline std::chrono::nanoseconds elapsed() const noexcept {
+        return elapsed_;
+    }
+
+    /**
+     * Adds the time between construction and destruction to the calling
+     * thread's active `ProcessCallbackTimer`, if it has one. The time is then
+     * also recorded in `histogram`, so the latency histograms show which host
+     * callbacks plugins block on during audio processing.
+     *
+     * @see vst2_process_callback_histogram
+     * @see vst3_process_callback_histogram
+     */
+    class Callback {
+       public:
+        explicit Callback(LatencyHistogram& histogram) noexcept;
+        ~Callback() noexcept;
+
+        Callback(const Callback&) = delete;
+        Callback& operator=(const Callback&) = delete;
+
+       private:
+        ProcessCallbackTimer* timer_;
+        LatencyHistogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+   private:
+    std::chrono::nanoseconds elapsed_{};
+    /**
+     * The thread's previous timer, restored when this one is destroyed.
+     */
+    ProcessCallbackTimer* previous_timer_;
+};
+
+/**
+ * Assigns every distinct host audio thread a CPU core, for the
+ * `audio_thread_host_mapping` option. There's a single instance of this per
+ * Wine plugin host process, so in a plugin group the audio threads of all
+ * plugin instances that are processed by the same host audio thread will end
+ * up on the same core. Those threads never run at the same time since the
+ * host processes them one after the other, so this keeps them cache-warm and
+ * it keeps them from competing with the audio threads working for the host's
+ * other audio threads.
+ */
+class HostAudioThreadMap {
+   public:
+    /**
+     * Get the process-wide instance.
+     */
+    static HostAudioThreadMap& get();
+
+    /**
+     * Pin the calling thread to the CPU core assigned to `host_thread_id`
+     * if the calling thread was last pinned for a different host thread.
+     * Cores are assigned round robin from `cpus`, or from the process'
+     * affinity mask if `cpus` is empty. This only takes a lock when the host
+     * thread changes, which normally only happens a handful of times.
+     *
+     * @param host_thread_id The thread ID of the host's audio thread that made
+     *   the current processing call.
+     * @param last_host_thread_id The host thread ID the calling thread was
+     *   last pinned for. This will be updated by this function.
+     * @param cpus The cores from the `audio_thread_cpus` option.
+     */
+    void pin_for_host_thread(int host_thread_id,
+                             std::optional<int>& last_host_thread_id,
+                             const std::vector<int>& cpus);
+
+   private:
+    HostAudioThreadMap() = default;
+
+    /**
+     * The cores assigned to every host thread ID we've seen.
+     */
+    std::unordered_map<int, int> assigned_cpus_;
+    /**
+     * The number of cores we've assigned so far, used to round robin over the
+     * available cores.
+     */
+    size_t num_assigned_ = 0;
+    /**
+     * The cores from the process' affinity mask, used when the
+     * `audio_thread_cpus` option is not set. Queried on first use.
+     */
+    std::optional<std::vector<int>> default_cpus_;
+    std::mutex mutex_;
+};
+
+/**
+ * Keeps track of when a plugin instance last processed audio so the memory
+ * backing its shared audio buffers can be given back to the kernel after it
+ * has been idle for a while, for the `audio_buffer_idle_release_s` option.
+ * Hosts like REAPER stop calling the processing function for silent tracks,
+ * and in large templates those instances' buffers would otherwise stay locked
+ * in memory. The buffers are restored transparently by the next processing
+ * call. The audio thread holds a lock while it processes audio or while it
+ * (re)creates the buffers, and the main thread only tries to take that lock,
+ * so the audio thread never has to wait for more than a single release.
+ */
+class IdleBufferRelease {
+   public:
+    IdleBufferRelease() noexcept;
+
+    IdleBufferRelease(const IdleBufferRelease&) = delete;
+    IdleBufferRelease& operator=(const IdleBufferRelease&) = delete;
+
+    /**
+     * Called before the buffers are accessed or before they are created or
+     * resized. This restores the buffers' memory if it was released. The
+     * returned lock should be held until the plugin has finished processing,
+     * or until the buffers have been set up.
+     */
+    std::unique_lock<std::mutex> begin_processing(
+        std::optional<AudioShmBuffer>& buffers) noexcept;
+
+    /**
+     * Release the buffers' memory if the plugin has not processed any audio
+     * for at least `timeout`. Called periodically from the main thread. This
+     * does nothing when the audio thread is currently processing audio or
+     * when the buffers have not been set up yet.
+     */
+    void release_if_idle(std::optional<AudioShmBuffer>& buffers,
+                         std::chrono::steady_clock::duration timeout) noexcept;
+
+   private:
+    std::chrono::steady_clock::time_point last_processed_;
+    std::mutex mutex_;
+};
+
+/**
+ * Advise the kernel about the large private anonymous memory regions in this
+ * process, for the `memory_merging` and `memory_huge_pages` options. With
+ * `mergeable` these regions can be deduplicated through kernel same-page
+ * merging (KSM), so group hosts that each load the same sample library can
+ * share the identical decoded sample data. On Linux 6.4 and up this enables
+ * merging for the entire process, including for memory allocated later. With
+ * `huge_pages` these regions are backed by transparent huge pages when
+ * possible. Since plugins keep allocating memory, this should be called
+ * periodically. Shared memory mappings like our audio buffers are left alone.
+ */
+void advise_anonymous_memory(bool mergeable, bool huge_pages) noexcept;
+
 /**
  * A simple RAII wrapper around `SetTimer`. Does not support timer procs since
  * we don't use them.
@@ -146,11 +526,24 @@ class Win32Timer {
     Win32Timer(Win32Timer&&) noexcept;
     Win32Timer& operator=(Win32Timer&&) noexcept;
 
+    /**
+     * Change the timer's interval. This resets the timer, so the next tick
+     * will happen `interval_ms` milliseconds from now. Does nothing for
+     * default constructed timers.
+     */
+    void set_interval(unsigned int interval_ms) noexcept;
+
    private:
     HWND window_handle_;
     std::optional<size_t> timer_id_;
 };
 
+/**
+ * The longest interval the event loop will back off to while it's idle when the
+ * `event_loop_idle_backoff` option is enabled.
+ */
+constexpr std::chrono::milliseconds max_idle_event_loop_interval(500);
+
 /**
  * A wrapper around `asio::io_context()` to serve as the application's
  * main IO context, run from the GUI thread. A single instance is shared for all
@@ -162,7 +555,10 @@ class Win32Timer {
  * a watchdog to shutdown a plugin instance's sockets when the process that
  * spawned it is no longer active. This approach also works with plugin groups
  * since closing a plugin's sockets will only cause that one plugin to
- * terminate.
+ * terminate. The watchdog waits on a pidfd for every native host process, so
+ * it reacts immediately when a host exits and it doesn't do any work in the
+ * meantime. We'll only fall back to periodically polling the process when the
+ * kernel doesn't support pidfds.
  */
 class MainContext {
    public:
@@ -184,9 +580,43 @@ class MainContext {
      * Set a new timer interval. We'll do this whenever a new plugin loads,
      * because we can't know in advance what the plugin's frame rate option is
      * set to.
+     *
+     * @param new_interval The new interval, based on the plugin's `frame_rate`
+     *   option.
+     * @param idle_backoff The plugin's `event_loop_idle_backoff` option. The
+     *   event loop will only back off when all plugins hosted in this process
+     *   have enabled this.
+     */
+    void update_timer_interval(std::chrono::steady_clock::duration new_interval,
+                               bool idle_backoff) noexcept;
+
+    /**
+     * Keeps the event loop running at its full rate while a plugin editor is
+     * open, for the `event_loop_idle_backoff` option. Opening an editor also
+     * wakes up the event loop immediately. Editors are created and destroyed on
+     * the GUI thread, so this should only be used from there.
+     */
+    class OpenEditorGuard {
+       public:
+        OpenEditorGuard(MainContext& main_context);
+        ~OpenEditorGuard() noexcept;
+
+        OpenEditorGuard(const OpenEditorGuard&) = delete;
+        OpenEditorGuard& operator=(const OpenEditorGuard&) = delete;
+
+       private:
+        MainContext& main_context_;
+    };
+
+    /**
+     * The bridges watched by our watchdog, along with a pidfd for the native
+     * host process. The descriptor is a null pointer if we could not open a
+     * pidfd for the process, in which case the bridge will be polled instead.
+     * Destroying the descriptor also cancels the pending wait on it.
      */
-    void update_timer_interval(
-        std::chrono::steady_clock::duration new_interval) noexcept;
+    using WatchedBridges =
+        std::unordered_map<HostBridge*,
+                           std::unique_ptr<asio::posix::stream_descriptor>>;
 
     /**
      * The RAII guard used to register and unregister host bridge instances from
@@ -195,7 +625,7 @@ class MainContext {
     class WatchdogGuard {
        public:
         WatchdogGuard(HostBridge& bridge,
-                      std::unordered_set<HostBridge*>& watched_bridges,
+                      WatchedBridges& watched_bridges,
                       std::mutex& watched_bridges_mutex);
         ~WatchdogGuard() noexcept;
 
@@ -220,20 +650,53 @@ class MainContext {
 
         // References to the same two fields on `MainContext`, so we don't have
         // to use `friend`
-        std::reference_wrapper<std::unordered_set<HostBridge*>>
-            watched_bridges_;
+        std::reference_wrapper<WatchedBridges> watched_bridges_;
         std::reference_wrapper<std::mutex> watched_bridges_mutex_;
     };
 
     /**
-     * Register a bridge instance for our watchdog. We'll periodically check if
-     * the remote (native) host process that should be connected to the bridge
-     * instance is still alive, and we'll shut down the bridge if it is not to
-     * prevent dangling processes. The returned guard should be stored as a
-     * field in `HostBridge`, and the watchdog will automatically be
-     * unregistered once this guard drops from scope.
+     * Register a bridge instance for our watchdog. We'll wait for the remote
+     * (native) host process that should be connected to the bridge instance to
+     * exit, and we'll shut down the bridge when that happens to prevent
+     * dangling processes. The returned guard should be stored as a field in
+     * `HostBridge`, and the watchdog will automatically be unregistered once
+     * this guard drops from scope.
+     *
+     * @param bridge The bridge to shut down when the host process exits.
+     * @param parent_pid The process ID of the native host process.
+     */
+    WatchdogGuard register_watchdog(HostBridge& bridge, pid_t parent_pid);
+
+    /**
+     * The RAII guard returned by `watch_file()`. The callback will no longer be
+     * called once this object has been destroyed.
+     */
+    class FileWatchGuard {
+       public:
+        FileWatchGuard(MainContext& main_context, size_t watch_id) noexcept;
+        ~FileWatchGuard() noexcept;
+
+        FileWatchGuard(const FileWatchGuard&) = delete;
+        FileWatchGuard& operator=(const FileWatchGuard&) = delete;
+
+       private:
+        MainContext& main_context_;
+        size_t watch_id_;
+    };
+
+    /**
+     * Call `callback` from the main IO context whenever `path` has been
+     * written to or replaced. All watched files share a single inotify
+     * instance, since the number of those is limited per user and a group host
+     * may host hundreds of plugins. We watch the file's directory instead of
+     * the file itself because most text editors save files by replacing them.
+     *
+     * @return A guard that unregisters the callback when it gets dropped, or a
+     *   null pointer if the file could not be watched.
      */
-    WatchdogGuard register_watchdog(HostBridge& bridge);
+    std::unique_ptr<FileWatchGuard> watch_file(
+        const ghc::filesystem::path& path,
+        fu2::unique_function<void()> callback);
 
     /**
      * Returns `true` if the calling thread is the GUI thread, aka the thread
@@ -274,9 +737,14 @@ class MainContext {
      * interval is controllable through the `frame_rate` option and defaults to
      * 60 updates per second.
      *
+     * When the `event_loop_idle_backoff` option is enabled for every plugin in
+     * this process, the interval doubles every time `handler` had nothing to do
+     * while no editors are open, up to `max_idle_event_loop_interval`.
+     *
      * @param handler The function that should be executed in the IO context
      *   when the timer ticks. This should be a function that handles both the
-     *   X11 events and the Win32 message loop.
+     *   X11 events and the Win32 message loop. It should return whether there
+     *   were any events to handle.
      * @param predicate A function returning a boolean to indicate whether
      *   `handler` should be run. If this returns `false`, then the current
      *   event loop cycle will be skipped. This is used to prevent the Win32
@@ -286,21 +754,36 @@ class MainContext {
      *   that will cause them to stall indefinitely in this situation, but who
      *   knows which other plugins exert similar behaviour.
      */
-    template <std::invocable F, invocable_returning<bool> P>
+    template <invocable_returning<bool> F, invocable_returning<bool> P>
     void async_handle_events(F handler, P predicate) {
         // Try to keep a steady framerate, but add in delays to let other events
         // get handled if the GUI message handling somehow takes very long.
-        events_timer_.expires_at(
-            std::max(events_timer_.expiry() + timer_interval_,
-                     std::chrono::steady_clock::now() + timer_interval_ / 4));
+        events_timer_.expires_at(std::max(
+            events_timer_.expiry() + current_timer_interval_,
+            std::chrono::steady_clock::now() + current_timer_interval_ / 4));
         events_timer_.async_wait(
             [&, handler, predicate](const std::error_code& error) {
-                if (error) {
+                // `OpenEditorGuard` cancels the wait to wake the loop up early
+                if (error && !(error == asio::error::operation_aborted &&
+                               wake_up_requested_)) {
                     return;
                 }
+                wake_up_requested_ = false;
 
+                bool had_events = false;
                 if (predicate()) {
-                    handler();
+                    had_events = handler();
+                }
+
+                if (idle_backoff_.value_or(false) && num_open_editors_ == 0 &&
+                    !had_events) {
+                    current_timer_interval_ =
+                        std::min(current_timer_interval_ * 2,
+                                 std::max(timer_interval_,
+                                          std::chrono::steady_clock::duration(
+                                              max_idle_event_loop_interval)));
+                } else {
+                    current_timer_interval_ = timer_interval_;
                 }
 
                 async_handle_events(handler, predicate);
@@ -316,11 +799,14 @@ class MainContext {
    private:
     /**
      * Start a timer to periodically check whether the host processes belong to
-     * all active plugin bridges are still alive. We will shut down the plugin
-     * instances where this is not the case, so that this process can gracefully
-     * terminate. In some cases Unix Domain Sockets are left in a state where
-     * it's impossible to tell that the remote isn't alive anymore, and where
-     * `recv()` will just hang indefinitely. We use this watchdog to avoid this.
+     * all active plugin bridges without a pidfd are still alive. We will shut
+     * down the plugin instances where this is not the case, so that this
+     * process can gracefully terminate. In some cases Unix Domain Sockets are
+     * left in a state where it's impossible to tell that the remote isn't alive
+     * anymore, and where `recv()` will just hang indefinitely. We use this
+     * watchdog to avoid this. The timer stops again once there are no more
+     * bridges left to poll. This should only be called from the watchdog
+     * thread.
      */
     void async_handle_watchdog_timer(
         std::chrono::steady_clock::duration interval);
@@ -346,25 +832,98 @@ class MainContext {
     std::chrono::steady_clock::duration timer_interval_ =
         std::chrono::milliseconds(1000) / 60;
 
+    /**
+     * The interval actually used for the next tick. This is the same as
+     * `timer_interval_`, unless the event loop is backing off because it's
+     * idle. Only accessed from the GUI thread.
+     */
+    std::chrono::steady_clock::duration current_timer_interval_ =
+        timer_interval_;
+
+    /**
+     * Whether all plugins loaded in this process have enabled the
+     * `event_loop_idle_backoff` option. Will be a nullopt until the first
+     * plugin has been loaded.
+     */
+    std::optional<bool> idle_backoff_;
+
+    /**
+     * The number of currently open editors.
+     *
+     * @see OpenEditorGuard
+     */
+    size_t num_open_editors_ = 0;
+
+    /**
+     * Set when `OpenEditorGuard` cancels the pending wait on `events_timer_`
+     * to handle events right away.
+     */
+    bool wake_up_requested_ = false;
+
+    /**
+     * Wait for the next inotify events and run the callbacks for the files
+     * they belong to.
+     */
+    void async_handle_file_events();
+
+    /**
+     * A file registered through `watch_file()`.
+     */
+    struct FileWatch {
+        /**
+         * The inotify watch descriptor for the file's directory. This may be
+         * shared with other files in the same directory.
+         */
+        int watch_descriptor;
+        std::string file_name;
+        fu2::unique_function<void()> callback;
+    };
+
+    /**
+     * The inotify instance used for `watch_file()`, created the first time a
+     * file gets watched.
+     */
+    std::optional<asio::posix::stream_descriptor> inotify_descriptor_;
+    /**
+     * The files registered through `watch_file()`, indexed by a unique ID.
+     */
+    std::unordered_map<size_t, FileWatch> file_watches_;
+    size_t next_file_watch_id_ = 0;
+    std::mutex file_watches_mutex_;
+
     /**
      * The IO context used for the watchdog described below.
      */
     asio::io_context watchdog_context_;
 
+    /**
+     * Keeps `watchdog_context_` running while there are no pending waits on
+     * any pidfds and the polling timer isn't active.
+     */
+    asio::executor_work_guard<asio::io_context::executor_type>
+        watchdog_work_guard_;
+
     /**
      * The timer used to periodically check if the host processes are still
      * active, so we can shut down a plugin's sockets (and with that the plugin
      * itself) when the host has exited and the sockets are somehow not closed
-     * yet..
+     * yet.. This is only used for bridges where we couldn't open a pidfd for
+     * the host process.
      */
     asio::steady_timer watchdog_timer_;
 
+    /**
+     * Whether `watchdog_timer_` is currently running. Only accessed from the
+     * watchdog thread.
+     */
+    bool watchdog_timer_active_ = false;
+
     /**
      * All of the bridges we're watching as part of our watchdog. We're storing
      * pointers for efficiency's sake, since reference wrappers don't implement
      * any comparison operators.
      */
-    std::unordered_set<HostBridge*> watched_bridges_;
+    WatchedBridges watched_bridges_;
     std::mutex watched_bridges_mutex_;
 
     /**
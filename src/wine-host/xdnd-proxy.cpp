@@ -19,6 +19,8 @@
 #include <iostream>
 #include <numeric>
 
+#include <poll.h>
+
 #include "../common/notifications.h"
 #include "editor.h"
 
@@ -52,6 +54,14 @@ constexpr char xdnd_copy_action_name[] = "XdndActionCopy";
 constexpr char mime_text_uri_list_name[] = "text/uri-list";
 constexpr char mime_text_plain_name[] = "text/plain";
 
+/**
+ * How often we'll check the pointer's position while dragging. Every check
+ * takes at least one round trip to the X11 server, and another couple of round
+ * trips when the pointer has moved, so we should not do this too often. XDND
+ * events and key presses are still handled as soon as they arrive.
+ */
+constexpr std::chrono::milliseconds xdnd_pointer_query_interval = 8ms;
+
 // We can cheat by just using the Win32 cursors instead of providing our own
 static const HCURSOR dnd_accepted_cursor = LoadCursor(nullptr, IDC_HAND);
 static const HCURSOR dnd_denied_cursor = LoadCursor(nullptr, IDC_NO);
@@ -90,6 +100,15 @@ void CALLBACK dnd_winevent_callback(HWINEVENTHOOK hWinEventHook,
 std::optional<xcb_keycode_t> find_escape_keycode(
     xcb_connection_t& x11_connection);
 
+/**
+ * Block until the X11 connection has data available to read, or until
+ * `timeout` has passed. This should only be called after handling all events
+ * returned by `xcb_poll_for_event()`, since events xcb has already read from
+ * the socket won't wake this up.
+ */
+void wait_for_x11_events(xcb_connection_t& x11_connection,
+                         std::chrono::steady_clock::duration timeout) noexcept;
+
 X11Window::~X11Window() noexcept {
     if (!is_moved_) {
         xcb_destroy_window(x11_connection_.get(), window_);
@@ -260,7 +279,8 @@ void WineXdndProxy::begin_xdnd(
     // GUI thread, we need to do our XDND polling from another thread. Luckily
     // the X11 API is thread safe.
     tracker_window_ = tracker_window;
-    xdnd_handler_ = Win32Thread([&]() { run_xdnd_loop(); });
+    xdnd_handler_ = Win32Thread(Win32Thread::small_stack_size,
+                                [&]() { run_xdnd_loop(); });
 }
 
 void WineXdndProxy::end_xdnd() {
@@ -360,11 +380,13 @@ void WineXdndProxy::run_xdnd_loop() {
     // We cannot just grab the pointer because Wine is already doing that, and
     // it's also blocking the GUI thread. So instead we will periodically poll
     // the mouse cursor position, and we will end the drag once the left mouse
-    // button gets released.
+    // button gets released. In between those checks we'll sleep until we
+    // receive an X11 event.
     bool left_mouse_button_held = true;
     bool escape_pressed = false;
     std::optional<uint16_t> last_pointer_x;
     std::optional<uint16_t> last_pointer_y;
+    std::chrono::steady_clock::time_point next_pointer_query = drag_loop_start;
     while (xdnd_warmup_active || (left_mouse_button_held && !escape_pressed)) {
         // See above for why we need to do this. We'll also stop this warmup
         // phase once the host accepts the drop (since at that point it's no
@@ -375,8 +397,6 @@ void WineXdndProxy::run_xdnd_loop() {
                 std::chrono::steady_clock::now() - drag_loop_start <= 200ms;
         }
 
-        std::this_thread::sleep_for(1ms);
-
         std::unique_ptr<xcb_generic_event_t> generic_event;
         while (generic_event.reset(xcb_poll_for_event(x11_connection_.get())),
                generic_event != nullptr) {
@@ -415,32 +435,52 @@ void WineXdndProxy::run_xdnd_loop() {
         // reply
         maybe_send_spooled_position_message();
 
-        // We'll try to find the first window under the pointer (starting form
-        // the root) until we find a window that supports XDND. The returned
-        // child window may not support XDND so we need to check that
-        // separately, as we still need to keep track of the pointer
-        // coordinates.
-        const std::unique_ptr<xcb_query_pointer_reply_t> xdnd_window_query =
-            query_xdnd_aware_window_at_pointer(root_window_);
-        if (!xdnd_window_query) {
+        // Until it's time to check the pointer again, we'll only wake up to
+        // handle incoming X11 events
+        const std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        if (now < next_pointer_query) {
+            wait_for_x11_events(*x11_connection_, next_pointer_query - now);
             continue;
         }
+        next_pointer_query = now + xdnd_pointer_query_interval;
 
         // We will stop the dragging operation as soon as the left mouse button
-        // gets released
+        // gets released. Checking this and the pointer's position only takes a
+        // single query.
         // NOTE: In soem cases Wine's own drag-and-drop operation ends
         //       prematurely. This seems to often happen with JUCE plugins. We
         //       will still continue with the dragging operation, although at
         //       that point the mouse pointer isn't grabbed by anything anymore.
         // NOTE: During the first couple of milliseconds we'll spam the host,
         //       see above for why this is necessary
-        left_mouse_button_held = xdnd_window_query->mask & XCB_BUTTON_MASK_1;
-        if (xdnd_window_query->root_x == last_pointer_x &&
-            xdnd_window_query->root_y == last_pointer_y &&
+        std::unique_ptr<xcb_query_pointer_reply_t> root_pointer_query =
+            query_pointer(root_window_);
+        if (!root_pointer_query) {
+            continue;
+        }
+
+        left_mouse_button_held = root_pointer_query->mask & XCB_BUTTON_MASK_1;
+        if (root_pointer_query->root_x == last_pointer_x &&
+            root_pointer_query->root_y == last_pointer_y &&
             !xdnd_warmup_active) {
             continue;
         }
 
+        // If the pointer has moved, then we'll try to find the first window
+        // under the pointer (starting form the root) until we find a window
+        // that supports XDND. The returned child window may not support XDND
+        // so we need to check that separately, as we still need to keep track
+        // of the pointer coordinates.
+        const std::unique_ptr<xcb_query_pointer_reply_t> xdnd_window_query =
+            root_pointer_query->child == XCB_NONE ||
+                    is_xdnd_aware(root_pointer_query->child)
+                ? std::move(root_pointer_query)
+                : query_xdnd_aware_window_at_pointer(root_pointer_query->child);
+        if (!xdnd_window_query) {
+            continue;
+        }
+
         last_pointer_x = xdnd_window_query->root_x;
         last_pointer_y = xdnd_window_query->root_y;
         const std::optional<unsigned char> supported_xdnd_version =
@@ -532,7 +572,7 @@ void WineXdndProxy::run_xdnd_loop() {
             break;
         }
 
-        std::this_thread::sleep_for(1ms);
+        wait_for_x11_events(*x11_connection_, 10ms);
 
         std::unique_ptr<xcb_generic_event_t> generic_event;
         while (generic_event.reset(xcb_poll_for_event(x11_connection_.get())),
@@ -595,6 +635,22 @@ void WineXdndProxy::run_xdnd_loop() {
 
 #pragma GCC diagnostic pop
 
+std::unique_ptr<xcb_query_pointer_reply_t>
+WineXdndProxy::query_pointer(xcb_window_t window) const noexcept {
+    xcb_generic_error_t* error = nullptr;
+    const xcb_query_pointer_cookie_t query_pointer_cookie =
+        xcb_query_pointer(x11_connection_.get(), window);
+    std::unique_ptr<xcb_query_pointer_reply_t> query_pointer_reply(
+        xcb_query_pointer_reply(x11_connection_.get(), query_pointer_cookie,
+                                &error));
+    if (error) {
+        free(error);
+        return nullptr;
+    }
+
+    return query_pointer_reply;
+}
+
 std::unique_ptr<xcb_query_pointer_reply_t>
 WineXdndProxy::query_xdnd_aware_window_at_pointer(
     xcb_window_t window) const noexcept {
@@ -961,3 +1017,15 @@ std::optional<xcb_keycode_t> find_escape_keycode(
 
     return std::nullopt;
 }
+
+void wait_for_x11_events(xcb_connection_t& x11_connection,
+                         std::chrono::steady_clock::duration timeout) noexcept {
+    pollfd poll_fd{.fd = xcb_get_file_descriptor(&x11_connection),
+                   .events = POLLIN,
+                   .revents = 0};
+
+    // Round up so we don't spin when less than a millisecond is left
+    const auto timeout_ms =
+        std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+    poll(&poll_fd, 1, static_cast<int>(timeout_ms));
+}
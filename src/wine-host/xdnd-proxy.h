@@ -168,6 +168,13 @@ class WineXdndProxy {
      */
     void run_xdnd_loop();
 
+    /**
+     * Query the pointer's position and button state relative to `window`. This
+     * will return a null pointer if an X11 error was thrown.
+     */
+    std::unique_ptr<xcb_query_pointer_reply_t> query_pointer(
+        xcb_window_t window) const noexcept;
+
     /**
      * Find the first XDND aware X11 window at the current mouse cursor,
      * starting at `window` and iteratively descending into its children until
@@ -27,11 +27,14 @@ use crate::config::{
     yabridge_vst2_home, yabridge_vst3_home, Config, Vst2InstallationLocation, YabridgeFiles,
 };
 use crate::files::{self, NativeFile, Plugin, Vst2Plugin};
+use crate::index_cache::IndexCache;
 use crate::util::{self, get_file_type};
 use crate::util::{verify_external_dependencies, verify_path_setup, verify_wine_setup};
 use crate::vst3_moduleinfo::ModuleInfo;
 
 pub mod blacklist;
+pub mod stats;
+pub mod top;
 
 /// Add a direcotry to the plugin locations. Duplicates get ignord because we're using ordered sets.
 pub fn add_directory(config: &mut Config, path: PathBuf) -> Result<()> {
@@ -88,9 +91,11 @@ pub fn list_directories(config: &Config) -> Result<()> {
 
 /// Print the current configuration and the installation status for all found plugins.
 pub fn show_status(config: &Config) -> Result<()> {
+    let cache = IndexCache::read();
     let results = config
-        .search_directories()
+        .search_directories(&cache)
         .context("Failure while searching for plugins")?;
+    write_index_cache(&cache);
 
     println!(
         "yabridge path: {}",
@@ -257,8 +262,9 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
         println!("- {}\n", files.vst2_chainloader.display());
     }
 
+    let cache = IndexCache::read();
     let results = config
-        .search_directories()
+        .search_directories(&cache)
         .context("Failure while searching for plugins")?;
 
     // Before doing anything, make sure `~/.vst/yabridge` and `~/.vst3/yabridge` are not symlinks to
@@ -510,9 +516,16 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
 
                     // If the plugin has a VST 3.7.10 moduleinfo file, then we'll rewrite the byte
                     // orders of the class IDs stored within the file and then write it to the
-                    // bridged VST3 bundle.
+                    // bridged VST3 bundle. This is skipped if the file has not changed since the
+                    // last sync.
                     // https://steinbergmedia.github.io/vst3_dev_portal/pages/Technical+Documentation/VST+Module+Architecture/ModuleInfo-JSON.html
-                    if let Some(original_moduleinfo_path) = module.original_moduleinfo_path() {
+                    if let Some(original_moduleinfo_path) =
+                        module.original_moduleinfo_path().filter(|path| {
+                            options.force
+                                || !cache
+                                    .moduleinfo_up_to_date(path, &module.target_moduleinfo_path())
+                        })
+                    {
                         let target_moduleinfo_path = module.target_moduleinfo_path();
 
                         let result = util::read_to_string(&original_moduleinfo_path)
@@ -530,12 +543,13 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
                                         .context("Could not format JSON file")?;
                                 util::write(target_moduleinfo_path, converted_json)
                             });
-                        if let Err(error) = result {
-                            eprintln!(
+                        match result {
+                            Ok(()) => cache.mark_moduleinfo_converted(&original_moduleinfo_path),
+                            Err(error) => eprintln!(
                                 "Error converting '{}', skipping...\n{}",
                                 original_moduleinfo_path.display(),
                                 error
-                            );
+                            ),
                         }
                     }
 
@@ -559,6 +573,9 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
         }
     }
 
+    // Only the files we've seen during this sync are kept in the cache
+    write_index_cache(&cache);
+
     // We'll print the skipped files all at once to prevetn clutter
     let num_skipped_files = skipped_dll_files.len();
     if options.verbose && !skipped_dll_files.is_empty() {
@@ -725,6 +742,14 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
     Ok(())
 }
 
+/// Write the plugin index cache used by `Config::search_directories()` back to disk. Failing to do
+/// so only means that the next sync will be slower, so this only prints a warning.
+fn write_index_cache(cache: &IndexCache) {
+    if let Err(err) = cache.write() {
+        eprintln!("WARNING: Could not write the plugin index cache: {err:#}\n");
+    }
+}
+
 // TODO: Clean this up, in the past this was part of a yabridgectl setting and the enum was simply
 //       reused here
 enum InstallationMethod {
@@ -733,7 +758,9 @@ enum InstallationMethod {
 }
 
 /// Create a copy or symlink of `from` to `to`. Depending on `force`, we might not actually create a
-/// new copy or symlink if `to` matches `from_hash`.
+/// new copy or symlink if `to` matches `from_hash`. Copies are made using reflinks or hardlinks when
+/// the file system supports it, see
+/// [`util::reflink_hardlink_or_copy()`](crate::util::reflink_hardlink_or_copy).
 fn install_file(
     force: bool,
     method: InstallationMethod,
@@ -749,11 +776,16 @@ fn install_file(
     if let Ok(metadata) = fs::symlink_metadata(&to) {
         match (force, &method) {
             (false, InstallationMethod::Copy) => {
-                // If the target file is already a real file (not a symlink) and its hash is the
-                // same as that of the `from` file we're trying to copy there, then we don't have to
-                // do anything
-                if let Some(hash) = from_hash {
-                    if metadata.file_type().is_file() && util::hash_file(to)? == hash {
+                // If the target file is already a real file (not a symlink) and it's either a
+                // hardlink to the `from` file we're trying to copy there or its hash is the same as
+                // that of the `from` file, then we don't have to do anything. Comparing the inodes
+                // and sizes first avoids having to read every single target file.
+                if let (Some(hash), Ok(from_metadata)) = (from_hash, fs::metadata(from)) {
+                    if metadata.file_type().is_file()
+                        && (util::is_same_inode(&metadata, &from_metadata)
+                            || (metadata.len() == from_metadata.len()
+                                && util::hash_file(to)? == hash))
+                    {
                         return Ok(false);
                     }
                 }
@@ -773,7 +805,7 @@ fn install_file(
 
     match method {
         InstallationMethod::Copy => {
-            util::copy_or_reflink(from, to)?;
+            util::reflink_hardlink_or_copy(from, to)?;
         }
         InstallationMethod::Symlink => {
             util::symlink(from, to)?;
@@ -0,0 +1,265 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//! Handler for `yabridgectl stats`, which shows live audio processing statistics for all running
+//! yabridge plugin instances. These are read from the control header at the start of every
+//! instance's shared memory audio buffer. `yabridgectl stats --memory` uses the same header to
+//! find each instance's Wine plugin host process and shows its memory usage instead.
+
+use anyhow::{Context, Result};
+use colored::Colorize;
+use std::collections::BTreeMap;
+use std::fs::{self, File};
+use std::io::Read;
+use std::path::{Path, PathBuf};
+use std::thread;
+use std::time::Duration;
+
+/// The directory the shared memory audio buffers are created in.
+const SHM_DIRECTORY: &str = "/dev/shm";
+/// The prefix all of yabridge's shared memory objects start with. This is based on
+/// `generate_endpoint_base()` in `src/common/communication/common.cpp`.
+const SHM_PREFIX: &str = "yabridge-";
+/// The prefix used for the temporary shared memory objects used to transfer large preset chunks.
+/// These are not audio buffers. See `src/common/bitsery/ext/shared-memory-blob.h`.
+const SHM_BLOB_PREFIX: &str = "yabridge-blob-";
+
+/// This should match `AudioShmBuffer::control_header_version` in `src/common/audio-shm.h`.
+const CONTROL_HEADER_VERSION: u32 = 4;
+/// The offset of `AudioShmBuffer::ControlHeader::stats` in bytes. The statistics are aligned to a
+/// cache line.
+const STATS_OFFSET: usize = 64;
+/// The number of 64-bit fields in `AudioShmBuffer::ProcessingStats`.
+const STATS_NUM_FIELDS: usize = 6;
+/// The offset of `AudioShmBuffer::ControlHeader::memory` in bytes. This directly follows the
+/// statistics, which take up a full cache line.
+const MEMORY_OFFSET: usize = 128;
+/// The number of 32-bit fields in `AudioShmBuffer::MemoryStats` we read. The native plugin's
+/// process ID is not used here.
+const MEMORY_NUM_FIELDS: usize = 1;
+
+/// How often the statistics are refreshed.
+const REFRESH_INTERVAL: Duration = Duration::from_secs(1);
+
+/// A copy of `AudioShmBuffer::ProcessingStats`. All durations are cumulative and in nanoseconds.
+#[derive(Debug, Clone, Copy, Default)]
+pub(super) struct ProcessingStats {
+    pub num_blocks: u64,
+    pub total_ns: u64,
+    pub max_total_ns: u64,
+    pub plugin_ns: u64,
+    pub max_plugin_ns: u64,
+    /// The part of `plugin_ns` spent waiting on host callbacks.
+    pub callbacks_ns: u64,
+}
+
+/// The part of `AudioShmBuffer::MemoryStats` we use.
+#[derive(Debug, Clone, Copy, Default)]
+pub(super) struct MemoryStats {
+    pub host_pid: u32,
+}
+
+/// Print the audio processing statistics for all running plugin instances once a second until the
+/// user exits with Ctrl+C. For every instance this shows the average time per block spent inside
+/// of the Windows plugin and the average time yabridge added on top of that since the last
+/// refresh, so xruns can be attributed to either the plugin or to yabridge.
+pub fn show_stats() -> Result<()> {
+    let mut previous_stats = read_all_stats()?;
+    loop {
+        thread::sleep(REFRESH_INTERVAL);
+        let current_stats = read_all_stats()?;
+
+        println!(
+            "{}",
+            format!(
+                "{:<48} {:>9} {:>11} {:>11} {:>11} {:>11} {:>11}",
+                "instance",
+                "blocks/s",
+                "plugin µs",
+                "callback µs",
+                "yabridge µs",
+                "max plugin",
+                "max total"
+            )
+            .bold()
+        );
+        if current_stats.is_empty() {
+            println!("No running plugin instances found");
+        }
+        for (name, stats) in &current_stats {
+            let previous = previous_stats.get(name).copied().unwrap_or_default();
+            let blocks = stats.num_blocks.saturating_sub(previous.num_blocks);
+            let total_ns = stats.total_ns.saturating_sub(previous.total_ns);
+            let plugin_ns = stats.plugin_ns.saturating_sub(previous.plugin_ns);
+            let callbacks_ns = stats.callbacks_ns.saturating_sub(previous.callbacks_ns);
+
+            // With `vst2_pipelined_processing` the plugin processes audio in parallel with the
+            // host, so the plugin's time can exceed the total time
+            let (plugin_us, callback_us, overhead_us) = if blocks > 0 {
+                (
+                    plugin_ns as f64 / blocks as f64 / 1000.0,
+                    callbacks_ns as f64 / blocks as f64 / 1000.0,
+                    total_ns.saturating_sub(plugin_ns) as f64 / blocks as f64 / 1000.0,
+                )
+            } else {
+                (0.0, 0.0, 0.0)
+            };
+
+            println!(
+                "{:<48} {:>9.0} {:>11.1} {:>11.1} {:>11.1} {:>11.1} {:>11.1}",
+                name,
+                blocks as f64 / REFRESH_INTERVAL.as_secs_f64(),
+                plugin_us,
+                callback_us,
+                overhead_us,
+                stats.max_plugin_ns as f64 / 1000.0,
+                stats.max_total_ns as f64 / 1000.0,
+            );
+        }
+        println!();
+
+        previous_stats = current_stats;
+    }
+}
+
+/// Print the memory usage of every running plugin instance's Wine plugin host process, together
+/// with the size of the instance's shared memory audio buffer. Plugins in a plugin group share a
+/// single process, so their memory usage can't be broken down any further than that. The
+/// process' resident memory also includes its thread stacks, its serialization buffers, and its
+/// mapping of the audio buffers.
+pub fn show_memory() -> Result<()> {
+    let buffers = read_all_buffers()?;
+
+    // Count how many instances are hosted in every process so group hosts can be recognized
+    let mut instances_per_process: BTreeMap<u32, usize> = BTreeMap::new();
+    for (_, memory, _) in buffers.values() {
+        *instances_per_process.entry(memory.host_pid).or_default() += 1;
+    }
+
+    println!(
+        "{}",
+        format!(
+            "{:<48} {:>8} {:>10} {:>8} {:>12} {:>9}",
+            "instance", "wine pid", "wine MiB", "threads", "buffer KiB", "instances"
+        )
+        .bold()
+    );
+    if buffers.is_empty() {
+        println!("No running plugin instances found");
+    }
+    for (name, (_, memory, buffer_size)) in &buffers {
+        let (rss_kib, threads) = read_process_status(memory.host_pid).unwrap_or_default();
+        println!(
+            "{:<48} {:>8} {:>10.1} {:>8} {:>12.0} {:>9}",
+            name,
+            memory.host_pid,
+            rss_kib as f64 / 1024.0,
+            threads,
+            *buffer_size as f64 / 1024.0,
+            instances_per_process
+                .get(&memory.host_pid)
+                .copied()
+                .unwrap_or(1),
+        );
+    }
+
+    Ok(())
+}
+
+/// Read the statistics from every yabridge shared memory audio buffer, indexed by the buffer's
+/// name without the `yabridge-` prefix. Buffers that disappear while we're reading them or that
+/// were created by a different version of yabridge are skipped.
+fn read_all_stats() -> Result<BTreeMap<String, ProcessingStats>> {
+    Ok(read_all_buffers()?
+        .into_iter()
+        .map(|(name, (stats, _, _))| (name, stats))
+        .collect())
+}
+
+/// Read the control headers from every yabridge shared memory audio buffer along with the size of
+/// the shared memory object, indexed by the buffer's name without the `yabridge-` prefix.
+pub(super) fn read_all_buffers() -> Result<BTreeMap<String, (ProcessingStats, MemoryStats, u64)>> {
+    let mut result = BTreeMap::new();
+    for entry in fs::read_dir(SHM_DIRECTORY)
+        .with_context(|| format!("Could not read '{}'", SHM_DIRECTORY))?
+    {
+        let path: PathBuf = entry?.path();
+        let name = match path.file_name().and_then(|name| name.to_str()) {
+            Some(name) if name.starts_with(SHM_PREFIX) && !name.starts_with(SHM_BLOB_PREFIX) => {
+                name[SHM_PREFIX.len()..].to_owned()
+            }
+            _ => continue,
+        };
+
+        if let Some((stats, memory)) = read_header(&path) {
+            let size = fs::metadata(&path).map(|m| m.len()).unwrap_or(0);
+            result.insert(name, (stats, memory, size));
+        }
+    }
+
+    Ok(result)
+}
+
+/// Read the statistics from a single shared memory audio buffer's control header. Returns `None`
+/// if the file could not be read or if its control header has a different layout.
+fn read_header(path: &Path) -> Option<(ProcessingStats, MemoryStats)> {
+    let mut header = [0u8; MEMORY_OFFSET + (MEMORY_NUM_FIELDS * 4)];
+    File::open(path).ok()?.read_exact(&mut header).ok()?;
+
+    let version = u32::from_ne_bytes(header[0..4].try_into().unwrap());
+    if version != CONTROL_HEADER_VERSION {
+        return None;
+    }
+
+    let field = |idx: usize| {
+        let start = STATS_OFFSET + (idx * 8);
+        u64::from_ne_bytes(header[start..start + 8].try_into().unwrap())
+    };
+    let memory_field = |idx: usize| {
+        let start = MEMORY_OFFSET + (idx * 4);
+        u32::from_ne_bytes(header[start..start + 4].try_into().unwrap())
+    };
+
+    Some((
+        ProcessingStats {
+            num_blocks: field(0),
+            total_ns: field(1),
+            max_total_ns: field(2),
+            plugin_ns: field(3),
+            max_plugin_ns: field(4),
+            callbacks_ns: field(5),
+        },
+        MemoryStats {
+            host_pid: memory_field(0),
+        },
+    ))
+}
+
+/// Read a process' resident memory in KiB and its number of threads from `/proc/<pid>/status`.
+/// Returns `None` if the process no longer exists.
+pub(super) fn read_process_status(pid: u32) -> Option<(u64, u64)> {
+    let status = fs::read_to_string(format!("/proc/{}/status", pid)).ok()?;
+    let value = |key: &str| {
+        status
+            .lines()
+            .find_map(|line| line.strip_prefix(key))
+            .and_then(|value| value.split_whitespace().next())
+            .and_then(|value| value.parse::<u64>().ok())
+            .unwrap_or(0)
+    };
+
+    Some((value("VmRSS:"), value("Threads:")))
+}
@@ -0,0 +1,272 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//! Handler for `yabridgectl top`, a live overview of all running bridged plugins sorted by how much
+//! of the realtime budget they use. Running plugins are found through their socket endpoint
+//! directories in the temporary directory, their processing statistics are read from their shared
+//! memory audio buffers like in `yabridgectl stats`, and request rates are read from the metrics
+//! sockets of group host processes started with `YABRIDGE_GROUP_METRICS` set.
+
+use anyhow::{Context, Result};
+use colored::Colorize;
+use std::collections::{BTreeMap, HashMap, HashSet};
+use std::env;
+use std::fs;
+use std::io::{Read, Write};
+use std::os::unix::net::UnixStream;
+use std::path::{Path, PathBuf};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use super::stats::{read_all_buffers, read_process_status, ProcessingStats};
+
+/// The prefix of the socket endpoint directories created for every bridged plugin. This is based
+/// on `generate_endpoint_base()` in `src/common/communication/common.cpp`.
+const ENDPOINT_PREFIX: &str = "yabridge-";
+/// The prefix of the group host sockets. See `generate_group_endpoint()` in
+/// `src/plugin/utils.cpp`.
+const GROUP_SOCKET_PREFIX: &str = "yabridge-group-";
+/// The suffix the group host's metrics socket uses instead of `.sock`. See `GroupBridge`'s
+/// constructor in `src/wine-host/bridges/group.cpp`.
+const METRICS_SOCKET_SUFFIX: &str = "-metrics.sock";
+
+/// How often the view is refreshed.
+const REFRESH_INTERVAL: Duration = Duration::from_secs(1);
+/// How long to wait for a group host to answer a metrics request.
+const METRICS_TIMEOUT: Duration = Duration::from_millis(250);
+
+/// A single plugin instance's row in the overview.
+struct InstanceRow {
+    name: String,
+    host_pid: u32,
+    /// The fraction of the last refresh interval spent processing audio inside of the plugin.
+    /// Since audio is processed in realtime, this is the plugin's DSP load.
+    dsp_load: f64,
+    /// The fraction of the last refresh interval yabridge added on top of that.
+    bridge_load: f64,
+    blocks_per_second: f64,
+}
+
+/// Clear the screen and print an overview of all running plugin instances once a second until the
+/// user exits with Ctrl+C. Instances are sorted by their DSP load so the plugin eating the budget
+/// ends up at the top.
+pub fn show_top() -> Result<()> {
+    let temp_dir = temporary_directory();
+
+    let mut previous_stats = read_instance_stats(&temp_dir)?;
+    let mut previous_requests = read_all_request_counts(&temp_dir);
+    let mut previous_time = Instant::now();
+    loop {
+        thread::sleep(REFRESH_INTERVAL);
+        let current_stats = read_instance_stats(&temp_dir)?;
+        let current_requests = read_all_request_counts(&temp_dir);
+        let current_time = Instant::now();
+        let elapsed_ns = (current_time - previous_time).as_nanos() as f64;
+
+        let mut rows: Vec<InstanceRow> = current_stats
+            .iter()
+            .map(|(name, (stats, host_pid))| {
+                let previous = previous_stats
+                    .get(name)
+                    .map(|(stats, _)| *stats)
+                    .unwrap_or_default();
+                let blocks = stats.num_blocks.saturating_sub(previous.num_blocks);
+                let total_ns = stats.total_ns.saturating_sub(previous.total_ns);
+                let plugin_ns = stats.plugin_ns.saturating_sub(previous.plugin_ns);
+
+                InstanceRow {
+                    name: name.clone(),
+                    host_pid: *host_pid,
+                    dsp_load: plugin_ns as f64 / elapsed_ns,
+                    // With `vst2_pipelined_processing` the plugin processes audio in parallel with
+                    // the host, so the plugin's time can exceed the total time
+                    bridge_load: total_ns.saturating_sub(plugin_ns) as f64 / elapsed_ns,
+                    blocks_per_second: blocks as f64 * 1.0e9 / elapsed_ns,
+                }
+            })
+            .collect();
+        rows.sort_by(|a, b| b.dsp_load.total_cmp(&a.dsp_load));
+
+        // Plugins in a group share a process, so the process' memory usage and request rate are
+        // only shown once
+        let mut processes = rows.iter().map(|row| row.host_pid).collect::<Vec<_>>();
+        processes.sort_unstable();
+        processes.dedup();
+
+        // Clear the screen and move the cursor to the top left corner
+        print!("\x1b[2J\x1b[H");
+        println!(
+            "yabridgectl top - {} instances in {} processes, total DSP load {:.1}%",
+            rows.len(),
+            processes.len(),
+            rows.iter().map(|row| row.dsp_load).sum::<f64>() * 100.0
+        );
+        println!();
+        println!(
+            "{}",
+            format!(
+                "{:<48} {:>8} {:>7} {:>8} {:>9} {:>9} {:>9}",
+                "instance", "wine pid", "dsp %", "bridge %", "blocks/s", "req/s", "wine MiB"
+            )
+            .bold()
+        );
+        if rows.is_empty() {
+            println!("No running plugin instances found");
+        }
+
+        let mut shown_processes: HashSet<u32> = HashSet::new();
+        for row in &rows {
+            let first_in_process = shown_processes.insert(row.host_pid);
+            let requests_per_second = match (
+                current_requests.get(&row.host_pid),
+                previous_requests.get(&row.host_pid),
+            ) {
+                (Some(current), Some(previous)) if first_in_process => format!(
+                    "{:.0}",
+                    current.saturating_sub(*previous) as f64 * 1.0e9 / elapsed_ns
+                ),
+                _ => String::from("-"),
+            };
+            let memory = if first_in_process {
+                read_process_status(row.host_pid)
+                    .map(|(rss_kib, _)| format!("{:.1}", rss_kib as f64 / 1024.0))
+                    .unwrap_or_else(|| String::from("-"))
+            } else {
+                String::from("-")
+            };
+
+            let line = format!(
+                "{:<48} {:>8} {:>7.1} {:>8.1} {:>9.0} {:>9} {:>9}",
+                row.name,
+                row.host_pid,
+                row.dsp_load * 100.0,
+                row.bridge_load * 100.0,
+                row.blocks_per_second,
+                requests_per_second,
+                memory,
+            );
+            // Anything using more than half of the budget is very likely to cause xruns
+            if row.dsp_load + row.bridge_load > 0.5 {
+                println!("{}", line.red());
+            } else {
+                println!("{}", line);
+            }
+        }
+        std::io::stdout().flush()?;
+
+        previous_stats = current_stats;
+        previous_requests = current_requests;
+        previous_time = current_time;
+    }
+}
+
+/// The directory yabridge creates its sockets in. This should match `get_temporary_directory()` in
+/// `src/common/utils.cpp`.
+fn temporary_directory() -> PathBuf {
+    env::var_os("YABRIDGE_TEMP_DIR")
+        .or_else(|| env::var_os("XDG_RUNTIME_DIR"))
+        .map(PathBuf::from)
+        .unwrap_or_else(env::temp_dir)
+}
+
+/// Read the processing statistics and the Wine plugin host's process ID for every instance of a
+/// running bridged plugin. Only audio buffers belonging to an existing socket endpoint directory
+/// are included, so buffers left behind by crashed plugins don't show up here.
+fn read_instance_stats(temp_dir: &Path) -> Result<BTreeMap<String, (ProcessingStats, u32)>> {
+    let mut endpoints: Vec<String> = Vec::new();
+    for entry in fs::read_dir(temp_dir)
+        .with_context(|| format!("Could not read '{}'", temp_dir.display()))?
+    {
+        let entry = entry?;
+        if !entry.file_type().map(|t| t.is_dir()).unwrap_or(false) {
+            continue;
+        }
+
+        if let Some(name) = entry.file_name().to_str() {
+            if name.starts_with(ENDPOINT_PREFIX) {
+                endpoints.push(name[ENDPOINT_PREFIX.len()..].to_owned());
+            }
+        }
+    }
+
+    // VST2 plugins use the endpoint's name for their buffer, and VST3 plugins append the
+    // instance's ID to it
+    Ok(read_all_buffers()?
+        .into_iter()
+        .filter(|(name, _)| {
+            endpoints.iter().any(|endpoint| {
+                name == endpoint
+                    || name
+                        .strip_prefix(endpoint.as_str())
+                        .map(|suffix| suffix.starts_with('-'))
+                        .unwrap_or(false)
+            })
+        })
+        .map(|(name, (stats, memory, _))| (name, (stats, memory.host_pid)))
+        .collect())
+}
+
+/// Query every group host process that's serving metrics for the total number of requests it has
+/// sent and handled, indexed by the process' ID. Group hosts that don't respond in time are
+/// skipped.
+fn read_all_request_counts(temp_dir: &Path) -> HashMap<u32, u64> {
+    let entries = match fs::read_dir(temp_dir) {
+        Ok(entries) => entries,
+        Err(_) => return HashMap::new(),
+    };
+
+    entries
+        .filter_map(|entry| entry.ok())
+        .filter(|entry| {
+            entry
+                .file_name()
+                .to_str()
+                .map(|name| {
+                    name.starts_with(GROUP_SOCKET_PREFIX) && name.ends_with(METRICS_SOCKET_SUFFIX)
+                })
+                .unwrap_or(false)
+        })
+        .filter_map(|entry| read_request_count(&entry.path()))
+        .collect()
+}
+
+/// Scrape a single group host's metrics socket and return its process ID together with the sum of
+/// all of its `yabridge_requests_total` counters.
+fn read_request_count(socket_path: &Path) -> Option<(u32, u64)> {
+    let mut stream = UnixStream::connect(socket_path).ok()?;
+    stream.set_read_timeout(Some(METRICS_TIMEOUT)).ok()?;
+    stream.set_write_timeout(Some(METRICS_TIMEOUT)).ok()?;
+    stream.write_all(b"GET /metrics HTTP/1.0\r\n\r\n").ok()?;
+
+    let mut response = String::new();
+    stream.read_to_string(&mut response).ok()?;
+
+    let mut pid = None;
+    let mut requests = 0;
+    for line in response.lines() {
+        if let Some(value) = line.strip_prefix("yabridge_host_pid ") {
+            pid = value.trim().parse::<u32>().ok();
+        } else if line.starts_with("yabridge_requests_total{") {
+            requests += line
+                .rsplit(' ')
+                .next()
+                .and_then(|value| value.parse::<u64>().ok())
+                .unwrap_or(0);
+        }
+    }
+
+    pid.map(|pid| (pid, requests))
+}
@@ -27,6 +27,7 @@ use which::which;
 use xdg::BaseDirectories;
 
 use crate::files::{self, LibArchitecture, SearchResults};
+use crate::index_cache::IndexCache;
 use crate::util;
 
 /// The name of the config file, relative to `$XDG_CONFIG_HOME/YABRIDGECTL_PREFIX`.
@@ -297,15 +298,16 @@ impl Config {
         })
     }
 
-    /// Search for VST2 and VST3 plugins in all of the registered plugins directories.
-    pub fn search_directories(&self) -> Result<BTreeMap<&Path, SearchResults>> {
+    /// Search for VST2 and VST3 plugins in all of the registered plugins directories. Plugin
+    /// libraries that have not changed since the last search are looked up in `cache`.
+    pub fn search_directories(&self, cache: &IndexCache) -> Result<BTreeMap<&Path, SearchResults>> {
         let blacklist: HashSet<&Path> = self.blacklist.iter().map(|p| p.as_path()).collect();
 
         self.plugin_dirs
             .par_iter()
             .map(|path| {
                 files::index(path, &blacklist)
-                    .search()
+                    .search(cache)
                     .map(|search_results| (path.as_path(), search_results))
             })
             .collect()
@@ -21,10 +21,11 @@ use rayon::prelude::*;
 use std::collections::{BTreeMap, HashMap, HashSet};
 use std::fmt::Display;
 use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
 use walkdir::WalkDir;
 
 use crate::config::{yabridge_vst2_home, yabridge_vst3_home, Config, YabridgeFiles};
-use crate::symbols::parse_pe32_binary;
+use crate::index_cache::IndexCache;
 use crate::util::get_file_type;
 
 /// Stores the results from searching through a directory. We'll search for Windows VST2 plugin
@@ -433,50 +434,54 @@ impl SearchResults {
 ///
 /// For VST3 plugin _bundles_ the subdirectory also contains the `foo.vst3/Contents/x86_64-win`
 /// suffix. This needs to be stripped out to get the bundle root.
+///
+/// Every subdirectory directly under `directory` is walked on its own thread. On network storage
+/// most of the time is spent waiting for the file system, so this makes a big difference for
+/// directories containing thousands of files.
 pub fn index(directory: &Path, blacklist: &HashSet<&Path>) -> SearchIndex {
-    // These are pairs of `(absolute_path, subdirectory)`. The subdirectory is used for setting up
-    // VST3 plugins and for setting up VST2 plugins in the centralized installation location mode.
-    let mut dll_files: Vec<(PathBuf, Option<PathBuf>)> = Vec::new();
-    let mut vst3_files: Vec<(PathBuf, Option<PathBuf>)> = Vec::new();
-    let mut so_files: Vec<NativeFile> = Vec::new();
-    for (file_idx, path) in WalkDir::new(directory)
-        .follow_links(true)
-        .into_iter()
-        .filter_entry(|e| {
-            // The blacklist entries are canonicalized to resolve symlinks and to normalize slashes,
-            // so we should do the same thing here as well
-            e.path()
-                .canonicalize()
-                .map(|p| !blacklist.contains(p.as_path()))
-                .unwrap_or(false)
-        })
-        .filter_map(|e| {
-            // NOTE: Broken symlinks will also get an `Err` entry, so we'll use `err.path()` to
-            //       still include them in the index
-            let path = match e {
-                Ok(entry) => entry.path().to_owned(),
-                Err(err) => err.path()?.to_owned(),
+    // The top level entries are walked first, and the subdirectories are then walked in parallel.
+    // This way the subdirectories' file lists still end up in the same order every time.
+    let num_indexed_files = AtomicUsize::new(0);
+    let top_level_entries = walk_directory(directory, blacklist, Some(1));
+    let paths: Vec<PathBuf> = top_level_entries
+        .into_par_iter()
+        .filter(|path| path != directory)
+        .flat_map_iter(|path| {
+            let paths: Vec<PathBuf> = if path.is_dir() {
+                walk_directory(&path, blacklist, None)
+                    .into_iter()
+                    .filter(|path| !path.is_dir())
+                    .collect()
+            } else {
+                vec![path]
             };
 
-            if !path.is_dir() {
-                Some(path)
-            } else {
-                None
+            // This is a bit of an odd warning, but I can see it happening that someone adds their
+            // entire home directory by accident. Removing the home directory would cause
+            // yabridgectl to scan for leftover `.so` files, which would of course take an
+            // enternity. This warning will at least tell the user what's happening and that they
+            // can safely cancel the scan.
+            let previous_num_indexed_files =
+                num_indexed_files.fetch_add(paths.len(), Ordering::Relaxed);
+            if previous_num_indexed_files < 100_000
+                && previous_num_indexed_files + paths.len() >= 100_000
+            {
+                eprintln!(
+                    "Indexed over 100.000 files, press Ctrl+C to cancel this operation if this \
+                     was not intentional."
+                )
             }
+
+            paths
         })
-        .enumerate()
-    {
-        // This is a bit of an odd warning, but I can see it happening that someone adds their
-        // entire home directory by accident. Removing the home directory would cause yabridgectl to
-        // scan for leftover `.so` files, which would of course take an enternity. This warning will
-        // at least tell the user what's happening and that they can safely cancel the scan.
-        if file_idx == 100_000 {
-            eprintln!(
-                "Indexed over 100.000 files, press Ctrl+C to cancel this operation if this was \
-                 not intentional."
-            )
-        }
+        .collect();
 
+    // These are pairs of `(absolute_path, subdirectory)`. The subdirectory is used for setting up
+    // VST3 plugins and for setting up VST2 plugins in the centralized installation location mode.
+    let mut dll_files: Vec<(PathBuf, Option<PathBuf>)> = Vec::new();
+    let mut vst3_files: Vec<(PathBuf, Option<PathBuf>)> = Vec::new();
+    let mut so_files: Vec<NativeFile> = Vec::new();
+    for path in paths {
         match path.extension().and_then(|os| os.to_str()) {
             Some("dll") => {
                 let subdirectory = path
@@ -512,13 +517,46 @@ pub fn index(directory: &Path, blacklist: &HashSet<&Path>) -> SearchIndex {
     }
 }
 
+/// Recursively list all files and directories under `directory`, including `directory` itself,
+/// skipping anything in the blacklist. Used in `index()`.
+fn walk_directory(
+    directory: &Path,
+    blacklist: &HashSet<&Path>,
+    max_depth: Option<usize>,
+) -> Vec<PathBuf> {
+    let mut walker = WalkDir::new(directory).follow_links(true);
+    if let Some(max_depth) = max_depth {
+        walker = walker.max_depth(max_depth);
+    }
+
+    walker
+        .into_iter()
+        .filter_entry(|e| {
+            // The blacklist entries are canonicalized to resolve symlinks and to normalize slashes,
+            // so we should do the same thing here as well
+            e.path()
+                .canonicalize()
+                .map(|p| !blacklist.contains(p.as_path()))
+                .unwrap_or(false)
+        })
+        .filter_map(|e| {
+            // NOTE: Broken symlinks will also get an `Err` entry, so we'll use `err.path()` to
+            //       still include them in the index
+            let path = match e {
+                Ok(entry) => entry.path().to_owned(),
+                Err(err) => err.path()?.to_owned(),
+            };
+
+            Some(path)
+        })
+        .collect()
+}
+
 impl SearchIndex {
     /// Filter these indexing results down to actual VST2 plugins and VST3 modules. This will skip
-    /// all invalid files, such as regular `.dll` libraries.
-    pub fn search(self) -> Result<SearchResults> {
-        const VST2_ENTRY_POINTS: [&str; 2] = ["VSTPluginMain", "main"];
-        const VST3_ENTRY_POINTS: [&str; 1] = ["GetPluginFactory"];
-
+    /// all invalid files, such as regular `.dll` libraries. Files that haven't changed since the
+    /// last search are looked up in `cache` instead of being parsed again.
+    pub fn search(self, cache: &IndexCache) -> Result<SearchResults> {
         // We'll have to figure out which `.dll` files are VST2 plugins and which should be skipped
         // by checking whether the file contains one of the VST2 entry point functions. This vector
         // will contain an `Err(path)` if `path` was not a valid VST2 plugin.
@@ -526,18 +564,14 @@ impl SearchIndex {
             .dll_files
             .into_par_iter()
             .map(|(path, subdirectory)| {
-                let info = parse_pe32_binary(&path)?;
+                let info = cache.parse_binary(&path)?;
                 let architecture = if info.is_64_bit {
                     LibArchitecture::Lib64
                 } else {
                     LibArchitecture::Lib32
                 };
 
-                if info
-                    .exports
-                    .into_iter()
-                    .any(|symbol| VST2_ENTRY_POINTS.contains(&symbol.as_str()))
-                {
+                if info.has_vst2_entry_point {
                     Ok(Ok(Vst2Plugin {
                         path,
                         architecture,
@@ -567,18 +601,14 @@ impl SearchIndex {
             .vst3_files
             .into_par_iter()
             .map(|(module_path, subdirectory)| {
-                let info = parse_pe32_binary(&module_path)?;
+                let info = cache.parse_binary(&module_path)?;
                 let architecture = if info.is_64_bit {
                     LibArchitecture::Lib64
                 } else {
                     LibArchitecture::Lib32
                 };
 
-                if info
-                    .exports
-                    .into_iter()
-                    .any(|symbol| VST3_ENTRY_POINTS.contains(&symbol.as_str()))
-                {
+                if info.has_vst3_entry_point {
                     // Now we'll have to figure out if the plugin is part of a VST 3.6.10 style
                     // bundle or a legacy `.vst3` DLL file. A WIndows VST3 bundle contains at least
                     // `<plugin_name>.vst3/Contents/<architecture_string>/<plugin_name>.vst3`, so
@@ -0,0 +1,217 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2022 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//! An on-disk cache for the results of parsing plugin libraries during `yabridgectl sync`. With
+//! thousands of plugin files on slow or networked storage, reading every `.dll` and `.vst3` file
+//! to check its exported symbols makes up the bulk of the time spent syncing. Files are keyed by
+//! their path, modification time and size, so only new or changed files need to be parsed again.
+
+use anyhow::{Context, Result};
+use serde_derive::{Deserialize, Serialize};
+use std::collections::BTreeMap;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::time::UNIX_EPOCH;
+
+use crate::config::yabridgectl_directories;
+use crate::symbols::parse_pe32_binary;
+use crate::util;
+
+/// The name of the cache file, relative to `$XDG_CACHE_HOME/yabridgectl`.
+const INDEX_CACHE_FILE_NAME: &str = "index.json";
+
+/// The exported functions that make a `.dll` file a VST2 plugin.
+const VST2_ENTRY_POINTS: [&str; 2] = ["VSTPluginMain", "main"];
+/// The exported functions that make a `.vst3` file a VST3 module.
+const VST3_ENTRY_POINTS: [&str; 1] = ["GetPluginFactory"];
+
+/// The parts of a PE32(+) binary's information we need to set up yabridge for a plugin library.
+/// This is what gets stored in the cache instead of the full list of exported symbols.
+#[derive(Debug, Clone, Copy, Deserialize, Serialize)]
+pub struct BinaryInfo {
+    /// Whether the binary is 64-bit.
+    pub is_64_bit: bool,
+    /// Whether the binary exports one of the VST2 entry points.
+    pub has_vst2_entry_point: bool,
+    /// Whether the binary exports one of the VST3 entry points.
+    pub has_vst3_entry_point: bool,
+}
+
+/// A file's modification time and size. If neither of these have changed since the last time we've
+/// seen the file, then we'll assume the file's contents haven't changed either.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Deserialize, Serialize)]
+struct FileStamp {
+    /// The modification time in nanoseconds since the Unix epoch.
+    modified_ns: u64,
+    size: u64,
+}
+
+/// A cached `BinaryInfo` for a plugin library, along with the file stamp it was parsed from.
+#[derive(Debug, Clone, Copy, Deserialize, Serialize)]
+struct CachedBinary {
+    #[serde(flatten)]
+    stamp: FileStamp,
+    #[serde(flatten)]
+    info: BinaryInfo,
+}
+
+/// The cache itself. Entries are read from the cache file at the start of `yabridgectl sync` or
+/// `yabridgectl status`, and every entry that's been looked up during the search is written back
+/// when calling `write()`. That way files that are no longer in any of the plugin directories
+/// automatically drop out of the cache. The lookup methods can be called from multiple threads at
+/// once.
+#[derive(Debug, Default)]
+pub struct IndexCache {
+    /// The entries read from the cache file.
+    previous: CacheFile,
+    /// The entries we've looked up or added during this run. These will be written back to the
+    /// cache file.
+    current: Mutex<CacheFile>,
+}
+
+/// The actual contents of the cache file.
+#[derive(Debug, Default, Deserialize, Serialize)]
+#[serde(default)]
+struct CacheFile {
+    /// Parsed `.dll` and `.vst3` plugin libraries, indexed by their path.
+    binaries: BTreeMap<PathBuf, CachedBinary>,
+    /// VST 3.7.10 `moduleinfo.json` files that have already been converted and written to a bridged
+    /// VST3 bundle, indexed by the original file's path.
+    moduleinfo: BTreeMap<PathBuf, FileStamp>,
+}
+
+impl IndexCache {
+    /// Read the cache file. If the file does not exist or if it cannot be parsed, for instance
+    /// because it was written by a different version of yabridgectl, then we'll start over with an
+    /// empty cache.
+    pub fn read() -> IndexCache {
+        let previous = yabridgectl_directories()
+            .ok()
+            .and_then(|dirs| dirs.find_cache_file(INDEX_CACHE_FILE_NAME))
+            .and_then(|path| fs::read_to_string(path).ok())
+            .and_then(|json| serde_jsonrc::from_str(&json).ok())
+            .unwrap_or_default();
+
+        IndexCache {
+            previous,
+            current: Mutex::new(CacheFile::default()),
+        }
+    }
+
+    /// Write all entries looked up or added during this run to the cache file.
+    pub fn write(&self) -> Result<()> {
+        let json = serde_jsonrc::to_string(&*self.current.lock().unwrap())
+            .context("Could not format JSON")?;
+        let cache_path = yabridgectl_directories()?
+            .place_cache_file(INDEX_CACHE_FILE_NAME)
+            .context("Could not create index cache file")?;
+
+        util::write(cache_path, json)
+    }
+
+    /// Parse a PE32(+) binary using
+    /// [`parse_pe32_binary()`](crate::symbols::parse_pe32_binary), or return the cached results
+    /// if the file has not changed since it was last parsed. Parsing failures are not cached.
+    pub fn parse_binary(&self, binary: &Path) -> Result<BinaryInfo> {
+        let stamp = FileStamp::read(binary)?;
+        if let Some(cached) = self.previous.binaries.get(binary) {
+            if cached.stamp == stamp {
+                self.current
+                    .lock()
+                    .unwrap()
+                    .binaries
+                    .insert(binary.to_owned(), *cached);
+
+                return Ok(cached.info);
+            }
+        }
+
+        let exports = parse_pe32_binary(binary)?;
+        let info = BinaryInfo {
+            is_64_bit: exports.is_64_bit,
+            has_vst2_entry_point: exports
+                .exports
+                .iter()
+                .any(|symbol| VST2_ENTRY_POINTS.contains(&symbol.as_str())),
+            has_vst3_entry_point: exports
+                .exports
+                .iter()
+                .any(|symbol| VST3_ENTRY_POINTS.contains(&symbol.as_str())),
+        };
+        self.current
+            .lock()
+            .unwrap()
+            .binaries
+            .insert(binary.to_owned(), CachedBinary { stamp, info });
+
+        Ok(info)
+    }
+
+    /// Check whether a `moduleinfo.json` file has already been converted and written to `target`
+    /// during a previous sync, and the original file has not changed since then. If this returns
+    /// false, then the file should be converted again and `mark_moduleinfo_converted()` should be
+    /// called afterwards.
+    pub fn moduleinfo_up_to_date(&self, original: &Path, target: &Path) -> bool {
+        let stamp = match FileStamp::read(original) {
+            Ok(stamp) => stamp,
+            Err(_) => return false,
+        };
+
+        if target.exists() && self.previous.moduleinfo.get(original) == Some(&stamp) {
+            self.current
+                .lock()
+                .unwrap()
+                .moduleinfo
+                .insert(original.to_owned(), stamp);
+
+            true
+        } else {
+            false
+        }
+    }
+
+    /// Store that `original` has been converted and written to a bridged VST3 bundle so the next
+    /// sync can skip the conversion if the file does not change.
+    pub fn mark_moduleinfo_converted(&self, original: &Path) {
+        if let Ok(stamp) = FileStamp::read(original) {
+            self.current
+                .lock()
+                .unwrap()
+                .moduleinfo
+                .insert(original.to_owned(), stamp);
+        }
+    }
+}
+
+impl FileStamp {
+    /// Read a file's modification time and size. This follows symlinks.
+    fn read(path: &Path) -> Result<FileStamp> {
+        let metadata = fs::metadata(path)
+            .with_context(|| format!("Could not read metadata for '{}'", path.display()))?;
+        let modified_ns = metadata
+            .modified()
+            .ok()
+            .and_then(|time| time.duration_since(UNIX_EPOCH).ok())
+            .map(|duration| duration.as_nanos() as u64)
+            .unwrap_or(0);
+
+        Ok(FileStamp {
+            modified_ns,
+            size: metadata.len(),
+        })
+    }
+}
@@ -26,6 +26,7 @@ use crate::config::Config;
 mod actions;
 mod config;
 mod files;
+mod index_cache;
 mod symbols;
 mod util;
 mod vst3_moduleinfo;
@@ -91,6 +92,21 @@ fn main() -> Result<()> {
                 .about("Show the installation status for all plugins")
                 .display_order(4),
         )
+        .subcommand(
+            Command::new("stats")
+                .about("Show live audio processing statistics for running plugins")
+                .display_order(5)
+                .arg(
+                    Arg::new("memory")
+                        .long("memory")
+                        .help("Show the memory usage of every plugin instance instead"),
+                ),
+        )
+        .subcommand(
+            Command::new("top")
+                .about("Show which running plugins use the most processing time")
+                .display_order(6),
+        )
         .subcommand(
             Command::new("sync")
                 .about("Set up or update yabridge for all plugins")
@@ -260,6 +276,14 @@ fn main() -> Result<()> {
         }
         Some(("list", _)) => actions::list_directories(&config),
         Some(("status", _)) => actions::show_status(&config),
+        Some(("stats", options)) => {
+            if options.is_present("memory") {
+                actions::stats::show_memory()
+            } else {
+                actions::stats::show_stats()
+            }
+        }
+        Some(("top", _)) => actions::top::show_top(),
         Some(("sync", options)) => actions::do_sync(
             &mut config,
             &actions::SyncOptions {
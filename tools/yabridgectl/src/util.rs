@@ -25,6 +25,7 @@ use std::fs;
 use std::hash::Hasher;
 use std::io::{BufRead, BufReader, Read, Seek, SeekFrom};
 use std::os::unix::fs as unix_fs;
+use std::os::unix::fs::MetadataExt;
 use std::os::unix::process::CommandExt;
 use std::path::{Path, PathBuf};
 use std::process::{Command, Stdio};
@@ -39,12 +40,25 @@ use crate::files::{LibArchitecture, NativeFile};
 /// moment without causing issues.
 const YABRIDGE_HOST_EXPECTED_OUTPUT_PREFIX: &str = "Usage: yabridge-";
 
-/// Wrapper around [`reflink::reflink_or_copy()`](reflink::reflink_or_copy) with a human readable
-/// error message.
-pub fn copy_or_reflink<P: AsRef<Path>, Q: AsRef<Path>>(from: P, to: Q) -> Result<Option<u64>> {
-    reflink::reflink_or_copy(&from, &to).with_context(|| {
+/// Create a copy of `from` at `to` using the cheapest method the file system supports. This first
+/// tries to create a reflink (a copy-on-write clone sharing the same data blocks) through
+/// [`reflink::reflink()`](reflink::reflink), then falls back to a hardlink if both files are on
+/// the same file system, and only makes a full copy if neither of those work. With thousands of
+/// plugins this saves a lot of I/O and disk space compared to always copying the file.
+///
+/// # Note
+///
+/// A hardlinked copy shares its inode with `from`, so modifying `from` in place will also modify
+/// the copy. Package managers and `tar` replace files instead of writing to them, so updating
+/// yabridge will still leave the old copies intact until the next sync replaces them.
+pub fn reflink_hardlink_or_copy<P: AsRef<Path>, Q: AsRef<Path>>(from: P, to: Q) -> Result<()> {
+    if reflink::reflink(&from, &to).is_ok() || fs::hard_link(&from, &to).is_ok() {
+        return Ok(());
+    }
+
+    fs::copy(&from, &to).map(|_| ()).with_context(|| {
         format!(
-            "Error reflinking '{}' to '{}'",
+            "Error copying '{}' to '{}'",
             from.as_ref().display(),
             to.as_ref().display()
         )
@@ -198,6 +212,12 @@ pub fn hash_file(file: &Path) -> Result<i64> {
     Ok(hasher.finish() as i64)
 }
 
+/// Check whether `file` is `other` or a hardlink to it, based on its metadata. This is a cheap way
+/// to detect that a file does not need to be hashed to know that it's identical to `other`.
+pub fn is_same_inode(file: &fs::Metadata, other: &fs::Metadata) -> bool {
+    file.dev() == other.dev() && file.ino() == other.ino()
+}
+
 /// Resolve symlinks in a path, like the `realpath` coreutil, but don't throw any errors of `path`
 /// does not exist, unlike the `realpath` libc function.
 ///